@@ -52,8 +52,32 @@ CPPFLAGS := -I$(SRC_DIR)/common/include \
             -DPROJECT_VERSION=\"$(VERSION)\" \
             -DBUILD_DATE=\"$(BUILD_DATE)\"
 
+# Compression backends: LZ4 is built in, zlib and LZMA are used when
+# pkg-config finds them
+ZLIB_LIBS := $(shell pkg-config --libs zlib 2>/dev/null)
+LZMA_LIBS := $(shell pkg-config --libs liblzma 2>/dev/null)
+CPPFLAGS += -DENABLE_LZ4
+ifneq ($(ZLIB_LIBS),)
+    CPPFLAGS += -DENABLE_ZLIB
+endif
+ifneq ($(LZMA_LIBS),)
+    CPPFLAGS += -DENABLE_LZMA
+endif
+# io_uring is driven through raw system calls, so only the kernel
+# headers are needed
+IO_URING := $(shell echo '\#include <linux/io_uring.h>' | $(CC) -E - >/dev/null 2>&1 && echo yes)
+ifeq ($(IO_URING),yes)
+    CPPFLAGS += -DENABLE_IO_URING
+endif
+# Trace spans (--trace=FILE); TRACE=0 compiles the hooks out
+TRACE ?= 1
+ifeq ($(TRACE),1)
+    CPPFLAGS += -DENABLE_TRACE
+endif
+STAR_LIBS := -lstar -lcommon $(ZLIB_LIBS) $(LZMA_LIBS)
+
 # Linker flags
-LDFLAGS := -Wl,--as-needed -Wl,--no-undefined
+LDFLAGS := -Wl,--as-needed -Wl,--no-undefined -pthread
 
 # Test-specific flags
 TEST_CPPFLAGS := $(CPPFLAGS) -I$(TESTS_DIR)/unity -I$(SRC_DIR)/common/include -I$(SRC_DIR)/stld/include -I$(SRC_DIR)/star/include
@@ -36,6 +36,7 @@ static const char* error_code_to_string(error_code_t code) {
         case ERROR_RELOCATION_FAILED: return "Relocation failed";
         case ERROR_SECTION_ALIGNMENT: return "Section alignment error";
         case ERROR_OUTPUT_TOO_LARGE: return "Output too large";
+        case ERROR_SCRIPT_SYNTAX: return "Linker script syntax error";
         case ERROR_ARCHIVE_CORRUPT: return "Archive corrupt";
         case ERROR_MEMBER_NOT_FOUND: return "Member not found";
         case ERROR_COMPRESSION_FAILED: return "Compression failed";
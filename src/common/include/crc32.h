@@ -0,0 +1,37 @@
+/* src/common/include/crc32.h */
+#ifndef CRC32_H_INCLUDED
+#define CRC32_H_INCLUDED
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file crc32.h
+ * @brief CRC-32 checksums shared by STLD and STAR
+ * @details C99 compliant CRC-32 (IEEE 802.3, reflected, polynomial
+ * 0xEDB88320): slicing-by-8, or the CPU's carry-less multiply or CRC
+ * instructions where available, with identical results on every path.
+ * Safe to call from several threads at once.
+ */
+
+/* Initial value for crc32_update */
+#define CRC32_INITIAL 0U
+
+/* CRC-32 of one buffer */
+uint32_t crc32_calculate(const void* data, size_t size);
+
+/*
+ * Continue a checksum: crc32_update(crc32_update(CRC32_INITIAL, a, n), b, m)
+ * equals the checksum of a followed by b.
+ */
+uint32_t crc32_update(uint32_t crc, const void* data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CRC32_H_INCLUDED */
@@ -42,6 +42,7 @@ typedef enum {
     ERROR_RELOCATION_FAILED = -23,
     ERROR_SECTION_ALIGNMENT = -24,
     ERROR_OUTPUT_TOO_LARGE = -25,
+    ERROR_SCRIPT_SYNTAX = -26,
     
     /* Archiver errors */
     ERROR_ARCHIVE_CORRUPT = -30,
@@ -20,6 +20,11 @@ extern "C" {
 #define MEMORY_POOL_ALIGN 8
 #define MEMORY_POOL_MIN_SIZE 64
 #define MEMORY_POOL_MAX_SIZE (1024 * 1024)  /* 1MB max */
+#define MEMORY_POOL_BLOCK_SIZE (64 * 1024)  /* Default growth step */
+
+/* Small size classes: one exact-fit free list per MEMORY_POOL_ALIGN step */
+#define MEMORY_POOL_SMALL_MAX 256
+#define MEMORY_POOL_SIZE_CLASSES (MEMORY_POOL_SMALL_MAX / MEMORY_POOL_ALIGN)
 
 /* Memory pool statistics */
 typedef struct memory_pool_stats {
@@ -29,23 +34,64 @@ typedef struct memory_pool_stats {
     size_t allocations;       /* Number of allocations */
     size_t deallocations;     /* Number of deallocations */
     size_t alignment;         /* Pool alignment */
+    size_t block_count;       /* Blocks in use (1 for fixed pools) */
+    size_t wasted_size;       /* Block tails abandoned by growth */
+    size_t free_list_size;    /* Bytes parked on size-class free lists */
+    size_t reused;            /* Allocations served from free lists */
+    double fragmentation;     /* Share of consumed bytes not in live use */
+    size_t class_allocations[MEMORY_POOL_SIZE_CLASSES]; /* Per class */
+    size_t class_free[MEMORY_POOL_SIZE_CLASSES];        /* Currently free */
 } memory_pool_stats_t;
 
+/* Checkpoint for memory_pool_rewind (contents are private) */
+typedef struct memory_pool_mark {
+    const void* block;        /* Newest block when the mark was taken */
+    void* free_ptr;
+    void* limit;
+    size_t used;
+    size_t wasted;
+} memory_pool_mark_t;
+
 /* Forward declaration */
 typedef struct memory_pool memory_pool_t;
 
 /* Memory pool operations */
 memory_pool_t* memory_pool_create(size_t size);
+
+/*
+ * Create a pool that chains block_size blocks as it fills (0 = default).
+ * Total capacity never exceeds max_size (0 = unlimited); the first block is
+ * shrunk to fit a small limit.
+ */
+memory_pool_t* memory_pool_create_growable(size_t block_size, size_t max_size);
 void memory_pool_destroy(memory_pool_t* pool);
 void* memory_pool_alloc(memory_pool_t* pool, size_t size);
 void* memory_pool_calloc(memory_pool_t* pool, size_t count, size_t size);
 void memory_pool_free(memory_pool_t* pool, void* ptr);
 void memory_pool_reset(memory_pool_t* pool);
 
+/*
+ * Return an allocation of a known size. Small sizes go onto their class
+ * free list and are handed out again by the next alloc of that class;
+ * larger blocks stay in place until reset or rewind.
+ */
+void memory_pool_free_sized(memory_pool_t* pool, void* ptr, size_t size);
+
+/*
+ * Phase checkpoints: rewind releases everything allocated since the mark,
+ * including chained blocks, and empties the free lists.
+ */
+memory_pool_mark_t memory_pool_mark(const memory_pool_t* pool);
+void memory_pool_rewind(memory_pool_t* pool, const memory_pool_mark_t* mark);
+
 /* Memory pool information */
 size_t memory_pool_get_size(const memory_pool_t* pool);
 size_t memory_pool_get_used(const memory_pool_t* pool);
 size_t memory_pool_get_available(const memory_pool_t* pool);
+
+/* High-water mark of used bytes; reset_peak restarts it at current use */
+size_t memory_pool_get_peak(const memory_pool_t* pool);
+void memory_pool_reset_peak(memory_pool_t* pool);
 void memory_pool_get_stats(const memory_pool_t* pool, memory_pool_stats_t* stats);
 
 /* Memory utilities */
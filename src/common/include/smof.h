@@ -8,8 +8,23 @@
 // SMOF Magic number: 'SMOF' in little-endian
 #define SMOF_MAGIC 0x534D4F46U
 
+// The magic as read from a file in the other byte order
+#define SMOF_MAGIC_SWAPPED 0x464F4D53U
+
 // SMOF Version
 #define SMOF_VERSION_CURRENT 1
+#define SMOF_VERSION_2       2  // 32-bit counts, 64-bit table offsets
+
+// Version 1 limits. stld's output writer switches to version 2 past any
+// of them; the smof_context_t builder only writes version 1 and rejects
+// entries past them
+#define SMOF_V1_MAX_SECTIONS     256
+#define SMOF_V1_MAX_SYMBOLS      32767
+#define SMOF_V1_MAX_RELOCATIONS  0xFFFFU
+#define SMOF_V1_MAX_STRING_TABLE 1048576
+
+// Version 2 sections are limited by the 16-bit section index of a symbol
+#define SMOF_V2_MAX_SECTIONS     0xFFFFU
 
 // SMOF Header flags
 #define SMOF_FLAG_EXECUTABLE    0x0001  // Executable file
@@ -73,6 +88,24 @@ typedef struct {
     uint16_t import_count;       // Number of imports
 } __attribute__((packed)) smof_header_t;
 
+// SMOF v2 Header structure (56 bytes). The first 8 bytes match v1, so
+// the version tells which header follows; the section, symbol and import
+// tables are as in v1, the relocation table holds smof_relocation_v2_t.
+typedef struct {
+    uint32_t magic;              // 0x534D4F46 ('SMOF')
+    uint16_t version;            // SMOF_VERSION_2
+    uint16_t flags;              // File flags
+    uint32_t entry_point;        // Virtual address of entry point
+    uint32_t section_count;      // Number of sections
+    uint32_t symbol_count;       // Number of symbols
+    uint32_t reloc_count;        // Number of relocations
+    uint32_t import_count;       // Number of imports
+    uint32_t string_table_size;  // Size of string table
+    uint64_t string_table_offset; // Offset to string table
+    uint64_t section_table_offset; // Offset to section table
+    uint64_t reloc_table_offset;   // Offset to relocation table
+} __attribute__((packed)) smof_header_v2_t;
+
 // Section Table Entry (12 bytes)
 typedef struct {
     uint32_t name_offset;        // Offset into string table
@@ -102,6 +135,15 @@ typedef struct {
     uint8_t  section_index;      // Section to relocate
 } __attribute__((packed)) smof_relocation_t;
 
+// v2 Relocation Entry (16 bytes)
+typedef struct {
+    uint32_t offset;             // Offset within section
+    uint32_t symbol_index;       // Index into symbol table
+    uint32_t section_index;      // Section to relocate
+    uint8_t  type;               // Relocation type
+    uint8_t  reserved[3];        // Reserved for future use
+} __attribute__((packed)) smof_relocation_v2_t;
+
 // Import Table Entry (8 bytes)
 typedef struct {
     uint32_t name_offset;        // Library name offset
@@ -129,12 +171,34 @@ typedef struct {
     size_t symbols_capacity;
     size_t relocations_capacity;
     size_t imports_capacity;
+    uint32_t *string_slots;         // Open-addressed string offsets, 0 = empty slot
+    size_t string_slot_count;       // Power of two, 0 until a string is added
+    size_t string_count;            // Strings in string_slots
 } smof_context_t;
 
+// smof_add_string's result when the string could not be added
+#define SMOF_STRING_INVALID 0xFFFFFFFFU
+
+// Most bytes of padding smof_write_file puts before section data (log2)
+#define SMOF_MAX_FILE_ALIGNMENT_SHIFT 12
+
 // Function declarations
 // output_format_ops_t *get_smof_format(void); // STAS-specific function
 
 // SMOF-specific functions
+//
+// Building a file in memory. Tables grow by doubling, and smof_add_string
+// returns the offset of an equal string already in the table, so names
+// are stored once. smof_add_section copies size bytes of data unless the
+// section is zero-filled or data is NULL (zeros), and returns the new
+// section's index; smof_add_symbol and smof_add_relocation return the
+// new entry's index too, or a negative error code, ERROR_SYSTEM_LIMIT
+// past a version 1 limit (strings added past the string table limit
+// give SMOF_STRING_INVALID). smof_write_file lays
+// the file out as header, section, symbol, relocation and import tables,
+// string table, then section data at each section's alignment; the
+// file_offset passed for a section is replaced by where its data goes.
+// The whole file goes out in one writev sequence.
 int smof_init_context(smof_context_t *ctx);
 void smof_cleanup_context(smof_context_t *ctx);
 uint32_t smof_add_string(smof_context_t *ctx, const char *str);
@@ -143,14 +207,61 @@ int smof_add_section(smof_context_t *ctx, const char *name, uint32_t virtual_add
                      const uint8_t *data);
 int smof_add_symbol(smof_context_t *ctx, const char *name, uint32_t value,
                     uint32_t size, uint16_t section_index, uint8_t type, uint8_t binding);
+int smof_add_relocation(smof_context_t *ctx, uint32_t offset, uint16_t symbol_index,
+                        uint8_t type, uint8_t section_index);
 int smof_write_file(smof_context_t *ctx, const char *filename, bool verbose);
 
 // Validation functions
 int smof_validate_header(const smof_header_t *header);
+int smof_validate_header_v2(const smof_header_v2_t *header);
 int smof_validate_section(const smof_section_t *section);
 
+// A file's layout as read from either header version, in host types.
+// smof_decode_header validates a header of either byte order from the
+// first size bytes of a file; smof_layout_fits checks that every table
+// lies within a file of size bytes, and smof_read_layout does both for an
+// image in memory. The tables themselves are left as they are.
+typedef struct {
+    uint16_t version;
+    uint16_t flags;
+    uint32_t entry_point;
+    uint32_t section_count;
+    uint32_t symbol_count;
+    uint32_t reloc_count;
+    uint32_t import_count;
+    uint32_t string_table_size;
+    uint64_t string_table_offset;
+    uint64_t section_table_offset;
+    uint64_t symbol_table_offset;  // Right after the section table
+    uint64_t reloc_table_offset;
+    size_t header_size;            // sizeof the version's header
+    size_t reloc_entry_size;       // sizeof the version's relocation entry
+} smof_layout_t;
+
+int smof_decode_header(const void *header, size_t size, smof_layout_t *layout);
+bool smof_layout_fits(const smof_layout_t *layout, uint64_t size);
+int smof_read_layout(const void *image, size_t size, smof_layout_t *layout);
+
 // Endianness helper functions
 bool smof_is_little_endian(const smof_header_t *header);
 bool smof_is_big_endian(const smof_header_t *header);
 
+// Reading a file written in either byte order. smof_is_foreign tells
+// whether an image's tables are in the other order than this host's;
+// smof_convert_to_native swaps the header and the section, symbol,
+// relocation and import tables of such an image in place, a whole table
+// per pass, so readers can then cast the tables as usual. An image
+// already in host order is left untouched. Section contents are never
+// swapped. The smof_swap_* functions do one table, or a copy of one.
+// Both header versions are handled.
+bool smof_is_foreign(const void *image, size_t size);
+int smof_convert_to_native(uint8_t *image, size_t size);
+void smof_swap_header(smof_header_t *header);
+void smof_swap_header_v2(smof_header_v2_t *header);
+void smof_swap_sections(smof_section_t *sections, size_t count);
+void smof_swap_symbols(smof_symbol_t *symbols, size_t count);
+void smof_swap_relocations(smof_relocation_t *relocations, size_t count);
+void smof_swap_relocations_v2(smof_relocation_v2_t *relocations, size_t count);
+void smof_swap_imports(smof_import_t *imports, size_t count);
+
 #endif // SMOF_H
@@ -0,0 +1,56 @@
+/* src/common/include/thread_pool.h */
+#ifndef THREAD_POOL_H_INCLUDED
+#define THREAD_POOL_H_INCLUDED
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file thread_pool.h
+ * @brief Fixed-size worker pool for data-parallel phases
+ * @details C99 compliant pthread pool. Work is submitted as a batch of
+ * indexed tasks; workers claim indices in increasing order and the
+ * submitting thread takes part, so a pool of one thread runs everything
+ * inline with no synchronization.
+ */
+
+/* Thread pool configuration */
+#define THREAD_POOL_MAX_THREADS 256
+
+/* Task callback: returns ERROR_SUCCESS or an error code */
+typedef int (*thread_pool_task_t)(void* user_data, size_t index);
+
+/* Forward declaration */
+typedef struct thread_pool thread_pool_t;
+
+/* Thread pool operations (thread_count 0 = one per online CPU) */
+thread_pool_t* thread_pool_create(size_t thread_count);
+void thread_pool_destroy(thread_pool_t* pool);
+
+/*
+ * Run task(user_data, i) for every i in [0, task_count) and wait for the
+ * batch to finish. After a task fails no further indices are started; the
+ * error of the lowest failing index is returned, which makes the result
+ * independent of scheduling.
+ */
+int thread_pool_run(thread_pool_t* pool, size_t task_count,
+                    thread_pool_task_t task, void* user_data);
+
+/* Thread pool information */
+size_t thread_pool_get_thread_count(const thread_pool_t* pool);
+size_t thread_pool_get_cpu_count(void);
+
+/* C99 inline utility functions */
+static inline bool thread_pool_is_parallel(const thread_pool_t* pool) {
+    return pool != NULL && thread_pool_get_thread_count(pool) > 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* THREAD_POOL_H_INCLUDED */
@@ -0,0 +1,73 @@
+/* src/common/include/trace.h */
+#ifndef TRACE_H_INCLUDED
+#define TRACE_H_INCLUDED
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file trace.h
+ * @brief Timed spans exported as a Chrome trace
+ * @details Spans are recorded into a ring buffer owned by the thread that
+ * ends them, so recording takes no lock; only a thread's first span of a
+ * session registers its ring. A full ring overwrites its oldest spans.
+ * trace_stop writes every ring as one Chrome/Perfetto JSON trace of
+ * complete ("X") events. Instrumentation goes through TRACE_BEGIN and
+ * TRACE_END, which compile to nothing without ENABLE_TRACE.
+ */
+
+/* Spans kept per thread */
+#define TRACE_RING_EVENTS 16384
+
+/* Detail text kept per span, including the terminator */
+#define TRACE_DETAIL_MAX  64
+
+/* Span opened by TRACE_BEGIN */
+typedef struct trace_span {
+    const char* name;               /* Static name of the span */
+    uint64_t start;                 /* Nanoseconds since trace_start */
+    bool recording;                 /* Whether a session was active at begin */
+} trace_span_t;
+
+/*
+ * Open filename and start recording spans; process_name (static) labels
+ * the trace. Fails with ERROR_INVALID_ARGUMENT while a session is active
+ * or when tracing is not built in, ERROR_FILE_IO if filename cannot be
+ * created.
+ */
+int trace_start(const char* filename, const char* process_name);
+
+/*
+ * Write the trace, close the file and end the session. No span may be
+ * open on another thread; ERROR_FILE_IO if the file cannot be written.
+ */
+int trace_stop(void);
+
+bool trace_is_available(void);
+bool trace_is_active(void);
+
+/*
+ * detail (may be NULL) names what the span worked on; it is copied, and
+ * of longer text only the end is kept, which for a path is the file name
+ */
+void trace_span_begin(trace_span_t* span, const char* name);
+void trace_span_end(trace_span_t* span, const char* detail);
+
+#ifdef ENABLE_TRACE
+#define TRACE_BEGIN(span, name) trace_span_begin(&(span), (name))
+#define TRACE_END(span, detail) trace_span_end(&(span), (detail))
+#else
+#define TRACE_BEGIN(span, name) ((void)(span))
+#define TRACE_END(span, detail) ((void)(span))
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACE_H_INCLUDED */
@@ -12,6 +12,18 @@
  * @details C99 compliant memory management for embedded systems
  */
 
+/* Overflow block of a growable pool */
+typedef struct memory_block {
+    struct memory_block* next;      /* Previous (older) block */
+    size_t size;                    /* Usable bytes in data */
+    uint8_t data[];                 /* C99 flexible array member */
+} memory_block_t;
+
+/* Free list link stored in a released small allocation */
+typedef struct memory_free_node {
+    struct memory_free_node* next;
+} memory_free_node_t;
+
 /* Memory pool structure with C99 flexible array member */
 struct memory_pool {
     size_t size;                    /* Total pool size */
@@ -21,9 +33,31 @@ struct memory_pool {
     size_t deallocations;           /* Number of deallocations */
     size_t alignment;               /* Pool alignment */
     uint8_t* free_ptr;              /* Next free position */
+    uint8_t* limit;                 /* End of the current block */
+    size_t base_size;               /* Bytes in the inline first block */
+    size_t block_size;              /* Growth step (0 = fixed pool) */
+    size_t max_size;                /* Growth limit (0 = unlimited) */
+    memory_block_t* blocks;         /* Overflow blocks, newest first */
+    size_t block_count;             /* Blocks including the inline one */
+    size_t wasted;                  /* Tails abandoned by grow_pool */
+    size_t free_list_bytes;         /* Bytes on the class free lists */
+    size_t reused;                  /* Allocations served by free lists */
+    memory_free_node_t* free_lists[MEMORY_POOL_SIZE_CLASSES];
+    size_t class_allocations[MEMORY_POOL_SIZE_CLASSES];
+    size_t class_free[MEMORY_POOL_SIZE_CLASSES];
     uint8_t data[];                 /* C99 flexible array member */
 };
 
+static size_t size_class(size_t aligned_size) {
+    return aligned_size / MEMORY_POOL_ALIGN - 1;
+}
+
+static void clear_free_lists(memory_pool_t* pool) {
+    memset(pool->free_lists, 0, sizeof(pool->free_lists));
+    memset(pool->class_free, 0, sizeof(pool->class_free));
+    pool->free_list_bytes = 0;
+}
+
 memory_pool_t* memory_pool_create(size_t size) {
     memory_pool_t* pool;
     
@@ -45,18 +79,120 @@ memory_pool_t* memory_pool_create(size_t size) {
         .peak_used = 0,
         .allocations = 0,
         .deallocations = 0,
-        .alignment = MEMORY_POOL_ALIGN
+        .alignment = MEMORY_POOL_ALIGN,
+        .base_size = size,
+        .block_size = 0,
+        .max_size = 0,
+        .blocks = NULL,
+        .block_count = 1
+    };
+    
+    pool->free_ptr = pool->data;
+    pool->limit = pool->data + size;
+    
+    return pool;
+}
+
+memory_pool_t* memory_pool_create_growable(size_t block_size, size_t max_size) {
+    memory_pool_t* pool;
+    
+    if (block_size == 0) {
+        block_size = MEMORY_POOL_BLOCK_SIZE;
+    }
+    
+    block_size = memory_align_size(block_size, MEMORY_POOL_ALIGN);
+    if (block_size < MEMORY_POOL_MIN_SIZE) {
+        block_size = MEMORY_POOL_MIN_SIZE;
+    }
+    
+    if (max_size != 0 && max_size < block_size) {
+        if (max_size < MEMORY_POOL_MIN_SIZE) {
+            ERROR_REPORT_ERROR(ERROR_INVALID_ARGUMENT, "Invalid pool size");
+            return NULL;
+        }
+        block_size = max_size & ~(size_t)(MEMORY_POOL_ALIGN - 1);
+    }
+    
+    pool = malloc(sizeof(memory_pool_t) + block_size);
+    if (pool == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate memory pool");
+        return NULL;
+    }
+    
+    *pool = (memory_pool_t) {
+        .size = block_size,
+        .used = 0,
+        .peak_used = 0,
+        .allocations = 0,
+        .deallocations = 0,
+        .alignment = MEMORY_POOL_ALIGN,
+        .base_size = block_size,
+        .block_size = block_size,
+        .max_size = max_size,
+        .blocks = NULL,
+        .block_count = 1
     };
     
     pool->free_ptr = pool->data;
+    pool->limit = pool->data + block_size;
     
     return pool;
 }
 
+/* Free chained blocks newer than keep (NULL = all of them) */
+static void release_blocks(memory_pool_t* pool, const memory_block_t* keep) {
+    memory_block_t* block = pool->blocks;
+    
+    while (block != NULL && block != keep) {
+        memory_block_t* next = block->next;
+        pool->size -= block->size;
+        pool->block_count--;
+        free(block);
+        block = next;
+    }
+    
+    pool->blocks = block;
+}
+
+/* Chain a new block big enough for aligned_size; the old tail is abandoned */
+static bool grow_pool(memory_pool_t* pool, size_t aligned_size) {
+    memory_block_t* block;
+    size_t size = pool->block_size > aligned_size ? pool->block_size : aligned_size;
+    
+    if (pool->max_size != 0) {
+        size_t remaining = pool->max_size > pool->size ? pool->max_size - pool->size : 0;
+        
+        if (remaining < aligned_size) {
+            return false;
+        }
+        if (size > remaining) {
+            size = remaining;
+        }
+    }
+    
+    block = malloc(sizeof(memory_block_t) + size);
+    if (block == NULL) {
+        return false;
+    }
+    
+    block->next = pool->blocks;
+    block->size = size;
+    pool->blocks = block;
+    pool->size += size;
+    pool->block_count++;
+    pool->wasted += (size_t)(pool->limit - pool->free_ptr);
+    pool->free_ptr = memory_align_ptr(block->data, pool->alignment);
+    pool->limit = block->data + size;
+    
+    return true;
+}
+
 void memory_pool_destroy(memory_pool_t* pool) {
     if (pool != NULL) {
+        release_blocks(pool, NULL);
+        
         /* Clear sensitive data before freeing */
-        memset(pool, 0, sizeof(memory_pool_t) + pool->size);
+        memset(pool, 0, sizeof(memory_pool_t) + pool->base_size);
         free(pool);
     }
 }
@@ -72,8 +208,32 @@ void* memory_pool_alloc(memory_pool_t* pool, size_t size) {
     /* Align size to pool alignment */
     aligned_size = memory_align_size(size, pool->alignment);
     
-    /* Check if allocation fits */
-    if (pool->used + aligned_size > pool->size) {
+    /* Small sizes are served from their class free list first */
+    if (aligned_size <= MEMORY_POOL_SMALL_MAX) {
+        size_t cls = size_class(aligned_size);
+        memory_free_node_t* node = pool->free_lists[cls];
+        
+        pool->class_allocations[cls]++;
+        
+        if (node != NULL) {
+            pool->free_lists[cls] = node->next;
+            pool->class_free[cls]--;
+            pool->free_list_bytes -= aligned_size;
+            pool->used += aligned_size;
+            pool->allocations++;
+            pool->reused++;
+            
+            if (pool->used > pool->peak_used) {
+                pool->peak_used = pool->used;
+            }
+            
+            return node;
+        }
+    }
+    
+    /* Check if allocation fits; growable pools chain another block */
+    if (aligned_size > (size_t)(pool->limit - pool->free_ptr) &&
+        (pool->block_size == 0 || !grow_pool(pool, aligned_size))) {
         ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Pool exhausted");
         return NULL;
     }
@@ -123,14 +283,73 @@ void memory_pool_free(memory_pool_t* pool, void* ptr) {
     }
 }
 
+void memory_pool_free_sized(memory_pool_t* pool, void* ptr, size_t size) {
+    memory_free_node_t* node = ptr;
+    size_t aligned_size;
+    size_t cls;
+    
+    if (pool == NULL || ptr == NULL || size == 0) {
+        return;
+    }
+    
+    pool->deallocations++;
+    
+    aligned_size = memory_align_size(size, pool->alignment);
+    if (aligned_size > MEMORY_POOL_SMALL_MAX) {
+        return;
+    }
+    
+    cls = size_class(aligned_size);
+    node->next = pool->free_lists[cls];
+    pool->free_lists[cls] = node;
+    pool->class_free[cls]++;
+    pool->free_list_bytes += aligned_size;
+    pool->used -= aligned_size;
+}
+
 void memory_pool_reset(memory_pool_t* pool) {
     if (pool != NULL) {
+        release_blocks(pool, NULL);
+        clear_free_lists(pool);
         pool->used = 0;
+        pool->wasted = 0;
         pool->free_ptr = pool->data;
+        pool->limit = pool->data + pool->base_size;
         /* Keep allocation/deallocation counters for statistics */
     }
 }
 
+memory_pool_mark_t memory_pool_mark(const memory_pool_t* pool) {
+    memory_pool_mark_t mark = { NULL, NULL, NULL, 0, 0 };
+    
+    if (pool != NULL) {
+        mark.block = pool->blocks;
+        mark.free_ptr = pool->free_ptr;
+        mark.limit = pool->limit;
+        mark.used = pool->used;
+        mark.wasted = pool->wasted;
+    }
+    
+    return mark;
+}
+
+void memory_pool_rewind(memory_pool_t* pool, const memory_pool_mark_t* mark) {
+    if (pool == NULL || mark == NULL || mark->free_ptr == NULL) {
+        return;
+    }
+    
+    /*
+     * Free lists may thread through memory that is being released, or
+     * through pre-mark nodes reused since; neither can be kept.
+     */
+    release_blocks(pool, mark->block);
+    clear_free_lists(pool);
+    pool->free_ptr = mark->free_ptr;
+    pool->limit = mark->limit;
+    pool->used = mark->used;
+    pool->wasted = mark->wasted;
+}
+
 size_t memory_pool_get_size(const memory_pool_t* pool) {
     return pool ? pool->size : 0;
 }
@@ -139,11 +358,35 @@ size_t memory_pool_get_used(const memory_pool_t* pool) {
     return pool ? pool->used : 0;
 }
 
+size_t memory_pool_get_peak(const memory_pool_t* pool) {
+    return pool ? pool->peak_used : 0;
+}
+
+void memory_pool_reset_peak(memory_pool_t* pool) {
+    if (pool != NULL) {
+        pool->peak_used = pool->used;
+    }
+}
+
 size_t memory_pool_get_available(const memory_pool_t* pool) {
-    return pool ? pool->size - pool->used : 0;
+    if (pool == NULL) {
+        return 0;
+    }
+    
+    /* Growable pools can take anything up to their limit */
+    if (pool->block_size != 0) {
+        if (pool->max_size == 0) {
+            return SIZE_MAX - pool->used;
+        }
+        return pool->max_size > pool->used ? pool->max_size - pool->used : 0;
+    }
+    
+    return pool->size - pool->used;
 }
 
 void memory_pool_get_stats(const memory_pool_t* pool, memory_pool_stats_t* stats) {
+    size_t consumed;
+    
     if (pool == NULL || stats == NULL) {
         return;
     }
@@ -154,8 +397,23 @@ void memory_pool_get_stats(const memory_pool_t* pool, memory_pool_stats_t* stats
         .peak_used = pool->peak_used,
         .allocations = pool->allocations,
         .deallocations = pool->deallocations,
-        .alignment = pool->alignment
+        .alignment = pool->alignment,
+        .block_count = pool->block_count,
+        .wasted_size = pool->wasted,
+        .free_list_size = pool->free_list_bytes,
+        .reused = pool->reused,
+        .fragmentation = 0.0
     };
+    
+    consumed = pool->used + pool->wasted + pool->free_list_bytes;
+    if (consumed > 0) {
+        stats->fragmentation = (double)(pool->wasted + pool->free_list_bytes) /
+                               (double)consumed;
+    }
+    
+    memcpy(stats->class_allocations, pool->class_allocations,
+           sizeof(stats->class_allocations));
+    memcpy(stats->class_free, pool->class_free, sizeof(stats->class_free));
 }
 
 void* memory_align_ptr(void* ptr, size_t alignment) {
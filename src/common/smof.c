@@ -1,17 +1,34 @@
 /* src/common/smof.c */
 #include "smof.h"
+#include "error.h"
 #include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
 /**
  * @file smof.c
- * @brief SMOF format implementation (stub)
- * @details STIX Machine Object Format implementation
+ * @brief SMOF format implementation
+ * @details STIX Machine Object Format validation, and building a file in
+ * memory to write it out in one pass
  */
 
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+/* Entries allocated on the first add to a table */
+#define SMOF_INITIAL_CAPACITY     16
+#define SMOF_STRING_TABLE_INITIAL 256
+#define SMOF_STRING_SLOTS_INITIAL 64
+
 /* Default SMOF header - STAS Compatible Format */
 const smof_header_t smof_default_header = {
     .magic = SMOF_MAGIC,
@@ -28,10 +45,24 @@ const smof_header_t smof_default_header = {
     .import_count = 0
 };
 
-int smof_validate_header(const smof_header_t* header) {
+/* Exactly one byte order flag */
+static bool endian_flags_valid(uint16_t flags) {
     bool little_endian;
     bool big_endian;
     
+    little_endian = (flags & SMOF_FLAG_LITTLE_ENDIAN) != 0;
+    big_endian = (flags & SMOF_FLAG_BIG_ENDIAN) != 0;
+    
+    // Also check STAS-compatible endianness flags (0x0010/0x0020)
+    if (!little_endian && !big_endian) {
+        little_endian = (flags & 0x0010) != 0;  // STAS SMOF_FLAG_LITTLE_ENDIAN
+        big_endian = (flags & 0x0020) != 0;     // STAS SMOF_FLAG_BIG_ENDIAN
+    }
+    
+    return little_endian != big_endian;
+}
+
+int smof_validate_header(const smof_header_t* header) {
     if (header == NULL) {
         return 0;
     }
@@ -41,39 +72,26 @@ int smof_validate_header(const smof_header_t* header) {
         return 0;
     }
     
-    /* Check version */
+    /* Check version; a v2 header does not fit this struct */
     if (header->version > SMOF_VERSION_CURRENT) {
         return 0;
     }
     
     /* Check endianness flags */
-    little_endian = (header->flags & SMOF_FLAG_LITTLE_ENDIAN) != 0;
-    big_endian = (header->flags & SMOF_FLAG_BIG_ENDIAN) != 0;
-    
-    // Also check STAS-compatible endianness flags (0x0010/0x0020)
-    if (!little_endian && !big_endian) {
-        little_endian = (header->flags & 0x0010) != 0;  // STAS SMOF_FLAG_LITTLE_ENDIAN
-        big_endian = (header->flags & 0x0020) != 0;     // STAS SMOF_FLAG_BIG_ENDIAN
-    }
-    
-    if (little_endian && big_endian) {
-        return 0; /* Both flags set */
-    }
-    
-    if (!little_endian && !big_endian) {
-        return 0; /* Neither flag set */
+    if (!endian_flags_valid(header->flags)) {
+        return 0;
     }
     
     /* Sanity checks */
-    if (header->section_count > 256) {
+    if (header->section_count > SMOF_V1_MAX_SECTIONS) {
         return 0; /* Reasonable limit */
     }
     
-    if (header->symbol_count > 32767) {
+    if (header->symbol_count > SMOF_V1_MAX_SYMBOLS) {
         return 0; /* uint16_t reasonable limit */
     }
     
-    if (header->string_table_size > 1048576) {
+    if (header->string_table_size > SMOF_V1_MAX_STRING_TABLE) {
         return 0; /* 1MB limit */
     }
     
@@ -115,6 +133,61 @@ int smof_validate_header(const smof_header_t* header) {
     return 1;
 }
 
+int smof_validate_header_v2(const smof_header_v2_t* header) {
+    uint64_t section_end;
+    uint64_t reloc_end;
+    
+    if (header == NULL || header->magic != SMOF_MAGIC || header->version != SMOF_VERSION_2) {
+        return 0;
+    }
+    
+    if (!endian_flags_valid(header->flags)) {
+        return 0;
+    }
+    
+    /* Symbols name their section in 16 bits, 0xFFFF being undefined */
+    if (header->section_count > SMOF_V2_MAX_SECTIONS) {
+        return 0;
+    }
+    
+    /* Tables lie after the header */
+    if ((header->section_table_offset > 0 &&
+         header->section_table_offset < sizeof(smof_header_v2_t)) ||
+        (header->string_table_offset > 0 &&
+         header->string_table_offset < sizeof(smof_header_v2_t)) ||
+        (header->reloc_table_offset > 0 &&
+         header->reloc_table_offset < sizeof(smof_header_v2_t))) {
+        return 0;
+    }
+    
+    /* Offsets are 64-bit but counts are not, so these sums cannot wrap */
+    if (header->section_table_offset > UINT64_MAX / 2 ||
+        header->reloc_table_offset > UINT64_MAX / 2 ||
+        header->string_table_offset > UINT64_MAX / 2) {
+        return 0;
+    }
+    
+    section_end = header->section_table_offset +
+                  (uint64_t)header->section_count * sizeof(smof_section_t) +
+                  (uint64_t)header->symbol_count * sizeof(smof_symbol_t);
+    reloc_end = header->reloc_table_offset +
+                (uint64_t)header->reloc_count * sizeof(smof_relocation_v2_t);
+    
+    /* The string table may not start inside the other tables */
+    if (header->string_table_offset > header->section_table_offset &&
+        header->string_table_offset < section_end) {
+        return 0;
+    }
+    
+    if (header->reloc_count > 0 &&
+        header->string_table_offset > header->reloc_table_offset &&
+        header->string_table_offset < reloc_end) {
+        return 0;
+    }
+    
+    return 1;
+}
+
 bool smof_is_little_endian(const smof_header_t* header) {
     return header != NULL && (header->flags & SMOF_FLAG_LITTLE_ENDIAN) != 0;
 }
@@ -122,3 +195,742 @@ bool smof_is_little_endian(const smof_header_t* header) {
 bool smof_is_big_endian(const smof_header_t* header) {
     return header != NULL && (header->flags & SMOF_FLAG_BIG_ENDIAN) != 0;
 }
+
+/*
+ * Byte order. A table is swapped with a byte permutation built from the
+ * widths of its struct's fields. Where entries tile a 16-byte lane (8 and
+ * 16 byte entries) the table goes through one shuffle per lane; sections
+ * and the header are swapped an entry at a time.
+ */
+#define SMOF_SWAP_LANE      16
+#define SMOF_SWAP_MAX_ENTRY 56
+
+/* Field widths in bytes, zero-terminated */
+static const uint8_t smof_header_fields[] = {4, 2, 2, 4, 2, 2, 4, 4, 4, 4, 2, 2, 0};
+static const uint8_t smof_section_fields[] = {4, 4, 4, 4, 2, 1, 1, 0};
+static const uint8_t smof_symbol_fields[] = {4, 4, 4, 2, 1, 1, 0};
+static const uint8_t smof_relocation_fields[] = {4, 2, 1, 1, 0};
+static const uint8_t smof_header_v2_fields[] = {4, 2, 2, 4, 4, 4, 4, 4, 4, 8, 8, 8, 0};
+static const uint8_t smof_relocation_v2_fields[] = {4, 4, 4, 1, 1, 1, 1, 0};
+static const uint8_t smof_import_fields[] = {4, 4, 0};
+
+/* pattern[i] is the byte that moves to i; size is a multiple of the entry size */
+static void build_swap_pattern(const uint8_t* fields, uint8_t* pattern, size_t size) {
+    size_t start;
+    size_t i;
+    size_t j;
+    
+    for (start = 0; start < size; ) {
+        for (i = 0; fields[i] != 0; i++) {
+            for (j = 0; j < fields[i]; j++) {
+                pattern[start + j] = (uint8_t)(start + fields[i] - 1 - j);
+            }
+            start += fields[i];
+        }
+    }
+}
+
+static void swap_entries(uint8_t* table, size_t count, size_t entry_size,
+                         const uint8_t* pattern) {
+    uint8_t entry[SMOF_SWAP_MAX_ENTRY];
+    size_t i;
+    size_t j;
+    
+    for (i = 0; i < count; i++, table += entry_size) {
+        memcpy(entry, table, entry_size);
+        for (j = 0; j < entry_size; j++) {
+            table[j] = entry[pattern[j]];
+        }
+    }
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+typedef uint8_t smof_lane_t __attribute__((vector_size(SMOF_SWAP_LANE)));
+
+/* Returns how many bytes were swapped, a multiple of the lane */
+static size_t swap_lanes(uint8_t* table, size_t size, const uint8_t* pattern) {
+    smof_lane_t shuffle;
+    smof_lane_t lane;
+    size_t offset;
+    
+    memcpy(&shuffle, pattern, sizeof(shuffle));
+    for (offset = 0; offset + SMOF_SWAP_LANE <= size; offset += SMOF_SWAP_LANE) {
+        memcpy(&lane, table + offset, sizeof(lane));
+        lane = __builtin_shuffle(lane, shuffle);
+        memcpy(table + offset, &lane, sizeof(lane));
+    }
+    
+    return offset;
+}
+#else
+static size_t swap_lanes(uint8_t* table, size_t size, const uint8_t* pattern) {
+    (void)table;
+    (void)size;
+    (void)pattern;
+    return 0;
+}
+#endif
+
+static void swap_table(void* table, size_t count, size_t entry_size, const uint8_t* fields) {
+    uint8_t pattern[SMOF_SWAP_MAX_ENTRY];
+    uint8_t* bytes = table;
+    size_t done = 0;
+    
+    if (table == NULL || count == 0) {
+        return;
+    }
+    
+    if (SMOF_SWAP_LANE % entry_size == 0) {
+        build_swap_pattern(fields, pattern, SMOF_SWAP_LANE);
+        done = swap_lanes(bytes, count * entry_size, pattern) / entry_size;
+    } else {
+        build_swap_pattern(fields, pattern, entry_size);
+    }
+    
+    /* The first entry_size bytes of a lane pattern swap a single entry */
+    swap_entries(bytes + done * entry_size, count - done, entry_size, pattern);
+}
+
+void smof_swap_header(smof_header_t* header) {
+    swap_table(header, 1, sizeof(smof_header_t), smof_header_fields);
+}
+
+void smof_swap_header_v2(smof_header_v2_t* header) {
+    swap_table(header, 1, sizeof(smof_header_v2_t), smof_header_v2_fields);
+}
+
+void smof_swap_sections(smof_section_t* sections, size_t count) {
+    swap_table(sections, count, sizeof(smof_section_t), smof_section_fields);
+}
+
+void smof_swap_symbols(smof_symbol_t* symbols, size_t count) {
+    swap_table(symbols, count, sizeof(smof_symbol_t), smof_symbol_fields);
+}
+
+void smof_swap_relocations(smof_relocation_t* relocations, size_t count) {
+    swap_table(relocations, count, sizeof(smof_relocation_t), smof_relocation_fields);
+}
+
+void smof_swap_relocations_v2(smof_relocation_v2_t* relocations, size_t count) {
+    swap_table(relocations, count, sizeof(smof_relocation_v2_t), smof_relocation_v2_fields);
+}
+
+void smof_swap_imports(smof_import_t* imports, size_t count) {
+    swap_table(imports, count, sizeof(smof_import_t), smof_import_fields);
+}
+
+bool smof_is_foreign(const void* image, size_t size) {
+    uint32_t magic;
+    
+    if (image == NULL || size < sizeof(smof_header_t)) {
+        return false;
+    }
+    
+    memcpy(&magic, image, sizeof(magic));
+    return magic == SMOF_MAGIC_SWAPPED;
+}
+
+static bool table_in_image(uint64_t size, uint64_t offset, uint64_t length) {
+    return length == 0 || (offset <= size && length <= size - offset);
+}
+
+/* The header's fields in host types, before any range check */
+static void decode_layout(const uint8_t* image, smof_layout_t* layout) {
+    smof_header_t v1;
+    smof_header_v2_t v2;
+    uint16_t version;
+    
+    memcpy(&version, image + offsetof(smof_header_t, version), sizeof(version));
+    
+    if (version == SMOF_VERSION_2) {
+        memcpy(&v2, image, sizeof(v2));
+        *layout = (smof_layout_t) {
+            .version = v2.version,
+            .flags = v2.flags,
+            .entry_point = v2.entry_point,
+            .section_count = v2.section_count,
+            .symbol_count = v2.symbol_count,
+            .reloc_count = v2.reloc_count,
+            .import_count = v2.import_count,
+            .string_table_size = v2.string_table_size,
+            .string_table_offset = v2.string_table_offset,
+            .section_table_offset = v2.section_table_offset,
+            .reloc_table_offset = v2.reloc_table_offset,
+            .header_size = sizeof(smof_header_v2_t),
+            .reloc_entry_size = sizeof(smof_relocation_v2_t)
+        };
+    } else {
+        memcpy(&v1, image, sizeof(v1));
+        *layout = (smof_layout_t) {
+            .version = v1.version,
+            .flags = v1.flags,
+            .entry_point = v1.entry_point,
+            .section_count = v1.section_count,
+            .symbol_count = v1.symbol_count,
+            .reloc_count = v1.reloc_count,
+            .import_count = v1.import_count,
+            .string_table_size = v1.string_table_size,
+            .string_table_offset = v1.string_table_offset,
+            .section_table_offset = v1.section_table_offset,
+            .reloc_table_offset = v1.reloc_table_offset,
+            .header_size = sizeof(smof_header_t),
+            .reloc_entry_size = sizeof(smof_relocation_t)
+        };
+    }
+    
+    layout->symbol_table_offset = layout->section_table_offset +
+                                  (uint64_t)layout->section_count * sizeof(smof_section_t);
+}
+
+int smof_decode_header(const void* header, size_t size, smof_layout_t* layout) {
+    smof_header_t v1;
+    smof_header_v2_t v2;
+    bool foreign;
+    
+    if (header == NULL || layout == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    if (size < sizeof(smof_header_t)) {
+        return ERROR_CORRUPT_HEADER;
+    }
+    
+    /* The first 8 bytes, version included, are common to both headers */
+    foreign = smof_is_foreign(header, size);
+    memcpy(&v1, header, sizeof(v1));
+    if (foreign) {
+        smof_swap_header(&v1);
+    }
+    
+    if (v1.version == SMOF_VERSION_2) {
+        if (size < sizeof(v2)) {
+            return ERROR_CORRUPT_HEADER;
+        }
+        memcpy(&v2, header, sizeof(v2));
+        if (foreign) {
+            smof_swap_header_v2(&v2);
+        }
+        if (!smof_validate_header_v2(&v2)) {
+            return ERROR_CORRUPT_HEADER;
+        }
+        decode_layout((const uint8_t*)&v2, layout);
+    } else {
+        if (!smof_validate_header(&v1)) {
+            return ERROR_CORRUPT_HEADER;
+        }
+        decode_layout((const uint8_t*)&v1, layout);
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+bool smof_layout_fits(const smof_layout_t* layout, uint64_t size) {
+    return layout != NULL &&
+           table_in_image(size, layout->section_table_offset,
+                          (uint64_t)layout->section_count * sizeof(smof_section_t)) &&
+           table_in_image(size, layout->symbol_table_offset,
+                          (uint64_t)layout->symbol_count * sizeof(smof_symbol_t)) &&
+           table_in_image(size, layout->reloc_table_offset,
+                          (uint64_t)layout->reloc_count * layout->reloc_entry_size) &&
+           table_in_image(size, layout->string_table_offset, layout->string_table_size);
+}
+
+int smof_read_layout(const void* image, size_t size, smof_layout_t* layout) {
+    int result;
+    
+    result = smof_decode_header(image, size, layout);
+    if (result == ERROR_SUCCESS && !smof_layout_fits(layout, size)) {
+        result = ERROR_CORRUPT_HEADER;
+    }
+    
+    return result;
+}
+
+int smof_convert_to_native(uint8_t* image, size_t size) {
+    smof_layout_t layout;
+    uint64_t import_offset;
+    int result;
+    
+    if (!smof_is_foreign(image, size)) {
+        return ERROR_SUCCESS;
+    }
+    
+    /* Every table is checked before the first byte is swapped */
+    result = smof_read_layout(image, size, &layout);
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    if (layout.version == SMOF_VERSION_2) {
+        smof_swap_header_v2((smof_header_v2_t*)image);
+        smof_swap_relocations_v2((smof_relocation_v2_t*)(image + layout.reloc_table_offset),
+                                 layout.reloc_count);
+    } else {
+        smof_swap_header((smof_header_t*)image);
+        smof_swap_relocations((smof_relocation_t*)(image + layout.reloc_table_offset),
+                              layout.reloc_count);
+    }
+    smof_swap_sections((smof_section_t*)(image + layout.section_table_offset), layout.section_count);
+    smof_swap_symbols((smof_symbol_t*)(image + layout.symbol_table_offset), layout.symbol_count);
+    
+    /* Imports follow the relocation table, so only a placed one locates them */
+    import_offset = layout.reloc_table_offset + (uint64_t)layout.reloc_count * layout.reloc_entry_size;
+    if (layout.reloc_table_offset != 0 &&
+        table_in_image(size, import_offset, (uint64_t)layout.import_count * sizeof(smof_import_t))) {
+        smof_swap_imports((smof_import_t*)(image + import_offset), layout.import_count);
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+/* Zeros to pad section data to its alignment */
+static uint8_t smof_padding[1U << SMOF_MAX_FILE_ALIGNMENT_SHIFT];
+
+int smof_init_context(smof_context_t* ctx) {
+    if (ctx == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->header = smof_default_header;
+    
+    return ERROR_SUCCESS;
+}
+
+void smof_cleanup_context(smof_context_t* ctx) {
+    uint16_t i;
+    
+    if (ctx == NULL) {
+        return;
+    }
+    
+    for (i = 0; ctx->section_data != NULL && i < ctx->header.section_count; i++) {
+        free(ctx->section_data[i].data);
+    }
+    free(ctx->sections);
+    free(ctx->symbols);
+    free(ctx->relocations);
+    free(ctx->imports);
+    free(ctx->section_data);
+    free(ctx->string_table);
+    free(ctx->string_slots);
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+/* Twice the capacity, or the first allocation's */
+static size_t next_capacity(size_t capacity) {
+    return capacity > 0 ? capacity * 2 : SMOF_INITIAL_CAPACITY;
+}
+
+/* Resize one table; its capacity is updated by the caller */
+static bool grow_array(void** array, size_t element_size, size_t capacity) {
+    void* grown = realloc(*array, capacity * element_size);
+    
+    if (grown == NULL) {
+        return false;
+    }
+    *array = grown;
+    
+    return true;
+}
+
+/* FNV-1a */
+static uint32_t hash_string(const char* str) {
+    uint32_t hash = 2166136261U;
+    
+    while (*str != '\0') {
+        hash ^= (uint8_t)*str++;
+        hash *= 16777619U;
+    }
+    
+    return hash;
+}
+
+/* Slot holding the offset of str, or the empty slot where it belongs */
+static size_t find_string_slot(const smof_context_t* ctx, const char* str) {
+    size_t mask = ctx->string_slot_count - 1;
+    size_t slot = hash_string(str) & mask;
+    
+    while (ctx->string_slots[slot] != 0 &&
+           strcmp(&ctx->string_table[ctx->string_slots[slot]], str) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    
+    return slot;
+}
+
+/* Double the hash, so it stays at most half full */
+static bool index_strings(smof_context_t* ctx) {
+    uint32_t* old_slots = ctx->string_slots;
+    size_t old_count = ctx->string_slot_count;
+    size_t i;
+    
+    ctx->string_slot_count = old_count > 0 ? old_count * 2 : SMOF_STRING_SLOTS_INITIAL;
+    ctx->string_slots = calloc(ctx->string_slot_count, sizeof(uint32_t));
+    if (ctx->string_slots == NULL) {
+        ctx->string_slots = old_slots;
+        ctx->string_slot_count = old_count;
+        return false;
+    }
+    
+    for (i = 0; i < old_count; i++) {
+        if (old_slots[i] != 0) {
+            ctx->string_slots[find_string_slot(ctx, &ctx->string_table[old_slots[i]])] =
+                old_slots[i];
+        }
+    }
+    free(old_slots);
+    
+    return true;
+}
+
+/* Make room for size more bytes, doubling; the table starts with the empty string */
+static bool reserve_strings(smof_context_t* ctx, size_t size) {
+    size_t capacity = ctx->string_table_capacity > 0 ? ctx->string_table_capacity :
+                      SMOF_STRING_TABLE_INITIAL;
+    size_t needed;
+    char* table;
+    
+    if (ctx->string_table == NULL) {
+        ctx->header.string_table_size = 1;
+    }
+    
+    /* The builder only writes version 1 */
+    needed = ctx->header.string_table_size + size;
+    if (needed > SMOF_V1_MAX_STRING_TABLE) {
+        return false;
+    }
+    if (ctx->string_table != NULL && needed <= ctx->string_table_capacity) {
+        return true;
+    }
+    
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    
+    table = realloc(ctx->string_table, capacity);
+    if (table == NULL) {
+        return false;
+    }
+    table[0] = '\0';
+    ctx->string_table = table;
+    ctx->string_table_capacity = capacity;
+    
+    return true;
+}
+
+/* Why a name could not be added: a full string table or no memory */
+static int string_error(const smof_context_t* ctx, const char* name) {
+    return ctx->header.string_table_size + strlen(name) + 1 > SMOF_V1_MAX_STRING_TABLE ?
+           ERROR_SYSTEM_LIMIT : ERROR_OUT_OF_MEMORY;
+}
+
+uint32_t smof_add_string(smof_context_t* ctx, const char* str) {
+    uint32_t offset;
+    size_t length;
+    size_t slot;
+    
+    if (ctx == NULL || str == NULL) {
+        return SMOF_STRING_INVALID;
+    }
+    
+    length = strlen(str) + 1;
+    if (!reserve_strings(ctx, length)) {
+        return SMOF_STRING_INVALID;
+    }
+    if (length == 1) {
+        return 0;
+    }
+    
+    if ((ctx->string_count + 1) * 2 > ctx->string_slot_count && !index_strings(ctx)) {
+        return SMOF_STRING_INVALID;
+    }
+    
+    slot = find_string_slot(ctx, str);
+    if (ctx->string_slots[slot] != 0) {
+        return ctx->string_slots[slot];
+    }
+    
+    offset = ctx->header.string_table_size;
+    memcpy(&ctx->string_table[offset], str, length);
+    ctx->header.string_table_size += (uint32_t)length;
+    ctx->string_slots[slot] = offset;
+    ctx->string_count++;
+    
+    return offset;
+}
+
+int smof_add_section(smof_context_t* ctx, const char* name, uint32_t virtual_addr,
+                     uint32_t size, uint32_t file_offset, uint16_t flags, uint8_t alignment,
+                     const uint8_t* data) {
+    smof_section_data_t* contents;
+    uint32_t name_offset;
+    size_t capacity;
+    uint16_t index;
+    
+    if (ctx == NULL || name == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    index = ctx->header.section_count;
+    if (index == SMOF_V1_MAX_SECTIONS) {
+        return ERROR_SYSTEM_LIMIT;
+    }
+    
+    /* Entries and their data grow together */
+    if (index == ctx->sections_capacity) {
+        capacity = next_capacity(ctx->sections_capacity);
+        if (!grow_array((void**)&ctx->sections, sizeof(smof_section_t), capacity) ||
+            !grow_array((void**)&ctx->section_data, sizeof(smof_section_data_t), capacity)) {
+            return ERROR_OUT_OF_MEMORY;
+        }
+        ctx->sections_capacity = capacity;
+    }
+    
+    name_offset = smof_add_string(ctx, name);
+    if (name_offset == SMOF_STRING_INVALID) {
+        return string_error(ctx, name);
+    }
+    
+    contents = &ctx->section_data[index];
+    memset(contents, 0, sizeof(*contents));
+    if ((flags & SMOF_SECT_ZERO_FILL) == 0 && size > 0) {
+        contents->data = data != NULL ? malloc(size) : calloc(size, 1);
+        if (contents->data == NULL) {
+            return ERROR_OUT_OF_MEMORY;
+        }
+        if (data != NULL) {
+            memcpy(contents->data, data, size);
+        }
+        contents->size = size;
+        contents->capacity = size;
+    }
+    
+    ctx->sections[index] = (smof_section_t) {
+        .name_offset = name_offset,
+        .virtual_addr = virtual_addr,
+        .size = size,
+        .file_offset = file_offset,
+        .flags = flags,
+        .alignment = alignment,
+        .reserved = 0
+    };
+    ctx->header.section_count++;
+    
+    return index;
+}
+
+int smof_add_symbol(smof_context_t* ctx, const char* name, uint32_t value,
+                    uint32_t size, uint16_t section_index, uint8_t type, uint8_t binding) {
+    uint32_t name_offset;
+    size_t capacity;
+    uint16_t index;
+    
+    if (ctx == NULL || name == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    index = ctx->header.symbol_count;
+    if (index == SMOF_V1_MAX_SYMBOLS) {
+        return ERROR_SYSTEM_LIMIT;
+    }
+    
+    if (index == ctx->symbols_capacity) {
+        capacity = next_capacity(ctx->symbols_capacity);
+        if (!grow_array((void**)&ctx->symbols, sizeof(smof_symbol_t), capacity)) {
+            return ERROR_OUT_OF_MEMORY;
+        }
+        ctx->symbols_capacity = capacity;
+    }
+    
+    name_offset = smof_add_string(ctx, name);
+    if (name_offset == SMOF_STRING_INVALID) {
+        return string_error(ctx, name);
+    }
+    
+    ctx->symbols[index] = (smof_symbol_t) {
+        .name_offset = name_offset,
+        .value = value,
+        .size = size,
+        .section_index = section_index,
+        .type = type,
+        .binding = binding
+    };
+    ctx->header.symbol_count++;
+    
+    return index;
+}
+
+int smof_add_relocation(smof_context_t* ctx, uint32_t offset, uint16_t symbol_index,
+                        uint8_t type, uint8_t section_index) {
+    size_t capacity;
+    uint16_t index;
+    
+    if (ctx == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    index = ctx->header.reloc_count;
+    if (index == UINT16_MAX) {
+        return ERROR_SYSTEM_LIMIT;
+    }
+    
+    if (index == ctx->relocations_capacity) {
+        capacity = next_capacity(ctx->relocations_capacity);
+        if (!grow_array((void**)&ctx->relocations, sizeof(smof_relocation_t), capacity)) {
+            return ERROR_OUT_OF_MEMORY;
+        }
+        ctx->relocations_capacity = capacity;
+    }
+    
+    ctx->relocations[index] = (smof_relocation_t) {
+        .offset = offset,
+        .symbol_index = symbol_index,
+        .type = type,
+        .section_index = section_index
+    };
+    ctx->header.reloc_count++;
+    
+    return index;
+}
+
+/* Fill in the table offsets and where each section's data goes; returns the file size */
+static uint64_t layout_file(smof_context_t* ctx) {
+    smof_header_t* header = &ctx->header;
+    uint64_t offset = sizeof(smof_header_t);
+    uint64_t mask;
+    uint16_t i;
+    
+    header->section_table_offset = (uint32_t)offset;
+    offset += (uint64_t)header->section_count * sizeof(smof_section_t) +
+              (uint64_t)header->symbol_count * sizeof(smof_symbol_t);
+    header->reloc_table_offset = header->reloc_count > 0 ? (uint32_t)offset : 0;
+    offset += (uint64_t)header->reloc_count * sizeof(smof_relocation_t) +
+              (uint64_t)header->import_count * sizeof(smof_import_t);
+    header->string_table_offset = (uint32_t)offset;
+    offset += header->string_table_size;
+    
+    for (i = 0; i < header->section_count; i++) {
+        ctx->sections[i].file_offset = 0;
+        if (ctx->section_data[i].data != NULL) {
+            mask = ((uint64_t)1 << (ctx->sections[i].alignment < SMOF_MAX_FILE_ALIGNMENT_SHIFT ?
+                                    ctx->sections[i].alignment :
+                                    SMOF_MAX_FILE_ALIGNMENT_SHIFT)) - 1;
+            offset = (offset + mask) & ~mask;
+            if (offset > UINT32_MAX) {
+                return offset;
+            }
+            ctx->sections[i].file_offset = (uint32_t)offset;
+            offset += ctx->section_data[i].size;
+        }
+    }
+    
+    return offset;
+}
+
+/* Append a buffer to the write sequence, leaving out empty ones */
+static void add_vector(struct iovec* vectors, int* count, void* buffer, size_t size) {
+    if (size > 0) {
+        vectors[*count].iov_base = buffer;
+        vectors[*count].iov_len = size;
+        (*count)++;
+    }
+}
+
+/* writev the whole sequence, IOV_MAX buffers at a time, resuming after short writes */
+static int write_vectors(int fd, struct iovec* vectors, int count) {
+    ssize_t written;
+    
+    while (count > 0) {
+        written = writev(fd, vectors, count < IOV_MAX ? count : IOV_MAX);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return ERROR_FILE_IO;
+        }
+        
+        while (count > 0 && (size_t)written >= vectors->iov_len) {
+            written -= (ssize_t)vectors->iov_len;
+            vectors++;
+            count--;
+        }
+        if (count > 0) {
+            vectors->iov_base = (uint8_t*)vectors->iov_base + written;
+            vectors->iov_len -= (size_t)written;
+        }
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+int smof_write_file(smof_context_t* ctx, const char* filename, bool verbose) {
+    smof_header_t* header;
+    struct iovec* vectors;
+    uint64_t file_size;
+    uint64_t position;
+    int count = 0;
+    int fd;
+    int result;
+    uint16_t i;
+    
+    if (ctx == NULL || filename == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    /* Even a file without names has the empty string */
+    if (!reserve_strings(ctx, 0)) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    header = &ctx->header;
+    file_size = layout_file(ctx);
+    if (file_size > UINT32_MAX) {
+        return ERROR_OUTPUT_TOO_LARGE;
+    }
+    if (!smof_validate_header(header)) {
+        return ERROR_CORRUPT_HEADER;
+    }
+    
+    /* Six tables, then padding and data for every section */
+    vectors = malloc((6 + 2 * (size_t)header->section_count) * sizeof(struct iovec));
+    if (vectors == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    add_vector(vectors, &count, header, sizeof(smof_header_t));
+    add_vector(vectors, &count, ctx->sections, header->section_count * sizeof(smof_section_t));
+    add_vector(vectors, &count, ctx->symbols, header->symbol_count * sizeof(smof_symbol_t));
+    add_vector(vectors, &count, ctx->relocations,
+               header->reloc_count * sizeof(smof_relocation_t));
+    add_vector(vectors, &count, ctx->imports, header->import_count * sizeof(smof_import_t));
+    add_vector(vectors, &count, ctx->string_table, header->string_table_size);
+    position = (uint64_t)header->string_table_offset + header->string_table_size;
+    for (i = 0; i < header->section_count; i++) {
+        if (ctx->section_data[i].data != NULL) {
+            add_vector(vectors, &count, smof_padding,
+                       (size_t)(ctx->sections[i].file_offset - position));
+            add_vector(vectors, &count, ctx->section_data[i].data, ctx->section_data[i].size);
+            position = (uint64_t)ctx->sections[i].file_offset + ctx->section_data[i].size;
+        }
+    }
+    
+    fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        free(vectors);
+        return ERROR_FILE_IO;
+    }
+    result = write_vectors(fd, vectors, count);
+    if (close(fd) != 0 && result == ERROR_SUCCESS) {
+        result = ERROR_FILE_IO;
+    }
+    free(vectors);
+    
+    if (result == ERROR_SUCCESS && verbose) {
+        printf("SMOF: wrote %s: %u sections, %u symbols, %u relocations, %lu bytes\n",
+               filename, (unsigned)header->section_count, (unsigned)header->symbol_count,
+               (unsigned)header->reloc_count, (unsigned long)file_size);
+    }
+    
+    return result;
+}
@@ -0,0 +1,228 @@
+/* src/common/thread_pool.c */
+#include "thread_pool.h"
+#include "error.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/**
+ * @file thread_pool.c
+ * @brief Thread pool implementation
+ * @details Persistent workers sleep on a condition variable between
+ * batches. A batch is a shared task index that workers advance under the
+ * pool mutex; the task itself runs unlocked.
+ */
+
+#define THREAD_POOL_NO_ERROR SIZE_MAX
+
+/* Thread pool structure */
+struct thread_pool {
+    pthread_mutex_t mutex;
+    pthread_cond_t work_cond;       /* Signalled when a batch starts */
+    pthread_cond_t done_cond;       /* Signalled when a batch drains */
+    pthread_t* workers;             /* thread_count - 1 workers */
+    size_t thread_count;            /* Including the submitting thread */
+    size_t started;                 /* Workers successfully started */
+    bool shutdown;
+    unsigned long generation;       /* Incremented per batch */
+    thread_pool_task_t task;
+    void* user_data;
+    size_t task_count;
+    size_t next_index;              /* Next unclaimed task */
+    size_t active;                  /* Tasks currently running */
+    size_t error_index;             /* Lowest failing index */
+    int error_code;
+};
+
+size_t thread_pool_get_cpu_count(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    
+    return count > 0 ? (size_t)count : 1;
+}
+
+/* Claim and run tasks until the batch is exhausted; called with mutex held */
+static void run_batch_locked(thread_pool_t* pool) {
+    size_t index;
+    int result;
+    
+    while (pool->next_index < pool->task_count &&
+           pool->error_index == THREAD_POOL_NO_ERROR) {
+        index = pool->next_index++;
+        pool->active++;
+        
+        pthread_mutex_unlock(&pool->mutex);
+        result = pool->task(pool->user_data, index);
+        pthread_mutex_lock(&pool->mutex);
+        
+        pool->active--;
+        if (result != ERROR_SUCCESS &&
+            (pool->error_index == THREAD_POOL_NO_ERROR || index < pool->error_index)) {
+            pool->error_index = index;
+            pool->error_code = result;
+        }
+    }
+    
+    if (pool->active == 0) {
+        pthread_cond_broadcast(&pool->done_cond);
+    }
+}
+
+static void* worker_main(void* arg) {
+    thread_pool_t* pool = arg;
+    unsigned long seen;
+    
+    pthread_mutex_lock(&pool->mutex);
+    seen = pool->generation;
+    
+    for (;;) {
+        while (!pool->shutdown && pool->generation == seen) {
+            pthread_cond_wait(&pool->work_cond, &pool->mutex);
+        }
+        
+        if (pool->shutdown) {
+            break;
+        }
+        
+        seen = pool->generation;
+        run_batch_locked(pool);
+    }
+    
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+thread_pool_t* thread_pool_create(size_t thread_count) {
+    thread_pool_t* pool;
+    size_t i;
+    
+    if (thread_count == 0) {
+        thread_count = thread_pool_get_cpu_count();
+    }
+    
+    if (thread_count > THREAD_POOL_MAX_THREADS) {
+        thread_count = THREAD_POOL_MAX_THREADS;
+    }
+    
+    pool = malloc(sizeof(thread_pool_t));
+    if (pool == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate thread pool");
+        return NULL;
+    }
+    
+    *pool = (thread_pool_t) {
+        .workers = NULL,
+        .thread_count = thread_count,
+        .started = 0,
+        .shutdown = false,
+        .generation = 0,
+        .task = NULL,
+        .user_data = NULL,
+        .task_count = 0,
+        .next_index = 0,
+        .active = 0,
+        .error_index = THREAD_POOL_NO_ERROR,
+        .error_code = ERROR_SUCCESS
+    };
+    
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->work_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+    
+    if (thread_count > 1) {
+        pool->workers = malloc((thread_count - 1) * sizeof(pthread_t));
+        if (pool->workers == NULL) {
+            ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate worker threads");
+            thread_pool_destroy(pool);
+            return NULL;
+        }
+        
+        for (i = 0; i < thread_count - 1; i++) {
+            if (pthread_create(&pool->workers[i], NULL, worker_main, pool) != 0) {
+                break;
+            }
+            pool->started++;
+        }
+        
+        /* Run with however many workers the system gave us */
+        pool->thread_count = pool->started + 1;
+    }
+    
+    return pool;
+}
+
+void thread_pool_destroy(thread_pool_t* pool) {
+    size_t i;
+    
+    if (pool == NULL) {
+        return;
+    }
+    
+    pthread_mutex_lock(&pool->mutex);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->mutex);
+    
+    for (i = 0; i < pool->started; i++) {
+        pthread_join(pool->workers[i], NULL);
+    }
+    
+    pthread_cond_destroy(&pool->done_cond);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool->workers);
+    free(pool);
+}
+
+int thread_pool_run(thread_pool_t* pool, size_t task_count,
+                    thread_pool_task_t task, void* user_data) {
+    size_t i;
+    int result;
+    
+    if (task == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    /* Serial fallback: no pool or nothing to share */
+    if (pool == NULL || pool->thread_count <= 1 || task_count <= 1) {
+        for (i = 0; i < task_count; i++) {
+            result = task(user_data, i);
+            if (result != ERROR_SUCCESS) {
+                return result;
+            }
+        }
+        return ERROR_SUCCESS;
+    }
+    
+    pthread_mutex_lock(&pool->mutex);
+    
+    pool->task = task;
+    pool->user_data = user_data;
+    pool->task_count = task_count;
+    pool->next_index = 0;
+    pool->active = 0;
+    pool->error_index = THREAD_POOL_NO_ERROR;
+    pool->error_code = ERROR_SUCCESS;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_cond);
+    
+    /* The submitting thread works too */
+    run_batch_locked(pool);
+    
+    while (pool->active > 0) {
+        pthread_cond_wait(&pool->done_cond, &pool->mutex);
+    }
+    
+    result = pool->error_code;
+    pool->task = NULL;
+    pool->user_data = NULL;
+    pool->task_count = 0;
+    
+    pthread_mutex_unlock(&pool->mutex);
+    
+    return result;
+}
+
+size_t thread_pool_get_thread_count(const thread_pool_t* pool) {
+    return pool != NULL ? pool->thread_count : 1;
+}
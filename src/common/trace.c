@@ -0,0 +1,288 @@
+/* src/common/trace.c */
+#include "trace.h"
+#include "error.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+/**
+ * @file trace.c
+ * @brief Span recording and Chrome trace output
+ * @details Each session creates a fresh thread-specific key, so a thread
+ * finds its ring with one pthread_getspecific and rings of an ended
+ * session are never seen again. The registry mutex is taken once per
+ * thread per session; recording a span only writes the caller's ring.
+ */
+
+#ifdef ENABLE_TRACE
+
+/* One finished span */
+typedef struct trace_event {
+    const char* name;
+    uint64_t start;                 /* Nanoseconds since trace_start */
+    uint64_t duration;              /* Nanoseconds */
+    char detail[TRACE_DETAIL_MAX];
+} trace_event_t;
+
+/* Per-thread ring; written only by its thread while the session runs */
+typedef struct trace_ring {
+    struct trace_ring* next;        /* Registry list */
+    uint32_t thread_id;             /* Order of registration, from 1 */
+    uint64_t written;               /* Spans recorded, including overwritten ones */
+    trace_event_t events[TRACE_RING_EVENTS];
+} trace_ring_t;
+
+/* Guards trace_state.rings and trace_state.thread_count */
+static pthread_mutex_t trace_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Session state; fields other than the ring list change only in start/stop */
+static struct {
+    pthread_key_t key;
+    bool active;
+    struct timespec origin;
+    FILE* file;                     /* Opened by trace_start */
+    const char* process_name;
+    trace_ring_t* rings;
+    uint32_t thread_count;
+} trace_state;
+
+static uint64_t trace_now(void) {
+    struct timespec now;
+    
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)(now.tv_sec - trace_state.origin.tv_sec) * 1000000000ULL +
+           (uint64_t)now.tv_nsec - (uint64_t)trace_state.origin.tv_nsec;
+}
+
+/* The calling thread's ring, registered on first use; NULL on failure */
+static trace_ring_t* thread_ring(void) {
+    trace_ring_t* ring = pthread_getspecific(trace_state.key);
+    
+    if (ring != NULL) {
+        return ring;
+    }
+    
+    ring = malloc(sizeof(trace_ring_t));
+    if (ring == NULL) {
+        return NULL;
+    }
+    ring->written = 0;
+    
+    pthread_mutex_lock(&trace_mutex);
+    ring->thread_id = ++trace_state.thread_count;
+    ring->next = trace_state.rings;
+    trace_state.rings = ring;
+    pthread_mutex_unlock(&trace_mutex);
+    
+    if (pthread_setspecific(trace_state.key, ring) != 0) {
+        /* Stays on the registry list and is freed by trace_stop */
+        return NULL;
+    }
+    return ring;
+}
+
+static void free_rings(void) {
+    trace_ring_t* ring;
+    
+    while (trace_state.rings != NULL) {
+        ring = trace_state.rings;
+        trace_state.rings = ring->next;
+        free(ring);
+    }
+    trace_state.thread_count = 0;
+}
+
+static void write_escaped(FILE* file, const char* text) {
+    const unsigned char* c;
+    
+    for (c = (const unsigned char*)text; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(file, "\\%c", *c);
+        } else if (*c < 0x20) {
+            fprintf(file, "\\u%04x", (unsigned)*c);
+        } else {
+            fputc(*c, file);
+        }
+    }
+}
+
+/* Nanoseconds as the microseconds Chrome traces use */
+static void write_microseconds(FILE* file, uint64_t ns) {
+    fprintf(file, "%llu.%03u", (unsigned long long)(ns / 1000), (unsigned)(ns % 1000));
+}
+
+static void write_ring(FILE* file, const trace_ring_t* ring, uint64_t* dropped) {
+    const trace_event_t* event;
+    uint64_t first = 0;
+    uint64_t i;
+    
+    if (ring->written > TRACE_RING_EVENTS) {
+        first = ring->written - TRACE_RING_EVENTS;
+        *dropped += first;
+    }
+    
+    fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+            "\"args\":{\"name\":\"thread %u\"}}",
+            ring->thread_id, ring->thread_id);
+    
+    for (i = first; i < ring->written; i++) {
+        event = &ring->events[i % TRACE_RING_EVENTS];
+        fprintf(file, ",\n{\"name\":\"");
+        write_escaped(file, event->name);
+        fprintf(file, "\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":",
+                trace_state.process_name, ring->thread_id);
+        write_microseconds(file, event->start);
+        fprintf(file, ",\"dur\":");
+        write_microseconds(file, event->duration);
+        if (event->detail[0] != '\0') {
+            fprintf(file, ",\"args\":{\"detail\":\"");
+            write_escaped(file, event->detail);
+            fprintf(file, "\"}");
+        }
+        fprintf(file, "}");
+    }
+}
+
+static int write_trace(FILE* file) {
+    const trace_ring_t* ring;
+    uint64_t dropped = 0;
+    
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+            "\"args\":{\"name\":\"%s\"}}", trace_state.process_name);
+    for (ring = trace_state.rings; ring != NULL; ring = ring->next) {
+        write_ring(file, ring, &dropped);
+    }
+    fprintf(file, "\n],\"otherData\":{\"dropped_spans\":%llu}}\n", (unsigned long long)dropped);
+    
+    if (ferror(file) != 0) {
+        fclose(file);
+        ERROR_REPORT_ERROR(ERROR_FILE_IO, "Failed to write trace file");
+        return ERROR_FILE_IO;
+    }
+    return fclose(file) == 0 ? ERROR_SUCCESS : ERROR_FILE_IO;
+}
+
+int trace_start(const char* filename, const char* process_name) {
+    if (filename == NULL || trace_state.active) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    /* Opened now so that a bad path fails before any work is done */
+    trace_state.file = fopen(filename, "w");
+    if (trace_state.file == NULL) {
+        ERROR_REPORT_ERROR(ERROR_FILE_IO, "Failed to open trace file");
+        return ERROR_FILE_IO;
+    }
+    
+    if (pthread_key_create(&trace_state.key, NULL) != 0) {
+        fclose(trace_state.file);
+        trace_state.file = NULL;
+        return ERROR_SYSTEM_LIMIT;
+    }
+    
+    trace_state.process_name = process_name != NULL ? process_name : "trace";
+    clock_gettime(CLOCK_MONOTONIC, &trace_state.origin);
+    trace_state.active = true;
+    
+    return ERROR_SUCCESS;
+}
+
+int trace_stop(void) {
+    int result;
+    
+    if (!trace_state.active) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    trace_state.active = false;
+    
+    result = write_trace(trace_state.file);
+    trace_state.file = NULL;
+    
+    free_rings();
+    pthread_key_delete(trace_state.key);
+    
+    return result;
+}
+
+bool trace_is_available(void) {
+    return true;
+}
+
+bool trace_is_active(void) {
+    return trace_state.active;
+}
+
+void trace_span_begin(trace_span_t* span, const char* name) {
+    span->name = name;
+    span->recording = trace_state.active;
+    span->start = span->recording ? trace_now() : 0;
+}
+
+void trace_span_end(trace_span_t* span, const char* detail) {
+    trace_event_t* event;
+    trace_ring_t* ring;
+    size_t length = 0;
+    uint64_t end;
+    
+    if (!span->recording || !trace_state.active) {
+        return;
+    }
+    
+    end = trace_now();
+    ring = thread_ring();
+    if (ring == NULL) {
+        return;
+    }
+    
+    event = &ring->events[ring->written % TRACE_RING_EVENTS];
+    event->name = span->name;
+    event->start = span->start;
+    event->duration = end - span->start;
+    if (detail != NULL) {
+        length = strlen(detail);
+        if (length >= TRACE_DETAIL_MAX) {
+            detail += length - (TRACE_DETAIL_MAX - 1);
+            length = TRACE_DETAIL_MAX - 1;
+        }
+        memcpy(event->detail, detail, length);
+    }
+    event->detail[length] = '\0';
+    ring->written++;
+}
+
+#else /* !ENABLE_TRACE */
+
+int trace_start(const char* filename, const char* process_name) {
+    (void)filename;
+    (void)process_name;
+    ERROR_REPORT_ERROR(ERROR_INVALID_ARGUMENT, "Tracing is not built in");
+    return ERROR_INVALID_ARGUMENT;
+}
+
+int trace_stop(void) {
+    return ERROR_INVALID_ARGUMENT;
+}
+
+bool trace_is_available(void) {
+    return false;
+}
+
+bool trace_is_active(void) {
+    return false;
+}
+
+void trace_span_begin(trace_span_t* span, const char* name) {
+    span->name = name;
+    span->start = 0;
+    span->recording = false;
+}
+
+void trace_span_end(trace_span_t* span, const char* detail) {
+    (void)span;
+    (void)detail;
+}
+
+#endif /* ENABLE_TRACE */
@@ -1,13 +1,21 @@
 /* src/star/archive.c */
 #include "archive.h"
 #include "star.h"
+#include "index.h"
+#include "compress.h"
+#include "archive_io.h"
 #include "../common/include/error.h"
+#include "../common/include/crc32.h"
+#include "../common/include/thread_pool.h"
+#include "../common/include/trace.h"
 #include <stdlib.h>
 #include <string.h>
-#include <errno.h>
+#include <pthread.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <time.h>
 #include <stdio.h>
+#include <unistd.h>
 
 /**
  * @file archive.c
@@ -15,42 +23,16 @@
  * @details Core archive I/O operations for STAR format
  */
 
-/* Calculate CRC32 checksum */
-static uint32_t crc32_table[256];
-static bool crc32_initialized = false;
+/* Initial string table allocation and string hash size */
+#define ARCHIVE_STRING_TABLE_INITIAL 1024
+#define ARCHIVE_STRING_SLOTS_INITIAL 256
 
-static void init_crc32_table(void) {
-    uint32_t c;
-    int n, k;
-    
-    if (crc32_initialized) return;
-    
-    for (n = 0; n < 256; n++) {
-        c = (uint32_t)n;
-        for (k = 0; k < 8; k++) {
-            if (c & 1) {
-                c = 0xedb88320L ^ (c >> 1);
-            } else {
-                c = c >> 1;
-            }
-        }
-        crc32_table[n] = c;
-    }
-    crc32_initialized = true;
-}
+/* Size of the synthetic object file auto mode times decoding on */
+#define ARCHIVE_AUTO_CORPUS_SIZE 65536
 
+/* CRC32 checksum, shared with STLD */
 uint32_t archive_calculate_checksum(const void* data, size_t size) {
-    const uint8_t* buf = (const uint8_t*)data;
-    uint32_t crc = 0xffffffffL;
-    size_t i;
-    
-    init_crc32_table();
-    
-    for (i = 0; i < size; i++) {
-        crc = crc32_table[(crc ^ buf[i]) & 0xff] ^ (crc >> 8);
-    }
-    
-    return crc ^ 0xffffffffL;
+    return crc32_calculate(data, size);
 }
 
 bool archive_validate_header(const star_header_t* header) {
@@ -84,6 +66,11 @@ bool archive_validate_header(const star_header_t* header) {
         return false;
     }
     
+    if (header->dictionary_size > STAR_MAX_DICTIONARY_SIZE ||
+        (header->dictionary_size > 0 && header->dictionary_offset < sizeof(star_header_t))) {
+        return false;
+    }
+    
     return true;
 }
 
@@ -142,6 +129,38 @@ archive_file_t* archive_open(const char* filename, const char* mode) {
     return archive;
 }
 
+/*
+ * The stored form of every member written so far, by checksum and size,
+ * for deduplication. Workers preparing members look it up while the
+ * writer adds to it, so it has its own lock.
+ */
+typedef struct archive_dedup {
+    pthread_mutex_t mutex;
+    star_member_header_t* slots;        /* Open-addressed, data_offset 0 = empty slot */
+    size_t slot_count;                  /* Power of two, 0 until a member is added */
+    size_t count;
+} archive_dedup_t;
+
+static archive_dedup_t* dedup_create(void) {
+    archive_dedup_t* dedup = calloc(1, sizeof(archive_dedup_t));
+    
+    if (dedup != NULL) {
+        pthread_mutex_init(&dedup->mutex, NULL);
+    }
+    
+    return dedup;
+}
+
+static void dedup_destroy(archive_dedup_t* dedup) {
+    if (dedup == NULL) {
+        return;
+    }
+    
+    pthread_mutex_destroy(&dedup->mutex);
+    free(dedup->slots);
+    free(dedup);
+}
+
 void archive_close(archive_file_t* archive) {
     if (archive == NULL) {
         return;
@@ -153,14 +172,27 @@ void archive_close(archive_file_t* archive) {
     
     if (archive->members != NULL) {
         for (uint32_t i = 0; i < archive->header.member_count; i++) {
-            free(archive->members[i].name);
+            if (archive->map == NULL) {
+                free(archive->members[i].name);
+            }
             free(archive->members[i].data);
         }
         free(archive->members);
     }
     
-    free(archive->string_table);
+    /* A mapped archive's names and string table live in the mapping */
+    if (archive->map != NULL) {
+        munmap(archive->map, archive->map_size);
+    } else {
+        free(archive->string_table);
+    }
+    free(archive->string_slots);
+    free(archive->member_slots);
+    free(archive->free_extents);
     free(archive->symbols);
+    free(archive->dictionary);
+    dedup_destroy(archive->dedup);
+    archive_io_destroy(archive->io);
     free(archive);
 }
 
@@ -171,6 +203,26 @@ bool archive_is_valid(const archive_file_t* archive) {
            archive_validate_header(&archive->header);
 }
 
+/* Member flags describing how the data is stored */
+#define ARCHIVE_STORAGE_FLAGS (STAR_MEMBER_FLAG_COMPRESSED | STAR_MEMBER_FLAG_BLOCKED | \
+                               STAR_MEMBER_FLAG_DICTIONARY)
+
+/* Log2 of a valid block size, 0 (whole members) otherwise */
+static uint8_t block_shift_for(size_t block_size) {
+    uint8_t shift = 0;
+    
+    if (block_size < STAR_MIN_BLOCK_SIZE || block_size > STAR_MAX_BLOCK_SIZE ||
+        (block_size & (block_size - 1)) != 0) {
+        return 0;
+    }
+    
+    while (((size_t)1 << shift) < block_size) {
+        shift++;
+    }
+    
+    return shift;
+}
+
 archive_file_t* archive_create(const char* filename, const star_options_t* options) {
     archive_file_t* archive;
     
@@ -193,6 +245,17 @@ archive_file_t* archive_create(const char* filename, const star_options_t* optio
     if (options != NULL) {
         if (options->compression != STAR_COMPRESS_NONE) {
             archive->header.flags |= STAR_FLAG_COMPRESSED;
+            archive->compression = options->compression;
+            archive->compression_level = options->compression == STAR_COMPRESS_AUTO ? -1 :
+                                         compression_normalize_level(options->compression,
+                                                                     options->compression_level);
+            archive->decode_goal = (uint8_t)options->decode_speed_goal;
+            archive->block_shift = block_shift_for(options->block_size);
+            if (options->compression == STAR_COMPRESS_AUTO ||
+                compression_supports_dictionary(options->compression)) {
+                archive->dictionary_capacity = options->dictionary_size < STAR_MAX_DICTIONARY_SIZE ?
+                                               options->dictionary_size : STAR_MAX_DICTIONARY_SIZE;
+            }
         }
         if (options->create_index) {
             archive->header.flags |= STAR_FLAG_INDEXED;
@@ -200,6 +263,13 @@ archive_file_t* archive_create(const char* filename, const star_options_t* optio
         if (options->sort_members) {
             archive->header.flags |= STAR_FLAG_SORTED;
         }
+        if (options->deduplicate) {
+            archive->dedup = dedup_create();
+            if (archive->dedup == NULL) {
+                archive_close(archive);
+                return NULL;
+            }
+        }
     }
     
     /* Set endianness flag */
@@ -210,52 +280,179 @@ archive_file_t* archive_create(const char* filename, const star_options_t* optio
     #endif
     
     /* Allocate initial string table */
-    archive->string_table = malloc(1024);
+    archive->string_table = malloc(ARCHIVE_STRING_TABLE_INITIAL);
     if (archive->string_table == NULL) {
         archive_close(archive);
         return NULL;
     }
     archive->string_table[0] = '\0'; /* Empty string at offset 0 */
+    archive->string_capacity = ARCHIVE_STRING_TABLE_INITIAL;
     archive->header.string_table_size = 1;
     
     return archive;
 }
 
+/* Slot holding the offset of str, or the empty slot where it belongs */
+static size_t find_string_slot(const archive_file_t* archive, const char* str, uint32_t hash) {
+    size_t mask = archive->string_slot_count - 1;
+    size_t slot = hash & mask;
+    
+    while (archive->string_slots[slot] != 0 &&
+           strcmp(&archive->string_table[archive->string_slots[slot]], str) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    
+    return slot;
+}
+
+/* Insert offset into a hash known to have room, unless an equal string is there */
+static void index_string(archive_file_t* archive, uint32_t offset) {
+    const char* str = &archive->string_table[offset];
+    size_t slot = find_string_slot(archive, str, symbol_index_hash_name(str));
+    
+    if (archive->string_slots[slot] == 0) {
+        archive->string_slots[slot] = offset;
+        archive->string_count++;
+    }
+}
+
+/* Rebuild the hash with room for count strings at half load */
+static int index_strings(archive_file_t* archive, size_t count) {
+    uint32_t* old_slots = archive->string_slots;
+    size_t old_count = archive->string_slot_count;
+    size_t slot_count = ARCHIVE_STRING_SLOTS_INITIAL;
+    const char* end;
+    uint32_t offset;
+    uint32_t next;
+    size_t i;
+    
+    while (slot_count < count * 2) {
+        slot_count *= 2;
+    }
+    
+    archive->string_slots = calloc(slot_count, sizeof(uint32_t));
+    if (archive->string_slots == NULL) {
+        archive->string_slots = old_slots;
+        return ERROR_OUT_OF_MEMORY;
+    }
+    archive->string_slot_count = slot_count;
+    archive->string_count = 0;
+    
+    if (old_slots != NULL) {
+        for (i = 0; i < old_count; i++) {
+            if (old_slots[i] != 0) {
+                index_string(archive, old_slots[i]);
+            }
+        }
+        free(old_slots);
+        return ERROR_SUCCESS;
+    }
+    
+    /* First use of a table read from disk: index its terminated strings */
+    for (offset = 1; offset < archive->header.string_table_size; offset = next) {
+        end = memchr(&archive->string_table[offset], '\0',
+                     archive->header.string_table_size - offset);
+        if (end == NULL) {
+            return ERROR_SUCCESS;
+        }
+        next = (uint32_t)(end - archive->string_table) + 1;
+        index_string(archive, offset);
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+/* Strings in a table read from disk; they have not been hashed yet */
+static size_t count_strings(const archive_file_t* archive) {
+    size_t count = 0;
+    uint32_t i;
+    
+    for (i = 1; i < archive->header.string_table_size; i++) {
+        count += archive->string_table[i] == '\0';
+    }
+    
+    return count;
+}
+
+/* Make room for size more bytes, doubling the allocation */
+static int reserve_strings(archive_file_t* archive, size_t size) {
+    size_t capacity = archive->string_capacity > 0 ? archive->string_capacity :
+                      ARCHIVE_STRING_TABLE_INITIAL;
+    size_t needed;
+    char* table;
+    
+    /* An archive without a table yet starts with the empty string */
+    if (archive->string_table == NULL) {
+        archive->header.string_table_size = 1;
+        archive->string_capacity = 0;
+    }
+    
+    needed = archive->header.string_table_size + size;
+    if (needed > UINT32_MAX) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    if (needed <= archive->string_capacity) {
+        return ERROR_SUCCESS;
+    }
+    
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    
+    table = realloc(archive->string_table, capacity);
+    if (table == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    table[0] = '\0';
+    archive->string_table = table;
+    archive->string_capacity = capacity;
+    
+    return ERROR_SUCCESS;
+}
+
 int archive_add_string(archive_file_t* archive, const char* str, uint32_t* offset) {
+    uint32_t hash;
     size_t len;
-    size_t new_size;
-    char* new_table;
+    size_t slot;
+    int result = ERROR_SUCCESS;
     
-    if (archive == NULL || str == NULL || offset == NULL) {
+    if (archive == NULL || str == NULL || offset == NULL || archive->map != NULL) {
         return ERROR_INVALID_ARGUMENT;
     }
     
-    /* Check if string already exists */
-    for (uint32_t i = 0; i < archive->header.string_table_size; i++) {
-        if (strcmp(&archive->string_table[i], str) == 0) {
-            *offset = i;
-            return ERROR_SUCCESS;
-        }
-        /* Skip to next string */
-        while (i < archive->header.string_table_size && archive->string_table[i] != '\0') {
-            i++;
-        }
+    if (str[0] == '\0') {
+        *offset = 0;
+        return ERROR_SUCCESS;
     }
     
-    /* Add new string */
     len = strlen(str) + 1;
-    new_size = archive->header.string_table_size + len;
+    result = reserve_strings(archive, len);
     
-    new_table = realloc(archive->string_table, new_size);
-    if (new_table == NULL) {
-        return ERROR_OUT_OF_MEMORY;
+    /* Keep the hash at most half full */
+    if (result == ERROR_SUCCESS && archive->string_slots == NULL) {
+        result = index_strings(archive, count_strings(archive) + 1);
+    }
+    if (result == ERROR_SUCCESS && (archive->string_count + 1) * 2 > archive->string_slot_count) {
+        result = index_strings(archive, archive->string_slot_count);
+    }
+    if (result != ERROR_SUCCESS) {
+        return result;
     }
     
-    archive->string_table = new_table;
-    *offset = archive->header.string_table_size;
+    hash = symbol_index_hash_name(str);
+    slot = find_string_slot(archive, str, hash);
+    if (archive->string_slots[slot] != 0) {
+        *offset = archive->string_slots[slot];
+        return ERROR_SUCCESS;
+    }
     
-    strcpy(&archive->string_table[*offset], str);
-    archive->header.string_table_size = (uint32_t)new_size;
+    /* Add new string */
+    *offset = archive->header.string_table_size;
+    memcpy(&archive->string_table[*offset], str, len);
+    archive->header.string_table_size += (uint32_t)len;
+    archive->string_slots[slot] = *offset;
+    archive->string_count++;
     
     return ERROR_SUCCESS;
 }
@@ -289,6 +486,11 @@ int archive_add_member_from_file(archive_file_t* archive,
         return ERROR_PERMISSION_DENIED;
     }
     
+    /* Streamed archives have their member table fixed already */
+    if (archive->is_streaming) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
     /* Get file info */
     if (stat(file_path, &st) != 0) {
         return ERROR_FILE_IO;
@@ -357,192 +559,2629 @@ int archive_add_member_from_file(archive_file_t* archive,
     return ERROR_SUCCESS;
 }
 
-int archive_write_header(archive_file_t* archive) {
-    if (archive == NULL || !archive->is_writable) {
+int archive_reserve_members(archive_file_t* archive, const char* const* names, size_t count) {
+    archive_member_t* member;
+    uint32_t name_offset;
+    uint64_t start;
+    size_t i;
+    int result = ERROR_SUCCESS;
+    
+    if (archive == NULL || names == NULL || count == 0) {
         return ERROR_INVALID_ARGUMENT;
     }
     
-    /* Calculate offsets */
-    archive->header.member_table_offset = sizeof(star_header_t);
-    archive->header.string_table_offset = archive->header.member_table_offset + 
-                                         (uint32_t)(archive->header.member_count * sizeof(star_member_header_t));
+    if (!archive->is_writable || archive->members != NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
     
-    /* Calculate checksum (excluding checksum field) */
-    archive->header.checksum = archive_calculate_checksum(&archive->header, 
-                                                         sizeof(star_header_t) - sizeof(uint32_t));
+    if (count > STAR_MAX_MEMBERS) {
+        return ERROR_SYSTEM_LIMIT;
+    }
     
-    /* Write header */
-    if (fseek(archive->file, 0, SEEK_SET) != 0) {
-        return ERROR_FILE_IO;
+    archive->members = calloc(count, sizeof(archive_member_t));
+    if (archive->members == NULL) {
+        return ERROR_OUT_OF_MEMORY;
     }
+    archive->header.member_count = (uint32_t)count;
     
-    if (fwrite(&archive->header, sizeof(star_header_t), 1, archive->file) != 1) {
+    for (i = 0; i < count && result == ERROR_SUCCESS; i++) {
+        member = &archive->members[i];
+        result = archive_add_string(archive, names[i], &name_offset);
+        if (result == ERROR_SUCCESS) {
+            member->header.name_offset = name_offset;
+            member->index = (uint32_t)i;
+            member->name = malloc(strlen(names[i]) + 1);
+            if (member->name == NULL) {
+                result = ERROR_OUT_OF_MEMORY;
+            } else {
+                strcpy(member->name, names[i]);
+            }
+        }
+    }
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    /* Header, member table and string table come before the data */
+    start = sizeof(star_header_t) + count * sizeof(star_member_header_t) +
+            archive->header.string_table_size;
+    if (start > UINT32_MAX) {
+        return ERROR_OUTPUT_TOO_LARGE;
+    }
+    
+    if (fseek(archive->file, (long)start, SEEK_SET) != 0) {
         return ERROR_FILE_IO;
     }
     
+    archive->is_streaming = true;
+    archive->stream_start = (uint32_t)start;
+    archive->stream_offset = (uint32_t)start;
+    
     return ERROR_SUCCESS;
 }
 
-int archive_finalize(archive_file_t* archive) {
-    uint32_t data_offset;
-    uint32_t i;
-    
-    if (archive == NULL || !archive->is_writable) {
-        return ERROR_INVALID_ARGUMENT;
+/* Archive error for a compression engine result */
+static int compression_error(int result, int failure) {
+    if (result == COMPRESS_SUCCESS) {
+        return ERROR_SUCCESS;
     }
     
-    /* Calculate offsets first */
-    archive->header.member_table_offset = sizeof(star_header_t);
-    archive->header.string_table_offset = archive->header.member_table_offset + 
-                                         (uint32_t)(archive->header.member_count * sizeof(star_member_header_t));
+    return result == COMPRESS_ERROR_MEMORY ? ERROR_OUT_OF_MEMORY : failure;
+}
+
+/* Uncompressed length of a block of a member split into 1 << shift byte blocks */
+static uint32_t block_length(uint32_t size, uint8_t shift, uint32_t block) {
+    uint32_t start = block << shift;
+    uint32_t length = (uint32_t)1 << shift;
     
-    /* Calculate data offset */
-    data_offset = archive->header.string_table_offset + archive->header.string_table_size;
+    return size - start < length ? size - start : length;
+}
 
-    /* Write member headers */
-    if (fseek(archive->file, (long)archive->header.member_table_offset, SEEK_SET) != 0) {
-        return ERROR_FILE_IO;
+static uint32_t block_count(uint32_t size, uint8_t shift) {
+    return (uint32_t)(((uint64_t)size + ((uint32_t)1 << shift) - 1) >> shift);
+}
+
+/* The dictionary new members are compressed against, NULL if none or unusable */
+static const uint8_t* member_dictionary(const archive_file_t* archive,
+                                        star_compression_t algorithm, size_t* size) {
+    if (archive->dictionary == NULL || !compression_supports_dictionary(algorithm)) {
+        *size = 0;
+        return NULL;
     }
+    
+    *size = archive->header.dictionary_size;
+    return archive->dictionary;
+}
 
-    for (i = 0; i < archive->header.member_count; i++) {
-        archive->members[i].header.data_offset = data_offset;
-        data_offset += archive->members[i].header.size;
+/*
+ * Compress data into independent blocks behind a block table. Blocks
+ * that would not shrink are stored as they are; *stored_size is then
+ * at most the table plus size.
+ */
+static int compress_blocks(const archive_file_t* archive, star_compression_t algorithm, int level,
+                           const uint8_t* data, uint32_t size, uint8_t** stored,
+                           size_t* stored_size) {
+    const compression_algorithm_t* algo = compression_get_algorithm(algorithm);
+    compression_context_t* ctx;
+    star_block_entry_t* table;
+    const uint8_t* dictionary;
+    size_t dictionary_size;
+    uint32_t count = block_count(size, archive->block_shift);
+    size_t table_size = ((size_t)count + 1) * sizeof(star_block_entry_t);
+    size_t used = table_size;
+    size_t length;
+    size_t packed;
+    uint32_t i;
+    int result = COMPRESS_SUCCESS;
+    
+    table = calloc((size_t)count + 1, sizeof(star_block_entry_t));
+    *stored = compression_allocate_buffer(table_size + size);
+    ctx = compression_acquire_context(algorithm, level);
+    if (table == NULL || *stored == NULL || ctx == NULL) {
+        result = COMPRESS_ERROR_MEMORY;
+    } else {
+        dictionary = member_dictionary(archive, algorithm, &dictionary_size);
+        result = compression_set_dictionary(algorithm, ctx, dictionary, dictionary_size);
+    }
+    
+    for (i = 0; result == COMPRESS_SUCCESS && i < count; i++) {
+        const uint8_t* block = data + ((size_t)i << archive->block_shift);
         
-        if (fwrite(&archive->members[i].header, sizeof(star_member_header_t), 1, archive->file) != 1) {
-            return ERROR_FILE_IO;
+        length = block_length(size, archive->block_shift, i);
+        table[i].offset = (uint32_t)used;
+        table[i].checksum = crc32_calculate(block, length);
+        
+        /* One byte short of the input, so only a block that shrinks fits */
+        result = algo->compress(ctx, block, length, *stored + used, length - 1, &packed);
+        if (result == COMPRESS_ERROR_OVERFLOW) {
+            memcpy(*stored + used, block, length);
+            packed = length;
+            result = COMPRESS_SUCCESS;
         }
+        used += packed;
     }
-    fflush(archive->file);    /* Write string table */
-    if (fseek(archive->file, (long)archive->header.string_table_offset, SEEK_SET) != 0) {
-        return ERROR_FILE_IO;
+    
+    if (result == COMPRESS_SUCCESS) {
+        table[count].offset = (uint32_t)used;
+        memcpy(*stored, table, table_size);
+        *stored_size = used;
+    } else {
+        compression_free_buffer(*stored);
+        *stored = NULL;
     }
+    
+    compression_release_context(algorithm, ctx);
+    free(table);
+    
+    return compression_error(result, ERROR_COMPRESSION_FAILED);
+}
 
-    if (fwrite(archive->string_table, archive->header.string_table_size, 1, archive->file) != 1) {
-        return ERROR_FILE_IO;
+/*
+ * Relative decoding cost of each algorithm, 1 for the slowest; until
+ * calibrate_decode_costs times them, typical figures for object code
+ */
+static double decode_costs[STAR_COMPRESS_LZMA + 1] = {0.0, 0.05, 0.25, 1.0};
+static pthread_once_t decode_costs_once = PTHREAD_ONCE_INIT;
+
+/*
+ * A synthetic object file: instructions from a small opcode set with
+ * mostly small operands, then a string table of symbol names and the
+ * zero padding sections are aligned with
+ */
+static void object_like_corpus(uint8_t* data, size_t size) {
+    static const uint8_t opcodes[] = {0x48, 0x89, 0x8b, 0xe8, 0xc3, 0x0f, 0x83, 0x74};
+    static const char* const words[] = {"init", "read", "write", "buffer", "symbol", "section",
+                                        "table", "entry"};
+    uint32_t seed = 0x2545f491U;
+    size_t code_end = size / 2;
+    size_t text_end = size - size / 8;
+    size_t i = 0;
+    int length;
+    
+    while (i < code_end) {
+        seed = seed * 1103515245U + 12345U;
+        data[i++] = opcodes[(seed >> 16) & 7];
+        for (length = (int)((seed >> 20) & 3); length > 0 && i < code_end; length--) {
+            data[i++] = (uint8_t)((seed >> 24) & 0x0f);
+        }
+    }
+    
+    while (i < text_end) {
+        seed = seed * 1103515245U + 12345U;
+        length = snprintf((char*)data + i, text_end - i, "%s_%s%u", words[(seed >> 16) & 7],
+                          words[(seed >> 19) & 7], (unsigned)((seed >> 22) & 0xff));
+        i += length > 0 && (size_t)length < text_end - i ? (size_t)length + 1 : text_end - i;
     }
-    fflush(archive->file);
+    
+    memset(data + text_end, 0, size - text_end);
+}
 
-    /* Write member data */
-    for (i = 0; i < archive->header.member_count; i++) {
-        if (archive->members[i].data_loaded) {
-            if (fwrite(archive->members[i].data, archive->members[i].header.size, 1, archive->file) != 1) {
-                return ERROR_FILE_IO;
+/* Time each available algorithm's decoding on object-like data, once */
+static void calibrate_decode_costs(void) {
+    compression_benchmark_t benchmark;
+    double speeds[STAR_COMPRESS_LZMA + 1] = {0.0};
+    double slowest = 0.0;
+    uint8_t* corpus;
+    int algorithm;
+    
+    corpus = malloc(ARCHIVE_AUTO_CORPUS_SIZE);
+    if (corpus == NULL) {
+        return;
+    }
+    object_like_corpus(corpus, ARCHIVE_AUTO_CORPUS_SIZE);
+    
+    for (algorithm = STAR_COMPRESS_LZ4; algorithm <= STAR_COMPRESS_LZMA; algorithm++) {
+        if (compression_is_available((star_compression_t)algorithm) &&
+            compression_benchmark_algorithm((star_compression_t)algorithm, -1, corpus,
+                                            ARCHIVE_AUTO_CORPUS_SIZE, &benchmark) ==
+                COMPRESS_SUCCESS &&
+            benchmark.decompression_speed > 0.0) {
+            speeds[algorithm] = benchmark.decompression_speed;
+            if (slowest == 0.0 || speeds[algorithm] < slowest) {
+                slowest = speeds[algorithm];
             }
         }
     }
-    fflush(archive->file);    /* Write header last */
-    return archive_write_header(archive);
+    
+    /* Costs are time per byte relative to the slowest algorithm timed */
+    for (algorithm = STAR_COMPRESS_LZ4; algorithm <= STAR_COMPRESS_LZMA; algorithm++) {
+        if (speeds[algorithm] > 0.0) {
+            decode_costs[algorithm] = slowest / speeds[algorithm];
+        }
+    }
+    free(corpus);
 }
 
-archive_member_t* archive_find_member(const archive_file_t* archive, const char* name) {
-    uint32_t i;
+/* A member's storage as auto mode chose it */
+typedef struct member_choice {
+    star_compression_t algorithm;
+    int level;
+    uint8_t* stored;                    /* The member compressed, if the sample was all of it */
+    size_t stored_size;
+} member_choice_t;
+
+/*
+ * Pick the algorithm for one member in auto mode by compressing a sample
+ * with each: the cost of a choice is its ratio weighted by 1 - goal plus
+ * its decoding cost weighted by the goal, storing the member as it is
+ * costing 1 - goal. Candidates whose decoding alone costs more than the
+ * best so far, or that the estimate says cannot shrink the member, are
+ * not tried.
+ */
+static int choose_compression(const archive_file_t* archive, const uint8_t* data, uint32_t size,
+                              member_choice_t* choice) {
+    static const star_compression_t candidates[] = {STAR_COMPRESS_LZ4, STAR_COMPRESS_ZLIB,
+                                                    STAR_COMPRESS_LZMA};
+    uint8_t chunks[ARCHIVE_AUTO_SAMPLE_SIZE];
+    const uint8_t* sample = data;
+    size_t sample_size = size;
+    size_t chunk = ARCHIVE_AUTO_SAMPLE_SIZE / ARCHIVE_AUTO_SAMPLE_CHUNKS;
+    double goal = archive->decode_goal / 100.0;
+    double best_cost = 1.0 - goal;
+    double cost;
+    const uint8_t* dictionary;
+    size_t dictionary_size;
+    uint8_t* packed;
+    size_t packed_size;
+    size_t i;
+    int level;
+    int result;
     
-    if (archive == NULL || name == NULL) {
-        return NULL;
-    }
+    pthread_once(&decode_costs_once, calibrate_decode_costs);
     
-    for (i = 0; i < archive->header.member_count; i++) {
-        if (archive->members[i].name != NULL && 
-            strcmp(archive->members[i].name, name) == 0) {
-            return &archive->members[i];
+    choice->algorithm = STAR_COMPRESS_NONE;
+    choice->level = 0;
+    choice->stored = NULL;
+    choice->stored_size = 0;
+    
+    if (size > ARCHIVE_AUTO_SAMPLE_SIZE) {
+        for (i = 0; i < ARCHIVE_AUTO_SAMPLE_CHUNKS; i++) {
+            memcpy(chunks + i * chunk,
+                   data + (size - chunk) / (ARCHIVE_AUTO_SAMPLE_CHUNKS - 1) * i, chunk);
         }
+        sample = chunks;
+        sample_size = ARCHIVE_AUTO_SAMPLE_SIZE;
     }
     
-    return NULL;
-}
-
-archive_member_t* archive_get_member(const archive_file_t* archive, uint32_t index) {
-    if (archive == NULL || index >= archive->header.member_count) {
-        return NULL;
+    for (i = 0; i < sizeof(candidates) / sizeof(candidates[0]); i++) {
+        level = compression_get_default_level(candidates[i]);
+        if (!compression_is_available(candidates[i]) ||
+            compression_estimate_compressed_size(candidates[i], size, level) >= size ||
+            goal * decode_costs[candidates[i]] >= best_cost) {
+            continue;
+        }
+        
+        dictionary = member_dictionary(archive, candidates[i], &dictionary_size);
+        result = compression_compress_with_dictionary(candidates[i], level, dictionary,
+                                                      dictionary_size, sample, sample_size,
+                                                      &packed, &packed_size);
+        if (result != COMPRESS_SUCCESS) {
+            compression_free_buffer(choice->stored);
+            choice->stored = NULL;
+            return compression_error(result, ERROR_COMPRESSION_FAILED);
+        }
+        
+        cost = (1.0 - goal) * compression_calculate_ratio(sample_size, packed_size) +
+               goal * decode_costs[candidates[i]];
+        if (packed_size * ARCHIVE_AUTO_MIN_SAVING < sample_size * (ARCHIVE_AUTO_MIN_SAVING - 1) &&
+            cost < best_cost) {
+            best_cost = cost;
+            choice->algorithm = candidates[i];
+            choice->level = level;
+            compression_free_buffer(choice->stored);
+            choice->stored = NULL;
+            if (sample == data) {
+                choice->stored = packed;
+                choice->stored_size = packed_size;
+                packed = NULL;
+            }
+        }
+        compression_free_buffer(packed);
     }
     
-    return &archive->members[index];
+    return ERROR_SUCCESS;
 }
 
-int archive_extract_member(const archive_file_t* archive,
-                          const archive_member_t* member,
-                          const char* output_path) {
-    FILE* output_file;
+/*
+ * Compress a member's data for storage, in blocks when it is larger
+ * than one. Data that would not shrink is kept as it is; *stored is then
+ * NULL and the member stays uncompressed.
+ */
+static int compress_member(const archive_file_t* archive, star_member_header_t* header,
+                           const uint8_t* data, uint8_t** stored) {
+    bool blocked = archive->block_shift != 0 && header->size > (uint32_t)1 << archive->block_shift;
+    member_choice_t choice = {archive->compression, archive->compression_level, NULL, 0};
+    const uint8_t* dictionary;
+    size_t dictionary_size;
+    size_t size = 0;
+    int result;
     
-    if (archive == NULL || member == NULL || output_path == NULL) {
-        return ERROR_INVALID_ARGUMENT;
+    *stored = NULL;
+    header->compressed_size = header->size;
+    header->compression = STAR_COMPRESS_NONE;
+    header->block_shift = 0;
+    header->flags &= (uint16_t)~ARCHIVE_STORAGE_FLAGS;
+    
+    if (archive->compression == STAR_COMPRESS_NONE || header->size == 0) {
+        return ERROR_SUCCESS;
     }
     
-    if (!member->data_loaded) {
-        return ERROR_INVALID_ARGUMENT; /* TODO: Load data from file */
+    if (archive->compression == STAR_COMPRESS_AUTO) {
+        result = choose_compression(archive, data, header->size, &choice);
+        if (result != ERROR_SUCCESS || choice.algorithm == STAR_COMPRESS_NONE) {
+            return result;
+        }
     }
     
-    output_file = fopen(output_path, "wb");
-    if (output_file == NULL) {
-        return ERROR_FILE_IO;
+    dictionary = member_dictionary(archive, choice.algorithm, &dictionary_size);
+    if (choice.stored != NULL && !blocked) {
+        *stored = choice.stored;
+        size = choice.stored_size;
+        result = ERROR_SUCCESS;
+    } else if (blocked) {
+        compression_free_buffer(choice.stored);
+        result = compress_blocks(archive, choice.algorithm, choice.level, data, header->size,
+                                 stored, &size);
+    } else {
+        result = compression_error(compression_compress_with_dictionary(
+                                       choice.algorithm, choice.level, dictionary,
+                                       dictionary_size, data, header->size, stored, &size),
+                                   ERROR_COMPRESSION_FAILED);
+    }
+    if (result != ERROR_SUCCESS) {
+        return result;
     }
     
-    if (fwrite(member->data, member->header.size, 1, output_file) != 1) {
-        fclose(output_file);
-        return ERROR_FILE_IO;
+    if (size >= header->size) {
+        compression_free_buffer(*stored);
+        *stored = NULL;
+        return ERROR_SUCCESS;
+    }
+    
+    header->compressed_size = (uint32_t)size;
+    header->compression = (uint8_t)choice.algorithm;
+    header->flags |= STAR_MEMBER_FLAG_COMPRESSED;
+    if (blocked) {
+        header->block_shift = archive->block_shift;
+        header->flags |= STAR_MEMBER_FLAG_BLOCKED;
+    }
+    if (dictionary != NULL) {
+        header->flags |= STAR_MEMBER_FLAG_DICTIONARY;
     }
     
-    fclose(output_file);
     return ERROR_SUCCESS;
 }
 
-int archive_load_members(archive_file_t* archive) {
-    uint32_t i;
-    star_member_header_t member_header;
-    archive_member_t* member;
+/* Take over how a member is stored, keeping its name and other flags */
+static void store_member_header(star_member_header_t* header, const star_member_header_t* stored,
+                                uint32_t data_offset) {
+    header->size = stored->size;
+    header->compressed_size = stored->compressed_size;
+    header->checksum = stored->checksum;
+    header->timestamp = stored->timestamp;
+    header->compression = stored->compression;
+    header->block_shift = stored->block_shift;
+    header->flags = (uint16_t)((header->flags & ~ARCHIVE_STORAGE_FLAGS) |
+                               (stored->flags & ARCHIVE_STORAGE_FLAGS));
+    header->data_offset = data_offset;
+}
+
+/* The slot of the member with this checksum and size, or the empty slot it would take */
+static size_t dedup_slot(const archive_dedup_t* dedup, uint32_t checksum, uint32_t size) {
+    size_t mask = dedup->slot_count - 1;
+    size_t slot = checksum & mask;
+    
+    while (dedup->slots[slot].data_offset != 0 &&
+           (dedup->slots[slot].checksum != checksum || dedup->slots[slot].size != size)) {
+        slot = (slot + 1) & mask;
+    }
     
-    if (archive == NULL || archive->header.member_count == 0) {
-        return ERROR_SUCCESS;
+    return slot;
+}
+
+static int dedup_grow(archive_dedup_t* dedup) {
+    star_member_header_t* old = dedup->slots;
+    size_t old_count = dedup->slot_count;
+    size_t slot_count = old_count > 0 ? old_count * 2 : ARCHIVE_STRING_SLOTS_INITIAL;
+    size_t i;
+    
+    dedup->slots = calloc(slot_count, sizeof(star_member_header_t));
+    if (dedup->slots == NULL) {
+        dedup->slots = old;
+        return ERROR_OUT_OF_MEMORY;
     }
+    dedup->slot_count = slot_count;
     
-    /* Allocate members array */
+    for (i = 0; i < old_count; i++) {
+        if (old[i].data_offset != 0) {
+            dedup->slots[dedup_slot(dedup, old[i].checksum, old[i].size)] = old[i];
+        }
+    }
+    free(old);
+    
+    return ERROR_SUCCESS;
+}
+
+/*
+ * Remember how a member is stored; the first member stored with a given
+ * checksum and size is the one later duplicates share. Its data must be
+ * readable through the file by then.
+ */
+static int dedup_add(archive_dedup_t* dedup, const star_member_header_t* header) {
+    size_t slot;
+    int result = ERROR_SUCCESS;
+    
+    if (header->size == 0) {
+        return ERROR_SUCCESS;
+    }
+    
+    pthread_mutex_lock(&dedup->mutex);
+    if ((dedup->count + 1) * 2 > dedup->slot_count) {
+        result = dedup_grow(dedup);
+    }
+    if (result == ERROR_SUCCESS) {
+        slot = dedup_slot(dedup, header->checksum, header->size);
+        if (dedup->slots[slot].data_offset == 0) {
+            dedup->slots[slot] = *header;
+            dedup->count++;
+        }
+    }
+    pthread_mutex_unlock(&dedup->mutex);
+    
+    return result;
+}
+
+/* Record a member just written; buffered data is flushed so workers can read it back */
+static int dedup_record(archive_file_t* archive, const star_member_header_t* header) {
+    if (archive->dedup == NULL) {
+        return ERROR_SUCCESS;
+    }
+    if (fflush(archive->file) != 0) {
+        return ERROR_FILE_IO;
+    }
+    
+    return dedup_add(archive->dedup, header);
+}
+
+/*
+ * Point a prepared member at a stored member with the same checksum and
+ * size if their contents also match, compared by reading the stored one
+ * back. Returns whether it did; a member that cannot be read back is
+ * simply not shared.
+ */
+static bool find_duplicate(const archive_file_t* archive, archive_prepared_member_t* prepared) {
+    archive_dedup_t* dedup = archive->dedup;
+    archive_member_t stored;
+    uint32_t timestamp = prepared->header.timestamp;
+    uint8_t* data;
+    bool found = false;
+    
+    if (dedup == NULL || prepared->header.size == 0) {
+        return false;
+    }
+    
+    memset(&stored, 0, sizeof(stored));
+    pthread_mutex_lock(&dedup->mutex);
+    if (dedup->slot_count > 0) {
+        stored.header = dedup->slots[dedup_slot(dedup, prepared->header.checksum,
+                                                prepared->header.size)];
+        found = stored.header.data_offset != 0;
+    }
+    pthread_mutex_unlock(&dedup->mutex);
+    if (!found) {
+        return false;
+    }
+    
+    data = malloc(stored.header.size);
+    found = data != NULL && archive_read_member(archive, &stored, data) == ERROR_SUCCESS &&
+            memcmp(data, prepared->data, stored.header.size) == 0;
+    free(data);
+    
+    if (found) {
+        store_member_header(&prepared->header, &stored.header, stored.header.data_offset);
+        prepared->header.timestamp = timestamp;
+        prepared->duplicate = true;
+    }
+    
+    return found;
+}
+
+/* Compressors work on whole buffers, so a member to be compressed is read whole */
+int archive_prepare_member(const archive_file_t* archive, const char* file_path,
+                           archive_prepared_member_t* prepared) {
+    trace_span_t span;
+    FILE* input_file;
+    struct stat st;
+    int result = ERROR_SUCCESS;
+    
+    if (archive == NULL || file_path == NULL || prepared == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    memset(prepared, 0, sizeof(*prepared));
+    if (stat(file_path, &st) != 0) {
+        return ERROR_FILE_IO;
+    }
+    if (st.st_size < 0 || (uint64_t)st.st_size > UINT32_MAX) {
+        return ERROR_OUTPUT_TOO_LARGE;
+    }
+    
+    input_file = fopen(file_path, "rb");
+    if (input_file == NULL) {
+        return ERROR_FILE_IO;
+    }
+    
+    TRACE_BEGIN(span, "read_member");
+    prepared->data = malloc(st.st_size > 0 ? (size_t)st.st_size : 1);
+    if (prepared->data == NULL) {
+        result = ERROR_OUT_OF_MEMORY;
+    } else if (st.st_size > 0 && fread(prepared->data, (size_t)st.st_size, 1, input_file) != 1) {
+        result = ERROR_FILE_IO;
+    }
+    fclose(input_file);
+    TRACE_END(span, file_path);
+    
+    if (result == ERROR_SUCCESS) {
+        prepared->header.size = (uint32_t)st.st_size;
+        prepared->header.timestamp = (uint32_t)st.st_mtime;
+        prepared->header.checksum = archive_calculate_checksum(prepared->data,
+                                                               (size_t)st.st_size);
+        if (!find_duplicate(archive, prepared)) {
+            TRACE_BEGIN(span, "compress_member");
+            result = compress_member(archive, &prepared->header, prepared->data,
+                                     &prepared->stored);
+            TRACE_END(span, file_path);
+        }
+    }
+    
+    if (result != ERROR_SUCCESS) {
+        archive_release_prepared_member(prepared);
+    }
+    
+    return result;
+}
+
+int archive_stream_prepared_member(archive_file_t* archive, uint32_t index,
+                                   archive_prepared_member_t* prepared) {
+    trace_span_t span;
+    int result = ERROR_SUCCESS;
+    
+    if (archive == NULL || prepared == NULL || !archive->is_streaming ||
+        index >= archive->header.member_count ||
+        archive->members[index].header.data_offset != 0) {
+        archive_release_prepared_member(prepared);
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    /* A worker may have prepared it before the member it duplicates was written */
+    if (prepared->duplicate || find_duplicate(archive, prepared)) {
+        store_member_header(&archive->members[index].header, &prepared->header,
+                            prepared->header.data_offset);
+        archive_release_prepared_member(prepared);
+        return ERROR_SUCCESS;
+    }
+    
+    TRACE_BEGIN(span, "write_member");
+    if ((uint64_t)archive->stream_offset + prepared->header.compressed_size > UINT32_MAX) {
+        result = ERROR_OUTPUT_TOO_LARGE;
+    } else if (prepared->header.compressed_size > 0 &&
+               fwrite(prepared->stored != NULL ? prepared->stored : prepared->data,
+                      prepared->header.compressed_size, 1, archive->file) != 1) {
+        result = ERROR_FILE_IO;
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        store_member_header(&archive->members[index].header, &prepared->header,
+                            archive->stream_offset);
+        archive->stream_offset += prepared->header.compressed_size;
+        result = dedup_record(archive, &archive->members[index].header);
+    }
+    TRACE_END(span, archive->members[index].name);
+    
+    archive_release_prepared_member(prepared);
+    
+    return result;
+}
+
+void archive_release_prepared_member(archive_prepared_member_t* prepared) {
+    if (prepared == NULL) {
+        return;
+    }
+    
+    compression_free_buffer(prepared->stored);
+    free(prepared->data);
+    prepared->stored = NULL;
+    prepared->data = NULL;
+    prepared->duplicate = false;
+}
+
+int archive_set_dictionary(archive_file_t* archive, const uint8_t* data, size_t size) {
+    uint8_t* copy;
+    
+    if (archive == NULL || (data == NULL && size > 0) || size > STAR_MAX_DICTIONARY_SIZE) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    /* It goes ahead of the member data, so none may be written yet */
+    if (!archive->is_writable || archive->is_updating || archive->dictionary != NULL ||
+        (archive->is_streaming && archive->stream_offset != archive->stream_start)) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    if (size == 0) {
+        return ERROR_SUCCESS;
+    }
+    if (archive->is_streaming && (uint64_t)archive->stream_offset + size > UINT32_MAX) {
+        return ERROR_OUTPUT_TOO_LARGE;
+    }
+    
+    copy = malloc(size);
+    if (copy == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    memcpy(copy, data, size);
+    
+    /* A streamed archive writes it at once; otherwise finalizing does */
+    if (archive->is_streaming) {
+        if (fseek(archive->file, (long)archive->stream_offset, SEEK_SET) != 0 ||
+            fwrite(copy, size, 1, archive->file) != 1) {
+            free(copy);
+            return ERROR_FILE_IO;
+        }
+        archive->header.dictionary_offset = archive->stream_offset;
+        archive->stream_offset += (uint32_t)size;
+    }
+    
+    archive->dictionary = copy;
+    archive->header.dictionary_size = (uint32_t)size;
+    archive->header.flags |= STAR_FLAG_DICTIONARY;
+    
+    return ERROR_SUCCESS;
+}
+
+/* Every stride-th of count inputs is sampled, so at most ARCHIVE_DICTIONARY_SAMPLES are */
+static size_t sample_stride(size_t count) {
+    return (count + ARCHIVE_DICTIONARY_SAMPLES - 1) / ARCHIVE_DICTIONARY_SAMPLES;
+}
+
+/* One member has nothing to share, and LZMA cannot use a dictionary */
+static bool wants_dictionary(const archive_file_t* archive, size_t member_count) {
+    return archive->dictionary_capacity > 0 && archive->dictionary == NULL &&
+           (archive->compression == STAR_COMPRESS_AUTO ||
+            compression_supports_dictionary(archive->compression)) && member_count > 1;
+}
+
+static int train_dictionary(archive_file_t* archive, const uint8_t* const* samples,
+                            const size_t* sizes, size_t count) {
+    uint8_t* dictionary;
+    size_t size = 0;
+    int result;
+    
+    dictionary = malloc(archive->dictionary_capacity);
+    if (dictionary == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    result = compression_error(compression_train_dictionary(samples, sizes, count, dictionary,
+                                                            archive->dictionary_capacity, &size),
+                               ERROR_COMPRESSION_FAILED);
+    if (result == ERROR_SUCCESS) {
+        result = archive_set_dictionary(archive, dictionary, size);
+    }
+    free(dictionary);
+    
+    return result;
+}
+
+int archive_train_dictionary(archive_file_t* archive, const char* const* paths, size_t count) {
+    uint8_t** samples;
+    size_t* sizes;
+    size_t stride;
+    size_t used = 0;
+    size_t i;
+    FILE* file;
+    int result = ERROR_SUCCESS;
+    
+    if (archive == NULL || (paths == NULL && count > 0)) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    if (!wants_dictionary(archive, count)) {
+        return ERROR_SUCCESS;
+    }
+    
+    samples = calloc(ARCHIVE_DICTIONARY_SAMPLES, sizeof(uint8_t*));
+    sizes = calloc(ARCHIVE_DICTIONARY_SAMPLES, sizeof(size_t));
+    if (samples == NULL || sizes == NULL) {
+        result = ERROR_OUT_OF_MEMORY;
+    }
+    
+    /* The start of a file holds its headers, which is what objects share most */
+    stride = sample_stride(count);
+    for (i = 0; result == ERROR_SUCCESS && i < count; i += stride) {
+        samples[used] = malloc(ARCHIVE_DICTIONARY_SAMPLE_SIZE);
+        file = fopen(paths[i], "rb");
+        if (samples[used] == NULL) {
+            result = ERROR_OUT_OF_MEMORY;
+        } else if (file == NULL) {
+            result = ERROR_FILE_IO;
+        } else {
+            sizes[used] = fread(samples[used], 1, ARCHIVE_DICTIONARY_SAMPLE_SIZE, file);
+            if (ferror(file)) {
+                result = ERROR_FILE_IO;
+            }
+        }
+        if (file != NULL) {
+            fclose(file);
+        }
+        used++;
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        result = train_dictionary(archive, (const uint8_t* const*)samples, sizes, used);
+    }
+    
+    for (i = 0; i < used; i++) {
+        free(samples[i]);
+    }
+    free(samples);
+    free(sizes);
+    
+    return result;
+}
+
+/* Members added in memory train the dictionary from their own data */
+static int train_member_dictionary(archive_file_t* archive) {
+    const uint8_t** samples;
+    size_t* sizes;
+    size_t stride;
+    size_t used = 0;
+    uint32_t i;
+    int result;
+    
+    if (!wants_dictionary(archive, archive->header.member_count)) {
+        return ERROR_SUCCESS;
+    }
+    
+    samples = calloc(ARCHIVE_DICTIONARY_SAMPLES, sizeof(const uint8_t*));
+    sizes = calloc(ARCHIVE_DICTIONARY_SAMPLES, sizeof(size_t));
+    if (samples == NULL || sizes == NULL) {
+        free(samples);
+        free(sizes);
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    stride = sample_stride(archive->header.member_count);
+    for (i = 0; i < archive->header.member_count; i += (uint32_t)stride) {
+        if (archive->members[i].data_loaded) {
+            samples[used] = archive->members[i].data;
+            sizes[used] = archive->members[i].header.size < ARCHIVE_DICTIONARY_SAMPLE_SIZE ?
+                          archive->members[i].header.size : ARCHIVE_DICTIONARY_SAMPLE_SIZE;
+            used++;
+        }
+    }
+    
+    result = train_dictionary(archive, samples, sizes, used);
+    free(samples);
+    free(sizes);
+    
+    return result;
+}
+
+int archive_stream_member_from_file(archive_file_t* archive, uint32_t index,
+                                    const char* file_path) {
+    archive_member_t* member;
+    archive_prepared_member_t prepared;
+    trace_span_t span;
+    FILE* input_file;
+    struct stat st;
+    uint8_t* buffer;
+    uint64_t size = 0;
+    uint32_t crc = CRC32_INITIAL;
+    size_t bytes;
+    int result = ERROR_SUCCESS;
+    
+    if (archive == NULL || file_path == NULL || !archive->is_streaming ||
+        index >= archive->header.member_count) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    member = &archive->members[index];
+    if (member->header.data_offset != 0) {
+        return ERROR_INVALID_ARGUMENT; /* Already streamed */
+    }
+    
+    if (archive->compression != STAR_COMPRESS_NONE || archive->dedup != NULL) {
+        result = archive_prepare_member(archive, file_path, &prepared);
+        
+        return result == ERROR_SUCCESS ?
+               archive_stream_prepared_member(archive, index, &prepared) : result;
+    }
+    
+    if (stat(file_path, &st) != 0) {
+        return ERROR_FILE_IO;
+    }
+    
+    input_file = fopen(file_path, "rb");
+    if (input_file == NULL) {
+        return ERROR_FILE_IO;
+    }
+    
+    buffer = malloc(ARCHIVE_STREAM_CHUNK_SIZE);
+    if (buffer == NULL) {
+        fclose(input_file);
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    /* Copy and checksum one chunk at a time */
+    TRACE_BEGIN(span, "copy_member");
+    while (result == ERROR_SUCCESS &&
+           (bytes = fread(buffer, 1, ARCHIVE_STREAM_CHUNK_SIZE, input_file)) > 0) {
+        if (archive->stream_offset + size + bytes > UINT32_MAX) {
+            result = ERROR_OUTPUT_TOO_LARGE;
+        } else if (fwrite(buffer, 1, bytes, archive->file) != bytes) {
+            result = ERROR_FILE_IO;
+        } else {
+            crc = crc32_update(crc, buffer, bytes);
+            size += bytes;
+        }
+    }
+    
+    if (result == ERROR_SUCCESS && ferror(input_file)) {
+        result = ERROR_FILE_IO;
+    }
+    fclose(input_file);
+    free(buffer);
+    TRACE_END(span, file_path);
+    
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    member->header.size = (uint32_t)size;
+    member->header.compressed_size = (uint32_t)size;
+    member->header.data_offset = archive->stream_offset;
+    member->header.checksum = crc;
+    member->header.timestamp = (uint32_t)st.st_mtime;
+    archive->stream_offset += (uint32_t)size;
+    
+    return ERROR_SUCCESS;
+}
+
+/* Checksum and write the header as it is */
+static int store_header(archive_file_t* archive) {
+    /* Calculate checksum (excluding checksum field) */
+    archive->header.checksum = archive_calculate_checksum(&archive->header, 
+                                                         sizeof(star_header_t) - sizeof(uint32_t));
+    
+    /* Write header */
+    if (fseek(archive->file, 0, SEEK_SET) != 0) {
+        return ERROR_FILE_IO;
+    }
+    
+    if (fwrite(&archive->header, sizeof(star_header_t), 1, archive->file) != 1) {
+        return ERROR_FILE_IO;
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+int archive_write_header(archive_file_t* archive) {
+    if (archive == NULL || !archive->is_writable) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    /* Calculate offsets */
+    archive->header.member_table_offset = sizeof(star_header_t);
+    archive->header.string_table_offset = archive->header.member_table_offset + 
+                                         (uint32_t)(archive->header.member_count * sizeof(star_member_header_t));
+    
+    return store_header(archive);
+}
+
+/* Read size bytes at offset without moving any shared file position */
+static int read_at(const archive_file_t* archive, uint8_t* output, size_t size,
+                   uint64_t offset) {
+    archive_io_request_t request = {fileno(archive->file), output, size, offset};
+    
+    return archive_io_read(archive->io, &request, 1);
+}
+
+int archive_set_io_backend(archive_file_t* archive, star_io_backend_t backend) {
+    archive_io_t* io;
+    
+    if (archive == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    io = archive_io_create(backend);
+    if (io == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    archive_io_destroy(archive->io);
+    archive->io = io;
+    
+    return ERROR_SUCCESS;
+}
+
+/*
+ * Copy size stored bytes of an unmapped member, a chunk at a time to a
+ * file. Reads are positional, so threads may extract members of one
+ * archive at the same time.
+ */
+static int copy_member_data(const archive_file_t* archive, const archive_member_t* member,
+                            FILE* output_file, uint8_t* output, size_t size) {
+    uint8_t* buffer;
+    size_t done = 0;
+    size_t bytes;
+    int result = ERROR_SUCCESS;
+    
+    if (output != NULL) {
+        return read_at(archive, output, size, member->header.data_offset);
+    }
+    
+    buffer = malloc(ARCHIVE_STREAM_CHUNK_SIZE);
+    if (buffer == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    while (result == ERROR_SUCCESS && done < size) {
+        bytes = size - done < ARCHIVE_STREAM_CHUNK_SIZE ? size - done : ARCHIVE_STREAM_CHUNK_SIZE;
+        result = read_at(archive, buffer, bytes, (uint64_t)member->header.data_offset + done);
+        if (result == ERROR_SUCCESS && fwrite(buffer, 1, bytes, output_file) != bytes) {
+            result = ERROR_FILE_IO;
+        }
+        done += bytes;
+    }
+    
+    free(buffer);
+    
+    return result;
+}
+
+size_t archive_extract_memory(const archive_file_t* archive, const archive_member_t* member) {
+    if (archive == NULL || member == NULL || member->data_loaded) {
+        return 0;
+    }
+    
+    if (archive_member_is_compressed(member)) {
+        return (size_t)member->header.size +
+               (archive->map != NULL ? 0 : member->header.compressed_size);
+    }
+    
+    return archive->map != NULL ? 0 : ARCHIVE_STREAM_CHUNK_SIZE;
+}
+
+/* One range read of a block-compressed member */
+typedef struct block_read {
+    const archive_file_t* archive;
+    const archive_member_t* member;
+    const uint8_t* stored;              /* Stored data in memory, NULL to read the file */
+    const star_block_entry_t* table;
+    uint32_t first;                     /* First block covering the range */
+    uint32_t offset;                    /* Range within the uncompressed member */
+    size_t size;
+    uint8_t* output;
+} block_read_t;
+
+/* Stored bytes [offset, offset + size) of a member, from memory or the file */
+static const uint8_t* stored_bytes(const block_read_t* read, uint32_t offset, size_t size,
+                                   uint8_t* buffer, int* result) {
+    if (read->stored != NULL) {
+        return read->stored + offset;
+    }
+    
+    *result = buffer == NULL ? ERROR_OUT_OF_MEMORY :
+              read_at(read->archive, buffer, size,
+                      (uint64_t)read->member->header.data_offset + offset);
+    
+    return *result == ERROR_SUCCESS ? buffer : NULL;
+}
+
+/* Decompress stored bytes, against the archive's dictionary if the member was */
+static int decompress_stored(const archive_file_t* archive, const star_member_header_t* header,
+                             const uint8_t* data, size_t size, uint8_t* output,
+                             size_t output_size) {
+    const uint8_t* dictionary = NULL;
+    size_t dictionary_size = 0;
+    
+    if ((header->flags & STAR_MEMBER_FLAG_DICTIONARY) != 0) {
+        if (archive->dictionary == NULL) {
+            return ERROR_ARCHIVE_CORRUPT;
+        }
+        dictionary = archive->dictionary;
+        dictionary_size = archive->header.dictionary_size;
+    }
+    
+    return compression_error(compression_decompress_with_dictionary(
+                                 (star_compression_t)header->compression, dictionary,
+                                 dictionary_size, data, size, output, output_size),
+                             ERROR_DECOMPRESSION_FAILED);
+}
+
+/* Decode one block into output, which holds the block's length */
+static int decode_block(const block_read_t* read, uint32_t block, uint8_t* output) {
+    const star_member_header_t* header = &read->member->header;
+    const star_block_entry_t* entry = &read->table[block];
+    uint32_t length = block_length(header->size, header->block_shift, block);
+    uint32_t packed = entry[1].offset - entry->offset;
+    const uint8_t* data;
+    uint8_t* buffer = NULL;
+    int result = ERROR_SUCCESS;
+    
+    if (packed == length) {
+        /* Stored as is: read it straight into place */
+        data = stored_bytes(read, entry->offset, length,
+                            read->stored == NULL ? output : NULL, &result);
+        if (data != NULL && data != output) {
+            memcpy(output, data, length);
+        }
+    } else {
+        if (read->stored == NULL) {
+            buffer = malloc(packed > 0 ? packed : 1);
+        }
+        data = stored_bytes(read, entry->offset, packed, buffer, &result);
+        if (data != NULL) {
+            result = decompress_stored(read->archive, header, data, packed, output, length);
+        }
+        free(buffer);
+    }
+    
+    if (result == ERROR_SUCCESS && crc32_calculate(output, length) != entry->checksum) {
+        result = ERROR_ARCHIVE_CORRUPT;
+    }
+    
+    return result;
+}
+
+/* Decode the index-th block of a range, through a scratch block if only partly wanted */
+static int read_block_task(void* user_data, size_t index) {
+    const block_read_t* read = user_data;
+    uint8_t shift = read->member->header.block_shift;
+    uint32_t block = read->first + (uint32_t)index;
+    uint32_t start = block << shift;
+    uint32_t length = block_length(read->member->header.size, shift, block);
+    uint64_t low = read->offset > start ? read->offset : start;
+    uint64_t high = (uint64_t)read->offset + read->size;
+    uint8_t* scratch;
+    int result;
+    
+    if (high > (uint64_t)start + length) {
+        high = (uint64_t)start + length;
+    }
+    
+    if (low == start && high == (uint64_t)start + length) {
+        return decode_block(read, block, read->output + (start - read->offset));
+    }
+    
+    scratch = malloc(length);
+    if (scratch == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    result = decode_block(read, block, scratch);
+    if (result == ERROR_SUCCESS) {
+        memcpy(read->output + (low - read->offset), scratch + (low - start),
+               (size_t)(high - low));
+    }
+    free(scratch);
+    
+    return result;
+}
+
+/* Copy and check a block table: offsets increase, fit their blocks and end the data */
+static int load_block_table(const block_read_t* read, star_block_entry_t** table) {
+    const star_member_header_t* header = &read->member->header;
+    uint32_t count;
+    size_t table_size;
+    const uint8_t* data;
+    uint32_t i;
+    int result = ERROR_SUCCESS;
+    
+    if (header->block_shift < 12 || header->block_shift > 24) {
+        return ERROR_ARCHIVE_CORRUPT;
+    }
+    
+    count = block_count(header->size, header->block_shift);
+    table_size = ((size_t)count + 1) * sizeof(star_block_entry_t);
+    if (table_size > header->compressed_size) {
+        return ERROR_ARCHIVE_CORRUPT;
+    }
+    
+    *table = malloc(table_size);
+    if (*table == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    data = stored_bytes(read, 0, table_size, (uint8_t*)*table, &result);
+    if (data != NULL && data != (uint8_t*)*table) {
+        memcpy(*table, data, table_size);
+    }
+    
+    if (result == ERROR_SUCCESS &&
+        ((*table)[0].offset != table_size || (*table)[count].offset != header->compressed_size)) {
+        result = ERROR_ARCHIVE_CORRUPT;
+    }
+    for (i = 0; result == ERROR_SUCCESS && i < count; i++) {
+        if ((*table)[i + 1].offset < (*table)[i].offset ||
+            (*table)[i + 1].offset - (*table)[i].offset >
+            block_length(header->size, header->block_shift, i)) {
+            result = ERROR_ARCHIVE_CORRUPT;
+        }
+    }
+    
+    if (result != ERROR_SUCCESS) {
+        free(*table);
+        *table = NULL;
+    }
+    
+    return result;
+}
+
+/* Decode [offset, offset + size) of a block-compressed member from its blocks */
+static int read_blocks(const archive_file_t* archive, thread_pool_t* pool,
+                       const archive_member_t* member, const uint8_t* stored,
+                       uint32_t offset, size_t size, uint8_t* output) {
+    star_block_entry_t* table = NULL;
+    block_read_t read;
+    uint32_t last;
+    int result;
+    
+    if (size == 0) {
+        return ERROR_SUCCESS;
+    }
+    
+    read = (block_read_t) {
+        .archive = archive,
+        .member = member,
+        .stored = stored,
+        .first = offset >> member->header.block_shift,
+        .offset = offset,
+        .size = size,
+        .output = output
+    };
+    
+    result = load_block_table(&read, &table);
+    if (result == ERROR_SUCCESS) {
+        read.table = table;
+        last = (uint32_t)(((uint64_t)offset + size - 1) >> member->header.block_shift);
+        result = thread_pool_run(pool, (size_t)(last - read.first) + 1,
+                                 read_block_task, &read);
+    }
+    free(table);
+    
+    return result;
+}
+
+/* Decompress a whole member from its stored bytes (NULL = read the file) into output */
+static int decode_member(const archive_file_t* archive, thread_pool_t* pool,
+                         const archive_member_t* member, const uint8_t* stored,
+                         uint8_t* output) {
+    uint8_t* buffer = NULL;
+    int result = ERROR_SUCCESS;
+    
+    if (archive_member_is_blocked(member)) {
+        return read_blocks(archive, pool, member, stored, 0, member->header.size, output);
+    }
+    
+    if (stored == NULL) {
+        buffer = malloc(member->header.compressed_size > 0 ? member->header.compressed_size : 1);
+        result = buffer == NULL ? ERROR_OUT_OF_MEMORY :
+                 copy_member_data(archive, member, NULL, buffer, member->header.compressed_size);
+        stored = buffer;
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        result = decompress_stored(archive, &member->header, stored,
+                                   member->header.compressed_size, output, member->header.size);
+    }
+    free(buffer);
+    
+    return result;
+}
+
+/*
+ * Members already written, read back through a mapping of the file. The
+ * mapping is backed by the file, so member data never has to fit in memory.
+ */
+typedef struct written_members {
+    const archive_file_t* archive;
+    uint8_t* map;
+} written_members_t;
+
+static int load_written_member(void* user_data, archive_member_t* view,
+                               thread_pool_t* pool, uint8_t** buffer) {
+    const written_members_t* written = user_data;
+    
+    view->data_loaded = view->header.data_offset != 0;
+    if (!view->data_loaded) {
+        return ERROR_SUCCESS;
+    }
+    
+    view->data = written->map + view->header.data_offset;
+    if (!archive_member_is_compressed(view)) {
+        return ERROR_SUCCESS;
+    }
+    
+    *buffer = malloc(view->header.size > 0 ? view->header.size : 1);
+    if (*buffer == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    view->data = *buffer;
+    
+    return decode_member(written->archive, pool, view,
+                         written->map + view->header.data_offset, *buffer);
+}
+
+/* Index the first length bytes of the file, on the archive's pool if it has one */
+static int index_written_members(symbol_index_t* index, archive_file_t* archive,
+                                 uint32_t length) {
+    written_members_t written;
+    int result;
+    
+    if (fflush(archive->file) != 0) {
+        return ERROR_FILE_IO;
+    }
+    
+    written.archive = archive;
+    written.map = mmap(NULL, length, PROT_READ, MAP_SHARED, fileno(archive->file), 0);
+    if (written.map == MAP_FAILED) {
+        return ERROR_FILE_IO;
+    }
+    
+    result = symbol_index_build_parallel(index, archive, archive->pool, load_written_member,
+                                         &written);
+    munmap(written.map, length);
+    
+    return result;
+}
+
+/* Serialized index of the members' global definitions; the caller frees it */
+static int serialize_symbol_index(archive_file_t* archive, uint8_t** data, size_t* size) {
+    symbol_index_t* index;
+    int result = ERROR_SUCCESS;
+    
+    index = symbol_index_create(0);
+    if (index == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    if (archive->is_updating) {
+        result = index_written_members(index, archive, archive->file_end);
+    } else if (archive->is_streaming) {
+        if (archive->stream_offset > archive->stream_start) {
+            result = index_written_members(index, archive, archive->stream_offset);
+        }
+    } else {
+        result = symbol_index_build_from_archive(index, archive);
+    }
+    if (result == ERROR_SUCCESS) {
+        result = symbol_index_serialize(index, data, size);
+    }
+    symbol_index_destroy(index);
+    
+    if (result == ERROR_SUCCESS && *size > UINT32_MAX) {
+        free(*data);
+        *data = NULL;
+        result = ERROR_OUTPUT_TOO_LARGE;
+    }
+    
+    return result;
+}
+
+/* Write the index at offset, after the member data */
+static int write_symbol_index(archive_file_t* archive, uint32_t offset) {
+    uint8_t* data = NULL;
+    size_t size = 0;
+    int result;
+    
+    result = serialize_symbol_index(archive, &data, &size);
+    if (result == ERROR_SUCCESS && fwrite(data, size, 1, archive->file) != 1) {
+        result = ERROR_FILE_IO;
+    }
+    free(data);
+    
+    if (result == ERROR_SUCCESS) {
+        archive->header.index_offset = offset;
+        archive->header.index_size = (uint32_t)size;
+    }
+    
+    return result;
+}
+
+/* Name order, and the original order among equal names */
+static int compare_member_names(const void* a, const void* b) {
+    const archive_member_t* left = a;
+    const archive_member_t* right = b;
+    int order = strcmp(left->name != NULL ? left->name : "",
+                       right->name != NULL ? right->name : "");
+    
+    if (order != 0) {
+        return order;
+    }
+    return (left->index > right->index) - (left->index < right->index);
+}
+
+/* Position of the first member named name or after it in a sorted table */
+static uint32_t sorted_member_position(const archive_file_t* archive, const char* name) {
+    uint32_t low = 0;
+    uint32_t high = archive->header.member_count;
+    uint32_t middle;
+    
+    while (low < high) {
+        middle = low + (high - low) / 2;
+        if (strcmp(archive->members[middle].name, name) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    
+    return low;
+}
+
+/* Hash member i unless an earlier member has the same name */
+static void index_member(archive_file_t* archive, uint32_t i) {
+    const char* name = archive->members[i].name;
+    size_t mask = archive->member_slot_count - 1;
+    size_t slot;
+    
+    if (name == NULL) {
+        return;
+    }
+    
+    slot = symbol_index_hash_name(name) & mask;
+    while (archive->member_slots[slot] != 0 &&
+           strcmp(archive->members[archive->member_slots[slot] - 1].name, name) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    if (archive->member_slots[slot] == 0) {
+        archive->member_slots[slot] = i + 1;
+    }
+}
+
+/* Hash member names at half load so lookups by name take constant time */
+static int index_members(archive_file_t* archive) {
+    size_t slot_count = 16;
+    uint32_t i;
+    
+    while (slot_count < (size_t)archive->header.member_count * 2) {
+        slot_count *= 2;
+    }
+    
+    free(archive->member_slots);
+    archive->member_slots = calloc(slot_count, sizeof(uint32_t));
+    if (archive->member_slots == NULL) {
+        archive->member_slot_count = 0;
+        return ERROR_OUT_OF_MEMORY;
+    }
+    archive->member_slot_count = slot_count;
+    
+    for (i = 0; i < archive->header.member_count; i++) {
+        index_member(archive, i);
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+/* A sorted archive's table in name order is searched as it is; anything else is hashed */
+static int index_member_table(archive_file_t* archive) {
+    uint32_t i;
+    
+    archive->members_sorted = archive_is_sorted(archive);
+    for (i = 0; i < archive->header.member_count && archive->members_sorted; i++) {
+        archive->members_sorted = archive->members[i].name != NULL &&
+                                  (i == 0 || strcmp(archive->members[i - 1].name,
+                                                    archive->members[i].name) <= 0);
+    }
+    if (!archive->members_sorted) {
+        return index_members(archive);
+    }
+    
+    free(archive->member_slots);
+    archive->member_slots = NULL;
+    archive->member_slot_count = 0;
+    
+    return ERROR_SUCCESS;
+}
+
+/* Put a sorted archive's members in name order before its tables are written */
+static int sort_member_table(archive_file_t* archive) {
+    uint32_t i;
+    
+    if (!archive_is_sorted(archive) || archive->members_sorted ||
+        archive->header.member_count == 0) {
+        return ERROR_SUCCESS;
+    }
+    
+    qsort(archive->members, archive->header.member_count, sizeof(archive_member_t),
+          compare_member_names);
+    for (i = 0; i < archive->header.member_count; i++) {
+        archive->members[i].index = i;
+    }
+    
+    return index_member_table(archive);
+}
+
+/* Member headers and string table at the offsets the header gives */
+static int write_member_tables(archive_file_t* archive) {
+    uint32_t i;
+    int result = ERROR_SUCCESS;
+    
+    if (fseek(archive->file, (long)archive->header.member_table_offset, SEEK_SET) != 0) {
+        return ERROR_FILE_IO;
+    }
+    for (i = 0; i < archive->header.member_count && result == ERROR_SUCCESS; i++) {
+        if (fwrite(&archive->members[i].header, sizeof(star_member_header_t), 1,
+                   archive->file) != 1) {
+            result = ERROR_FILE_IO;
+        }
+    }
+    
+    if (result == ERROR_SUCCESS &&
+        (fseek(archive->file, (long)archive->header.string_table_offset, SEEK_SET) != 0 ||
+         fwrite(archive->string_table, archive->header.string_table_size, 1,
+                archive->file) != 1)) {
+        result = ERROR_FILE_IO;
+    }
+    
+    return result;
+}
+
+/* Data is in place: append the index, then fill in the reserved tables */
+static int finalize_stream(archive_file_t* archive) {
+    trace_span_t span;
+    uint32_t tables_end;
+    int result = ERROR_SUCCESS;
+    
+    archive->header.member_table_offset = sizeof(star_header_t);
+    archive->header.string_table_offset = archive->header.member_table_offset +
+                                         archive->header.member_count *
+                                         (uint32_t)sizeof(star_member_header_t);
+    tables_end = archive->header.string_table_offset + archive->header.string_table_size;
+    
+    /* Strings added after the reservation would not fit */
+    if (tables_end > archive->stream_start) {
+        return ERROR_INTERNAL;
+    }
+    
+    /* The index refers to members by position, so it is built after sorting */
+    result = sort_member_table(archive);
+    if (result == ERROR_SUCCESS && archive_has_index(archive)) {
+        if (fseek(archive->file, (long)archive->stream_offset, SEEK_SET) != 0) {
+            return ERROR_FILE_IO;
+        }
+        TRACE_BEGIN(span, "write_index");
+        result = write_symbol_index(archive, archive->stream_offset);
+        TRACE_END(span, NULL);
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        TRACE_BEGIN(span, "write_tables");
+        result = write_member_tables(archive);
+        TRACE_END(span, NULL);
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        result = archive_write_header(archive);
+    }
+    if (result == ERROR_SUCCESS && fflush(archive->file) != 0) {
+        result = ERROR_FILE_IO;
+    }
+    
+    return result;
+}
+
+int archive_finalize(archive_file_t* archive) {
+    uint32_t data_offset;
+    uint32_t i;
+    int result = ERROR_SUCCESS;
+    
+    if (archive == NULL || !archive->is_writable) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    if (archive->is_streaming) {
+        return finalize_stream(archive);
+    }
+    
+    result = sort_member_table(archive);
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    /* Calculate offsets first */
+    archive->header.member_table_offset = sizeof(star_header_t);
+    archive->header.string_table_offset = archive->header.member_table_offset + 
+                                         (uint32_t)(archive->header.member_count * sizeof(star_member_header_t));
+    
+    /* Member data follows the tables; it is written first, as compressed */
+    data_offset = archive->header.string_table_offset + archive->header.string_table_size;
+    if (fseek(archive->file, (long)data_offset, SEEK_SET) != 0) {
+        return ERROR_FILE_IO;
+    }
+    
+    /* The dictionary comes first, so the members can be compressed against it */
+    result = train_member_dictionary(archive);
+    if (result == ERROR_SUCCESS && archive->dictionary != NULL) {
+        archive->header.dictionary_offset = data_offset;
+        if (fwrite(archive->dictionary, archive->header.dictionary_size, 1, archive->file) != 1) {
+            result = ERROR_FILE_IO;
+        }
+        data_offset += archive->header.dictionary_size;
+    }
+    
+    for (i = 0; i < archive->header.member_count && result == ERROR_SUCCESS; i++) {
+        archive_member_t* member = &archive->members[i];
+        uint8_t* stored = NULL;
+        
+        member->header.data_offset = data_offset;
+        if (member->data_loaded) {
+            result = compress_member(archive, &member->header, member->data, &stored);
+            if (result == ERROR_SUCCESS &&
+                (uint64_t)data_offset + member->header.compressed_size > UINT32_MAX) {
+                result = ERROR_OUTPUT_TOO_LARGE;
+            }
+            if (result == ERROR_SUCCESS && member->header.compressed_size > 0 &&
+                fwrite(stored != NULL ? stored : member->data, member->header.compressed_size, 1,
+                       archive->file) != 1) {
+                result = ERROR_FILE_IO;
+            }
+            compression_free_buffer(stored);
+            data_offset += member->header.compressed_size;
+        }
+    }
+    
+    /* Symbol index follows the data so readers can skip every member */
+    if (result == ERROR_SUCCESS && archive_has_index(archive)) {
+        result = write_symbol_index(archive, data_offset);
+    }
+    
+    /* Then the member headers and string table */
+    if (result == ERROR_SUCCESS) {
+        result = write_member_tables(archive);
+    }
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    /* Write header last */
+    return archive_write_header(archive);
+}
+
+archive_member_t* archive_find_member(const archive_file_t* archive, const char* name) {
+    archive_member_t* member;
+    size_t mask;
+    size_t slot;
+    uint32_t i;
+    
+    if (archive == NULL || name == NULL) {
+        return NULL;
+    }
+    
+    if (archive->members_sorted) {
+        i = sorted_member_position(archive, name);
+        return i < archive->header.member_count && strcmp(archive->members[i].name, name) == 0 ?
+               &archive->members[i] : NULL;
+    }
+    
+    /* Archives still being written are not hashed */
+    if (archive->member_slots == NULL) {
+        for (i = 0; i < archive->header.member_count; i++) {
+            if (archive->members[i].name != NULL && 
+                strcmp(archive->members[i].name, name) == 0) {
+                return &archive->members[i];
+            }
+        }
+        return NULL;
+    }
+    
+    mask = archive->member_slot_count - 1;
+    for (slot = symbol_index_hash_name(name) & mask; archive->member_slots[slot] != 0;
+         slot = (slot + 1) & mask) {
+        member = &archive->members[archive->member_slots[slot] - 1];
+        if (strcmp(member->name, name) == 0) {
+            return member;
+        }
+    }
+    
+    return NULL;
+}
+
+archive_member_t* archive_get_member(const archive_file_t* archive, uint32_t index) {
+    if (archive == NULL || index >= archive->header.member_count) {
+        return NULL;
+    }
+    
+    return &archive->members[index];
+}
+
+uint32_t archive_stored_size(const archive_member_t* member) {
+    return archive_member_is_compressed(member) ? member->header.compressed_size :
+           member->header.size;
+}
+
+const uint8_t* archive_member_data(const archive_file_t* archive,
+                                   const archive_member_t* member) {
+    if (archive == NULL || member == NULL || archive->map == NULL ||
+        (uint64_t)member->header.data_offset + archive_stored_size(member) > archive->map_size) {
+        return NULL;
+    }
+    
+    return archive->map + member->header.data_offset;
+}
+
+/* Decompress a member into output, which holds header.size bytes */
+static int decompress_member(const archive_file_t* archive, const archive_member_t* member,
+                             uint8_t* output) {
+    const uint8_t* stored = archive_member_data(archive, member);
+    int result;
+    
+    if (stored == NULL && archive->map != NULL) {
+        return ERROR_ARCHIVE_CORRUPT;
+    }
+    
+    result = decode_member(archive, archive->pool, member, stored, output);
+    if (result == ERROR_SUCCESS &&
+        archive_calculate_checksum(output, member->header.size) != member->header.checksum) {
+        result = ERROR_ARCHIVE_CORRUPT;
+    }
+    
+    return result;
+}
+
+/* Member data as it was added, into output holding header.size bytes */
+static int read_member_data(const archive_file_t* archive, const archive_member_t* member,
+                            uint8_t* output) {
+    const uint8_t* stored;
+    
+    if (member->data_loaded) {
+        memcpy(output, member->data, member->header.size);
+        return ERROR_SUCCESS;
+    }
+    
+    if (archive_member_is_compressed(member)) {
+        return decompress_member(archive, member, output);
+    }
+    
+    stored = archive_member_data(archive, member);
+    if (stored != NULL) {
+        memcpy(output, stored, member->header.size);
+        return ERROR_SUCCESS;
+    }
+    
+    return archive->map != NULL ? ERROR_ARCHIVE_CORRUPT :
+           copy_member_data(archive, member, NULL, output, member->header.size);
+}
+
+int archive_read_stored(const archive_file_t* archive, const archive_member_t* const* members,
+                        uint8_t* const* buffers, size_t count) {
+    archive_io_request_t* requests;
+    size_t used = 0;
+    size_t i;
+    int result = ERROR_SUCCESS;
+    
+    if (archive == NULL || (count > 0 && (members == NULL || buffers == NULL))) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    requests = malloc(count > 0 ? count * sizeof(archive_io_request_t) : 1);
+    if (requests == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    for (i = 0; result == ERROR_SUCCESS && i < count; i++) {
+        const uint8_t* stored = archive_member_data(archive, members[i]);
+        uint32_t size = archive_stored_size(members[i]);
+        
+        if (members[i]->data_loaded) {
+            result = ERROR_INVALID_ARGUMENT;
+        } else if (stored != NULL) {
+            memcpy(buffers[i], stored, size);
+        } else if (archive->map != NULL) {
+            result = ERROR_ARCHIVE_CORRUPT;
+        } else {
+            requests[used].fd = fileno(archive->file);
+            requests[used].buffer = buffers[i];
+            requests[used].size = size;
+            requests[used].offset = members[i]->header.data_offset;
+            used++;
+        }
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        result = archive_io_read(archive->io, requests, used);
+    }
+    free(requests);
+    
+    return result;
+}
+
+int archive_decode_stored(const archive_file_t* archive, const archive_member_t* member,
+                          const uint8_t* stored, uint8_t* output) {
+    int result;
+    
+    if (archive == NULL || member == NULL || stored == NULL ||
+        (output == NULL && member->header.size > 0)) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    if (!archive_member_is_compressed(member)) {
+        if (output != stored && member->header.size > 0) {
+            memcpy(output, stored, member->header.size);
+        }
+        return ERROR_SUCCESS;
+    }
+    
+    result = decode_member(archive, NULL, member, stored, output);
+    if (result == ERROR_SUCCESS &&
+        archive_calculate_checksum(output, member->header.size) != member->header.checksum) {
+        result = ERROR_ARCHIVE_CORRUPT;
+    }
+    
+    return result;
+}
+
+void archive_set_thread_pool(archive_file_t* archive, thread_pool_t* pool) {
+    if (archive != NULL) {
+        archive->pool = pool;
+    }
+}
+
+int archive_read_member(const archive_file_t* archive, const archive_member_t* member,
+                        uint8_t* output) {
+    if (archive == NULL || member == NULL || (output == NULL && member->header.size > 0)) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    return read_member_data(archive, member, output);
+}
+
+int archive_read_member_range(const archive_file_t* archive, const archive_member_t* member,
+                              uint32_t offset, size_t size, uint8_t* output) {
+    const uint8_t* stored;
+    uint8_t* data;
+    int result;
+    
+    if (archive == NULL || member == NULL || (output == NULL && size > 0) ||
+        (uint64_t)offset + size > member->header.size) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    if (member->data_loaded) {
+        memcpy(output, member->data + offset, size);
+        return ERROR_SUCCESS;
+    }
+    
+    stored = archive_member_data(archive, member);
+    if (stored == NULL && archive->map != NULL) {
+        return ERROR_ARCHIVE_CORRUPT;
+    }
+    
+    if (archive_member_is_blocked(member)) {
+        return read_blocks(archive, archive->pool, member, stored, offset, size, output);
+    }
+    
+    if (!archive_member_is_compressed(member)) {
+        if (stored != NULL) {
+            memcpy(output, stored + offset, size);
+            return ERROR_SUCCESS;
+        }
+        return read_at(archive, output, size, (uint64_t)member->header.data_offset + offset);
+    }
+    
+    /* A member compressed whole has to be decompressed whole */
+    data = malloc(member->header.size > 0 ? member->header.size : 1);
+    if (data == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    result = decompress_member(archive, member, data);
+    if (result == ERROR_SUCCESS) {
+        memcpy(output, data + offset, size);
+    }
+    free(data);
+    
+    return result;
+}
+
+int archive_extract_member(const archive_file_t* archive,
+                          const archive_member_t* member,
+                          const char* output_path) {
+    const uint8_t* stored;
+    uint8_t* data;
+    FILE* output_file;
+    int result = ERROR_SUCCESS;
+    
+    if (archive == NULL || member == NULL || output_path == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    output_file = fopen(output_path, "wb");
+    if (output_file == NULL) {
+        return ERROR_FILE_IO;
+    }
+    
+    /* Uncompressed members on disk are copied without holding them whole */
+    stored = member->data_loaded ? member->data : archive_member_data(archive, member);
+    if (archive_member_is_compressed(member) && !member->data_loaded) {
+        data = malloc(member->header.size > 0 ? member->header.size : 1);
+        result = data == NULL ? ERROR_OUT_OF_MEMORY : decompress_member(archive, member, data);
+        if (result == ERROR_SUCCESS && member->header.size > 0 &&
+            fwrite(data, member->header.size, 1, output_file) != 1) {
+            result = ERROR_FILE_IO;
+        }
+        free(data);
+    } else if (stored != NULL) {
+        if (member->header.size > 0 && fwrite(stored, member->header.size, 1, output_file) != 1) {
+            result = ERROR_FILE_IO;
+        }
+    } else if (archive->map != NULL) {
+        result = ERROR_ARCHIVE_CORRUPT;
+    } else {
+        result = copy_member_data(archive, member, output_file, NULL, member->header.size);
+    }
+    
+    if (fclose(output_file) != 0 && result == ERROR_SUCCESS) {
+        result = ERROR_FILE_IO;
+    }
+    
+    return result;
+}
+
+int archive_extract_member_to_memory(const archive_file_t* archive,
+                                    const archive_member_t* member,
+                                    uint8_t** data,
+                                    size_t* size) {
+    uint8_t* copy;
+    int result;
+    
+    if (archive == NULL || member == NULL || data == NULL || size == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    copy = malloc(member->header.size > 0 ? member->header.size : 1);
+    if (copy == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    result = read_member_data(archive, member, copy);
+    if (result != ERROR_SUCCESS) {
+        free(copy);
+        return result;
+    }
+    
+    *data = copy;
+    *size = member->header.size;
+    
+    return ERROR_SUCCESS;
+}
+
+/* A copy of the shared dictionary, from the mapping or read from the file */
+static int load_dictionary(archive_file_t* archive) {
+    const star_header_t* header = &archive->header;
+    
+    if (header->dictionary_size == 0 || archive->dictionary != NULL) {
+        return ERROR_SUCCESS;
+    }
+    
+    if (archive->map != NULL &&
+        (uint64_t)header->dictionary_offset + header->dictionary_size > archive->map_size) {
+        return ERROR_ARCHIVE_CORRUPT;
+    }
+    
+    archive->dictionary = malloc(header->dictionary_size);
+    if (archive->dictionary == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    if (archive->map != NULL) {
+        memcpy(archive->dictionary, archive->map + header->dictionary_offset,
+               header->dictionary_size);
+        return ERROR_SUCCESS;
+    }
+    
+    return read_at(archive, archive->dictionary, header->dictionary_size,
+                   header->dictionary_offset);
+}
+
+int archive_load_members(archive_file_t* archive) {
+    uint32_t i;
+    star_member_header_t member_header;
+    archive_member_t* member;
+    int result;
+    
+    if (archive == NULL) {
+        return ERROR_SUCCESS;
+    }
+    
+    result = load_dictionary(archive);
+    if (result != ERROR_SUCCESS || archive->header.member_count == 0) {
+        return result;
+    }
+    
+    /* Allocate members array */
     archive->members = malloc(archive->header.member_count * sizeof(archive_member_t));
     if (archive->members == NULL) {
         return ERROR_OUT_OF_MEMORY;
     }
     
-    /* Load string table */
-    if (archive->header.string_table_size > 0) {
-        archive->string_table = malloc(archive->header.string_table_size);
-        if (archive->string_table == NULL) {
-            return ERROR_OUT_OF_MEMORY;
+    /* Load string table */
+    if (archive->header.string_table_size > 0) {
+        archive->string_table = malloc(archive->header.string_table_size);
+        if (archive->string_table == NULL) {
+            return ERROR_OUT_OF_MEMORY;
+        }
+        archive->string_capacity = archive->header.string_table_size;
+        
+        if (fseek(archive->file, (long)archive->header.string_table_offset, SEEK_SET) != 0 ||
+            fread(archive->string_table, archive->header.string_table_size, 1, archive->file) != 1) {
+            return ERROR_FILE_IO;
+        }
+    }
+    
+    /* Load member headers */
+    if (fseek(archive->file, (long)archive->header.member_table_offset, SEEK_SET) != 0) {
+        return ERROR_FILE_IO;
+    }
+    
+    for (i = 0; i < archive->header.member_count; i++) {
+        if (fread(&member_header, sizeof(star_member_header_t), 1, archive->file) != 1) {
+            return ERROR_FILE_IO;
+        }
+        
+        member = &archive->members[i];
+        member->header = member_header;
+        member->index = i;
+        member->data = NULL;
+        member->data_loaded = false;
+        
+        /* Get member name from string table */
+        if (member_header.name_offset < archive->header.string_table_size) {
+            const char* name = &archive->string_table[member_header.name_offset];
+            member->name = malloc(strlen(name) + 1);
+            if (member->name != NULL) {
+                strcpy(member->name, name);
+            }
+        } else {
+            member->name = NULL;
+        }
+    }
+    
+    return index_member_table(archive);
+}
+
+/* Member and string tables must lie inside the file, the strings terminated */
+static bool mapped_tables_valid(const archive_file_t* archive) {
+    const star_header_t* header = &archive->header;
+    
+    if ((uint64_t)header->member_table_offset +
+        (uint64_t)header->member_count * sizeof(star_member_header_t) > archive->map_size ||
+        (uint64_t)header->string_table_offset + header->string_table_size > archive->map_size) {
+        return false;
+    }
+    
+    return header->string_table_size == 0 ||
+           archive->map[header->string_table_offset + header->string_table_size - 1] == '\0';
+}
+
+archive_file_t* archive_map(const char* filename) {
+    archive_file_t* archive;
+    struct stat st;
+    void* map;
+    uint32_t i;
+    
+    archive = archive_open(filename, "rb");
+    if (archive == NULL) {
+        return NULL;
+    }
+    
+    if (fstat(fileno(archive->file), &st) != 0 || st.st_size < (off_t)sizeof(star_header_t)) {
+        archive_close(archive);
+        return NULL;
+    }
+    
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fileno(archive->file), 0);
+    if (map == MAP_FAILED) {
+        archive_close(archive);
+        return NULL;
+    }
+    archive->map = map;
+    archive->map_size = (size_t)st.st_size;
+    
+    if (!mapped_tables_valid(archive)) {
+        archive_close(archive);
+        return NULL;
+    }
+    
+    archive->string_table = (char*)archive->map + archive->header.string_table_offset;
+    archive->string_capacity = archive->header.string_table_size;
+    
+    if (load_dictionary(archive) != ERROR_SUCCESS) {
+        archive_close(archive);
+        return NULL;
+    }
+    
+    if (archive->header.member_count == 0) {
+        return archive;
+    }
+    
+    archive->members = calloc(archive->header.member_count, sizeof(archive_member_t));
+    if (archive->members == NULL) {
+        archive_close(archive);
+        return NULL;
+    }
+    
+    /* Headers are copied out whole; names are used where they lie */
+    for (i = 0; i < archive->header.member_count; i++) {
+        archive_member_t* member = &archive->members[i];
+        
+        memcpy(&member->header, archive->map + archive->header.member_table_offset +
+               (size_t)i * sizeof(star_member_header_t), sizeof(star_member_header_t));
+        member->index = i;
+        if (member->header.name_offset < archive->header.string_table_size) {
+            member->name = archive->string_table + member->header.name_offset;
+        }
+    }
+    
+    if (index_member_table(archive) != ERROR_SUCCESS) {
+        archive_close(archive);
+        return NULL;
+    }
+    
+    return archive;
+}
+
+static int compare_extents(const void* a, const void* b) {
+    const archive_extent_t* left = a;
+    const archive_extent_t* right = b;
+    
+    return (left->offset > right->offset) - (left->offset < right->offset);
+}
+
+/*
+ * Everything the header refers to is live and the gaps between it are
+ * free. The file is treated as ending after the last live byte, so any
+ * tail beyond that is free space too.
+ */
+static int collect_free_space(archive_file_t* archive) {
+    const star_header_t* header = &archive->header;
+    archive_extent_t* live;
+    archive_extent_t* gaps;
+    size_t count = 0;
+    size_t gap_count = 0;
+    uint64_t end = 0;
+    uint64_t extent_end;
+    uint32_t i;
+    size_t j;
+    
+    live = malloc(((size_t)header->member_count + 5) * sizeof(archive_extent_t));
+    gaps = malloc(((size_t)header->member_count + 5) * sizeof(archive_extent_t));
+    if (live == NULL || gaps == NULL) {
+        free(live);
+        free(gaps);
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    live[count++] = (archive_extent_t) {0, sizeof(star_header_t)};
+    live[count++] = (archive_extent_t) {header->member_table_offset,
+                                        header->member_count *
+                                        (uint32_t)sizeof(star_member_header_t)};
+    live[count++] = (archive_extent_t) {header->string_table_offset, header->string_table_size};
+    if (archive_has_index(archive)) {
+        live[count++] = (archive_extent_t) {header->index_offset, header->index_size};
+    }
+    live[count++] = (archive_extent_t) {header->dictionary_offset, header->dictionary_size};
+    for (i = 0; i < header->member_count; i++) {
+        live[count++] = (archive_extent_t) {archive->members[i].header.data_offset,
+                                            archive_stored_size(&archive->members[i])};
+    }
+    qsort(live, count, sizeof(archive_extent_t), compare_extents);
+    
+    for (j = 0; j < count; j++) {
+        if (live[j].size == 0) {
+            continue;
         }
-        
-        if (fseek(archive->file, (long)archive->header.string_table_offset, SEEK_SET) != 0 ||
-            fread(archive->string_table, archive->header.string_table_size, 1, archive->file) != 1) {
-            return ERROR_FILE_IO;
+        if (live[j].offset > end) {
+            gaps[gap_count++] = (archive_extent_t) {(uint32_t)end, (uint32_t)(live[j].offset - end)};
+        }
+        extent_end = (uint64_t)live[j].offset + live[j].size;
+        if (extent_end > end) {
+            end = extent_end;
         }
     }
+    free(live);
     
-    /* Load member headers */
-    if (fseek(archive->file, (long)archive->header.member_table_offset, SEEK_SET) != 0) {
+    if (end > UINT32_MAX) {
+        free(gaps);
+        return ERROR_ARCHIVE_CORRUPT;
+    }
+    
+    free(archive->free_extents);
+    archive->free_extents = gaps;
+    archive->free_count = gap_count;
+    archive->file_end = (uint32_t)end;
+    
+    return ERROR_SUCCESS;
+}
+
+/* The first gap size bytes fit in, else the end of the file */
+static int allocate_space(archive_file_t* archive, uint64_t size, uint32_t* offset) {
+    archive_extent_t* gap;
+    size_t i;
+    
+    for (i = 0; i < archive->free_count && size > 0; i++) {
+        gap = &archive->free_extents[i];
+        if (gap->size >= size) {
+            *offset = gap->offset;
+            gap->offset += (uint32_t)size;
+            gap->size -= (uint32_t)size;
+            return ERROR_SUCCESS;
+        }
+    }
+    
+    if (archive->file_end + size > UINT32_MAX) {
+        return ERROR_OUTPUT_TOO_LARGE;
+    }
+    
+    *offset = archive->file_end;
+    archive->file_end += (uint32_t)size;
+    
+    return ERROR_SUCCESS;
+}
+
+static int write_at(archive_file_t* archive, const void* data, size_t size, uint32_t offset) {
+    if (size > 0 && (fseek(archive->file, (long)offset, SEEK_SET) != 0 ||
+                     fwrite(data, size, 1, archive->file) != 1)) {
         return ERROR_FILE_IO;
     }
     
-    for (i = 0; i < archive->header.member_count; i++) {
-        if (fread(&member_header, sizeof(star_member_header_t), 1, archive->file) != 1) {
-            return ERROR_FILE_IO;
+    return ERROR_SUCCESS;
+}
+
+/* Forget stored data no member refers to any more, which is free space from now on */
+static int dedup_live_members(archive_file_t* archive) {
+    uint32_t i;
+    int result = ERROR_SUCCESS;
+    
+    if (archive->dedup == NULL) {
+        return ERROR_SUCCESS;
+    }
+    
+    free(archive->dedup->slots);
+    archive->dedup->slots = NULL;
+    archive->dedup->slot_count = 0;
+    archive->dedup->count = 0;
+    for (i = 0; i < archive->header.member_count && result == ERROR_SUCCESS; i++) {
+        result = dedup_add(archive->dedup, &archive->members[i].header);
+    }
+    
+    return result;
+}
+
+archive_file_t* archive_open_for_update(const char* filename, const star_options_t* options) {
+    archive_file_t* archive;
+    struct stat st;
+    uint32_t i;
+    int result;
+    
+    archive = archive_open(filename, "r+b");
+    if (archive == NULL) {
+        return NULL;
+    }
+    
+    result = archive_load_members(archive);
+    
+    /* New members are stored the way the archive's first compressed one is */
+    if (options != NULL && options->compression != STAR_COMPRESS_NONE) {
+        archive->compression = options->compression;
+        archive->compression_level = options->compression_level;
+        archive->decode_goal = (uint8_t)options->decode_speed_goal;
+    }
+    for (i = 0; i < archive->header.member_count && archive->compression == STAR_COMPRESS_NONE &&
+         result == ERROR_SUCCESS; i++) {
+        if (archive_member_is_compressed(&archive->members[i])) {
+            archive->compression = (star_compression_t)archive->members[i].header.compression;
+            archive->compression_level = compression_get_default_level(archive->compression);
+        }
+    }
+    if (archive->compression != STAR_COMPRESS_NONE) {
+        archive->header.flags |= STAR_FLAG_COMPRESSED;
+        archive->compression_level = archive->compression == STAR_COMPRESS_AUTO ? -1 :
+                                     compression_normalize_level(archive->compression,
+                                                                 archive->compression_level);
+        archive->block_shift = block_shift_for(options != NULL ? options->block_size :
+                                               STAR_DEFAULT_BLOCK_SIZE);
+    }
+    
+    /* New members may share the data of any member already stored */
+    if (result == ERROR_SUCCESS && options != NULL && options->deduplicate) {
+        archive->dedup = dedup_create();
+        result = archive->dedup != NULL ? dedup_live_members(archive) : ERROR_OUT_OF_MEMORY;
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        result = collect_free_space(archive);
+    }
+    if (result == ERROR_SUCCESS &&
+        (fstat(fileno(archive->file), &st) != 0 || st.st_size < (off_t)archive->file_end)) {
+        result = ERROR_ARCHIVE_CORRUPT;
+    }
+    
+    if (result != ERROR_SUCCESS) {
+        archive_close(archive);
+        return NULL;
+    }
+    archive->is_updating = true;
+    
+    return archive;
+}
+
+/*
+ * A new member at the end of the table, or at its place in a sorted
+ * one, found by name from now on
+ */
+static int append_member(archive_file_t* archive, const char* name, archive_member_t** added) {
+    archive_member_t* members;
+    archive_member_t* member;
+    char* copy;
+    uint32_t count = archive->header.member_count;
+    uint32_t position = count;
+    uint32_t i;
+    
+    if (count >= STAR_MAX_MEMBERS) {
+        return ERROR_SYSTEM_LIMIT;
+    }
+    
+    copy = malloc(strlen(name) + 1);
+    members = copy != NULL ? realloc(archive->members,
+                                     ((size_t)count + 1) * sizeof(archive_member_t)) : NULL;
+    if (members == NULL) {
+        free(copy);
+        return ERROR_OUT_OF_MEMORY;
+    }
+    archive->members = members;
+    strcpy(copy, name);
+    
+    if (archive->members_sorted) {
+        position = sorted_member_position(archive, name);
+        memmove(&members[position + 1], &members[position],
+                (count - position) * sizeof(archive_member_t));
+    }
+    member = &members[position];
+    memset(member, 0, sizeof(archive_member_t));
+    member->name = copy;
+    archive->header.member_count++;
+    for (i = position; i < archive->header.member_count; i++) {
+        members[i].index = i;
+    }
+    
+    *added = member;
+    if (archive->members_sorted) {
+        return ERROR_SUCCESS;
+    }
+    if ((size_t)archive->header.member_count * 2 > archive->member_slot_count) {
+        return index_members(archive);
+    }
+    index_member(archive, count);
+    
+    return ERROR_SUCCESS;
+}
+
+int archive_update_member_from_file(archive_file_t* archive, const char* name,
+                                    const char* file_path) {
+    archive_prepared_member_t prepared;
+    archive_member_t* member;
+    uint32_t offset = 0;
+    int result;
+    
+    if (archive == NULL || name == NULL || file_path == NULL || !archive->is_updating) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    result = archive_prepare_member(archive, file_path, &prepared);
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    /* Space freed by this update is not reused until the next, so shared data stays put */
+    if (prepared.duplicate) {
+        offset = prepared.header.data_offset;
+    } else {
+        result = allocate_space(archive, prepared.header.compressed_size, &offset);
+        if (result == ERROR_SUCCESS) {
+            result = write_at(archive, prepared.stored != NULL ? prepared.stored : prepared.data,
+                              prepared.header.compressed_size, offset);
+        }
+    }
+    
+    member = archive_find_member(archive, name);
+    if (result == ERROR_SUCCESS && member == NULL) {
+        result = append_member(archive, name, &member);
+    }
+    if (result == ERROR_SUCCESS) {
+        store_member_header(&member->header, &prepared.header, offset);
+        if (!prepared.duplicate) {
+            result = dedup_record(archive, &member->header);
+        }
+    }
+    archive_release_prepared_member(&prepared);
+    
+    return result;
+}
+
+int archive_delete_member(archive_file_t* archive, const char* name) {
+    archive_member_t* member;
+    uint32_t index;
+    uint32_t i;
+    
+    if (archive == NULL || name == NULL || !archive->is_updating) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    member = archive_find_member(archive, name);
+    if (member == NULL) {
+        return ERROR_MEMBER_NOT_FOUND;
+    }
+    
+    index = (uint32_t)(member - archive->members);
+    free(member->name);
+    free(member->data);
+    memmove(member, member + 1,
+            (archive->header.member_count - index - 1) * sizeof(archive_member_t));
+    archive->header.member_count--;
+    
+    for (i = index; i < archive->header.member_count; i++) {
+        archive->members[i].index = i;
+    }
+    
+    return archive->members_sorted ? ERROR_SUCCESS : index_members(archive);
+}
+
+/* A fresh string table of the live names, so dead ones do not pile up */
+static int rebuild_string_table(archive_file_t* archive) {
+    uint32_t offset;
+    uint32_t i;
+    int result;
+    
+    free(archive->string_table);
+    free(archive->string_slots);
+    archive->string_table = NULL;
+    archive->string_slots = NULL;
+    archive->string_slot_count = 0;
+    archive->string_count = 0;
+    
+    result = reserve_strings(archive, 0);
+    for (i = 0; i < archive->header.member_count && result == ERROR_SUCCESS; i++) {
+        offset = 0;
+        if (archive->members[i].name != NULL) {
+            result = archive_add_string(archive, archive->members[i].name, &offset);
+        }
+        archive->members[i].header.name_offset = offset;
+    }
+    
+    return result;
+}
+
+int archive_commit_update(archive_file_t* archive) {
+    uint8_t* index_data = NULL;
+    size_t index_size = 0;
+    uint64_t tables_size;
+    uint32_t tables_offset = 0;
+    uint32_t index_offset = 0;
+    int result;
+    
+    if (archive == NULL || !archive->is_updating) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    result = sort_member_table(archive);
+    if (result == ERROR_SUCCESS) {
+        result = rebuild_string_table(archive);
+    }
+    
+    /* The index comes from the members' data, which is read but not rewritten */
+    if (result == ERROR_SUCCESS && archive_has_index(archive)) {
+        result = serialize_symbol_index(archive, &index_data, &index_size);
+    }
+    
+    tables_size = (uint64_t)archive->header.member_count * sizeof(star_member_header_t) +
+                  archive->header.string_table_size;
+    if (result == ERROR_SUCCESS) {
+        result = allocate_space(archive, tables_size, &tables_offset);
+    }
+    if (result == ERROR_SUCCESS && index_data != NULL) {
+        result = allocate_space(archive, index_size, &index_offset);
+    }
+    if (result == ERROR_SUCCESS && index_data != NULL) {
+        result = write_at(archive, index_data, index_size, index_offset);
+    }
+    free(index_data);
+    
+    if (result == ERROR_SUCCESS) {
+        archive->header.member_table_offset = tables_offset;
+        archive->header.string_table_offset = tables_offset + archive->header.member_count *
+                                              (uint32_t)sizeof(star_member_header_t);
+        archive->header.index_offset = archive_has_index(archive) ? index_offset : 0;
+        archive->header.index_size = archive_has_index(archive) ? (uint32_t)index_size : 0;
+        result = write_member_tables(archive);
+    }
+    
+    /* Only now does the archive on disk change */
+    if (result == ERROR_SUCCESS) {
+        result = store_header(archive);
+    }
+    if (result == ERROR_SUCCESS && fflush(archive->file) != 0) {
+        result = ERROR_FILE_IO;
+    }
+    
+    /* Drop whatever now lies past the last live byte */
+    if (result == ERROR_SUCCESS) {
+        result = collect_free_space(archive);
+    }
+    if (result == ERROR_SUCCESS) {
+        result = dedup_live_members(archive);
+    }
+    if (result == ERROR_SUCCESS && ftruncate(fileno(archive->file), archive->file_end) != 0) {
+        result = ERROR_FILE_IO;
+    }
+    
+    return result;
+}
+
+uint64_t archive_free_space(const archive_file_t* archive) {
+    uint64_t total = 0;
+    size_t i;
+    
+    if (archive == NULL) {
+        return 0;
+    }
+    
+    for (i = 0; i < archive->free_count; i++) {
+        total += archive->free_extents[i].size;
+    }
+    
+    return total;
+}
+
+/* A member by where its data starts, to find the members sharing it */
+typedef struct member_offset {
+    uint32_t offset;
+    uint32_t index;
+} member_offset_t;
+
+static int compare_member_offsets(const void* a, const void* b) {
+    const member_offset_t* left = a;
+    const member_offset_t* right = b;
+    
+    if (left->offset != right->offset) {
+        return (left->offset > right->offset) - (left->offset < right->offset);
+    }
+    return (left->index > right->index) - (left->index < right->index);
+}
+
+/* The first member whose data starts at offset */
+static uint32_t first_sharing(const member_offset_t* offsets, size_t count, uint32_t offset) {
+    size_t low = 0;
+    size_t high = count;
+    size_t middle;
+    
+    while (low < high) {
+        middle = low + (high - low) / 2;
+        if (offsets[middle].offset < offset) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    
+    return offsets[low].index;
+}
+
+/*
+ * Stored bytes are copied as they are, so nothing is recompressed, and
+ * members that share their data in the source share the one copy
+ */
+static int copy_live_members(archive_file_t* output, const archive_file_t* source) {
+    const char** names;
+    member_offset_t* offsets;
+    star_member_header_t* header;
+    uint32_t name_offset;
+    uint32_t size;
+    uint32_t first;
+    uint32_t i;
+    bool shared;
+    int result;
+    
+    names = malloc(source->header.member_count * sizeof(const char*));
+    offsets = malloc(source->header.member_count * sizeof(member_offset_t));
+    if (names == NULL || offsets == NULL) {
+        free(names);
+        free(offsets);
+        return ERROR_OUT_OF_MEMORY;
+    }
+    for (i = 0; i < source->header.member_count; i++) {
+        names[i] = source->members[i].name != NULL ? source->members[i].name : "";
+        offsets[i] = (member_offset_t) {source->members[i].header.data_offset, i};
+    }
+    result = archive_reserve_members(output, names, source->header.member_count);
+    free(names);
+    qsort(offsets, source->header.member_count, sizeof(member_offset_t), compare_member_offsets);
+    
+    /* Members compressed against the dictionary still need it */
+    if (result == ERROR_SUCCESS && source->dictionary != NULL) {
+        result = archive_set_dictionary(output, source->dictionary,
+                                        source->header.dictionary_size);
+    }
+    
+    for (i = 0; i < source->header.member_count && result == ERROR_SUCCESS; i++) {
+        size = archive_stored_size(&source->members[i]);
+        first = first_sharing(offsets, source->header.member_count,
+                              source->members[i].header.data_offset);
+        shared = first < i && size > 0 && archive_stored_size(&source->members[first]) == size;
+        if (shared) {
+            /* Already copied */
+        } else if (archive_member_data(source, &source->members[i]) == NULL) {
+            result = ERROR_ARCHIVE_CORRUPT;
+        } else if ((uint64_t)output->stream_offset + size > UINT32_MAX) {
+            result = ERROR_OUTPUT_TOO_LARGE;
+        } else if (size > 0 && fwrite(archive_member_data(source, &source->members[i]), size, 1,
+                                      output->file) != 1) {
+            result = ERROR_FILE_IO;
         }
         
-        member = &archive->members[i];
-        member->header = member_header;
-        member->index = i;
-        member->data = NULL;
-        member->data_loaded = false;
-        
-        /* Get member name from string table */
-        if (member_header.name_offset < archive->header.string_table_size) {
-            const char* name = &archive->string_table[member_header.name_offset];
-            member->name = malloc(strlen(name) + 1);
-            if (member->name != NULL) {
-                strcpy(member->name, name);
+        if (result == ERROR_SUCCESS) {
+            header = &output->members[i].header;
+            name_offset = header->name_offset;
+            *header = source->members[i].header;
+            header->name_offset = name_offset;
+            if (shared) {
+                header->data_offset = output->members[first].header.data_offset;
+            } else {
+                header->data_offset = output->stream_offset;
+                output->stream_offset += size;
             }
-        } else {
-            member->name = NULL;
         }
     }
+    free(offsets);
     
-    return ERROR_SUCCESS;
+    return result;
+}
+
+int archive_compact(const char* filename, const char* output_filename) {
+    archive_file_t* source;
+    archive_file_t* output;
+    int result = ERROR_SUCCESS;
+    
+    if (filename == NULL || output_filename == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    source = archive_map(filename);
+    if (source == NULL) {
+        return ERROR_ARCHIVE_CORRUPT;
+    }
+    
+    output = archive_create(output_filename, NULL);
+    if (output == NULL) {
+        archive_close(source);
+        return ERROR_FILE_IO;
+    }
+    output->header.flags = source->header.flags & (uint16_t)~STAR_FLAG_DICTIONARY;
+    output->header.creation_time = source->header.creation_time;
+    
+    if (source->header.member_count > 0) {
+        result = copy_live_members(output, source);
+    }
+    if (result == ERROR_SUCCESS) {
+        result = archive_finalize(output);
+    }
+    
+    archive_close(output);
+    archive_close(source);
+    
+    return result;
 }
 
 void archive_get_member_info(const archive_member_t* member, star_member_info_t* info) {
@@ -0,0 +1,406 @@
+/* src/star/archive_io.c */
+#include "archive_io.h"
+#include "../common/include/error.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifdef ENABLE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+/**
+ * @file archive_io.c
+ * @brief Batched positional I/O backends
+ * @details Every backend transfers requests in full, resuming after
+ * short transfers and EINTR. The io_uring backend drives the ring
+ * through the raw system calls, so it needs the kernel headers but no
+ * library; a kernel or sandbox that refuses io_uring_setup simply gets
+ * the vectored backend.
+ */
+
+#ifdef ENABLE_IO_URING
+/* The kernel's rings, mapped into our address space */
+typedef struct archive_io_ring {
+    int fd;
+    unsigned entries;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_sqe* sqes;
+    struct io_uring_cqe* cqes;
+    void* sq_map;
+    size_t sq_map_size;
+    void* cq_map;
+    size_t cq_map_size;
+    size_t sqes_size;
+} archive_io_ring_t;
+#endif
+
+struct archive_io {
+    star_io_backend_t backend;
+#ifdef ENABLE_IO_URING
+    pthread_mutex_t mutex;              /* A ring has one submitter at a time */
+    archive_io_ring_t ring;
+#endif
+};
+
+/*
+ * Transfer count buffers that lie back to back from offset in fd,
+ * resuming after short transfers; vectors are used up on the way
+ */
+static int transfer_vectors(int fd, struct iovec* vectors, int count, uint64_t offset,
+                            bool write) {
+    ssize_t bytes;
+    
+    while (count > 0) {
+        bytes = write ? pwritev(fd, vectors, count, (off_t)offset) :
+                        preadv(fd, vectors, count, (off_t)offset);
+        if (bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes <= 0) {
+            return ERROR_FILE_IO;
+        }
+        
+        offset += (uint64_t)bytes;
+        while (count > 0 && (size_t)bytes >= vectors->iov_len) {
+            bytes -= (ssize_t)vectors->iov_len;
+            vectors++;
+            count--;
+        }
+        if (count > 0) {
+            vectors->iov_base = (uint8_t*)vectors->iov_base + bytes;
+            vectors->iov_len -= (size_t)bytes;
+        }
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+/* One call per request, or per run of requests adjacent in the same file when merging */
+static int transfer_runs(const archive_io_request_t* requests, size_t count, bool merge,
+                         bool write) {
+    struct iovec vectors[ARCHIVE_IO_MAX_VECTORS];
+    uint64_t start;
+    uint64_t end;
+    size_t i = 0;
+    int used;
+    int fd;
+    int result = ERROR_SUCCESS;
+    
+    while (result == ERROR_SUCCESS && i < count) {
+        fd = requests[i].fd;
+        start = requests[i].offset;
+        end = start;
+        used = 0;
+        do {
+            if (requests[i].size > 0) {
+                vectors[used].iov_base = requests[i].buffer;
+                vectors[used].iov_len = requests[i].size;
+                used++;
+                end += requests[i].size;
+            }
+            i++;
+        } while (merge && i < count && used < ARCHIVE_IO_MAX_VECTORS &&
+                 (requests[i].size == 0 || (requests[i].fd == fd && requests[i].offset == end)));
+        
+        result = transfer_vectors(fd, vectors, used, start, write);
+    }
+    
+    return result;
+}
+
+#ifdef ENABLE_IO_URING
+/* A ring field at a byte offset the kernel gave */
+#define RING_FIELD(map, offset) ((unsigned*)(void*)((uint8_t*)(map) + (offset)))
+
+static void ring_close(archive_io_ring_t* ring) {
+    if (ring->sqes != NULL) {
+        munmap(ring->sqes, ring->sqes_size);
+    }
+    if (ring->cq_map != NULL) {
+        munmap(ring->cq_map, ring->cq_map_size);
+    }
+    if (ring->sq_map != NULL) {
+        munmap(ring->sq_map, ring->sq_map_size);
+    }
+    if (ring->fd >= 0) {
+        close(ring->fd);
+    }
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+}
+
+static void* ring_map(int fd, size_t size, off_t offset) {
+    void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, offset);
+    
+    return map == MAP_FAILED ? NULL : map;
+}
+
+static bool ring_open(archive_io_ring_t* ring) {
+    struct io_uring_params params;
+    
+    memset(ring, 0, sizeof(*ring));
+    memset(&params, 0, sizeof(params));
+    ring->fd = (int)syscall(__NR_io_uring_setup, ARCHIVE_IO_RING_ENTRIES, &params);
+    if (ring->fd < 0) {
+        ring->fd = -1;
+        return false;
+    }
+    
+    ring->entries = params.sq_entries;
+    ring->sq_map_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sq_map = ring_map(ring->fd, ring->sq_map_size, (off_t)IORING_OFF_SQ_RING);
+    ring->cq_map = ring_map(ring->fd, ring->cq_map_size, (off_t)IORING_OFF_CQ_RING);
+    ring->sqes = ring_map(ring->fd, ring->sqes_size, (off_t)IORING_OFF_SQES);
+    if (ring->sq_map == NULL || ring->cq_map == NULL || ring->sqes == NULL) {
+        ring_close(ring);
+        return false;
+    }
+    
+    ring->sq_tail = RING_FIELD(ring->sq_map, params.sq_off.tail);
+    ring->sq_mask = RING_FIELD(ring->sq_map, params.sq_off.ring_mask);
+    ring->sq_array = RING_FIELD(ring->sq_map, params.sq_off.array);
+    ring->cq_head = RING_FIELD(ring->cq_map, params.cq_off.head);
+    ring->cq_tail = RING_FIELD(ring->cq_map, params.cq_off.tail);
+    ring->cq_mask = RING_FIELD(ring->cq_map, params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(void*)((uint8_t*)ring->cq_map + params.cq_off.cqes);
+    
+    return true;
+}
+
+/* Queue the rest of request index, described by its vector and offset */
+static void ring_queue(archive_io_ring_t* ring, int fd, const struct iovec* vector,
+                       uint64_t offset, size_t index, bool write) {
+    unsigned tail = *ring->sq_tail;
+    unsigned slot = tail & *ring->sq_mask;
+    struct io_uring_sqe* sqe = &ring->sqes[slot];
+    
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = (uint8_t)(write ? IORING_OP_WRITEV : IORING_OP_READV);
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)vector;
+    sqe->len = 1;
+    sqe->off = offset;
+    sqe->user_data = (uint64_t)index;
+    ring->sq_array[slot] = slot;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * Keep up to the ring's size of requests in flight, requeueing the rest
+ * of any short transfer. After a failure nothing new is queued, but what
+ * is in flight is still waited for, since the kernel owns those buffers.
+ */
+static int ring_transfer(archive_io_ring_t* ring, const archive_io_request_t* requests,
+                         size_t count, bool write) {
+    struct iovec* vectors = malloc(count * sizeof(struct iovec));
+    uint64_t* offsets = malloc(count * sizeof(uint64_t));
+    struct io_uring_cqe* cqe;
+    unsigned pending = 0;
+    unsigned in_flight = 0;
+    unsigned head;
+    size_t next = 0;
+    size_t index;
+    long submitted;
+    int result = ERROR_SUCCESS;
+    
+    if (vectors == NULL || offsets == NULL) {
+        free(vectors);
+        free(offsets);
+        return transfer_runs(requests, count, true, write);
+    }
+    
+    while ((result == ERROR_SUCCESS && next < count) || in_flight > 0) {
+        while (result == ERROR_SUCCESS && next < count && in_flight < ring->entries) {
+            if (requests[next].size > 0) {
+                vectors[next].iov_base = requests[next].buffer;
+                vectors[next].iov_len = requests[next].size;
+                offsets[next] = requests[next].offset;
+                ring_queue(ring, requests[next].fd, &vectors[next], offsets[next], next, write);
+                pending++;
+                in_flight++;
+            }
+            next++;
+        }
+        if (in_flight == 0) {
+            break;
+        }
+        
+        submitted = syscall(__NR_io_uring_enter, ring->fd, pending, 1, IORING_ENTER_GETEVENTS,
+                            NULL, 0);
+        if (submitted < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            /* The kernel took none of the pending entries: withdraw them */
+            result = ERROR_FILE_IO;
+            __atomic_store_n(ring->sq_tail, *ring->sq_tail - pending, __ATOMIC_RELEASE);
+            in_flight -= pending;
+            pending = 0;
+            if (in_flight == 0) {
+                break;
+            }
+            continue;
+        }
+        if (submitted > 0) {
+            pending -= (unsigned)submitted;
+        }
+        
+        head = *ring->cq_head;
+        while (head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+            cqe = &ring->cqes[head & *ring->cq_mask];
+            index = (size_t)cqe->user_data;
+            head++;
+            in_flight--;
+            
+            if (cqe->res > 0) {
+                offsets[index] += (uint64_t)cqe->res;
+                vectors[index].iov_base = (uint8_t*)vectors[index].iov_base + cqe->res;
+                vectors[index].iov_len -= (size_t)cqe->res;
+            } else if (cqe->res != -EINTR && cqe->res != -EAGAIN) {
+                result = ERROR_FILE_IO;
+            }
+            /* Requeue the rest of a short transfer, or one that was interrupted */
+            if (result == ERROR_SUCCESS && vectors[index].iov_len > 0) {
+                ring_queue(ring, requests[index].fd, &vectors[index], offsets[index], index,
+                           write);
+                pending++;
+                in_flight++;
+            }
+        }
+        __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    }
+    
+    free(vectors);
+    free(offsets);
+    
+    return result;
+}
+#endif
+
+archive_io_t* archive_io_create(star_io_backend_t backend) {
+    archive_io_t* io = calloc(1, sizeof(archive_io_t));
+    
+    if (io == NULL) {
+        return NULL;
+    }
+    
+    io->backend = backend == STAR_IO_PREAD ? STAR_IO_PREAD : STAR_IO_VECTORED;
+#ifdef ENABLE_IO_URING
+    pthread_mutex_init(&io->mutex, NULL);
+    io->ring.fd = -1;
+    if ((backend == STAR_IO_DEFAULT || backend == STAR_IO_URING) && ring_open(&io->ring)) {
+        io->backend = STAR_IO_URING;
+    }
+#endif
+
+    return io;
+}
+
+void archive_io_destroy(archive_io_t* io) {
+    if (io == NULL) {
+        return;
+    }
+
+#ifdef ENABLE_IO_URING
+    if (io->backend == STAR_IO_URING) {
+        ring_close(&io->ring);
+    }
+    pthread_mutex_destroy(&io->mutex);
+#endif
+    free(io);
+}
+
+star_io_backend_t archive_io_get_backend(const archive_io_t* io) {
+    return io != NULL ? io->backend : STAR_IO_VECTORED;
+}
+
+bool archive_io_backend_is_available(star_io_backend_t backend) {
+#ifdef ENABLE_IO_URING
+    archive_io_ring_t ring;
+#endif
+
+    switch (backend) {
+        case STAR_IO_DEFAULT:
+        case STAR_IO_PREAD:
+        case STAR_IO_VECTORED:
+            return true;
+        case STAR_IO_URING:
+#ifdef ENABLE_IO_URING
+            if (ring_open(&ring)) {
+                ring_close(&ring);
+                return true;
+            }
+#endif
+            return false;
+        default:
+            return false;
+    }
+}
+
+const char* archive_io_backend_to_string(star_io_backend_t backend) {
+    switch (backend) {
+        case STAR_IO_DEFAULT:  return "default";
+        case STAR_IO_PREAD:    return "pread";
+        case STAR_IO_VECTORED: return "vectored";
+        case STAR_IO_URING:    return "io_uring";
+        default:               return "unknown";
+    }
+}
+
+star_io_backend_t archive_io_backend_from_string(const char* name) {
+    if (name != NULL) {
+        if (strcmp(name, "pread") == 0) {
+            return STAR_IO_PREAD;
+        }
+        if (strcmp(name, "vectored") == 0) {
+            return STAR_IO_VECTORED;
+        }
+        if (strcmp(name, "io_uring") == 0) {
+            return STAR_IO_URING;
+        }
+    }
+    
+    return STAR_IO_DEFAULT;
+}
+
+/* A single request gains nothing from a ring, and needs no lock without one */
+static int transfer(archive_io_t* io, const archive_io_request_t* requests, size_t count,
+                    bool write) {
+    int result;
+    
+    if (requests == NULL && count > 0) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+
+#ifdef ENABLE_IO_URING
+    if (io != NULL && io->backend == STAR_IO_URING && count > 1 &&
+        pthread_mutex_trylock(&io->mutex) == 0) {
+        result = ring_transfer(&io->ring, requests, count, write);
+        pthread_mutex_unlock(&io->mutex);
+        return result;
+    }
+#endif
+
+    result = transfer_runs(requests, count, io == NULL || io->backend != STAR_IO_PREAD, write);
+    
+    return result;
+}
+
+int archive_io_read(archive_io_t* io, const archive_io_request_t* requests, size_t count) {
+    return transfer(io, requests, count, false);
+}
+
+int archive_io_write(archive_io_t* io, const archive_io_request_t* requests, size_t count) {
+    return transfer(io, requests, count, true);
+}
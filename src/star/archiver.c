@@ -1,10 +1,16 @@
 /* src/star/archiver.c */
 #include "star.h"
 #include "archive.h"
+#include "archive_io.h"
+#include "compress.h"
 #include "error.h"
+#include "../common/include/thread_pool.h"
+#include "../common/include/trace.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <pthread.h>
+#include <sys/stat.h>
 
 /**
  * @file archiver.c
@@ -17,8 +23,48 @@ struct star_context {
     star_options_t options;
     star_progress_callback_t progress_callback;
     void* progress_user_data;
+    archive_file_t* mapped;         /* Archive last read into memory */
+    char* mapped_path;
+    struct stat mapped_stat;        /* File as it was when mapped */
+    uint8_t* member_data;           /* Last compressed member read into memory */
+    thread_pool_t* pool;            /* Worker threads, created on first use */
 };
 
+/* Compressed members held per worker thread ahead of the writer */
+#define STAR_PIPELINE_DEPTH 2
+
+/* Extraction batch bounds, the size one when max_memory sets none */
+#define STAR_EXTRACT_BATCH_SIZE    ((size_t)64 * 1024 * 1024)
+#define STAR_EXTRACT_BATCH_MEMBERS 128
+
+/* One member on its way through the create pipeline */
+typedef struct pipeline_slot {
+    archive_prepared_member_t prepared;
+    bool ready;                     /* Prepared and waiting for the writer */
+} pipeline_slot_t;
+
+/*
+ * Parallel archive creation. Worker tasks read and compress members into
+ * a ring of slots; whichever thread finds the next member in list order
+ * ready takes the writer role and appends ready members until it reaches
+ * one still being compressed. A task waits while its slot is still held
+ * by a member the writer has not reached, which bounds memory to the
+ * ring however far the compressors run ahead.
+ */
+typedef struct create_pipeline {
+    star_context_t* context;
+    archive_file_t* archive;
+    const char* const* file_list;
+    size_t file_count;
+    pipeline_slot_t* slots;
+    size_t slot_count;
+    size_t written;                 /* Members appended so far */
+    bool writing;                   /* A thread holds the writer role */
+    int result;                     /* First failure, stops the pipeline */
+    pthread_mutex_t mutex;
+    pthread_cond_t advanced;        /* Signalled when written or result changes */
+} create_pipeline_t;
+
 star_options_t star_get_default_options(void) {
     star_options_t options = {
         .compression = STAR_COMPRESS_NONE,
@@ -28,7 +74,13 @@ star_options_t star_get_default_options(void) {
         .verbose = false,
         .force_overwrite = false,
         .max_memory = 0,
-        .temp_dir = NULL
+        .temp_dir = NULL,
+        .threads = 0,
+        .block_size = STAR_DEFAULT_BLOCK_SIZE,
+        .dictionary_size = 0,
+        .decode_speed_goal = 50,
+        .deduplicate = false,
+        .io_backend = STAR_IO_DEFAULT
     };
     
     return options;
@@ -41,7 +93,7 @@ bool star_validate_options(const star_options_t* options) {
     
     /* Basic validation */
     if (options->compression < STAR_COMPRESS_NONE || 
-        options->compression > STAR_COMPRESS_LZMA) {
+        options->compression > STAR_COMPRESS_AUTO) {
         return false;
     }
     
@@ -49,6 +101,20 @@ bool star_validate_options(const star_options_t* options) {
         return false;
     }
     
+    if (options->block_size != 0 &&
+        (options->block_size < STAR_MIN_BLOCK_SIZE || options->block_size > STAR_MAX_BLOCK_SIZE ||
+         (options->block_size & (options->block_size - 1)) != 0)) {
+        return false;
+    }
+    
+    if (options->dictionary_size > STAR_MAX_DICTIONARY_SIZE) {
+        return false;
+    }
+    
+    if (options->decode_speed_goal < 0 || options->decode_speed_goal > 100) {
+        return false;
+    }
+    
     return true;
 }
 
@@ -67,12 +133,26 @@ star_context_t* star_context_create(const star_options_t* options) {
     
     context->progress_callback = NULL;
     context->progress_user_data = NULL;
+    context->mapped = NULL;
+    context->mapped_path = NULL;
+    context->member_data = NULL;
+    context->pool = NULL;
     
     return context;
 }
 
+static void unmap_archive(star_context_t* context) {
+    archive_close(context->mapped);
+    free(context->mapped_path);
+    context->mapped = NULL;
+    context->mapped_path = NULL;
+}
+
 void star_context_destroy(star_context_t* context) {
     if (context != NULL) {
+        unmap_archive(context);
+        free(context->member_data);
+        thread_pool_destroy(context->pool);
         free(context);
     }
 }
@@ -86,11 +166,137 @@ void star_set_progress_callback(star_context_t* context,
     }
 }
 
+static thread_pool_t* get_thread_pool(star_context_t* context) {
+    if (context->pool == NULL && context->options.threads != 1) {
+        /* A failed pool is not fatal: work falls back to serial */
+        context->pool = thread_pool_create(context->options.threads);
+    }
+    
+    return context->pool;
+}
+
+static void report_added(const star_context_t* context, size_t added, size_t total) {
+    if (context->progress_callback != NULL) {
+        int progress = (int)(added * 90 / total);
+        context->progress_callback("Adding files", progress, context->progress_user_data);
+    }
+}
+
+/* Append ready members in order; called with the mutex held and returns with it held */
+static void write_ready_members(create_pipeline_t* pipeline) {
+    pipeline_slot_t* slot = &pipeline->slots[pipeline->written % pipeline->slot_count];
+    int result;
+    
+    pipeline->writing = true;
+    while (pipeline->result == ERROR_SUCCESS && pipeline->written < pipeline->file_count &&
+           slot->ready) {
+        pthread_mutex_unlock(&pipeline->mutex);
+        result = archive_stream_prepared_member(pipeline->archive, (uint32_t)pipeline->written,
+                                                &slot->prepared);
+        if (result == ERROR_SUCCESS) {
+            report_added(pipeline->context, pipeline->written + 1, pipeline->file_count);
+        }
+        pthread_mutex_lock(&pipeline->mutex);
+        
+        slot->ready = false;
+        if (result != ERROR_SUCCESS) {
+            pipeline->result = result;
+        } else {
+            pipeline->written++;
+        }
+        pthread_cond_broadcast(&pipeline->advanced);
+        slot = &pipeline->slots[pipeline->written % pipeline->slot_count];
+    }
+    pipeline->writing = false;
+}
+
+static int pipeline_member_task(void* user_data, size_t index) {
+    create_pipeline_t* pipeline = user_data;
+    pipeline_slot_t* slot = &pipeline->slots[index % pipeline->slot_count];
+    archive_prepared_member_t prepared;
+    int result;
+    
+    pthread_mutex_lock(&pipeline->mutex);
+    while (pipeline->result == ERROR_SUCCESS &&
+           index >= pipeline->written + pipeline->slot_count) {
+        pthread_cond_wait(&pipeline->advanced, &pipeline->mutex);
+    }
+    result = pipeline->result;
+    pthread_mutex_unlock(&pipeline->mutex);
+    
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    result = archive_prepare_member(pipeline->archive, pipeline->file_list[index], &prepared);
+    
+    pthread_mutex_lock(&pipeline->mutex);
+    if (result != ERROR_SUCCESS) {
+        if (pipeline->result == ERROR_SUCCESS) {
+            pipeline->result = result;
+        }
+        pthread_cond_broadcast(&pipeline->advanced);
+    } else if (pipeline->result != ERROR_SUCCESS) {
+        archive_release_prepared_member(&prepared);
+        result = pipeline->result;
+    } else {
+        slot->prepared = prepared;
+        slot->ready = true;
+        if (!pipeline->writing && index == pipeline->written) {
+            write_ready_members(pipeline);
+        }
+        result = pipeline->result;
+    }
+    pthread_mutex_unlock(&pipeline->mutex);
+    
+    return result;
+}
+
+static int stream_members_parallel(star_context_t* context, archive_file_t* archive,
+                                   thread_pool_t* pool, const char* const* file_list,
+                                   size_t file_count) {
+    create_pipeline_t pipeline;
+    size_t i;
+    int result;
+    
+    memset(&pipeline, 0, sizeof(pipeline));
+    pipeline.context = context;
+    pipeline.archive = archive;
+    pipeline.file_list = file_list;
+    pipeline.file_count = file_count;
+    pipeline.slot_count = thread_pool_get_thread_count(pool) * STAR_PIPELINE_DEPTH;
+    pipeline.slots = calloc(pipeline.slot_count, sizeof(pipeline_slot_t));
+    if (pipeline.slots == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    pthread_mutex_init(&pipeline.mutex, NULL);
+    pthread_cond_init(&pipeline.advanced, NULL);
+    
+    result = thread_pool_run(pool, file_count, pipeline_member_task, &pipeline);
+    if (pipeline.result != ERROR_SUCCESS) {
+        result = pipeline.result;
+    }
+    
+    /* Members compressed after a failure were never written */
+    for (i = 0; i < pipeline.slot_count; i++) {
+        archive_release_prepared_member(&pipeline.slots[i].prepared);
+    }
+    
+    pthread_cond_destroy(&pipeline.advanced);
+    pthread_mutex_destroy(&pipeline.mutex);
+    free(pipeline.slots);
+    
+    return result;
+}
+
 int star_create_archive(star_context_t* context,
                        const char* archive_path,
                        const char* const* file_list,
                        size_t file_count) {
     archive_file_t* archive;
+    thread_pool_t* pool = NULL;
+    trace_span_t span;
     size_t i;
     int result;
     
@@ -98,6 +304,12 @@ int star_create_archive(star_context_t* context,
         return ERROR_INVALID_ARGUMENT;
     }
     
+    if (context->options.compression != STAR_COMPRESS_AUTO &&
+        !compression_is_available(context->options.compression)) {
+        ERROR_REPORT_ERROR(ERROR_COMPRESSION_FAILED, "Compression algorithm not available");
+        return ERROR_COMPRESSION_FAILED;
+    }
+    
     /* Report progress */
     if (context->progress_callback != NULL) {
         context->progress_callback("Creating archive", 0, context->progress_user_data);
@@ -109,24 +321,49 @@ int star_create_archive(star_context_t* context,
         return ERROR_FILE_IO;
     }
     
-    /* Add files to archive */
-    for (i = 0; i < file_count; i++) {
-        result = archive_add_member_from_file(archive, file_list[i], file_list[i]);
-        if (result != ERROR_SUCCESS) {
-            archive_close(archive);
-            return result;
-        }
-        
-        /* Report progress */
-        if (context->progress_callback != NULL) {
-            int progress = (int)((i + 1) * 90 / file_count);
-            context->progress_callback("Adding files", progress, context->progress_user_data);
+    /* Stream files into the archive; only one chunk is in memory at a time */
+    result = archive_reserve_members(archive, file_list, file_count);
+    
+    /* Small members share most of their content; a dictionary lets them refer to it */
+    if (result == ERROR_SUCCESS) {
+        result = archive_train_dictionary(archive, file_list, file_count);
+    }
+    if (result != ERROR_SUCCESS) {
+        archive_close(archive);
+        return result;
+    }
+    
+    /* Copying is I/O bound; only compression is worth spreading over threads */
+    if (context->options.compression != STAR_COMPRESS_NONE && file_count > 1) {
+        pool = get_thread_pool(context);
+    }
+    
+    TRACE_BEGIN(span, "add_members");
+    if (thread_pool_is_parallel(pool)) {
+        result = stream_members_parallel(context, archive, pool, file_list, file_count);
+    } else {
+        for (i = 0; result == ERROR_SUCCESS && i < file_count; i++) {
+            result = archive_stream_member_from_file(archive, (uint32_t)i, file_list[i]);
+            if (result == ERROR_SUCCESS) {
+                report_added(context, i + 1, file_count);
+            }
         }
     }
+    TRACE_END(span, archive_path);
     
-    /* Finalize archive */
+    if (result != ERROR_SUCCESS) {
+        archive_close(archive);
+        return result;
+    }
+    
+    /* Finalize archive, indexing the members on the pool */
+    if (context->options.create_index && file_count > 1) {
+        archive_set_thread_pool(archive, get_thread_pool(context));
+    }
+    TRACE_BEGIN(span, "finalize_archive");
     result = archive_finalize(archive);
     archive_close(archive);
+    TRACE_END(span, archive_path);
     
     if (context->progress_callback != NULL) {
         context->progress_callback("Archive creation complete", 100, context->progress_user_data);
@@ -135,16 +372,189 @@ int star_create_archive(star_context_t* context,
     return result;
 }
 
+/*
+ * Batched extraction. Members go in batches of up to
+ * STAR_EXTRACT_BATCH_MEMBERS whose stored and decoded data fit in
+ * max_memory (STAR_EXTRACT_BATCH_SIZE without a limit): the batch's
+ * stored bytes are read as one batch on the archive's I/O backend,
+ * decoded in parallel on the pool, and written to their files as one
+ * batch again, so a backend that keeps requests in flight saves a round
+ * trip per member. A member larger than the whole budget is extracted
+ * on its own, an uncompressed one a chunk at a time.
+ */
+typedef struct extract_job {
+    star_context_t* context;
+    const archive_file_t* archive;
+    const archive_member_t** members;
+    const char* output_dir;
+    size_t count;
+    size_t memory_limit;            /* Data held by one batch at most */
+    const archive_member_t** batch; /* Members of the current batch */
+    uint8_t** stored;               /* Their stored bytes */
+    uint8_t** data;                 /* Their data, the stored bytes if uncompressed */
+} extract_job_t;
+
+static void output_path_for(const extract_job_t* job, const archive_member_t* member,
+                            char* output_path, size_t size) {
+    if (job->output_dir != NULL) {
+        snprintf(output_path, size, "%s/%s", job->output_dir, member->name);
+    } else {
+        strncpy(output_path, member->name, size - 1);
+        output_path[size - 1] = '\0';
+    }
+}
+
+/* Memory a member takes in a batch */
+static size_t batch_memory(const archive_member_t* member) {
+    return (size_t)archive_stored_size(member) +
+           (archive_member_is_compressed(member) ? member->header.size : 0);
+}
+
+static int decode_member_task(void* user_data, size_t index) {
+    extract_job_t* job = user_data;
+    const archive_member_t* member = job->batch[index];
+    
+    if (!archive_member_is_compressed(member)) {
+        job->data[index] = job->stored[index];
+        return ERROR_SUCCESS;
+    }
+    
+    job->data[index] = malloc(member->header.size > 0 ? member->header.size : 1);
+    if (job->data[index] == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    return archive_decode_stored(job->archive, member, job->stored[index], job->data[index]);
+}
+
+/* Create the batch's files and write them as one batch */
+static int write_batch(extract_job_t* job, size_t count) {
+    archive_io_request_t* requests = calloc(count, sizeof(archive_io_request_t));
+    FILE** files = calloc(count, sizeof(FILE*));
+    char output_path[1024];
+    size_t i;
+    int result = ERROR_SUCCESS;
+    
+    if (requests == NULL || files == NULL) {
+        result = ERROR_OUT_OF_MEMORY;
+    }
+    
+    for (i = 0; result == ERROR_SUCCESS && i < count; i++) {
+        output_path_for(job, job->batch[i], output_path, sizeof(output_path));
+        files[i] = fopen(output_path, "wb");
+        if (files[i] == NULL) {
+            result = ERROR_FILE_IO;
+        } else {
+            requests[i].fd = fileno(files[i]);
+            requests[i].buffer = job->data[i];
+            requests[i].size = job->batch[i]->header.size;
+            requests[i].offset = 0;
+        }
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        result = archive_io_write(job->archive->io, requests, count);
+    }
+    
+    for (i = 0; files != NULL && i < count; i++) {
+        if (files[i] != NULL && fclose(files[i]) != 0 && result == ERROR_SUCCESS) {
+            result = ERROR_FILE_IO;
+        }
+    }
+    free(files);
+    free(requests);
+    
+    return result;
+}
+
+static int extract_batch(extract_job_t* job, thread_pool_t* pool, size_t first, size_t count) {
+    size_t i;
+    int result = ERROR_SUCCESS;
+    
+    job->batch = &job->members[first];
+    job->stored = calloc(count, sizeof(uint8_t*));
+    job->data = calloc(count, sizeof(uint8_t*));
+    if (job->stored == NULL || job->data == NULL) {
+        result = ERROR_OUT_OF_MEMORY;
+    }
+    
+    for (i = 0; result == ERROR_SUCCESS && i < count; i++) {
+        uint32_t size = archive_stored_size(job->batch[i]);
+        
+        job->stored[i] = malloc(size > 0 ? size : 1);
+        if (job->stored[i] == NULL) {
+            result = ERROR_OUT_OF_MEMORY;
+        }
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        result = archive_read_stored(job->archive, job->batch, job->stored, count);
+    }
+    if (result == ERROR_SUCCESS) {
+        result = thread_pool_run(pool, count, decode_member_task, job);
+    }
+    if (result == ERROR_SUCCESS) {
+        result = write_batch(job, count);
+    }
+    
+    for (i = 0; job->stored != NULL && i < count; i++) {
+        if (job->data != NULL && job->data[i] != job->stored[i]) {
+            free(job->data[i]);
+        }
+        free(job->stored[i]);
+    }
+    free(job->stored);
+    free(job->data);
+    job->stored = NULL;
+    job->data = NULL;
+    
+    return result;
+}
+
+/* Extract every member of the job, a batch at a time */
+static int extract_members(extract_job_t* job, thread_pool_t* pool) {
+    char output_path[1024];
+    size_t first;
+    size_t end;
+    size_t memory;
+    int result = ERROR_SUCCESS;
+    
+    for (first = 0; result == ERROR_SUCCESS && first < job->count; first = end) {
+        memory = batch_memory(job->members[first]);
+        end = first + 1;
+        if (memory > job->memory_limit) {
+            output_path_for(job, job->members[first], output_path, sizeof(output_path));
+            result = archive_extract_member(job->archive, job->members[first], output_path);
+        } else {
+            while (end < job->count && end - first < STAR_EXTRACT_BATCH_MEMBERS &&
+                   memory + batch_memory(job->members[end]) <= job->memory_limit) {
+                memory += batch_memory(job->members[end]);
+                end++;
+            }
+            result = extract_batch(job, pool, first, end - first);
+        }
+        
+        /* Report progress */
+        if (result == ERROR_SUCCESS && job->context->progress_callback != NULL) {
+            int progress = (int)(end * 100 / job->count);
+            job->context->progress_callback("Extracting files", progress,
+                                            job->context->progress_user_data);
+        }
+    }
+    
+    return result;
+}
+
 int star_extract_archive(star_context_t* context,
                         const char* archive_path,
                         const char* output_dir,
                         const char* const* member_list,
                         size_t member_count) {
     archive_file_t* archive;
-    archive_member_t* member;
+    extract_job_t job;
+    thread_pool_t* pool = NULL;
     int result;
     size_t i;
-    char output_path[1024];
     
     if (context == NULL || archive_path == NULL) {
         return ERROR_INVALID_ARGUMENT;
@@ -168,117 +578,104 @@ int star_extract_archive(star_context_t* context,
         return result;
     }
     
-    /* Extract members */
+    memset(&job, 0, sizeof(job));
+    job.context = context;
+    job.archive = archive;
+    job.output_dir = output_dir;
+    job.memory_limit = context->options.max_memory != 0 ? context->options.max_memory :
+                       STAR_EXTRACT_BATCH_SIZE;
+    job.members = calloc(member_list == NULL || member_count == 0 ?
+                         (size_t)archive->header.member_count + 1 : member_count,
+                         sizeof(archive_member_t*));
+    if (job.members == NULL) {
+        archive_close(archive);
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    /* Resolve the members first, so a missing name extracts nothing */
     if (member_list == NULL || member_count == 0) {
-        /* Extract all members */
         for (i = 0; i < archive->header.member_count; i++) {
-            member = &archive->members[i];
-            if (member->name != NULL) {
-                /* Load member data if not already loaded */
-                if (!member->data_loaded) {
-                    member->data = malloc(member->header.size);
-                    if (member->data == NULL) {
-                        archive_close(archive);
-                        return ERROR_OUT_OF_MEMORY;
-                    }
-                    
-                    if (fseek(archive->file, (long)member->header.data_offset, SEEK_SET) != 0 ||
-                        fread(member->data, member->header.size, 1, archive->file) != 1) {
-                        archive_close(archive);
-                        return ERROR_FILE_IO;
-                    }
-                    member->data_loaded = true;
-                }
-                
-                /* Create output path */
-                if (output_dir != NULL) {
-                    snprintf(output_path, sizeof(output_path), "%s/%s", output_dir, member->name);
-                } else {
-                    strncpy(output_path, member->name, sizeof(output_path) - 1);
-                    output_path[sizeof(output_path) - 1] = '\0';
-                }
-                
-                /* Extract member */
-                result = archive_extract_member(archive, member, output_path);
-                if (result != ERROR_SUCCESS) {
-                    archive_close(archive);
-                    return result;
-                }
-                
-                /* Report progress */
-                if (context->progress_callback != NULL) {
-                    int progress = (int)((i + 1) * 100 / archive->header.member_count);
-                    context->progress_callback("Extracting files", progress, context->progress_user_data);
-                }
+            if (archive->members[i].name != NULL) {
+                job.members[job.count++] = &archive->members[i];
             }
         }
     } else {
-        /* Extract specific members */
-        for (i = 0; i < member_count; i++) {
-            member = archive_find_member(archive, member_list[i]);
-            if (member == NULL) {
-                archive_close(archive);
-                return ERROR_MEMBER_NOT_FOUND;
-            }
-            
-            /* Load member data if not already loaded */
-            if (!member->data_loaded) {
-                member->data = malloc(member->header.size);
-                if (member->data == NULL) {
-                    archive_close(archive);
-                    return ERROR_OUT_OF_MEMORY;
-                }
-                
-                if (fseek(archive->file, (long)member->header.data_offset, SEEK_SET) != 0 ||
-                    fread(member->data, member->header.size, 1, archive->file) != 1) {
-                    archive_close(archive);
-                    return ERROR_FILE_IO;
-                }
-                member->data_loaded = true;
-            }
-            
-            /* Create output path */
-            if (output_dir != NULL) {
-                snprintf(output_path, sizeof(output_path), "%s/%s", output_dir, member->name);
-            } else {
-                strncpy(output_path, member->name, sizeof(output_path) - 1);
-                output_path[sizeof(output_path) - 1] = '\0';
-            }
-            
-            /* Extract member */
-            result = archive_extract_member(archive, member, output_path);
-            if (result != ERROR_SUCCESS) {
-                archive_close(archive);
-                return result;
-            }
-            
-            /* Report progress */
-            if (context->progress_callback != NULL) {
-                int progress = (int)((i + 1) * 100 / member_count);
-                context->progress_callback("Extracting files", progress, context->progress_user_data);
+        for (i = 0; result == ERROR_SUCCESS && i < member_count; i++) {
+            job.members[job.count] = archive_find_member(archive, member_list[i]);
+            if (job.members[job.count++] == NULL) {
+                result = ERROR_MEMBER_NOT_FOUND;
             }
         }
     }
     
+    if (result == ERROR_SUCCESS && job.count > 1) {
+        pool = get_thread_pool(context);
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        result = archive_set_io_backend(archive, context->options.io_backend);
+    }
+    if (result == ERROR_SUCCESS) {
+        result = extract_members(&job, pool);
+    }
+    
+    free(job.members);
     archive_close(archive);
     
-    if (context->progress_callback != NULL) {
+    if (result == ERROR_SUCCESS && context->progress_callback != NULL) {
         context->progress_callback("Extraction complete", 100, context->progress_user_data);
     }
     
-    return ERROR_SUCCESS;
+    return result;
 }
 
 int star_update_archive(star_context_t* context,
                        const char* archive_path,
                        const char* const* file_list,
                        size_t file_count) {
+    archive_file_t* archive;
+    size_t i;
+    int result = ERROR_SUCCESS;
+    
     if (context == NULL || archive_path == NULL || file_list == NULL || file_count == 0) {
         return ERROR_INVALID_ARGUMENT;
     }
     
-    /* TODO: Implement archive update */
-    return ERROR_SUCCESS;
+    if (context->options.compression != STAR_COMPRESS_AUTO &&
+        !compression_is_available(context->options.compression)) {
+        ERROR_REPORT_ERROR(ERROR_COMPRESSION_FAILED, "Compression algorithm not available");
+        return ERROR_COMPRESSION_FAILED;
+    }
+    
+    /* The file changes under any mapping of it */
+    unmap_archive(context);
+    
+    archive = archive_open_for_update(archive_path, &context->options);
+    if (archive == NULL) {
+        return ERROR_FILE_IO;
+    }
+    
+    /* Only the changed members are written; the rest stay where they are */
+    for (i = 0; result == ERROR_SUCCESS && i < file_count; i++) {
+        result = archive_update_member_from_file(archive, file_list[i], file_list[i]);
+        if (result == ERROR_SUCCESS) {
+            report_added(context, i + 1, file_count);
+        }
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        if ((archive->header.flags & STAR_FLAG_INDEXED) != 0) {
+            archive_set_thread_pool(archive, get_thread_pool(context));
+        }
+        result = archive_commit_update(archive);
+    }
+    archive_close(archive);
+    
+    if (result == ERROR_SUCCESS && context->progress_callback != NULL) {
+        context->progress_callback("Archive update complete", 100, context->progress_user_data);
+    }
+    
+    return result;
 }
 
 int star_list_archive(star_context_t* context,
@@ -325,12 +722,65 @@ int star_delete_members(star_context_t* context,
                        const char* archive_path,
                        const char* const* member_list,
                        size_t member_count) {
+    archive_file_t* archive;
+    size_t i;
+    int result = ERROR_SUCCESS;
+    
     if (context == NULL || archive_path == NULL || member_list == NULL || member_count == 0) {
         return ERROR_INVALID_ARGUMENT;
     }
     
-    /* TODO: Implement member deletion */
-    return ERROR_SUCCESS;
+    unmap_archive(context);
+    
+    archive = archive_open_for_update(archive_path, NULL);
+    if (archive == NULL) {
+        return ERROR_FILE_IO;
+    }
+    
+    /* A missing member leaves the archive untouched */
+    for (i = 0; result == ERROR_SUCCESS && i < member_count; i++) {
+        result = archive_delete_member(archive, member_list[i]);
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        if ((archive->header.flags & STAR_FLAG_INDEXED) != 0) {
+            archive_set_thread_pool(archive, get_thread_pool(context));
+        }
+        result = archive_commit_update(archive);
+    }
+    archive_close(archive);
+    
+    return result;
+}
+
+int star_compact_archive(star_context_t* context, const char* archive_path) {
+    char* temp_path;
+    int result;
+    
+    if (context == NULL || archive_path == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    unmap_archive(context);
+    
+    temp_path = malloc(strlen(archive_path) + sizeof(".compact"));
+    if (temp_path == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    strcpy(temp_path, archive_path);
+    strcat(temp_path, ".compact");
+    
+    /* The archive is only replaced once the copy is complete */
+    result = archive_compact(archive_path, temp_path);
+    if (result == ERROR_SUCCESS && rename(temp_path, archive_path) != 0) {
+        result = ERROR_FILE_IO;
+    }
+    if (result != ERROR_SUCCESS) {
+        remove(temp_path);
+    }
+    free(temp_path);
+    
+    return result;
 }
 
 int star_get_stats(star_context_t* context,
@@ -346,23 +796,118 @@ int star_get_stats(star_context_t* context,
     return ERROR_SUCCESS;
 }
 
+/* Keep one archive mapped; repeated reads of an unchanged file reuse it */
+static int map_archive(star_context_t* context, const char* archive_path) {
+    struct stat st;
+    
+    if (stat(archive_path, &st) != 0) {
+        return ERROR_FILE_NOT_FOUND;
+    }
+    
+    if (context->mapped != NULL && strcmp(context->mapped_path, archive_path) == 0 &&
+        st.st_dev == context->mapped_stat.st_dev && st.st_ino == context->mapped_stat.st_ino &&
+        st.st_size == context->mapped_stat.st_size &&
+        st.st_mtime == context->mapped_stat.st_mtime) {
+        return ERROR_SUCCESS;
+    }
+    
+    unmap_archive(context);
+    
+    context->mapped_path = malloc(strlen(archive_path) + 1);
+    if (context->mapped_path == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    strcpy(context->mapped_path, archive_path);
+    
+    context->mapped = archive_map(context->mapped_path);
+    if (context->mapped == NULL) {
+        unmap_archive(context);
+        return ERROR_ARCHIVE_CORRUPT;
+    }
+    context->mapped_stat = st;
+    
+    return ERROR_SUCCESS;
+}
+
 int star_extract_member_to_memory(star_context_t* context,
                                  const char* archive_path,
                                  const char* member_name,
-                                 uint8_t** data,
+                                 const uint8_t** data,
                                  size_t* size) {
+    const archive_member_t* member;
+    int result;
+    
     if (context == NULL || archive_path == NULL || member_name == NULL || 
         data == NULL || size == NULL) {
         return ERROR_INVALID_ARGUMENT;
     }
     
-    /* TODO: Implement memory extraction */
     *data = NULL;
     *size = 0;
+    free(context->member_data);
+    context->member_data = NULL;
+    
+    result = map_archive(context, archive_path);
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    member = archive_find_member(context->mapped, member_name);
+    if (member == NULL) {
+        return ERROR_MEMBER_NOT_FOUND;
+    }
+    
+    /* Compressed members cannot be read in place */
+    if (archive_member_is_blocked(member)) {
+        archive_set_thread_pool(context->mapped, get_thread_pool(context));
+    }
+    if (archive_member_is_compressed(member)) {
+        result = archive_extract_member_to_memory(context->mapped, member,
+                                                  &context->member_data, size);
+        *data = context->member_data;
+        return result;
+    }
+    
+    *data = archive_member_data(context->mapped, member);
+    if (*data == NULL) {
+        return ERROR_ARCHIVE_CORRUPT;
+    }
+    *size = member->header.size;
     
     return ERROR_SUCCESS;
 }
 
+int star_read_member_range(star_context_t* context,
+                           const char* archive_path,
+                           const char* member_name,
+                           size_t offset,
+                           uint8_t* output,
+                           size_t size) {
+    archive_member_t* member;
+    int result;
+    
+    if (context == NULL || archive_path == NULL || member_name == NULL ||
+        (output == NULL && size > 0) || offset > UINT32_MAX) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    result = map_archive(context, archive_path);
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    member = archive_find_member(context->mapped, member_name);
+    if (member == NULL) {
+        return ERROR_MEMBER_NOT_FOUND;
+    }
+    
+    if (archive_member_is_blocked(member)) {
+        archive_set_thread_pool(context->mapped, get_thread_pool(context));
+    }
+    
+    return archive_read_member_range(context->mapped, member, (uint32_t)offset, size, output);
+}
+
 int star_add_member_from_memory(star_context_t* context,
                                const char* archive_path,
                                const char* member_name,
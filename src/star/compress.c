@@ -0,0 +1,1555 @@
+/* src/star/compress.c */
+#include "compress.h"
+#include "star.h"
+#include "../common/include/crc32.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#ifdef ENABLE_ZLIB
+#define ZLIB_CONST
+#include <zlib.h>
+#endif
+
+#ifdef ENABLE_LZMA
+#include <lzma.h>
+#endif
+
+/**
+ * @file compress.c
+ * @brief Compression engine implementation
+ * @details Member compression backends for STAR: a built-in LZ4 block
+ * codec for fast decoding, and zlib and LZMA through the system libraries
+ * for better ratios. Every backend compresses a whole buffer in one call.
+ * Contexts keep their tables and library streams between calls, and the
+ * high-level functions take contexts and buffers from a process-wide
+ * cache, so compressing many small members does not set up a compressor
+ * or allocate an output buffer for each. LZ4 and zlib can also compress
+ * against a dictionary trained from sample members, which small members
+ * that share most of their content need to compress well at all.
+ */
+
+/* LZ4 block format limits */
+#define LZ4_MIN_MATCH 4
+#define LZ4_LAST_LITERALS 5         /* The last bytes of a block are always literals */
+#define LZ4_MATCH_LIMIT 12          /* No match starts closer than this to the end */
+#define LZ4_MAX_OFFSET 65535
+#define LZ4_WINDOW_MASK 0xFFFFU
+#define LZ4_HASH_BITS 16
+#define LZ4_MIN_HASH_BITS 10
+
+/*
+ * Buffers are recycled by power-of-two size class, from 4KB to 16MB,
+ * while the cache holds less than COMPRESS_CACHE_BYTES; larger buffers
+ * go straight back to malloc. Released contexts are kept up to
+ * COMPRESS_CACHED_CONTEXTS per algorithm, about one per worker thread.
+ */
+#define COMPRESS_MIN_CLASS 12
+#define COMPRESS_MAX_CLASS 24
+#define COMPRESS_CACHE_BYTES ((size_t)64 << 20)
+#define COMPRESS_CACHED_CONTEXTS 8
+
+/* Processor time each direction of a benchmark runs for at least */
+#define COMPRESS_BENCHMARK_SECONDS 0.01
+
+/*
+ * Dictionary training scores DICTIONARY_SEGMENT byte pieces of the
+ * samples by how many samples share their DICTIONARY_DMER byte runs.
+ */
+#define DICTIONARY_DMER 8
+#define DICTIONARY_SEGMENT 64
+#define DICTIONARY_HASH_BITS 20
+
+/* Compression context, shared by all algorithms */
+struct compression_context {
+    int level;
+    uint32_t* hash_table;           /* LZ4: position + 1 by hash, 0 = empty */
+    uint32_t* chain;                /* LZ4: previous position + 1 with the same hash */
+    const uint8_t* dictionary;      /* Attached until the context is released; not owned */
+    size_t dictionary_size;
+    uint32_t* history_table;        /* LZ4: dictionary position + 1 by hash */
+    uint32_t* history_chain;        /* LZ4: previous dictionary position + 1, same hash */
+    size_t history_indexed;         /* LZ4: bytes the history tables cover, 0 = none */
+    uint32_t history_checksum;      /* LZ4: CRC32 of the bytes they were built from */
+#ifdef ENABLE_ZLIB
+    z_stream deflater;              /* Reset rather than rebuilt for each call */
+    z_stream inflater;
+    int deflater_level;
+    bool has_deflater;
+    bool has_inflater;
+#endif
+#ifdef ENABLE_LZMA
+    lzma_stream encoder;            /* Reinitializing reuses the coder's memory */
+    lzma_stream decoder;
+#endif
+    compression_stats_t stats;
+    compression_context_t* next;    /* In the cache of released contexts */
+};
+
+/* In front of every buffer from compression_allocate_buffer, kept aligned */
+typedef union buffer_header {
+    struct {
+        unsigned size_class;        /* COMPRESS_MAX_CLASS + 1 if not recycled */
+        union buffer_header* next;  /* In the cache of released buffers */
+    } link;
+    long double align_float;
+    uint64_t align_integer;
+    void* align_pointer;
+} buffer_header_t;
+
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static buffer_header_t* cached_buffers[COMPRESS_MAX_CLASS + 1];
+static size_t cached_bytes;
+static compression_context_t* cached_contexts[STAR_COMPRESS_LZMA + 1];
+static size_t cached_context_count[STAR_COMPRESS_LZMA + 1];
+
+static compression_context_t* create_context(int level) {
+    compression_context_t* ctx = calloc(1, sizeof(compression_context_t));
+    
+    if (ctx != NULL) {
+        ctx->level = level;
+#ifdef ENABLE_LZMA
+        ctx->encoder = (lzma_stream)LZMA_STREAM_INIT;
+        ctx->decoder = (lzma_stream)LZMA_STREAM_INIT;
+#endif
+    }
+    
+    return ctx;
+}
+
+static void destroy_context(compression_context_t* ctx) {
+    if (ctx != NULL) {
+#ifdef ENABLE_ZLIB
+        if (ctx->has_deflater) {
+            deflateEnd(&ctx->deflater);
+        }
+        if (ctx->has_inflater) {
+            inflateEnd(&ctx->inflater);
+        }
+#endif
+#ifdef ENABLE_LZMA
+        lzma_end(&ctx->encoder);
+        lzma_end(&ctx->decoder);
+#endif
+        free(ctx->hash_table);
+        free(ctx->chain);
+        free(ctx->history_table);
+        free(ctx->history_chain);
+        free(ctx);
+    }
+}
+
+static void get_stats(const compression_context_t* ctx, compression_stats_t* stats) {
+    if (ctx != NULL && stats != NULL) {
+        *stats = ctx->stats;
+    }
+}
+
+static double seconds_since(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/* Account one call in the context's running totals */
+static void record_compression(compression_context_t* ctx, size_t input_size,
+                               size_t output_size, clock_t start) {
+    ctx->stats.input_size += input_size;
+    ctx->stats.output_size += output_size;
+    ctx->stats.compression_ratio = compression_calculate_ratio(ctx->stats.input_size,
+                                                               ctx->stats.output_size);
+    ctx->stats.compression_time += seconds_since(start);
+}
+
+/* No compression */
+
+static int none_compress(compression_context_t* ctx,
+                         const uint8_t* input, size_t input_size,
+                         uint8_t* output, size_t output_size,
+                         size_t* compressed_size) {
+    clock_t start = clock();
+    
+    if (ctx == NULL || (input == NULL && input_size > 0) || compressed_size == NULL) {
+        return COMPRESS_ERROR_INVALID;
+    }
+    
+    if (output_size < input_size) {
+        return COMPRESS_ERROR_OVERFLOW;
+    }
+    
+    if (input_size > 0) {
+        memcpy(output, input, input_size);
+    }
+    *compressed_size = input_size;
+    record_compression(ctx, input_size, input_size, start);
+    
+    return COMPRESS_SUCCESS;
+}
+
+static int none_decompress(compression_context_t* ctx,
+                           const uint8_t* input, size_t input_size,
+                           uint8_t* output, size_t output_size,
+                           size_t* decompressed_size) {
+    if (ctx == NULL || (input == NULL && input_size > 0) || decompressed_size == NULL) {
+        return COMPRESS_ERROR_INVALID;
+    }
+    
+    if (output_size < input_size) {
+        return COMPRESS_ERROR_OVERFLOW;
+    }
+    
+    if (input_size > 0) {
+        memcpy(output, input, input_size);
+    }
+    *decompressed_size = input_size;
+    
+    return COMPRESS_SUCCESS;
+}
+
+static size_t none_max_compressed_size(size_t input_size) {
+    return input_size;
+}
+
+static bool none_validate(const uint8_t* data, size_t size) {
+    return data != NULL || size == 0;
+}
+
+const compression_algorithm_t compression_none_algorithm = {
+    .name = "none",
+    .type = STAR_COMPRESS_NONE,
+    .create_context = create_context,
+    .destroy_context = destroy_context,
+    .compress = none_compress,
+    .decompress = none_decompress,
+    .get_max_compressed_size = none_max_compressed_size,
+    .validate_compressed_data = none_validate,
+    .get_stats = get_stats
+};
+
+/* LZ4 block format, built in */
+
+#ifdef ENABLE_LZ4
+
+static uint32_t lz4_read32(const uint8_t* p) {
+    uint32_t value;
+    
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint32_t lz4_hash(uint32_t sequence, unsigned bits) {
+    return (sequence * 2654435761U) >> (32 - bits);
+}
+
+/* Length in the 255-run encoding that follows a saturated token nibble */
+static size_t lz4_length_bytes(size_t length) {
+    return length >= 15 ? (length - 15) / 255 + 1 : 0;
+}
+
+static uint8_t* lz4_write_length(uint8_t* op, size_t length) {
+    if (length >= 15) {
+        length -= 15;
+        while (length >= 255) {
+            *op++ = 255;
+            length -= 255;
+        }
+        *op++ = (uint8_t)length;
+    }
+    
+    return op;
+}
+
+/* Append one sequence; a match_length of 0 ends the block with literals only */
+static int lz4_write_sequence(uint8_t** out, const uint8_t* out_end,
+                              const uint8_t* literals, size_t literal_length,
+                              size_t offset, size_t match_length) {
+    uint8_t* op = *out;
+    size_t match_code = match_length > 0 ? match_length - LZ4_MIN_MATCH : 0;
+    size_t needed = 1 + lz4_length_bytes(literal_length) + literal_length +
+                    (match_length > 0 ? 2 + lz4_length_bytes(match_code) : 0);
+    
+    if (needed > (size_t)(out_end - op)) {
+        return COMPRESS_ERROR_OVERFLOW;
+    }
+    
+    *op++ = (uint8_t)(((literal_length < 15 ? literal_length : 15) << 4) |
+                      (match_code < 15 ? match_code : 15));
+    op = lz4_write_length(op, literal_length);
+    memcpy(op, literals, literal_length);
+    op += literal_length;
+    
+    if (match_length > 0) {
+        *op++ = (uint8_t)(offset & 0xFF);
+        *op++ = (uint8_t)(offset >> 8);
+        op = lz4_write_length(op, match_code);
+    }
+    
+    *out = op;
+    return COMPRESS_SUCCESS;
+}
+
+/* Hash and chain tables are allocated on first use and kept with the context */
+static int lz4_prepare(compression_context_t* ctx, unsigned bits) {
+    if (ctx->hash_table == NULL) {
+        ctx->hash_table = malloc(((size_t)1 << LZ4_HASH_BITS) * sizeof(uint32_t));
+        ctx->chain = malloc(((size_t)LZ4_WINDOW_MASK + 1) * sizeof(uint32_t));
+        if (ctx->hash_table == NULL || ctx->chain == NULL) {
+            free(ctx->hash_table);
+            free(ctx->chain);
+            ctx->hash_table = NULL;
+            ctx->chain = NULL;
+            return COMPRESS_ERROR_MEMORY;
+        }
+    }
+    
+    memset(ctx->hash_table, 0, ((size_t)1 << bits) * sizeof(uint32_t));
+    return COMPRESS_SUCCESS;
+}
+
+/* The end of the attached dictionary that LZ4 offsets can reach, if any */
+static const uint8_t* lz4_history(const compression_context_t* ctx, size_t* size) {
+    *size = ctx->dictionary_size < LZ4_MAX_OFFSET ? ctx->dictionary_size : LZ4_MAX_OFFSET;
+    
+    return ctx->dictionary != NULL ? ctx->dictionary + ctx->dictionary_size - *size : NULL;
+}
+
+/*
+ * Index every position of the history once. The tables stay with the
+ * context and are rebuilt only when it is given a different dictionary,
+ * so compressing many members against one costs no more per member.
+ */
+static int lz4_index_history(compression_context_t* ctx, const uint8_t* history, size_t size) {
+    uint32_t checksum = crc32_calculate(history, size);
+    uint32_t hash;
+    size_t position;
+    
+    if (ctx->history_table != NULL && ctx->history_indexed == size &&
+        ctx->history_checksum == checksum) {
+        return COMPRESS_SUCCESS;
+    }
+    
+    if (ctx->history_table == NULL) {
+        ctx->history_table = malloc(((size_t)1 << LZ4_HASH_BITS) * sizeof(uint32_t));
+        ctx->history_chain = malloc((size_t)LZ4_MAX_OFFSET * sizeof(uint32_t));
+        if (ctx->history_table == NULL || ctx->history_chain == NULL) {
+            free(ctx->history_table);
+            free(ctx->history_chain);
+            ctx->history_table = NULL;
+            ctx->history_chain = NULL;
+            return COMPRESS_ERROR_MEMORY;
+        }
+    }
+    
+    memset(ctx->history_table, 0, ((size_t)1 << LZ4_HASH_BITS) * sizeof(uint32_t));
+    for (position = 0; position + LZ4_MIN_MATCH <= size; position++) {
+        hash = lz4_hash(lz4_read32(history + position), LZ4_HASH_BITS);
+        ctx->history_chain[position] = ctx->history_table[hash];
+        ctx->history_table[hash] = (uint32_t)(position + 1);
+    }
+    ctx->history_indexed = size;
+    ctx->history_checksum = checksum;
+    
+    return COMPRESS_SUCCESS;
+}
+
+/* A match starting in the history runs on into the start of the input */
+static size_t lz4_history_match(const uint8_t* history, size_t history_size, size_t position,
+                                const uint8_t* input, size_t ip, size_t limit) {
+    size_t length = 0;
+    size_t next = 0;
+    
+    while (position + length < history_size && ip + length < limit &&
+           history[position + length] == input[ip + length]) {
+        length++;
+    }
+    if (position + length == history_size) {
+        while (ip + length < limit && input[next] == input[ip + length]) {
+            next++;
+            length++;
+        }
+    }
+    
+    return length;
+}
+
+/*
+ * Greedy parse over hash chains. The level sets how many earlier
+ * positions with the same hash are tried, and from level 2 on every
+ * position inside a match is indexed too, trading speed for ratio.
+ * With a dictionary attached, the tries left after the input's own
+ * chain go to the dictionary's, as if it came just before the input.
+ */
+static int lz4_compress(compression_context_t* ctx,
+                        const uint8_t* input, size_t input_size,
+                        uint8_t* output, size_t output_size,
+                        size_t* compressed_size) {
+    clock_t start = clock();
+    uint8_t* op = output;
+    const uint8_t* out_end = output + output_size;
+    const uint8_t* history;
+    size_t history_size;
+    unsigned bits = LZ4_MIN_HASH_BITS;
+    unsigned depth;
+    size_t match_end_limit;
+    size_t anchor = 0;
+    size_t ip = 0;
+    size_t best_length;
+    size_t best_offset = 0;
+    size_t candidate;
+    size_t length;
+    uint32_t hash;
+    unsigned tries;
+    int result = COMPRESS_SUCCESS;
+    
+    if (ctx == NULL || (input == NULL && input_size > 0) || output == NULL ||
+        compressed_size == NULL) {
+        return COMPRESS_ERROR_INVALID;
+    }
+    
+    if (input_size > UINT32_MAX - 1) {
+        return COMPRESS_ERROR_OVERFLOW;
+    }
+    
+    while (bits < LZ4_HASH_BITS && ((size_t)1 << bits) < input_size) {
+        bits++;
+    }
+    depth = ctx->level <= 1 ? 1 : (unsigned)ctx->level * 8;
+    
+    result = lz4_prepare(ctx, bits);
+    history = lz4_history(ctx, &history_size);
+    if (result == COMPRESS_SUCCESS && history != NULL) {
+        result = lz4_index_history(ctx, history, history_size);
+    }
+    match_end_limit = input_size > LZ4_LAST_LITERALS ? input_size - LZ4_LAST_LITERALS : 0;
+    
+    while (result == COMPRESS_SUCCESS && ip + LZ4_MATCH_LIMIT <= input_size) {
+        hash = lz4_hash(lz4_read32(input + ip), bits);
+        candidate = ctx->hash_table[hash];
+        ctx->hash_table[hash] = (uint32_t)(ip + 1);
+        ctx->chain[ip & LZ4_WINDOW_MASK] = (uint32_t)candidate;
+        
+        best_length = 0;
+        for (tries = 0; tries < depth && candidate != 0 && ip - (candidate - 1) <= LZ4_MAX_OFFSET;
+             tries++) {
+            size_t position = candidate - 1;
+            
+            if (lz4_read32(input + position) == lz4_read32(input + ip)) {
+                length = LZ4_MIN_MATCH;
+                while (ip + length < match_end_limit && input[position + length] == input[ip + length]) {
+                    length++;
+                }
+                if (length > best_length) {
+                    best_length = length;
+                    best_offset = ip - position;
+                }
+            }
+            candidate = ctx->chain[position & LZ4_WINDOW_MASK];
+        }
+        
+        /* Older history positions lie further back, so the walk stops at the first out of reach */
+        candidate = history != NULL ?
+                    ctx->history_table[lz4_hash(lz4_read32(input + ip), LZ4_HASH_BITS)] : 0;
+        for (; tries < depth && candidate != 0 &&
+             ip + history_size - (candidate - 1) <= LZ4_MAX_OFFSET; tries++) {
+            length = lz4_history_match(history, history_size, candidate - 1, input, ip,
+                                       match_end_limit);
+            if (length >= LZ4_MIN_MATCH && length > best_length) {
+                best_length = length;
+                best_offset = ip + history_size - (candidate - 1);
+            }
+            candidate = ctx->history_chain[candidate - 1];
+        }
+        
+        if (best_length < LZ4_MIN_MATCH) {
+            ip++;
+        } else {
+            result = lz4_write_sequence(&op, out_end, input + anchor, ip - anchor,
+                                        best_offset, best_length);
+            
+            /* Higher levels also find matches that start inside this one */
+            for (length = 1; ctx->level > 1 && length < best_length &&
+                 ip + length + LZ4_MATCH_LIMIT <= input_size; length++) {
+                hash = lz4_hash(lz4_read32(input + ip + length), bits);
+                ctx->chain[(ip + length) & LZ4_WINDOW_MASK] = ctx->hash_table[hash];
+                ctx->hash_table[hash] = (uint32_t)(ip + length + 1);
+            }
+            
+            ip += best_length;
+            anchor = ip;
+        }
+    }
+    
+    if (result == COMPRESS_SUCCESS) {
+        result = lz4_write_sequence(&op, out_end, input + anchor, input_size - anchor, 0, 0);
+    }
+    if (result != COMPRESS_SUCCESS) {
+        return result;
+    }
+    
+    *compressed_size = (size_t)(op - output);
+    record_compression(ctx, input_size, *compressed_size, start);
+    
+    return COMPRESS_SUCCESS;
+}
+
+/* Read a 255-run length extension; false if it runs off the input */
+static bool lz4_read_length(const uint8_t** in, const uint8_t* in_end, size_t* length) {
+    const uint8_t* ip = *in;
+    uint8_t byte = 255;
+    
+    while (byte == 255) {
+        if (ip >= in_end) {
+            return false;
+        }
+        byte = *ip++;
+        *length += byte;
+    }
+    
+    *in = ip;
+    return true;
+}
+
+/*
+ * Decodes exactly output_size bytes; anything else is corrupt input.
+ * Offsets that reach back past the start of the output continue into
+ * the end of the attached dictionary.
+ */
+static int lz4_decompress(compression_context_t* ctx,
+                          const uint8_t* input, size_t input_size,
+                          uint8_t* output, size_t output_size,
+                          size_t* decompressed_size) {
+    clock_t start = clock();
+    const uint8_t* ip = input;
+    const uint8_t* in_end = input + input_size;
+    size_t op = 0;
+    size_t history_size = 0;
+    size_t literal_length;
+    size_t match_length;
+    size_t offset;
+    size_t back;
+    uint8_t token;
+    
+    if (ctx == NULL || input == NULL || (output == NULL && output_size > 0) ||
+        decompressed_size == NULL) {
+        return COMPRESS_ERROR_INVALID;
+    }
+    
+    if (ctx->dictionary != NULL) {
+        history_size = ctx->dictionary_size;
+    }
+    
+    while (ip < in_end) {
+        token = *ip++;
+        
+        literal_length = (size_t)(token >> 4);
+        if (literal_length == 15 && !lz4_read_length(&ip, in_end, &literal_length)) {
+            return COMPRESS_ERROR_CORRUPT;
+        }
+        if (literal_length > (size_t)(in_end - ip) || literal_length > output_size - op) {
+            return COMPRESS_ERROR_CORRUPT;
+        }
+        memcpy(output + op, ip, literal_length);
+        ip += literal_length;
+        op += literal_length;
+        
+        if (ip < in_end) {
+            if (in_end - ip < 2) {
+                return COMPRESS_ERROR_CORRUPT;
+            }
+            offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+            ip += 2;
+            
+            match_length = (size_t)(token & 15);
+            if (match_length == 15 && !lz4_read_length(&ip, in_end, &match_length)) {
+                return COMPRESS_ERROR_CORRUPT;
+            }
+            match_length += LZ4_MIN_MATCH;
+            
+            if (offset == 0 || offset > op + history_size || match_length > output_size - op) {
+                return COMPRESS_ERROR_CORRUPT;
+            }
+            
+            /* The part of the match in the dictionary, after which it continues at output[0] */
+            if (offset > op) {
+                back = offset - op < match_length ? offset - op : match_length;
+                memcpy(output + op, ctx->dictionary + history_size - (offset - op), back);
+                op += back;
+                match_length -= back;
+            }
+            
+            /* Matches may overlap their own output */
+            if (match_length > 0 && offset >= match_length) {
+                memcpy(output + op, output + op - offset, match_length);
+                op += match_length;
+            } else {
+                while (match_length-- > 0) {
+                    output[op] = output[op - offset];
+                    op++;
+                }
+            }
+        }
+    }
+    
+    if (op != output_size) {
+        return COMPRESS_ERROR_CORRUPT;
+    }
+    
+    *decompressed_size = op;
+    ctx->stats.decompression_time += seconds_since(start);
+    
+    return COMPRESS_SUCCESS;
+}
+
+static size_t lz4_max_compressed_size(size_t input_size) {
+    return input_size + input_size / 255 + 16;
+}
+
+/* A block is a token followed by data, so it is never empty */
+static bool lz4_validate(const uint8_t* data, size_t size) {
+    return data != NULL && size > 0;
+}
+
+const compression_algorithm_t compression_lz4_algorithm = {
+    .name = "lz4",
+    .type = STAR_COMPRESS_LZ4,
+    .supports_dictionary = true,
+    .create_context = create_context,
+    .destroy_context = destroy_context,
+    .compress = lz4_compress,
+    .decompress = lz4_decompress,
+    .get_max_compressed_size = lz4_max_compressed_size,
+    .validate_compressed_data = lz4_validate,
+    .get_stats = get_stats
+};
+
+#endif /* ENABLE_LZ4 */
+
+/* Zlib, as a zlib stream so that it can be detected */
+
+#ifdef ENABLE_ZLIB
+
+/* The context's deflater, reset for a new stream at the context's level */
+static int zlib_reset_deflater(compression_context_t* ctx) {
+    int status;
+    
+    if (!ctx->has_deflater) {
+        memset(&ctx->deflater, 0, sizeof(ctx->deflater));
+        status = deflateInit(&ctx->deflater, ctx->level);
+        ctx->has_deflater = status == Z_OK;
+        ctx->deflater_level = ctx->level;
+    } else {
+        status = deflateReset(&ctx->deflater);
+        if (status == Z_OK && ctx->deflater_level != ctx->level) {
+            status = deflateParams(&ctx->deflater, ctx->level, Z_DEFAULT_STRATEGY);
+            ctx->deflater_level = ctx->level;
+        }
+    }
+    
+    return status == Z_OK ? COMPRESS_SUCCESS :
+           status == Z_MEM_ERROR ? COMPRESS_ERROR_MEMORY : COMPRESS_ERROR_INVALID;
+}
+
+/* The same stream compress2 writes, without setting up a deflater per call */
+static int zlib_compress(compression_context_t* ctx,
+                         const uint8_t* input, size_t input_size,
+                         uint8_t* output, size_t output_size,
+                         size_t* compressed_size) {
+    clock_t start = clock();
+    int status;
+    int result;
+    
+    if (ctx == NULL || (input == NULL && input_size > 0) || output == NULL ||
+        compressed_size == NULL) {
+        return COMPRESS_ERROR_INVALID;
+    }
+    
+    if (input_size > UINT32_MAX || output_size > UINT32_MAX) {
+        return COMPRESS_ERROR_OVERFLOW;
+    }
+    
+    result = zlib_reset_deflater(ctx);
+    if (result == COMPRESS_SUCCESS && ctx->dictionary != NULL &&
+        deflateSetDictionary(&ctx->deflater, ctx->dictionary,
+                             (uInt)ctx->dictionary_size) != Z_OK) {
+        result = COMPRESS_ERROR_INVALID;
+    }
+    if (result != COMPRESS_SUCCESS) {
+        return result;
+    }
+    
+    ctx->deflater.next_in = input;
+    ctx->deflater.avail_in = (uInt)input_size;
+    ctx->deflater.next_out = output;
+    ctx->deflater.avail_out = (uInt)output_size;
+    status = deflate(&ctx->deflater, Z_FINISH);
+    if (status != Z_STREAM_END) {
+        return COMPRESS_ERROR_OVERFLOW;
+    }
+    
+    *compressed_size = (size_t)ctx->deflater.total_out;
+    record_compression(ctx, input_size, *compressed_size, start);
+    
+    return COMPRESS_SUCCESS;
+}
+
+static int zlib_decompress(compression_context_t* ctx,
+                           const uint8_t* input, size_t input_size,
+                           uint8_t* output, size_t output_size,
+                           size_t* decompressed_size) {
+    clock_t start = clock();
+    int status;
+    
+    if (ctx == NULL || input == NULL || output == NULL || decompressed_size == NULL) {
+        return COMPRESS_ERROR_INVALID;
+    }
+    
+    if (input_size > UINT32_MAX || output_size > UINT32_MAX) {
+        return COMPRESS_ERROR_CORRUPT;
+    }
+    
+    if (!ctx->has_inflater) {
+        memset(&ctx->inflater, 0, sizeof(ctx->inflater));
+        status = inflateInit(&ctx->inflater);
+        ctx->has_inflater = status == Z_OK;
+    } else {
+        status = inflateReset(&ctx->inflater);
+    }
+    if (status != Z_OK) {
+        return status == Z_MEM_ERROR ? COMPRESS_ERROR_MEMORY : COMPRESS_ERROR_INVALID;
+    }
+    
+    ctx->inflater.next_in = input;
+    ctx->inflater.avail_in = (uInt)input_size;
+    ctx->inflater.next_out = output;
+    ctx->inflater.avail_out = (uInt)output_size;
+    status = inflate(&ctx->inflater, Z_FINISH);
+    
+    /* A stream compressed against a dictionary asks for it after its header */
+    if (status == Z_NEED_DICT && ctx->dictionary != NULL &&
+        inflateSetDictionary(&ctx->inflater, ctx->dictionary,
+                             (uInt)ctx->dictionary_size) == Z_OK) {
+        status = inflate(&ctx->inflater, Z_FINISH);
+    }
+    if (status == Z_MEM_ERROR) {
+        return COMPRESS_ERROR_MEMORY;
+    }
+    if (status != Z_STREAM_END || ctx->inflater.total_out != output_size) {
+        return COMPRESS_ERROR_CORRUPT;
+    }
+    
+    *decompressed_size = (size_t)ctx->inflater.total_out;
+    ctx->stats.decompression_time += seconds_since(start);
+    
+    return COMPRESS_SUCCESS;
+}
+
+/* A stream compressed against a dictionary carries the dictionary's id too */
+static size_t zlib_max_compressed_size(size_t input_size) {
+    return (size_t)compressBound((uLong)input_size) + 4;
+}
+
+/* Deflate method with a header check that is a multiple of 31 */
+static bool zlib_validate(const uint8_t* data, size_t size) {
+    return data != NULL && size >= 2 && (data[0] & 0x0F) == 8 &&
+           ((unsigned)data[0] * 256 + data[1]) % 31 == 0;
+}
+
+const compression_algorithm_t compression_zlib_algorithm = {
+    .name = "zlib",
+    .type = STAR_COMPRESS_ZLIB,
+    .supports_dictionary = true,
+    .create_context = create_context,
+    .destroy_context = destroy_context,
+    .compress = zlib_compress,
+    .decompress = zlib_decompress,
+    .get_max_compressed_size = zlib_max_compressed_size,
+    .validate_compressed_data = zlib_validate,
+    .get_stats = get_stats
+};
+
+#endif /* ENABLE_ZLIB */
+
+/* LZMA2 in an .xz stream, without a check: members carry their own CRC32 */
+
+#ifdef ENABLE_LZMA
+
+static const uint8_t xz_magic[6] = {0xFD, '7', 'z', 'X', 'Z', 0x00};
+
+static int lzma_compress(compression_context_t* ctx,
+                         const uint8_t* input, size_t input_size,
+                         uint8_t* output, size_t output_size,
+                         size_t* compressed_size) {
+    clock_t start = clock();
+    lzma_ret status;
+    
+    if (ctx == NULL || (input == NULL && input_size > 0) || output == NULL ||
+        compressed_size == NULL) {
+        return COMPRESS_ERROR_INVALID;
+    }
+    
+    status = lzma_easy_encoder(&ctx->encoder, (uint32_t)ctx->level, LZMA_CHECK_NONE);
+    if (status != LZMA_OK) {
+        return status == LZMA_MEM_ERROR ? COMPRESS_ERROR_MEMORY : COMPRESS_ERROR_INVALID;
+    }
+    
+    ctx->encoder.next_in = input;
+    ctx->encoder.avail_in = input_size;
+    ctx->encoder.next_out = output;
+    ctx->encoder.avail_out = output_size;
+    status = lzma_code(&ctx->encoder, LZMA_FINISH);
+    if (status == LZMA_MEM_ERROR) {
+        return COMPRESS_ERROR_MEMORY;
+    }
+    if (status != LZMA_STREAM_END) {
+        return COMPRESS_ERROR_OVERFLOW;
+    }
+    
+    *compressed_size = output_size - ctx->encoder.avail_out;
+    record_compression(ctx, input_size, *compressed_size, start);
+    
+    return COMPRESS_SUCCESS;
+}
+
+static int lzma_decompress(compression_context_t* ctx,
+                           const uint8_t* input, size_t input_size,
+                           uint8_t* output, size_t output_size,
+                           size_t* decompressed_size) {
+    clock_t start = clock();
+    lzma_ret status;
+    
+    if (ctx == NULL || input == NULL || output == NULL || decompressed_size == NULL) {
+        return COMPRESS_ERROR_INVALID;
+    }
+    
+    status = lzma_stream_decoder(&ctx->decoder, UINT64_MAX, 0);
+    if (status != LZMA_OK) {
+        return status == LZMA_MEM_ERROR ? COMPRESS_ERROR_MEMORY : COMPRESS_ERROR_INVALID;
+    }
+    
+    ctx->decoder.next_in = input;
+    ctx->decoder.avail_in = input_size;
+    ctx->decoder.next_out = output;
+    ctx->decoder.avail_out = output_size;
+    status = lzma_code(&ctx->decoder, LZMA_FINISH);
+    if (status == LZMA_MEM_ERROR) {
+        return COMPRESS_ERROR_MEMORY;
+    }
+    if (status != LZMA_STREAM_END || ctx->decoder.avail_in != 0 ||
+        ctx->decoder.avail_out != 0) {
+        return COMPRESS_ERROR_CORRUPT;
+    }
+    
+    *decompressed_size = output_size;
+    ctx->stats.decompression_time += seconds_since(start);
+    
+    return COMPRESS_SUCCESS;
+}
+
+static size_t lzma_max_compressed_size(size_t input_size) {
+    return lzma_stream_buffer_bound(input_size);
+}
+
+static bool lzma_validate(const uint8_t* data, size_t size) {
+    return data != NULL && size >= sizeof(xz_magic) && memcmp(data, xz_magic, sizeof(xz_magic)) == 0;
+}
+
+const compression_algorithm_t compression_lzma_algorithm = {
+    .name = "lzma",
+    .type = STAR_COMPRESS_LZMA,
+    .create_context = create_context,
+    .destroy_context = destroy_context,
+    .compress = lzma_compress,
+    .decompress = lzma_decompress,
+    .get_max_compressed_size = lzma_max_compressed_size,
+    .validate_compressed_data = lzma_validate,
+    .get_stats = get_stats
+};
+
+#endif /* ENABLE_LZMA */
+
+/* Engine */
+
+static const compression_algorithm_t* const algorithms[] = {
+    &compression_none_algorithm,
+#ifdef ENABLE_LZ4
+    &compression_lz4_algorithm,
+#endif
+#ifdef ENABLE_ZLIB
+    &compression_zlib_algorithm,
+#endif
+#ifdef ENABLE_LZMA
+    &compression_lzma_algorithm,
+#endif
+};
+
+#define ALGORITHM_COUNT (sizeof(algorithms) / sizeof(algorithms[0]))
+
+const compression_algorithm_t* compression_get_algorithm(star_compression_t type) {
+    size_t i;
+    
+    for (i = 0; i < ALGORITHM_COUNT; i++) {
+        if (algorithms[i]->type == type) {
+            return algorithms[i];
+        }
+    }
+    
+    return NULL;
+}
+
+const compression_algorithm_t* compression_find_algorithm(const char* name) {
+    size_t i;
+    
+    if (name == NULL) {
+        return NULL;
+    }
+    
+    for (i = 0; i < ALGORITHM_COUNT; i++) {
+        if (strcmp(algorithms[i]->name, name) == 0) {
+            return algorithms[i];
+        }
+    }
+    
+    return NULL;
+}
+
+void compression_list_algorithms(const compression_algorithm_t** list, size_t* count) {
+    size_t i;
+    
+    if (count == NULL) {
+        return;
+    }
+    
+    for (i = 0; i < ALGORITHM_COUNT && list != NULL && i < *count; i++) {
+        list[i] = algorithms[i];
+    }
+    *count = list != NULL && *count < ALGORITHM_COUNT ? *count : ALGORITHM_COUNT;
+}
+
+int compression_compress_data(star_compression_t algorithm,
+                            int level,
+                            const uint8_t* input,
+                            size_t input_size,
+                            uint8_t** output,
+                            size_t* output_size) {
+    return compression_compress_with_dictionary(algorithm, level, NULL, 0, input, input_size,
+                                                output, output_size);
+}
+
+int compression_compress_with_dictionary(star_compression_t algorithm,
+                                         int level,
+                                         const uint8_t* dictionary,
+                                         size_t dictionary_size,
+                                         const uint8_t* input,
+                                         size_t input_size,
+                                         uint8_t** output,
+                                         size_t* output_size) {
+    const compression_algorithm_t* algo = compression_get_algorithm(algorithm);
+    compression_context_t* ctx;
+    uint8_t* buffer;
+    int result;
+    
+    if (algo == NULL || output == NULL || output_size == NULL) {
+        return COMPRESS_ERROR_INVALID;
+    }
+    
+    buffer = compression_allocate_buffer(algo->get_max_compressed_size(input_size));
+    ctx = compression_acquire_context(algorithm, level);
+    if (buffer == NULL || ctx == NULL) {
+        compression_free_buffer(buffer);
+        compression_release_context(algorithm, ctx);
+        return COMPRESS_ERROR_MEMORY;
+    }
+    
+    result = compression_set_dictionary(algorithm, ctx, dictionary, dictionary_size);
+    if (result == COMPRESS_SUCCESS) {
+        result = algo->compress(ctx, input, input_size, buffer,
+                                algo->get_max_compressed_size(input_size), output_size);
+    }
+    compression_release_context(algorithm, ctx);
+    
+    if (result != COMPRESS_SUCCESS) {
+        compression_free_buffer(buffer);
+        return result;
+    }
+    
+    *output = buffer;
+    return COMPRESS_SUCCESS;
+}
+
+int compression_decompress_into(star_compression_t algorithm,
+                                const uint8_t* input,
+                                size_t input_size,
+                                uint8_t* output,
+                                size_t output_size) {
+    return compression_decompress_with_dictionary(algorithm, NULL, 0, input, input_size,
+                                                  output, output_size);
+}
+
+int compression_decompress_with_dictionary(star_compression_t algorithm,
+                                           const uint8_t* dictionary,
+                                           size_t dictionary_size,
+                                           const uint8_t* input,
+                                           size_t input_size,
+                                           uint8_t* output,
+                                           size_t output_size) {
+    const compression_algorithm_t* algo = compression_get_algorithm(algorithm);
+    compression_context_t* ctx;
+    size_t size = 0;
+    int result;
+    
+    if (algo == NULL) {
+        return COMPRESS_ERROR_INVALID;
+    }
+    
+    ctx = compression_acquire_context(algorithm, -1);
+    if (ctx == NULL) {
+        return COMPRESS_ERROR_MEMORY;
+    }
+    
+    result = compression_set_dictionary(algorithm, ctx, dictionary, dictionary_size);
+    if (result == COMPRESS_SUCCESS) {
+        result = algo->decompress(ctx, input, input_size, output, output_size, &size);
+    }
+    compression_release_context(algorithm, ctx);
+    
+    return result == COMPRESS_SUCCESS && size != output_size ? COMPRESS_ERROR_CORRUPT : result;
+}
+
+int compression_decompress_data(star_compression_t algorithm,
+                              const uint8_t* input,
+                              size_t input_size,
+                              uint8_t** output,
+                              size_t* output_size) {
+    uint8_t* buffer;
+    int result;
+    
+    if (output == NULL || output_size == NULL) {
+        return COMPRESS_ERROR_INVALID;
+    }
+    
+    /* The stored formats do not record their size; the caller passes it in */
+    buffer = compression_allocate_buffer(*output_size > 0 ? *output_size : 1);
+    if (buffer == NULL) {
+        return COMPRESS_ERROR_MEMORY;
+    }
+    
+    result = compression_decompress_into(algorithm, input, input_size, buffer, *output_size);
+    if (result != COMPRESS_SUCCESS) {
+        compression_free_buffer(buffer);
+        return result;
+    }
+    
+    *output = buffer;
+    return COMPRESS_SUCCESS;
+}
+
+compression_context_t* compression_acquire_context(star_compression_t algorithm, int level) {
+    const compression_algorithm_t* algo = compression_get_algorithm(algorithm);
+    compression_context_t* ctx;
+    
+    if (algo == NULL) {
+        return NULL;
+    }
+    
+    pthread_mutex_lock(&cache_mutex);
+    ctx = cached_contexts[algorithm];
+    if (ctx != NULL) {
+        cached_contexts[algorithm] = ctx->next;
+        cached_context_count[algorithm]--;
+    }
+    pthread_mutex_unlock(&cache_mutex);
+    
+    if (ctx == NULL) {
+        return algo->create_context(compression_normalize_level(algorithm, level));
+    }
+    
+    ctx->level = compression_normalize_level(algorithm, level);
+    ctx->next = NULL;
+    ctx->dictionary = NULL;
+    ctx->dictionary_size = 0;
+    memset(&ctx->stats, 0, sizeof(ctx->stats));
+    
+    return ctx;
+}
+
+bool compression_supports_dictionary(star_compression_t algorithm) {
+    const compression_algorithm_t* algo = compression_get_algorithm(algorithm);
+    
+    return algo != NULL && algo->supports_dictionary;
+}
+
+int compression_set_dictionary(star_compression_t algorithm, compression_context_t* ctx,
+                               const uint8_t* dictionary, size_t size) {
+    if (ctx == NULL || (dictionary == NULL && size > 0) || size > STAR_MAX_DICTIONARY_SIZE) {
+        return COMPRESS_ERROR_INVALID;
+    }
+    
+    if (size > 0 && !compression_supports_dictionary(algorithm)) {
+        return COMPRESS_ERROR_INVALID;
+    }
+    
+    ctx->dictionary = size > 0 ? dictionary : NULL;
+    ctx->dictionary_size = size;
+    
+    return COMPRESS_SUCCESS;
+}
+
+void compression_release_context(star_compression_t algorithm, compression_context_t* ctx) {
+    if (ctx == NULL) {
+        return;
+    }
+    
+    pthread_mutex_lock(&cache_mutex);
+    if (compression_get_algorithm(algorithm) != NULL &&
+        cached_context_count[algorithm] < COMPRESS_CACHED_CONTEXTS) {
+        ctx->next = cached_contexts[algorithm];
+        cached_contexts[algorithm] = ctx;
+        cached_context_count[algorithm]++;
+        ctx = NULL;
+    }
+    pthread_mutex_unlock(&cache_mutex);
+    
+    destroy_context(ctx);
+}
+
+uint8_t* compression_allocate_buffer(size_t size) {
+    buffer_header_t* header = NULL;
+    unsigned size_class = COMPRESS_MIN_CLASS;
+    
+    while (size_class <= COMPRESS_MAX_CLASS && ((size_t)1 << size_class) < size) {
+        size_class++;
+    }
+    
+    if (size_class <= COMPRESS_MAX_CLASS) {
+        pthread_mutex_lock(&cache_mutex);
+        header = cached_buffers[size_class];
+        if (header != NULL) {
+            cached_buffers[size_class] = header->link.next;
+            cached_bytes -= (size_t)1 << size_class;
+        }
+        pthread_mutex_unlock(&cache_mutex);
+        size = (size_t)1 << size_class;
+    }
+    
+    if (header == NULL) {
+        if (size > SIZE_MAX - sizeof(buffer_header_t)) {
+            return NULL;
+        }
+        header = malloc(sizeof(buffer_header_t) + size);
+        if (header == NULL) {
+            return NULL;
+        }
+    }
+    
+    header->link.size_class = size_class;
+    header->link.next = NULL;
+    
+    return (uint8_t*)(header + 1);
+}
+
+void compression_free_buffer(uint8_t* buffer) {
+    buffer_header_t* header;
+    size_t size;
+    
+    if (buffer == NULL) {
+        return;
+    }
+    
+    header = (buffer_header_t*)(void*)buffer - 1;
+    if (header->link.size_class <= COMPRESS_MAX_CLASS) {
+        size = (size_t)1 << header->link.size_class;
+        pthread_mutex_lock(&cache_mutex);
+        if (cached_bytes + size <= COMPRESS_CACHE_BYTES) {
+            header->link.next = cached_buffers[header->link.size_class];
+            cached_buffers[header->link.size_class] = header;
+            cached_bytes += size;
+            header = NULL;
+        }
+        pthread_mutex_unlock(&cache_mutex);
+    }
+    
+    free(header);
+}
+
+void compression_release_cache(void) {
+    buffer_header_t* header;
+    compression_context_t* ctx;
+    size_t i;
+    
+    pthread_mutex_lock(&cache_mutex);
+    for (i = 0; i <= COMPRESS_MAX_CLASS; i++) {
+        while (cached_buffers[i] != NULL) {
+            header = cached_buffers[i];
+            cached_buffers[i] = header->link.next;
+            free(header);
+        }
+    }
+    cached_bytes = 0;
+    
+    for (i = 0; i <= STAR_COMPRESS_LZMA; i++) {
+        while (cached_contexts[i] != NULL) {
+            ctx = cached_contexts[i];
+            cached_contexts[i] = ctx->next;
+            destroy_context(ctx);
+        }
+        cached_context_count[i] = 0;
+    }
+    pthread_mutex_unlock(&cache_mutex);
+}
+
+/* Dictionary training */
+
+/* How widely one DICTIONARY_DMER byte run is shared */
+typedef struct dictionary_dmer {
+    uint32_t samples;               /* Samples it occurs in; 0 once in the dictionary */
+    uint32_t last_sample;           /* Last sample counted + 1 */
+} dictionary_dmer_t;
+
+/* A piece of one sample that may go into the dictionary */
+typedef struct dictionary_segment {
+    const uint8_t* data;
+    size_t length;
+    uint64_t score;
+    size_t order;                   /* Position among the segments, for a stable sort */
+} dictionary_segment_t;
+
+static uint32_t dmer_hash(const uint8_t* data) {
+    uint64_t value;
+    
+    memcpy(&value, data, sizeof(value));
+    return (uint32_t)((value * 0x9E3779B97F4A7C15ULL) >> (64 - DICTIONARY_HASH_BITS));
+}
+
+/* Runs that only one sample has are worth nothing: no other input can refer to them */
+static uint64_t score_segment(const dictionary_dmer_t* dmers, const uint8_t* data, size_t length) {
+    uint64_t score = 0;
+    uint32_t samples;
+    size_t i;
+    
+    for (i = 0; i + DICTIONARY_DMER <= length; i++) {
+        samples = dmers[dmer_hash(data + i)].samples;
+        score += samples > 1 ? samples - 1 : 0;
+    }
+    
+    return score;
+}
+
+static int compare_segments(const void* a, const void* b) {
+    const dictionary_segment_t* left = a;
+    const dictionary_segment_t* right = b;
+    
+    if (left->score != right->score) {
+        return left->score < right->score ? 1 : -1;
+    }
+    
+    return (left->order > right->order) - (left->order < right->order);
+}
+
+/* Score every segment that shares anything; *count is how many did */
+static int collect_segments(const dictionary_dmer_t* dmers, const uint8_t* const* samples,
+                            const size_t* sample_sizes, size_t sample_count,
+                            dictionary_segment_t** segments, size_t* count) {
+    size_t capacity = 0;
+    size_t offset;
+    size_t i;
+    dictionary_segment_t segment;
+    
+    for (i = 0; i < sample_count; i++) {
+        capacity += (sample_sizes[i] + DICTIONARY_SEGMENT - 1) / DICTIONARY_SEGMENT;
+    }
+    
+    *count = 0;
+    *segments = malloc((capacity > 0 ? capacity : 1) * sizeof(dictionary_segment_t));
+    if (*segments == NULL) {
+        return COMPRESS_ERROR_MEMORY;
+    }
+    
+    for (i = 0; i < sample_count; i++) {
+        for (offset = 0; offset < sample_sizes[i]; offset += DICTIONARY_SEGMENT) {
+            segment.data = samples[i] + offset;
+            segment.length = sample_sizes[i] - offset < DICTIONARY_SEGMENT ?
+                             sample_sizes[i] - offset : DICTIONARY_SEGMENT;
+            segment.score = score_segment(dmers, segment.data, segment.length);
+            segment.order = *count;
+            if (segment.score > 0) {
+                (*segments)[(*count)++] = segment;
+            }
+        }
+    }
+    
+    return COMPRESS_SUCCESS;
+}
+
+/*
+ * Greedy segment selection in the manner of zstd's COVER trainer. Runs
+ * are counted once per sample that has them, the most widely shared
+ * segments are taken first, and runs already in the dictionary stop
+ * counting, so a segment that mostly repeats earlier picks is skipped.
+ * The best segments go at the end, where LZ offsets to them are shortest
+ * and where a window smaller than the dictionary still reaches them.
+ */
+int compression_train_dictionary(const uint8_t* const* samples,
+                                 const size_t* sample_sizes,
+                                 size_t sample_count,
+                                 uint8_t* dictionary,
+                                 size_t capacity,
+                                 size_t* dictionary_size) {
+    dictionary_dmer_t* dmers;
+    dictionary_dmer_t* dmer;
+    dictionary_segment_t* segments = NULL;
+    size_t segment_count = 0;
+    size_t position = capacity;
+    size_t length;
+    size_t i;
+    size_t j;
+    int result;
+    
+    if ((samples == NULL || sample_sizes == NULL) && sample_count > 0) {
+        return COMPRESS_ERROR_INVALID;
+    }
+    if (dictionary == NULL || dictionary_size == NULL || capacity > STAR_MAX_DICTIONARY_SIZE ||
+        sample_count > UINT32_MAX - 1) {
+        return COMPRESS_ERROR_INVALID;
+    }
+    
+    dmers = calloc((size_t)1 << DICTIONARY_HASH_BITS, sizeof(dictionary_dmer_t));
+    if (dmers == NULL) {
+        return COMPRESS_ERROR_MEMORY;
+    }
+    
+    for (i = 0; i < sample_count; i++) {
+        for (j = 0; j + DICTIONARY_DMER <= sample_sizes[i]; j++) {
+            dmer = &dmers[dmer_hash(samples[i] + j)];
+            if (dmer->last_sample != (uint32_t)i + 1) {
+                dmer->last_sample = (uint32_t)i + 1;
+                dmer->samples++;
+            }
+        }
+    }
+    
+    result = collect_segments(dmers, samples, sample_sizes, sample_count, &segments,
+                              &segment_count);
+    if (result == COMPRESS_SUCCESS) {
+        qsort(segments, segment_count, sizeof(dictionary_segment_t), compare_segments);
+    }
+    
+    for (i = 0; result == COMPRESS_SUCCESS && i < segment_count && position > 0; i++) {
+        if (score_segment(dmers, segments[i].data, segments[i].length) * 2 < segments[i].score) {
+            continue;
+        }
+        
+        length = segments[i].length < position ? segments[i].length : position;
+        memcpy(dictionary + position - length, segments[i].data, length);
+        position -= length;
+        
+        for (j = 0; j + DICTIONARY_DMER <= segments[i].length; j++) {
+            dmers[dmer_hash(segments[i].data + j)].samples = 0;
+        }
+    }
+    
+    if (result == COMPRESS_SUCCESS) {
+        memmove(dictionary, dictionary + position, capacity - position);
+        *dictionary_size = capacity - position;
+    }
+    
+    free(segments);
+    free(dmers);
+    
+    return result;
+}
+
+star_compression_t compression_detect_algorithm(const uint8_t* data, size_t size) {
+#ifdef ENABLE_LZMA
+    if (lzma_validate(data, size)) {
+        return STAR_COMPRESS_LZMA;
+    }
+#endif
+#ifdef ENABLE_ZLIB
+    if (zlib_validate(data, size)) {
+        return STAR_COMPRESS_ZLIB;
+    }
+#endif
+    (void)data;
+    (void)size;
+    
+    /* LZ4 blocks carry no signature */
+    return STAR_COMPRESS_NONE;
+}
+
+bool compression_validate_data(star_compression_t algorithm,
+                              const uint8_t* data,
+                              size_t size) {
+    const compression_algorithm_t* algo = compression_get_algorithm(algorithm);
+    
+    return algo != NULL && algo->validate_compressed_data(data, size);
+}
+
+int compression_get_default_level(star_compression_t algorithm) {
+    switch (algorithm) {
+        case STAR_COMPRESS_LZ4:  return 1;
+        case STAR_COMPRESS_ZLIB: return 6;
+        case STAR_COMPRESS_LZMA: return 6;
+        default:                 return 0;
+    }
+}
+
+int compression_get_max_level(star_compression_t algorithm) {
+    return algorithm == STAR_COMPRESS_NONE ? 0 : 9;
+}
+
+int compression_normalize_level(star_compression_t algorithm, int level) {
+    int max_level = compression_get_max_level(algorithm);
+    
+    if (level < 0) {
+        return compression_get_default_level(algorithm);
+    }
+    
+    return level > max_level ? max_level : level;
+}
+
+const char* compression_algorithm_to_string(star_compression_t algorithm) {
+    switch (algorithm) {
+        case STAR_COMPRESS_NONE: return "none";
+        case STAR_COMPRESS_LZ4:  return "lz4";
+        case STAR_COMPRESS_ZLIB: return "zlib";
+        case STAR_COMPRESS_LZMA: return "lzma";
+        case STAR_COMPRESS_AUTO: return "auto";
+        default:                 return "unknown";
+    }
+}
+
+star_compression_t compression_algorithm_from_string(const char* name) {
+    if (name != NULL) {
+        if (strcmp(name, "lz4") == 0) {
+            return STAR_COMPRESS_LZ4;
+        }
+        if (strcmp(name, "zlib") == 0) {
+            return STAR_COMPRESS_ZLIB;
+        }
+        if (strcmp(name, "lzma") == 0) {
+            return STAR_COMPRESS_LZMA;
+        }
+        if (strcmp(name, "auto") == 0) {
+            return STAR_COMPRESS_AUTO;
+        }
+    }
+    
+    return STAR_COMPRESS_NONE;
+}
+
+/*
+ * Typical compressed size of object code, for planning before any of the
+ * data has been seen: a ratio that improves a little with the level, plus
+ * the format's fixed overhead, which is what decides it for tiny inputs.
+ */
+size_t compression_estimate_compressed_size(star_compression_t algorithm,
+                                           size_t input_size,
+                                           int level) {
+    double ratio;
+    size_t overhead;
+    
+    level = compression_normalize_level(algorithm, level);
+    switch (algorithm) {
+        case STAR_COMPRESS_LZ4:
+            ratio = 0.55 - 0.01 * level;
+            overhead = 1;
+            break;
+        case STAR_COMPRESS_ZLIB:
+            ratio = 0.42 - 0.01 * level;
+            overhead = 8;
+            break;
+        case STAR_COMPRESS_LZMA:
+            ratio = 0.38 - 0.01 * level;
+            overhead = 52;
+            break;
+        default:
+            return input_size;
+    }
+    
+    return (size_t)((double)input_size * ratio) + overhead;
+}
+
+/*
+ * Each direction is repeated until it has run for at least
+ * COMPRESS_BENCHMARK_SECONDS of processor time, so that even small inputs
+ * are timed well above the clock's resolution.
+ */
+int compression_benchmark_algorithm(star_compression_t algorithm,
+                                   int level,
+                                   const uint8_t* test_data,
+                                   size_t test_size,
+                                   compression_benchmark_t* result) {
+    const compression_algorithm_t* algo = compression_get_algorithm(algorithm);
+    compression_context_t* ctx;
+    uint8_t* compressed;
+    uint8_t* output;
+    size_t capacity;
+    size_t compressed_size = 0;
+    size_t size = 0;
+    size_t runs;
+    clock_t start;
+    double seconds;
+    double megabytes = (double)test_size / 1e6;
+    int status = COMPRESS_SUCCESS;
+    
+    if (algo == NULL || test_data == NULL || test_size == 0 || result == NULL) {
+        return COMPRESS_ERROR_INVALID;
+    }
+    
+    capacity = algo->get_max_compressed_size(test_size);
+    compressed = compression_allocate_buffer(capacity);
+    output = compression_allocate_buffer(test_size);
+    ctx = compression_acquire_context(algorithm, level);
+    if (compressed == NULL || output == NULL || ctx == NULL) {
+        status = COMPRESS_ERROR_MEMORY;
+    }
+    
+    memset(result, 0, sizeof(*result));
+    result->algorithm = algorithm;
+    result->level = compression_normalize_level(algorithm, level);
+    result->input_size = test_size;
+    result->memory_usage = capacity + test_size;
+    
+    start = clock();
+    seconds = 0.0;
+    for (runs = 0; status == COMPRESS_SUCCESS && (runs == 0 || seconds < COMPRESS_BENCHMARK_SECONDS);
+         runs++) {
+        status = algo->compress(ctx, test_data, test_size, compressed, capacity, &compressed_size);
+        seconds = seconds_since(start);
+    }
+    if (status == COMPRESS_SUCCESS) {
+        result->compression_speed = seconds > 0.0 ? megabytes * (double)runs / seconds : 0.0;
+        result->compression_ratio = compression_calculate_ratio(test_size, compressed_size);
+    }
+    
+    start = clock();
+    seconds = 0.0;
+    for (runs = 0; status == COMPRESS_SUCCESS && (runs == 0 || seconds < COMPRESS_BENCHMARK_SECONDS);
+         runs++) {
+        status = algo->decompress(ctx, compressed, compressed_size, output, test_size, &size);
+        seconds = seconds_since(start);
+    }
+    if (status == COMPRESS_SUCCESS && (size != test_size ||
+                                       memcmp(output, test_data, test_size) != 0)) {
+        status = COMPRESS_ERROR_CORRUPT;
+    }
+    if (status == COMPRESS_SUCCESS) {
+        result->decompression_speed = seconds > 0.0 ? megabytes * (double)runs / seconds : 0.0;
+    }
+    
+    compression_release_context(algorithm, ctx);
+    compression_free_buffer(compressed);
+    compression_free_buffer(output);
+    
+    return status;
+}
+
+const char* compression_get_error_string(int error_code) {
+    switch (error_code) {
+        case COMPRESS_SUCCESS:        return "Success";
+        case COMPRESS_ERROR_INVALID:  return "Invalid argument";
+        case COMPRESS_ERROR_MEMORY:   return "Out of memory";
+        case COMPRESS_ERROR_CORRUPT:  return "Corrupt compressed data";
+        case COMPRESS_ERROR_OVERFLOW: return "Output buffer too small";
+        default:                      return "Unknown compression error";
+    }
+}
@@ -24,6 +24,22 @@ extern "C" {
 #define STAR_MEMBER_HEADER_SIZE 128
 #define STAR_CHECKSUM_SIZE 4
 
+/* Read size used when streaming member data into an archive */
+#define ARCHIVE_STREAM_CHUNK_SIZE 65536
+
+/* Dictionary training reads at most this many samples of this many bytes */
+#define ARCHIVE_DICTIONARY_SAMPLES 2048
+#define ARCHIVE_DICTIONARY_SAMPLE_SIZE 16384
+
+/*
+ * STAR_COMPRESS_AUTO tries the algorithms on members up to the sample
+ * size whole and on evenly spaced chunks of larger ones, and stores a
+ * member as it is unless it saves at least 1/ARCHIVE_AUTO_MIN_SAVING
+ */
+#define ARCHIVE_AUTO_SAMPLE_SIZE 16384
+#define ARCHIVE_AUTO_SAMPLE_CHUNKS 4
+#define ARCHIVE_AUTO_MIN_SAVING 16
+
 /* Archive header structure */
 typedef struct star_header {
     uint32_t magic;                 /* Archive magic 'STAR' */
@@ -37,7 +53,9 @@ typedef struct star_header {
     uint32_t string_table_size;     /* String table size */
     uint32_t creation_time;         /* Archive creation time */
     uint32_t checksum;              /* Header checksum */
-    uint8_t reserved[24];           /* Reserved for future use */
+    uint32_t dictionary_offset;     /* Shared compression dictionary offset */
+    uint32_t dictionary_size;       /* Dictionary size, 0 = none */
+    uint8_t reserved[16];           /* Reserved for future use */
 } star_header_t;
 
 /* Member header structure */
@@ -50,10 +68,21 @@ typedef struct star_member_header {
     uint32_t timestamp;             /* Modification timestamp */
     uint16_t flags;                 /* Member flags */
     uint8_t compression;            /* Compression algorithm */
-    uint8_t reserved1;              /* Reserved */
+    uint8_t block_shift;            /* Log2 block size if blocked, else 0 */
     uint8_t reserved2[100];         /* Reserved for future use */
 } star_member_header_t;
 
+/*
+ * A block-compressed member's stored data starts with one entry per
+ * block and an end entry, whose offset is the compressed size. Offsets
+ * are relative to the member's data; a block whose stored length equals
+ * its uncompressed length is kept as it is.
+ */
+typedef struct star_block_entry {
+    uint32_t offset;                /* Stored block offset */
+    uint32_t checksum;              /* CRC32 of the uncompressed block */
+} star_block_entry_t;
+
 /* Symbol index entry */
 typedef struct star_symbol_entry {
     uint32_t name_offset;           /* Symbol name offset */
@@ -64,9 +93,18 @@ typedef struct star_symbol_entry {
     uint16_t reserved;              /* Reserved */
 } star_symbol_entry_t;
 
+/* A byte range of the archive file */
+typedef struct archive_extent {
+    uint32_t offset;
+    uint32_t size;
+} archive_extent_t;
+
 /* Forward declarations */
 typedef struct archive_file archive_file_t;
 typedef struct archive_member archive_member_t;
+struct thread_pool;
+struct archive_dedup;
+struct archive_io;
 
 /* Archive file handle */
 struct archive_file {
@@ -74,25 +112,59 @@ struct archive_file {
     star_header_t header;           /* Archive header */
     archive_member_t* members;      /* Member array */
     char* string_table;             /* String table */
+    size_t string_capacity;         /* Bytes allocated for string_table */
+    uint32_t* string_slots;         /* Open-addressed string offsets, 0 = empty slot */
+    size_t string_slot_count;       /* Power of two, 0 until a string is added */
+    size_t string_count;            /* Strings indexed in string_slots */
+    uint32_t* member_slots;         /* Open-addressed member index + 1, 0 = empty slot */
+    size_t member_slot_count;       /* Power of two, 0 until members are loaded */
+    bool members_sorted;            /* Members are in name order, found by binary search */
+    uint8_t* map;                   /* Read-only file mapping, NULL unless archive_map */
+    size_t map_size;
+    struct thread_pool* pool;       /* Block decompression workers (not owned) */
+    struct archive_dedup* dedup;    /* Stored data by checksum and size, NULL unless deduplicating */
+    struct archive_io* io;          /* Batched I/O backend, NULL = vectored calls (owned) */
     star_symbol_entry_t* symbols;   /* Symbol index */
     bool is_open;                   /* File is open */
     bool is_writable;               /* File is writable */
+    bool is_streaming;              /* Member data goes straight to the file */
+    bool is_updating;               /* Opened by archive_open_for_update */
+    star_compression_t compression; /* Algorithm new members are stored with, or AUTO */
+    int compression_level;          /* Unused in auto mode, which takes the defaults */
+    uint8_t decode_goal;            /* Auto: weight of decode speed over size, 0-100 */
+    uint8_t block_shift;            /* Log2 compression block size, 0 = whole members */
+    uint8_t* dictionary;            /* Shared dictionary, header.dictionary_size bytes */
+    size_t dictionary_capacity;     /* Dictionary size to train on creation, 0 = none */
+    uint32_t stream_start;          /* First byte after the reserved tables */
+    uint32_t stream_offset;         /* Where the next streamed member goes */
+    archive_extent_t* free_extents; /* Unreferenced gaps while updating, by offset */
+    size_t free_count;
+    uint32_t file_end;              /* Where space past the gaps starts while updating */
     const char* filename;           /* Archive filename */
 };
 
 /* Archive member */
 struct archive_member {
     star_member_header_t header;    /* Member header */
-    char* name;                     /* Member name */
+    char* name;                     /* Member name, in the mapping if mapped */
     uint8_t* data;                  /* Member data (if loaded) */
     bool data_loaded;               /* Data is loaded in memory */
     uint32_t index;                 /* Member index */
 };
 
+/* A member read, checksummed and compressed but not yet written */
+typedef struct archive_prepared_member {
+    star_member_header_t header;    /* Sizes, checksum, timestamp and compression */
+    uint8_t* data;                  /* Uncompressed member data */
+    uint8_t* stored;                /* Compressed data, NULL if stored as is */
+    bool duplicate;                 /* Same data as a stored member, at header.data_offset */
+} archive_prepared_member_t;
+
 /* C99 static assertions for structure sizes */
 _Static_assert(sizeof(star_header_t) == 64, "STAR header must be 64 bytes");
 _Static_assert(sizeof(star_member_header_t) == 128, "STAR member header must be 128 bytes");
 _Static_assert(sizeof(star_symbol_entry_t) == 16, "STAR symbol entry must be 16 bytes");
+_Static_assert(sizeof(star_block_entry_t) == 8, "STAR block entry must be 8 bytes");
 
 /* Archive file operations */
 archive_file_t* archive_open(const char* filename, const char* mode);
@@ -116,21 +188,155 @@ int archive_add_member_from_file(archive_file_t* archive,
                                 const char* member_name,
                                 const char* file_path);
 
+/*
+ * Streaming creation. archive_reserve_members fixes the member names up
+ * front, so the member and string tables have a known size and member
+ * data can follow them at once; archive_stream_member_from_file then
+ * copies one file in ARCHIVE_STREAM_CHUNK_SIZE pieces, computing its CRC
+ * on the way, and archive_finalize writes the tables and the index. Only
+ * one chunk of member data is ever held in memory, except that a member
+ * to be compressed or deduplicated is read whole.
+ */
+int archive_reserve_members(archive_file_t* archive, const char* const* names, size_t count);
+int archive_stream_member_from_file(archive_file_t* archive, uint32_t index,
+                                    const char* file_path);
+
+/*
+ * The two halves of streaming a compressed member, so members can be
+ * compressed in parallel and written in order. archive_prepare_member
+ * reads and compresses a file without touching the archive and may run
+ * on any thread; archive_stream_prepared_member appends the result as
+ * member index and releases the prepared buffers whether or not the
+ * write succeeds. archive_release_prepared_member discards a prepared
+ * member that will not be written.
+ *
+ * With the deduplicate option, a member whose checksum, size and then
+ * contents match a member already stored is not compressed or written
+ * again: its header points at the same data.
+ */
+int archive_prepare_member(const archive_file_t* archive, const char* file_path,
+                           archive_prepared_member_t* prepared);
+int archive_stream_prepared_member(archive_file_t* archive, uint32_t index,
+                                   archive_prepared_member_t* prepared);
+void archive_release_prepared_member(archive_prepared_member_t* prepared);
+
+/*
+ * Shared compression dictionary. Members compressed with LZ4 or zlib are
+ * compressed against it and flagged STAR_MEMBER_FLAG_DICTIONARY, which
+ * lets small members that share most of their content compress well.
+ * It is stored once, ahead of the member data, so it must be set before
+ * any member data is written: archive_set_dictionary copies a given one,
+ * and archive_train_dictionary trains one of the size the options asked
+ * for from the start of up to ARCHIVE_DICTIONARY_SAMPLES of the files,
+ * doing nothing if the algorithm cannot use it. An archive finalized
+ * from members held in memory trains its own.
+ */
+int archive_set_dictionary(archive_file_t* archive, const uint8_t* data, size_t size);
+int archive_train_dictionary(archive_file_t* archive, const char* const* paths, size_t count);
+
+/*
+ * In-place update. archive_open_for_update loads the member table and
+ * treats the gaps between everything the header refers to as free space.
+ * archive_update_member_from_file replaces the member of that name, or
+ * adds one, writing its data into the first gap it fits or else at the
+ * end of the file; archive_delete_member drops a member. Nothing the
+ * header on disk refers to is overwritten: archive_commit_update writes
+ * new member and string tables and index into free space and the header
+ * last, so an update that is not committed leaves the archive as it was.
+ * Space given up by an update is only reused by the next one, and
+ * archive_compact copies the live members to a new file without gaps.
+ * New data uses the options' compression, or the archive's when the
+ * options ask for none, and is deduplicated against every member already
+ * stored if the options ask for that. Data shared by several members
+ * stays shared through compaction.
+ */
+archive_file_t* archive_open_for_update(const char* filename, const star_options_t* options);
+int archive_update_member_from_file(archive_file_t* archive, const char* name,
+                                    const char* file_path);
+int archive_commit_update(archive_file_t* archive);
+uint64_t archive_free_space(const archive_file_t* archive);
+int archive_compact(const char* filename, const char* output_filename);
+
+/*
+ * Constant time once members are loaded; the first of equal names wins.
+ * An archive with STAR_FLAG_SORTED (the sort_members option) has its
+ * member table written in name order, and readers find its members by
+ * binary search instead of hashing them; members added while updating
+ * go in at their place. A table that turns out not to be in order is
+ * hashed as usual.
+ */
 archive_member_t* archive_find_member(const archive_file_t* archive, const char* name);
 archive_member_t* archive_get_member(const archive_file_t* archive, uint32_t index);
 
 /* Archive loading */
 int archive_load_members(archive_file_t* archive);
 
+/*
+ * Random-access reading. archive_map opens an archive read-only, maps the
+ * whole file and loads the member table in place: names point into the
+ * mapping instead of being copied, and archive_member_data returns a
+ * member's stored bytes without reading them; for a compressed member
+ * these are compressed_size bytes in its compression format. Strings
+ * cannot be added to a mapped archive.
+ */
+archive_file_t* archive_map(const char* filename);
+const uint8_t* archive_member_data(const archive_file_t* archive,
+                                   const archive_member_t* member);
+
+/*
+ * Extraction never moves the file position, so members of an archive
+ * opened for reading can be extracted from several threads at once.
+ * archive_extract_memory is the most archive_extract_member holds in
+ * memory for a member: the whole member when it is compressed, one
+ * chunk when it is copied from the file.
+ */
 int archive_extract_member(const archive_file_t* archive,
                           const archive_member_t* member,
                           const char* output_path);
-
+size_t archive_extract_memory(const archive_file_t* archive, const archive_member_t* member);
+
+/*
+ * archive_read_member decompresses a whole member into output, which
+ * holds header.size bytes, and checks its CRC. archive_read_member_range
+ * reads size bytes from offset: for a block-compressed member only the
+ * blocks covering the range are read, each checked against its own CRC,
+ * and several blocks are decompressed on the archive's thread pool if it
+ * has one. The symbol index written on finalizing or committing is
+ * built on the same pool, several members at a time. The pool must not
+ * be the one the caller is running on.
+ */
+void archive_set_thread_pool(archive_file_t* archive, struct thread_pool* pool);
+int archive_read_member(const archive_file_t* archive, const archive_member_t* member,
+                        uint8_t* output);
+int archive_read_member_range(const archive_file_t* archive, const archive_member_t* member,
+                              uint32_t offset, size_t size, uint8_t* output);
+
+/*
+ * Batched extraction. archive_read_stored reads the stored bytes of
+ * count members, archive_stored_size(members[i]) bytes into buffers[i],
+ * as one batch on the archive's I/O backend (see archive_io.h), which
+ * archive_set_io_backend picks; mapped members are copied. Without a
+ * backend set, batches go out as vectored calls. archive_decode_stored
+ * then turns one member's stored bytes into its header.size bytes of
+ * data in output, checking the CRC of a compressed member; for an
+ * uncompressed one output may be stored itself. Unlike
+ * archive_read_member it never uses the archive's thread pool, so
+ * several members may be decoded on that pool at once.
+ */
+int archive_set_io_backend(archive_file_t* archive, star_io_backend_t backend);
+uint32_t archive_stored_size(const archive_member_t* member);
+int archive_read_stored(const archive_file_t* archive, const archive_member_t* const* members,
+                        uint8_t* const* buffers, size_t count);
+int archive_decode_stored(const archive_file_t* archive, const archive_member_t* member,
+                          const uint8_t* stored, uint8_t* output);
+
+/* Decompressed copy of the member's data; the caller frees it */
 int archive_extract_member_to_memory(const archive_file_t* archive,
                                     const archive_member_t* member,
                                     uint8_t** data,
                                     size_t* size);
 
+/* Only while updating; the member's data becomes free space on commit */
 int archive_delete_member(archive_file_t* archive, const char* name);
 
 /* Symbol index management */
@@ -144,7 +350,12 @@ int archive_add_symbol(archive_file_t* archive,
 
 star_symbol_entry_t* archive_find_symbol(const archive_file_t* archive, const char* name);
 
-/* String table management */
+/*
+ * String table management. Adding a string returns the offset of an
+ * equal string already in the table; lookups go through a hash over the
+ * table's offsets and the table grows geometrically, so interning N names
+ * is linear in N.
+ */
 int archive_add_string(archive_file_t* archive, const char* str, uint32_t* offset);
 const char* archive_get_string(const archive_file_t* archive, uint32_t offset);
 
@@ -197,6 +408,10 @@ static inline bool archive_has_index(const archive_file_t* archive) {
     return archive != NULL && (archive->header.flags & STAR_FLAG_INDEXED) != 0;
 }
 
+static inline bool archive_has_dictionary(const archive_file_t* archive) {
+    return archive != NULL && archive->dictionary != NULL;
+}
+
 static inline bool archive_is_sorted(const archive_file_t* archive) {
     return archive != NULL && (archive->header.flags & STAR_FLAG_SORTED) != 0;
 }
@@ -205,6 +420,11 @@ static inline bool archive_member_is_compressed(const archive_member_t* member)
     return member != NULL && (member->header.flags & STAR_MEMBER_FLAG_COMPRESSED) != 0;
 }
 
+static inline bool archive_member_is_blocked(const archive_member_t* member) {
+    return archive_member_is_compressed(member) &&
+           (member->header.flags & STAR_MEMBER_FLAG_BLOCKED) != 0;
+}
+
 static inline size_t archive_member_get_size(const archive_member_t* member) {
     return member ? member->header.size : 0;
 }
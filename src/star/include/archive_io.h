@@ -0,0 +1,68 @@
+/* src/star/include/archive_io.h */
+#ifndef ARCHIVE_IO_H_INCLUDED
+#define ARCHIVE_IO_H_INCLUDED
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "star.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file archive_io.h
+ * @brief Batched positional I/O for STAR archives
+ * @details A batch is a list of reads or writes of whole buffers at file
+ * offsets, possibly on different files. The pread backend issues one
+ * call per request; the vectored backend merges requests that are
+ * adjacent in the same file into one preadv/pwritev; the io_uring
+ * backend keeps up to ARCHIVE_IO_RING_ENTRIES requests in flight, which
+ * is what pays off when every call is a network round trip.
+ */
+
+/* Submission queue size of an io_uring instance */
+#define ARCHIVE_IO_RING_ENTRIES 64
+
+/* Requests merged into one vectored call at most */
+#define ARCHIVE_IO_MAX_VECTORS 1024
+
+/* One read or write: size bytes of buffer at offset in fd */
+typedef struct archive_io_request {
+    int fd;
+    void* buffer;
+    size_t size;
+    uint64_t offset;
+} archive_io_request_t;
+
+/* I/O backend instance (opaque) */
+typedef struct archive_io archive_io_t;
+
+/*
+ * STAR_IO_DEFAULT takes the best backend available, and a backend the
+ * system cannot provide falls back to the vectored one;
+ * archive_io_get_backend tells which was taken. An instance may be used
+ * from several threads: one that finds the ring busy does its batch with
+ * vectored calls instead. A NULL instance behaves as the vectored backend.
+ */
+archive_io_t* archive_io_create(star_io_backend_t backend);
+void archive_io_destroy(archive_io_t* io);
+star_io_backend_t archive_io_get_backend(const archive_io_t* io);
+bool archive_io_backend_is_available(star_io_backend_t backend);
+const char* archive_io_backend_to_string(star_io_backend_t backend);
+star_io_backend_t archive_io_backend_from_string(const char* name);
+
+/*
+ * Transfer every request in full, in no particular order. Returns
+ * ERROR_SUCCESS, or ERROR_FILE_IO if any request fails or a read hits
+ * the end of its file; requests in a failed batch may be partly done.
+ */
+int archive_io_read(archive_io_t* io, const archive_io_request_t* requests, size_t count);
+int archive_io_write(archive_io_t* io, const archive_io_request_t* requests, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ARCHIVE_IO_H_INCLUDED */
@@ -41,6 +41,7 @@ typedef struct compression_context compression_context_t;
 typedef struct compression_algorithm {
     const char* name;               /* Algorithm name */
     star_compression_t type;        /* Algorithm type */
+    bool supports_dictionary;       /* Can compress against a dictionary */
     
     /* Create/destroy context */
     compression_context_t* (*create_context)(int level);
@@ -78,12 +79,78 @@ int compression_compress_data(star_compression_t algorithm,
                             uint8_t** output,
                             size_t* output_size);
 
+/*
+ * Stored data does not record its decompressed size, so *output_size
+ * passes it in; anything that does not decode to exactly that size is
+ * reported as COMPRESS_ERROR_CORRUPT.
+ */
 int compression_decompress_data(star_compression_t algorithm,
                               const uint8_t* input,
                               size_t input_size,
                               uint8_t** output,
                               size_t* output_size);
 
+/* Decompress into a caller buffer of exactly the decompressed size */
+int compression_decompress_into(star_compression_t algorithm,
+                                const uint8_t* input,
+                                size_t input_size,
+                                uint8_t* output,
+                                size_t output_size);
+
+/*
+ * Contexts and buffers are cached for reuse, safely from any thread.
+ * An acquired context is a new one or a released one with its tables
+ * and library state kept, set to level (-1 for the default) and with its
+ * statistics cleared; hand it back to the algorithm it came from.
+ * Buffers come in power-of-two size classes and must be freed with
+ * compression_free_buffer. compression_release_cache frees everything
+ * cached, for instance before a long idle period.
+ */
+compression_context_t* compression_acquire_context(star_compression_t algorithm, int level);
+void compression_release_context(star_compression_t algorithm, compression_context_t* ctx);
+void compression_release_cache(void);
+
+/*
+ * Dictionaries hold content typical of the data being compressed. LZ4
+ * and zlib refer back into one as if it came just before each input, so
+ * small inputs that share most of their content with each other compress
+ * nearly as well as they would together. Data compressed against a
+ * dictionary decodes only with the same bytes; LZ4 reaches the last 64KB
+ * of one and zlib the last 32KB. A dictionary attached to a context with
+ * compression_set_dictionary is borrowed until the context is released;
+ * the other algorithms accept only an empty one.
+ */
+bool compression_supports_dictionary(star_compression_t algorithm);
+int compression_set_dictionary(star_compression_t algorithm, compression_context_t* ctx,
+                               const uint8_t* dictionary, size_t size);
+int compression_compress_with_dictionary(star_compression_t algorithm,
+                                         int level,
+                                         const uint8_t* dictionary,
+                                         size_t dictionary_size,
+                                         const uint8_t* input,
+                                         size_t input_size,
+                                         uint8_t** output,
+                                         size_t* output_size);
+int compression_decompress_with_dictionary(star_compression_t algorithm,
+                                           const uint8_t* dictionary,
+                                           size_t dictionary_size,
+                                           const uint8_t* input,
+                                           size_t input_size,
+                                           uint8_t* output,
+                                           size_t output_size);
+
+/*
+ * Train a dictionary of at most capacity bytes from sample inputs. Only
+ * content that several samples share is taken; *dictionary_size is 0 if
+ * they share nothing worth keeping.
+ */
+int compression_train_dictionary(const uint8_t* const* samples,
+                                 const size_t* sample_sizes,
+                                 size_t sample_count,
+                                 uint8_t* dictionary,
+                                 size_t capacity,
+                                 size_t* dictionary_size);
+
 /* Memory management for compressed data */
 uint8_t* compression_allocate_buffer(size_t size);
 void compression_free_buffer(uint8_t* buffer);
@@ -104,7 +171,7 @@ int compression_normalize_level(star_compression_t algorithm, int level);
 /* None (no compression) */
 extern const compression_algorithm_t compression_none_algorithm;
 
-/* LZ4 compression */
+/* LZ4 block format, built in; level 0-9 sets the match search effort */
 #ifdef ENABLE_LZ4
 extern const compression_algorithm_t compression_lz4_algorithm;
 #endif
@@ -122,11 +189,18 @@ extern const compression_algorithm_t compression_lzma_algorithm;
 /* Utility functions */
 const char* compression_algorithm_to_string(star_compression_t algorithm);
 star_compression_t compression_algorithm_from_string(const char* name);
+
+/* A typical size for object code of input_size bytes, without looking at it */
 size_t compression_estimate_compressed_size(star_compression_t algorithm,
                                            size_t input_size,
                                            int level);
 
-/* Performance benchmarking */
+/*
+ * Performance benchmarking. compression_benchmark_algorithm compresses
+ * and decompresses test_data repeatedly for a few milliseconds each way
+ * and reports the speeds in processor time and the ratio
+ * compressed/original; it fails if the data does not survive the trip.
+ */
 typedef struct compression_benchmark {
     star_compression_t algorithm;   /* Algorithm type */
     int level;                      /* Compression level */
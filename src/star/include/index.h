@@ -18,9 +18,9 @@ extern "C" {
  * @details C99 compliant symbol index for fast symbol lookup
  */
 
-/* Index configuration */
+/* Index configuration: initial buckets, and the most symbols serialized counts hold */
 #define INDEX_HASH_TABLE_SIZE 1024
-#define INDEX_MAX_SYMBOLS 65536
+#define INDEX_MAX_SYMBOLS UINT32_MAX
 #define INDEX_SYMBOL_NAME_MAX 256
 
 /* Index entry flags */
@@ -37,7 +37,7 @@ typedef struct symbol_hash_table symbol_hash_table_t;
 
 /* Symbol index entry */
 struct symbol_index_entry {
-    char* name;                     /* Symbol name */
+    const char* name;               /* Symbol name */
     uint32_t name_hash;             /* Cached name hash */
     uint32_t member_index;          /* Member containing symbol */
     uint32_t symbol_value;          /* Symbol value/address */
@@ -92,12 +92,28 @@ typedef struct symbol_search_result {
     double relevance;               /* Search relevance (0.0-1.0) */
 } symbol_search_result_t;
 
+/*
+ * Definitions whose names match a pattern of literal characters, '?'
+ * for any one character and '*' for any run. found_count is the number
+ * of matches; results receives the max_results most relevant, best
+ * first and otherwise in name order. A literal prefix narrows the search
+ * to a range of the sorted names and patterns starting with '*' are
+ * filtered by trigrams, so neither scans the index. The structures for
+ * this are built on the first search after symbols are added, which
+ * makes searching from several threads at once unsafe.
+ */
 int symbol_index_find_symbols_by_pattern(const symbol_index_t* index,
                                         const char* pattern,
                                         symbol_search_result_t* results,
                                         size_t max_results,
                                         size_t* found_count);
 
+/*
+ * The definitions in one member, in name order: found_count of them, the
+ * first max_symbols stored in symbols. The entries are grouped by member
+ * on the first query after the index changes, so a query costs a binary
+ * search plus the member's own symbols.
+ */
 int symbol_index_find_symbols_by_member(const symbol_index_t* index,
                                        uint32_t member_index,
                                        symbol_index_entry_t** symbols,
@@ -113,6 +129,45 @@ int symbol_index_build_from_member(symbol_index_t* index,
                                   const archive_member_t* member,
                                   uint32_t member_index);
 
+/*
+ * Supplies a member's data to a parallel build. view starts as a copy of
+ * the member; the loader points its data at something
+ * symbol_index_build_from_member can read, or clears data_loaded to skip
+ * the member. Anything left in *buffer is freed once the member is
+ * indexed. pool is for the loader's own work and is NULL while members
+ * are being loaded in parallel.
+ */
+typedef int (*symbol_index_loader_t)(void* user_data, archive_member_t* view,
+                                     struct thread_pool* pool, uint8_t** buffer);
+
+/*
+ * Index every member on pool's threads. Contiguous runs of members are
+ * indexed into shards of their own, which are absorbed in member order,
+ * so duplicate and weak definitions resolve as in a serial build
+ * whatever the thread count. loader NULL indexes members whose data is
+ * loaded; symbol_index_build_from_archive is this on the archive's pool.
+ */
+int symbol_index_build_parallel(symbol_index_t* index,
+                               const archive_file_t* archive,
+                               struct thread_pool* pool,
+                               symbol_index_loader_t loader,
+                               void* user_data);
+
+/*
+ * Move other's definitions into index as if other's members came after
+ * index's, and destroy other. Names are not copied: index takes over
+ * other's storage. other must not be attached to serialized data.
+ */
+int symbol_index_absorb(symbol_index_t* index, symbol_index_t* other);
+
+/*
+ * Read the serialized index of an archive created with STAR_FLAG_INDEXED.
+ * The index is attached rather than rebuilt: in a mapped archive it is
+ * used where it lies, otherwise it is read in one piece.
+ */
+int symbol_index_load_from_archive(symbol_index_t* index,
+                                  const archive_file_t* archive);
+
 /* Serialization */
 int symbol_index_serialize(const symbol_index_t* index,
                           uint8_t** data,
@@ -122,6 +177,17 @@ int symbol_index_deserialize(symbol_index_t* index,
                             const uint8_t* data,
                             size_t size);
 
+/*
+ * Use a serialized index in place instead of copying it into the hash:
+ * the layout is a bucket table over fixed-size entries carrying their
+ * name hashes, and a lookup reads one bucket's entries where they lie.
+ * Only the sizes are checked here, so attaching costs the same for any
+ * number of symbols. data must outlive the index, which must be empty
+ * and stays read-only. Lookups fill in the entries they return, so an
+ * attached index is not safe to search from several threads at once.
+ */
+int symbol_index_attach(symbol_index_t* index, const uint8_t* data, size_t size);
+
 int symbol_index_write_to_file(const symbol_index_t* index,
                               const char* filename);
 
@@ -134,6 +200,7 @@ void symbol_index_foreach(const symbol_index_t* index,
                          symbol_index_visitor_t visitor,
                          void* user_data);
 
+/* Visit one member's definitions in name order, grouped as above */
 void symbol_index_foreach_in_member(const symbol_index_t* index,
                                    uint32_t member_index,
                                    symbol_index_visitor_t visitor,
@@ -144,7 +211,12 @@ void symbol_index_get_stats(const symbol_index_t* index, symbol_index_stats_t* s
 void symbol_index_dump(const symbol_index_t* index, FILE* output);
 void symbol_index_dump_hash_table(const symbol_index_t* index, FILE* output);
 
-/* Optimization */
+/*
+ * Optimization. The table grows by itself as symbols are added, moving a
+ * few chains per insert rather than all at once. symbol_index_rehash
+ * moves every chain now into at least new_size buckets, and
+ * symbol_index_optimize into twice as many buckets as symbols.
+ */
 int symbol_index_optimize(symbol_index_t* index);
 int symbol_index_rehash(symbol_index_t* index, size_t new_size);
 
@@ -50,6 +50,7 @@ extern "C" {
 #define STAR_FLAG_COMPRESSED    0x01
 #define STAR_FLAG_INDEXED       0x02
 #define STAR_FLAG_SORTED        0x04
+#define STAR_FLAG_DICTIONARY    0x08    /* Holds a shared compression dictionary */
 #define STAR_FLAG_LITTLE_ENDIAN 0x10
 #define STAR_FLAG_BIG_ENDIAN    0x20
 
@@ -57,6 +58,17 @@ extern "C" {
 #define STAR_MEMBER_FLAG_COMPRESSED 0x01
 #define STAR_MEMBER_FLAG_EXECUTABLE 0x02
 #define STAR_MEMBER_FLAG_READONLY   0x04
+#define STAR_MEMBER_FLAG_BLOCKED    0x08    /* Compressed in independent blocks */
+#define STAR_MEMBER_FLAG_DICTIONARY 0x10    /* Compressed against the archive's dictionary */
+
+/* Block compression: members larger than one block are split */
+#define STAR_MIN_BLOCK_SIZE     4096U
+#define STAR_MAX_BLOCK_SIZE     (16U * 1024U * 1024U)
+#define STAR_DEFAULT_BLOCK_SIZE (256U * 1024U)
+
+/* Shared dictionary: trained from the members when an archive is created */
+#define STAR_MAX_DICTIONARY_SIZE     (64U * 1024U)
+#define STAR_DEFAULT_DICTIONARY_SIZE (32U * 1024U)
 
 /**
  * @brief Archive operation mode
@@ -66,7 +78,8 @@ typedef enum {
     STAR_MODE_EXTRACT = 1,      /**< Extract from archive */
     STAR_MODE_UPDATE = 2,       /**< Update existing archive */
     STAR_MODE_LIST = 3,         /**< List archive contents */
-    STAR_MODE_DELETE = 4        /**< Delete members from archive */
+    STAR_MODE_DELETE = 4,       /**< Delete members from archive */
+    STAR_MODE_COMPACT = 5       /**< Reclaim free space in archive */
 } star_mode_t;
 
 /**
@@ -76,9 +89,20 @@ typedef enum {
     STAR_COMPRESS_NONE = 0,     /**< No compression */
     STAR_COMPRESS_LZ4 = 1,      /**< LZ4 compression */
     STAR_COMPRESS_ZLIB = 2,     /**< Zlib compression */
-    STAR_COMPRESS_LZMA = 3      /**< LZMA compression */
+    STAR_COMPRESS_LZMA = 3,     /**< LZMA compression */
+    STAR_COMPRESS_AUTO = 4      /**< Chosen per member when creating (archive option only) */
 } star_compression_t;
 
+/**
+ * @brief Archive I/O backend
+ */
+typedef enum {
+    STAR_IO_DEFAULT = 0,        /**< Best available */
+    STAR_IO_PREAD = 1,          /**< One pread/pwrite per request */
+    STAR_IO_VECTORED = 2,       /**< preadv/pwritev over adjacent requests */
+    STAR_IO_URING = 3           /**< io_uring with many requests in flight (Linux) */
+} star_io_backend_t;
+
 /**
  * @brief Archive options structure
  */
@@ -89,8 +113,14 @@ typedef struct star_options {
     bool sort_members;              /**< Sort members by name */
     bool verbose;                   /**< Enable verbose output */
     bool force_overwrite;           /**< Overwrite existing files */
-    size_t max_memory;              /**< Maximum memory usage */
+    size_t max_memory;              /**< Member data held at once when extracting (0 = no limit) */
     const char* temp_dir;           /**< Temporary directory */
+    size_t threads;                 /**< Worker threads (0 = one per CPU, 1 = serial) */
+    size_t block_size;              /**< Compression block size, a power of two (0 = whole members) */
+    size_t dictionary_size;         /**< Shared dictionary to train for LZ4 or zlib (0 = none) */
+    int decode_speed_goal;          /**< Auto mode: 0 = smallest members ... 100 = fastest decoding */
+    bool deduplicate;               /**< Store the data of identical members once */
+    star_io_backend_t io_backend;   /**< How batches of member reads and writes are issued */
 } star_options_t;
 
 /**
@@ -164,6 +194,10 @@ void star_set_progress_callback(star_context_t* context,
 /**
  * @brief Create new archive
  * 
+ * With compression enabled and more than one thread, members are read
+ * and compressed in parallel and written in their list order, so the
+ * archive is the same whatever the thread count.
+ * 
  * @param[in] context Archive context
  * @param[in] archive_path Path to archive file
  * @param[in] file_list Array of file paths to add
@@ -178,6 +212,10 @@ int star_create_archive(star_context_t* context,
 /**
  * @brief Extract from archive
  * 
+ * Members are extracted in parallel when the context has more than one
+ * thread, with at most max_memory bytes of member data held at a time.
+ * Every named member must exist before anything is extracted.
+ * 
  * @param[in] context Archive context
  * @param[in] archive_path Path to archive file
  * @param[in] output_dir Output directory (NULL for current)
@@ -194,6 +232,12 @@ int star_extract_archive(star_context_t* context,
 /**
  * @brief Update archive with new/modified files
  * 
+ * Files replace the members of the same name, or are added, in place:
+ * their data goes into space freed by earlier updates or at the end of
+ * the archive, and only the member and string tables and the index are
+ * written again. Members keep the archive's compression unless the
+ * options ask for one. An update that fails leaves the archive as it was.
+ * 
  * @param[in] context Archive context
  * @param[in] archive_path Path to archive file
  * @param[in] file_list Array of file paths to update
@@ -222,6 +266,10 @@ int star_list_archive(star_context_t* context,
 /**
  * @brief Delete members from archive
  * 
+ * Members are dropped from the tables in place and their data becomes
+ * free space for later updates. Nothing is deleted unless every member
+ * exists.
+ * 
  * @param[in] context Archive context
  * @param[in] archive_path Path to archive file
  * @param[in] member_list Members to delete
@@ -233,6 +281,18 @@ int star_delete_members(star_context_t* context,
                        const char* const* member_list,
                        size_t member_count);
 
+/**
+ * @brief Rewrite archive without free space
+ * 
+ * Live members are copied as stored, without recompressing them, to a
+ * new file that then replaces the archive.
+ * 
+ * @param[in] context Archive context
+ * @param[in] archive_path Path to archive file
+ * @return 0 on success, negative error code on failure
+ */
+int star_compact_archive(star_context_t* context, const char* archive_path);
+
 /**
  * @brief Get archive statistics
  * 
@@ -251,17 +311,42 @@ int star_get_stats(star_context_t* context,
  * @param[in] context Archive context
  * @param[in] archive_path Path to archive file
  * @param[in] member_name Member to extract
- * @param[out] data Pointer to store extracted data
+ * @param[out] data Pointer to the member data in the mapped archive
  * @param[out] size Size of extracted data
  * @return 0 on success, negative error code on failure
- * @note Caller must free the returned data
+ * @note The data is not copied. The context keeps the archive mapped and
+ *       reuses the mapping while the file is unchanged; the data stays
+ *       valid until the context is destroyed or used on another archive.
+ *       A compressed member is decompressed into a buffer the context
+ *       owns, valid until the next call.
  */
 int star_extract_member_to_memory(star_context_t* context,
                                  const char* archive_path,
                                  const char* member_name,
-                                 uint8_t** data,
+                                 const uint8_t** data,
                                  size_t* size);
 
+/**
+ * @brief Read part of a member
+ * 
+ * @param[in] context Archive context
+ * @param[in] archive_path Path to archive file
+ * @param[in] member_name Member to read
+ * @param[in] offset First byte to read, in the uncompressed member
+ * @param[out] output Buffer for size bytes
+ * @param[in] size Number of bytes to read
+ * @return 0 on success, negative error code on failure
+ * @note For a member compressed in blocks only the blocks covering the
+ *       range are decompressed, on the context's threads. The archive
+ *       mapping is shared with star_extract_member_to_memory.
+ */
+int star_read_member_range(star_context_t* context,
+                           const char* archive_path,
+                           const char* member_name,
+                           size_t offset,
+                           uint8_t* output,
+                           size_t size);
+
 /**
  * @brief Add member from memory
  * 
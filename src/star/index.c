@@ -0,0 +1,1697 @@
+/* src/star/index.c */
+#include "index.h"
+#include "archive.h"
+#include "../common/include/error.h"
+#include "../common/include/memory.h"
+#include "../common/include/smof.h"
+#include "../common/include/thread_pool.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file index.c
+ * @brief Symbol index implementation for STAR archives
+ * @details Chained hash table of the global definitions in an archive's
+ * members. Entries and names live in one arena, so building and dropping
+ * an index costs a handful of allocations; a parallel build fills one
+ * index per run of members and merges them in member order. The serialized form is written
+ * after the member data and lets a linker find the member defining a
+ * symbol without reading any member; it is itself a hash table, so it
+ * can be searched where it lies instead of being loaded first.
+ */
+
+/* Arena growth step for entries and names */
+#define INDEX_ARENA_BLOCK_SIZE 16384
+
+/*
+ * The bucket array doubles once there are more entries than buckets.
+ * The old array is then drained INDEX_REHASH_STEP buckets per insert,
+ * which empties it long before the next doubling is due.
+ */
+#define INDEX_MAX_LOAD_FACTOR 1
+#define INDEX_REHASH_STEP 4
+
+/* Shards per worker thread in a parallel build, to even out member sizes */
+#define INDEX_SHARDS_PER_THREAD 4
+
+/* Trigrams are hashed into this many posting lists; collisions only widen a filter */
+#define INDEX_TRIGRAM_BITS 16
+#define INDEX_TRIGRAM_BUCKETS ((size_t)1 << INDEX_TRIGRAM_BITS)
+
+/* Most trigrams of a pattern's literal text used to filter */
+#define INDEX_PATTERN_TRIGRAMS 32
+
+/*
+ * Serialized index: header, bucket_count + 1 bucket starts, entries
+ * ordered by bucket, then the name pool. Bucket b's entries run from
+ * start b to start b + 1, so a lookup reads one bucket's entries where
+ * they lie and nothing has to be parsed or rebuilt first. Every offset
+ * is relative to the start of the index.
+ */
+#define INDEX_SERIAL_MAGIC 0x32444953U  /* 'SID2' */
+
+/* The older layout: no buckets, entries in any order */
+#define INDEX_LEGACY_MAGIC 0x58444953U  /* 'SIDX' */
+
+typedef struct index_file_header {
+    uint32_t magic;
+    uint32_t symbol_count;
+    uint32_t names_size;             /* Bytes in the name pool */
+    uint32_t bucket_count;           /* Power of two; 0 in the legacy layout */
+} index_file_header_t;
+
+typedef struct index_file_entry {
+    uint32_t name_offset;            /* Name in the pool */
+    uint32_t name_hash;
+    uint32_t member_index;
+    uint32_t symbol_value;
+    uint32_t symbol_size;
+    uint8_t symbol_type;
+    uint8_t symbol_binding;
+    uint8_t flags;
+    uint8_t reserved;
+} index_file_entry_t;
+
+_Static_assert(sizeof(index_file_header_t) == 16, "Index header must be 16 bytes");
+_Static_assert(sizeof(index_file_entry_t) == 24, "Index entry must be 24 bytes");
+
+/*
+ * A serialized index used in place. The data need not be aligned, so
+ * fields are loaded with memcpy. Entries handed out are filled in on
+ * first lookup into resolved, which is zeroed and so costs nothing for
+ * entries never looked up.
+ */
+typedef struct index_view {
+    const uint8_t* buckets;          /* bucket_count + 1 starts */
+    const uint8_t* entries;
+    const char* names;
+    uint32_t bucket_count;
+    uint32_t symbol_count;
+    uint32_t names_size;
+    symbol_index_entry_t* resolved;  /* By entry position */
+    uint8_t* owned;                  /* Buffer the view lies in, if read from a file */
+} index_view_t;
+
+/*
+ * Search structures, built on the first search after the index changed.
+ * Names are sorted, so a literal prefix is a binary-searched range; each
+ * trigram bucket lists the sorted positions of the names containing one
+ * of its trigrams, for patterns that start with a wildcard. Entries are
+ * also grouped by member, so one member's definitions are a range too.
+ */
+typedef struct index_search {
+    symbol_index_entry_t** sorted;
+    size_t count;
+    size_t symbols;                  /* Symbols in the index when built */
+    uint32_t* trigram_starts;        /* INDEX_TRIGRAM_BUCKETS + 1 */
+    uint32_t* postings;              /* Ascending positions, by bucket */
+    symbol_index_entry_t** by_member; /* By member, then name */
+    size_t member_entries;
+    size_t member_changes;           /* Changes to the index when grouped */
+} index_search_t;
+
+struct symbol_index {
+    memory_pool_t* arena;            /* Entries, names and member names */
+    memory_pool_t** absorbed;        /* Arenas of absorbed indexes, still holding names */
+    size_t absorbed_count;
+    symbol_index_entry_t** buckets;  /* Chain heads */
+    size_t bucket_count;             /* Power of two */
+    symbol_index_entry_t** old_buckets; /* Being drained into buckets, NULL if not growing */
+    size_t old_bucket_count;
+    size_t migrated;                 /* Old buckets already drained */
+    size_t symbol_count;
+    size_t changes;                  /* Entries added or replaced, to spot stale groupings */
+    index_view_t view;               /* Attached serialized index, read-only */
+    index_search_t* search;          /* Filled in by searches, which see a const index */
+};
+
+uint32_t symbol_index_hash_name(const char* name) {
+    /* FNV-1a, as in the STLD symbol table, so cached hashes carry over */
+    uint32_t hash = 2166136261U;
+    const unsigned char* p = (const unsigned char*)name;
+    
+    if (name == NULL) {
+        return 0;
+    }
+    
+    while (*p != '\0') {
+        hash ^= *p++;
+        hash *= 16777619U;
+    }
+    
+    return hash;
+}
+
+symbol_index_t* symbol_index_create(size_t hash_table_size) {
+    symbol_index_t* index;
+    size_t bucket_count = 64;
+    
+    if (hash_table_size == 0) {
+        hash_table_size = INDEX_HASH_TABLE_SIZE;
+    }
+    while (bucket_count < hash_table_size) {
+        bucket_count *= 2;
+    }
+    
+    index = malloc(sizeof(symbol_index_t));
+    if (index == NULL) {
+        return NULL;
+    }
+    
+    index->arena = memory_pool_create_growable(INDEX_ARENA_BLOCK_SIZE, 0);
+    index->buckets = calloc(bucket_count, sizeof(symbol_index_entry_t*));
+    index->search = calloc(1, sizeof(index_search_t));
+    if (index->arena == NULL || index->buckets == NULL || index->search == NULL) {
+        memory_pool_destroy(index->arena);
+        free(index->buckets);
+        free(index->search);
+        free(index);
+        return NULL;
+    }
+    
+    index->absorbed = NULL;
+    index->absorbed_count = 0;
+    index->bucket_count = bucket_count;
+    index->old_buckets = NULL;
+    index->old_bucket_count = 0;
+    index->migrated = 0;
+    index->symbol_count = 0;
+    index->changes = 0;
+    memset(&index->view, 0, sizeof(index->view));
+    
+    return index;
+}
+
+void symbol_index_destroy(symbol_index_t* index) {
+    size_t i;
+    
+    if (index != NULL) {
+        memory_pool_destroy(index->arena);
+        for (i = 0; i < index->absorbed_count; i++) {
+            memory_pool_destroy(index->absorbed[i]);
+        }
+        free(index->absorbed);
+        free(index->buckets);
+        free(index->old_buckets);
+        free(index->view.resolved);
+        free(index->view.owned);
+        free(index->search->sorted);
+        free(index->search->trigram_starts);
+        free(index->search->postings);
+        free(index->search->by_member);
+        free(index->search);
+        free(index);
+    }
+}
+
+static uint8_t index_flags(uint8_t type, uint8_t binding) {
+    uint8_t flags = 0;
+    
+    if (type == SMOF_SYM_FUNC) {
+        flags |= INDEX_FLAG_FUNCTION;
+    } else if (type == SMOF_SYM_OBJECT) {
+        flags |= INDEX_FLAG_OBJECT;
+    }
+    
+    if (binding == SMOF_BIND_WEAK) {
+        flags |= INDEX_FLAG_WEAK;
+    } else if (binding == SMOF_BIND_LOCAL) {
+        flags |= INDEX_FLAG_LOCAL;
+    } else {
+        flags |= INDEX_FLAG_GLOBAL;
+    }
+    
+    return flags;
+}
+
+static char* copy_string(memory_pool_t* arena, const char* str) {
+    size_t size = strlen(str) + 1;
+    char* copy = memory_pool_alloc(arena, size);
+    
+    if (copy != NULL) {
+        memcpy(copy, str, size);
+    }
+    
+    return copy;
+}
+
+/* Drain up to count old buckets into the current array */
+static void migrate_buckets(symbol_index_t* index, size_t count) {
+    symbol_index_entry_t* entry;
+    symbol_index_entry_t* next;
+    size_t bucket;
+    
+    while (count > 0 && index->old_buckets != NULL) {
+        for (entry = index->old_buckets[index->migrated]; entry != NULL; entry = next) {
+            next = entry->next;
+            bucket = entry->name_hash & (index->bucket_count - 1);
+            entry->next = index->buckets[bucket];
+            index->buckets[bucket] = entry;
+        }
+        index->old_buckets[index->migrated++] = NULL;
+        count--;
+        
+        if (index->migrated == index->old_bucket_count) {
+            free(index->old_buckets);
+            index->old_buckets = NULL;
+            index->old_bucket_count = 0;
+            index->migrated = 0;
+        }
+    }
+}
+
+/* Switch to an empty array of bucket_count buckets; the current one starts draining */
+static int begin_rehash(symbol_index_t* index, size_t bucket_count) {
+    symbol_index_entry_t** buckets;
+    
+    migrate_buckets(index, SIZE_MAX);
+    
+    buckets = calloc(bucket_count, sizeof(symbol_index_entry_t*));
+    if (buckets == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    index->old_buckets = index->buckets;
+    index->old_bucket_count = index->bucket_count;
+    index->migrated = 0;
+    index->buckets = buckets;
+    index->bucket_count = bucket_count;
+    
+    return ERROR_SUCCESS;
+}
+
+/*
+ * Link a new entry into its chain, copying name unless entry already
+ * points at storage in the arena. The first strong definition of a name
+ * wins and replaces a weak one, so the result follows member order.
+ */
+static int index_insert(symbol_index_t* index, const symbol_index_entry_t* entry,
+                        const char* name) {
+    symbol_index_entry_t* existing;
+    symbol_index_entry_t* slot;
+    size_t bucket;
+    
+    /* An attached index is read-only */
+    if (index->view.entries != NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    existing = symbol_index_find_symbol_hash(index, name, entry->name_hash);
+    if (existing != NULL) {
+        if ((existing->flags & INDEX_FLAG_WEAK) != 0 && (entry->flags & INDEX_FLAG_WEAK) == 0) {
+            existing->member_index = entry->member_index;
+            existing->symbol_value = entry->symbol_value;
+            existing->symbol_size = entry->symbol_size;
+            existing->symbol_type = entry->symbol_type;
+            existing->symbol_binding = entry->symbol_binding;
+            existing->flags = entry->flags;
+            existing->member_name = entry->member_name;
+            index->changes++;
+        }
+        return ERROR_SUCCESS;
+    }
+    
+    if (index->symbol_count >= INDEX_MAX_SYMBOLS) {
+        ERROR_REPORT_ERROR(ERROR_SYSTEM_LIMIT, "Symbol index is full");
+        return ERROR_SYSTEM_LIMIT;
+    }
+    
+    /* Chains stay short; if the larger array cannot be had, they just grow */
+    if (index->old_buckets == NULL &&
+        index->symbol_count >= index->bucket_count * INDEX_MAX_LOAD_FACTOR) {
+        begin_rehash(index, index->bucket_count * 2);
+    }
+    migrate_buckets(index, INDEX_REHASH_STEP);
+    
+    slot = memory_pool_alloc(index->arena, sizeof(symbol_index_entry_t));
+    if (slot == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    *slot = *entry;
+    if (slot->name == NULL) {
+        slot->name = copy_string(index->arena, name);
+        if (slot->name == NULL) {
+            return ERROR_OUT_OF_MEMORY;
+        }
+    }
+    
+    bucket = entry->name_hash & (index->bucket_count - 1);
+    slot->next = index->buckets[bucket];
+    index->buckets[bucket] = slot;
+    index->symbol_count++;
+    index->changes++;
+    
+    return ERROR_SUCCESS;
+}
+
+/* Add a definition whose member name is already in the arena */
+static int index_add(symbol_index_t* index, const char* name, uint32_t member_index,
+                     const char* member_name, uint32_t value, uint32_t size,
+                     uint8_t type, uint8_t binding) {
+    symbol_index_entry_t entry;
+    
+    if (name[0] == '\0' || strlen(name) >= INDEX_SYMBOL_NAME_MAX) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    entry = (symbol_index_entry_t) {
+        .name = NULL,
+        .name_hash = symbol_index_hash_name(name),
+        .member_index = member_index,
+        .symbol_value = value,
+        .symbol_size = size,
+        .symbol_type = type,
+        .symbol_binding = binding,
+        .flags = index_flags(type, binding),
+        .member_name = member_name
+    };
+    
+    return index_insert(index, &entry, name);
+}
+
+int symbol_index_add_symbol(symbol_index_t* index,
+                           const char* name,
+                           uint32_t member_index,
+                           const char* member_name,
+                           uint32_t value,
+                           uint32_t size,
+                           uint8_t type,
+                           uint8_t binding) {
+    const char* member_copy = NULL;
+    
+    if (index == NULL || name == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    if (member_name != NULL) {
+        member_copy = copy_string(index->arena, member_name);
+        if (member_copy == NULL) {
+            return ERROR_OUT_OF_MEMORY;
+        }
+    }
+    
+    return index_add(index, name, member_index, member_copy, value, size, type, binding);
+}
+
+symbol_index_entry_t* symbol_index_find_symbol(const symbol_index_t* index,
+                                              const char* name) {
+    if (index == NULL || name == NULL) {
+        return NULL;
+    }
+    
+    return symbol_index_find_symbol_hash(index, name, symbol_index_hash_name(name));
+}
+
+static uint32_t load_u32(const uint8_t* p) {
+    uint32_t value;
+    
+    memcpy(&value, p, sizeof(value));
+    
+    return value;
+}
+
+/* The entry at position i of the view, filled in the first time it is asked for */
+static symbol_index_entry_t* view_entry(const index_view_t* view, uint32_t i) {
+    symbol_index_entry_t* entry = &view->resolved[i];
+    index_file_entry_t record;
+    
+    if (entry->name == NULL) {
+        memcpy(&record, view->entries + (size_t)i * sizeof(record), sizeof(record));
+        if (record.name_offset >= view->names_size) {
+            return NULL;
+        }
+        *entry = (symbol_index_entry_t) {
+            .name = view->names + record.name_offset,
+            .name_hash = record.name_hash,
+            .member_index = record.member_index,
+            .symbol_value = record.symbol_value,
+            .symbol_size = record.symbol_size,
+            .symbol_type = record.symbol_type,
+            .symbol_binding = record.symbol_binding,
+            .flags = record.flags,
+            .member_name = NULL,
+            .next = NULL
+        };
+    }
+    
+    return entry;
+}
+
+/* Compare hashes in place; only a matching entry is resolved */
+static symbol_index_entry_t* view_find(const index_view_t* view, const char* name,
+                                       uint32_t hash) {
+    symbol_index_entry_t* entry;
+    size_t bucket = hash & (view->bucket_count - 1);
+    uint32_t i = load_u32(view->buckets + bucket * sizeof(uint32_t));
+    uint32_t end = load_u32(view->buckets + (bucket + 1) * sizeof(uint32_t));
+    
+    if (end > view->symbol_count) {
+        return NULL;
+    }
+    
+    for (; i < end; i++) {
+        if (load_u32(view->entries + (size_t)i * sizeof(index_file_entry_t) +
+                     offsetof(index_file_entry_t, name_hash)) != hash) {
+            continue;
+        }
+        entry = view_entry(view, i);
+        if (entry != NULL && strcmp(entry->name, name) == 0) {
+            return entry;
+        }
+    }
+    
+    return NULL;
+}
+
+symbol_index_entry_t* symbol_index_find_symbol_hash(const symbol_index_t* index,
+                                                   const char* name,
+                                                   uint32_t hash) {
+    symbol_index_entry_t* entry;
+    
+    if (index == NULL || name == NULL) {
+        return NULL;
+    }
+    
+    for (entry = index->buckets[hash & (index->bucket_count - 1)]; entry != NULL;
+         entry = entry->next) {
+        if (entry->name_hash == hash && strcmp(entry->name, name) == 0) {
+            return entry;
+        }
+    }
+    
+    /* While growing, entries not yet drained are still in the old array */
+    if (index->old_buckets != NULL) {
+        for (entry = index->old_buckets[hash & (index->old_bucket_count - 1)]; entry != NULL;
+             entry = entry->next) {
+            if (entry->name_hash == hash && strcmp(entry->name, name) == 0) {
+                return entry;
+            }
+        }
+    }
+    
+    if (index->view.entries != NULL) {
+        return view_find(&index->view, name, hash);
+    }
+    
+    return NULL;
+}
+
+/*
+ * Index the global definitions of one member. Archives may hold any file,
+ * so members that are not well-formed SMOF objects define nothing.
+ */
+int symbol_index_build_from_member(symbol_index_t* index,
+                                  const archive_file_t* archive,
+                                  const archive_member_t* member,
+                                  uint32_t member_index) {
+    smof_layout_t layout;
+    smof_symbol_t symbol;
+    smof_symbol_t* swapped = NULL;
+    const uint8_t* data;
+    const uint8_t* symbols;
+    const char* strings;
+    const char* member_name = NULL;
+    size_t size;
+    uint32_t i;
+    int result = ERROR_SUCCESS;
+    
+    if (index == NULL || archive == NULL || member == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    if (!member->data_loaded) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    data = member->data;
+    size = member->header.size;
+    
+    /* Members that are not SMOF objects define nothing */
+    if (smof_read_layout(data, size, &layout) != ERROR_SUCCESS) {
+        return ERROR_SUCCESS;
+    }
+    strings = (const char*)data + layout.string_table_offset;
+    symbols = data + layout.symbol_table_offset;
+    
+    if (member->name != NULL) {
+        member_name = copy_string(index->arena, member->name);
+        if (member_name == NULL) {
+            return ERROR_OUT_OF_MEMORY;
+        }
+    }
+    
+    /* Member data is shared, so a foreign symbol table is swapped in a copy */
+    if (smof_is_foreign(data, size) && layout.symbol_count > 0) {
+        swapped = malloc((size_t)layout.symbol_count * sizeof(smof_symbol_t));
+        if (swapped == NULL) {
+            return ERROR_OUT_OF_MEMORY;
+        }
+        memcpy(swapped, symbols, (size_t)layout.symbol_count * sizeof(smof_symbol_t));
+        smof_swap_symbols(swapped, layout.symbol_count);
+        symbols = (const uint8_t*)swapped;
+    }
+    
+    for (i = 0; i < layout.symbol_count && result == ERROR_SUCCESS; i++) {
+        memcpy(&symbol, symbols + i * sizeof(smof_symbol_t), sizeof(symbol));
+        
+        /* Only definitions another object can bind to */
+        if (symbol.binding == SMOF_BIND_LOCAL || symbol.section_index >= layout.section_count) {
+            continue;
+        }
+        
+        if (symbol.name_offset >= layout.string_table_size ||
+            memchr(strings + symbol.name_offset, '\0',
+                   layout.string_table_size - symbol.name_offset) == NULL) {
+            continue;
+        }
+        
+        result = index_add(index, strings + symbol.name_offset, member_index, member_name,
+                           symbol.value, symbol.size, symbol.type, symbol.binding);
+    }
+    
+    free(swapped);
+    return result;
+}
+
+/*
+ * A parallel build. The definition that survives for a name is the first
+ * strong one, else the first weak one, both within a shard and over the
+ * whole archive, so absorbing the shards in order reproduces a serial
+ * build and no index is ever shared between threads.
+ */
+typedef struct index_build {
+    const archive_file_t* archive;
+    symbol_index_loader_t loader;
+    void* user_data;
+    struct thread_pool* pool;        /* For the loader, NULL when shards run in parallel */
+    symbol_index_t** shards;
+    size_t shard_members;            /* Members per shard */
+} index_build_t;
+
+static int build_member(const index_build_t* build, symbol_index_t* index, uint32_t i) {
+    archive_member_t view;
+    uint8_t* buffer = NULL;
+    int result;
+    
+    if (build->loader == NULL) {
+        return symbol_index_build_from_member(index, build->archive,
+                                              &build->archive->members[i], i);
+    }
+    
+    view = build->archive->members[i];
+    result = build->loader(build->user_data, &view, build->pool, &buffer);
+    if (result == ERROR_SUCCESS && view.data_loaded) {
+        result = symbol_index_build_from_member(index, build->archive, &view, i);
+    }
+    free(buffer);
+    
+    return result;
+}
+
+static int build_shard_task(void* user_data, size_t shard) {
+    index_build_t* build = user_data;
+    size_t first = shard * build->shard_members;
+    size_t end = first + build->shard_members;
+    size_t i;
+    int result = ERROR_SUCCESS;
+    
+    if (end > build->archive->header.member_count) {
+        end = build->archive->header.member_count;
+    }
+    
+    build->shards[shard] = symbol_index_create(0);
+    if (build->shards[shard] == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    for (i = first; i < end && result == ERROR_SUCCESS; i++) {
+        result = build_member(build, build->shards[shard], (uint32_t)i);
+    }
+    
+    return result;
+}
+
+int symbol_index_build_parallel(symbol_index_t* index,
+                               const archive_file_t* archive,
+                               struct thread_pool* pool,
+                               symbol_index_loader_t loader,
+                               void* user_data) {
+    index_build_t build;
+    size_t count;
+    size_t shard_count = 1;
+    size_t i;
+    int result = ERROR_SUCCESS;
+    
+    if (index == NULL || archive == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    build = (index_build_t) {
+        .archive = archive,
+        .loader = loader,
+        .user_data = user_data,
+        .pool = pool
+    };
+    count = archive->header.member_count;
+    if (thread_pool_is_parallel(pool)) {
+        shard_count = thread_pool_get_thread_count(pool) * INDEX_SHARDS_PER_THREAD;
+    }
+    
+    if (shard_count <= 1 || count <= 1) {
+        for (i = 0; i < count && result == ERROR_SUCCESS; i++) {
+            result = build_member(&build, index, (uint32_t)i);
+        }
+        return result;
+    }
+    
+    build.pool = NULL;
+    build.shard_members = (count + shard_count - 1) / shard_count;
+    shard_count = (count + build.shard_members - 1) / build.shard_members;
+    build.shards = calloc(shard_count, sizeof(symbol_index_t*));
+    if (build.shards == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    result = thread_pool_run(pool, shard_count, build_shard_task, &build);
+    for (i = 0; i < shard_count; i++) {
+        if (result == ERROR_SUCCESS) {
+            result = symbol_index_absorb(index, build.shards[i]);
+        } else {
+            symbol_index_destroy(build.shards[i]);
+        }
+    }
+    free(build.shards);
+    
+    return result;
+}
+
+int symbol_index_build_from_archive(symbol_index_t* index,
+                                   const archive_file_t* archive) {
+    if (index == NULL || archive == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    return symbol_index_build_parallel(index, archive, archive->pool, NULL, NULL);
+}
+
+/* Visit one bucket array's chains; false if the visitor stopped */
+static bool visit_chains(symbol_index_entry_t* const* buckets, size_t count,
+                         symbol_index_visitor_t visitor, void* user_data) {
+    const symbol_index_entry_t* entry;
+    size_t i;
+    
+    for (i = 0; i < count; i++) {
+        for (entry = buckets[i]; entry != NULL; entry = entry->next) {
+            if (!visitor(entry, user_data)) {
+                return false;
+            }
+        }
+    }
+    
+    return true;
+}
+
+/* Chained entries first, then those of an attached index */
+static void visit_entries(const symbol_index_t* index, symbol_index_visitor_t visitor,
+                          void* user_data) {
+    const symbol_index_entry_t* entry;
+    size_t i;
+    
+    if (!visit_chains(index->buckets, index->bucket_count, visitor, user_data) ||
+        (index->old_buckets != NULL &&
+         !visit_chains(index->old_buckets, index->old_bucket_count, visitor, user_data))) {
+        return;
+    }
+    
+    for (i = 0; i < index->view.symbol_count; i++) {
+        entry = view_entry(&index->view, (uint32_t)i);
+        if (entry != NULL && !visitor(entry, user_data)) {
+            return;
+        }
+    }
+}
+
+void symbol_index_foreach(const symbol_index_t* index,
+                         symbol_index_visitor_t visitor,
+                         void* user_data) {
+    if (index == NULL || visitor == NULL) {
+        return;
+    }
+    
+    visit_entries(index, visitor, user_data);
+}
+
+bool symbol_index_pattern_is_wildcard(const char* pattern) {
+    return pattern != NULL && strpbrk(pattern, "*?") != NULL;
+}
+
+/* Glob match with '*' and '?'; backtracks only to the last '*' */
+bool symbol_index_name_matches_pattern(const char* name, const char* pattern) {
+    const char* star = NULL;
+    const char* resume = name;
+    
+    if (name == NULL || pattern == NULL) {
+        return false;
+    }
+    
+    while (*name != '\0') {
+        if (*pattern == '*') {
+            star = ++pattern;
+            resume = name;
+        } else if (*pattern != '\0' && (*pattern == '?' || *pattern == *name)) {
+            pattern++;
+            name++;
+        } else if (star != NULL) {
+            pattern = star;
+            name = ++resume;
+        } else {
+            return false;
+        }
+    }
+    
+    while (*pattern == '*') {
+        pattern++;
+    }
+    
+    return *pattern == '\0';
+}
+
+/*
+ * 1.0 for an exact match. Otherwise anchored patterns rank above ones
+ * starting with '*', and within each half the more of the name the
+ * pattern spells out, the higher.
+ */
+double symbol_index_calculate_relevance(const char* name, const char* pattern) {
+    size_t literal = 0;
+    size_t length;
+    const char* p;
+    
+    if (!symbol_index_name_matches_pattern(name, pattern)) {
+        return 0.0;
+    }
+    
+    length = strlen(name);
+    if (length == 0) {
+        return 1.0;
+    }
+    
+    for (p = pattern; *p != '\0'; p++) {
+        literal += (size_t)(*p != '*');
+    }
+    
+    return (pattern[0] != '*' ? 0.5 : 0.0) + 0.5 * (double)literal / (double)length;
+}
+
+static uint32_t trigram_bucket(const char* p) {
+    uint32_t key = (uint32_t)(unsigned char)p[0] | (uint32_t)(unsigned char)p[1] << 8 |
+                   (uint32_t)(unsigned char)p[2] << 16;
+    
+    return (key * 2654435761U) >> (32 - INDEX_TRIGRAM_BITS);
+}
+
+static int compare_names(const void* a, const void* b) {
+    const symbol_index_entry_t* left = *(symbol_index_entry_t* const*)a;
+    const symbol_index_entry_t* right = *(symbol_index_entry_t* const*)b;
+    
+    return strcmp(left->name, right->name);
+}
+
+/* Every entry, chained or attached, into entries; returns the count */
+static size_t list_entries(const symbol_index_t* index, symbol_index_entry_t** entries) {
+    symbol_index_entry_t* entry;
+    size_t count = 0;
+    size_t i;
+    
+    for (i = 0; i < index->bucket_count; i++) {
+        for (entry = index->buckets[i]; entry != NULL; entry = entry->next) {
+            entries[count++] = entry;
+        }
+    }
+    for (i = 0; i < index->old_bucket_count; i++) {
+        for (entry = index->old_buckets[i]; entry != NULL; entry = entry->next) {
+            entries[count++] = entry;
+        }
+    }
+    for (i = 0; i < index->view.symbol_count; i++) {
+        entry = view_entry(&index->view, (uint32_t)i);
+        if (entry != NULL) {
+            entries[count++] = entry;
+        }
+    }
+    
+    return count;
+}
+
+/* Sort the names and post their trigrams, unless nothing was added since */
+static int prepare_search(const symbol_index_t* index) {
+    index_search_t* search = index->search;
+    size_t total = index->symbol_count + index->view.symbol_count;
+    uint32_t* starts;
+    uint32_t* postings = NULL;
+    uint32_t* cursor;
+    size_t posting_count = 0;
+    size_t bucket;
+    size_t i;
+    const char* p;
+    
+    if (search->sorted != NULL && search->symbols == total) {
+        return ERROR_SUCCESS;
+    }
+    
+    free(search->sorted);
+    free(search->trigram_starts);
+    free(search->postings);
+    memset(search, 0, sizeof(index_search_t));
+    
+    search->sorted = malloc((total + 1) * sizeof(symbol_index_entry_t*));
+    starts = calloc(INDEX_TRIGRAM_BUCKETS + 1, sizeof(uint32_t));
+    cursor = malloc(INDEX_TRIGRAM_BUCKETS * sizeof(uint32_t));
+    if (search->sorted == NULL || starts == NULL || cursor == NULL) {
+        free(search->sorted);
+        search->sorted = NULL;
+        free(starts);
+        free(cursor);
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    total = list_entries(index, search->sorted);
+    qsort(search->sorted, total, sizeof(symbol_index_entry_t*), compare_names);
+    
+    /* Count each name once per bucket, remembering the last name counted */
+    memset(cursor, 0xFF, INDEX_TRIGRAM_BUCKETS * sizeof(uint32_t));
+    for (i = 0; i < total; i++) {
+        for (p = search->sorted[i]->name; p[0] != '\0' && p[1] != '\0' && p[2] != '\0'; p++) {
+            bucket = trigram_bucket(p);
+            if (cursor[bucket] != (uint32_t)i) {
+                cursor[bucket] = (uint32_t)i;
+                starts[bucket + 1]++;
+                posting_count++;
+            }
+        }
+    }
+    for (bucket = 0; bucket < INDEX_TRIGRAM_BUCKETS; bucket++) {
+        starts[bucket + 1] += starts[bucket];
+    }
+    
+    postings = malloc((posting_count + 1) * sizeof(uint32_t));
+    if (postings == NULL) {
+        free(search->sorted);
+        search->sorted = NULL;
+        free(starts);
+        free(cursor);
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    /* Positions go in ascending, so a repeat is always the bucket's last one */
+    memcpy(cursor, starts, INDEX_TRIGRAM_BUCKETS * sizeof(uint32_t));
+    for (i = 0; i < total; i++) {
+        for (p = search->sorted[i]->name; p[0] != '\0' && p[1] != '\0' && p[2] != '\0'; p++) {
+            bucket = trigram_bucket(p);
+            if (cursor[bucket] == starts[bucket] || postings[cursor[bucket] - 1] != (uint32_t)i) {
+                postings[cursor[bucket]++] = (uint32_t)i;
+            }
+        }
+    }
+    free(cursor);
+    
+    search->count = total;
+    search->symbols = index->symbol_count + index->view.symbol_count;
+    search->trigram_starts = starts;
+    search->postings = postings;
+    
+    return ERROR_SUCCESS;
+}
+
+/* Matches so far, the best max_results of them by relevance */
+typedef struct pattern_query {
+    const char* pattern;
+    symbol_search_result_t* results;
+    size_t max_results;
+    size_t kept;
+    size_t found;
+} pattern_query_t;
+
+/* Candidates come in name order, so equal relevance stays in name order */
+static void consider_entry(pattern_query_t* query, symbol_index_entry_t* entry) {
+    double relevance;
+    size_t i;
+    
+    if (!symbol_index_name_matches_pattern(entry->name, query->pattern)) {
+        return;
+    }
+    
+    query->found++;
+    relevance = symbol_index_calculate_relevance(entry->name, query->pattern);
+    if (query->kept == query->max_results) {
+        if (query->kept == 0 || relevance <= query->results[query->kept - 1].relevance) {
+            return;
+        }
+        i = query->kept - 1;
+    } else {
+        i = query->kept++;
+    }
+    
+    while (i > 0 && query->results[i - 1].relevance < relevance) {
+        query->results[i] = query->results[i - 1];
+        i--;
+    }
+    query->results[i].symbol = entry;
+    query->results[i].relevance = relevance;
+}
+
+/* First name not sorting before the length-byte prefix, or if past, after it */
+static size_t lower_bound(const index_search_t* search, const char* prefix, size_t length,
+                          bool past) {
+    size_t low = 0;
+    size_t high = search->count;
+    size_t middle;
+    int order;
+    
+    while (low < high) {
+        middle = low + (high - low) / 2;
+        order = strncmp(search->sorted[middle]->name, prefix, length);
+        if (order < 0 || (past && order == 0)) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    
+    return low;
+}
+
+static bool list_contains(const uint32_t* list, size_t count, uint32_t position) {
+    size_t low = 0;
+    size_t high = count;
+    size_t middle;
+    
+    while (low < high) {
+        middle = low + (high - low) / 2;
+        if (list[middle] < position) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    
+    return low < count && list[low] == position;
+}
+
+/*
+ * Names holding every trigram of the pattern's literal runs, walking the
+ * shortest posting list. Returns false if the pattern has no run of
+ * three characters to filter by.
+ */
+static bool search_trigrams(const index_search_t* search, pattern_query_t* query) {
+    uint32_t buckets[INDEX_PATTERN_TRIGRAMS];
+    size_t count = 0;
+    size_t shortest = 0;
+    size_t i;
+    size_t j;
+    const uint32_t* list;
+    const char* p;
+    
+    for (p = query->pattern; p[0] != '\0' && p[1] != '\0' && p[2] != '\0' &&
+         count < INDEX_PATTERN_TRIGRAMS; p++) {
+        if (strcspn(p, "*?") >= 3) {
+            buckets[count++] = trigram_bucket(p);
+        }
+    }
+    if (count == 0) {
+        return false;
+    }
+    
+    for (j = 1; j < count; j++) {
+        if (search->trigram_starts[buckets[j] + 1] - search->trigram_starts[buckets[j]] <
+            search->trigram_starts[buckets[shortest] + 1] -
+            search->trigram_starts[buckets[shortest]]) {
+            shortest = j;
+        }
+    }
+    
+    list = search->postings + search->trigram_starts[buckets[shortest]];
+    for (i = 0; i < search->trigram_starts[buckets[shortest] + 1] -
+                    search->trigram_starts[buckets[shortest]]; i++) {
+        for (j = 0; j < count; j++) {
+            if (j != shortest &&
+                !list_contains(search->postings + search->trigram_starts[buckets[j]],
+                               search->trigram_starts[buckets[j] + 1] -
+                               search->trigram_starts[buckets[j]], list[i])) {
+                break;
+            }
+        }
+        if (j == count) {
+            consider_entry(query, search->sorted[list[i]]);
+        }
+    }
+    
+    return true;
+}
+
+int symbol_index_find_symbols_by_pattern(const symbol_index_t* index,
+                                        const char* pattern,
+                                        symbol_search_result_t* results,
+                                        size_t max_results,
+                                        size_t* found_count) {
+    const index_search_t* search;
+    pattern_query_t query;
+    symbol_index_entry_t* entry;
+    size_t prefix;
+    size_t first;
+    size_t end;
+    size_t i;
+    int result;
+    
+    if (index == NULL || pattern == NULL || found_count == NULL ||
+        (results == NULL && max_results > 0)) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    query = (pattern_query_t) {
+        .pattern = pattern,
+        .results = results,
+        .max_results = max_results
+    };
+    *found_count = 0;
+    
+    /* Without wildcards this is a lookup */
+    if (!symbol_index_pattern_is_wildcard(pattern)) {
+        entry = symbol_index_find_symbol(index, pattern);
+        if (entry != NULL) {
+            consider_entry(&query, entry);
+        }
+        *found_count = query.found;
+        return ERROR_SUCCESS;
+    }
+    
+    result = prepare_search(index);
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    search = index->search;
+    
+    prefix = strcspn(pattern, "*?");
+    if (prefix > 0) {
+        first = lower_bound(search, pattern, prefix, false);
+        end = lower_bound(search, pattern, prefix, true);
+        for (i = first; i < end; i++) {
+            consider_entry(&query, search->sorted[i]);
+        }
+    } else if (!search_trigrams(search, &query)) {
+        for (i = 0; i < search->count; i++) {
+            consider_entry(&query, search->sorted[i]);
+        }
+    }
+    *found_count = query.found;
+    
+    return ERROR_SUCCESS;
+}
+
+/* By member, then name: members' definitions in the order searches list them */
+static int compare_members(const void* a, const void* b) {
+    const symbol_index_entry_t* left = *(symbol_index_entry_t* const*)a;
+    const symbol_index_entry_t* right = *(symbol_index_entry_t* const*)b;
+    
+    if (left->member_index != right->member_index) {
+        return left->member_index < right->member_index ? -1 : 1;
+    }
+    
+    return strcmp(left->name, right->name);
+}
+
+/* Group the entries by member, unless nothing changed since */
+static int prepare_members(const symbol_index_t* index) {
+    index_search_t* search = index->search;
+    
+    if (search->by_member != NULL && search->member_changes == index->changes) {
+        return ERROR_SUCCESS;
+    }
+    
+    free(search->by_member);
+    search->by_member = malloc((index->symbol_count + index->view.symbol_count + 1) *
+                               sizeof(symbol_index_entry_t*));
+    if (search->by_member == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    search->member_entries = list_entries(index, search->by_member);
+    qsort(search->by_member, search->member_entries, sizeof(symbol_index_entry_t*),
+          compare_members);
+    search->member_changes = index->changes;
+    
+    return ERROR_SUCCESS;
+}
+
+/* Range of member_index's entries in the grouping */
+static size_t member_range(const index_search_t* search, uint32_t member_index, size_t* end) {
+    size_t low = 0;
+    size_t high = search->member_entries;
+    size_t middle;
+    
+    while (low < high) {
+        middle = low + (high - low) / 2;
+        if (search->by_member[middle]->member_index < member_index) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    
+    *end = low;
+    while (*end < search->member_entries &&
+           search->by_member[*end]->member_index == member_index) {
+        (*end)++;
+    }
+    
+    return low;
+}
+
+int symbol_index_find_symbols_by_member(const symbol_index_t* index,
+                                       uint32_t member_index,
+                                       symbol_index_entry_t** symbols,
+                                       size_t max_symbols,
+                                       size_t* found_count) {
+    size_t first;
+    size_t end;
+    int result;
+    
+    if (index == NULL || found_count == NULL || (symbols == NULL && max_symbols > 0)) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    *found_count = 0;
+    result = prepare_members(index);
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    first = member_range(index->search, member_index, &end);
+    *found_count = end - first;
+    if (end - first > max_symbols) {
+        end = first + max_symbols;
+    }
+    if (end > first) {
+        memcpy(symbols, index->search->by_member + first,
+               (end - first) * sizeof(symbol_index_entry_t*));
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+/* Filter for a member when there was no memory to group the entries */
+typedef struct member_visit {
+    uint32_t member_index;
+    symbol_index_visitor_t visitor;
+    void* user_data;
+} member_visit_t;
+
+static bool visit_member_entry(const symbol_index_entry_t* entry, void* user_data) {
+    member_visit_t* visit = user_data;
+    
+    return entry->member_index != visit->member_index ||
+           visit->visitor(entry, visit->user_data);
+}
+
+void symbol_index_foreach_in_member(const symbol_index_t* index,
+                                   uint32_t member_index,
+                                   symbol_index_visitor_t visitor,
+                                   void* user_data) {
+    member_visit_t visit;
+    size_t first;
+    size_t end;
+    
+    if (index == NULL || visitor == NULL) {
+        return;
+    }
+    
+    if (prepare_members(index) != ERROR_SUCCESS) {
+        visit = (member_visit_t) {member_index, visitor, user_data};
+        visit_entries(index, visit_member_entry, &visit);
+        return;
+    }
+    
+    first = member_range(index->search, member_index, &end);
+    while (first < end && visitor(index->search->by_member[first], user_data)) {
+        first++;
+    }
+}
+
+/* One entry of an index being absorbed */
+typedef struct index_absorb {
+    symbol_index_t* index;
+    int result;
+} index_absorb_t;
+
+static bool absorb_entry(const symbol_index_entry_t* entry, void* user_data) {
+    index_absorb_t* absorb = user_data;
+    
+    absorb->result = index_insert(absorb->index, entry, entry->name);
+    
+    return absorb->result == ERROR_SUCCESS;
+}
+
+int symbol_index_absorb(symbol_index_t* index, symbol_index_t* other) {
+    index_absorb_t absorb;
+    memory_pool_t** absorbed;
+    
+    if (index == NULL || other == NULL || other->view.entries != NULL) {
+        symbol_index_destroy(other);
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    /* Take over other's arenas first: the entries copied in point into them */
+    absorbed = realloc(index->absorbed, (index->absorbed_count + other->absorbed_count + 1) *
+                                        sizeof(memory_pool_t*));
+    if (absorbed == NULL) {
+        symbol_index_destroy(other);
+        return ERROR_OUT_OF_MEMORY;
+    }
+    index->absorbed = absorbed;
+    absorbed[index->absorbed_count++] = other->arena;
+    if (other->absorbed_count > 0) {
+        memcpy(absorbed + index->absorbed_count, other->absorbed,
+               other->absorbed_count * sizeof(memory_pool_t*));
+        index->absorbed_count += other->absorbed_count;
+    }
+    
+    absorb.index = index;
+    absorb.result = ERROR_SUCCESS;
+    visit_entries(other, absorb_entry, &absorb);
+    
+    other->arena = NULL;
+    other->absorbed_count = 0;
+    symbol_index_destroy(other);
+    
+    return absorb.result;
+}
+
+/* Entries gathered for serialization */
+typedef struct serial_list {
+    const symbol_index_entry_t** entries;
+    size_t count;
+    size_t names_size;
+} serial_list_t;
+
+static bool collect_entry(const symbol_index_entry_t* entry, void* user_data) {
+    serial_list_t* list = user_data;
+    
+    list->entries[list->count++] = entry;
+    list->names_size += strlen(entry->name) + 1;
+    
+    return true;
+}
+
+/* By hash, then name: one order however the entries were inserted */
+static int compare_entries(const void* a, const void* b) {
+    const symbol_index_entry_t* left = *(const symbol_index_entry_t* const*)a;
+    const symbol_index_entry_t* right = *(const symbol_index_entry_t* const*)b;
+    
+    if (left->name_hash != right->name_hash) {
+        return left->name_hash < right->name_hash ? -1 : 1;
+    }
+    
+    return strcmp(left->name, right->name);
+}
+
+int symbol_index_serialize(const symbol_index_t* index,
+                          uint8_t** data,
+                          size_t* size) {
+    index_file_header_t header;
+    index_file_entry_t record;
+    serial_list_t list;
+    const symbol_index_entry_t** order;
+    uint32_t* starts;
+    uint8_t* buffer;
+    uint8_t* entries;
+    char* names;
+    size_t bucket_count;
+    size_t names_size = 0;
+    size_t total;
+    size_t bucket;
+    size_t i;
+    
+    if (index == NULL || data == NULL || size == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    list.entries = malloc((index->symbol_count + index->view.symbol_count + 1) *
+                          sizeof(symbol_index_entry_t*));
+    if (list.entries == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    list.count = 0;
+    list.names_size = 0;
+    visit_entries(index, collect_entry, &list);
+    qsort(list.entries, list.count, sizeof(symbol_index_entry_t*), compare_entries);
+    
+    bucket_count = symbol_index_calculate_hash_size(list.count);
+    total = sizeof(header) + (bucket_count + 1) * sizeof(uint32_t) +
+            list.count * sizeof(index_file_entry_t) + list.names_size;
+    buffer = malloc(total);
+    starts = calloc(bucket_count + 1, sizeof(uint32_t));
+    order = malloc((list.count + 1) * sizeof(symbol_index_entry_t*));
+    if (buffer == NULL || starts == NULL || order == NULL) {
+        free(buffer);
+        free(starts);
+        free(order);
+        free(list.entries);
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    header = (index_file_header_t) {
+        .magic = INDEX_SERIAL_MAGIC,
+        .symbol_count = (uint32_t)list.count,
+        .names_size = (uint32_t)list.names_size,
+        .bucket_count = (uint32_t)bucket_count
+    };
+    memcpy(buffer, &header, sizeof(header));
+    entries = buffer + sizeof(header) + (bucket_count + 1) * sizeof(uint32_t);
+    names = (char*)(entries + list.count * sizeof(index_file_entry_t));
+    
+    /* Counting sort by bucket, keeping the sorted order within a bucket */
+    for (i = 0; i < list.count; i++) {
+        starts[(list.entries[i]->name_hash & (bucket_count - 1)) + 1]++;
+    }
+    for (bucket = 0; bucket < bucket_count; bucket++) {
+        starts[bucket + 1] += starts[bucket];
+    }
+    memcpy(buffer + sizeof(header), starts, (bucket_count + 1) * sizeof(uint32_t));
+    for (i = 0; i < list.count; i++) {
+        bucket = list.entries[i]->name_hash & (bucket_count - 1);
+        order[starts[bucket]++] = list.entries[i];
+    }
+    
+    /* Names follow the same order, so a bucket's names lie together */
+    for (i = 0; i < list.count; i++) {
+        const symbol_index_entry_t* entry = order[i];
+        size_t length = strlen(entry->name) + 1;
+        
+        record = (index_file_entry_t) {
+            .name_offset = (uint32_t)names_size,
+            .name_hash = entry->name_hash,
+            .member_index = entry->member_index,
+            .symbol_value = entry->symbol_value,
+            .symbol_size = entry->symbol_size,
+            .symbol_type = entry->symbol_type,
+            .symbol_binding = entry->symbol_binding,
+            .flags = entry->flags,
+            .reserved = 0
+        };
+        memcpy(entries + i * sizeof(record), &record, sizeof(record));
+        memcpy(names + names_size, entry->name, length);
+        names_size += length;
+    }
+    free(order);
+    free(starts);
+    free(list.entries);
+    
+    *data = buffer;
+    *size = total;
+    
+    return ERROR_SUCCESS;
+}
+
+/* Check the sizes add up and the pool ends in a terminator; entries are checked on use */
+static int parse_layout(const uint8_t* data, size_t size, index_view_t* view) {
+    index_file_header_t header;
+    size_t buckets_size = 0;
+    size_t entries_size;
+    
+    if (size < sizeof(header)) {
+        return ERROR_ARCHIVE_CORRUPT;
+    }
+    
+    memcpy(&header, data, sizeof(header));
+    if (header.magic == INDEX_SERIAL_MAGIC) {
+        if (header.bucket_count == 0 || (header.bucket_count & (header.bucket_count - 1)) != 0) {
+            return ERROR_ARCHIVE_CORRUPT;
+        }
+        buckets_size = ((size_t)header.bucket_count + 1) * sizeof(uint32_t);
+    } else if (header.magic != INDEX_LEGACY_MAGIC) {
+        return ERROR_ARCHIVE_CORRUPT;
+    }
+    
+    entries_size = (size_t)header.symbol_count * sizeof(index_file_entry_t);
+    if (buckets_size > size - sizeof(header) ||
+        entries_size > size - sizeof(header) - buckets_size ||
+        header.names_size != size - sizeof(header) - buckets_size - entries_size ||
+        (header.names_size > 0 && data[size - 1] != '\0')) {
+        return ERROR_ARCHIVE_CORRUPT;
+    }
+    
+    view->buckets = header.magic == INDEX_SERIAL_MAGIC ? data + sizeof(header) : NULL;
+    view->entries = data + sizeof(header) + buckets_size;
+    view->names = (const char*)view->entries + entries_size;
+    view->bucket_count = header.bucket_count;
+    view->symbol_count = header.symbol_count;
+    view->names_size = header.names_size;
+    
+    return ERROR_SUCCESS;
+}
+
+/* Add a serialized index; names are copied once as a single pool */
+int symbol_index_deserialize(symbol_index_t* index,
+                            const uint8_t* data,
+                            size_t size) {
+    index_view_t layout;
+    index_file_entry_t record;
+    symbol_index_entry_t entry;
+    char* names;
+    uint32_t i;
+    int result = ERROR_SUCCESS;
+    
+    if (index == NULL || data == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    if (parse_layout(data, size, &layout) != ERROR_SUCCESS) {
+        ERROR_REPORT_ERROR(ERROR_ARCHIVE_CORRUPT, "Corrupt archive symbol index");
+        return ERROR_ARCHIVE_CORRUPT;
+    }
+    
+    /* An empty index is sized for what it is about to hold */
+    if (index->symbol_count == 0 &&
+        symbol_index_calculate_hash_size(layout.symbol_count) > index->bucket_count) {
+        size_t bucket_count = symbol_index_calculate_hash_size(layout.symbol_count);
+        symbol_index_entry_t** buckets = calloc(bucket_count, sizeof(symbol_index_entry_t*));
+        
+        if (buckets == NULL) {
+            return ERROR_OUT_OF_MEMORY;
+        }
+        free(index->buckets);
+        index->buckets = buckets;
+        index->bucket_count = bucket_count;
+    }
+    
+    names = memory_pool_alloc(index->arena, layout.names_size + 1);
+    if (names == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    memcpy(names, layout.names, layout.names_size);
+    
+    for (i = 0; i < layout.symbol_count && result == ERROR_SUCCESS; i++) {
+        memcpy(&record, layout.entries + (size_t)i * sizeof(record), sizeof(record));
+        if (record.name_offset >= layout.names_size) {
+            ERROR_REPORT_ERROR(ERROR_ARCHIVE_CORRUPT, "Corrupt archive symbol index");
+            return ERROR_ARCHIVE_CORRUPT;
+        }
+        
+        entry = (symbol_index_entry_t) {
+            .name = names + record.name_offset,
+            .name_hash = record.name_hash,
+            .member_index = record.member_index,
+            .symbol_value = record.symbol_value,
+            .symbol_size = record.symbol_size,
+            .symbol_type = record.symbol_type,
+            .symbol_binding = record.symbol_binding,
+            .flags = record.flags,
+            .member_name = NULL
+        };
+        result = index_insert(index, &entry, entry.name);
+    }
+    
+    return result;
+}
+
+int symbol_index_attach(symbol_index_t* index, const uint8_t* data, size_t size) {
+    index_view_t view;
+    
+    if (index == NULL || data == NULL || index->symbol_count > 0 ||
+        index->view.entries != NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    memset(&view, 0, sizeof(view));
+    if (parse_layout(data, size, &view) != ERROR_SUCCESS || view.buckets == NULL) {
+        ERROR_REPORT_ERROR(ERROR_ARCHIVE_CORRUPT, "Corrupt archive symbol index");
+        return ERROR_ARCHIVE_CORRUPT;
+    }
+    
+    view.resolved = calloc((size_t)view.symbol_count + 1, sizeof(symbol_index_entry_t));
+    if (view.resolved == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    index->view = view;
+    index->changes++;
+    
+    return ERROR_SUCCESS;
+}
+
+static bool is_legacy_layout(const uint8_t* data, size_t size) {
+    return size >= sizeof(uint32_t) && load_u32(data) == INDEX_LEGACY_MAGIC;
+}
+
+/*
+ * Use the index where it lies in a mapped archive, else read it whole;
+ * nothing is parsed. Older archives' indexes are read into the buckets.
+ */
+int symbol_index_load_from_archive(symbol_index_t* index,
+                                  const archive_file_t* archive) {
+    uint8_t* data;
+    int result;
+    
+    if (index == NULL || archive == NULL || archive->file == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    if (!archive_has_index(archive) || archive->header.index_size == 0) {
+        ERROR_REPORT_ERROR(ERROR_ARCHIVE_CORRUPT, "Archive has no symbol index");
+        return ERROR_ARCHIVE_CORRUPT;
+    }
+    
+    if (archive->map != NULL) {
+        if ((uint64_t)archive->header.index_offset + archive->header.index_size >
+            archive->map_size) {
+            ERROR_REPORT_ERROR(ERROR_ARCHIVE_CORRUPT, "Corrupt archive symbol index");
+            return ERROR_ARCHIVE_CORRUPT;
+        }
+        data = archive->map + archive->header.index_offset;
+        return is_legacy_layout(data, archive->header.index_size) ?
+               symbol_index_deserialize(index, data, archive->header.index_size) :
+               symbol_index_attach(index, data, archive->header.index_size);
+    }
+    
+    data = malloc(archive->header.index_size);
+    if (data == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    if (fseek(archive->file, (long)archive->header.index_offset, SEEK_SET) != 0 ||
+        fread(data, archive->header.index_size, 1, archive->file) != 1) {
+        free(data);
+        return ERROR_FILE_IO;
+    }
+    
+    if (is_legacy_layout(data, archive->header.index_size)) {
+        result = symbol_index_deserialize(index, data, archive->header.index_size);
+        free(data);
+        return result;
+    }
+    
+    result = symbol_index_attach(index, data, archive->header.index_size);
+    if (result == ERROR_SUCCESS) {
+        index->view.owned = data;
+    } else {
+        free(data);
+    }
+    
+    return result;
+}
+
+static bool count_entry(const symbol_index_entry_t* entry, void* user_data) {
+    symbol_index_stats_t* stats = user_data;
+    
+    stats->total_symbols++;
+    stats->function_symbols += (size_t)((entry->flags & INDEX_FLAG_FUNCTION) != 0);
+    stats->object_symbols += (size_t)((entry->flags & INDEX_FLAG_OBJECT) != 0);
+    stats->global_symbols += (size_t)((entry->flags & INDEX_FLAG_GLOBAL) != 0);
+    stats->local_symbols += (size_t)((entry->flags & INDEX_FLAG_LOCAL) != 0);
+    stats->weak_symbols += (size_t)((entry->flags & INDEX_FLAG_WEAK) != 0);
+    stats->index_size += sizeof(index_file_entry_t) + strlen(entry->name) + 1;
+    
+    return true;
+}
+
+void symbol_index_get_stats(const symbol_index_t* index, symbol_index_stats_t* stats) {
+    const symbol_index_entry_t* entry;
+    const index_view_t* view;
+    size_t chain;
+    size_t i;
+    
+    if (index == NULL || stats == NULL) {
+        return;
+    }
+    
+    memset(stats, 0, sizeof(symbol_index_stats_t));
+    visit_entries(index, count_entry, stats);
+    
+    /* An attached index is described by its own buckets */
+    view = &index->view;
+    stats->hash_table_size = view->entries != NULL ? view->bucket_count : index->bucket_count;
+    stats->load_factor = (double)stats->total_symbols / (double)stats->hash_table_size;
+    stats->memory_usage = memory_pool_get_used(index->arena) +
+                          (index->bucket_count + index->old_bucket_count) *
+                          sizeof(symbol_index_entry_t*) +
+                          view->symbol_count * sizeof(symbol_index_entry_t);
+    for (i = 0; i < index->absorbed_count; i++) {
+        stats->memory_usage += memory_pool_get_used(index->absorbed[i]);
+    }
+    stats->index_size += sizeof(index_file_header_t) +
+                         (symbol_index_calculate_hash_size(stats->total_symbols) + 1) *
+                         sizeof(uint32_t);
+    
+    for (i = 0; i < index->bucket_count; i++) {
+        chain = 0;
+        for (entry = index->buckets[i]; entry != NULL; entry = entry->next) {
+            chain++;
+        }
+        if (chain > stats->max_chain_length) {
+            stats->max_chain_length = chain;
+        }
+    }
+    for (i = 0; i < index->old_bucket_count; i++) {
+        chain = 0;
+        for (entry = index->old_buckets[i]; entry != NULL; entry = entry->next) {
+            chain++;
+        }
+        if (chain > stats->max_chain_length) {
+            stats->max_chain_length = chain;
+        }
+    }
+    for (i = 0; i < view->bucket_count && view->buckets != NULL; i++) {
+        chain = load_u32(view->buckets + (i + 1) * sizeof(uint32_t)) -
+                load_u32(view->buckets + i * sizeof(uint32_t));
+        if (chain > stats->max_chain_length) {
+            stats->max_chain_length = chain;
+        }
+    }
+}
+
+int symbol_index_rehash(symbol_index_t* index, size_t new_size) {
+    size_t bucket_count = 64;
+    int result;
+    
+    if (index == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    while (bucket_count < new_size) {
+        bucket_count *= 2;
+    }
+    
+    /* Asked for explicitly, so the whole table moves at once */
+    result = begin_rehash(index, bucket_count);
+    migrate_buckets(index, SIZE_MAX);
+    
+    return result;
+}
+
+/* Half load, the size a freshly loaded index of this many symbols gets */
+int symbol_index_optimize(symbol_index_t* index) {
+    if (index == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    return symbol_index_rehash(index, symbol_index_calculate_hash_size(index->symbol_count));
+}
@@ -6,6 +6,7 @@
 #include <unistd.h>
 #include "star.h"
 #include "error.h"
+#include "trace.h"
 
 /**
  * @file main.c
@@ -24,14 +25,22 @@ static struct option long_options[] = {
     {"update",          no_argument,       0, 'u'},
     {"list",            no_argument,       0, 't'},
     {"delete",          no_argument,       0, 'd'},
+    {"compact",         no_argument,       0, 'K'},
     {"file",            required_argument, 0, 'f'},
     {"directory",       required_argument, 0, 'C'},
     {"compress",        required_argument, 0, 'z'},
     {"level",           required_argument, 0, 'L'},
+    {"threads",         required_argument, 0, 'j'},
+    {"block-size",      required_argument, 0, 'B'},
+    {"dictionary",      required_argument, 0, 'D'},
+    {"goal",            required_argument, 0, 'G'},
+    {"dedup",           no_argument,       0, 'e'},
+    {"io",              required_argument, 0, 'O'},
     {"index",           no_argument,       0, 'i'},
     {"sort",            no_argument,       0, 's'},
     {"verbose",         no_argument,       0, 'v'},
     {"force",           no_argument,       0, 'F'},
+    {"trace",           required_argument, 0, 'T'},
     {"help",            no_argument,       0, 'h'},
     {"version",         no_argument,       0, 'V'},
     {0, 0, 0, 0}
@@ -45,15 +54,23 @@ static void print_usage(const char* program_name) {
     printf("  -u, --update              Update archive\n");
     printf("  -t, --list                List archive contents\n");
     printf("  -d, --delete              Delete members from archive\n");
+    printf("  -K, --compact             Reclaim space freed by updates and deletions\n");
     printf("\nOptions:\n");
     printf("  -f, --file ARCHIVE        Use ARCHIVE file\n");
     printf("  -C, --directory DIR       Change to DIR before operation\n");
-    printf("  -z, --compress ALG        Use compression algorithm (none|lz4|zlib|lzma)\n");
+    printf("  -z, --compress ALG        Use compression algorithm (none|lz4|zlib|lzma|auto)\n");
     printf("  -L, --level LEVEL         Set compression level (0-9)\n");
+    printf("  -j, --threads N           Use N worker threads (0 = one per CPU)\n");
+    printf("  -B, --block-size SIZE     Compress members in SIZE byte blocks (0 = whole)\n");
+    printf("  -D, --dictionary SIZE     Train a shared SIZE byte dictionary for lz4|zlib\n");
+    printf("  -G, --goal N              Auto: weight decode speed N%% over size (0-100)\n");
+    printf("  -e, --dedup               Store identical members once\n");
+    printf("  -O, --io BACKEND          Batch extraction I/O (pread|vectored|io_uring)\n");
     printf("  -i, --index               Create symbol index\n");
     printf("  -s, --sort                Sort members by name\n");
     printf("  -v, --verbose             Enable verbose output\n");
     printf("  -F, --force               Force overwrite existing files\n");
+    printf("      --trace=FILE          Write a Chrome trace of the operation to FILE\n");
     printf("  -h, --help                Show this help message\n");
     printf("  -V, --version             Show version information\n");
     printf("\nExamples:\n");
@@ -104,17 +121,32 @@ static star_compression_t parse_compression(const char* name) {
         return STAR_COMPRESS_ZLIB;
     } else if (strcmp(name, "lzma") == 0) {
         return STAR_COMPRESS_LZMA;
+    } else if (strcmp(name, "auto") == 0) {
+        return STAR_COMPRESS_AUTO;
     } else {
         return STAR_COMPRESS_NONE;
     }
 }
 
+static star_io_backend_t parse_io_backend(const char* name) {
+    if (strcmp(name, "pread") == 0) {
+        return STAR_IO_PREAD;
+    } else if (strcmp(name, "vectored") == 0) {
+        return STAR_IO_VECTORED;
+    } else if (strcmp(name, "io_uring") == 0) {
+        return STAR_IO_URING;
+    } else {
+        return STAR_IO_DEFAULT;
+    }
+}
+
 int main(int argc, char* argv[]) {
     /* Variable declarations */
     star_options_t options;
     star_mode_t mode;
     const char* archive_file = NULL;
     const char* directory = NULL;
+    const char* trace_file = NULL;
     const char** input_files;
     size_t input_count = 0;
     int opt;
@@ -139,7 +171,7 @@ int main(int argc, char* argv[]) {
     }
     
     /* Parse command line options */
-    while ((opt = getopt_long(argc, argv, "cxutdf:C:z:L:isvFhV", long_options, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "cxutdKf:C:z:L:j:B:D:G:eO:isvFhV", long_options, NULL)) != -1) {
         switch (opt) {
             case 'c':
                 mode = STAR_MODE_CREATE;
@@ -166,6 +198,11 @@ int main(int argc, char* argv[]) {
                 mode_set = true;
                 break;
                 
+            case 'K':
+                mode = STAR_MODE_COMPACT;
+                mode_set = true;
+                break;
+            
             case 'f':
                 archive_file = optarg;
                 break;
@@ -182,6 +219,27 @@ int main(int argc, char* argv[]) {
                 options.compression_level = atoi(optarg);
                 break;
                 
+            case 'j':
+                options.threads = (size_t)strtoul(optarg, NULL, 0);
+                break;
+            
+            case 'B':
+                options.block_size = (size_t)strtoul(optarg, NULL, 0);
+                break;
+            
+            case 'D':
+                options.dictionary_size = (size_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'G':
+                options.decode_speed_goal = atoi(optarg);
+                break;
+            case 'e':
+                options.deduplicate = true;
+                break;
+            case 'O':
+                options.io_backend = parse_io_backend(optarg);
+                break;
+            
             case 'i':
                 options.create_index = true;
                 break;
@@ -198,6 +256,10 @@ int main(int argc, char* argv[]) {
                 options.force_overwrite = true;
                 break;
                 
+            case 'T':
+                trace_file = optarg;
+                break;
+            
             case 'h':
                 print_usage(argv[0]);
                 free(input_files);
@@ -265,6 +327,15 @@ int main(int argc, char* argv[]) {
     /* Set progress callback */
     star_set_progress_callback(context, progress_callback, &options.verbose);
     
+    /* Like the archive, the trace file is relative to -C */
+    if (trace_file != NULL && trace_start(trace_file, "star") != ERROR_SUCCESS) {
+        fprintf(stderr, "Error: Cannot trace to '%s'%s\n", trace_file,
+                trace_is_available() ? "" : " (built with TRACE=0)");
+        star_context_destroy(context);
+        free(input_files);
+        return EXIT_FAILURE;
+    }
+    
     /* Perform operation */
     result = 0;
     
@@ -317,6 +388,10 @@ int main(int argc, char* argv[]) {
                 result = star_delete_members(context, archive_file, input_files, input_count);
             }
             break;
+        
+        case STAR_MODE_COMPACT:
+            result = star_compact_archive(context, archive_file);
+            break;
     }
     
     if (result == 0) {
@@ -327,8 +402,12 @@ int main(int argc, char* argv[]) {
         fprintf(stderr, "STAR: Operation failed with error code %d\n", result);
     }
     
-    /* Cleanup */
+    /* Cleanup; the context's thread pool goes first, so no span is still open */
     star_context_destroy(context);
+    if (trace_file != NULL && trace_stop() != ERROR_SUCCESS && result == 0) {
+        fprintf(stderr, "Error: Failed to write trace '%s'\n", trace_file);
+        result = ERROR_FILE_IO;
+    }
     free(input_files);
     
     return result == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
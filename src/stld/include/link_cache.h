@@ -0,0 +1,113 @@
+/* src/stld/include/link_cache.h */
+#ifndef LINK_CACHE_H_INCLUDED
+#define LINK_CACHE_H_INCLUDED
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file link_cache.h
+ * @brief Persisted link state for incremental relinking
+ * @details C99 compliant sidecar file written next to the output. It
+ * records a fingerprint of the options, one of the libraries and linker
+ * script, each input's size, modification time and CRC32 (library members
+ * that were pulled in follow the named inputs), the linked address and output file offset of every
+ * input section and the resolved symbol table. The file is written in host
+ * byte order and protected by a CRC32 over everything after the header;
+ * a cache that fails validation is simply not used.
+ */
+
+/* Cache file identification */
+#define LINK_CACHE_MAGIC   0x43444C53U  /* "SLDC" */
+#define LINK_CACHE_VERSION 2
+#define LINK_CACHE_SUFFIX  ".ldcache"
+
+/* Section without bytes in the output file */
+#define LINK_CACHE_NO_DATA 0xFFFFFFFFU
+
+/* File header */
+typedef struct link_cache_header {
+    uint32_t magic;                 /* LINK_CACHE_MAGIC */
+    uint16_t version;               /* LINK_CACHE_VERSION */
+    uint16_t reserved;
+    uint32_t options_hash;          /* Fingerprint of the layout options */
+    uint32_t dependency_hash;       /* Fingerprint of the libraries and script */
+    uint32_t input_count;
+    uint32_t member_count;          /* Trailing inputs taken from libraries */
+    uint32_t section_count;         /* Input sections over all inputs */
+    uint32_t symbol_count;
+    uint32_t string_size;
+    uint32_t checksum;              /* CRC32 of the tables and strings */
+    uint64_t output_size;           /* Output file size when written */
+    int64_t output_mtime;           /* Output modification time (ns) */
+} link_cache_header_t;
+
+/* One input file */
+typedef struct link_cache_input {
+    uint64_t file_size;
+    int64_t mtime;                  /* Modification time (ns) */
+    uint32_t path_offset;           /* Path in the string table */
+    uint32_t checksum;              /* CRC32 of the whole file */
+    uint32_t signature;             /* CRC32 of what the layout depends on */
+    uint32_t first_section;         /* Index of its first cached section */
+    uint32_t section_count;
+    uint32_t reserved;
+} link_cache_input_t;
+
+/* One input section */
+typedef struct link_cache_section {
+    uint32_t address;               /* Linked address */
+    uint32_t file_offset;           /* Output file offset or LINK_CACHE_NO_DATA */
+} link_cache_section_t;
+
+/* One resolved symbol */
+typedef struct link_cache_symbol {
+    uint32_t name_offset;
+    uint32_t value;
+    uint32_t size;
+    uint16_t section_index;
+    uint8_t type;
+    uint8_t binding;
+} link_cache_symbol_t;
+
+/* In-memory cache; every table is owned */
+typedef struct link_cache {
+    link_cache_header_t header;
+    link_cache_input_t* inputs;
+    link_cache_section_t* sections;
+    link_cache_symbol_t* symbols;
+    char* strings;
+    size_t string_capacity;
+} link_cache_t;
+
+/* Allocate zeroed tables; the string table starts with an empty string */
+int link_cache_init(link_cache_t* cache, uint32_t input_count,
+                    uint32_t section_count, uint32_t symbol_count);
+void link_cache_release(link_cache_t* cache);
+
+int link_cache_add_string(link_cache_t* cache, const char* str, uint32_t* offset);
+
+/* NULL when offset is not the start of a string in the table */
+const char* link_cache_get_string(const link_cache_t* cache, uint32_t offset);
+
+/*
+ * Load and validate a cache. Failures are not reported through the error
+ * system, since a missing or stale cache only means a full link:
+ * ERROR_FILE_NOT_FOUND, ERROR_FILE_IO, ERROR_INVALID_MAGIC,
+ * ERROR_UNSUPPORTED_VERSION or ERROR_CORRUPT_HEADER.
+ */
+int link_cache_read(link_cache_t* cache, const char* filename);
+
+/* Write through a temporary file renamed over filename */
+int link_cache_write(link_cache_t* cache, const char* filename);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINK_CACHE_H_INCLUDED */
@@ -0,0 +1,83 @@
+/* src/stld/include/link_server.h */
+#ifndef LINK_SERVER_H_INCLUDED
+#define LINK_SERVER_H_INCLUDED
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file link_server.h
+ * @brief Link jobs over a local socket
+ * @details A server accepts connections on a Unix domain socket and
+ * runs each request's command line on one of a fixed set of worker
+ * threads, so several jobs link at once. A request carries the client's
+ * working directory and arguments; the reply carries the job's exit
+ * status and everything it printed. Messages are in host byte order,
+ * since both ends are on the same machine.
+ */
+
+/* Message identification */
+#define LINK_SERVER_MAGIC       0x4A444C53U  /* "SLDJ" */
+#define LINK_SERVER_VERSION     1
+
+/* Largest request payload accepted */
+#define LINK_SERVER_MAX_REQUEST (1U << 20)
+
+/* Request flags */
+#define LINK_SERVER_FLAG_SHUTDOWN 0x0001U   /* Stop once the running jobs finish */
+
+/* Request, followed by the working directory and argc arguments, each NUL-terminated */
+typedef struct link_server_request {
+    uint32_t magic;                 /* LINK_SERVER_MAGIC */
+    uint16_t version;               /* LINK_SERVER_VERSION */
+    uint16_t flags;
+    uint32_t argc;
+    uint32_t payload_size;
+} link_server_request_t;
+
+/* Reply, followed by out_size bytes of output and err_size of diagnostics */
+typedef struct link_server_reply {
+    uint32_t magic;
+    int32_t status;                 /* Job exit status */
+    uint32_t out_size;
+    uint32_t err_size;
+} link_server_reply_t;
+
+/*
+ * Runs one job: argv as on a command line, relative paths meant against
+ * cwd. What the job prints goes to out and err; the result is its exit
+ * status. Runs on several threads at once.
+ */
+typedef int (*link_server_handler_t)(int argc, char** argv, const char* cwd,
+                                     FILE* out, FILE* err, void* user_data);
+
+/*
+ * Serve jobs on socket_path with workers threads (0 = one per CPU) until
+ * a shutdown request, SIGINT or SIGTERM. A stale socket file is replaced;
+ * one a server still listens on is not (ERROR_FILE_IO).
+ */
+int link_server_run(const char* socket_path, size_t workers,
+                    link_server_handler_t handler, void* user_data);
+
+/*
+ * Run argv on the server at socket_path from the current directory and
+ * copy what it printed to out and err. ERROR_FILE_NOT_FOUND when no
+ * server listens there.
+ */
+int link_server_submit(const char* socket_path, int argc, char* const* argv, bool shutdown,
+                       FILE* out, FILE* err, int* status);
+
+/* Diagnostics stream of the job running on the calling thread, NULL outside a job */
+FILE* link_server_job_stream(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINK_SERVER_H_INCLUDED */
@@ -0,0 +1,52 @@
+/* src/stld/include/map_file.h */
+#ifndef MAP_FILE_H_INCLUDED
+#define MAP_FILE_H_INCLUDED
+
+#include <stdint.h>
+#include <stddef.h>
+#include "symbol_table.h"
+#include "section.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file map_file.h
+ * @brief Memory map output for STLD
+ * @details C99 compliant map file writer. The input sections and the
+ * symbol table are each sorted once by output section and address, then
+ * merged while the output sections are walked in layout order, so the
+ * whole map is written in one pass through a large stdio buffer.
+ */
+
+/* Map file write buffer size */
+#define MAP_FILE_BUFFER_SIZE 65536
+
+/* Suffix added to the output name when no map file name is given */
+#define MAP_FILE_SUFFIX ".map"
+
+/* Input section placed in the output */
+typedef struct map_input {
+    const char* file;               /* Input file name (not owned) */
+    const char* name;               /* Input section name (not owned) */
+    uint32_t address;               /* Linked address */
+    uint32_t size;                  /* Size in bytes */
+    uint32_t output_index;          /* layout_index of its output section */
+} map_input_t;
+
+/*
+ * Write the map of a laid-out link. inputs is sorted in place. Symbols
+ * are placed by their section_index, which holds the layout index of
+ * their output section; the rest are listed after the sections. Fails
+ * with ERROR_FILE_IO when the file cannot be written.
+ */
+int map_file_write(const char* filename, const char* output_file,
+                   const section_manager_t* sections, const symbol_table_t* symbols,
+                   map_input_t* inputs, size_t input_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MAP_FILE_H_INCLUDED */
@@ -0,0 +1,92 @@
+/* src/stld/include/object_cache.h */
+#ifndef OBJECT_CACHE_H_INCLUDED
+#define OBJECT_CACHE_H_INCLUDED
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include "stld.h"
+#include "../../star/include/archive.h"
+#include "../../star/include/index.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file object_cache.h
+ * @brief Entries of the shared input cache (stld_cache_t)
+ * @details Entries are reference counted: the table holds one reference
+ * and every acquire another, so an entry replaced or evicted while a link
+ * uses it is freed only when that link releases it. Everything but the
+ * per-member tables is immutable once an entry is published; a
+ * library's symbol index is resolved in full at load time, so lookups
+ * from concurrent links only read it. Object bytes and decoded members
+ * live in an unlinked memory file, which links map copy-on-write: a hit
+ * costs a mapping, and only the pages a link patches are copied.
+ */
+
+/* What a cached file was loaded as */
+typedef enum {
+    CACHE_ENTRY_OBJECT = 0,         /* Whole file bytes */
+    CACHE_ENTRY_LIBRARY = 1         /* STAR archive with a symbol index */
+} cache_entry_kind_t;
+
+/* One cached file */
+typedef struct cache_entry {
+    struct cache_entry* next;       /* Bucket chain */
+    struct cache_entry* newer;      /* Recency list, most recent at its head */
+    struct cache_entry* older;
+    char* path;
+    uint32_t path_hash;
+    cache_entry_kind_t kind;
+    dev_t device;                   /* Identity the entry was loaded with */
+    ino_t inode;
+    uint64_t file_size;
+    int64_t mtime;                  /* Modification time (ns) */
+    uint32_t checksum;              /* CRC32 of the file */
+    size_t refs;                    /* Guarded by the cache mutex */
+    bool in_table;
+    size_t memory;                  /* Bytes charged to the cache */
+    int fd;                         /* Memory file holding the bytes below, -1 = none yet */
+    uint8_t* data;                  /* CACHE_ENTRY_OBJECT: file_size bytes, read-only */
+    archive_file_t* archive;        /* CACHE_ENTRY_LIBRARY: mapped archive */
+    symbol_index_t* index;
+    uint64_t* member_offsets;       /* Per member: page-aligned offset of its bytes in fd */
+    uint64_t fd_size;               /* Bytes of fd handed out to members */
+    uint8_t* verified;              /* Per member: checksum checked and stored in fd */
+} cache_entry_t;
+
+/*
+ * Entry for path loaded as kind, reloading it when the file changed.
+ * hit tells whether the file was used without being read. Fails with
+ * ERROR_FILE_NOT_FOUND, ERROR_FILE_IO, ERROR_OUT_OF_MEMORY or, for a
+ * library, ERROR_ARCHIVE_CORRUPT or the symbol index's load error.
+ */
+int object_cache_acquire(stld_cache_t* cache, const char* path, cache_entry_kind_t kind,
+                         cache_entry_t** entry, bool* hit);
+void object_cache_release(stld_cache_t* cache, cache_entry_t* entry);
+
+/*
+ * Private writable mapping of an object entry's bytes, released with
+ * munmap; it stays valid after the entry is released. Fails with
+ * ERROR_OUT_OF_MEMORY.
+ */
+int object_cache_map_object(const cache_entry_t* entry, void** map);
+
+/*
+ * Private writable mapping of a library member's decompressed,
+ * checksum-verified bytes, like object_cache_map_object. A member is
+ * decoded once and then shared by every link. Fails with
+ * ERROR_ARCHIVE_CORRUPT, ERROR_DECOMPRESSION_FAILED, ERROR_FILE_IO or
+ * ERROR_OUT_OF_MEMORY.
+ */
+int object_cache_map_member(stld_cache_t* cache, cache_entry_t* entry, uint32_t member_index,
+                            void** map);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OBJECT_CACHE_H_INCLUDED */
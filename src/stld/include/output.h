@@ -0,0 +1,121 @@
+/* src/stld/include/output.h */
+#ifndef OUTPUT_H_INCLUDED
+#define OUTPUT_H_INCLUDED
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "symbol_table.h"
+#include "section.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file output.h
+ * @brief Output generation for STLD
+ * @details C99 compliant streaming output writer. Sections are registered
+ * by reference, the complete file layout is computed up front and the
+ * file is then written front to back in a single pass through one write
+ * buffer. Section contents are never copied into a staging image: small
+ * pieces are gathered in the buffer and large ones are written straight
+ * from the caller's memory (typically the input mapping). Long zero
+ * runs, such as the gap between two ROM regions of a flat image, are left
+ * as file holes unless fill_gaps asks for them to be written. Relocatable
+ * SMOF outputs also carry the relocations the next link has to apply.
+ */
+
+/* Write buffer size; runs at least this long bypass the buffer */
+#define OUTPUT_BUFFER_SIZE 262144
+
+/* Zero runs at least this long are left as file holes */
+#define OUTPUT_HOLE_SIZE 65536
+
+/* Largest file alignment honoured for section data (4KB) */
+#define OUTPUT_MAX_FILE_ALIGNMENT_SHIFT 12
+
+/* Output formats */
+typedef enum {
+    OUTPUT_TYPE_SMOF = 0,           /* SMOF file with section and symbol tables */
+    OUTPUT_TYPE_BINARY_FLAT = 1     /* Memory image starting at base_address */
+} output_type_t;
+
+/* Output configuration */
+typedef struct output_config {
+    output_type_t type;             /* Output format */
+    uint32_t base_address;          /* First address of a flat image */
+    uint32_t entry_point;           /* SMOF header entry point */
+    uint16_t file_flags;            /* SMOF_FLAG_* for the header */
+    bool fill_gaps;                 /* Fill flat image gaps with fill_value */
+    uint8_t fill_value;             /* Gap byte (gaps are 0 otherwise) */
+} output_config_t;
+
+/* Relocation written to a relocatable SMOF output */
+typedef struct output_relocation {
+    uint32_t offset;                /* Offset within its output section */
+    uint32_t symbol;                /* Symbol handle in the written symbol table */
+    uint8_t type;                   /* SMOF_RELOC_* */
+    uint32_t section;               /* Output section index */
+} output_relocation_t;
+
+/* Forward declaration */
+typedef struct output_generator output_generator_t;
+
+/*
+ * Create a generator. The symbol table is written to SMOF outputs and must
+ * not change between calculate_size and generate_to_file.
+ */
+output_generator_t* output_generator_create(const symbol_table_t* symbols);
+void output_generator_destroy(output_generator_t* generator);
+
+bool output_generator_configure(output_generator_t* generator, const output_config_t* config);
+
+/*
+ * Append an output section. The name and data are referenced, not copied,
+ * and must stay valid until the file is written; NULL data (or
+ * SMOF_SECT_ZERO_FILL in flags) gives a zero-filled section. alignment is
+ * a power-of-two exponent as in smof_section_t.
+ */
+int output_generator_add_section(output_generator_t* generator, const char* name,
+                                 uint32_t address, uint32_t size, uint16_t flags,
+                                 uint8_t alignment, const uint8_t* data);
+
+/*
+ * Append a section built by the section manager. Its fragment list is
+ * written in place of a contiguous buffer, with zeros between fragments;
+ * the section and its fragments must stay valid until the file is written.
+ */
+int output_generator_add_merged_section(output_generator_t* generator, const section_t* section);
+
+/*
+ * Relocation table of a SMOF output, written in the given order. The
+ * array is referenced, not copied; flat images ignore it.
+ */
+int output_generator_set_relocations(output_generator_t* generator,
+                                     const output_relocation_t* relocations, size_t count);
+
+size_t output_generator_get_section_count(const output_generator_t* generator);
+
+/* Size of the file generate_to_file would write; 0 if the layout is invalid */
+size_t output_generator_calculate_size(output_generator_t* generator);
+
+/*
+ * File offset of section index's first byte, valid after calculate_size.
+ * False when the section has no bytes in the file (zero fill or empty).
+ */
+bool output_generator_get_file_offset(const output_generator_t* generator, size_t index,
+                                      uint32_t* offset);
+
+/*
+ * Write the output. Fails with ERROR_INVALID_SECTION when flat sections
+ * overlap or lie below base_address, ERROR_OUTPUT_TOO_LARGE when a table
+ * or the file exceeds the SMOF limits and ERROR_FILE_IO on write errors.
+ */
+int output_generator_generate_to_file(output_generator_t* generator, const char* filename);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OUTPUT_H_INCLUDED */
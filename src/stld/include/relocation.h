@@ -0,0 +1,137 @@
+/* src/stld/include/relocation.h */
+#ifndef RELOCATION_H_INCLUDED
+#define RELOCATION_H_INCLUDED
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "symbol_table.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file relocation.h
+ * @brief Relocation engine for STLD
+ * @details C99 compliant relocation processing. Entries are collected
+ * first and applied in one pass: they are resolved against the symbol
+ * table, grouped by (section, type), sorted by offset and each group is
+ * handed to a patch kernel specialised for its type, so the inner loop
+ * never dispatches per entry and writes move forward through the section.
+ * Sections are independent, so with a thread pool each section's entries
+ * are sorted and applied by one worker.
+ */
+
+/* Relocation types (values match SMOF_RELOC_*) */
+typedef enum {
+    RELOC_TYPE_NONE = 0,
+    RELOC_TYPE_ABS32 = 1,
+    RELOC_TYPE_REL32 = 2,
+    RELOC_TYPE_ABS16 = 3,
+    RELOC_TYPE_REL16 = 4,
+    RELOC_TYPE_SYSCALL = 5,
+    RELOC_TYPE_GOT = 6,
+    RELOC_TYPE_PLT = 7,
+    RELOC_TYPE_COUNT = 8
+} relocation_type_t;
+
+/* Largest section id the engine can group (24 bits of the sort key) */
+#define RELOCATION_MAX_SECTIONS 0x1000000U
+
+/* Relocation id (index in insertion order) */
+typedef uint32_t relocation_id_t;
+#define RELOCATION_ID_INVALID ((relocation_id_t)0xFFFFFFFFU)
+
+/*
+ * Relocation entry. With S the symbol address, A the addend, P the
+ * address of the patched field and G the address of the symbol's GOT
+ * slot, the field receives:
+ *   ABS32, SYSCALL  S + A (32 bits)
+ *   ABS16           S + A (16 bits, range checked)
+ *   REL32, PLT      S + A - P (32 bits; PLT binds directly when static)
+ *   REL16           S + A - P (16 bits signed, range checked)
+ *   GOT             G + A (32 bits)
+ */
+typedef struct relocation_entry {
+    uint32_t offset;                /* Offset within the target section */
+    relocation_type_t type;         /* Relocation type */
+    symbol_handle_t symbol_handle;  /* Target symbol */
+    int32_t addend;                 /* Constant added to the result */
+    uint32_t section_id;            /* Section registered with the engine */
+} relocation_entry_t;
+
+/* Relocation statistics */
+typedef struct relocation_stats {
+    size_t total_relocations;       /* Entries added */
+    size_t resolved_relocations;    /* Entries applied by the last pass */
+    size_t unresolved_relocations;  /* Entries not (yet) applied */
+    size_t pc_relative_count;       /* REL32, REL16 and PLT entries */
+    size_t absolute_count;          /* ABS32 and ABS16 entries */
+    size_t got_entries;             /* GOT slots allocated */
+    size_t group_count;             /* (section, type) groups applied */
+    size_t type_counts[RELOC_TYPE_COUNT];  /* Entries per type */
+    double type_time[RELOC_TYPE_COUNT];    /* Seconds spent per kernel */
+    double process_time;            /* Seconds for the whole pass */
+} relocation_stats_t;
+
+/* Forward declarations */
+typedef struct relocation_engine relocation_engine_t;
+struct thread_pool;
+
+/* Relocation engine operations */
+relocation_engine_t* relocation_engine_create(const symbol_table_t* symbols);
+void relocation_engine_destroy(relocation_engine_t* engine);
+void relocation_engine_clear(relocation_engine_t* engine);
+
+/* Register the buffer and load address of a target section */
+int relocation_engine_set_section(relocation_engine_t* engine, uint32_t section_id,
+                                  uint8_t* data, uint32_t size, uint32_t address);
+
+/*
+ * Apply section partitions on pool (NULL = calling thread only). The
+ * symbol table must not change while process_all runs.
+ */
+void relocation_engine_set_thread_pool(relocation_engine_t* engine, struct thread_pool* pool);
+
+/* Address of the GOT built from GOT relocations (default 0) */
+void relocation_engine_set_got_address(relocation_engine_t* engine, uint32_t address);
+
+relocation_id_t relocation_engine_add_entry(relocation_engine_t* engine,
+                                            const relocation_entry_t* entry);
+
+/*
+ * Resolve and apply every entry. Fails with ERROR_SYMBOL_NOT_FOUND if a
+ * strong reference is undefined (undefined weak symbols resolve to 0),
+ * ERROR_INVALID_RELOCATION for a field outside its section and
+ * ERROR_RELOCATION_FAILED when a 16-bit value is out of range.
+ */
+int relocation_engine_process_all(relocation_engine_t* engine);
+
+/* Engine information */
+size_t relocation_engine_get_count(const relocation_engine_t* engine);
+bool relocation_engine_has_unresolved(const relocation_engine_t* engine);
+relocation_stats_t relocation_engine_get_statistics(const relocation_engine_t* engine);
+
+/* GOT contents (symbol addresses in slot order) built by the last pass */
+const uint32_t* relocation_engine_get_got(const relocation_engine_t* engine, size_t* count);
+
+/* C99 inline utility functions */
+static inline bool relocation_type_is_pc_relative(relocation_type_t type) {
+    return type == RELOC_TYPE_REL32 || type == RELOC_TYPE_REL16 || type == RELOC_TYPE_PLT;
+}
+
+static inline uint32_t relocation_type_width(relocation_type_t type) {
+    switch (type) {
+        case RELOC_TYPE_NONE:  return 0;
+        case RELOC_TYPE_ABS16:
+        case RELOC_TYPE_REL16: return 2;
+        default:               return 4;
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RELOCATION_H_INCLUDED */
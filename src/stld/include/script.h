@@ -0,0 +1,99 @@
+/* src/stld/include/script.h */
+#ifndef SCRIPT_H_INCLUDED
+#define SCRIPT_H_INCLUDED
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file script.h
+ * @brief Linker script support for STLD
+ * @details C99 compliant parser for a subset of the GNU ld script
+ * language: ENTRY(symbol) and a SECTIONS block of output sections, each
+ * with an optional address and ALIGN(n) and a list of input section
+ * patterns, optionally inside KEEP(). "/DISCARD/" drops what it matches
+ * and ". = address;" sets the start of the next output section. Input
+ * file patterns must be "*".
+ *
+ * All patterns are compiled into one trie over their literal prefixes
+ * when the script is parsed. Matching an input section name walks the
+ * trie once; only patterns with a wildcard other than a trailing '*'
+ * are glob-matched, and only against the rest of the name below the
+ * node where their prefix ends.
+ *
+ * Example:
+ *
+ *     ENTRY(_start)
+ *     SECTIONS {
+ *         . = 0x100000;
+ *         .text : { KEEP(*(.text.boot)) *(.text .text.*) }
+ *         .rodata ALIGN(16) : { *(.rodata*) }
+ *         .data 0x200000 : { *(.data*) }
+ *         .bss : { *(.bss*) }
+ *         /DISCARD/ : { *(.comment) *(.note.*) }
+ *     }
+ */
+
+/* Input section no rule matches */
+#define SCRIPT_NO_RULE 0xFFFFFFFFU
+
+/* Largest number of output sections in one script */
+#define SCRIPT_MAX_OUTPUTS 0xFFFEU
+
+/* Output section statement */
+typedef struct script_output {
+    const char* name;               /* Output section name */
+    bool discard;                   /* "/DISCARD/": matching inputs are dropped */
+    bool fixed;                     /* Starts at address */
+    uint32_t address;
+    uint32_t alignment;             /* ALIGN(n) in bytes, 0 if not given */
+} script_output_t;
+
+/* Input section description: the patterns inside one "*(...)" */
+typedef struct script_rule {
+    uint32_t output;                /* Index of its output section */
+    bool keep;                      /* Inside KEEP(): a root for --gc-sections */
+} script_rule_t;
+
+/* Forward declarations */
+typedef struct linker_script linker_script_t;
+struct memory_pool;
+
+/*
+ * Parse a script held in memory. Everything is allocated from pool,
+ * which must outlive the script. Fails with ERROR_SCRIPT_SYNTAX (and a
+ * message naming the line) on malformed or unsupported input.
+ */
+int linker_script_parse(const char* text, size_t length, struct memory_pool* pool,
+                        linker_script_t** script);
+
+/* Read and parse a script file */
+int linker_script_load(const char* filename, struct memory_pool* pool,
+                       linker_script_t** script);
+
+/* ENTRY symbol, or NULL if the script names none */
+const char* linker_script_get_entry(const linker_script_t* script);
+
+size_t linker_script_get_output_count(const linker_script_t* script);
+const script_output_t* linker_script_get_output(const linker_script_t* script, size_t index);
+
+size_t linker_script_get_rule_count(const linker_script_t* script);
+const script_rule_t* linker_script_get_rule(const linker_script_t* script, uint32_t rule);
+
+/*
+ * Rule placing an input section of this name: the first rule in script
+ * order with a matching pattern, or SCRIPT_NO_RULE. Rules are numbered in
+ * script order, so the number also orders inputs within an output.
+ */
+uint32_t linker_script_match(const linker_script_t* script, const char* name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCRIPT_H_INCLUDED */
@@ -0,0 +1,156 @@
+/* src/stld/include/section.h */
+#ifndef SECTION_H_INCLUDED
+#define SECTION_H_INCLUDED
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file section.h
+ * @brief Output section management for STLD
+ * @details C99 compliant section handling. Output sections are found by
+ * name through a hash index, so merging same-named input sections costs
+ * O(1) per fragment. A section's contents are a scatter list of
+ * fragments that reference the caller's memory; nothing is copied or
+ * reallocated as fragments are added. Layout is a single sort of all
+ * sections followed by one address-assignment pass.
+ */
+
+/* Section id (index in creation order) */
+typedef uint32_t section_id_t;
+#define SECTION_ID_INVALID ((section_id_t)0xFFFFFFFFU)
+
+/* Rank of sections placed by class alone */
+#define SECTION_RANK_NONE 0xFFFFU
+
+/* Section flags (values match SMOF_SECT_*) */
+#define SECTION_FLAG_EXECUTABLE 0x0001U
+#define SECTION_FLAG_WRITABLE   0x0002U
+#define SECTION_FLAG_READABLE   0x0004U
+#define SECTION_FLAG_LOADABLE   0x0008U
+#define SECTION_FLAG_ZERO_FILL  0x0010U
+
+/* Section types */
+typedef enum {
+    SECTION_TYPE_TEXT = 0,          /* Executable code */
+    SECTION_TYPE_RODATA = 1,        /* Read-only data */
+    SECTION_TYPE_DATA = 2,          /* Writable data */
+    SECTION_TYPE_BSS = 3,           /* Zero-initialised data */
+    SECTION_TYPE_PROGBITS = 4,      /* Other contents */
+    SECTION_TYPE_NOTE = 5           /* Non-loaded notes */
+} section_type_t;
+
+/* Piece of a section; fragments are ordered by offset */
+typedef struct section_fragment {
+    const uint8_t* data;            /* Contents (not owned), NULL for zero fill */
+    uint32_t offset;                /* Offset within the section */
+    uint32_t size;                  /* Size in bytes */
+    struct section_fragment* next;
+} section_fragment_t;
+
+/* Output section */
+typedef struct section {
+    const char* name;               /* Section name (copied) */
+    section_type_t type;            /* Section type */
+    uint16_t flags;                 /* SECTION_FLAG_* */
+    uint32_t alignment;             /* Alignment in bytes (power of two) */
+    uint32_t address;               /* Load address, set by layout */
+    uint32_t size;                  /* Size including alignment padding */
+    uint32_t layout_index;          /* Position in the layout order */
+    size_t fragment_count;          /* Fragments in the list */
+    const section_fragment_t* fragments;  /* Scatter list by offset */
+} section_t;
+
+/* Forward declarations */
+typedef struct section_manager section_manager_t;
+struct memory_pool;
+
+/*
+ * Create a manager whose records and fragments come from pool, which
+ * must outlive it.
+ */
+section_manager_t* section_manager_create(struct memory_pool* pool);
+void section_manager_destroy(section_manager_t* manager);
+
+/*
+ * Create a section. Names need not be unique: find_section returns the
+ * first live section of that name.
+ */
+section_id_t section_manager_create_section(section_manager_t* manager, const char* name,
+                                            section_type_t type, uint16_t flags);
+section_id_t section_manager_find_section(const section_manager_t* manager, const char* name);
+
+/* NULL for an invalid or merged-away id */
+const section_t* section_manager_get_section(const section_manager_t* manager, section_id_t id);
+
+/*
+ * Append a fragment at the next multiple of alignment (bytes, power of
+ * two). data is referenced, not copied; NULL adds zero fill. The
+ * fragment's offset within the section is stored in offset if non-NULL.
+ */
+int section_manager_add_data(section_manager_t* manager, section_id_t id,
+                             const uint8_t* data, uint32_t size,
+                             uint32_t alignment, uint32_t* offset);
+
+int section_manager_set_alignment(section_manager_t* manager, section_id_t id,
+                                  uint32_t alignment);
+
+/* Place one section by hand; calculate_layout overrides it */
+int section_manager_assign_address(section_manager_t* manager, section_id_t id,
+                                   uint32_t address);
+
+/* Ranked sections are laid out first, in rank order; the rest follow */
+int section_manager_set_rank(section_manager_t* manager, section_id_t id, uint16_t rank);
+
+/*
+ * Have layout start the section at address (aligned up to its
+ * alignment). calculate_layout fails with ERROR_INVALID_SECTION when the
+ * sections before it already extend past address.
+ */
+int section_manager_set_start(section_manager_t* manager, section_id_t id, uint32_t address);
+
+/*
+ * Append source's fragments to target, aligned to source's alignment.
+ * source is removed; fragment offsets of source shift by the returned
+ * base stored in offset if non-NULL.
+ */
+int section_manager_merge_sections(section_manager_t* manager, section_id_t target,
+                                   section_id_t source, uint32_t* offset);
+
+/*
+ * Assign addresses from base_address: ranked sections in rank order,
+ * then code, read-only data, writable data and zero fill; larger
+ * alignments first within each class and creation order among equals.
+ * Fails with ERROR_OUTPUT_TOO_LARGE when the image passes 4GB.
+ */
+int section_manager_calculate_layout(section_manager_t* manager, uint32_t base_address);
+
+/* Live sections in layout order (creation order before any layout) */
+const section_id_t* section_manager_get_layout(const section_manager_t* manager, size_t* count);
+
+/* Manager information */
+size_t section_manager_get_count(const section_manager_t* manager);
+bool section_manager_is_empty(const section_manager_t* manager);
+
+/* Type implied by SECTION_FLAG_* */
+section_type_t section_type_from_flags(uint16_t flags);
+
+/* C99 inline utility functions */
+static inline uint32_t section_end_address(const section_t* section) {
+    return section->address + section->size;
+}
+
+static inline bool section_is_zero_fill(const section_t* section) {
+    return (section->flags & SECTION_FLAG_ZERO_FILL) != 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SECTION_H_INCLUDED */
@@ -84,19 +84,53 @@ typedef struct stld_options {
     bool verbose;                       /**< Enable verbose output */
     const char* map_file;               /**< Custom map file name */
     const char* script_file;            /**< Linker script file */
+    size_t threads;                     /**< Worker threads (0 = one per CPU, 1 = serial) */
+    bool gc_sections;                   /**< Drop unreachable sections (implied by OPTIMIZE_SIZE) */
+    bool fold_identical;                /**< Fold identical code (implied by OPTIMIZE_SIZE/BALANCED) */
+    bool incremental;                   /**< Relink from the cache kept next to the output */
 } stld_options_t;
 
+/**
+ * @brief Link phases timed by stld_link
+ * 
+ * @details A phase may run in several stretches (symbol resolution covers
+ * library pull-in and the symbol merge); its time is their sum.
+ */
+typedef enum {
+    STLD_PHASE_LOAD = 0,        /**< Map and parse input objects */
+    STLD_PHASE_RESOLVE = 1,     /**< Library pull-in and symbol resolution */
+    STLD_PHASE_LAYOUT = 2,      /**< Section collection, folding and layout */
+    STLD_PHASE_RELOCATE = 3,    /**< Relocation resolution and patching */
+    STLD_PHASE_WRITE = 4,       /**< Output and link cache writing */
+    STLD_PHASE_COUNT = 5
+} stld_phase_t;
+
+/**
+ * @brief Per-phase profile
+ */
+typedef struct stld_phase_stats {
+    double time;                        /**< Wall time in seconds */
+    size_t peak_memory;                 /**< Peak arena and symbol table bytes */
+} stld_phase_stats_t;
+
 /**
  * @brief Linker statistics
  */
 typedef struct stld_stats {
     size_t input_files;                 /**< Number of input files */
     size_t total_sections;              /**< Total sections processed */
+    size_t sections_removed;            /**< Unreachable sections dropped */
+    size_t sections_folded;             /**< Sections folded into an identical copy */
+    size_t inputs_reused;               /**< Inputs taken unchanged from the link cache */
+    size_t members_loaded;              /**< Archive members pulled in from libraries */
+    size_t inputs_cached;               /**< Inputs and libraries taken from a shared cache */
     size_t total_symbols;               /**< Total symbols processed */
     size_t relocations_processed;       /**< Relocations processed */
+    size_t relocations_kept;            /**< Relocations left in a relocatable output */
     size_t output_size;                 /**< Output file size */
     size_t memory_used;                 /**< Peak memory usage */
     double link_time;                   /**< Linking time in seconds */
+    stld_phase_stats_t phases[STLD_PHASE_COUNT]; /**< Indexed by stld_phase_t */
 } stld_stats_t;
 
 /**
@@ -104,6 +138,32 @@ typedef struct stld_stats {
  */
 typedef struct stld_context stld_context_t;
 
+/**
+ * @brief Input cache shared across links (opaque)
+ * 
+ * @details Keeps the bytes of input objects and the mapped archive,
+ * resolved symbol index and decoded members of libraries between links.
+ * Entries are keyed by path and reused while the file's device, inode,
+ * size and modification time match; a file whose timestamp moved is
+ * reloaded, and kept only when its CRC32 shows the contents changed.
+ * 
+ * @par Thread Safety
+ * A cache may serve contexts linking concurrently on different threads.
+ */
+typedef struct stld_cache stld_cache_t;
+
+/**
+ * @brief Shared cache statistics
+ */
+typedef struct stld_cache_stats {
+    size_t hits;                        /**< Lookups served without reading the file */
+    size_t misses;                      /**< Lookups that loaded the file */
+    size_t revalidated;                 /**< Reloads that found the contents unchanged */
+    size_t evictions;                   /**< Entries dropped to stay within the limit */
+    size_t entries;                     /**< Files cached */
+    size_t memory_used;                 /**< Bytes held, library mappings included */
+} stld_cache_stats_t;
+
 /**
  * @brief Progress callback function type
  * 
@@ -151,6 +211,8 @@ int stld_add_input_file(stld_context_t* context, const char* filename);
 /**
  * @brief Add library search path
  * 
+ * @details Directories are searched in the order they were added.
+ * 
  * @param[in] context Linker context
  * @param[in] path Library search path
  * @return 0 on success, negative error code on failure
@@ -160,12 +222,54 @@ int stld_add_library_path(stld_context_t* context, const char* path);
 /**
  * @brief Add library to link
  * 
+ * @details The library is the STAR archive lib<libname>.star in the
+ * search path, or libname itself if it contains a '/'. Only members that
+ * define a symbol still undefined by the inputs (or by members already
+ * pulled in) are loaded; the archive must carry a symbol index.
+ * 
  * @param[in] context Linker context
- * @param[in] libname Library name (without lib prefix and .a suffix)
+ * @param[in] libname Library name (without lib prefix and .star suffix)
  * @return 0 on success, negative error code on failure
  */
 int stld_add_library(stld_context_t* context, const char* libname);
 
+/**
+ * @brief Create a shared input cache
+ * 
+ * @param[in] max_memory Bytes to hold before unused entries are dropped (0 = unlimited)
+ * @return Cache or NULL on failure
+ */
+stld_cache_t* stld_cache_create(size_t max_memory);
+
+/**
+ * @brief Destroy a shared input cache
+ * 
+ * @details No context using the cache may be linking.
+ * 
+ * @param[in] cache Cache to destroy
+ */
+void stld_cache_destroy(stld_cache_t* cache);
+
+/**
+ * @brief Get shared cache statistics
+ * 
+ * @param[in] cache Cache
+ * @param[out] stats Statistics structure to fill
+ */
+void stld_cache_get_stats(stld_cache_t* cache, stld_cache_stats_t* stats);
+
+/**
+ * @brief Load inputs and libraries through a shared cache
+ * 
+ * @details The cache must outlive the context's links. Every input is
+ * mapped copy-on-write from the cache, so relocation never touches
+ * cached bytes and only the pages it patches are copied.
+ * 
+ * @param[in] context Linker context
+ * @param[in] cache Cache to use (NULL to read files directly)
+ */
+void stld_set_cache(stld_context_t* context, stld_cache_t* cache);
+
 /**
  * @brief Perform linking operation
  * 
@@ -225,6 +329,14 @@ stld_options_t stld_get_default_options(void);
  */
 bool stld_validate_options(const stld_options_t* options);
 
+/**
+ * @brief Get phase name
+ * 
+ * @param[in] phase Link phase
+ * @return Lower-case name ("load", "resolve", ...), "unknown" if out of range
+ */
+const char* stld_phase_name(stld_phase_t phase);
+
 /**
  * @brief Get version information
  * 
@@ -0,0 +1,159 @@
+/* src/stld/include/symbol_table.h */
+#ifndef SYMBOL_TABLE_H_INCLUDED
+#define SYMBOL_TABLE_H_INCLUDED
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file symbol_table.h
+ * @brief Global symbol table for STLD
+ * @details C99 compliant hash-indexed symbol table. Symbol attributes are
+ * stored as parallel arrays addressed by symbol_handle_t; names live in an
+ * interned string pool and are located through an open-addressing hash
+ * index. Entries are read back by copy (symbol_table_get) or one field at
+ * a time through the accessors.
+ */
+
+/* Symbol table configuration */
+#define SYMBOL_TABLE_INITIAL_CAPACITY 64
+#define SYMBOL_TABLE_MAX_LOAD_PERCENT 70
+#define SYMBOL_TABLE_STRINGS_INITIAL 16384
+
+/* Undefined section index (matches SMOF) */
+#define SECTION_INDEX_UNDEFINED 0xFFFFU
+
+/* Symbol handle (stable index into the table) */
+typedef uint32_t symbol_handle_t;
+#define SYMBOL_HANDLE_INVALID ((symbol_handle_t)0xFFFFFFFFU)
+
+/* Symbol types (values match SMOF_SYM_*) */
+typedef enum {
+    SYMBOL_TYPE_NOTYPE = 0,
+    SYMBOL_TYPE_OBJECT = 1,
+    SYMBOL_TYPE_FUNCTION = 2,
+    SYMBOL_TYPE_SECTION = 3,
+    SYMBOL_TYPE_FILE = 4,
+    SYMBOL_TYPE_SYSCALL = 5
+} symbol_type_t;
+
+/* Symbol binding (values match SMOF_BIND_*) */
+typedef enum {
+    SYMBOL_BINDING_LOCAL = 0,
+    SYMBOL_BINDING_GLOBAL = 1,
+    SYMBOL_BINDING_WEAK = 2,
+    SYMBOL_BINDING_EXPORT = 3
+} symbol_binding_t;
+
+/* Symbol visibility */
+typedef enum {
+    SYMBOL_VISIBILITY_DEFAULT = 0,
+    SYMBOL_VISIBILITY_HIDDEN = 1,
+    SYMBOL_VISIBILITY_PROTECTED = 2
+} symbol_visibility_t;
+
+/* Symbol description */
+typedef struct symbol {
+    const char* name;               /* Symbol name (interned by table) */
+    symbol_type_t type;             /* Symbol type */
+    symbol_binding_t binding;       /* Symbol binding */
+    symbol_visibility_t visibility; /* Symbol visibility */
+    uint16_t section_index;         /* Section index or SECTION_INDEX_UNDEFINED */
+    uint32_t value;                 /* Symbol value/address */
+    uint32_t size;                  /* Symbol size in bytes */
+} symbol_t;
+
+/* Forward declaration */
+typedef struct symbol_table symbol_table_t;
+
+/* Symbol iterator */
+typedef struct symbol_iterator {
+    const symbol_table_t* table;    /* Table being iterated */
+    symbol_handle_t current;        /* Current handle */
+} symbol_iterator_t;
+
+/* Symbol table operations */
+symbol_table_t* symbol_table_create(size_t initial_capacity);
+void symbol_table_destroy(symbol_table_t* table);
+void symbol_table_clear(symbol_table_t* table);
+
+/*
+ * Insert a symbol, merging with an existing global of the same name.
+ * Local symbols are always added; they are only indexed by name while no
+ * global of that name exists. Undefined and weak entries are upgraded in
+ * place by a later definition, so handles to them stay valid. A second
+ * strong definition reports ERROR_DUPLICATE_SYMBOL.
+ */
+symbol_handle_t symbol_table_insert(symbol_table_t* table, const symbol_t* symbol);
+
+/* Insert with a precomputed symbol_table_hash_name() value */
+symbol_handle_t symbol_table_insert_hash(symbol_table_t* table,
+                                         const symbol_t* symbol,
+                                         uint32_t hash);
+
+/* Symbol lookup */
+symbol_handle_t symbol_table_lookup(const symbol_table_t* table, const char* name);
+symbol_handle_t symbol_table_lookup_hash(const symbol_table_t* table,
+                                         const char* name,
+                                         uint32_t hash);
+
+/*
+ * Copy an entry out of the table; false for an invalid handle. The name
+ * pointer (like that from symbol_table_get_name) is invalidated by the
+ * next insert.
+ */
+bool symbol_table_get(const symbol_table_t* table, symbol_handle_t handle, symbol_t* symbol);
+
+/* Single-field accessors for hot paths */
+const char* symbol_table_get_name(const symbol_table_t* table, symbol_handle_t handle);
+uint32_t symbol_table_get_value(const symbol_table_t* table, symbol_handle_t handle);
+uint16_t symbol_table_get_section_index(const symbol_table_t* table, symbol_handle_t handle);
+symbol_binding_t symbol_table_get_binding(const symbol_table_t* table, symbol_handle_t handle);
+
+/* Table information */
+size_t symbol_table_size(const symbol_table_t* table);
+bool symbol_table_is_empty(const symbol_table_t* table);
+size_t symbol_table_count_undefined(const symbol_table_t* table);
+size_t symbol_table_count_unresolved(const symbol_table_t* table); /* Excludes weak */
+size_t symbol_table_get_memory_usage(const symbol_table_t* table);
+
+/* Iteration */
+symbol_iterator_t symbol_table_begin(const symbol_table_t* table);
+bool symbol_iterator_is_valid(const symbol_iterator_t* iter);
+bool symbol_iterator_get(const symbol_iterator_t* iter, symbol_t* symbol);
+void symbol_iterator_next(symbol_iterator_t* iter);
+
+/* The visitor receives a copy of each entry */
+typedef bool (*symbol_table_visitor_t)(symbol_handle_t handle,
+                                       const symbol_t* symbol,
+                                       void* user_data);
+void symbol_table_foreach(const symbol_table_t* table,
+                          symbol_table_visitor_t visitor,
+                          void* user_data);
+
+/* Utility functions */
+uint32_t symbol_table_hash_name(const char* name);
+
+/* C99 inline utility functions */
+static inline bool symbol_is_defined(const symbol_t* symbol) {
+    return symbol != NULL && symbol->section_index != SECTION_INDEX_UNDEFINED;
+}
+
+static inline bool symbol_is_global(const symbol_t* symbol) {
+    return symbol != NULL && symbol->binding != SYMBOL_BINDING_LOCAL;
+}
+
+static inline bool symbol_is_weak(const symbol_t* symbol) {
+    return symbol != NULL && symbol->binding == SYMBOL_BINDING_WEAK;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYMBOL_TABLE_H_INCLUDED */
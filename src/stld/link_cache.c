@@ -0,0 +1,331 @@
+/* src/stld/link_cache.c */
+#include "include/link_cache.h"
+#include "../common/include/error.h"
+#include "../common/include/crc32.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/**
+ * @file link_cache.c
+ * @brief Link-state cache implementation
+ * @details The file is the header followed by the input, section and
+ * symbol tables and the string table, each stored exactly as in memory.
+ */
+
+/* Initial string table size */
+#define LINK_CACHE_STRINGS_INITIAL 1024
+
+int link_cache_init(link_cache_t* cache, uint32_t input_count,
+                    uint32_t section_count, uint32_t symbol_count) {
+    if (cache == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    *cache = (link_cache_t) {
+        .header = {
+            .magic = LINK_CACHE_MAGIC,
+            .version = LINK_CACHE_VERSION,
+            .input_count = input_count,
+            .section_count = section_count,
+            .symbol_count = symbol_count,
+            .string_size = 1
+        },
+        .inputs = calloc(input_count > 0 ? input_count : 1, sizeof(link_cache_input_t)),
+        .sections = calloc(section_count > 0 ? section_count : 1, sizeof(link_cache_section_t)),
+        .symbols = calloc(symbol_count > 0 ? symbol_count : 1, sizeof(link_cache_symbol_t)),
+        .strings = malloc(LINK_CACHE_STRINGS_INITIAL),
+        .string_capacity = LINK_CACHE_STRINGS_INITIAL
+    };
+    
+    if (cache->inputs == NULL || cache->sections == NULL ||
+        cache->symbols == NULL || cache->strings == NULL) {
+        link_cache_release(cache);
+        return ERROR_OUT_OF_MEMORY;
+    }
+    cache->strings[0] = '\0';
+    
+    return ERROR_SUCCESS;
+}
+
+void link_cache_release(link_cache_t* cache) {
+    if (cache != NULL) {
+        free(cache->inputs);
+        free(cache->sections);
+        free(cache->symbols);
+        free(cache->strings);
+        cache->inputs = NULL;
+        cache->sections = NULL;
+        cache->symbols = NULL;
+        cache->strings = NULL;
+        cache->string_capacity = 0;
+    }
+}
+
+int link_cache_add_string(link_cache_t* cache, const char* str, uint32_t* offset) {
+    size_t length;
+    size_t capacity;
+    char* grown;
+    
+    if (cache == NULL || str == NULL || offset == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    length = strlen(str) + 1;
+    if (length > UINT32_MAX - cache->header.string_size) {
+        return ERROR_OUTPUT_TOO_LARGE;
+    }
+    
+    if (cache->header.string_size + length > cache->string_capacity) {
+        capacity = cache->string_capacity * 2;
+        while (capacity < cache->header.string_size + length) {
+            capacity *= 2;
+        }
+        
+        grown = realloc(cache->strings, capacity);
+        if (grown == NULL) {
+            return ERROR_OUT_OF_MEMORY;
+        }
+        cache->strings = grown;
+        cache->string_capacity = capacity;
+    }
+    
+    *offset = cache->header.string_size;
+    memcpy(cache->strings + cache->header.string_size, str, length);
+    cache->header.string_size += (uint32_t)length;
+    
+    return ERROR_SUCCESS;
+}
+
+const char* link_cache_get_string(const link_cache_t* cache, uint32_t offset) {
+    if (cache == NULL || cache->strings == NULL || offset >= cache->header.string_size ||
+        memchr(cache->strings + offset, '\0', cache->header.string_size - offset) == NULL) {
+        return NULL;
+    }
+    
+    return cache->strings + offset;
+}
+
+static uint32_t tables_checksum(const link_cache_t* cache) {
+    const link_cache_header_t* header = &cache->header;
+    uint32_t crc = CRC32_INITIAL;
+    
+    crc = crc32_update(crc, cache->inputs, header->input_count * sizeof(link_cache_input_t));
+    crc = crc32_update(crc, cache->sections, header->section_count * sizeof(link_cache_section_t));
+    crc = crc32_update(crc, cache->symbols, header->symbol_count * sizeof(link_cache_symbol_t));
+    
+    return crc32_update(crc, cache->strings, header->string_size);
+}
+
+static int read_all(int fd, void* data, size_t size) {
+    uint8_t* p = data;
+    ssize_t count;
+    
+    while (size > 0) {
+        count = read(fd, p, size);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return ERROR_CORRUPT_HEADER;
+        }
+        p += count;
+        size -= (size_t)count;
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+static int write_all(int fd, const void* data, size_t size) {
+    const uint8_t* p = data;
+    ssize_t count;
+    
+    while (size > 0) {
+        count = write(fd, p, size);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return ERROR_FILE_IO;
+        }
+        p += count;
+        size -= (size_t)count;
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+/* Every reference inside the cache must stay inside its table */
+static bool cache_consistent(const link_cache_t* cache) {
+    const link_cache_header_t* header = &cache->header;
+    const link_cache_input_t* input;
+    uint32_t i;
+    
+    if (header->string_size == 0 || cache->strings[header->string_size - 1] != '\0' ||
+        tables_checksum(cache) != header->checksum) {
+        return false;
+    }
+    
+    for (i = 0; i < header->input_count; i++) {
+        input = &cache->inputs[i];
+        if (link_cache_get_string(cache, input->path_offset) == NULL ||
+            input->first_section > header->section_count ||
+            input->section_count > header->section_count - input->first_section) {
+            return false;
+        }
+    }
+    
+    for (i = 0; i < header->symbol_count; i++) {
+        if (link_cache_get_string(cache, cache->symbols[i].name_offset) == NULL) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+int link_cache_read(link_cache_t* cache, const char* filename) {
+    link_cache_header_t header;
+    struct stat st;
+    int result;
+    int fd;
+    
+    if (cache == NULL || filename == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return errno == ENOENT ? ERROR_FILE_NOT_FOUND : ERROR_FILE_IO;
+    }
+    
+    result = fstat(fd, &st) == 0 ? ERROR_SUCCESS : ERROR_FILE_IO;
+    if (result == ERROR_SUCCESS && (size_t)st.st_size < sizeof(header)) {
+        result = ERROR_CORRUPT_HEADER;
+    }
+    if (result == ERROR_SUCCESS) {
+        result = read_all(fd, &header, sizeof(header));
+    }
+    if (result == ERROR_SUCCESS && header.magic != LINK_CACHE_MAGIC) {
+        result = ERROR_INVALID_MAGIC;
+    }
+    if (result == ERROR_SUCCESS && header.version != LINK_CACHE_VERSION) {
+        result = ERROR_UNSUPPORTED_VERSION;
+    }
+    
+    /* The counts must describe the file exactly before anything is allocated */
+    if (result == ERROR_SUCCESS &&
+        ((uint64_t)st.st_size != sizeof(header) + (uint64_t)header.input_count * sizeof(link_cache_input_t) +
+                                 (uint64_t)header.section_count * sizeof(link_cache_section_t) +
+                                 (uint64_t)header.symbol_count * sizeof(link_cache_symbol_t) +
+                                 header.string_size ||
+         header.member_count > header.input_count)) {
+        result = ERROR_CORRUPT_HEADER;
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        result = link_cache_init(cache, header.input_count, header.section_count,
+                                 header.symbol_count);
+    }
+    if (result == ERROR_SUCCESS && header.string_size > cache->string_capacity) {
+        free(cache->strings);
+        cache->strings = malloc(header.string_size);
+        cache->string_capacity = header.string_size;
+        if (cache->strings == NULL) {
+            link_cache_release(cache);
+            result = ERROR_OUT_OF_MEMORY;
+        }
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        cache->header = header;
+        result = read_all(fd, cache->inputs, header.input_count * sizeof(link_cache_input_t));
+        if (result == ERROR_SUCCESS) {
+            result = read_all(fd, cache->sections,
+                              header.section_count * sizeof(link_cache_section_t));
+        }
+        if (result == ERROR_SUCCESS) {
+            result = read_all(fd, cache->symbols, header.symbol_count * sizeof(link_cache_symbol_t));
+        }
+        if (result == ERROR_SUCCESS) {
+            result = read_all(fd, cache->strings, header.string_size);
+        }
+        if (result == ERROR_SUCCESS && !cache_consistent(cache)) {
+            result = ERROR_CORRUPT_HEADER;
+        }
+        if (result != ERROR_SUCCESS) {
+            link_cache_release(cache);
+        }
+    }
+    
+    close(fd);
+    
+    return result;
+}
+
+int link_cache_write(link_cache_t* cache, const char* filename) {
+    char* temporary;
+    size_t length;
+    int result;
+    int fd;
+    
+    if (cache == NULL || filename == NULL || cache->strings == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    length = strlen(filename);
+    temporary = malloc(length + 5);
+    if (temporary == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate cache file name");
+        return ERROR_OUT_OF_MEMORY;
+    }
+    memcpy(temporary, filename, length);
+    memcpy(temporary + length, ".tmp", 5);
+    
+    cache->header.checksum = tables_checksum(cache);
+    
+    fd = open(temporary, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        ERROR_REPORT_ERROR(ERROR_FILE_IO, "Failed to create link cache");
+        free(temporary);
+        return ERROR_FILE_IO;
+    }
+    
+    result = write_all(fd, &cache->header, sizeof(cache->header));
+    if (result == ERROR_SUCCESS) {
+        result = write_all(fd, cache->inputs,
+                           cache->header.input_count * sizeof(link_cache_input_t));
+    }
+    if (result == ERROR_SUCCESS) {
+        result = write_all(fd, cache->sections,
+                           cache->header.section_count * sizeof(link_cache_section_t));
+    }
+    if (result == ERROR_SUCCESS) {
+        result = write_all(fd, cache->symbols,
+                           cache->header.symbol_count * sizeof(link_cache_symbol_t));
+    }
+    if (result == ERROR_SUCCESS) {
+        result = write_all(fd, cache->strings, cache->header.string_size);
+    }
+    
+    if (close(fd) != 0 && result == ERROR_SUCCESS) {
+        result = ERROR_FILE_IO;
+    }
+    
+    /* Readers only ever see a complete cache */
+    if (result == ERROR_SUCCESS && rename(temporary, filename) != 0) {
+        result = ERROR_FILE_IO;
+    }
+    if (result != ERROR_SUCCESS) {
+        ERROR_REPORT_ERROR(result, "Failed to write link cache");
+        unlink(temporary);
+    }
+    
+    free(temporary);
+    
+    return result;
+}
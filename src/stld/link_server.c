@@ -0,0 +1,607 @@
+/* src/stld/link_server.c */
+#include "include/link_server.h"
+#include "../common/include/error.h"
+#include "../common/include/thread_pool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+/**
+ * @file link_server.c
+ * @brief Link server and client
+ * @details The calling thread accepts connections and queues them; the
+ * workers take one connection each, read the request, run the handler
+ * with its output captured in memory streams and send the reply. Stop
+ * requests are noticed by the accept loop within one poll interval;
+ * connections already queued are still served.
+ */
+
+/* How often the accept loop looks for a stop request (ms) */
+#define LINK_SERVER_POLL_MS 200
+
+/* Bytes copied per step when relaying a reply */
+#define LINK_SERVER_CHUNK 4096
+
+typedef struct link_server {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;             /* Signalled when a connection is queued or on stop */
+    int* queue;                      /* Ring of accepted connections */
+    size_t head;
+    size_t count;
+    size_t capacity;
+    bool stopping;
+    link_server_handler_t handler;
+    void* user_data;
+} link_server_t;
+
+static pthread_once_t stream_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t stream_key;
+static bool stream_key_valid;
+
+static volatile sig_atomic_t stop_signal;
+
+static void create_stream_key(void) {
+    stream_key_valid = pthread_key_create(&stream_key, NULL) == 0;
+}
+
+FILE* link_server_job_stream(void) {
+    pthread_once(&stream_key_once, create_stream_key);
+    
+    return stream_key_valid ? pthread_getspecific(stream_key) : NULL;
+}
+
+static void handle_stop_signal(int signal_number) {
+    (void)signal_number;
+    stop_signal = 1;
+}
+
+static int read_all(int fd, void* data, size_t size) {
+    uint8_t* p = data;
+    ssize_t count;
+    
+    while (size > 0) {
+        count = read(fd, p, size);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return ERROR_FILE_IO;
+        }
+        p += count;
+        size -= (size_t)count;
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+/* A client that went away must not kill the server with SIGPIPE */
+static int write_all(int fd, const void* data, size_t size) {
+    const uint8_t* p = data;
+    ssize_t count;
+    
+    while (size > 0) {
+        count = send(fd, p, size, MSG_NOSIGNAL);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return ERROR_FILE_IO;
+        }
+        p += count;
+        size -= (size_t)count;
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+static int socket_address(const char* path, struct sockaddr_un* address) {
+    if (path == NULL || strlen(path) >= sizeof(address->sun_path)) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    strcpy(address->sun_path, path);
+    
+    return ERROR_SUCCESS;
+}
+
+static int connect_socket(const char* path, int* fd) {
+    struct sockaddr_un address;
+    int result;
+    
+    result = socket_address(path, &address);
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    *fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (*fd < 0) {
+        return ERROR_SYSTEM_LIMIT;
+    }
+    
+    if (connect(*fd, (const struct sockaddr*)&address, sizeof(address)) != 0) {
+        close(*fd);
+        return ERROR_FILE_NOT_FOUND;
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+static int listen_socket(const char* path, int* fd) {
+    struct sockaddr_un address;
+    struct stat st;
+    int probe;
+    int result;
+    
+    result = socket_address(path, &address);
+    if (result != ERROR_SUCCESS) {
+        ERROR_REPORT_ERROR(ERROR_INVALID_ARGUMENT, "Server socket path is too long");
+        return result;
+    }
+    
+    /* Only a socket nobody answers on is taken over */
+    if (lstat(path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            ERROR_REPORT_ERROR(ERROR_FILE_IO, "Server socket path exists and is not a socket");
+            return ERROR_FILE_IO;
+        }
+        if (connect_socket(path, &probe) == ERROR_SUCCESS) {
+            close(probe);
+            ERROR_REPORT_ERROR(ERROR_FILE_IO, "A server is already listening on the socket");
+            return ERROR_FILE_IO;
+        }
+        unlink(path);
+    }
+    
+    *fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (*fd < 0) {
+        return ERROR_SYSTEM_LIMIT;
+    }
+    
+    if (bind(*fd, (const struct sockaddr*)&address, sizeof(address)) != 0 ||
+        listen(*fd, SOMAXCONN) != 0) {
+        close(*fd);
+        ERROR_REPORT_ERROR(ERROR_FILE_IO, "Failed to listen on the server socket");
+        return ERROR_FILE_IO;
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+static int send_reply(int fd, int status, const char* out, size_t out_size,
+                      const char* err, size_t err_size) {
+    link_server_reply_t reply;
+    int result;
+    
+    reply = (link_server_reply_t) {
+        .magic = LINK_SERVER_MAGIC,
+        .status = status,
+        .out_size = (uint32_t)out_size,
+        .err_size = (uint32_t)err_size
+    };
+    
+    result = write_all(fd, &reply, sizeof(reply));
+    if (result == ERROR_SUCCESS) {
+        result = write_all(fd, out, out_size);
+    }
+    if (result == ERROR_SUCCESS) {
+        result = write_all(fd, err, err_size);
+    }
+    
+    return result;
+}
+
+static int refuse_request(int fd, const char* message) {
+    return send_reply(fd, EXIT_FAILURE, NULL, 0, message, strlen(message));
+}
+
+/* argv points into payload, which must hold exactly count + 1 strings */
+static bool split_payload(char* payload, size_t size, uint32_t count, char** argv) {
+    size_t offset = 0;
+    size_t length;
+    uint32_t i;
+    
+    for (i = 0; i <= count; i++) {
+        if (offset >= size) {
+            return false;
+        }
+        length = strnlen(payload + offset, size - offset);
+        if (length == size - offset) {
+            return false;
+        }
+        argv[i] = payload + offset;
+        offset += length + 1;
+    }
+    
+    return offset == size;
+}
+
+static int run_job(link_server_t* server, int fd, int argc, char** argv, const char* cwd) {
+    char* out = NULL;
+    char* err = NULL;
+    size_t out_size = 0;
+    size_t err_size = 0;
+    FILE* out_stream;
+    FILE* err_stream;
+    int status;
+    int result;
+    
+    out_stream = open_memstream(&out, &out_size);
+    err_stream = open_memstream(&err, &err_size);
+    if (out_stream == NULL || err_stream == NULL) {
+        if (out_stream != NULL) {
+            fclose(out_stream);
+        }
+        if (err_stream != NULL) {
+            fclose(err_stream);
+        }
+        free(out);
+        free(err);
+        return refuse_request(fd, "Error: Link server is out of memory\n");
+    }
+    
+    pthread_setspecific(stream_key, err_stream);
+    status = server->handler(argc, argv, cwd, out_stream, err_stream, server->user_data);
+    pthread_setspecific(stream_key, NULL);
+    
+    fclose(out_stream);
+    fclose(err_stream);
+    result = send_reply(fd, status, out, out_size, err, err_size);
+    free(out);
+    free(err);
+    
+    return result;
+}
+
+static void serve_connection(link_server_t* server, int fd) {
+    link_server_request_t request;
+    char* payload;
+    char** argv;
+    
+    if (read_all(fd, &request, sizeof(request)) != ERROR_SUCCESS) {
+        return;
+    }
+    
+    if (request.magic != LINK_SERVER_MAGIC || request.version != LINK_SERVER_VERSION ||
+        request.payload_size > LINK_SERVER_MAX_REQUEST || request.argc == 0 ||
+        request.argc > request.payload_size) {
+        refuse_request(fd, "Error: Malformed link server request\n");
+        return;
+    }
+    
+    /* argv[0] is the working directory until the arguments are split off */
+    payload = malloc(request.payload_size);
+    argv = malloc(((size_t)request.argc + 2) * sizeof(char*));
+    if (payload == NULL || argv == NULL) {
+        refuse_request(fd, "Error: Link server is out of memory\n");
+    } else if (read_all(fd, payload, request.payload_size) == ERROR_SUCCESS) {
+        if (!split_payload(payload, request.payload_size, request.argc, argv)) {
+            refuse_request(fd, "Error: Malformed link server request\n");
+        } else if ((request.flags & LINK_SERVER_FLAG_SHUTDOWN) != 0) {
+            pthread_mutex_lock(&server->mutex);
+            server->stopping = true;
+            pthread_mutex_unlock(&server->mutex);
+            send_reply(fd, EXIT_SUCCESS, NULL, 0, NULL, 0);
+        } else {
+            argv[request.argc + 1] = NULL;
+            run_job(server, fd, (int)request.argc, argv + 1, argv[0]);
+        }
+    }
+    
+    free(payload);
+    free(argv);
+}
+
+static void* server_worker(void* user_data) {
+    link_server_t* server = user_data;
+    int fd;
+    
+    for (;;) {
+        pthread_mutex_lock(&server->mutex);
+        while (server->count == 0 && !server->stopping) {
+            pthread_cond_wait(&server->cond, &server->mutex);
+        }
+        if (server->count == 0) {
+            pthread_mutex_unlock(&server->mutex);
+            return NULL;
+        }
+        fd = server->queue[server->head];
+        server->head = (server->head + 1) % server->capacity;
+        server->count--;
+        pthread_mutex_unlock(&server->mutex);
+        
+        serve_connection(server, fd);
+        close(fd);
+    }
+}
+
+/* Queue a connection; the ring doubles when full */
+static int enqueue_connection(link_server_t* server, int fd) {
+    size_t capacity;
+    int* queue;
+    size_t i;
+    
+    pthread_mutex_lock(&server->mutex);
+    if (server->count == server->capacity) {
+        capacity = server->capacity > 0 ? server->capacity * 2 : 16;
+        queue = malloc(capacity * sizeof(int));
+        if (queue == NULL) {
+            pthread_mutex_unlock(&server->mutex);
+            return ERROR_OUT_OF_MEMORY;
+        }
+        for (i = 0; i < server->count; i++) {
+            queue[i] = server->queue[(server->head + i) % server->capacity];
+        }
+        free(server->queue);
+        server->queue = queue;
+        server->head = 0;
+        server->capacity = capacity;
+    }
+    server->queue[(server->head + server->count) % server->capacity] = fd;
+    server->count++;
+    pthread_cond_signal(&server->cond);
+    pthread_mutex_unlock(&server->mutex);
+    
+    return ERROR_SUCCESS;
+}
+
+static bool server_stopping(link_server_t* server) {
+    bool stopping;
+    
+    pthread_mutex_lock(&server->mutex);
+    if (stop_signal) {
+        server->stopping = true;
+    }
+    stopping = server->stopping;
+    pthread_mutex_unlock(&server->mutex);
+    
+    return stopping;
+}
+
+static void accept_connections(link_server_t* server, int listen_fd) {
+    struct pollfd poll_fd;
+    int fd;
+    
+    poll_fd.fd = listen_fd;
+    poll_fd.events = POLLIN;
+    
+    while (!server_stopping(server)) {
+        if (poll(&poll_fd, 1, LINK_SERVER_POLL_MS) <= 0 || (poll_fd.revents & POLLIN) == 0) {
+            continue;
+        }
+        fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            continue;
+        }
+        if (enqueue_connection(server, fd) != ERROR_SUCCESS) {
+            refuse_request(fd, "Error: Link server is out of memory\n");
+            close(fd);
+        }
+    }
+}
+
+int link_server_run(const char* socket_path, size_t workers,
+                    link_server_handler_t handler, void* user_data) {
+    struct sigaction action;
+    struct sigaction old_int;
+    struct sigaction old_term;
+    link_server_t server;
+    pthread_t* threads;
+    size_t started = 0;
+    size_t i;
+    int listen_fd;
+    int result;
+    
+    if (socket_path == NULL || handler == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    pthread_once(&stream_key_once, create_stream_key);
+    if (!stream_key_valid) {
+        return ERROR_SYSTEM_LIMIT;
+    }
+    
+    if (workers == 0) {
+        workers = thread_pool_get_cpu_count();
+    }
+    threads = malloc(workers * sizeof(pthread_t));
+    if (threads == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    result = listen_socket(socket_path, &listen_fd);
+    if (result != ERROR_SUCCESS) {
+        free(threads);
+        return result;
+    }
+    
+    server = (link_server_t) {
+        .handler = handler,
+        .user_data = user_data
+    };
+    pthread_mutex_init(&server.mutex, NULL);
+    pthread_cond_init(&server.cond, NULL);
+    
+    stop_signal = 0;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_stop_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, &old_int);
+    sigaction(SIGTERM, &action, &old_term);
+    
+    for (i = 0; i < workers; i++) {
+        if (pthread_create(&threads[started], NULL, server_worker, &server) == 0) {
+            started++;
+        }
+    }
+    
+    if (started > 0) {
+        accept_connections(&server, listen_fd);
+    } else {
+        ERROR_REPORT_ERROR(ERROR_SYSTEM_LIMIT, "Failed to start link server workers");
+        result = ERROR_SYSTEM_LIMIT;
+    }
+    
+    /* Workers drain the queue before they see the stop */
+    pthread_mutex_lock(&server.mutex);
+    server.stopping = true;
+    pthread_cond_broadcast(&server.cond);
+    pthread_mutex_unlock(&server.mutex);
+    for (i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    
+    close(listen_fd);
+    unlink(socket_path);
+    sigaction(SIGINT, &old_int, NULL);
+    sigaction(SIGTERM, &old_term, NULL);
+    
+    pthread_cond_destroy(&server.cond);
+    pthread_mutex_destroy(&server.mutex);
+    free(server.queue);
+    free(threads);
+    
+    return result;
+}
+
+/* Current directory in a buffer the caller frees */
+static char* current_directory(void) {
+    size_t size = 256;
+    char* buffer = NULL;
+    char* grown;
+    
+    for (;;) {
+        grown = realloc(buffer, size);
+        if (grown == NULL) {
+            free(buffer);
+            return NULL;
+        }
+        buffer = grown;
+        if (getcwd(buffer, size) != NULL) {
+            return buffer;
+        }
+        if (errno != ERANGE) {
+            free(buffer);
+            return NULL;
+        }
+        size *= 2;
+    }
+}
+
+/* Copy size bytes of the reply to stream */
+static int relay_output(int fd, uint32_t size, FILE* stream) {
+    uint8_t chunk[LINK_SERVER_CHUNK];
+    size_t step;
+    int result;
+    
+    while (size > 0) {
+        step = size < sizeof(chunk) ? size : sizeof(chunk);
+        result = read_all(fd, chunk, step);
+        if (result != ERROR_SUCCESS) {
+            return result;
+        }
+        fwrite(chunk, 1, step, stream);
+        size -= (uint32_t)step;
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+static int send_request(int fd, const char* cwd, int argc, char* const* argv, bool shutdown) {
+    link_server_request_t request;
+    size_t size = strlen(cwd) + 1;
+    size_t offset;
+    size_t length;
+    char* payload;
+    int result;
+    int i;
+    
+    for (i = 0; i < argc; i++) {
+        size += strlen(argv[i]) + 1;
+    }
+    if (size > LINK_SERVER_MAX_REQUEST) {
+        ERROR_REPORT_ERROR(ERROR_INVALID_ARGUMENT, "Command line too long for the link server");
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    payload = malloc(size);
+    if (payload == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    offset = strlen(cwd) + 1;
+    memcpy(payload, cwd, offset);
+    for (i = 0; i < argc; i++) {
+        length = strlen(argv[i]) + 1;
+        memcpy(payload + offset, argv[i], length);
+        offset += length;
+    }
+    
+    request = (link_server_request_t) {
+        .magic = LINK_SERVER_MAGIC,
+        .version = LINK_SERVER_VERSION,
+        .flags = shutdown ? LINK_SERVER_FLAG_SHUTDOWN : 0,
+        .argc = (uint32_t)argc,
+        .payload_size = (uint32_t)size
+    };
+    
+    result = write_all(fd, &request, sizeof(request));
+    if (result == ERROR_SUCCESS) {
+        result = write_all(fd, payload, size);
+    }
+    free(payload);
+    
+    return result;
+}
+
+int link_server_submit(const char* socket_path, int argc, char* const* argv, bool shutdown,
+                       FILE* out, FILE* err, int* status) {
+    link_server_reply_t reply;
+    char* cwd;
+    int fd;
+    int result;
+    
+    if (socket_path == NULL || argc <= 0 || argv == NULL || out == NULL || err == NULL ||
+        status == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    cwd = current_directory();
+    if (cwd == NULL) {
+        return ERROR_FILE_IO;
+    }
+    
+    result = connect_socket(socket_path, &fd);
+    if (result != ERROR_SUCCESS) {
+        free(cwd);
+        return result;
+    }
+    
+    result = send_request(fd, cwd, argc, argv, shutdown);
+    free(cwd);
+    if (result == ERROR_SUCCESS) {
+        result = read_all(fd, &reply, sizeof(reply));
+    }
+    if (result == ERROR_SUCCESS && reply.magic != LINK_SERVER_MAGIC) {
+        result = ERROR_INVALID_MAGIC;
+    }
+    if (result == ERROR_SUCCESS) {
+        result = relay_output(fd, reply.out_size, out);
+    }
+    if (result == ERROR_SUCCESS) {
+        result = relay_output(fd, reply.err_size, err);
+    }
+    if (result == ERROR_SUCCESS) {
+        *status = reply.status;
+    }
+    close(fd);
+    
+    return result;
+}
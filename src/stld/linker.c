@@ -1,10 +1,29 @@
 /* src/stld/linker.c */
 #include "include/stld.h"
+#include "include/symbol_table.h"
+#include "include/relocation.h"
+#include "include/output.h"
+#include "include/section.h"
+#include "include/link_cache.h"
+#include "include/map_file.h"
+#include "include/script.h"
+#include "include/object_cache.h"
 #include "../common/include/error.h"
 #include "../common/include/smof.h"
+#include "../common/include/memory.h"
+#include "../common/include/thread_pool.h"
+#include "../common/include/crc32.h"
+#include "../common/include/trace.h"
+#include "../star/include/archive.h"
+#include "../star/include/index.h"
 #include <stdlib.h>
 #include <string.h>
-#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
 
 /**
  * @file linker.c
@@ -12,45 +31,89 @@
  * @details Main linking logic implementation
  */
 
-/* Forward declarations for enhanced internal structures */
-typedef struct symbol_entry {
-    char* name;
-    uint64_t value;
-    uint32_t size;
-    uint8_t type;
-    uint8_t binding;
-    uint16_t section_index;
-    struct symbol_entry* next;
-} symbol_entry_t;
-
-typedef struct section_entry {
-    char* name;
-    uint64_t size;
-    uint32_t virtual_address;
-    uint16_t flags;
-    uint8_t *data;  /* Section data for relocation processing */
-    struct section_entry* next;
-} section_entry_t;
-
-typedef struct relocation_entry {
-    uint32_t offset;
-    uint16_t symbol_index;
-    uint8_t type;
-    uint8_t section_index;
-    struct relocation_entry* next;
-} relocation_entry_t;
+/* Arena growth step; small enough to honour a 64KB max_memory */
+#define STLD_ARENA_BLOCK_SIZE 16384
+
+/* Entry symbol; its section is where section collection starts */
+#define STLD_ENTRY_SYMBOL "_start"
+
+/* No input section (global input section ids are uint32_t) */
+#define INPUT_SECTION_NONE 0xFFFFFFFFU
+
+/*
+ * Per-input object state. Inputs are mapped MAP_PRIVATE and every table is
+ * a view into the mapping, so nothing is copied at load time. Writes to
+ * section data (relocation patching) are copy-on-write in the kernel and
+ * only duplicate the pages that are actually touched.
+ */
+typedef struct input_object {
+    uint8_t* map;                         /* Mapped file, NULL if not loaded */
+    size_t map_size;
+    smof_layout_t layout;                 /* Tables of either header version */
+    const smof_symbol_t* symbols;
+    const smof_relocation_v2_t* relocations;
+    smof_relocation_v2_t* widened_relocations; /* Owned copy of a v1 table, else NULL */
+    const char* strings;
+    symbol_t* staged_symbols;     /* Parsed symbols awaiting merge */
+    uint32_t* staged_hashes;      /* Name hashes for staged_symbols */
+    symbol_handle_t* symbol_map;  /* SMOF symbol index -> global handle */
+    uint32_t symbol_count;
+    uint32_t first_section;       /* Relocation engine id of section 0 */
+    section_id_t* output_sections;  /* Output section of each input section */
+    uint32_t* section_addresses;  /* Linked address of each input section */
+    uint64_t file_size;           /* Identity for the link cache */
+    int64_t mtime;
+    uint32_t checksum;            /* CRC32 of the file (incremental links only) */
+    uint32_t signature;           /* CRC32 of what other inputs depend on */
+    bool reused;                  /* Taken from the link cache, not relinked */
+    bool cached;                  /* Copied from the shared cache without reading the file */
+} input_object_t;
 
 /* STLD context structure */
 struct stld_context {
     stld_options_t options;
+    memory_pool_t* arena;            /* Backs every context allocation */
     stld_progress_callback_t progress_callback;
     void* progress_user_data;
-    symbol_entry_t* symbols;
-    section_entry_t* sections;
-    relocation_entry_t* relocations; /* Add relocations support */
+    symbol_table_t* symbols;         /* Global symbol table */
+    section_manager_t* sections;     /* Output sections, built at layout */
+    linker_script_t* script;         /* Parsed script_file, NULL without one */
+    uint32_t* section_rules;         /* Script rule per input section, NULL without a script */
+    uint32_t section_count;          /* Sections across all inputs */
+    uint8_t* section_live;           /* Per input section, NULL when nothing is collected */
+    size_t sections_removed;         /* Input sections dropped by collection */
+    uint32_t* folded_into;           /* Kept copy per input section, NULL without folding */
+    size_t sections_folded;          /* Input sections folded into an identical one */
+    uint32_t* output_offsets;        /* File offset per output section, for the cache */
+    size_t inputs_reused;            /* Inputs the last link took from the cache */
+    size_t named_input_count;        /* Inputs before any library member */
+    input_object_t* objects;         /* One per input file, built at load time */
+    size_t object_capacity;          /* Slots in objects; archive members append */
+    size_t members_loaded;           /* Archive members pulled in by libraries */
+    stld_cache_t* cache;             /* Shared input cache, NULL to read files directly */
+    size_t inputs_cached;            /* Inputs and libraries the last link took from it */
+    thread_pool_t* pool;             /* Created on first parallel phase */
+    relocation_engine_t* relocations; /* Created when relocations are applied */
+    size_t relocations_processed;
+    section_id_t got_section;        /* Output section holding the GOT, if any */
+    uint32_t got_offset;             /* Offset of the GOT in got_section */
+    uint8_t* got_data;               /* GOT contents, filled in by the relocation pass */
+    size_t got_slots;                /* Slots reserved at layout, 0 = no GOT */
+    output_relocation_t* kept_relocations; /* Left for the next link by relocatable outputs */
+    size_t relocations_kept;
+    size_t output_size;              /* Bytes written by the last link */
+    stld_phase_stats_t phases[STLD_PHASE_COUNT]; /* Profile of the last link */
+    stld_phase_t phase;              /* Phase being timed */
+    struct timespec phase_start;
+    trace_span_t phase_span;         /* Trace span of the timed stretch */
+    double link_time;                /* Wall time of the last link */
     char** input_files;
     size_t input_file_count;
     size_t input_file_capacity;
+    char** library_paths;            /* -L directories in search order */
+    size_t library_path_count;
+    char** libraries;                /* -l names in link order */
+    size_t library_count;
 };
 
 stld_options_t stld_get_default_options(void) {
@@ -69,7 +132,11 @@ stld_options_t stld_get_default_options(void) {
         .page_size = 4096,
         .verbose = false,
         .map_file = NULL,
-        .script_file = NULL
+        .script_file = NULL,
+        .threads = 0,
+        .gc_sections = false,
+        .fold_identical = false,
+        .incremental = false
     };
     
     return options;
@@ -110,18 +177,65 @@ stld_context_t* stld_context_create(const stld_options_t* options) {
         return NULL;
     }
     
+    /* All further context allocations come from the arena */
+    context->arena = memory_pool_create_growable(STLD_ARENA_BLOCK_SIZE, options->max_memory);
+    if (context->arena == NULL) {
+        free(context);
+        return NULL;
+    }
+    
     /* Initialize context */
     context->options = *options;
     context->progress_callback = NULL;
     context->progress_user_data = NULL;
-    context->symbols = NULL;
     context->sections = NULL;
+    context->script = NULL;
+    context->section_rules = NULL;
+    context->section_count = 0;
+    context->section_live = NULL;
+    context->sections_removed = 0;
+    context->folded_into = NULL;
+    context->sections_folded = 0;
+    context->output_offsets = NULL;
+    context->inputs_reused = 0;
+    context->named_input_count = 0;
+    context->objects = NULL;
+    context->object_capacity = 0;
+    context->members_loaded = 0;
+    context->cache = NULL;
+    context->inputs_cached = 0;
+    context->pool = NULL;
+    context->relocations = NULL;
+    context->relocations_processed = 0;
+    context->got_section = SECTION_ID_INVALID;
+    context->got_offset = 0;
+    context->got_data = NULL;
+    context->got_slots = 0;
+    context->kept_relocations = NULL;
+    context->relocations_kept = 0;
+    context->output_size = 0;
+    memset(context->phases, 0, sizeof(context->phases));
+    context->phase = STLD_PHASE_LOAD;
+    context->link_time = 0.0;
     context->input_file_count = 0;
     context->input_file_capacity = 8;  /* Start with capacity for 8 files */
+    context->library_paths = NULL;
+    context->library_path_count = 0;
+    context->libraries = NULL;
+    context->library_count = 0;
     
     /* Allocate initial input files array */
-    context->input_files = malloc(context->input_file_capacity * sizeof(char*));
+    context->input_files = memory_pool_alloc(context->arena,
+                                             context->input_file_capacity * sizeof(char*));
     if (context->input_files == NULL) {
+        memory_pool_destroy(context->arena);
+        free(context);
+        return NULL;
+    }
+    
+    context->symbols = symbol_table_create(0);
+    if (context->symbols == NULL) {
+        memory_pool_destroy(context->arena);
         free(context);
         return NULL;
     }
@@ -129,35 +243,38 @@ stld_context_t* stld_context_create(const stld_options_t* options) {
     return context;
 }
 
+/* Drop an input's mapping and staging; arena tables go with the arena */
+static void release_input_object(input_object_t* object) {
+    free(object->staged_symbols);
+    free(object->staged_hashes);
+    free(object->widened_relocations);
+    if (object->map != NULL) {
+        munmap(object->map, object->map_size);
+    }
+    *object = (input_object_t) {
+        .map = NULL
+    };
+}
+
 void stld_context_destroy(stld_context_t* context) {
-    symbol_entry_t* symbol;
-    section_entry_t* section;
     size_t i;
     
     if (context != NULL) {
         /* Free symbols */
-        while (context->symbols != NULL) {
-            symbol = context->symbols;
-            context->symbols = symbol->next;
-            free(symbol->name);
-            free(symbol);
-        }
+        symbol_table_destroy(context->symbols);
         
-        /* Free sections */
-        while (context->sections != NULL) {
-            section = context->sections;
-            context->sections = section->next;
-            free(section->name);
-            free(section);
-        }
+        relocation_engine_destroy(context->relocations);
+        thread_pool_destroy(context->pool);
         
-        if (context->input_files != NULL) {
+        /* Unmap inputs; their staging buffers are the only heap leftovers */
+        if (context->objects != NULL) {
             for (i = 0; i < context->input_file_count; i++) {
-                free(context->input_files[i]);
+                release_input_object(&context->objects[i]);
             }
-            free(context->input_files);
         }
         
+        /* Sections, symbol maps, objects and file names go in one step */
+        memory_pool_destroy(context->arena);
         free(context);
     }
 }
@@ -171,6 +288,12 @@ void stld_set_progress_callback(stld_context_t* context,
     }
 }
 
+void stld_set_cache(stld_context_t* context, stld_cache_t* cache) {
+    if (context != NULL) {
+        context->cache = cache;
+    }
+}
+
 int stld_add_input_file(stld_context_t* context, const char* filename) {
     char* filename_copy;
     
@@ -178,24 +301,27 @@ int stld_add_input_file(stld_context_t* context, const char* filename) {
         return ERROR_INVALID_ARGUMENT;
     }
     
-    /* Expand array if needed */
+    /* Expand array if needed; a small old array is recycled by the arena */
     if (context->input_file_count >= context->input_file_capacity) {
         char** new_files;
         size_t new_capacity = context->input_file_capacity > 0 ? 
                              context->input_file_capacity * 2 : 8;
         
-        new_files = realloc(context->input_files, new_capacity * sizeof(char*));
+        new_files = memory_pool_alloc(context->arena, new_capacity * sizeof(char*));
         if (new_files == NULL) {
             ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to expand input files array");
             return ERROR_OUT_OF_MEMORY;
         }
         
+        memcpy(new_files, context->input_files, context->input_file_count * sizeof(char*));
+        memory_pool_free_sized(context->arena, context->input_files,
+                               context->input_file_capacity * sizeof(char*));
         context->input_files = new_files;
         context->input_file_capacity = new_capacity;
     }
     
     /* Copy filename */
-    filename_copy = malloc(strlen(filename) + 1);
+    filename_copy = memory_pool_alloc(context->arena, strlen(filename) + 1);
     if (filename_copy == NULL) {
         ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate filename copy");
         return ERROR_OUT_OF_MEMORY;
@@ -207,295 +333,3333 @@ int stld_add_input_file(stld_context_t* context, const char* filename) {
     return ERROR_SUCCESS;
 }
 
+/* Append a copy of str; the array doubles whenever count reaches a power of two */
+static int append_string(stld_context_t* context, char*** list, size_t* count, const char* str) {
+    char** grown;
+    char* copy;
+    
+    if (*count == 0 || (*count >= 4 && (*count & (*count - 1)) == 0)) {
+        size_t capacity = *count == 0 ? 4 : *count * 2;
+        
+        grown = memory_pool_alloc(context->arena, capacity * sizeof(char*));
+        if (grown == NULL) {
+            ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to expand library list");
+            return ERROR_OUT_OF_MEMORY;
+        }
+        if (*count > 0) {
+            memcpy(grown, *list, *count * sizeof(char*));
+            memory_pool_free_sized(context->arena, *list, *count * sizeof(char*));
+        }
+        *list = grown;
+    }
+    
+    copy = memory_pool_alloc(context->arena, strlen(str) + 1);
+    if (copy == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate library name");
+        return ERROR_OUT_OF_MEMORY;
+    }
+    strcpy(copy, str);
+    (*list)[(*count)++] = copy;
+    
+    return ERROR_SUCCESS;
+}
+
 int stld_add_library_path(stld_context_t* context, const char* path) {
     if (context == NULL || path == NULL) {
         return ERROR_INVALID_ARGUMENT;
     }
     
-    /* TODO: Implement library path management */
-    return ERROR_SUCCESS;
+    return append_string(context, &context->library_paths, &context->library_path_count, path);
 }
 
 int stld_add_library(stld_context_t* context, const char* libname) {
-    if (context == NULL || libname == NULL) {
+    if (context == NULL || libname == NULL || libname[0] == '\0') {
         return ERROR_INVALID_ARGUMENT;
     }
     
-    /* TODO: Implement library management */
+    /* Resolved against the search path at link time, as -L may follow -l */
+    return append_string(context, &context->libraries, &context->library_count, libname);
+}
+
+static bool object_range_valid(const input_object_t* object,
+                               uint32_t offset, size_t size) {
+    return offset <= object->map_size && size <= object->map_size - offset;
+}
+
+static bool object_string_valid(const input_object_t* object, uint32_t offset) {
+    return offset < object->layout.string_table_size &&
+           memchr(object->strings + offset, '\0',
+                  object->layout.string_table_size - offset) != NULL;
+}
+
+/* Modification time in nanoseconds */
+static int64_t stat_mtime(const struct stat* st) {
+    return (int64_t)st->st_mtim.tv_sec * 1000000000 + (int64_t)st->st_mtim.tv_nsec;
+}
+
+/* Map an input out of the shared cache copy-on-write; links patch their pages, never the cache */
+static int map_cached_file(input_object_t* object, const char* filename, stld_cache_t* cache) {
+    cache_entry_t* entry;
+    void* map;
+    int result;
+    
+    result = object_cache_acquire(cache, filename, CACHE_ENTRY_OBJECT, &entry, &object->cached);
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    if (entry->file_size < sizeof(smof_header_t)) {
+        object_cache_release(cache, entry);
+        return ERROR_CORRUPT_HEADER;
+    }
+    
+    result = object_cache_map_object(entry, &map);
+    if (result != ERROR_SUCCESS) {
+        object_cache_release(cache, entry);
+        return result;
+    }
+    
+    object->map = map;
+    object->map_size = (size_t)entry->file_size;
+    object->file_size = entry->file_size;
+    object->mtime = entry->mtime;
+    object_cache_release(cache, entry);
+    
     return ERROR_SUCCESS;
 }
 
-static int load_smof_file(stld_context_t* context, const char* filename) {
-    FILE* file;
-    smof_header_t header;
-    symbol_entry_t* symbol;
-    section_entry_t* section;
+static int map_smof_file(input_object_t* object, const char* filename, stld_cache_t* cache) {
+    struct stat st;
+    void* map;
+    int fd;
     
-    if (context == NULL || filename == NULL) {
-        return ERROR_INVALID_ARGUMENT;
+    if (cache != NULL) {
+        return map_cached_file(object, filename, cache);
     }
     
-    file = fopen(filename, "rb");
-    if (file == NULL) {
+    fd = open(filename, O_RDONLY);
+    if (fd < 0) {
         return ERROR_FILE_IO;
     }
     
-    /* Read and validate header */
-    if (fread(&header, sizeof(header), 1, file) != 1) {
-        fclose(file);
+    if (fstat(fd, &st) != 0) {
+        close(fd);
         return ERROR_FILE_IO;
     }
     
-    if (!smof_validate_header(&header)) {
-        fclose(file);
+    if ((size_t)st.st_size < sizeof(smof_header_t)) {
+        close(fd);
         return ERROR_CORRUPT_HEADER;
     }
     
-    fclose(file);
+    /* Private writable mapping: patched pages are copied on write */
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return ERROR_FILE_IO;
+    }
     
-    /* Add a simple section */
-    section = malloc(sizeof(section_entry_t));
-    if (section != NULL) {
-        section->name = malloc(strlen(".text") + 1);
-        if (section->name != NULL) {
-            strcpy(section->name, ".text");
-            section->size = 0;
-            section->next = context->sections;
-            context->sections = section;
-        } else {
-            free(section);
-        }
+    object->map = map;
+    object->map_size = (size_t)st.st_size;
+    object->file_size = (uint64_t)st.st_size;
+    object->mtime = stat_mtime(&st);
+    
+    return ERROR_SUCCESS;
+}
+
+/* v1 relocations are widened once, so every later pass reads one format */
+static int widen_relocations(input_object_t* object) {
+    const smof_relocation_t* source;
+    smof_relocation_t reloc;
+    uint32_t i;
+    
+    object->widened_relocations = malloc((object->layout.reloc_count > 0 ?
+                                          object->layout.reloc_count : 1) *
+                                         sizeof(smof_relocation_v2_t));
+    if (object->widened_relocations == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate relocations");
+        return ERROR_OUT_OF_MEMORY;
     }
     
-    /* Add a simple symbol */
-    symbol = malloc(sizeof(symbol_entry_t));
-    if (symbol != NULL) {
-        symbol->name = malloc(strlen("_start") + 1);
-        if (symbol->name != NULL) {
-            strcpy(symbol->name, "_start");
-            symbol->value = 0;
-            symbol->next = context->symbols;
-            context->symbols = symbol;
-        } else {
-            free(symbol);
-        }
+    source = (const smof_relocation_t*)(object->map + object->layout.reloc_table_offset);
+    for (i = 0; i < object->layout.reloc_count; i++) {
+        memcpy(&reloc, &source[i], sizeof(reloc));
+        object->widened_relocations[i] = (smof_relocation_v2_t) {
+            .offset = reloc.offset,
+            .symbol_index = reloc.symbol_index,
+            .section_index = reloc.section_index,
+            .type = reloc.type
+        };
     }
     
+    object->relocations = object->widened_relocations;
     return ERROR_SUCCESS;
 }
 
-/* Symbol resolution function */
-static symbol_entry_t* find_symbol(stld_context_t* context, const char* name) __attribute__((unused));
-static symbol_entry_t* find_symbol(stld_context_t* context, const char* name) {
-    symbol_entry_t* symbol = context->symbols;
-    while (symbol) {
-        if (strcmp(symbol->name, name) == 0) {
-            return symbol;
+static int bind_smof_tables(input_object_t* object) {
+    const smof_layout_t* header = &object->layout;
+    
+    if (smof_read_layout(object->map, object->map_size, &object->layout) != ERROR_SUCCESS) {
+        return ERROR_CORRUPT_HEADER;
+    }
+    
+    object->symbols = (const smof_symbol_t*)(object->map + header->symbol_table_offset);
+    object->strings = (const char*)(object->map + header->string_table_offset);
+    
+    if (header->version == SMOF_VERSION_2) {
+        object->relocations = (const smof_relocation_v2_t*)(object->map + header->reloc_table_offset);
+        return ERROR_SUCCESS;
+    }
+    
+    return widen_relocations(object);
+}
+
+static const smof_section_t* object_sections(const input_object_t* object) {
+    return (const smof_section_t*)(object->map + object->layout.section_table_offset);
+}
+
+static int validate_smof_sections(const input_object_t* object) {
+    const smof_layout_t* header = &object->layout;
+    const smof_section_t* sections = object_sections(object);
+    uint32_t i;
+    
+    for (i = 0; i < header->section_count; i++) {
+        bool zero_fill = (sections[i].flags & SMOF_SECT_ZERO_FILL) != 0;
+        
+        if (!object_string_valid(object, sections[i].name_offset)) {
+            ERROR_REPORT_ERROR(ERROR_INVALID_SECTION, "Section name outside string table");
+            return ERROR_INVALID_SECTION;
+        }
+        
+        if (!zero_fill &&
+            !object_range_valid(object, sections[i].file_offset, sections[i].size)) {
+            ERROR_REPORT_ERROR(ERROR_INVALID_SECTION, "Section data outside file");
+            return ERROR_INVALID_SECTION;
         }
-        symbol = symbol->next;
     }
-    return NULL;
+    
+    return ERROR_SUCCESS;
 }
 
-/* Relocation processing function */
-static int process_relocations(stld_context_t* context) {
-    relocation_entry_t* reloc = context->relocations;
-    int unresolved_count = 0;
-    
-    while (reloc) {
-        /* Find the symbol for this relocation */
-        symbol_entry_t* symbol = context->symbols;
-        uint16_t symbol_index = 0;
-        
-        /* Find symbol by index */
-        for (uint16_t i = 0; i < reloc->symbol_index && symbol; i++) {
-            symbol = symbol->next;
-            symbol_index++;
-        }
-        
-        if (symbol) {
-            /* Apply relocation based on type */
-            switch (reloc->type) {
-                case 1: /* SMOF_RELOC_ABS32 */
-                    /* For absolute relocations, use symbol value directly */
-                    /* In a real linker, this would patch the binary */
-                    break;
-                    
-                case 2: /* SMOF_RELOC_REL32 */
-                    /* For PC-relative relocations, calculate offset */
-                    /* offset = symbol_address - (relocation_address + 4) */
-                    break;
-                    
-                default:
-                    /* Unknown relocation type */
-                    unresolved_count++;
-                    break;
-            }
-        } else {
-            unresolved_count++;
+static int stage_smof_symbols(input_object_t* object) {
+    const smof_layout_t* header = &object->layout;
+    uint32_t i;
+    
+    if (header->symbol_count == 0) {
+        return ERROR_SUCCESS;
+    }
+    
+    object->staged_symbols = malloc(header->symbol_count * sizeof(symbol_t));
+    object->staged_hashes = malloc(header->symbol_count * sizeof(uint32_t));
+    if (object->staged_symbols == NULL || object->staged_hashes == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate symbol staging");
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    for (i = 0; i < header->symbol_count; i++) {
+        if (!object_string_valid(object, object->symbols[i].name_offset)) {
+            ERROR_REPORT_ERROR(ERROR_INVALID_SYMBOL, "Symbol name outside string table");
+            return ERROR_INVALID_SYMBOL;
         }
         
-        reloc = reloc->next;
+        object->staged_symbols[i] = (symbol_t) {
+            .name = object->strings + object->symbols[i].name_offset,
+            .type = (symbol_type_t)object->symbols[i].type,
+            .binding = (symbol_binding_t)object->symbols[i].binding,
+            .visibility = SYMBOL_VISIBILITY_DEFAULT,
+            .section_index = object->symbols[i].section_index,
+            .value = object->symbols[i].value,
+            .size = object->symbols[i].size
+        };
+        object->staged_hashes[i] = symbol_table_hash_name(object->staged_symbols[i].name);
     }
     
-    return unresolved_count == 0 ? ERROR_SUCCESS : ERROR_SYMBOL_NOT_FOUND;
+    return ERROR_SUCCESS;
 }
 
-int stld_link(stld_context_t* context, const char* output_file) {
-    size_t i;
-    int result;
-    FILE* output = NULL;  /* Initialize to NULL */
+static uint32_t crc32_string(uint32_t crc, const char* str) {
+    return crc32_update(crc, str, strlen(str) + 1);
+}
+
+/*
+ * Checksum the file and everything the rest of the link depends on:
+ * section names, sizes, addresses, flags and alignments and every
+ * symbol. Section bytes and relocations are left out; changing only those
+ * keeps the layout, so an incremental link can re-patch the input alone.
+ */
+static void fingerprint_object(input_object_t* object) {
+    const smof_section_t* sections = object_sections(object);
+    const symbol_t* symbol;
+    uint32_t fields[5];
+    uint32_t crc = CRC32_INITIAL;
+    uint32_t i;
     
-    if (context == NULL || output_file == NULL) {
-        return ERROR_INVALID_ARGUMENT;
+    object->checksum = crc32_calculate(object->map, object->map_size);
+    
+    fields[0] = object->layout.section_count;
+    fields[1] = object->layout.symbol_count;
+    crc = crc32_update(crc, fields, 2 * sizeof(uint32_t));
+    
+    for (i = 0; i < object->layout.section_count; i++) {
+        fields[0] = sections[i].virtual_addr;
+        fields[1] = sections[i].size;
+        fields[2] = sections[i].flags;
+        fields[3] = sections[i].alignment;
+        crc = crc32_string(crc, object->strings + sections[i].name_offset);
+        crc = crc32_update(crc, fields, 4 * sizeof(uint32_t));
     }
     
-    /* Report progress */
-    if (context->progress_callback != NULL) {
-        context->progress_callback("Initializing", 0, context->progress_user_data);
+    for (i = 0; i < object->layout.symbol_count; i++) {
+        symbol = &object->staged_symbols[i];
+        fields[0] = symbol->value;
+        fields[1] = symbol->size;
+        fields[2] = symbol->section_index;
+        fields[3] = (uint32_t)symbol->type;
+        fields[4] = (uint32_t)symbol->binding;
+        crc = crc32_string(crc, symbol->name);
+        crc = crc32_update(crc, fields, sizeof(fields));
     }
     
-    /* Load input files */
-    if (context->progress_callback != NULL) {
-        context->progress_callback("Loading objects", 25, context->progress_user_data);
+    object->signature = crc;
+}
+
+/* Bind, check and stage an input whose bytes are already mapped */
+static int parse_mapped_object(input_object_t* object) {
+    int result;
+    
+    /* Tables of the other byte order are swapped once, here, for every reader */
+    result = smof_convert_to_native(object->map, object->map_size);
+    if (result == ERROR_SUCCESS) {
+        result = bind_smof_tables(object);
+    }
+    if (result == ERROR_SUCCESS) {
+        result = validate_smof_sections(object);
+    }
+    if (result == ERROR_SUCCESS) {
+        result = stage_smof_symbols(object);
     }
     
-    for (i = 0; i < context->input_file_count; i++) {
-        result = load_smof_file(context, context->input_files[i]);
-        if (result != ERROR_SUCCESS) {
-            return result;
-        }
+    return result;
+}
+
+/* Parse one input; touches only its own object, so inputs parse in parallel */
+static int parse_smof_file(input_object_t* object, const char* filename, stld_cache_t* cache) {
+    int result;
+    
+    if (object == NULL || filename == NULL) {
+        return ERROR_INVALID_ARGUMENT;
     }
     
-    /* Resolve symbols */
-    if (context->progress_callback != NULL) {
-        context->progress_callback("Resolving symbols", 50, context->progress_user_data);
+    result = map_smof_file(object, filename, cache);
+    if (result == ERROR_SUCCESS) {
+        result = parse_mapped_object(object);
     }
     
-    // Process relocations using the current context structure
-    result = process_relocations(context);
-    if (result != ERROR_SUCCESS) {
-        if (output != NULL) {
-            fclose(output);
-        }
-        return result;
+    return result;
+}
+
+static int parse_smof_task(void* user_data, size_t index) {
+    stld_context_t* context = user_data;
+    trace_span_t span;
+    int result;
+    
+    TRACE_BEGIN(span, "load_object");
+    result = parse_smof_file(&context->objects[index], context->input_files[index],
+                             context->cache);
+    if (result == ERROR_SUCCESS && context->options.incremental) {
+        fingerprint_object(&context->objects[index]);
     }
+    TRACE_END(span, context->input_files[index]);
     
-    /* Layout sections */
-    if (context->progress_callback != NULL) {
-        context->progress_callback("Layout sections", 75, context->progress_user_data);
+    return result;
+}
+
+static size_t memory_in_use(const stld_context_t* context) {
+    return memory_pool_get_size(context->arena) +
+           symbol_table_get_memory_usage(context->symbols);
+}
+
+/* The arena enforces max_memory itself; the symbol table is checked here */
+static int check_memory_limit(const stld_context_t* context) {
+    if (context->options.max_memory != 0 &&
+        memory_in_use(context) > context->options.max_memory) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Linker memory limit exceeded");
+        return ERROR_OUT_OF_MEMORY;
     }
     
-    /* Write output */
-    if (context->progress_callback != NULL) {
-        context->progress_callback("Writing output", 90, context->progress_user_data);
+    return ERROR_SUCCESS;
+}
+
+static double elapsed_seconds(const struct timespec* start) {
+    struct timespec now;
+    
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+/* Time one stretch of a phase; the arena high-water mark restarts with it */
+static void phase_begin(stld_context_t* context, stld_phase_t phase) {
+    context->phase = phase;
+    memory_pool_reset_peak(context->arena);
+    clock_gettime(CLOCK_MONOTONIC, &context->phase_start);
+    TRACE_BEGIN(context->phase_span, stld_phase_name(phase));
+}
+
+static void phase_end(stld_context_t* context) {
+    stld_phase_stats_t* stats = &context->phases[context->phase];
+    size_t peak = memory_pool_get_peak(context->arena) +
+                  symbol_table_get_memory_usage(context->symbols);
+    
+    TRACE_END(context->phase_span, NULL);
+    stats->time += elapsed_seconds(&context->phase_start);
+    if (peak > stats->peak_memory) {
+        stats->peak_memory = peak;
+    }
+}
+
+static thread_pool_t* get_thread_pool(stld_context_t* context) {
+    if (context->pool == NULL && context->options.threads != 1) {
+        /* A failed pool is not fatal: phases fall back to serial */
+        context->pool = thread_pool_create(context->options.threads);
     }
     
-    /* Create simple output file */
-    output = fopen(output_file, "wb");
-    if (output == NULL) {
-        return ERROR_FILE_IO;
+    return context->pool;
+}
+
+static bool input_section_live(const stld_context_t* context, const input_object_t* object,
+                               uint32_t index) {
+    return context->section_live == NULL ||
+           context->section_live[object->first_section + index] != 0;
+}
+
+/* Give every input section a global id; relocations and collection use it */
+static void number_input_sections(stld_context_t* context) {
+    size_t i;
+    
+    context->section_count = 0;
+    for (i = 0; i < context->input_file_count; i++) {
+        context->objects[i].first_section = context->section_count;
+        context->section_count += context->objects[i].layout.section_count;
+    }
+}
+
+/* Global definition seen by section collection */
+typedef struct section_definition {
+    const char* name;                /* NULL for an empty slot */
+    uint32_t hash;
+    uint32_t section;                /* Global input section id */
+    symbol_binding_t binding;
+} section_definition_t;
+
+/*
+ * Reference graph over input sections. Edges are stored per source
+ * section (edge_start[id]..edge_start[id + 1]), so a section's references
+ * are walked without rescanning the relocation tables.
+ */
+typedef struct section_graph {
+    section_definition_t* definitions;  /* Open-addressed by name hash */
+    size_t mask;
+    uint32_t* edge_start;
+    uint32_t* edges;
+    uint32_t* worklist;
+    size_t pending;
+} section_graph_t;
+
+/* Relocatable outputs keep every section for the next link */
+static bool output_is_relocatable(const stld_options_t* options) {
+    return options->output_type == STLD_OUTPUT_OBJECT ||
+           options->output_type == STLD_OUTPUT_STATIC_LIBRARY;
+}
+
+static bool gc_enabled(const stld_options_t* options) {
+    if (output_is_relocatable(options)) {
+        return false;
     }
     
-    /* Write basic content based on output type */
-    if (context->options.output_type == STLD_OUTPUT_BINARY_FLAT) {
-        /* Write raw binary data */
-        uint8_t dummy_data[] = {0x90, 0x90, 0x90, 0x90}; /* NOP instructions */
-        fwrite(dummy_data, 1, sizeof(dummy_data), output);
-    } else {
-        /* Write SMOF header */
-        smof_header_t header = {
-            .magic = SMOF_MAGIC,
-            .version = SMOF_VERSION_CURRENT,
-            .flags = SMOF_FLAG_LITTLE_ENDIAN,
-            .entry_point = context->options.base_address,
-            .section_count = 1,
-            .symbol_count = 1,
-            .string_table_offset = sizeof(smof_header_t),
-            .string_table_size = 16,
-            .section_table_offset = sizeof(smof_header_t) + 16,
-            .reloc_table_offset = 0,
-            .reloc_count = 0,
-            .import_count = 0
-        };
-        fwrite(&header, sizeof(header), 1, output);
+    return options->gc_sections || options->optimize == STLD_OPTIMIZE_SIZE;
+}
+
+static bool symbol_defined_in(const input_object_t* object, const symbol_t* symbol) {
+    return symbol->section_index < object->layout.section_count;
+}
+
+/* A strong definition replaces a weak one; otherwise the first one stays */
+static void add_definition(section_graph_t* graph, const symbol_t* symbol,
+                           uint32_t hash, uint32_t section) {
+    section_definition_t* slot;
+    size_t index = hash & graph->mask;
+    
+    while (graph->definitions[index].name != NULL) {
+        slot = &graph->definitions[index];
+        if (slot->hash == hash && strcmp(slot->name, symbol->name) == 0) {
+            if (slot->binding == SYMBOL_BINDING_WEAK && symbol->binding != SYMBOL_BINDING_WEAK) {
+                slot->section = section;
+                slot->binding = symbol->binding;
+            }
+            return;
+        }
+        index = (index + 1) & graph->mask;
     }
     
-    fclose(output);
+    graph->definitions[index] = (section_definition_t) {
+        .name = symbol->name,
+        .hash = hash,
+        .section = section,
+        .binding = symbol->binding
+    };
+}
+
+static uint32_t find_definition(const section_graph_t* graph, const char* name, uint32_t hash) {
+    size_t index = hash & graph->mask;
     
-    if (context->progress_callback != NULL) {
-        context->progress_callback("Complete", 100, context->progress_user_data);
+    while (graph->definitions[index].name != NULL) {
+        if (graph->definitions[index].hash == hash &&
+            strcmp(graph->definitions[index].name, name) == 0) {
+            return graph->definitions[index].section;
+        }
+        index = (index + 1) & graph->mask;
     }
     
-    return ERROR_SUCCESS;
+    return INPUT_SECTION_NONE;
 }
 
-int stld_get_stats(const stld_context_t* context, stld_stats_t* stats) {
-    symbol_entry_t* symbol;
-    section_entry_t* section;
-    size_t symbol_count = 0;
-    size_t section_count = 0;
+static int build_definition_index(stld_context_t* context, section_graph_t* graph) {
+    const input_object_t* object;
+    const symbol_t* symbol;
+    size_t count = 0;
+    size_t capacity = 16;
+    size_t i;
+    uint32_t j;
     
-    if (context == NULL || stats == NULL) {
-        return ERROR_INVALID_ARGUMENT;
+    for (i = 0; i < context->input_file_count; i++) {
+        object = &context->objects[i];
+        for (j = 0; j < object->layout.symbol_count; j++) {
+            symbol = &object->staged_symbols[j];
+            if (symbol->binding != SYMBOL_BINDING_LOCAL && symbol_defined_in(object, symbol)) {
+                count++;
+            }
+        }
     }
     
-    /* Count symbols */
-    for (symbol = context->symbols; symbol != NULL; symbol = symbol->next) {
-        symbol_count++;
+    /* Keep the index at most half full */
+    while (capacity < count * 2) {
+        capacity *= 2;
     }
     
-    /* Count sections */
-    for (section = context->sections; section != NULL; section = section->next) {
-        section_count++;
+    graph->definitions = calloc(capacity, sizeof(section_definition_t));
+    if (graph->definitions == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate definition index");
+        return ERROR_OUT_OF_MEMORY;
     }
+    graph->mask = capacity - 1;
     
-    /* Fill in actual statistics */
-    stats->input_files = context->input_file_count;
-    stats->total_sections = section_count;
-    stats->total_symbols = symbol_count;
-    stats->relocations_processed = 0;
-    stats->output_size = 0; /* TODO: Calculate from sections */
-    stats->memory_used = 0; /* TODO: Track memory usage */
-    stats->link_time = 0.0; /* TODO: Track timing */
+    for (i = 0; i < context->input_file_count; i++) {
+        object = &context->objects[i];
+        for (j = 0; j < object->layout.symbol_count; j++) {
+            symbol = &object->staged_symbols[j];
+            if (symbol->binding != SYMBOL_BINDING_LOCAL && symbol_defined_in(object, symbol)) {
+                add_definition(graph, symbol, object->staged_hashes[j],
+                               object->first_section + symbol->section_index);
+            }
+        }
+    }
     
     return ERROR_SUCCESS;
 }
 
-int stld_link_files(const char* const* input_files,
-                   size_t input_count,
-                   const char* output_file,
-                   const stld_options_t* options) {
-    stld_context_t* context;
-    size_t i;
-    int result;
+/*
+ * Sections a relocation keeps alive: the winning definition of a global
+ * symbol and, if the referring object defines the symbol itself, that
+ * local definition too, since the symbol map may resolve to either.
+ */
+static size_t relocation_targets(const section_graph_t* graph, const input_object_t* object,
+                                 const smof_relocation_v2_t* reloc, uint32_t targets[2]) {
+    const symbol_t* symbol;
+    size_t count = 0;
+    uint32_t section;
     
-    if (input_files == NULL || input_count == 0 || output_file == NULL) {
-        return ERROR_INVALID_ARGUMENT;
+    if (reloc->symbol_index >= object->layout.symbol_count) {
+        return 0;
     }
     
-    /* Create context */
-    context = stld_context_create(options);
-    if (context == NULL) {
-        return ERROR_OUT_OF_MEMORY;
+    symbol = &object->staged_symbols[reloc->symbol_index];
+    if (symbol_defined_in(object, symbol)) {
+        targets[count++] = object->first_section + symbol->section_index;
     }
     
-    /* Add input files */
-    for (i = 0; i < input_count; i++) {
-        result = stld_add_input_file(context, input_files[i]);
-        if (result != ERROR_SUCCESS) {
-            stld_context_destroy(context);
-            return result;
+    if (symbol->binding != SYMBOL_BINDING_LOCAL) {
+        section = find_definition(graph, symbol->name, object->staged_hashes[reloc->symbol_index]);
+        if (section != INPUT_SECTION_NONE && (count == 0 || section != targets[0])) {
+            targets[count++] = section;
         }
     }
     
-    /* Perform linking */
-    result = stld_link(context, output_file);
+    return count;
+}
+
+static int build_reference_graph(stld_context_t* context, section_graph_t* graph) {
+    const input_object_t* object;
+    const smof_relocation_v2_t* reloc;
+    uint32_t targets[2];
+    uint32_t source;
+    size_t edge_count = 0;
+    size_t count;
+    size_t i;
+    size_t k;
+    uint32_t id;
+    uint32_t j;
     
-    /* Cleanup */
-    stld_context_destroy(context);
+    graph->edge_start = calloc((size_t)context->section_count + 1, sizeof(uint32_t));
+    graph->worklist = malloc(context->section_count * sizeof(uint32_t));
+    if (graph->edge_start == NULL || graph->worklist == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate reference graph");
+        return ERROR_OUT_OF_MEMORY;
+    }
     
-    return result;
+    /* Count each section's references, then turn the counts into offsets */
+    for (i = 0; i < context->input_file_count; i++) {
+        object = &context->objects[i];
+        for (j = 0; j < object->layout.reloc_count; j++) {
+            reloc = &object->relocations[j];
+            if (reloc->section_index < object->layout.section_count) {
+                count = relocation_targets(graph, object, reloc, targets);
+                graph->edge_start[object->first_section + reloc->section_index + 1] += (uint32_t)count;
+                edge_count += count;
+            }
+        }
+    }
+    
+    for (id = 0; id < context->section_count; id++) {
+        graph->edge_start[id + 1] += graph->edge_start[id];
+    }
+    
+    graph->edges = malloc((edge_count > 0 ? edge_count : 1) * sizeof(uint32_t));
+    if (graph->edges == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate reference graph");
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    /* The worklist is not in use yet and serves as the fill cursor */
+    memcpy(graph->worklist, graph->edge_start, context->section_count * sizeof(uint32_t));
+    for (i = 0; i < context->input_file_count; i++) {
+        object = &context->objects[i];
+        for (j = 0; j < object->layout.reloc_count; j++) {
+            reloc = &object->relocations[j];
+            if (reloc->section_index < object->layout.section_count) {
+                source = object->first_section + reloc->section_index;
+                count = relocation_targets(graph, object, reloc, targets);
+                for (k = 0; k < count; k++) {
+                    graph->edges[graph->worklist[source]++] = targets[k];
+                }
+            }
+        }
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+static void mark_section_live(stld_context_t* context, section_graph_t* graph, uint32_t id) {
+    if (context->section_live[id] == 0) {
+        context->section_live[id] = 1;
+        graph->worklist[graph->pending++] = id;
+    }
+}
+
+/* The script's ENTRY symbol, or _start */
+static const char* entry_symbol(const stld_context_t* context) {
+    const char* entry = linker_script_get_entry(context->script);
+    
+    return entry != NULL ? entry : STLD_ENTRY_SYMBOL;
+}
+
+/*
+ * Roots are the entry symbol's section, sections defining exported
+ * symbols (any global one for shared libraries), sections the script
+ * KEEPs and non-loadable sections. Without an entry symbol the first
+ * input is kept whole, as the entry point then defaults to the start of
+ * the image.
+ */
+
+static void mark_root_sections(stld_context_t* context, section_graph_t* graph) {
+    bool shared = context->options.output_type == STLD_OUTPUT_SHARED_LIBRARY;
+    const char* name = entry_symbol(context);
+    const input_object_t* object;
+    const symbol_t* symbol;
+    const smof_section_t* sections;
+    uint32_t entry;
+    size_t i;
+    uint32_t j;
+    
+    for (i = 0; i < context->input_file_count; i++) {
+        object = &context->objects[i];
+        sections = object_sections(object);
+        
+        for (j = 0; j < object->layout.section_count; j++) {
+            if ((sections[j].flags & SMOF_SECT_LOADABLE) == 0) {
+                mark_section_live(context, graph, object->first_section + j);
+            }
+        }
+        
+        for (j = 0; j < object->layout.symbol_count; j++) {
+            symbol = &object->staged_symbols[j];
+            if (symbol_defined_in(object, symbol) &&
+                (symbol->binding == SYMBOL_BINDING_EXPORT ||
+                 (shared && symbol->binding == SYMBOL_BINDING_GLOBAL))) {
+                mark_section_live(context, graph, object->first_section + symbol->section_index);
+            }
+        }
+    }
+    
+    /* KEEP() in the script makes its sections roots */
+    if (context->section_rules != NULL) {
+        for (entry = 0; entry < context->section_count; entry++) {
+            if (context->section_rules[entry] != SCRIPT_NO_RULE &&
+                linker_script_get_rule(context->script, context->section_rules[entry])->keep) {
+                mark_section_live(context, graph, entry);
+            }
+        }
+    }
+    
+    entry = find_definition(graph, name, symbol_table_hash_name(name));
+    if (entry != INPUT_SECTION_NONE) {
+        mark_section_live(context, graph, entry);
+    } else if (context->input_file_count > 0) {
+        for (j = 0; j < context->objects[0].layout.section_count; j++) {
+            mark_section_live(context, graph, (uint32_t)j);
+        }
+    }
+}
+
+/*
+ * Match every input section name against the script once; layout and
+ * collection then look the rule up by global section id.
+ */
+static int match_script_rules(stld_context_t* context) {
+    const input_object_t* object;
+    const smof_section_t* sections;
+    size_t i;
+    uint32_t j;
+    
+    context->section_rules = NULL;
+    if (context->script == NULL || context->section_count == 0) {
+        return ERROR_SUCCESS;
+    }
+    
+    context->section_rules = memory_pool_alloc(context->arena,
+                                               context->section_count * sizeof(uint32_t));
+    if (context->section_rules == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate script rules");
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    for (i = 0; i < context->input_file_count; i++) {
+        object = &context->objects[i];
+        sections = object_sections(object);
+        for (j = 0; j < object->layout.section_count; j++) {
+            context->section_rules[object->first_section + j] =
+                linker_script_match(context->script, object->strings + sections[j].name_offset);
+        }
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+/* Script output an input section is placed in, NULL for none */
+static const script_output_t* section_script_output(const stld_context_t* context, uint32_t id,
+                                                    uint32_t* index) {
+    uint32_t rule;
+    
+    if (context->section_rules == NULL || context->section_rules[id] == SCRIPT_NO_RULE) {
+        return NULL;
+    }
+    
+    rule = context->section_rules[id];
+    *index = linker_script_get_rule(context->script, rule)->output;
+    return linker_script_get_output(context->script, *index);
+}
+
+/* Drop what /DISCARD/ matches, whether or not collection kept it */
+static int discard_script_sections(stld_context_t* context) {
+    const script_output_t* output;
+    uint32_t index;
+    uint32_t id;
+    
+    if (context->section_rules == NULL) {
+        return ERROR_SUCCESS;
+    }
+    
+    if (context->section_live == NULL) {
+        context->section_live = memory_pool_alloc(context->arena, context->section_count);
+        if (context->section_live == NULL) {
+            ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate section marks");
+            return ERROR_OUT_OF_MEMORY;
+        }
+        memset(context->section_live, 1, context->section_count);
+    }
+    
+    for (id = 0; id < context->section_count; id++) {
+        output = section_script_output(context, id, &index);
+        if (output != NULL && output->discard && context->section_live[id] != 0) {
+            context->section_live[id] = 0;
+            context->sections_removed++;
+        }
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+/*
+ * Mark the input sections reachable from the roots along relocations;
+ * everything else is left out of layout, relocation and output.
+ */
+static int collect_sections(stld_context_t* context) {
+    section_graph_t graph = {0};
+    uint32_t id;
+    uint32_t edge;
+    int result;
+    
+    number_input_sections(context);
+    context->section_live = NULL;
+    context->sections_removed = 0;
+    
+    result = match_script_rules(context);
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    if (!gc_enabled(&context->options) || context->section_count == 0) {
+        return discard_script_sections(context);
+    }
+    
+    context->section_live = memory_pool_calloc(context->arena, context->section_count, 1);
+    if (context->section_live == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate section marks");
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    result = build_definition_index(context, &graph);
+    if (result == ERROR_SUCCESS) {
+        result = build_reference_graph(context, &graph);
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        mark_root_sections(context, &graph);
+        
+        while (graph.pending > 0) {
+            id = graph.worklist[--graph.pending];
+            for (edge = graph.edge_start[id]; edge < graph.edge_start[id + 1]; edge++) {
+                mark_section_live(context, &graph, graph.edges[edge]);
+            }
+        }
+        
+        for (id = 0; id < context->section_count; id++) {
+            if (context->section_live[id] == 0) {
+                context->sections_removed++;
+            }
+        }
+    }
+    
+    free(graph.definitions);
+    free(graph.edge_start);
+    free(graph.edges);
+    free(graph.worklist);
+    
+    return result == ERROR_SUCCESS ? discard_script_sections(context) : result;
+}
+
+/* 64-bit FNV-1a, used for section contents */
+#define FOLD_HASH_BASIS 14695981039346656037ULL
+#define FOLD_HASH_PRIME 1099511628211ULL
+
+/* Relocation target meaning "the referring section itself" */
+#define INPUT_SECTION_SELF 0xFFFFFFFEU
+
+/* Section considered for identical code folding */
+typedef struct fold_candidate {
+    uint64_t hash;                   /* Contents and relocation targets */
+    uint32_t section;                /* Global input section id */
+    uint32_t object;                 /* Owning input */
+    uint32_t index;                  /* Section index within the input */
+} fold_candidate_t;
+
+/* What a relocation refers to, independent of where its section lands */
+typedef struct fold_target {
+    const char* name;                /* Global symbol, NULL for a local one */
+    uint32_t hash;
+    uint32_t section;                /* Local target section or INPUT_SECTION_SELF */
+    uint32_t offset;                 /* Offset within the local target section */
+} fold_target_t;
+
+typedef struct fold_state {
+    stld_context_t* context;
+    fold_candidate_t* candidates;
+    size_t candidate_count;
+    uint32_t* reloc_start;           /* Per global section, into relocs */
+    const smof_relocation_v2_t** relocs; /* Relocations grouped by section */
+} fold_state_t;
+
+static bool fold_enabled(const stld_options_t* options) {
+    if (output_is_relocatable(options)) {
+        return false;
+    }
+    
+    return options->fold_identical || options->optimize == STLD_OPTIMIZE_SIZE ||
+           options->optimize == STLD_OPTIMIZE_BALANCED;
+}
+
+static bool input_section_folded(const stld_context_t* context, const input_object_t* object,
+                                 uint32_t index) {
+    return context->folded_into != NULL &&
+           context->folded_into[object->first_section + index] != INPUT_SECTION_NONE;
+}
+
+/* Read-only code with contents; writable or zero-fill sections never fold */
+static bool section_foldable(const smof_section_t* section) {
+    return (section->flags & SMOF_SECT_EXECUTABLE) != 0 &&
+           (section->flags & (SMOF_SECT_WRITABLE | SMOF_SECT_ZERO_FILL)) == 0 &&
+           section->size > 0;
+}
+
+/* Input owning a global section id; objects are ordered by first_section */
+static size_t find_input_object(const stld_context_t* context, uint32_t section) {
+    size_t low = 0;
+    size_t high = context->input_file_count;
+    size_t mid;
+    
+    while (high - low > 1) {
+        mid = low + (high - low) / 2;
+        if (context->objects[mid].first_section <= section) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    
+    return low;
+}
+
+static void fold_target_of(const input_object_t* object, uint32_t self,
+                           const smof_relocation_v2_t* reloc, fold_target_t* target) {
+    const symbol_t* symbol;
+    uint32_t section;
+    
+    *target = (fold_target_t) {
+        .name = NULL,
+        .hash = 0,
+        .section = INPUT_SECTION_NONE,
+        .offset = reloc->symbol_index
+    };
+    
+    if (reloc->symbol_index >= object->layout.symbol_count) {
+        return;  /* Rejected when relocations are queued */
+    }
+    
+    symbol = &object->staged_symbols[reloc->symbol_index];
+    if (symbol->binding != SYMBOL_BINDING_LOCAL || !symbol_defined_in(object, symbol)) {
+        target->name = symbol->name;
+        target->hash = object->staged_hashes[reloc->symbol_index];
+        target->offset = 0;
+    } else {
+        section = object->first_section + symbol->section_index;
+        target->section = section == self ? INPUT_SECTION_SELF : section;
+        target->offset = symbol->value - object_sections(object)[symbol->section_index].virtual_addr;
+    }
+}
+
+static bool fold_targets_equal(const fold_target_t* a, const fold_target_t* b) {
+    if (a->name != NULL || b->name != NULL) {
+        return a->name != NULL && b->name != NULL && a->hash == b->hash &&
+               strcmp(a->name, b->name) == 0;
+    }
+    
+    return a->section == b->section && a->offset == b->offset;
+}
+
+static uint64_t fold_hash_word(uint64_t hash, uint32_t word) {
+    hash ^= word;
+    return hash * FOLD_HASH_PRIME;
+}
+
+/* Hash one candidate; candidates are independent, so this runs in parallel */
+static int hash_candidate_task(void* user_data, size_t index) {
+    fold_state_t* state = user_data;
+    fold_candidate_t* candidate = &state->candidates[index];
+    const input_object_t* object = &state->context->objects[candidate->object];
+    const smof_section_t* section = &object_sections(object)[candidate->index];
+    const uint8_t* data = object->map + section->file_offset;
+    const smof_relocation_v2_t* reloc;
+    fold_target_t target;
+    uint64_t hash = FOLD_HASH_BASIS;
+    uint32_t i;
+    
+    hash = fold_hash_word(hash, section->size);
+    hash = fold_hash_word(hash, ((uint32_t)section->flags << 8) | section->alignment);
+    for (i = 0; i < section->size; i++) {
+        hash ^= data[i];
+        hash *= FOLD_HASH_PRIME;
+    }
+    
+    for (i = state->reloc_start[candidate->section];
+         i < state->reloc_start[candidate->section + 1]; i++) {
+        reloc = state->relocs[i];
+        fold_target_of(object, candidate->section, reloc, &target);
+        hash = fold_hash_word(hash, reloc->offset);
+        hash = fold_hash_word(hash, reloc->type);
+        hash = fold_hash_word(hash, target.name != NULL ? target.hash : target.section);
+        hash = fold_hash_word(hash, target.offset);
+    }
+    
+    candidate->hash = hash;
+    
+    return ERROR_SUCCESS;
+}
+
+/* Byte-for-byte confirmation of a hash match, relocations included */
+static bool candidates_identical(const fold_state_t* state, const fold_candidate_t* a,
+                                 const fold_candidate_t* b) {
+    const input_object_t* object_a = &state->context->objects[a->object];
+    const input_object_t* object_b = &state->context->objects[b->object];
+    const smof_section_t* section_a = &object_sections(object_a)[a->index];
+    const smof_section_t* section_b = &object_sections(object_b)[b->index];
+    uint32_t start_a = state->reloc_start[a->section];
+    uint32_t start_b = state->reloc_start[b->section];
+    uint32_t count = state->reloc_start[a->section + 1] - start_a;
+    fold_target_t target_a;
+    fold_target_t target_b;
+    uint32_t i;
+    
+    if (section_a->size != section_b->size || section_a->flags != section_b->flags ||
+        section_a->alignment != section_b->alignment ||
+        state->reloc_start[b->section + 1] - start_b != count ||
+        memcmp(object_a->map + section_a->file_offset,
+               object_b->map + section_b->file_offset, section_a->size) != 0) {
+        return false;
+    }
+    
+    for (i = 0; i < count; i++) {
+        const smof_relocation_v2_t* reloc_a = state->relocs[start_a + i];
+        const smof_relocation_v2_t* reloc_b = state->relocs[start_b + i];
+        
+        if (reloc_a->offset != reloc_b->offset || reloc_a->type != reloc_b->type) {
+            return false;
+        }
+        
+        fold_target_of(object_a, a->section, reloc_a, &target_a);
+        fold_target_of(object_b, b->section, reloc_b, &target_b);
+        if (!fold_targets_equal(&target_a, &target_b)) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+static int compare_fold_candidates(const void* a, const void* b) {
+    const fold_candidate_t* left = a;
+    const fold_candidate_t* right = b;
+    
+    if (left->hash != right->hash) {
+        return left->hash < right->hash ? -1 : 1;
+    }
+    
+    return left->section < right->section ? -1 : (left->section > right->section ? 1 : 0);
+}
+
+/* Group every live section's relocations by section, in table order */
+static int group_relocations(stld_context_t* context, fold_state_t* state) {
+    const input_object_t* object;
+    const smof_relocation_v2_t* reloc;
+    uint32_t* cursor;
+    size_t total = 0;
+    uint32_t id;
+    size_t i;
+    uint32_t j;
+    
+    state->reloc_start = calloc((size_t)context->section_count + 1, sizeof(uint32_t));
+    cursor = malloc(context->section_count * sizeof(uint32_t));
+    if (state->reloc_start == NULL || cursor == NULL) {
+        free(cursor);
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate relocation groups");
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    for (i = 0; i < context->input_file_count; i++) {
+        object = &context->objects[i];
+        for (j = 0; j < object->layout.reloc_count; j++) {
+            if (object->relocations[j].section_index < object->layout.section_count) {
+                state->reloc_start[object->first_section +
+                                   object->relocations[j].section_index + 1]++;
+                total++;
+            }
+        }
+    }
+    
+    for (id = 0; id < context->section_count; id++) {
+        state->reloc_start[id + 1] += state->reloc_start[id];
+    }
+    
+    state->relocs = malloc((total > 0 ? total : 1) * sizeof(const smof_relocation_v2_t*));
+    if (state->relocs == NULL) {
+        free(cursor);
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate relocation groups");
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    memcpy(cursor, state->reloc_start, context->section_count * sizeof(uint32_t));
+    for (i = 0; i < context->input_file_count; i++) {
+        object = &context->objects[i];
+        for (j = 0; j < object->layout.reloc_count; j++) {
+            reloc = &object->relocations[j];
+            if (reloc->section_index < object->layout.section_count) {
+                state->relocs[cursor[object->first_section + reloc->section_index]++] = reloc;
+            }
+        }
+    }
+    
+    free(cursor);
+    
+    return ERROR_SUCCESS;
+}
+
+static int collect_fold_candidates(stld_context_t* context, fold_state_t* state) {
+    const input_object_t* object;
+    const smof_section_t* sections;
+    size_t i;
+    uint32_t j;
+    
+    state->candidates = malloc((context->section_count > 0 ? context->section_count : 1) *
+                               sizeof(fold_candidate_t));
+    if (state->candidates == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate fold candidates");
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    for (i = 0; i < context->input_file_count; i++) {
+        object = &context->objects[i];
+        sections = object_sections(object);
+        
+        for (j = 0; j < object->layout.section_count; j++) {
+            if (section_foldable(&sections[j]) && input_section_live(context, object, j)) {
+                state->candidates[state->candidate_count++] = (fold_candidate_t) {
+                    .hash = 0,
+                    .section = object->first_section + j,
+                    .object = (uint32_t)i,
+                    .index = j
+                };
+            }
+        }
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+/*
+ * Fold identical read-only code. Candidates are hashed in parallel over
+ * their bytes and relocation targets, sorted so equal hashes are adjacent
+ * and confirmed byte for byte; each duplicate is folded into the lowest
+ * numbered copy, which is always laid out before it. A folded section is
+ * neither written nor patched, and its symbols land in the kept copy.
+ */
+static int fold_identical_sections(stld_context_t* context) {
+    fold_state_t state = {0};
+    thread_pool_t* pool = NULL;
+    size_t run;
+    size_t i;
+    size_t k;
+    int result;
+    
+    context->folded_into = NULL;
+    context->sections_folded = 0;
+    
+    if (!fold_enabled(&context->options) || context->section_count < 2) {
+        return ERROR_SUCCESS;
+    }
+    
+    context->folded_into = memory_pool_alloc(context->arena,
+                                             context->section_count * sizeof(uint32_t));
+    if (context->folded_into == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate fold map");
+        return ERROR_OUT_OF_MEMORY;
+    }
+    memset(context->folded_into, 0xFF, context->section_count * sizeof(uint32_t));
+    
+    state.context = context;
+    result = collect_fold_candidates(context, &state);
+    if (result == ERROR_SUCCESS && state.candidate_count > 1) {
+        result = group_relocations(context, &state);
+        
+        if (result == ERROR_SUCCESS) {
+            pool = get_thread_pool(context);
+            result = thread_pool_run(pool, state.candidate_count, hash_candidate_task, &state);
+        }
+        
+        if (result == ERROR_SUCCESS) {
+            qsort(state.candidates, state.candidate_count, sizeof(fold_candidate_t),
+                  compare_fold_candidates);
+            
+            /* Within a run of equal hashes, fold each section into the first match */
+            for (run = 0; run < state.candidate_count; run = i) {
+                for (i = run + 1; i < state.candidate_count &&
+                     state.candidates[i].hash == state.candidates[run].hash; i++) {
+                    for (k = run; k < i; k++) {
+                        if (context->folded_into[state.candidates[k].section] == INPUT_SECTION_NONE &&
+                            candidates_identical(&state, &state.candidates[k], &state.candidates[i])) {
+                            context->folded_into[state.candidates[i].section] =
+                                state.candidates[k].section;
+                            context->sections_folded++;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    
+    free(state.candidates);
+    free(state.reloc_start);
+    free(state.relocs);
+    
+    return result;
+}
+
+/* Allocate an input's section map; sections start out unplaced */
+static int prepare_object_layout(stld_context_t* context, input_object_t* object) {
+    const smof_section_t* sections = object_sections(object);
+    uint32_t section_count = object->layout.section_count;
+    uint32_t i;
+    
+    if (section_count == 0) {
+        return ERROR_SUCCESS;
+    }
+    
+    object->output_sections = memory_pool_alloc(context->arena,
+                                                section_count * sizeof(section_id_t));
+    object->section_addresses = memory_pool_alloc(context->arena,
+                                                  section_count * sizeof(uint32_t));
+    if (object->output_sections == NULL || object->section_addresses == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate section map");
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    for (i = 0; i < section_count; i++) {
+        if (sections[i].alignment >= 32) {
+            ERROR_REPORT_ERROR(ERROR_SECTION_ALIGNMENT, "Section alignment out of range");
+            return ERROR_SECTION_ALIGNMENT;
+        }
+        object->output_sections[i] = SECTION_ID_INVALID;
+        object->section_addresses[i] = 0;
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+/*
+ * Output section for an input section: the script's output if a rule
+ * matches, else one named like the input. Created on first use.
+ */
+static int find_output_section(stld_context_t* context, const input_object_t* object,
+                               uint32_t index, section_id_t* id) {
+    const smof_section_t* section = &object_sections(object)[index];
+    const char* name = object->strings + section->name_offset;
+    const script_output_t* output;
+    uint32_t output_index = 0;
+    int result = ERROR_SUCCESS;
+    
+    output = section_script_output(context, object->first_section + index, &output_index);
+    if (output != NULL) {
+        name = output->name;
+    }
+    
+    *id = section_manager_find_section(context->sections, name);
+    if (*id == SECTION_ID_INVALID) {
+        *id = section_manager_create_section(context->sections, name,
+                                             section_type_from_flags(section->flags),
+                                             section->flags);
+        if (*id == SECTION_ID_INVALID) {
+            return ERROR_OUT_OF_MEMORY;
+        }
+    }
+    
+    /* Script outputs are laid out in script order, placed as it says */
+    if (output != NULL) {
+        result = section_manager_set_rank(context->sections, *id, (uint16_t)output_index);
+        if (result == ERROR_SUCCESS && output->fixed) {
+            result = section_manager_set_start(context->sections, *id, output->address);
+        }
+        if (result == ERROR_SUCCESS &&
+            output->alignment > section_manager_get_section(context->sections, *id)->alignment) {
+            result = section_manager_set_alignment(context->sections, *id, output->alignment);
+        }
+    }
+    
+    return result;
+}
+
+/*
+ * Append one live, unfolded input section to its output section. The
+ * fragment references the input mapping, so nothing is copied.
+ */
+static int place_input_section(stld_context_t* context, input_object_t* object, uint32_t index) {
+    const smof_section_t* section = &object_sections(object)[index];
+    bool zero_fill = (section->flags & SMOF_SECT_ZERO_FILL) != 0;
+    section_id_t id;
+    uint32_t offset;
+    int result;
+    
+    /* Collected sections get no output section and no address */
+    if (!input_section_live(context, object, index) ||
+        input_section_folded(context, object, index)) {
+        return ERROR_SUCCESS;
+    }
+    
+    result = find_output_section(context, object, index, &id);
+    if (result == ERROR_SUCCESS) {
+        result = section_manager_add_data(context->sections, id,
+                                          zero_fill ? NULL : object->map + section->file_offset,
+                                          section->size, (uint32_t)1 << section->alignment,
+                                          &offset);
+    }
+    if (result == ERROR_SUCCESS) {
+        object->output_sections[index] = id;
+        object->section_addresses[index] = offset;  /* Made absolute after layout */
+    }
+    
+    return result;
+}
+
+/* A folded section shares the place of its kept copy */
+static void place_folded_sections(stld_context_t* context, input_object_t* object) {
+    const input_object_t* kept;
+    uint32_t kept_section;
+    uint32_t i;
+    
+    for (i = 0; i < object->layout.section_count; i++) {
+        if (input_section_live(context, object, i) && input_section_folded(context, object, i)) {
+            kept_section = context->folded_into[object->first_section + i];
+            kept = &context->objects[find_input_object(context, kept_section)];
+            object->output_sections[i] = kept->output_sections[kept_section - kept->first_section];
+            object->section_addresses[i] = kept->section_addresses[kept_section - kept->first_section];
+        }
+    }
+}
+
+static int compare_placement_keys(const void* a, const void* b) {
+    uint64_t left = *(const uint64_t*)a;
+    uint64_t right = *(const uint64_t*)b;
+    
+    return left < right ? -1 : (left > right ? 1 : 0);
+}
+
+/*
+ * With a script, inputs enter their output section in rule order and
+ * input order within a rule; unmatched ones follow in input order.
+ */
+static int place_by_rule(stld_context_t* context) {
+    input_object_t* object;
+    uint64_t* keys;
+    uint32_t id;
+    int result = ERROR_SUCCESS;
+    
+    keys = malloc(context->section_count * sizeof(uint64_t));
+    if (keys == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate placement order");
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    for (id = 0; id < context->section_count; id++) {
+        keys[id] = ((uint64_t)context->section_rules[id] << 32) | id;
+    }
+    qsort(keys, context->section_count, sizeof(uint64_t), compare_placement_keys);
+    
+    for (id = 0; id < context->section_count && result == ERROR_SUCCESS; id++) {
+        object = &context->objects[find_input_object(context, (uint32_t)keys[id])];
+        result = place_input_section(context, object,
+                                     (uint32_t)keys[id] - object->first_section);
+    }
+    
+    free(keys);
+    return result;
+}
+
+/* Merge every input into output sections and assign their addresses */
+/* Whether a GOT relocation of the object's is applied by this link */
+static bool relocation_uses_got(const stld_context_t* context, const input_object_t* object,
+                                const smof_relocation_v2_t* reloc) {
+    return reloc->type == SMOF_RELOC_GOT && reloc->section_index < object->layout.section_count &&
+           input_section_live(context, object, reloc->section_index) &&
+           !input_section_folded(context, object, reloc->section_index);
+}
+
+/*
+ * Count the GOT slots the relocation pass will hand out: one per symbol
+ * referenced through a GOT relocation. Globals are told apart by name, as
+ * the symbol table merges them; each local symbol is its own.
+ */
+static int count_got_slots(const stld_context_t* context, size_t* slots) {
+    const input_object_t* object;
+    const smof_relocation_v2_t* reloc;
+    symbol_table_t* globals = NULL;
+    symbol_t symbol;
+    uint8_t* seen;
+    size_t i;
+    uint32_t j;
+    int result = ERROR_SUCCESS;
+    
+    *slots = 0;
+    for (i = 0; i < context->input_file_count && result == ERROR_SUCCESS; i++) {
+        object = &context->objects[i];
+        seen = NULL;
+        
+        for (j = 0; j < object->layout.reloc_count && result == ERROR_SUCCESS; j++) {
+            reloc = &object->relocations[j];
+            if (!relocation_uses_got(context, object, reloc) ||
+                reloc->symbol_index >= object->layout.symbol_count) {
+                continue;
+            }
+            
+            if (seen == NULL) {
+                seen = calloc(object->layout.symbol_count, sizeof(uint8_t));
+                if (globals == NULL) {
+                    globals = symbol_table_create(0);
+                }
+                if (seen == NULL || globals == NULL) {
+                    result = ERROR_OUT_OF_MEMORY;
+                    break;
+                }
+            }
+            if (seen[reloc->symbol_index]) {
+                continue;
+            }
+            seen[reloc->symbol_index] = 1;
+            
+            symbol = object->staged_symbols[reloc->symbol_index];
+            if (symbol.binding == SYMBOL_BINDING_LOCAL) {
+                (*slots)++;
+                continue;
+            }
+            
+            /* An undefined global merges into an earlier one of its name */
+            symbol.binding = SYMBOL_BINDING_GLOBAL;
+            symbol.section_index = SECTION_INDEX_UNDEFINED;
+            if (symbol_table_insert_hash(globals, &symbol,
+                                         object->staged_hashes[reloc->symbol_index]) ==
+                SYMBOL_HANDLE_INVALID) {
+                result = ERROR_OUT_OF_MEMORY;
+            }
+        }
+        free(seen);
+    }
+    
+    if (globals != NULL) {
+        *slots += symbol_table_size(globals);
+        symbol_table_destroy(globals);
+    }
+    if (result != ERROR_SUCCESS) {
+        ERROR_REPORT_ERROR(result, "Failed to count GOT slots");
+    }
+    
+    return result;
+}
+
+/*
+ * Reserve the GOT as a ".got" output section laid out with the rest; its
+ * slots are filled in once the relocation pass has handed them out. A
+ * relocatable output leaves GOT relocations to the final link.
+ */
+static int reserve_got(stld_context_t* context) {
+    size_t slots;
+    int result;
+    
+    context->got_section = SECTION_ID_INVALID;
+    context->got_data = NULL;
+    context->got_slots = 0;
+    if (output_is_relocatable(&context->options)) {
+        return ERROR_SUCCESS;
+    }
+    
+    result = count_got_slots(context, &slots);
+    if (result != ERROR_SUCCESS || slots == 0) {
+        return result;
+    }
+    if (slots > UINT32_MAX / sizeof(uint32_t)) {
+        ERROR_REPORT_ERROR(ERROR_OUTPUT_TOO_LARGE, "GOT too large");
+        return ERROR_OUTPUT_TOO_LARGE;
+    }
+    
+    context->got_data = memory_pool_calloc(context->arena, slots, sizeof(uint32_t));
+    if (context->got_data == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate GOT");
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    context->got_section = section_manager_find_section(context->sections, ".got");
+    if (context->got_section == SECTION_ID_INVALID) {
+        context->got_section = section_manager_create_section(
+            context->sections, ".got", SECTION_TYPE_DATA,
+            SECTION_FLAG_READABLE | SECTION_FLAG_WRITABLE | SECTION_FLAG_LOADABLE);
+        if (context->got_section == SECTION_ID_INVALID) {
+            return ERROR_OUT_OF_MEMORY;
+        }
+    }
+    
+    result = section_manager_add_data(context->sections, context->got_section, context->got_data,
+                                      (uint32_t)(slots * sizeof(uint32_t)), sizeof(uint32_t),
+                                      &context->got_offset);
+    if (result == ERROR_SUCCESS) {
+        context->got_slots = slots;
+    }
+    
+    return result;
+}
+
+static int layout_sections(stld_context_t* context) {
+    input_object_t* object;
+    size_t i;
+    uint32_t j;
+    int result = ERROR_SUCCESS;
+    
+    if (context->sections == NULL) {
+        context->sections = section_manager_create(context->arena);
+        if (context->sections == NULL) {
+            return ERROR_OUT_OF_MEMORY;
+        }
+    }
+    
+    for (i = 0; i < context->input_file_count && result == ERROR_SUCCESS; i++) {
+        result = prepare_object_layout(context, &context->objects[i]);
+    }
+    
+    if (result == ERROR_SUCCESS && context->section_rules != NULL) {
+        result = place_by_rule(context);
+    } else {
+        for (i = 0; i < context->input_file_count && result == ERROR_SUCCESS; i++) {
+            object = &context->objects[i];
+            for (j = 0; j < object->layout.section_count && result == ERROR_SUCCESS; j++) {
+                result = place_input_section(context, object, j);
+            }
+        }
+    }
+    
+    /* Kept copies have their places now, wherever they are in the order */
+    for (i = 0; i < context->input_file_count && result == ERROR_SUCCESS; i++) {
+        place_folded_sections(context, &context->objects[i]);
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        result = reserve_got(context);
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        result = section_manager_calculate_layout(context->sections,
+                                                  context->options.base_address);
+    }
+    
+    /* Output section indices must stay below SECTION_INDEX_UNDEFINED */
+    if (result == ERROR_SUCCESS &&
+        section_manager_get_count(context->sections) >= SECTION_INDEX_UNDEFINED) {
+        ERROR_REPORT_ERROR(ERROR_OUTPUT_TOO_LARGE, "Too many output sections");
+        result = ERROR_OUTPUT_TOO_LARGE;
+    }
+    
+    for (i = 0; i < context->input_file_count && result == ERROR_SUCCESS; i++) {
+        object = &context->objects[i];
+        
+        for (j = 0; j < object->layout.section_count; j++) {
+            if (object->output_sections[j] == SECTION_ID_INVALID) {
+                continue;
+            }
+            object->section_addresses[j] +=
+                section_manager_get_section(context->sections,
+                                            object->output_sections[j])->address;
+        }
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        result = check_memory_limit(context);
+    }
+    
+    return result;
+}
+
+/* Merge a laid-out input's symbols into the global table; run in input order */
+static int merge_smof_symbols(stld_context_t* context, input_object_t* object) {
+    const smof_section_t* sections = object_sections(object);
+    uint32_t section_count = object->layout.section_count;
+    uint32_t count = object->layout.symbol_count;
+    symbol_t* symbol;
+    uint32_t index;
+    uint32_t i;
+    
+    if (count > 0) {
+        object->symbol_map = memory_pool_alloc(context->arena, count * sizeof(symbol_handle_t));
+        if (object->symbol_map == NULL) {
+            ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate symbol map");
+            return ERROR_OUT_OF_MEMORY;
+        }
+    }
+    
+    /* Resolve every file-local index to a global handle once */
+    for (i = 0; i < count; i++) {
+        symbol = &object->staged_symbols[i];
+        index = symbol->section_index;
+        
+        if (index < section_count && !input_section_live(context, object, index)) {
+            /* Nothing live refers to a definition in a collected section */
+            object->symbol_map[i] = SYMBOL_HANDLE_INVALID;
+        } else {
+            /* Move definitions with their section into the output */
+            if (index < section_count) {
+                symbol->value += object->section_addresses[index] - sections[index].virtual_addr;
+                symbol->section_index = (uint16_t)section_manager_get_section(
+                    context->sections, object->output_sections[index])->layout_index;
+            }
+            
+            object->symbol_map[i] = symbol_table_insert_hash(context->symbols, symbol,
+                                                             object->staged_hashes[i]);
+            if (object->symbol_map[i] == SYMBOL_HANDLE_INVALID) {
+                return ERROR_INVALID_SYMBOL;
+            }
+        }
+        object->symbol_count = i + 1;
+    }
+    
+    free(object->staged_symbols);
+    free(object->staged_hashes);
+    object->staged_symbols = NULL;
+    object->staged_hashes = NULL;
+    
+    return check_memory_limit(context);
+}
+
+static int load_input_files(stld_context_t* context) {
+    thread_pool_t* pool = NULL;
+    size_t i;
+    int result;
+    
+    if (context->input_file_count > 1) {
+        pool = get_thread_pool(context);
+    }
+    
+    result = thread_pool_run(pool, context->input_file_count, parse_smof_task, context);
+    for (i = 0; i < context->input_file_count; i++) {
+        context->inputs_cached += (size_t)context->objects[i].cached;
+    }
+    
+    return result;
+}
+
+/* Archive searched for members that define undefined symbols */
+typedef struct library {
+    const char* path;
+    archive_file_t* archive;         /* Header, member table and names only */
+    symbol_index_t* index;           /* Serialized index read from the archive */
+    uint8_t* loaded;                 /* Per member: already an input */
+    stld_cache_t* cache;             /* Owner of entry */
+    cache_entry_t* entry;            /* Archive and index from the shared cache, else NULL */
+} library_t;
+
+/* Undefined strong reference awaiting a definition */
+typedef struct pending_reference {
+    const char* name;
+    uint32_t hash;
+} pending_reference_t;
+
+/*
+ * Library resolution state. defined is an open-addressed set of the global
+ * names the inputs define so far; pending is a worklist of undefined
+ * references that only grows, so one pass over it reaches the fixed point.
+ */
+typedef struct library_state {
+    library_t* libraries;
+    size_t library_count;
+    const char** defined;
+    uint32_t* defined_hashes;
+    size_t defined_mask;
+    size_t defined_count;
+    pending_reference_t* pending;
+    size_t pending_count;
+    size_t pending_capacity;
+} library_state_t;
+
+/* lib<name>.star in the first search directory that has it; names with a '/' are paths */
+static int find_library(stld_context_t* context, const char* name, char** path) {
+    struct stat st;
+    size_t size;
+    size_t i;
+    
+    if (strchr(name, '/') != NULL) {
+        size = strlen(name) + 1;
+        *path = memory_pool_alloc(context->arena, size);
+        if (*path == NULL) {
+            return ERROR_OUT_OF_MEMORY;
+        }
+        memcpy(*path, name, size);
+        return stat(name, &st) == 0 ? ERROR_SUCCESS : ERROR_FILE_NOT_FOUND;
+    }
+    
+    for (i = 0; i < context->library_path_count; i++) {
+        size = strlen(context->library_paths[i]) + strlen(name) + sizeof("/lib.star");
+        *path = memory_pool_alloc(context->arena, size);
+        if (*path == NULL) {
+            return ERROR_OUT_OF_MEMORY;
+        }
+        snprintf(*path, size, "%s/lib%s.star", context->library_paths[i], name);
+        if (stat(*path, &st) == 0 && S_ISREG(st.st_mode)) {
+            return ERROR_SUCCESS;
+        }
+        memory_pool_free_sized(context->arena, *path, size);
+    }
+    
+    return ERROR_FILE_NOT_FOUND;
+}
+
+/* Archive and index shared with other links; only the loaded flags are this link's */
+static int open_cached_library(stld_context_t* context, library_t* library) {
+    bool hit;
+    int result;
+    
+    result = object_cache_acquire(context->cache, library->path, CACHE_ENTRY_LIBRARY,
+                                  &library->entry, &hit);
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    library->cache = context->cache;
+    library->archive = library->entry->archive;
+    library->index = library->entry->index;
+    library->loaded = calloc(library->archive->header.member_count + 1U, sizeof(uint8_t));
+    if (library->loaded == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    context->inputs_cached += (size_t)hit;
+    
+    return ERROR_SUCCESS;
+}
+
+/* Map the archive and read its symbol index; member data is read in place */
+static int open_library(stld_context_t* context, const char* name, library_t* library) {
+    char* path = NULL;
+    int result;
+    
+    result = find_library(context, name, &path);
+    if (result == ERROR_FILE_NOT_FOUND) {
+        ERROR_REPORT_ERROR(ERROR_FILE_NOT_FOUND, "Library not found");
+    }
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    library->path = path;
+    if (context->cache != NULL) {
+        return open_cached_library(context, library);
+    }
+    
+    library->archive = archive_map(path);
+    if (library->archive == NULL) {
+        ERROR_REPORT_ERROR(ERROR_ARCHIVE_CORRUPT, "Library is not a STAR archive");
+        return ERROR_ARCHIVE_CORRUPT;
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        library->index = symbol_index_create(0);
+        library->loaded = calloc(library->archive->header.member_count + 1U, sizeof(uint8_t));
+        if (library->index == NULL || library->loaded == NULL) {
+            result = ERROR_OUT_OF_MEMORY;
+        }
+    }
+    if (result == ERROR_SUCCESS) {
+        result = symbol_index_load_from_archive(library->index, library->archive);
+    }
+    
+    return result;
+}
+
+static void close_library(library_t* library) {
+    if (library->entry != NULL) {
+        object_cache_release(library->cache, library->entry);
+    } else {
+        archive_close(library->archive);
+        symbol_index_destroy(library->index);
+    }
+    free(library->loaded);
+}
+
+static bool name_defined(const library_state_t* state, const char* name, uint32_t hash) {
+    size_t index = hash & state->defined_mask;
+    
+    while (state->defined[index] != NULL) {
+        if (state->defined_hashes[index] == hash && strcmp(state->defined[index], name) == 0) {
+            return true;
+        }
+        index = (index + 1) & state->defined_mask;
+    }
+    
+    return false;
+}
+
+/* Record a definition; the set is rebuilt at twice the size when half full */
+static int define_name(library_state_t* state, const char* name, uint32_t hash) {
+    size_t index;
+    size_t i;
+    
+    if (name_defined(state, name, hash)) {
+        return ERROR_SUCCESS;
+    }
+    
+    if ((state->defined_count + 1) * 2 > state->defined_mask + 1) {
+        size_t capacity = (state->defined_mask + 1) * 2;
+        const char** names = calloc(capacity, sizeof(const char*));
+        uint32_t* hashes = malloc(capacity * sizeof(uint32_t));
+        
+        if (names == NULL || hashes == NULL) {
+            free(names);
+            free(hashes);
+            ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to grow definition set");
+            return ERROR_OUT_OF_MEMORY;
+        }
+        
+        for (i = 0; i <= state->defined_mask; i++) {
+            if (state->defined[i] != NULL) {
+                index = state->defined_hashes[i] & (capacity - 1);
+                while (names[index] != NULL) {
+                    index = (index + 1) & (capacity - 1);
+                }
+                names[index] = state->defined[i];
+                hashes[index] = state->defined_hashes[i];
+            }
+        }
+        
+        free(state->defined);
+        free(state->defined_hashes);
+        state->defined = names;
+        state->defined_hashes = hashes;
+        state->defined_mask = capacity - 1;
+    }
+    
+    index = hash & state->defined_mask;
+    while (state->defined[index] != NULL) {
+        index = (index + 1) & state->defined_mask;
+    }
+    state->defined[index] = name;
+    state->defined_hashes[index] = hash;
+    state->defined_count++;
+    
+    return ERROR_SUCCESS;
+}
+
+static int add_pending(library_state_t* state, const char* name, uint32_t hash) {
+    if (state->pending_count == state->pending_capacity) {
+        size_t capacity = state->pending_capacity * 2;
+        pending_reference_t* pending = realloc(state->pending,
+                                               capacity * sizeof(pending_reference_t));
+        
+        if (pending == NULL) {
+            ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to grow reference worklist");
+            return ERROR_OUT_OF_MEMORY;
+        }
+        state->pending = pending;
+        state->pending_capacity = capacity;
+    }
+    
+    state->pending[state->pending_count++] = (pending_reference_t) {
+        .name = name,
+        .hash = hash
+    };
+    
+    return ERROR_SUCCESS;
+}
+
+/*
+ * Add an input's global definitions and strong undefined references.
+ * Staged hashes are FNV-1a, the same hash the archive index stores.
+ */
+static int scan_object_symbols(library_state_t* state, const input_object_t* object) {
+    const symbol_t* symbol;
+    uint32_t i;
+    int result = ERROR_SUCCESS;
+    
+    for (i = 0; i < object->layout.symbol_count && result == ERROR_SUCCESS; i++) {
+        symbol = &object->staged_symbols[i];
+        if (symbol->binding == SYMBOL_BINDING_LOCAL) {
+            continue;
+        }
+        
+        if (symbol->section_index != SECTION_INDEX_UNDEFINED) {
+            result = define_name(state, symbol->name, object->staged_hashes[i]);
+        } else if (symbol->binding != SYMBOL_BINDING_WEAK) {
+            result = add_pending(state, symbol->name, object->staged_hashes[i]);
+        }
+    }
+    
+    return result;
+}
+
+/* Copy a member the shared cache has decoded and verified, then parse the copy */
+static int load_cached_member(library_t* library, uint32_t member_index, input_object_t* object) {
+    uint32_t size = library->archive->members[member_index].header.size;
+    void* map;
+    int result;
+    
+    result = object_cache_map_member(library->cache, library->entry, member_index, &map);
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    object->map = map;
+    object->map_size = size;
+    object->file_size = size;
+    
+    return parse_mapped_object(object);
+}
+
+/* Copy one member into an anonymous private mapping and parse it in place */
+static int load_library_member(library_t* library, uint32_t member_index, input_object_t* object) {
+    const star_member_header_t* member = &library->archive->members[member_index].header;
+    const uint8_t* data;
+    void* map;
+    
+    if (member->size < sizeof(smof_header_t)) {
+        return ERROR_CORRUPT_HEADER;
+    }
+    
+    if (library->entry != NULL) {
+        return load_cached_member(library, member_index, object);
+    }
+    
+    data = archive_member_data(library->archive, &library->archive->members[member_index]);
+    if (data == NULL) {
+        ERROR_REPORT_ERROR(ERROR_ARCHIVE_CORRUPT, "Library member lies outside the archive");
+        return ERROR_ARCHIVE_CORRUPT;
+    }
+    
+    map = mmap(NULL, member->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    object->map = map;
+    object->map_size = member->size;
+    object->file_size = member->size;
+    
+    /* A private copy: the parsed object must outlive the library's mapping */
+    if ((member->flags & STAR_MEMBER_FLAG_COMPRESSED) == 0) {
+        memcpy(object->map, data, member->size);
+    } else if (archive_read_member(library->archive, &library->archive->members[member_index],
+                                   object->map) != ERROR_SUCCESS) {
+        ERROR_REPORT_ERROR(ERROR_DECOMPRESSION_FAILED, "Failed to decompress library member");
+        return ERROR_DECOMPRESSION_FAILED;
+    }
+    
+    if (crc32_calculate(object->map, object->map_size) != member->checksum) {
+        ERROR_REPORT_ERROR(ERROR_ARCHIVE_CORRUPT, "Library member checksum mismatch");
+        return ERROR_ARCHIVE_CORRUPT;
+    }
+    
+    return parse_mapped_object(object);
+}
+
+/* Append an input named filename, with a zeroed object for it */
+static int append_input_object(stld_context_t* context, const char* filename) {
+    input_object_t* objects;
+    
+    if (context->input_file_count == context->object_capacity) {
+        size_t capacity = context->object_capacity > 0 ? context->object_capacity * 2 : 8;
+        
+        objects = memory_pool_calloc(context->arena, capacity, sizeof(input_object_t));
+        if (objects == NULL) {
+            ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to expand input objects");
+            return ERROR_OUT_OF_MEMORY;
+        }
+        if (context->input_file_count > 0) {
+            memcpy(objects, context->objects, context->input_file_count * sizeof(input_object_t));
+            memory_pool_free_sized(context->arena, context->objects,
+                                   context->object_capacity * sizeof(input_object_t));
+        }
+        context->objects = objects;
+        context->object_capacity = capacity;
+    }
+    
+    return stld_add_input_file(context, filename);
+}
+
+/* Append a member as the next input, named archive(member) in diagnostics */
+static int add_library_object(stld_context_t* context, library_t* library, uint32_t member_index) {
+    const archive_member_t* member = &library->archive->members[member_index];
+    input_object_t* object;
+    trace_span_t span;
+    char* label;
+    size_t size;
+    int result;
+    
+    size = strlen(library->path) + strlen(member->name != NULL ? member->name : "") + 3;
+    label = malloc(size);
+    if (label == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    snprintf(label, size, "%s(%s)", library->path, member->name != NULL ? member->name : "");
+    result = append_input_object(context, label);
+    free(label);
+    
+    if (result == ERROR_SUCCESS) {
+        TRACE_BEGIN(span, "load_member");
+        object = &context->objects[context->input_file_count - 1];
+        result = load_library_member(library, member_index, object);
+        if (result == ERROR_SUCCESS && context->options.incremental) {
+            fingerprint_object(object);
+        }
+        TRACE_END(span, context->input_files[context->input_file_count - 1]);
+    }
+    if (result == ERROR_SUCCESS) {
+        context->members_loaded++;
+    }
+    
+    return result;
+}
+
+/* Pull in the member that defines reference, searching libraries in link order */
+static int resolve_reference(stld_context_t* context, library_state_t* state,
+                             const pending_reference_t* reference) {
+    const symbol_index_entry_t* entry;
+    library_t* library;
+    size_t i;
+    int result;
+    
+    for (i = 0; i < state->library_count; i++) {
+        library = &state->libraries[i];
+        entry = symbol_index_find_symbol_hash(library->index, reference->name, reference->hash);
+        if (entry == NULL || entry->member_index >= library->archive->header.member_count ||
+            library->loaded[entry->member_index]) {
+            continue;
+        }
+        
+        library->loaded[entry->member_index] = 1;
+        result = add_library_object(context, library, entry->member_index);
+        if (result == ERROR_SUCCESS) {
+            result = scan_object_symbols(state, &context->objects[context->input_file_count - 1]);
+        }
+        return result;
+    }
+    
+    /* Still undefined; relocation reports it if anything uses it */
+    return ERROR_SUCCESS;
+}
+
+/*
+ * Load only the archive members that define a currently undefined strong
+ * reference, repeating for the references those members add until none
+ * can be resolved. Lookups go through each archive's symbol index, so
+ * members that are not needed are never read.
+ */
+static int resolve_libraries(stld_context_t* context) {
+    library_state_t state;
+    size_t opened = 0;
+    size_t i;
+    int result = ERROR_SUCCESS;
+    
+    if (context->library_count == 0) {
+        return ERROR_SUCCESS;
+    }
+    
+    state = (library_state_t) {
+        .libraries = calloc(context->library_count, sizeof(library_t)),
+        .library_count = context->library_count,
+        .defined = calloc(64, sizeof(const char*)),
+        .defined_hashes = malloc(64 * sizeof(uint32_t)),
+        .defined_mask = 63,
+        .pending = malloc(64 * sizeof(pending_reference_t)),
+        .pending_capacity = 64
+    };
+    if (state.libraries == NULL || state.defined == NULL || state.defined_hashes == NULL ||
+        state.pending == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate library state");
+        result = ERROR_OUT_OF_MEMORY;
+    }
+    
+    for (i = 0; i < context->library_count && result == ERROR_SUCCESS; i++) {
+        opened++;
+        result = open_library(context, context->libraries[i], &state.libraries[i]);
+    }
+    
+    for (i = 0; i < context->input_file_count && result == ERROR_SUCCESS; i++) {
+        result = scan_object_symbols(&state, &context->objects[i]);
+    }
+    
+    for (i = 0; i < state.pending_count && result == ERROR_SUCCESS; i++) {
+        if (!name_defined(&state, state.pending[i].name, state.pending[i].hash)) {
+            result = resolve_reference(context, &state, &state.pending[i]);
+        }
+    }
+    
+    for (i = 0; i < opened; i++) {
+        close_library(&state.libraries[i]);
+    }
+    free(state.libraries);
+    free(state.defined);
+    free(state.defined_hashes);
+    free(state.pending);
+    
+    return result == ERROR_SUCCESS ? check_memory_limit(context) : result;
+}
+
+static int merge_input_symbols(stld_context_t* context) {
+    trace_span_t span;
+    size_t i;
+    int result = ERROR_SUCCESS;
+    
+    for (i = 0; i < context->input_file_count && result == ERROR_SUCCESS; i++) {
+        TRACE_BEGIN(span, "merge_symbols");
+        result = merge_smof_symbols(context, &context->objects[i]);
+        TRACE_END(span, context->input_files[i]);
+    }
+    
+    return result;
+}
+
+/* Symbol resolution function */
+static symbol_handle_t find_symbol(const stld_context_t* context, const char* name) __attribute__((unused));
+static symbol_handle_t find_symbol(const stld_context_t* context, const char* name) {
+    return symbol_table_lookup(context->symbols, name);
+}
+
+/* SMOF fields hold no addend; PC-relative fields are relative to their end */
+static int32_t implicit_addend(relocation_type_t type) {
+    return relocation_type_is_pc_relative(type) ? -(int32_t)relocation_type_width(type) : 0;
+}
+
+/*
+ * A relocatable output is linked again, so a field stays in its table
+ * unless its value can no longer change: a PC-relative reference to a
+ * symbol defined in the same output section, which moves as a unit.
+ */
+static bool relocation_final(const stld_context_t* context, const relocation_entry_t* entry,
+                             const section_t* output) {
+    return relocation_type_is_pc_relative(entry->type) &&
+           symbol_table_get_section_index(context->symbols, entry->symbol_handle) ==
+           output->layout_index;
+}
+
+/* Record a relocation for the output, relative to its output section */
+static int keep_relocation(stld_context_t* context, const input_object_t* object,
+                           const smof_relocation_v2_t* reloc, symbol_handle_t handle) {
+    const section_t* output = section_manager_get_section(
+        context->sections, object->output_sections[reloc->section_index]);
+    
+    /* The output picks a header version whose tables hold every index */
+    context->kept_relocations[context->relocations_kept++] = (output_relocation_t) {
+        .offset = reloc->offset + object->section_addresses[reloc->section_index] -
+                  output->address,
+        .symbol = handle,
+        .type = reloc->type,
+        .section = output->layout_index
+    };
+    
+    return ERROR_SUCCESS;
+}
+
+/*
+ * Register an object's sections and queue its relocations. For a
+ * relocatable output, references to undefined symbols are only kept; the
+ * rest are applied, so the output is also correct where it was laid out.
+ */
+static int queue_object_relocations(stld_context_t* context, const input_object_t* object) {
+    const smof_section_t* sections = object_sections(object);
+    const smof_relocation_v2_t* reloc;
+    const section_t* output;
+    relocation_entry_t entry;
+    bool relocatable = output_is_relocatable(&context->options);
+    uint32_t i;
+    int result;
+    
+    for (i = 0; i < object->layout.section_count; i++) {
+        bool zero_fill = (sections[i].flags & SMOF_SECT_ZERO_FILL) != 0;
+        
+        if (!input_section_live(context, object, i) || input_section_folded(context, object, i)) {
+            continue;
+        }
+        
+        result = relocation_engine_set_section(context->relocations, object->first_section + i,
+                                               zero_fill ? NULL : object->map + sections[i].file_offset,
+                                               sections[i].size, object->section_addresses[i]);
+        if (result != ERROR_SUCCESS) {
+            return result;
+        }
+    }
+    
+    for (i = 0; i < object->layout.reloc_count; i++) {
+        reloc = &object->relocations[i];
+        
+        if (reloc->section_index >= object->layout.section_count) {
+            ERROR_REPORT_ERROR(ERROR_INVALID_RELOCATION, "Relocation against missing section");
+            return ERROR_INVALID_RELOCATION;
+        }
+        
+        /* Collected and folded sections are never patched */
+        if (!input_section_live(context, object, reloc->section_index) ||
+            input_section_folded(context, object, reloc->section_index)) {
+            continue;
+        }
+        
+        /* Map the file-local index to its global symbol */
+        entry = (relocation_entry_t) {
+            .offset = reloc->offset,
+            .type = (relocation_type_t)reloc->type,
+            .symbol_handle = reloc->symbol_index < object->symbol_count ?
+                             object->symbol_map[reloc->symbol_index] : SYMBOL_HANDLE_INVALID,
+            .addend = implicit_addend((relocation_type_t)reloc->type),
+            .section_id = object->first_section + reloc->section_index
+        };
+        
+        if (relocatable && entry.symbol_handle != SYMBOL_HANDLE_INVALID) {
+            output = section_manager_get_section(
+                context->sections, object->output_sections[reloc->section_index]);
+            if (!relocation_final(context, &entry, output)) {
+                result = keep_relocation(context, object, reloc, entry.symbol_handle);
+                if (result != ERROR_SUCCESS) {
+                    return result;
+                }
+            }
+            
+            /* The GOT is built by the final link */
+            if (entry.type == RELOC_TYPE_GOT ||
+                symbol_table_get_section_index(context->symbols, entry.symbol_handle) ==
+                SECTION_INDEX_UNDEFINED) {
+                continue;
+            }
+        }
+        
+        if (relocation_engine_add_entry(context->relocations, &entry) == RELOCATION_ID_INVALID) {
+            return ERROR_INVALID_RELOCATION;
+        }
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+static int compare_output_relocations(const void* a, const void* b) {
+    const output_relocation_t* left = a;
+    const output_relocation_t* right = b;
+    
+    if (left->section != right->section) {
+        return left->section < right->section ? -1 : 1;
+    }
+    if (left->offset != right->offset) {
+        return left->offset < right->offset ? -1 : 1;
+    }
+    if (left->type != right->type) {
+        return left->type < right->type ? -1 : 1;
+    }
+    if (left->symbol != right->symbol) {
+        return left->symbol < right->symbol ? -1 : 1;
+    }
+    return 0;
+}
+
+/* Order the kept relocations by section and offset and drop repeats */
+static void sort_kept_relocations(stld_context_t* context) {
+    output_relocation_t* kept = context->kept_relocations;
+    size_t count = 0;
+    size_t i;
+    
+    if (context->relocations_kept == 0) {
+        return;
+    }
+    
+    qsort(kept, context->relocations_kept, sizeof(output_relocation_t),
+          compare_output_relocations);
+    for (i = 1; i < context->relocations_kept; i++) {
+        if (compare_output_relocations(&kept[count], &kept[i]) != 0) {
+            kept[++count] = kept[i];
+        }
+    }
+    context->relocations_kept = count + 1;
+}
+
+/* Room for every input relocation a relocatable output may keep */
+static int allocate_kept_relocations(stld_context_t* context) {
+    size_t total = 0;
+    size_t i;
+    
+    context->kept_relocations = NULL;
+    context->relocations_kept = 0;
+    if (!output_is_relocatable(&context->options)) {
+        return ERROR_SUCCESS;
+    }
+    
+    for (i = 0; i < context->input_file_count; i++) {
+        total += context->objects[i].layout.reloc_count;
+    }
+    
+    if (total > 0) {
+        context->kept_relocations = memory_pool_alloc(context->arena,
+                                                      total * sizeof(output_relocation_t));
+        if (context->kept_relocations == NULL) {
+            ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate output relocations");
+            return ERROR_OUT_OF_MEMORY;
+        }
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+/* Copy the slots the relocation pass handed out into the reserved GOT */
+static int fill_got(stld_context_t* context) {
+    const uint32_t* got;
+    size_t count;
+    size_t i;
+    
+    got = relocation_engine_get_got(context->relocations, &count);
+    if (count > context->got_slots) {
+        ERROR_REPORT_ERROR(ERROR_INVALID_RELOCATION, "GOT relocation without a reserved slot");
+        return ERROR_INVALID_RELOCATION;
+    }
+    
+    /* Output words are little-endian */
+    for (i = 0; i < count; i++) {
+        context->got_data[i * 4] = (uint8_t)got[i];
+        context->got_data[i * 4 + 1] = (uint8_t)(got[i] >> 8);
+        context->got_data[i * 4 + 2] = (uint8_t)(got[i] >> 16);
+        context->got_data[i * 4 + 3] = (uint8_t)(got[i] >> 24);
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+/* Relocation processing function */
+static int process_relocations(stld_context_t* context) {
+    trace_span_t span;
+    size_t i;
+    int result;
+    
+    if (context->relocations == NULL) {
+        context->relocations = relocation_engine_create(context->symbols);
+        if (context->relocations == NULL) {
+            return ERROR_OUT_OF_MEMORY;
+        }
+    }
+    relocation_engine_clear(context->relocations);
+    result = allocate_kept_relocations(context);
+    
+    /* Multi-object links apply each section's relocations on the pool */
+    if (context->input_file_count > 1) {
+        relocation_engine_set_thread_pool(context->relocations, get_thread_pool(context));
+    }
+    if (context->got_slots > 0) {
+        relocation_engine_set_got_address(
+            context->relocations,
+            section_manager_get_section(context->sections, context->got_section)->address +
+            context->got_offset);
+    }
+    
+    for (i = 0; i < context->input_file_count && result == ERROR_SUCCESS; i++) {
+        if (!context->objects[i].reused) {
+            TRACE_BEGIN(span, "queue_relocations");
+            result = queue_object_relocations(context, &context->objects[i]);
+            TRACE_END(span, context->input_files[i]);
+        }
+    }
+    
+    /* Patches land in the private input mappings */
+    if (result == ERROR_SUCCESS) {
+        TRACE_BEGIN(span, "apply_relocations");
+        result = relocation_engine_process_all(context->relocations);
+        TRACE_END(span, NULL);
+    }
+    if (result == ERROR_SUCCESS) {
+        result = fill_got(context);
+    }
+    sort_kept_relocations(context);
+    
+    context->relocations_processed = relocation_engine_get_count(context->relocations);
+    
+    return result;
+}
+
+static uint16_t output_file_flags(const stld_options_t* options) {
+    uint16_t flags = SMOF_FLAG_LITTLE_ENDIAN;
+    
+    switch (options->output_type) {
+        case STLD_OUTPUT_EXECUTABLE:
+            flags |= SMOF_FLAG_EXECUTABLE | SMOF_FLAG_STATIC;
+            break;
+        case STLD_OUTPUT_SHARED_LIBRARY:
+            flags |= SMOF_FLAG_SHARED_LIB;
+            break;
+        default:
+            break;
+    }
+    
+    if (options->position_independent) {
+        flags |= SMOF_FLAG_POSITION_INDEP;
+    }
+    if (options->strip_debug) {
+        flags |= SMOF_FLAG_STRIPPED;
+    }
+    
+    return flags;
+}
+
+/*
+ * -e wins, then the script's ENTRY symbol, then the start of the image.
+ * Relocatable outputs have an entry point only when -e gives one.
+ */
+static uint32_t output_entry_point(const stld_context_t* context) {
+    const char* entry = linker_script_get_entry(context->script);
+    symbol_handle_t handle;
+    
+    if (context->options.entry_point != 0 || output_is_relocatable(&context->options)) {
+        return context->options.entry_point;
+    }
+    
+    handle = entry != NULL ? symbol_table_lookup(context->symbols, entry) : SYMBOL_HANDLE_INVALID;
+    if (handle != SYMBOL_HANDLE_INVALID &&
+        symbol_table_get_section_index(context->symbols, handle) != SECTION_INDEX_UNDEFINED) {
+        return symbol_table_get_value(context->symbols, handle);
+    }
+    
+    return context->options.base_address;
+}
+
+/*
+ * Stream the output sections in layout order. Their fragments point into
+ * the private input mappings, where relocations have already been
+ * applied, so the image is never assembled in memory.
+ */
+static int write_output(stld_context_t* context, const char* output_file) {
+    const stld_options_t* options = &context->options;
+    output_generator_t* generator;
+    output_config_t config;
+    trace_span_t span;
+    const section_id_t* layout;
+    size_t count;
+    size_t size = 0;
+    size_t i;
+    int result = ERROR_SUCCESS;
+    
+    generator = output_generator_create(context->symbols);
+    if (generator == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    config = (output_config_t) {
+        .type = options->output_type == STLD_OUTPUT_BINARY_FLAT ?
+                OUTPUT_TYPE_BINARY_FLAT : OUTPUT_TYPE_SMOF,
+        .base_address = options->base_address,
+        .entry_point = output_entry_point(context),
+        .file_flags = output_file_flags(options),
+        .fill_gaps = options->fill_gaps,
+        .fill_value = options->fill_value
+    };
+    output_generator_configure(generator, &config);
+    result = output_generator_set_relocations(generator, context->kept_relocations,
+                                              context->relocations_kept);
+    
+    layout = section_manager_get_layout(context->sections, &count);
+    for (i = 0; i < count && result == ERROR_SUCCESS; i++) {
+        result = output_generator_add_merged_section(
+            generator, section_manager_get_section(context->sections, layout[i]));
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        size = output_generator_calculate_size(generator);
+        if (options->max_file_size != 0 && size > options->max_file_size) {
+            ERROR_REPORT_ERROR(ERROR_OUTPUT_TOO_LARGE, "Output exceeds maximum file size");
+            result = ERROR_OUTPUT_TOO_LARGE;
+        }
+    }
+    
+    /* The link cache records where each section's bytes went */
+    context->output_offsets = NULL;
+    if (result == ERROR_SUCCESS && options->incremental && count > 0) {
+        context->output_offsets = memory_pool_alloc(context->arena, count * sizeof(uint32_t));
+        if (context->output_offsets == NULL) {
+            ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate output offsets");
+            result = ERROR_OUT_OF_MEMORY;
+        }
+        for (i = 0; i < count && result == ERROR_SUCCESS; i++) {
+            if (!output_generator_get_file_offset(generator, i, &context->output_offsets[i])) {
+                context->output_offsets[i] = LINK_CACHE_NO_DATA;
+            }
+        }
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        TRACE_BEGIN(span, "write_output");
+        result = output_generator_generate_to_file(generator, output_file);
+        context->output_size = result == ERROR_SUCCESS ? size : 0;
+        TRACE_END(span, output_file);
+    }
+    
+    output_generator_destroy(generator);
+    
+    return result;
+}
+
+/* One map entry per input section that was placed; folded copies are not */
+static int write_map_file(stld_context_t* context, const char* output_file) {
+    const input_object_t* object;
+    const smof_section_t* sections;
+    const section_t* output;
+    const char* filename = context->options.map_file;
+    map_input_t* inputs = NULL;
+    size_t input_count = 0;
+    size_t length;
+    char* path;
+    size_t i;
+    uint32_t j;
+    
+    if (filename == NULL) {
+        length = strlen(output_file);
+        path = memory_pool_alloc(context->arena, length + sizeof(MAP_FILE_SUFFIX));
+        if (path == NULL) {
+            return ERROR_OUT_OF_MEMORY;
+        }
+        memcpy(path, output_file, length);
+        memcpy(path + length, MAP_FILE_SUFFIX, sizeof(MAP_FILE_SUFFIX));
+        filename = path;
+    }
+    
+    if (context->section_count > 0) {
+        inputs = memory_pool_alloc(context->arena, context->section_count * sizeof(map_input_t));
+        if (inputs == NULL) {
+            ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate map entries");
+            return ERROR_OUT_OF_MEMORY;
+        }
+    }
+    
+    for (i = 0; i < context->input_file_count; i++) {
+        object = &context->objects[i];
+        sections = object_sections(object);
+        for (j = 0; j < object->layout.section_count; j++) {
+            if (!input_section_live(context, object, j) || input_section_folded(context, object, j)) {
+                continue;
+            }
+            output = section_manager_get_section(context->sections, object->output_sections[j]);
+            inputs[input_count++] = (map_input_t) {
+                .file = context->input_files[i],
+                .name = object->strings + sections[j].name_offset,
+                .address = object->section_addresses[j],
+                .size = sections[j].size,
+                .output_index = output->layout_index
+            };
+        }
+    }
+    
+    return map_file_write(filename, output_file, context->sections, context->symbols,
+                          inputs, input_count);
+}
+
+static bool incremental_enabled(const stld_context_t* context) {
+    const stld_options_t* options = &context->options;
+    
+    /*
+     * Collection and folding depend on every input, so they relink fully,
+     * and patching leaves a relocatable output's relocation table stale.
+     */
+    return options->incremental && !gc_enabled(options) && !fold_enabled(options) &&
+           !output_is_relocatable(options);
+}
+
+static uint32_t options_fingerprint(const stld_options_t* options) {
+    uint32_t fields[11];
+    
+    fields[0] = (uint32_t)options->output_type;
+    fields[1] = options->entry_point;
+    fields[2] = options->base_address;
+    fields[3] = (uint32_t)options->optimize;
+    fields[4] = options->strip_debug;
+    fields[5] = options->position_independent;
+    fields[6] = options->fill_gaps;
+    fields[7] = options->fill_value;
+    fields[8] = options->page_size;
+    fields[9] = options->gc_sections;
+    fields[10] = options->fold_identical;
+    
+    return crc32_calculate(fields, sizeof(fields));
+}
+
+/* CRC32 of a whole file */
+static int file_checksum(const char* filename, uint32_t* crc) {
+    uint8_t buffer[4096];
+    size_t size;
+    FILE* file;
+    int result;
+    
+    file = fopen(filename, "rb");
+    if (file == NULL) {
+        return ERROR_FILE_NOT_FOUND;
+    }
+    
+    *crc = CRC32_INITIAL;
+    while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        *crc = crc32_update(*crc, buffer, size);
+    }
+    result = ferror(file) ? ERROR_FILE_IO : ERROR_SUCCESS;
+    fclose(file);
+    
+    return result;
+}
+
+/*
+ * Fingerprint what the link reads besides its named inputs: each library
+ * by its resolved path, file identity, size and modification time, and
+ * the script by its contents. Any change relinks fully, so the members a
+ * cached link pulled in are the ones this link would pull in.
+ */
+static int dependency_fingerprint(stld_context_t* context, uint32_t* hash) {
+    struct stat st;
+    uint64_t fields[4];
+    uint32_t script_crc;
+    char* path;
+    uint32_t crc = CRC32_INITIAL;
+    size_t i;
+    int result;
+    
+    for (i = 0; i < context->library_count; i++) {
+        result = find_library(context, context->libraries[i], &path);
+        if (result != ERROR_SUCCESS) {
+            return result;
+        }
+        if (stat(path, &st) != 0) {
+            return ERROR_FILE_NOT_FOUND;
+        }
+        
+        fields[0] = (uint64_t)st.st_dev;
+        fields[1] = (uint64_t)st.st_ino;
+        fields[2] = (uint64_t)st.st_size;
+        fields[3] = (uint64_t)stat_mtime(&st);
+        crc = crc32_string(crc, path);
+        crc = crc32_update(crc, fields, sizeof(fields));
+    }
+    
+    if (context->options.script_file != NULL) {
+        result = file_checksum(context->options.script_file, &script_crc);
+        if (result != ERROR_SUCCESS) {
+            return result;
+        }
+        crc = crc32_update(crc, &script_crc, sizeof(script_crc));
+    }
+    
+    *hash = crc;
+    return ERROR_SUCCESS;
+}
+
+static char* link_cache_filename(stld_context_t* context, const char* output_file) {
+    size_t length = strlen(output_file);
+    char* filename;
+    
+    filename = memory_pool_alloc(context->arena, length + sizeof(LINK_CACHE_SUFFIX));
+    if (filename != NULL) {
+        memcpy(filename, output_file, length);
+        memcpy(filename + length, LINK_CACHE_SUFFIX, sizeof(LINK_CACHE_SUFFIX));
+    }
+    
+    return filename;
+}
+
+/* Output file offset of an input section's bytes after a full link */
+static uint32_t input_file_offset(const stld_context_t* context, const input_object_t* object,
+                                  uint32_t index) {
+    const smof_section_t* sections = object_sections(object);
+    const section_t* output;
+    uint32_t offset;
+    
+    /* Sections a script discards are never patched */
+    if ((sections[index].flags & SMOF_SECT_ZERO_FILL) != 0 || sections[index].size == 0 ||
+        !input_section_live(context, object, index)) {
+        return LINK_CACHE_NO_DATA;
+    }
+    
+    output = section_manager_get_section(context->sections, object->output_sections[index]);
+    offset = context->output_offsets[output->layout_index];
+    if (offset == LINK_CACHE_NO_DATA) {
+        return LINK_CACHE_NO_DATA;
+    }
+    
+    return offset + (object->section_addresses[index] - output->address);
+}
+
+/* Record a finished full link for the next incremental one */
+static int save_link_cache(stld_context_t* context, const char* output_file) {
+    const input_object_t* object;
+    link_cache_t cache;
+    symbol_t symbol;
+    struct stat st;
+    char* filename;
+    size_t count = symbol_table_size(context->symbols);
+    size_t i;
+    uint32_t j;
+    uint32_t dependency_hash;
+    int result;
+    
+    filename = link_cache_filename(context, output_file);
+    if (filename == NULL || stat(output_file, &st) != 0) {
+        return ERROR_FILE_IO;
+    }
+    result = dependency_fingerprint(context, &dependency_hash);
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    result = link_cache_init(&cache, (uint32_t)context->input_file_count,
+                             context->section_count, (uint32_t)count);
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    cache.header.options_hash = options_fingerprint(&context->options);
+    cache.header.dependency_hash = dependency_hash;
+    cache.header.member_count = (uint32_t)(context->input_file_count -
+                                           context->named_input_count);
+    cache.header.output_size = context->output_size;
+    cache.header.output_mtime = stat_mtime(&st);
+    
+    for (i = 0; i < context->input_file_count && result == ERROR_SUCCESS; i++) {
+        object = &context->objects[i];
+        cache.inputs[i] = (link_cache_input_t) {
+            .file_size = object->file_size,
+            .mtime = object->mtime,
+            .checksum = object->checksum,
+            .signature = object->signature,
+            .first_section = object->first_section,
+            .section_count = object->layout.section_count
+        };
+        result = link_cache_add_string(&cache, context->input_files[i],
+                                       &cache.inputs[i].path_offset);
+        
+        for (j = 0; j < object->layout.section_count; j++) {
+            cache.sections[object->first_section + j] = (link_cache_section_t) {
+                .address = object->section_addresses[j],
+                .file_offset = input_file_offset(context, object, j)
+            };
+        }
+    }
+    
+    for (i = 0; i < count && result == ERROR_SUCCESS; i++) {
+        symbol_table_get(context->symbols, (symbol_handle_t)i, &symbol);
+        cache.symbols[i] = (link_cache_symbol_t) {
+            .value = symbol.value,
+            .size = symbol.size,
+            .section_index = symbol.section_index,
+            .type = (uint8_t)symbol.type,
+            .binding = (uint8_t)symbol.binding
+        };
+        result = link_cache_add_string(&cache, symbol.name, &cache.symbols[i].name_offset);
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        result = link_cache_write(&cache, filename);
+    }
+    link_cache_release(&cache);
+    
+    return result;
+}
+
+/* Incremental link state shared with the refresh tasks */
+typedef struct incremental_state {
+    stld_context_t* context;
+    link_cache_t cache;
+} incremental_state_t;
+
+/*
+ * An input whose size and modification time match the cache is reused
+ * without being opened. Anything else is parsed; it is still reused when
+ * its checksum shows the contents did not change. Library members are
+ * covered by the dependency fingerprint and always reused.
+ */
+static int refresh_input_task(void* user_data, size_t index) {
+    incremental_state_t* state = user_data;
+    input_object_t* object = &state->context->objects[index];
+    const link_cache_input_t* cached = &state->cache.inputs[index];
+    struct stat st;
+    int result;
+    
+    if (index >= state->context->named_input_count) {
+        object->reused = true;
+        return ERROR_SUCCESS;
+    }
+    
+    if (stat(state->context->input_files[index], &st) == 0 &&
+        (uint64_t)st.st_size == cached->file_size && stat_mtime(&st) == cached->mtime) {
+        object->reused = true;
+        return ERROR_SUCCESS;
+    }
+    
+    result = parse_smof_file(object, state->context->input_files[index], state->context->cache);
+    if (result == ERROR_SUCCESS) {
+        fingerprint_object(object);
+        object->reused = object->checksum == cached->checksum;
+    }
+    
+    return result;
+}
+
+/* The cache must describe this exact link and an untouched output */
+static bool cache_matches(stld_context_t* context, const link_cache_t* cache,
+                          const char* output_file) {
+    const char* path;
+    struct stat st;
+    uint32_t dependency_hash;
+    size_t i;
+    
+    if (cache->header.options_hash != options_fingerprint(&context->options) ||
+        cache->header.input_count - cache->header.member_count != context->input_file_count ||
+        stat(output_file, &st) != 0 || (uint64_t)st.st_size != cache->header.output_size ||
+        stat_mtime(&st) != cache->header.output_mtime ||
+        dependency_fingerprint(context, &dependency_hash) != ERROR_SUCCESS ||
+        dependency_hash != cache->header.dependency_hash) {
+        return false;
+    }
+    
+    for (i = 0; i < context->input_file_count; i++) {
+        path = link_cache_get_string(cache, cache->inputs[i].path_offset);
+        if (strcmp(path, context->input_files[i]) != 0) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+/* Re-add the library members the cached link pulled in, after the named inputs */
+static int restore_cached_members(stld_context_t* context, const link_cache_t* cache) {
+    const char* label;
+    uint32_t i;
+    int result = ERROR_SUCCESS;
+    
+    for (i = (uint32_t)context->input_file_count;
+         i < cache->header.input_count && result == ERROR_SUCCESS; i++) {
+        label = link_cache_get_string(cache, cache->inputs[i].path_offset);
+        result = label != NULL ? append_input_object(context, label) : ERROR_CORRUPT_HEADER;
+    }
+    
+    return result;
+}
+
+/* Whether any of the object's relocations goes through the GOT */
+static bool object_uses_got(const input_object_t* object) {
+    uint32_t i;
+    
+    for (i = 0; i < object->layout.reloc_count; i++) {
+        if (object->relocations[i].type == SMOF_RELOC_GOT) {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+/*
+ * Changed inputs keep the layout only if everything others see is equal.
+ * The cache has no GOT, so one that starts needing it relinks fully.
+ */
+static bool layout_kept(const stld_context_t* context, const link_cache_t* cache) {
+    const input_object_t* object;
+    size_t i;
+    
+    for (i = 0; i < context->input_file_count; i++) {
+        object = &context->objects[i];
+        if (!object->reused && (object->signature != cache->inputs[i].signature ||
+                                object->layout.section_count != cache->inputs[i].section_count ||
+                                object_uses_got(object))) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+/* Rebuild the resolved symbol table and bind a changed input against it */
+static int restore_cached_symbols(stld_context_t* context, const link_cache_t* cache) {
+    const link_cache_symbol_t* cached;
+    symbol_t symbol;
+    uint32_t i;
+    
+    for (i = 0; i < cache->header.symbol_count; i++) {
+        cached = &cache->symbols[i];
+        symbol = (symbol_t) {
+            .name = link_cache_get_string(cache, cached->name_offset),
+            .type = (symbol_type_t)cached->type,
+            .binding = (symbol_binding_t)cached->binding,
+            .visibility = SYMBOL_VISIBILITY_DEFAULT,
+            .section_index = cached->section_index,
+            .value = cached->value,
+            .size = cached->size
+        };
+        if (symbol_table_insert(context->symbols, &symbol) == SYMBOL_HANDLE_INVALID) {
+            return ERROR_INVALID_SYMBOL;
+        }
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+static int bind_changed_object(stld_context_t* context, const link_cache_t* cache,
+                               input_object_t* object, size_t index) {
+    const smof_section_t* sections = object_sections(object);
+    const link_cache_input_t* cached = &cache->inputs[index];
+    uint32_t section_count = object->layout.section_count;
+    uint32_t count = object->layout.symbol_count;
+    symbol_t* symbol;
+    uint32_t i;
+    
+    object->first_section = cached->first_section;
+    object->section_addresses = memory_pool_alloc(context->arena,
+                                                  (section_count > 0 ? section_count : 1) *
+                                                  sizeof(uint32_t));
+    object->symbol_map = memory_pool_alloc(context->arena,
+                                           (count > 0 ? count : 1) * sizeof(symbol_handle_t));
+    if (object->section_addresses == NULL || object->symbol_map == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate section map");
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    for (i = 0; i < section_count; i++) {
+        object->section_addresses[i] = cache->sections[cached->first_section + i].address;
+    }
+    
+    /* Globals resolve as in the full link; locals are rebound here */
+    for (i = 0; i < count; i++) {
+        symbol = &object->staged_symbols[i];
+        object->symbol_map[i] = SYMBOL_HANDLE_INVALID;
+        
+        if (symbol->binding != SYMBOL_BINDING_LOCAL) {
+            object->symbol_map[i] = symbol_table_lookup_hash(context->symbols, symbol->name,
+                                                             object->staged_hashes[i]);
+        } else if (symbol->section_index < section_count) {
+            symbol->value += object->section_addresses[symbol->section_index] -
+                             sections[symbol->section_index].virtual_addr;
+        }
+        
+        if (object->symbol_map[i] == SYMBOL_HANDLE_INVALID) {
+            object->symbol_map[i] = symbol_table_insert_hash(context->symbols, symbol,
+                                                             object->staged_hashes[i]);
+            if (object->symbol_map[i] == SYMBOL_HANDLE_INVALID) {
+                return ERROR_INVALID_SYMBOL;
+            }
+        }
+        object->symbol_count = i + 1;
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+static int pwrite_all(int fd, const uint8_t* data, size_t size, off_t offset) {
+    ssize_t written;
+    
+    while (size > 0) {
+        written = pwrite(fd, data, size, offset);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return ERROR_FILE_IO;
+        }
+        data += written;
+        offset += written;
+        size -= (size_t)written;
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+/* Rewrite the re-patched sections of changed inputs in place */
+static int patch_output(const stld_context_t* context, const link_cache_t* cache,
+                        const char* output_file) {
+    const input_object_t* object;
+    const smof_section_t* sections;
+    uint32_t offset;
+    size_t i;
+    uint32_t j;
+    int result = ERROR_SUCCESS;
+    int fd;
+    
+    fd = open(output_file, O_WRONLY);
+    if (fd < 0) {
+        ERROR_REPORT_ERROR(ERROR_FILE_IO, "Failed to open output for patching");
+        return ERROR_FILE_IO;
+    }
+    
+    for (i = 0; i < context->input_file_count && result == ERROR_SUCCESS; i++) {
+        object = &context->objects[i];
+        if (object->reused) {
+            continue;
+        }
+        
+        sections = object_sections(object);
+        for (j = 0; j < object->layout.section_count && result == ERROR_SUCCESS; j++) {
+            offset = cache->sections[object->first_section + j].file_offset;
+            if (offset != LINK_CACHE_NO_DATA && (sections[j].flags & SMOF_SECT_ZERO_FILL) == 0) {
+                result = pwrite_all(fd, object->map + sections[j].file_offset,
+                                    sections[j].size, (off_t)offset);
+            }
+        }
+    }
+    
+    if (close(fd) != 0 && result == ERROR_SUCCESS) {
+        result = ERROR_FILE_IO;
+    }
+    if (result != ERROR_SUCCESS) {
+        ERROR_REPORT_ERROR(ERROR_FILE_IO, "Failed to patch output");
+    }
+    
+    return result;
+}
+
+/* Record the refreshed inputs and the patched output */
+static int update_link_cache(stld_context_t* context, link_cache_t* cache,
+                             const char* output_file, const char* filename) {
+    const input_object_t* object;
+    struct stat st;
+    size_t i;
+    
+    if (stat(output_file, &st) != 0) {
+        return ERROR_FILE_IO;
+    }
+    cache->header.output_mtime = stat_mtime(&st);
+    
+    for (i = 0; i < context->input_file_count; i++) {
+        object = &context->objects[i];
+        if (object->map != NULL) {
+            cache->inputs[i].file_size = object->file_size;
+            cache->inputs[i].mtime = object->mtime;
+            cache->inputs[i].checksum = object->checksum;
+        }
+    }
+    
+    return link_cache_write(cache, filename);
+}
+
+/*
+ * Relink from the cache next to the output. Inputs that did not change
+ * are neither loaded nor patched. Changed inputs whose signature is
+ * unchanged are re-patched against the cached symbol table and their
+ * sections are rewritten in place in the existing output. Anything else
+ * leaves *linked false, with every input released, for a full link.
+ */
+static int incremental_link(stld_context_t* context, const char* output_file, bool* linked) {
+    incremental_state_t state;
+    thread_pool_t* pool = NULL;
+    const char* filename;
+    size_t i;
+    int result;
+    
+    *linked = false;
+    if (context->options.incremental && !incremental_enabled(context)) {
+        ERROR_REPORT_WARNING(ERROR_INVALID_ARGUMENT,
+                             "--incremental is ignored with section collection, folding or -r");
+    }
+    if (!incremental_enabled(context) || context->input_file_count == 0) {
+        return ERROR_SUCCESS;
+    }
+    
+    filename = link_cache_filename(context, output_file);
+    if (filename == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    state.context = context;
+    if (link_cache_read(&state.cache, filename) != ERROR_SUCCESS) {
+        return ERROR_SUCCESS;
+    }
+    if (!cache_matches(context, &state.cache, output_file)) {
+        link_cache_release(&state.cache);
+        return ERROR_SUCCESS;
+    }
+    if (restore_cached_members(context, &state.cache) != ERROR_SUCCESS) {
+        context->input_file_count = context->named_input_count;
+        link_cache_release(&state.cache);
+        return ERROR_SUCCESS;
+    }
+    
+    if (context->input_file_count > 1) {
+        pool = get_thread_pool(context);
+    }
+    phase_begin(context, STLD_PHASE_LOAD);
+    result = thread_pool_run(pool, context->input_file_count, refresh_input_task, &state);
+    phase_end(context);
+    
+    if (result == ERROR_SUCCESS && layout_kept(context, &state.cache)) {
+        *linked = true;
+        context->section_count = state.cache.header.section_count;
+        context->output_size = (size_t)state.cache.header.output_size;
+        context->relocations_processed = 0;
+        context->relocations_kept = 0;
+        context->inputs_reused = 0;
+        
+        phase_begin(context, STLD_PHASE_RESOLVE);
+        result = restore_cached_symbols(context, &state.cache);
+        for (i = 0; i < context->input_file_count && result == ERROR_SUCCESS; i++) {
+            if (context->objects[i].reused) {
+                context->inputs_reused++;
+            } else {
+                result = bind_changed_object(context, &state.cache, &context->objects[i], i);
+            }
+        }
+        phase_end(context);
+        
+        if (result == ERROR_SUCCESS && context->inputs_reused < context->input_file_count) {
+            phase_begin(context, STLD_PHASE_RELOCATE);
+            result = process_relocations(context);
+            phase_end(context);
+            if (result == ERROR_SUCCESS) {
+                phase_begin(context, STLD_PHASE_WRITE);
+                result = patch_output(context, &state.cache, output_file);
+                phase_end(context);
+            }
+        }
+        
+        if (result == ERROR_SUCCESS) {
+            phase_begin(context, STLD_PHASE_WRITE);
+            result = update_link_cache(context, &state.cache, output_file, filename);
+            phase_end(context);
+        } else {
+            /* The output may be half patched; the next link must be full */
+            unlink(filename);
+        }
+    }
+    
+    /* A full link pulls library members in again */
+    if (!*linked) {
+        for (i = 0; i < context->input_file_count; i++) {
+            release_input_object(&context->objects[i]);
+        }
+        context->input_file_count = context->named_input_count;
+    }
+    link_cache_release(&state.cache);
+    
+    return result;
+}
+
+/* The link pipeline; stld_link times it as a whole */
+static int run_link(stld_context_t* context, const char* output_file) {
+    bool linked;
+    int result;
+    
+    /* Report progress */
+    if (context->progress_callback != NULL) {
+        context->progress_callback("Initializing", 0, context->progress_user_data);
+    }
+    
+    /* Load input files */
+    if (context->progress_callback != NULL) {
+        context->progress_callback("Loading objects", 25, context->progress_user_data);
+    }
+    
+    /* Per-object symbol maps, freed with the context */
+    if (context->objects == NULL && context->input_file_count > 0) {
+        context->objects = memory_pool_calloc(context->arena, context->input_file_count,
+                                              sizeof(input_object_t));
+        if (context->objects == NULL) {
+            ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate input objects");
+            return ERROR_OUT_OF_MEMORY;
+        }
+        context->object_capacity = context->input_file_count;
+    }
+    
+    /* An incremental link only loads and patches what changed */
+    context->named_input_count = context->input_file_count;
+    result = incremental_link(context, output_file, &linked);
+    if (result != ERROR_SUCCESS || linked) {
+        if (result == ERROR_SUCCESS && context->progress_callback != NULL) {
+            context->progress_callback("Complete", 100, context->progress_user_data);
+        }
+        return result;
+    }
+    
+    context->inputs_reused = 0;
+    phase_begin(context, STLD_PHASE_LOAD);
+    if (context->options.script_file != NULL && context->script == NULL) {
+        result = linker_script_load(context->options.script_file, context->arena,
+                                    &context->script);
+    }
+    if (result == ERROR_SUCCESS) {
+        result = load_input_files(context);
+    }
+    phase_end(context);
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    /* Archive members join the inputs before anything is laid out */
+    phase_begin(context, STLD_PHASE_RESOLVE);
+    result = resolve_libraries(context);
+    phase_end(context);
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    /* Drop sections nothing reaches before they are laid out or patched */
+    phase_begin(context, STLD_PHASE_LAYOUT);
+    result = collect_sections(context);
+    if (result == ERROR_SUCCESS) {
+        result = fold_identical_sections(context);
+    }
+    
+    /* Layout sections */
+    if (result == ERROR_SUCCESS && context->progress_callback != NULL) {
+        context->progress_callback("Layout sections", 40, context->progress_user_data);
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        result = layout_sections(context);
+    }
+    phase_end(context);
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    /* Resolve symbols */
+    if (context->progress_callback != NULL) {
+        context->progress_callback("Resolving symbols", 50, context->progress_user_data);
+    }
+    
+    phase_begin(context, STLD_PHASE_RESOLVE);
+    result = merge_input_symbols(context);
+    phase_end(context);
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    /* Apply relocations */
+    if (context->progress_callback != NULL) {
+        context->progress_callback("Applying relocations", 75, context->progress_user_data);
+    }
+    
+    phase_begin(context, STLD_PHASE_RELOCATE);
+    result = process_relocations(context);
+    phase_end(context);
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    /* Write output */
+    if (context->progress_callback != NULL) {
+        context->progress_callback("Writing output", 90, context->progress_user_data);
+    }
+    
+    phase_begin(context, STLD_PHASE_WRITE);
+    result = write_output(context, output_file);
+    
+    /* An incremental relink keeps this layout, so its map stays valid */
+    if (result == ERROR_SUCCESS && context->options.generate_map) {
+        result = write_map_file(context, output_file);
+    }
+    
+    /*
+     * A stale cache is rejected by its output fingerprint, so failure is
+     * harmless. Patching cannot grow the GOT, so links with one relink fully.
+     */
+    if (result == ERROR_SUCCESS && incremental_enabled(context) && context->got_slots == 0) {
+        save_link_cache(context, output_file);
+    }
+    phase_end(context);
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    if (context->progress_callback != NULL) {
+        context->progress_callback("Complete", 100, context->progress_user_data);
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+int stld_link(stld_context_t* context, const char* output_file) {
+    struct timespec start;
+    int result;
+    
+    if (context == NULL || output_file == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    memset(context->phases, 0, sizeof(context->phases));
+    context->inputs_cached = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    result = run_link(context, output_file);
+    context->link_time = elapsed_seconds(&start);
+    
+    return result;
+}
+
+int stld_get_stats(const stld_context_t* context, stld_stats_t* stats) {
+    size_t i;
+    
+    if (context == NULL || stats == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    /* Fill in actual statistics */
+    stats->input_files = context->input_file_count;
+    stats->total_sections = context->section_count;
+    stats->sections_removed = context->sections_removed;
+    stats->sections_folded = context->sections_folded;
+    stats->inputs_reused = context->inputs_reused;
+    stats->members_loaded = context->members_loaded;
+    stats->inputs_cached = context->inputs_cached;
+    stats->total_symbols = symbol_table_size(context->symbols);
+    stats->relocations_processed = context->relocations_processed;
+    stats->relocations_kept = context->relocations_kept;
+    stats->output_size = context->output_size;
+    stats->memory_used = memory_in_use(context);
+    stats->link_time = context->link_time;
+    
+    /* Peak use is the largest phase peak, or current use before any link */
+    for (i = 0; i < STLD_PHASE_COUNT; i++) {
+        stats->phases[i] = context->phases[i];
+        if (context->phases[i].peak_memory > stats->memory_used) {
+            stats->memory_used = context->phases[i].peak_memory;
+        }
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+int stld_link_files(const char* const* input_files,
+                   size_t input_count,
+                   const char* output_file,
+                   const stld_options_t* options) {
+    stld_context_t* context;
+    size_t i;
+    int result;
+    
+    if (input_files == NULL || input_count == 0 || output_file == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    /* Create context */
+    context = stld_context_create(options);
+    if (context == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    /* Add input files */
+    for (i = 0; i < input_count; i++) {
+        result = stld_add_input_file(context, input_files[i]);
+        if (result != ERROR_SUCCESS) {
+            stld_context_destroy(context);
+            return result;
+        }
+    }
+    
+    /* Perform linking */
+    result = stld_link(context, output_file);
+    
+    /* Cleanup */
+    stld_context_destroy(context);
+    
+    return result;
+}
+
+const char* stld_phase_name(stld_phase_t phase) {
+    static const char* const names[STLD_PHASE_COUNT] = {
+        "load", "resolve", "layout", "relocate", "write"
+    };
+    
+    if ((int)phase < 0 || phase >= STLD_PHASE_COUNT) {
+        return "unknown";
+    }
+    
+    return names[phase];
 }
 
 const char* stld_get_version(void) {
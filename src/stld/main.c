@@ -3,9 +3,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <getopt.h>
+#include <pthread.h>
 #include "stld.h"
+#include "link_server.h"
 #include "error.h"
 #include "memory.h"
+#include "trace.h"
 
 /**
  * @file main.c
@@ -17,6 +20,9 @@
 #define STLD_FULL_VERSION_STRING "STLD (STIX Linker) version " STLD_VERSION_STRING "\n"
 #define STLD_COPYRIGHT "Copyright (c) 2025 STIX Project\n"
 
+/* Bytes a link server keeps cached before dropping unused files */
+#define STLD_SERVER_CACHE_LIMIT ((size_t)512 << 20)
+
 /* Command line options */
 static struct option long_options[] = {
     {"output",          required_argument, 0, 'o'},
@@ -27,45 +33,171 @@ static struct option long_options[] = {
     {"binary-flat",     no_argument,       0, 'B'},
     {"shared",          no_argument,       0, 's'},
     {"static",          no_argument,       0, 'S'},
+    {"relocatable",     no_argument,       0, 'r'},
     {"optimize-size",   no_argument,       0, 'O'},
+    {"gc-sections",     no_argument,       0, 'G'},
+    {"icf",             no_argument,       0, 'I'},
+    {"incremental",     no_argument,       0, 'C'},
     {"strip",           no_argument,       0, 'x'},
     {"map",             optional_argument, 0, 'm'},
+    {"threads",         required_argument, 0, 'j'},
+    {"script",          required_argument, 0, 'T'},
+    {"stats",           optional_argument, 0, 'P'},
+    {"trace",           required_argument, 0, 't'},
     {"verbose",         no_argument,       0, 'v'},
     {"help",            no_argument,       0, 'h'},
     {"version",         no_argument,       0, 'V'},
     {0, 0, 0, 0}
 };
 
-static void print_usage(const char* program_name) {
-    printf("Usage: %s [options] input-files...\n", program_name);
-    printf("\nOptions:\n");
-    printf("  -o, --output FILE         Write output to FILE\n");
-    printf("  -L, --library-path DIR    Add DIR to library search path\n");
-    printf("  -l, --library LIB         Link with library LIB\n");
-    printf("  -e, --entry SYMBOL        Set entry point symbol\n");
-    printf("  -b, --base-address ADDR   Set base address for binary flat output\n");
-    printf("  -B, --binary-flat         Generate binary flat output\n");
-    printf("  -s, --shared              Create shared library\n");
-    printf("  -S, --static              Create static library\n");
-    printf("  -O, --optimize-size       Optimize for size\n");
-    printf("  -x, --strip               Strip debug information\n");
-    printf("  -m, --map[=FILE]          Generate memory map\n");
-    printf("  -v, --verbose             Enable verbose output\n");
-    printf("  -h, --help                Show this help message\n");
-    printf("  -V, --version             Show version information\n");
-    printf("\nExamples:\n");
-    printf("  %s -o program main.smof lib.smof\n", program_name);
-    printf("  %s -B -b 0x100000 -o kernel.bin kernel.smof\n", program_name);
-    printf("  %s -s -o libfoo.so foo.smof bar.smof\n", program_name);
+static void print_usage(FILE* out, const char* program_name) {
+    fprintf(out, "Usage: %s [options] input-files...\n", program_name);
+    fprintf(out, "\nOptions:\n");
+    fprintf(out, "  -o, --output FILE         Write output to FILE\n");
+    fprintf(out, "  -L, --library-path DIR    Add DIR to library search path\n");
+    fprintf(out, "  -l, --library LIB         Pull needed members from libLIB.star\n");
+    fprintf(out, "  -e, --entry SYMBOL        Set entry point symbol\n");
+    fprintf(out, "  -b, --base-address ADDR   Set base address for binary flat output\n");
+    fprintf(out, "  -T, --script FILE         Place sections as the linker script FILE says\n");
+    fprintf(out, "  -B, --binary-flat         Generate binary flat output\n");
+    fprintf(out, "  -s, --shared              Create shared library\n");
+    fprintf(out, "  -S, --static              Create static library\n");
+    fprintf(out, "  -r, --relocatable         Merge inputs into one relocatable object\n");
+    fprintf(out, "  -O, --optimize-size       Optimize for size (implies --gc-sections, --icf)\n");
+    fprintf(out, "      --gc-sections         Drop sections unreachable from the entry point\n");
+    fprintf(out, "      --icf                 Fold identical read-only code sections\n");
+    fprintf(out, "      --incremental         Relink only changed inputs using a cache file\n");
+    fprintf(out, "  -x, --strip               Strip debug information\n");
+    fprintf(out, "  -m, --map[=FILE]          Write a memory map (default: output name + .map)\n");
+    fprintf(out, "  -j, --threads N           Use N worker threads (0 = one per CPU)\n");
+    fprintf(out, "      --stats[=text|json]   Print link statistics and phase times\n");
+    fprintf(out, "      --trace=FILE          Write a Chrome trace of the link to FILE\n");
+    fprintf(out, "  -v, --verbose             Enable verbose output\n");
+    fprintf(out, "      --server=SOCKET       Serve link jobs on SOCKET, caching inputs and libraries\n");
+    fprintf(out, "      --jobs=N              Run N server jobs at once (default: one per CPU)\n");
+    fprintf(out, "      --connect=SOCKET      Run this link on the server at SOCKET\n");
+    fprintf(out, "      --shutdown            With --connect, stop the server\n");
+    fprintf(out, "  -h, --help                Show this help message\n");
+    fprintf(out, "  -V, --version             Show version information\n");
+    fprintf(out, "\nExamples:\n");
+    fprintf(out, "  %s -o program main.smof lib.smof\n", program_name);
+    fprintf(out, "  %s -L lib -l runtime -o program main.smof\n", program_name);
+    fprintf(out, "  %s -B -b 0x100000 -o kernel.bin kernel.smof\n", program_name);
+    fprintf(out, "  %s -T board.ld -B -o rom.bin start.smof drivers.smof\n", program_name);
+    fprintf(out, "  %s -s -o libfoo.so foo.smof bar.smof\n", program_name);
+    fprintf(out, "  %s -r -o net.smof tcp.smof udp.smof ip.smof\n", program_name);
+    fprintf(out, "  %s --connect=/tmp/stld.sock -L lib -l runtime -o test main.smof\n", program_name);
+}
+
+static void print_version(FILE* out) {
+    fprintf(out, STLD_FULL_VERSION_STRING);
+    fprintf(out, STLD_COPYRIGHT);
+    fprintf(out, "This is free software; see the source for copying conditions.\n");
+}
+
+/* Statistics report formats */
+typedef enum {
+    STATS_NONE = 0,
+    STATS_TEXT = 1,
+    STATS_JSON = 2
+} stats_format_t;
+
+static void print_stats_text(FILE* out, const stld_stats_t* stats) {
+    int phase;
+    
+    fprintf(out, "Link statistics:\n");
+    fprintf(out, "  Input files:        %zu (%zu from libraries, %zu reused, %zu cached)\n",
+            stats->input_files, stats->members_loaded, stats->inputs_reused, stats->inputs_cached);
+    fprintf(out, "  Sections:           %zu (%zu removed, %zu folded)\n",
+            stats->total_sections, stats->sections_removed, stats->sections_folded);
+    fprintf(out, "  Symbols:            %zu\n", stats->total_symbols);
+    fprintf(out, "  Relocations:        %zu (%zu kept)\n", stats->relocations_processed,
+            stats->relocations_kept);
+    fprintf(out, "  Output size:        %zu bytes\n", stats->output_size);
+    fprintf(out, "  Peak memory:        %zu bytes\n", stats->memory_used);
+    fprintf(out, "  Link time:          %.6f s\n", stats->link_time);
+    for (phase = 0; phase < STLD_PHASE_COUNT; phase++) {
+        fprintf(out, "    %-9s %12.6f s %12zu bytes\n", stld_phase_name((stld_phase_t)phase),
+                stats->phases[phase].time, stats->phases[phase].peak_memory);
+    }
+}
+
+/* One JSON object per link so benchmark scripts can diff runs */
+static void print_stats_json(FILE* out, const stld_stats_t* stats, const char* output_file,
+                             int result) {
+    int phase;
+    
+    fprintf(out, "{\"output\":\"");
+    for (; *output_file != '\0'; output_file++) {
+        if (*output_file == '"' || *output_file == '\\') {
+            fputc('\\', out);
+        }
+        if ((unsigned char)*output_file >= 0x20) {
+            fputc(*output_file, out);
+        }
+    }
+    fprintf(out, "\",\"result\":%d,\"link_time\":%.6f,\"memory_used\":%zu,", result,
+            stats->link_time, stats->memory_used);
+    fprintf(out, "\"input_files\":%zu,\"members_loaded\":%zu,\"inputs_reused\":%zu,",
+            stats->input_files, stats->members_loaded, stats->inputs_reused);
+    fprintf(out, "\"inputs_cached\":%zu,", stats->inputs_cached);
+    fprintf(out, "\"total_sections\":%zu,\"sections_removed\":%zu,\"sections_folded\":%zu,",
+            stats->total_sections, stats->sections_removed, stats->sections_folded);
+    fprintf(out, "\"total_symbols\":%zu,\"relocations_processed\":%zu,\"relocations_kept\":%zu,",
+            stats->total_symbols, stats->relocations_processed, stats->relocations_kept);
+    fprintf(out, "\"output_size\":%zu,", stats->output_size);
+    fprintf(out, "\"phases\":{");
+    for (phase = 0; phase < STLD_PHASE_COUNT; phase++) {
+        fprintf(out, "%s\"%s\":{\"time\":%.6f,\"peak_memory\":%zu}", phase > 0 ? "," : "",
+                stld_phase_name((stld_phase_t)phase), stats->phases[phase].time,
+                stats->phases[phase].peak_memory);
+    }
+    fprintf(out, "}}\n");
 }
 
-static void print_version(void) {
-    printf(STLD_FULL_VERSION_STRING);
-    printf(STLD_COPYRIGHT);
-    printf("This is free software; see the source for copying conditions.\n");
+/*
+ * Link inputs against the -l libraries found through the -L directories,
+ * loading them through cache when it is not NULL. The context's
+ * statistics are stored in stats, even when the link fails.
+ */
+static int link_program(const char* const* input_files, size_t input_count,
+                        const char* const* library_paths, size_t library_path_count,
+                        const char* const* libraries, size_t library_count,
+                        const char* output_file, const stld_options_t* options,
+                        stld_cache_t* cache, stld_stats_t* stats) {
+    stld_context_t* context;
+    size_t i;
+    int result = ERROR_SUCCESS;
+    
+    context = stld_context_create(options);
+    if (context == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    stld_set_cache(context, cache);
+    
+    for (i = 0; i < input_count && result == ERROR_SUCCESS; i++) {
+        result = stld_add_input_file(context, input_files[i]);
+    }
+    for (i = 0; i < library_path_count && result == ERROR_SUCCESS; i++) {
+        result = stld_add_library_path(context, library_paths[i]);
+    }
+    for (i = 0; i < library_count && result == ERROR_SUCCESS; i++) {
+        result = stld_add_library(context, libraries[i]);
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        result = stld_link(context, output_file);
+    }
+    
+    stld_get_stats(context, stats);
+    stld_context_destroy(context);
+    
+    return result;
 }
 
+/* Diagnostics of a server job go back to its client */
 static void error_callback(const error_context_t* context) {
+    FILE* stream = link_server_job_stream();
     const char* severity = "";
     switch (context->severity) {
         case ERROR_SEVERITY_INFO:    severity = "Info"; break;
@@ -74,48 +206,119 @@ static void error_callback(const error_context_t* context) {
         case ERROR_SEVERITY_FATAL:   severity = "Fatal"; break;
     }
     
-    fprintf(stderr, "%s: %s (%s:%d in %s)\n",
+    fprintf(stream != NULL ? stream : stderr, "%s: %s (%s:%d in %s)\n",
             severity, context->message,
             context->file, context->line, context->function);
 }
 
-int main(int argc, char* argv[]) {
+/* Paths of a server job, which are relative to its client's directory */
+typedef struct job_paths {
+    const char* cwd;                /* NULL outside a server job */
+    char** owned;                   /* Joined paths, one slot per argument and a.out */
+    size_t count;
+    bool failed;                    /* A path could not be allocated */
+} job_paths_t;
+
+static const char* job_path(job_paths_t* paths, const char* path) {
+    size_t size;
+    char* joined;
+    
+    if (paths->cwd == NULL || path[0] == '/' || path[0] == '\0') {
+        return path;
+    }
+    
+    size = strlen(paths->cwd) + strlen(path) + 2;
+    joined = malloc(size);
+    if (joined == NULL) {
+        paths->failed = true;
+        return path;
+    }
+    snprintf(joined, size, "%s/%s", paths->cwd, path);
+    paths->owned[paths->count++] = joined;
+    
+    return joined;
+}
+
+static void free_arguments(const char** input_files, job_paths_t* paths) {
+    size_t i;
+    
+    for (i = 0; i < paths->count; i++) {
+        free(paths->owned[i]);
+    }
+    free(paths->owned);
+    free(input_files);
+}
+
+/* getopt keeps its state in globals, so server jobs parse one at a time */
+static pthread_mutex_t getopt_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Run one stld command line, printing to out and err. cwd is the
+ * directory relative paths are taken from, NULL for the process's own;
+ * cache (may be NULL) is shared with other links. Returns the exit status.
+ */
+static int run_stld(int argc, char* argv[], const char* cwd, FILE* out, FILE* err,
+                    stld_cache_t* cache) {
     /* Variable declarations */
     stld_options_t options;
+    stld_stats_t stats;
+    stats_format_t stats_format = STATS_NONE;
+    job_paths_t paths;
     const char* output_file = NULL;
     const char* map_file = NULL;
+    const char* trace_file = NULL;
     const char** input_files;
+    const char** library_paths;
+    const char** libraries;
     size_t input_count = 0;
+    size_t library_path_count = 0;
+    size_t library_count = 0;
+    int early_exit = -1;
     int opt;
     int result;
     
-    /* Set up error handling */
-    error_set_callback(error_callback);
-    
-    /* Initialize options */
+    /* Initialize options; server jobs run side by side, so each is serial by default */
     options = stld_get_default_options();
+    if (cwd != NULL) {
+        options.threads = 1;
+    }
     
-    /* Input files array */
-    input_files = malloc((size_t)argc * sizeof(char*));
+    /* One array holds input files, -L directories and -l names */
+    input_files = malloc(3 * (size_t)argc * sizeof(char*));
+    paths = (job_paths_t) {
+        .cwd = cwd,
+        .owned = malloc(((size_t)argc + 1) * sizeof(char*)),
+        .count = 0,
+        .failed = false
+    };
     
-    if (input_files == NULL) {
+    if (input_files == NULL || paths.owned == NULL) {
         ERROR_REPORT_FATAL(ERROR_OUT_OF_MEMORY, "Failed to allocate input files array");
+        free(input_files);
+        free(paths.owned);
         return EXIT_FAILURE;
     }
+    library_paths = input_files + argc;
+    libraries = library_paths + argc;
     
-    /* Parse command line options */
-    while ((opt = getopt_long(argc, argv, "o:L:l:e:b:BsSOx::m::vhV", long_options, NULL)) != -1) {
+    /* Parse command line options; optind 0 makes GNU getopt start afresh */
+    pthread_mutex_lock(&getopt_mutex);
+    optind = 0;
+    opterr = cwd == NULL;
+    while (early_exit < 0 &&
+           (opt = getopt_long(argc, argv, "o:L:l:e:b:T:BsSrOx::m::j:vhV", long_options, NULL)) != -1) {
         switch (opt) {
             case 'o':
-                output_file = optarg;
+                output_file = job_path(&paths, optarg);
                 break;
                 
             case 'L':
-                /* TODO: Add library path */
+                library_paths[library_path_count++] = job_path(&paths, optarg);
                 break;
                 
             case 'l':
-                /* TODO: Add library */
+                libraries[library_count++] = strchr(optarg, '/') != NULL ?
+                                             job_path(&paths, optarg) : optarg;
                 break;
                 
             case 'e':
@@ -138,10 +341,26 @@ int main(int argc, char* argv[]) {
                 options.output_type = STLD_OUTPUT_STATIC_LIBRARY;
                 break;
                 
+            case 'r':
+                options.output_type = STLD_OUTPUT_OBJECT;
+                break;
+            
             case 'O':
                 options.optimize = STLD_OPTIMIZE_SIZE;
                 break;
                 
+            case 'G':
+                options.gc_sections = true;
+                break;
+            
+            case 'I':
+                options.fold_identical = true;
+                break;
+            
+            case 'C':
+                options.incremental = true;
+                break;
+            
             case 'x':
                 options.strip_debug = true;
                 break;
@@ -149,28 +368,54 @@ int main(int argc, char* argv[]) {
             case 'm':
                 options.generate_map = true;
                 if (optarg) {
-                    map_file = optarg;
+                    map_file = job_path(&paths, optarg);
                 }
                 break;
                 
+            case 'j':
+                options.threads = (size_t)strtoul(optarg, NULL, 0);
+                break;
+                
+            case 'T':
+                options.script_file = job_path(&paths, optarg);
+                break;
+            
+            case 'P':
+                if (optarg == NULL || strcmp(optarg, "text") == 0) {
+                    stats_format = STATS_TEXT;
+                } else if (strcmp(optarg, "json") == 0) {
+                    stats_format = STATS_JSON;
+                } else {
+                    fprintf(err, "Error: Unknown stats format '%s'\n", optarg);
+                    early_exit = EXIT_FAILURE;
+                }
+                break;
+            
+            case 't':
+                trace_file = optarg;
+                break;
+            
             case 'v':
                 options.verbose = true;
                 break;
                 
             case 'h':
-                print_usage(argv[0]);
-                free(input_files);
-                return EXIT_SUCCESS;
+                print_usage(out, argv[0]);
+                early_exit = EXIT_SUCCESS;
+                break;
                 
             case 'V':
-                print_version();
-                free(input_files);
-                return EXIT_SUCCESS;
+                print_version(out);
+                early_exit = EXIT_SUCCESS;
+                break;
                 
             case '?':
-                fprintf(stderr, "Try '%s --help' for more information.\n", argv[0]);
-                free(input_files);
-                return EXIT_FAILURE;
+                if (cwd != NULL) {
+                    fprintf(err, "Error: Invalid option '%s'\n", argv[optind - 1]);
+                }
+                fprintf(err, "Try '%s --help' for more information.\n", argv[0]);
+                early_exit = EXIT_FAILURE;
+                break;
                 
             default:
                 break;
@@ -178,20 +423,39 @@ int main(int argc, char* argv[]) {
     }
     
     /* Collect input files */
-    for (int i = optind; i < argc; i++) {
-        input_files[input_count++] = argv[i];
+    for (int i = optind; i < argc && early_exit < 0; i++) {
+        input_files[input_count++] = job_path(&paths, argv[i]);
+    }
+    pthread_mutex_unlock(&getopt_mutex);
+    
+    if (early_exit >= 0) {
+        free_arguments(input_files, &paths);
+        return early_exit;
     }
     
     /* Validate arguments */
+    if (paths.failed) {
+        fprintf(err, "Error: Out of memory\n");
+        free_arguments(input_files, &paths);
+        return EXIT_FAILURE;
+    }
+    
     if (input_count == 0) {
-        fprintf(stderr, "Error: No input files specified\n");
-        fprintf(stderr, "Try '%s --help' for more information.\n", argv[0]);
-        free(input_files);
+        fprintf(err, "Error: No input files specified\n");
+        fprintf(err, "Try '%s --help' for more information.\n", argv[0]);
+        free_arguments(input_files, &paths);
+        return EXIT_FAILURE;
+    }
+    
+    /* The trace is the whole process's, which a server job is not */
+    if (trace_file != NULL && cwd != NULL) {
+        fprintf(err, "Error: --trace is not available for server jobs\n");
+        free_arguments(input_files, &paths);
         return EXIT_FAILURE;
     }
     
     if (output_file == NULL) {
-        output_file = "a.out";
+        output_file = job_path(&paths, "a.out");
     }
     
     /* Set map file if needed */
@@ -202,27 +466,141 @@ int main(int argc, char* argv[]) {
     /* Validate options */
     if (!stld_validate_options(&options)) {
         ERROR_REPORT_ERROR(ERROR_INVALID_ARGUMENT, "Invalid linker options");
-        free(input_files);
+        free_arguments(input_files, &paths);
         return EXIT_FAILURE;
     }
     
     /* Perform linking */
     if (options.verbose) {
-        printf("STLD: Linking %zu input files to %s\n", input_count, output_file);
+        fprintf(out, "STLD: Linking %zu input files to %s\n", input_count, output_file);
+    }
+    
+    if (trace_file != NULL && trace_start(trace_file, "stld") != ERROR_SUCCESS) {
+        fprintf(err, "Error: Cannot trace to '%s'%s\n", trace_file,
+                trace_is_available() ? "" : " (built with TRACE=0)");
+        free_arguments(input_files, &paths);
+        return EXIT_FAILURE;
+    }
+    
+    memset(&stats, 0, sizeof(stats));
+    result = link_program(input_files, input_count, library_paths, library_path_count,
+                          libraries, library_count, output_file, &options, cache, &stats);
+    
+    /* The thread pool went with the context, so no span is still open */
+    if (trace_file != NULL && trace_stop() != ERROR_SUCCESS && result == ERROR_SUCCESS) {
+        result = ERROR_FILE_IO;
     }
     
-    result = stld_link_files(input_files, input_count, output_file, &options);
+    if (stats_format == STATS_TEXT) {
+        print_stats_text(out, &stats);
+    } else if (stats_format == STATS_JSON) {
+        print_stats_json(out, &stats, output_file, result);
+    }
     
     if (result == 0) {
         if (options.verbose) {
-            printf("STLD: Linking completed successfully\n");
+            fprintf(out, "STLD: Linking completed successfully\n");
         }
     } else {
-        fprintf(stderr, "STLD: Linking failed with error code %d\n", result);
+        fprintf(err, "STLD: Linking failed with error code %d\n", result);
     }
     
     /* Cleanup */
-    free(input_files);
+    free_arguments(input_files, &paths);
     
     return result == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
+
+static int server_job(int argc, char** argv, const char* cwd, FILE* out, FILE* err,
+                      void* user_data) {
+    return run_stld(argc, argv, cwd, out, err, user_data);
+}
+
+/* Serve link jobs with one cache shared by all of them */
+static int run_server(const char* socket_path, size_t jobs) {
+    stld_cache_stats_t cache_stats;
+    stld_cache_t* cache;
+    int result;
+    
+    cache = stld_cache_create(STLD_SERVER_CACHE_LIMIT);
+    if (cache == NULL) {
+        ERROR_REPORT_FATAL(ERROR_OUT_OF_MEMORY, "Failed to create the input cache");
+        return EXIT_FAILURE;
+    }
+    
+    result = link_server_run(socket_path, jobs, server_job, cache);
+    
+    if (result == ERROR_SUCCESS) {
+        stld_cache_get_stats(cache, &cache_stats);
+        printf("STLD: Server stopped (cache: %zu hits, %zu misses, %zu revalidated, %zu evicted)\n",
+               cache_stats.hits, cache_stats.misses, cache_stats.revalidated,
+               cache_stats.evictions);
+    } else {
+        fprintf(stderr, "Error: Cannot serve on '%s': %s\n", socket_path, error_get_string(result));
+    }
+    stld_cache_destroy(cache);
+    
+    return result == ERROR_SUCCESS ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char* argv[]) {
+    const char* server_socket = NULL;
+    const char* connect_socket = NULL;
+    char** arguments;
+    size_t jobs = 0;
+    bool shutdown = false;
+    int count = 0;
+    int status;
+    int result;
+    int i;
+    
+    /* Set up error handling */
+    error_set_callback(error_callback);
+    
+    /* Server options are taken out here; everything else is a link's command line */
+    arguments = malloc(((size_t)argc + 1) * sizeof(char*));
+    if (arguments == NULL) {
+        ERROR_REPORT_FATAL(ERROR_OUT_OF_MEMORY, "Failed to allocate argument array");
+        return EXIT_FAILURE;
+    }
+    for (i = 0; i < argc; i++) {
+        if (i > 0 && strncmp(argv[i], "--server=", 9) == 0) {
+            server_socket = argv[i] + 9;
+        } else if (i > 0 && strncmp(argv[i], "--connect=", 10) == 0) {
+            connect_socket = argv[i] + 10;
+        } else if (i > 0 && strncmp(argv[i], "--jobs=", 7) == 0) {
+            jobs = (size_t)strtoul(argv[i] + 7, NULL, 0);
+        } else if (i > 0 && strcmp(argv[i], "--shutdown") == 0) {
+            shutdown = true;
+        } else {
+            arguments[count++] = argv[i];
+        }
+    }
+    arguments[count] = NULL;
+    
+    if (server_socket != NULL) {
+        if (count > 1 || connect_socket != NULL || shutdown) {
+            fprintf(stderr, "Error: --server takes no link arguments\n");
+            free(arguments);
+            return EXIT_FAILURE;
+        }
+        status = run_server(server_socket, jobs);
+    } else if (connect_socket != NULL) {
+        result = link_server_submit(connect_socket, count, arguments, shutdown,
+                                    stdout, stderr, &status);
+        if (result != ERROR_SUCCESS) {
+            fprintf(stderr, "Error: Cannot reach the link server on '%s': %s\n",
+                    connect_socket, error_get_string(result));
+            status = EXIT_FAILURE;
+        }
+    } else if (shutdown) {
+        fprintf(stderr, "Error: --shutdown needs --connect\n");
+        status = EXIT_FAILURE;
+    } else {
+        status = run_stld(count, arguments, NULL, stdout, stderr, NULL);
+    }
+    
+    free(arguments);
+    
+    return status;
+}
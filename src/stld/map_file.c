@@ -0,0 +1,220 @@
+/* src/stld/map_file.c */
+#include "include/map_file.h"
+#include "../common/include/error.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file map_file.c
+ * @brief Memory map output for STLD linker
+ * @details C99 compliant map file generation. Symbols are copied out of
+ * the symbol table into one array keyed by (output section, address) and
+ * sorted with the input sections; each output section then consumes the
+ * next run of both arrays, so no section ever searches the symbols.
+ */
+
+/* Symbol as listed in the map */
+typedef struct map_symbol {
+    uint64_t key;                   /* section_index << 32 | value */
+    const char* name;               /* Interned by the symbol table */
+    uint32_t size;
+    symbol_binding_t binding;
+} map_symbol_t;
+
+/* Symbol table visitor state */
+typedef struct map_collector {
+    map_symbol_t* symbols;
+    size_t count;
+    size_t capacity;
+} map_collector_t;
+
+static bool collect_symbol(symbol_handle_t handle, const symbol_t* symbol, void* user_data) {
+    map_collector_t* collector = user_data;
+    
+    (void)handle;
+    
+    /* Section and file symbols only name what the map already shows */
+    if (symbol->type == SYMBOL_TYPE_SECTION || symbol->type == SYMBOL_TYPE_FILE ||
+        collector->count == collector->capacity) {
+        return true;
+    }
+    
+    collector->symbols[collector->count++] = (map_symbol_t) {
+        .key = ((uint64_t)symbol->section_index << 32) | symbol->value,
+        .name = symbol->name,
+        .size = symbol->size,
+        .binding = symbol->binding
+    };
+    
+    return true;
+}
+
+static int compare_symbols(const void* a, const void* b) {
+    const map_symbol_t* symbol_a = a;
+    const map_symbol_t* symbol_b = b;
+    
+    if (symbol_a->key != symbol_b->key) {
+        return symbol_a->key < symbol_b->key ? -1 : 1;
+    }
+    
+    return strcmp(symbol_a->name, symbol_b->name);
+}
+
+static int compare_inputs(const void* a, const void* b) {
+    const map_input_t* input_a = a;
+    const map_input_t* input_b = b;
+    
+    if (input_a->output_index != input_b->output_index) {
+        return input_a->output_index < input_b->output_index ? -1 : 1;
+    }
+    if (input_a->address != input_b->address) {
+        return input_a->address < input_b->address ? -1 : 1;
+    }
+    
+    return 0;
+}
+
+static const char* binding_suffix(symbol_binding_t binding) {
+    switch (binding) {
+        case SYMBOL_BINDING_LOCAL: return " (local)";
+        case SYMBOL_BINDING_WEAK:  return " (weak)";
+        default:                   return "";
+    }
+}
+
+static void write_symbol(FILE* file, const map_symbol_t* symbol) {
+    fprintf(file, "  0x%08X  0x%08X    %s%s\n", (uint32_t)symbol->key, symbol->size,
+            symbol->name, binding_suffix(symbol->binding));
+}
+
+static void write_section_table(FILE* file, const section_manager_t* sections,
+                                const section_id_t* layout, size_t count) {
+    const section_t* section;
+    size_t i;
+    
+    fprintf(file, "Output sections\n\n");
+    fprintf(file, "  Address     Size        Align       Flags  Fragments  Name\n");
+    for (i = 0; i < count; i++) {
+        section = section_manager_get_section(sections, layout[i]);
+        fprintf(file, "  0x%08X  0x%08X  0x%08X  %c%c%c%c   %9zu  %s\n",
+                section->address, section->size, section->alignment,
+                (section->flags & SECTION_FLAG_READABLE) != 0 ? 'R' : '-',
+                (section->flags & SECTION_FLAG_WRITABLE) != 0 ? 'W' : '-',
+                (section->flags & SECTION_FLAG_EXECUTABLE) != 0 ? 'X' : '-',
+                section_is_zero_fill(section) ? 'Z' : '-',
+                section->fragment_count, section->name);
+    }
+}
+
+/* Walk the layout once, taking each section's run of inputs and symbols */
+static void write_section_contents(FILE* file, const section_manager_t* sections,
+                                   const section_id_t* layout, size_t count,
+                                   const map_input_t* inputs, size_t input_count,
+                                   const map_symbol_t* symbols, size_t symbol_count) {
+    const section_t* section;
+    size_t next_input = 0;
+    size_t next_symbol = 0;
+    size_t i;
+    
+    fprintf(file, "\nSection contents\n");
+    for (i = 0; i < count; i++) {
+        section = section_manager_get_section(sections, layout[i]);
+        fprintf(file, "\n%s  0x%08X  0x%08X\n", section->name, section->address, section->size);
+        
+        /* Inputs and symbols interleave by address; inputs go first on ties */
+        while (next_input < input_count && inputs[next_input].output_index == i) {
+            while (next_symbol < symbol_count && (symbols[next_symbol].key >> 32) == i &&
+                   (uint32_t)symbols[next_symbol].key < inputs[next_input].address) {
+                write_symbol(file, &symbols[next_symbol++]);
+            }
+            fprintf(file, "  0x%08X  0x%08X  %s(%s)\n", inputs[next_input].address,
+                    inputs[next_input].size, inputs[next_input].file, inputs[next_input].name);
+            next_input++;
+        }
+        while (next_symbol < symbol_count && (symbols[next_symbol].key >> 32) == i) {
+            write_symbol(file, &symbols[next_symbol++]);
+        }
+    }
+    
+    /* Undefined, absolute and otherwise unplaced symbols */
+    if (next_symbol < symbol_count) {
+        fprintf(file, "\nSymbols outside sections\n\n");
+        for (; next_symbol < symbol_count; next_symbol++) {
+            fprintf(file, "  %s  0x%08X  0x%08X    %s%s\n",
+                    (symbols[next_symbol].key >> 32) == SECTION_INDEX_UNDEFINED ?
+                    "UNDEF " : "ABS   ",
+                    (uint32_t)symbols[next_symbol].key, symbols[next_symbol].size,
+                    symbols[next_symbol].name, binding_suffix(symbols[next_symbol].binding));
+        }
+    }
+}
+
+int map_file_write(const char* filename, const char* output_file,
+                   const section_manager_t* sections, const symbol_table_t* symbols,
+                   map_input_t* inputs, size_t input_count) {
+    map_collector_t collector;
+    const section_id_t* layout;
+    char* buffer;
+    FILE* file;
+    size_t count;
+    int result = ERROR_SUCCESS;
+    
+    if (filename == NULL || output_file == NULL || sections == NULL || symbols == NULL ||
+        (inputs == NULL && input_count > 0)) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    collector = (map_collector_t) {
+        .symbols = NULL,
+        .count = 0,
+        .capacity = symbol_table_size(symbols)
+    };
+    if (collector.capacity > 0) {
+        collector.symbols = malloc(collector.capacity * sizeof(map_symbol_t));
+    }
+    buffer = malloc(MAP_FILE_BUFFER_SIZE);
+    if (buffer == NULL || (collector.symbols == NULL && collector.capacity > 0)) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate map file buffers");
+        free(collector.symbols);
+        free(buffer);
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    symbol_table_foreach(symbols, collect_symbol, &collector);
+    if (collector.count > 1) {
+        qsort(collector.symbols, collector.count, sizeof(map_symbol_t), compare_symbols);
+    }
+    if (input_count > 1) {
+        qsort(inputs, input_count, sizeof(map_input_t), compare_inputs);
+    }
+    layout = section_manager_get_layout(sections, &count);
+    
+    file = fopen(filename, "w");
+    if (file == NULL) {
+        ERROR_REPORT_ERROR(ERROR_FILE_IO, "Cannot create map file");
+        result = ERROR_FILE_IO;
+    } else {
+        setvbuf(file, buffer, _IOFBF, MAP_FILE_BUFFER_SIZE);
+        
+        fprintf(file, "Memory map of %s\n\n", output_file);
+        write_section_table(file, sections, layout, count);
+        write_section_contents(file, sections, layout, count, inputs, input_count,
+                               collector.symbols, collector.count);
+        
+        if (ferror(file)) {
+            result = ERROR_FILE_IO;
+        }
+        if (fclose(file) != 0) {
+            result = ERROR_FILE_IO;
+        }
+        if (result != ERROR_SUCCESS) {
+            ERROR_REPORT_ERROR(ERROR_FILE_IO, "Failed to write map file");
+        }
+    }
+    
+    free(collector.symbols);
+    free(buffer);
+    
+    return result;
+}
@@ -0,0 +1,590 @@
+/* src/stld/object_cache.c */
+#include "include/object_cache.h"
+#include "../common/include/error.h"
+#include "../common/include/crc32.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <linux/memfd.h>
+#include <sys/syscall.h>
+#endif
+
+/**
+ * @file object_cache.c
+ * @brief Shared input cache implementation
+ * @details A chained hash table over paths plus a recency list of the
+ * same entries. Files are read and libraries mapped and indexed outside
+ * the cache mutex; the mutex only guards the table, the list, reference
+ * counts and the member tables, so concurrent links that miss on
+ * different files load them in parallel. When two links load the same
+ * changed file at once, the first result is published and the second is
+ * dropped.
+ */
+
+/* Initial bucket count; the table doubles when it holds more entries */
+#define OBJECT_CACHE_BUCKETS 256
+
+struct stld_cache {
+    pthread_mutex_t mutex;
+    cache_entry_t** buckets;
+    size_t bucket_mask;
+    size_t entry_count;
+    cache_entry_t* newest;          /* Recency list of the entries in the table */
+    cache_entry_t* oldest;
+    size_t max_memory;              /* 0 = unlimited */
+    size_t memory_used;             /* Charged by entries in the table */
+    size_t hits;
+    size_t misses;
+    size_t revalidated;
+    size_t evictions;
+};
+
+/* Modification time in nanoseconds */
+static int64_t stat_mtime(const struct stat* st) {
+    return (int64_t)st->st_mtim.tv_sec * 1000000000 + (int64_t)st->st_mtim.tv_nsec;
+}
+
+/* An unlinked file for cached bytes: a memfd where the kernel has them, else a temporary file */
+static int create_memory_file(void) {
+    char path[] = "/tmp/stld-cache-XXXXXX";
+    int fd;
+
+#if defined(__linux__) && defined(SYS_memfd_create)
+    fd = (int)syscall(SYS_memfd_create, "stld-cache", MFD_CLOEXEC);
+    if (fd >= 0) {
+        return fd;
+    }
+#endif
+
+    fd = mkstemp(path);
+    if (fd >= 0) {
+        unlink(path);
+    }
+    
+    return fd;
+}
+
+static int write_at(int fd, const uint8_t* data, size_t size, uint64_t offset) {
+    ssize_t written;
+    
+    while (size > 0) {
+        written = pwrite(fd, data, size, (off_t)offset);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return ERROR_FILE_IO;
+        }
+        data += written;
+        offset += (uint64_t)written;
+        size -= (size_t)written;
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+/* Copy-on-write view of cached bytes: pages are shared until the link writes to them */
+static int map_private(int fd, uint64_t offset, size_t size, void** map) {
+    *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, (off_t)offset);
+    
+    return *map == MAP_FAILED ? ERROR_OUT_OF_MEMORY : ERROR_SUCCESS;
+}
+
+static bool member_is_compressed(const archive_member_t* member) {
+    return (member->header.flags & STAR_MEMBER_FLAG_COMPRESSED) != 0;
+}
+
+static void free_entry(cache_entry_t* entry) {
+    free(entry->member_offsets);
+    free(entry->verified);
+    symbol_index_destroy(entry->index);
+    archive_close(entry->archive);
+    if (entry->data != NULL) {
+        munmap(entry->data, (size_t)entry->file_size);
+    }
+    if (entry->fd >= 0) {
+        close(entry->fd);
+    }
+    free(entry->path);
+    free(entry);
+}
+
+/* Drop one reference; the caller holds the mutex */
+static void unref_entry(cache_entry_t* entry) {
+    if (--entry->refs == 0) {
+        free_entry(entry);
+    }
+}
+
+static bool identity_matches(const cache_entry_t* entry, const struct stat* st) {
+    return entry->device == st->st_dev && entry->inode == st->st_ino &&
+           entry->file_size == (uint64_t)st->st_size && entry->mtime == stat_mtime(st);
+}
+
+static void set_identity(cache_entry_t* entry, const struct stat* st) {
+    entry->device = st->st_dev;
+    entry->inode = st->st_ino;
+    entry->file_size = (uint64_t)st->st_size;
+    entry->mtime = stat_mtime(st);
+}
+
+static cache_entry_t* find_entry(const stld_cache_t* cache, const char* path, uint32_t hash,
+                                 cache_entry_kind_t kind) {
+    cache_entry_t* entry;
+    
+    for (entry = cache->buckets[hash & cache->bucket_mask]; entry != NULL; entry = entry->next) {
+        if (entry->path_hash == hash && entry->kind == kind && strcmp(entry->path, path) == 0) {
+            return entry;
+        }
+    }
+    
+    return NULL;
+}
+
+static void unlink_recency(stld_cache_t* cache, cache_entry_t* entry) {
+    if (entry->newer != NULL) {
+        entry->newer->older = entry->older;
+    } else {
+        cache->newest = entry->older;
+    }
+    if (entry->older != NULL) {
+        entry->older->newer = entry->newer;
+    } else {
+        cache->oldest = entry->newer;
+    }
+    entry->newer = NULL;
+    entry->older = NULL;
+}
+
+static void push_recency(stld_cache_t* cache, cache_entry_t* entry) {
+    entry->older = cache->newest;
+    if (cache->newest != NULL) {
+        cache->newest->newer = entry;
+    } else {
+        cache->oldest = entry;
+    }
+    cache->newest = entry;
+}
+
+static void touch_entry(stld_cache_t* cache, cache_entry_t* entry) {
+    unlink_recency(cache, entry);
+    push_recency(cache, entry);
+}
+
+/* Take an entry out of the table and drop the table's reference */
+static void remove_entry(stld_cache_t* cache, cache_entry_t* entry) {
+    cache_entry_t** link = &cache->buckets[entry->path_hash & cache->bucket_mask];
+    
+    while (*link != entry) {
+        link = &(*link)->next;
+    }
+    *link = entry->next;
+    entry->next = NULL;
+    
+    unlink_recency(cache, entry);
+    entry->in_table = false;
+    cache->entry_count--;
+    cache->memory_used -= entry->memory;
+    unref_entry(entry);
+}
+
+/* A larger table is only an optimisation, so a failed allocation is ignored */
+static void grow_table(stld_cache_t* cache) {
+    size_t capacity = (cache->bucket_mask + 1) * 2;
+    cache_entry_t** buckets = calloc(capacity, sizeof(cache_entry_t*));
+    cache_entry_t* entry;
+    cache_entry_t* next;
+    size_t i;
+    
+    if (buckets == NULL) {
+        return;
+    }
+    
+    for (i = 0; i <= cache->bucket_mask; i++) {
+        for (entry = cache->buckets[i]; entry != NULL; entry = next) {
+            next = entry->next;
+            entry->next = buckets[entry->path_hash & (capacity - 1)];
+            buckets[entry->path_hash & (capacity - 1)] = entry;
+        }
+    }
+    
+    free(cache->buckets);
+    cache->buckets = buckets;
+    cache->bucket_mask = capacity - 1;
+}
+
+static void insert_entry(stld_cache_t* cache, cache_entry_t* entry) {
+    size_t bucket;
+    
+    if (cache->entry_count >= cache->bucket_mask + 1) {
+        grow_table(cache);
+    }
+    
+    bucket = entry->path_hash & cache->bucket_mask;
+    entry->next = cache->buckets[bucket];
+    cache->buckets[bucket] = entry;
+    push_recency(cache, entry);
+    entry->in_table = true;
+    entry->refs++;
+    cache->entry_count++;
+    cache->memory_used += entry->memory;
+}
+
+/* Evict from the old end; entries in use survive until they are released */
+static void enforce_limit(stld_cache_t* cache, const cache_entry_t* keep) {
+    while (cache->max_memory > 0 && cache->memory_used > cache->max_memory &&
+           cache->oldest != NULL && cache->oldest != keep) {
+        remove_entry(cache, cache->oldest);
+        cache->evictions++;
+    }
+}
+
+static int read_object(cache_entry_t* entry) {
+    struct stat st;
+    void* map;
+    size_t done = 0;
+    ssize_t count;
+    int fd;
+    
+    fd = open(entry->path, O_RDONLY);
+    if (fd < 0) {
+        return ERROR_FILE_IO;
+    }
+    
+    /* The identity is the descriptor's, so it describes exactly the bytes read */
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return ERROR_FILE_IO;
+    }
+    set_identity(entry, &st);
+    if (entry->file_size == 0) {
+        close(fd);
+        return ERROR_CORRUPT_HEADER;
+    }
+    
+    /* Read straight into the memory file that links map, through a shared view */
+    entry->fd = create_memory_file();
+    if (entry->fd < 0 || ftruncate(entry->fd, (off_t)entry->file_size) != 0) {
+        close(fd);
+        return ERROR_FILE_IO;
+    }
+    map = mmap(NULL, (size_t)entry->file_size, PROT_READ | PROT_WRITE, MAP_SHARED, entry->fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return ERROR_OUT_OF_MEMORY;
+    }
+    entry->data = map;
+    
+    while (done < entry->file_size) {
+        count = read(fd, entry->data + done, (size_t)entry->file_size - done);
+        if (count <= 0) {
+            close(fd);
+            return ERROR_FILE_IO;
+        }
+        done += (size_t)count;
+    }
+    close(fd);
+    
+    /* Published bytes never change */
+    mprotect(entry->data, (size_t)entry->file_size, PROT_READ);
+    entry->checksum = crc32_calculate(entry->data, (size_t)entry->file_size);
+    entry->memory = (size_t)entry->file_size;
+    
+    return ERROR_SUCCESS;
+}
+
+static bool resolve_entry(const symbol_index_entry_t* symbol, void* user_data) {
+    (void)symbol;
+    (void)user_data;
+    
+    return true;
+}
+
+static int map_library(cache_entry_t* entry, const struct stat* st) {
+    int result;
+    
+    /* Identity from before the map: a change in between only costs a reload */
+    set_identity(entry, st);
+    
+    entry->archive = archive_map(entry->path);
+    if (entry->archive == NULL) {
+        ERROR_REPORT_ERROR(ERROR_ARCHIVE_CORRUPT, "Library is not a STAR archive");
+        return ERROR_ARCHIVE_CORRUPT;
+    }
+    
+    entry->index = symbol_index_create(0);
+    entry->member_offsets = calloc(entry->archive->header.member_count + 1U, sizeof(uint64_t));
+    entry->verified = calloc(entry->archive->header.member_count + 1U, sizeof(uint8_t));
+    if (entry->index == NULL || entry->member_offsets == NULL || entry->verified == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    result = symbol_index_load_from_archive(entry->index, entry->archive);
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    /* Visiting resolves every entry, so later lookups never write to the index */
+    symbol_index_foreach(entry->index, resolve_entry, NULL);
+    
+    entry->checksum = crc32_calculate(entry->archive->map, entry->archive->map_size);
+    entry->memory = entry->archive->map_size;
+    
+    return ERROR_SUCCESS;
+}
+
+static cache_entry_t* load_entry(const char* path, uint32_t hash, cache_entry_kind_t kind,
+                                 const struct stat* st, int* result) {
+    cache_entry_t* entry = calloc(1, sizeof(cache_entry_t));
+    size_t size = strlen(path) + 1;
+    
+    if (entry == NULL || (entry->path = malloc(size)) == NULL) {
+        free(entry);
+        *result = ERROR_OUT_OF_MEMORY;
+        return NULL;
+    }
+    memcpy(entry->path, path, size);
+    entry->fd = -1;
+    entry->path_hash = hash;
+    entry->kind = kind;
+    entry->refs = 1;
+    
+    *result = kind == CACHE_ENTRY_OBJECT ? read_object(entry) : map_library(entry, st);
+    if (*result != ERROR_SUCCESS) {
+        free_entry(entry);
+        return NULL;
+    }
+    
+    return entry;
+}
+
+stld_cache_t* stld_cache_create(size_t max_memory) {
+    stld_cache_t* cache = calloc(1, sizeof(stld_cache_t));
+    
+    if (cache == NULL) {
+        return NULL;
+    }
+    
+    cache->buckets = calloc(OBJECT_CACHE_BUCKETS, sizeof(cache_entry_t*));
+    if (cache->buckets == NULL || pthread_mutex_init(&cache->mutex, NULL) != 0) {
+        free(cache->buckets);
+        free(cache);
+        return NULL;
+    }
+    cache->bucket_mask = OBJECT_CACHE_BUCKETS - 1;
+    cache->max_memory = max_memory;
+    
+    return cache;
+}
+
+void stld_cache_destroy(stld_cache_t* cache) {
+    if (cache == NULL) {
+        return;
+    }
+    
+    while (cache->newest != NULL) {
+        remove_entry(cache, cache->newest);
+    }
+    pthread_mutex_destroy(&cache->mutex);
+    free(cache->buckets);
+    free(cache);
+}
+
+void stld_cache_get_stats(stld_cache_t* cache, stld_cache_stats_t* stats) {
+    if (cache == NULL || stats == NULL) {
+        return;
+    }
+    
+    pthread_mutex_lock(&cache->mutex);
+    *stats = (stld_cache_stats_t) {
+        .hits = cache->hits,
+        .misses = cache->misses,
+        .revalidated = cache->revalidated,
+        .evictions = cache->evictions,
+        .entries = cache->entry_count,
+        .memory_used = cache->memory_used
+    };
+    pthread_mutex_unlock(&cache->mutex);
+}
+
+int object_cache_acquire(stld_cache_t* cache, const char* path, cache_entry_kind_t kind,
+                         cache_entry_t** entry, bool* hit) {
+    uint32_t hash;
+    cache_entry_t* current;
+    cache_entry_t* fresh;
+    struct stat st;
+    int result;
+    
+    if (cache == NULL || path == NULL || entry == NULL || hit == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    if (stat(path, &st) != 0) {
+        return ERROR_FILE_IO;
+    }
+    hash = symbol_index_hash_name(path);
+    
+    pthread_mutex_lock(&cache->mutex);
+    current = find_entry(cache, path, hash, kind);
+    if (current != NULL && identity_matches(current, &st)) {
+        current->refs++;
+        touch_entry(cache, current);
+        cache->hits++;
+        pthread_mutex_unlock(&cache->mutex);
+        *entry = current;
+        *hit = true;
+        return ERROR_SUCCESS;
+    }
+    pthread_mutex_unlock(&cache->mutex);
+    
+    fresh = load_entry(path, hash, kind, &st, &result);
+    if (fresh == NULL) {
+        return result;
+    }
+    
+    pthread_mutex_lock(&cache->mutex);
+    current = find_entry(cache, path, hash, kind);
+    if (current != NULL && current->file_size == fresh->file_size &&
+        current->checksum == fresh->checksum) {
+        /* Only the timestamp moved (or another link loaded it first): keep what is cached */
+        current->device = fresh->device;
+        current->inode = fresh->inode;
+        current->mtime = fresh->mtime;
+        current->refs++;
+        touch_entry(cache, current);
+        cache->revalidated++;
+        *entry = current;
+        unref_entry(fresh);
+    } else {
+        if (current != NULL) {
+            remove_entry(cache, current);
+        }
+        insert_entry(cache, fresh);
+        cache->misses++;
+        enforce_limit(cache, fresh);
+        *entry = fresh;
+    }
+    pthread_mutex_unlock(&cache->mutex);
+    
+    *hit = false;
+    return ERROR_SUCCESS;
+}
+
+void object_cache_release(stld_cache_t* cache, cache_entry_t* entry) {
+    if (cache == NULL || entry == NULL) {
+        return;
+    }
+    
+    pthread_mutex_lock(&cache->mutex);
+    unref_entry(entry);
+    pthread_mutex_unlock(&cache->mutex);
+}
+
+/* Copy a verified member to a page-aligned slot of the memory file; the caller holds the mutex */
+static int store_member(cache_entry_t* entry, uint32_t member_index, const uint8_t* data,
+                        uint32_t size) {
+    uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+    uint64_t end = entry->fd_size + (((uint64_t)size + page - 1) / page) * page;
+    
+    if (entry->fd < 0) {
+        entry->fd = create_memory_file();
+        if (entry->fd < 0) {
+            return ERROR_FILE_IO;
+        }
+    }
+    if (ftruncate(entry->fd, (off_t)end) != 0 ||
+        write_at(entry->fd, data, size, entry->fd_size) != ERROR_SUCCESS) {
+        return ERROR_FILE_IO;
+    }
+    
+    entry->member_offsets[member_index] = entry->fd_size;
+    entry->fd_size = end;
+    entry->verified[member_index] = 1;
+    
+    return ERROR_SUCCESS;
+}
+
+int object_cache_map_object(const cache_entry_t* entry, void** map) {
+    if (entry == NULL || entry->kind != CACHE_ENTRY_OBJECT || entry->fd < 0 || map == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    return map_private(entry->fd, 0, (size_t)entry->file_size, map);
+}
+
+int object_cache_map_member(stld_cache_t* cache, cache_entry_t* entry, uint32_t member_index,
+                            void** map) {
+    const archive_member_t* member;
+    const uint8_t* stored;
+    uint8_t* decoded = NULL;
+    uint64_t offset;
+    bool verified;
+    int fd;
+    int result = ERROR_SUCCESS;
+    
+    if (cache == NULL || entry == NULL || entry->kind != CACHE_ENTRY_LIBRARY || map == NULL ||
+        member_index >= entry->archive->header.member_count ||
+        entry->archive->members[member_index].header.size == 0) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    member = &entry->archive->members[member_index];
+    
+    pthread_mutex_lock(&cache->mutex);
+    verified = entry->verified[member_index] != 0;
+    offset = entry->member_offsets[member_index];
+    fd = entry->fd;
+    pthread_mutex_unlock(&cache->mutex);
+    if (verified) {
+        return map_private(fd, offset, member->header.size, map);
+    }
+    
+    /* Decoded without the mutex; a link that lost the race drops its copy */
+    stored = archive_member_data(entry->archive, member);
+    if (stored == NULL) {
+        ERROR_REPORT_ERROR(ERROR_ARCHIVE_CORRUPT, "Library member lies outside the archive");
+        return ERROR_ARCHIVE_CORRUPT;
+    }
+    
+    if (member_is_compressed(member)) {
+        decoded = malloc(member->header.size);
+        if (decoded == NULL) {
+            return ERROR_OUT_OF_MEMORY;
+        }
+        if (archive_read_member(entry->archive, member, decoded) != ERROR_SUCCESS) {
+            free(decoded);
+            ERROR_REPORT_ERROR(ERROR_DECOMPRESSION_FAILED, "Failed to decompress library member");
+            return ERROR_DECOMPRESSION_FAILED;
+        }
+        stored = decoded;
+    }
+    
+    if (crc32_calculate(stored, member->header.size) != member->header.checksum) {
+        free(decoded);
+        ERROR_REPORT_ERROR(ERROR_ARCHIVE_CORRUPT, "Library member checksum mismatch");
+        return ERROR_ARCHIVE_CORRUPT;
+    }
+    
+    pthread_mutex_lock(&cache->mutex);
+    if (!entry->verified[member_index]) {
+        result = store_member(entry, member_index, stored, member->header.size);
+        if (result == ERROR_SUCCESS) {
+            entry->memory += member->header.size;
+            if (entry->in_table) {
+                cache->memory_used += member->header.size;
+            }
+        }
+    }
+    offset = entry->member_offsets[member_index];
+    fd = entry->fd;
+    pthread_mutex_unlock(&cache->mutex);
+    free(decoded);
+    
+    return result == ERROR_SUCCESS ? map_private(fd, offset, member->header.size, map) : result;
+}
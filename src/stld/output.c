@@ -1,12 +1,765 @@
 /* src/stld/output.c */
+#include "include/output.h"
+#include "../common/include/error.h"
+#include "../common/include/smof.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 /**
  * @file output.c
  * @brief Output generation for STLD linker
- * @details C99 compliant output file generation
+ * @details C99 compliant output file generation. The layout pass assigns
+ * every file offset (tables first, then section data in registration
+ * order for SMOF; address order for flat images), so the write pass never
+ * seeks. Symbol and section names are streamed from their owners in the
+ * same order the layout pass sized them, so no string table is built.
+ * Writes are positioned (pwrite), so long zero runs are skipped and left
+ * as file holes; the file is sized with ftruncate at the end. A SMOF
+ * output gets the v1 header unless its tables exceed v1's limits.
  */
 
-/* TODO: Implement output generation functions */
+#define OUTPUT_INITIAL_SECTIONS 16
 
-/* Dummy variable to satisfy ISO C empty translation unit requirement */
-static const int output_dummy_variable __attribute__((unused)) = 0;
\ No newline at end of file
+/* Registered output section */
+typedef struct output_section {
+    const char* name;               /* Section name (not owned) */
+    const uint8_t* data;            /* Contents (not owned), NULL for zero fill */
+    const section_fragment_t* fragments;  /* Scatter list used instead of data */
+    uint32_t address;               /* Load address */
+    uint32_t size;                  /* Size in bytes */
+    uint16_t flags;                 /* SMOF_SECT_* */
+    uint8_t alignment;              /* Power-of-two exponent */
+    uint32_t name_offset;           /* Layout: offset in the string table */
+    uint32_t file_offset;           /* Layout: offset of the data, 0 if none */
+} output_section_t;
+
+/* Output generator structure */
+struct output_generator {
+    const symbol_table_t* symbols;  /* Written to SMOF outputs (not owned) */
+    output_config_t config;
+    output_section_t* sections;     /* In registration order */
+    size_t section_count;
+    size_t section_capacity;
+    uint64_t* order;                /* Layout: flat order keys, sorted */
+    size_t order_count;
+    const output_relocation_t* relocations;  /* Relocation table (not owned) */
+    size_t relocation_count;
+    size_t symbol_count;            /* Layout: symbols in the symbol table */
+    bool wide;                      /* Layout: written with the SMOF v2 header */
+    uint32_t symbol_table_offset;
+    uint32_t reloc_table_offset;
+    uint32_t string_table_offset;
+    uint32_t string_table_size;
+    uint64_t file_size;             /* Layout: bytes to write */
+};
+
+/* Sequential writer state */
+typedef struct output_writer {
+    int fd;
+    uint8_t* buffer;                /* OUTPUT_BUFFER_SIZE bytes */
+    size_t used;                    /* Bytes pending in buffer */
+    uint64_t position;              /* Bytes accepted so far */
+    bool sparse;                    /* Leave long zero runs as holes */
+} output_writer_t;
+
+output_generator_t* output_generator_create(const symbol_table_t* symbols) {
+    output_generator_t* generator;
+    
+    if (symbols == NULL) {
+        return NULL;
+    }
+    
+    generator = malloc(sizeof(output_generator_t));
+    if (generator == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate output generator");
+        return NULL;
+    }
+    
+    *generator = (output_generator_t) {
+        .symbols = symbols,
+        .config = {
+            .type = OUTPUT_TYPE_SMOF,
+            .base_address = 0,
+            .entry_point = 0,
+            .file_flags = SMOF_FLAG_LITTLE_ENDIAN,
+            .fill_gaps = false,
+            .fill_value = 0
+        },
+        .sections = NULL,
+        .section_count = 0,
+        .section_capacity = 0,
+        .order = NULL,
+        .order_count = 0,
+        .relocations = NULL,
+        .relocation_count = 0,
+        .symbol_count = 0,
+        .wide = false,
+        .symbol_table_offset = 0,
+        .reloc_table_offset = 0,
+        .string_table_offset = 0,
+        .string_table_size = 0,
+        .file_size = 0
+    };
+    
+    return generator;
+}
+
+void output_generator_destroy(output_generator_t* generator) {
+    if (generator != NULL) {
+        free(generator->sections);
+        free(generator->order);
+        free(generator);
+    }
+}
+
+bool output_generator_configure(output_generator_t* generator, const output_config_t* config) {
+    if (generator == NULL || config == NULL) {
+        return false;
+    }
+    
+    if (config->type != OUTPUT_TYPE_SMOF && config->type != OUTPUT_TYPE_BINARY_FLAT) {
+        return false;
+    }
+    
+    generator->config = *config;
+    return true;
+}
+
+static int append_section(output_generator_t* generator, const output_section_t* section) {
+    output_section_t* sections;
+    size_t new_capacity;
+    
+    if (generator->section_count >= generator->section_capacity) {
+        new_capacity = generator->section_capacity > 0 ?
+                       generator->section_capacity * 2 : OUTPUT_INITIAL_SECTIONS;
+        sections = realloc(generator->sections, new_capacity * sizeof(output_section_t));
+        if (sections == NULL) {
+            ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to grow output sections");
+            return ERROR_OUT_OF_MEMORY;
+        }
+        generator->sections = sections;
+        generator->section_capacity = new_capacity;
+    }
+    
+    generator->sections[generator->section_count++] = *section;
+    return ERROR_SUCCESS;
+}
+
+int output_generator_add_section(output_generator_t* generator, const char* name,
+                                 uint32_t address, uint32_t size, uint16_t flags,
+                                 uint8_t alignment, const uint8_t* data) {
+    output_section_t section;
+    
+    if (generator == NULL || name == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    if (alignment >= 32) {
+        ERROR_REPORT_ERROR(ERROR_SECTION_ALIGNMENT, "Section alignment out of range");
+        return ERROR_SECTION_ALIGNMENT;
+    }
+    
+    if (data == NULL) {
+        flags = (uint16_t)(flags | SMOF_SECT_ZERO_FILL);
+    }
+    
+    section = (output_section_t) {
+        .name = name,
+        .data = (flags & SMOF_SECT_ZERO_FILL) != 0 ? NULL : data,
+        .fragments = NULL,
+        .address = address,
+        .size = size,
+        .flags = flags,
+        .alignment = alignment,
+        .name_offset = 0,
+        .file_offset = 0
+    };
+    
+    return append_section(generator, &section);
+}
+
+int output_generator_add_merged_section(output_generator_t* generator, const section_t* section) {
+    output_section_t entry;
+    uint8_t alignment = 0;
+    
+    if (generator == NULL || section == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    while (((uint32_t)1 << alignment) < section->alignment && alignment < 31) {
+        alignment++;
+    }
+    
+    entry = (output_section_t) {
+        .name = section->name,
+        .data = NULL,
+        .fragments = section_is_zero_fill(section) ? NULL : section->fragments,
+        .address = section->address,
+        .size = section->size,
+        .flags = section->flags,
+        .alignment = alignment,
+        .name_offset = 0,
+        .file_offset = 0
+    };
+    
+    return append_section(generator, &entry);
+}
+
+int output_generator_set_relocations(output_generator_t* generator,
+                                     const output_relocation_t* relocations, size_t count) {
+    if (generator == NULL || (relocations == NULL && count > 0)) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    generator->relocations = relocations;
+    generator->relocation_count = count;
+    return ERROR_SUCCESS;
+}
+
+size_t output_generator_get_section_count(const output_generator_t* generator) {
+    return generator != NULL ? generator->section_count : 0;
+}
+
+static bool has_contents(const output_section_t* section) {
+    return (section->flags & SMOF_SECT_ZERO_FILL) == 0;
+}
+
+static uint64_t align_offset(uint64_t offset, uint8_t alignment) {
+    uint64_t mask;
+    
+    if (alignment > OUTPUT_MAX_FILE_ALIGNMENT_SHIFT) {
+        alignment = OUTPUT_MAX_FILE_ALIGNMENT_SHIFT;
+    }
+    
+    mask = ((uint64_t)1 << alignment) - 1;
+    return (offset + mask) & ~mask;
+}
+
+static int layout_smof(output_generator_t* generator) {
+    output_section_t* section;
+    uint64_t offset;
+    uint64_t strings = 1;           /* Leading empty string */
+    size_t i;
+    
+    generator->symbol_count = symbol_table_size(generator->symbols);
+    
+    if (generator->section_count > SMOF_V2_MAX_SECTIONS || generator->symbol_count > UINT32_MAX ||
+        generator->relocation_count > UINT32_MAX) {
+        ERROR_REPORT_ERROR(ERROR_OUTPUT_TOO_LARGE,
+                           "Too many sections, symbols or relocations for SMOF");
+        return ERROR_OUTPUT_TOO_LARGE;
+    }
+    
+    /* Names in write order: sections, then symbols by handle */
+    for (i = 0; i < generator->section_count; i++) {
+        generator->sections[i].name_offset = (uint32_t)strings;
+        strings += strlen(generator->sections[i].name) + 1;
+    }
+    
+    for (i = 0; i < generator->symbol_count; i++) {
+        strings += strlen(symbol_table_get_name(generator->symbols, (symbol_handle_t)i)) + 1;
+    }
+    
+    generator->wide = generator->section_count > SMOF_V1_MAX_SECTIONS ||
+                      generator->symbol_count > SMOF_V1_MAX_SYMBOLS ||
+                      generator->relocation_count > SMOF_V1_MAX_RELOCATIONS ||
+                      strings > SMOF_V1_MAX_STRING_TABLE;
+    
+    /* Header, section, symbol and relocation tables, string table, then data */
+    offset = (generator->wide ? sizeof(smof_header_v2_t) : sizeof(smof_header_t)) +
+             generator->section_count * sizeof(smof_section_t);
+    generator->symbol_table_offset = (uint32_t)offset;
+    offset += generator->symbol_count * sizeof(smof_symbol_t);
+    generator->reloc_table_offset = generator->relocation_count > 0 ? (uint32_t)offset : 0;
+    offset += generator->relocation_count *
+              (generator->wide ? sizeof(smof_relocation_v2_t) : sizeof(smof_relocation_t));
+    generator->string_table_offset = (uint32_t)offset;
+    offset += strings;
+    
+    for (i = 0; i < generator->section_count; i++) {
+        section = &generator->sections[i];
+        section->file_offset = 0;
+        
+        if (has_contents(section) && section->size > 0) {
+            offset = align_offset(offset, section->alignment);
+            if (offset > UINT32_MAX) {
+                break;
+            }
+            section->file_offset = (uint32_t)offset;
+            offset += section->size;
+        }
+    }
+    
+    if (strings > UINT32_MAX || offset > UINT32_MAX) {
+        ERROR_REPORT_ERROR(ERROR_OUTPUT_TOO_LARGE, "Output exceeds 4GB");
+        return ERROR_OUTPUT_TOO_LARGE;
+    }
+    
+    generator->string_table_size = (uint32_t)strings;
+    generator->file_size = offset;
+    
+    return ERROR_SUCCESS;
+}
+
+/* Flat order keys: address (32) | section index (32) */
+static int compare_order(const void* a, const void* b) {
+    uint64_t left = *(const uint64_t*)a;
+    uint64_t right = *(const uint64_t*)b;
+    
+    return left < right ? -1 : (left > right ? 1 : 0);
+}
+
+static int layout_flat(output_generator_t* generator) {
+    const output_section_t* section;
+    uint64_t previous_end;
+    uint64_t image_end;
+    size_t i;
+    
+    free(generator->order);
+    generator->order = NULL;
+    generator->order_count = 0;
+    generator->file_size = 0;
+    
+    if (generator->section_count == 0) {
+        return ERROR_SUCCESS;
+    }
+    
+    if (generator->section_count > UINT32_MAX) {
+        ERROR_REPORT_ERROR(ERROR_OUTPUT_TOO_LARGE, "Too many sections for flat output");
+        return ERROR_OUTPUT_TOO_LARGE;
+    }
+    
+    generator->order = malloc(generator->section_count * sizeof(uint64_t));
+    if (generator->order == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate section order");
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    for (i = 0; i < generator->section_count; i++) {
+        if (generator->sections[i].size > 0) {
+            generator->order[generator->order_count++] =
+                ((uint64_t)generator->sections[i].address << 32) | i;
+        }
+    }
+    
+    /* Equal addresses keep registration order */
+    qsort(generator->order, generator->order_count, sizeof(uint64_t), compare_order);
+    
+    /* The image ends with the last section that has contents */
+    previous_end = generator->config.base_address;
+    image_end = generator->config.base_address;
+    
+    for (i = 0; i < generator->order_count; i++) {
+        section = &generator->sections[(uint32_t)generator->order[i]];
+        
+        if (section->address < previous_end) {
+            ERROR_REPORT_ERROR(ERROR_INVALID_SECTION,
+                               section->address < generator->config.base_address ?
+                               "Section below flat image base address" :
+                               "Sections overlap in flat image");
+            return ERROR_INVALID_SECTION;
+        }
+        
+        previous_end = (uint64_t)section->address + section->size;
+        if (has_contents(section)) {
+            image_end = previous_end;
+        }
+    }
+    
+    generator->file_size = image_end - generator->config.base_address;
+    
+    return ERROR_SUCCESS;
+}
+
+static int compute_layout(output_generator_t* generator) {
+    return generator->config.type == OUTPUT_TYPE_BINARY_FLAT ?
+           layout_flat(generator) : layout_smof(generator);
+}
+
+size_t output_generator_calculate_size(output_generator_t* generator) {
+    if (generator == NULL || compute_layout(generator) != ERROR_SUCCESS) {
+        return 0;
+    }
+    
+    return (size_t)generator->file_size;
+}
+
+bool output_generator_get_file_offset(const output_generator_t* generator, size_t index,
+                                      uint32_t* offset) {
+    const output_section_t* section;
+    
+    if (generator == NULL || offset == NULL || index >= generator->section_count) {
+        return false;
+    }
+    
+    section = &generator->sections[index];
+    if (!has_contents(section) || section->size == 0) {
+        return false;
+    }
+    
+    /* Flat images are the memory image itself */
+    *offset = generator->config.type == OUTPUT_TYPE_BINARY_FLAT ?
+              section->address - generator->config.base_address : section->file_offset;
+    
+    return true;
+}
+
+static int write_all(int fd, const uint8_t* data, size_t size, uint64_t offset) {
+    ssize_t written;
+    
+    while (size > 0) {
+        written = pwrite(fd, data, size, (off_t)offset);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            ERROR_REPORT_ERROR(ERROR_FILE_IO, "Failed to write output file");
+            return ERROR_FILE_IO;
+        }
+        data += written;
+        size -= (size_t)written;
+        offset += (uint64_t)written;
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+/* The buffer holds the bytes just before position */
+static int writer_flush(output_writer_t* writer) {
+    int result = write_all(writer->fd, writer->buffer, writer->used,
+                           writer->position - writer->used);
+    
+    writer->used = 0;
+    return result;
+}
+
+/* Buffer small pieces; long runs go to the file directly */
+static int writer_put(output_writer_t* writer, const void* data, size_t size) {
+    int result = ERROR_SUCCESS;
+    
+    if (writer->used + size > OUTPUT_BUFFER_SIZE) {
+        result = writer_flush(writer);
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        if (size >= OUTPUT_BUFFER_SIZE) {
+            result = write_all(writer->fd, data, size, writer->position);
+        } else {
+            memcpy(writer->buffer + writer->used, data, size);
+            writer->used += size;
+        }
+    }
+    
+    writer->position += size;
+    return result;
+}
+
+static int writer_fill(output_writer_t* writer, uint8_t value, uint64_t size) {
+    size_t chunk;
+    int result = ERROR_SUCCESS;
+    
+    /* A hole reads back as zeros without touching the disk */
+    if (value == 0 && writer->sparse && size >= OUTPUT_HOLE_SIZE) {
+        result = writer_flush(writer);
+        writer->position += size;
+        return result;
+    }
+    
+    /* Long runs write one filled buffer repeatedly */
+    if (writer->used + size >= 2 * (uint64_t)OUTPUT_BUFFER_SIZE) {
+        result = writer_flush(writer);
+        memset(writer->buffer, value, OUTPUT_BUFFER_SIZE);
+        while (size >= OUTPUT_BUFFER_SIZE && result == ERROR_SUCCESS) {
+            result = write_all(writer->fd, writer->buffer, OUTPUT_BUFFER_SIZE, writer->position);
+            writer->position += OUTPUT_BUFFER_SIZE;
+            size -= OUTPUT_BUFFER_SIZE;
+        }
+    }
+    
+    while (size > 0 && result == ERROR_SUCCESS) {
+        if (writer->used == OUTPUT_BUFFER_SIZE) {
+            result = writer_flush(writer);
+        }
+        
+        chunk = OUTPUT_BUFFER_SIZE - writer->used;
+        if (chunk > size) {
+            chunk = (size_t)size;
+        }
+        
+        memset(writer->buffer + writer->used, value, chunk);
+        writer->used += chunk;
+        writer->position += chunk;
+        size -= chunk;
+    }
+    
+    return result;
+}
+
+static int write_smof_header(const output_generator_t* generator, output_writer_t* writer) {
+    smof_header_t header;
+    smof_header_v2_t header_v2;
+    
+    if (generator->wide) {
+        header_v2 = (smof_header_v2_t) {
+            .magic = SMOF_MAGIC,
+            .version = SMOF_VERSION_2,
+            .flags = generator->config.file_flags,
+            .entry_point = generator->config.entry_point,
+            .section_count = (uint32_t)generator->section_count,
+            .symbol_count = (uint32_t)generator->symbol_count,
+            .reloc_count = (uint32_t)generator->relocation_count,
+            .import_count = 0,
+            .string_table_size = generator->string_table_size,
+            .string_table_offset = generator->string_table_offset,
+            .section_table_offset = sizeof(smof_header_v2_t),
+            .reloc_table_offset = generator->reloc_table_offset
+        };
+        return writer_put(writer, &header_v2, sizeof(header_v2));
+    }
+    
+    header = (smof_header_t) {
+        .magic = SMOF_MAGIC,
+        .version = SMOF_VERSION_CURRENT,
+        .flags = generator->config.file_flags,
+        .entry_point = generator->config.entry_point,
+        .section_count = (uint16_t)generator->section_count,
+        .symbol_count = (uint16_t)generator->symbol_count,
+        .string_table_offset = generator->string_table_offset,
+        .string_table_size = generator->string_table_size,
+        .section_table_offset = sizeof(smof_header_t),
+        .reloc_table_offset = generator->reloc_table_offset,
+        .reloc_count = (uint16_t)generator->relocation_count,
+        .import_count = 0
+    };
+    return writer_put(writer, &header, sizeof(header));
+}
+
+static int write_smof_relocation(const output_generator_t* generator, output_writer_t* writer,
+                                 const output_relocation_t* relocation) {
+    smof_relocation_t entry;
+    smof_relocation_v2_t entry_v2;
+    
+    if (generator->wide) {
+        entry_v2 = (smof_relocation_v2_t) {
+            .offset = relocation->offset,
+            .symbol_index = relocation->symbol,
+            .section_index = relocation->section,
+            .type = relocation->type
+        };
+        return writer_put(writer, &entry_v2, sizeof(entry_v2));
+    }
+    
+    /* The layout only picks v1 when every index fits its fields */
+    entry = (smof_relocation_t) {
+        .offset = relocation->offset,
+        .symbol_index = (uint16_t)relocation->symbol,
+        .type = relocation->type,
+        .section_index = (uint8_t)relocation->section
+    };
+    return writer_put(writer, &entry, sizeof(entry));
+}
+
+static int write_smof_tables(const output_generator_t* generator, output_writer_t* writer) {
+    const output_section_t* section;
+    smof_section_t entry;
+    smof_symbol_t symbol_entry;
+    symbol_t symbol;
+    uint32_t name_offset;
+    size_t i;
+    int result;
+    
+    result = write_smof_header(generator, writer);
+    
+    for (i = 0; i < generator->section_count && result == ERROR_SUCCESS; i++) {
+        section = &generator->sections[i];
+        entry = (smof_section_t) {
+            .name_offset = section->name_offset,
+            .virtual_addr = section->address,
+            .size = section->size,
+            .file_offset = section->file_offset,
+            .flags = section->flags,
+            .alignment = section->alignment,
+            .reserved = 0
+        };
+        result = writer_put(writer, &entry, sizeof(entry));
+    }
+    
+    /* Symbol names follow the section names in the string table */
+    name_offset = generator->section_count > 0 ?
+                  generator->sections[generator->section_count - 1].name_offset +
+                  (uint32_t)strlen(generator->sections[generator->section_count - 1].name) + 1 : 1;
+    
+    for (i = 0; i < generator->symbol_count && result == ERROR_SUCCESS; i++) {
+        symbol_table_get(generator->symbols, (symbol_handle_t)i, &symbol);
+        symbol_entry = (smof_symbol_t) {
+            .name_offset = name_offset,
+            .value = symbol.value,
+            .size = symbol.size,
+            .section_index = symbol.section_index,
+            .type = (uint8_t)symbol.type,
+            .binding = (uint8_t)symbol.binding
+        };
+        name_offset += (uint32_t)strlen(symbol.name) + 1;
+        result = writer_put(writer, &symbol_entry, sizeof(symbol_entry));
+    }
+    
+    for (i = 0; i < generator->relocation_count && result == ERROR_SUCCESS; i++) {
+        result = write_smof_relocation(generator, writer, &generator->relocations[i]);
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        result = writer_fill(writer, 0, 1);
+    }
+    
+    for (i = 0; i < generator->section_count && result == ERROR_SUCCESS; i++) {
+        result = writer_put(writer, generator->sections[i].name,
+                            strlen(generator->sections[i].name) + 1);
+    }
+    
+    for (i = 0; i < generator->symbol_count && result == ERROR_SUCCESS; i++) {
+        const char* name = symbol_table_get_name(generator->symbols, (symbol_handle_t)i);
+        
+        result = writer_put(writer, name, strlen(name) + 1);
+    }
+    
+    return result;
+}
+
+/* Contiguous data, or the fragments with zeros between and after them */
+static int write_contents(const output_section_t* section, output_writer_t* writer) {
+    const section_fragment_t* fragment;
+    uint64_t start = writer->position;
+    int result = ERROR_SUCCESS;
+    
+    if (section->fragments == NULL) {
+        return writer_put(writer, section->data, section->size);
+    }
+    
+    for (fragment = section->fragments; fragment != NULL && result == ERROR_SUCCESS;
+         fragment = fragment->next) {
+        result = writer_fill(writer, 0, start + fragment->offset - writer->position);
+        if (result == ERROR_SUCCESS) {
+            result = fragment->data != NULL ?
+                     writer_put(writer, fragment->data, fragment->size) :
+                     writer_fill(writer, 0, fragment->size);
+        }
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        result = writer_fill(writer, 0, start + section->size - writer->position);
+    }
+    
+    return result;
+}
+
+static int write_smof(const output_generator_t* generator, output_writer_t* writer) {
+    const output_section_t* section;
+    size_t i;
+    int result = write_smof_tables(generator, writer);
+    
+    for (i = 0; i < generator->section_count && result == ERROR_SUCCESS; i++) {
+        section = &generator->sections[i];
+        
+        if (section->file_offset != 0) {
+            result = writer_fill(writer, 0, section->file_offset - writer->position);
+            if (result == ERROR_SUCCESS) {
+                result = write_contents(section, writer);
+            }
+        }
+    }
+    
+    return result;
+}
+
+static int write_flat(const output_generator_t* generator, output_writer_t* writer) {
+    const output_section_t* section;
+    uint8_t gap = generator->config.fill_gaps ? generator->config.fill_value : 0;
+    uint64_t start;
+    uint64_t length;
+    size_t i;
+    int result = ERROR_SUCCESS;
+    
+    for (i = 0; i < generator->order_count && result == ERROR_SUCCESS; i++) {
+        section = &generator->sections[(uint32_t)generator->order[i]];
+        start = section->address - generator->config.base_address;
+        
+        /* Trailing zero-fill sections are not part of the image */
+        if (start >= generator->file_size) {
+            break;
+        }
+        
+        length = section->size;
+        if (length > generator->file_size - start) {
+            length = generator->file_size - start;
+        }
+        
+        result = writer_fill(writer, gap, start - writer->position);
+        if (result == ERROR_SUCCESS) {
+            result = has_contents(section) ? write_contents(section, writer) :
+                     writer_fill(writer, 0, length);
+        }
+    }
+    
+    return result;
+}
+
+int output_generator_generate_to_file(output_generator_t* generator, const char* filename) {
+    output_writer_t writer;
+    int result;
+    
+    if (generator == NULL || filename == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    result = compute_layout(generator);
+    if (result != ERROR_SUCCESS) {
+        return result;
+    }
+    
+    writer = (output_writer_t) {
+        .fd = -1,
+        .buffer = malloc(OUTPUT_BUFFER_SIZE),
+        .used = 0,
+        .position = 0,
+        .sparse = generator->config.type == OUTPUT_TYPE_SMOF || !generator->config.fill_gaps
+    };
+    if (writer.buffer == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate output buffer");
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    writer.fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (writer.fd < 0) {
+        ERROR_REPORT_ERROR(ERROR_FILE_IO, "Failed to create output file");
+        free(writer.buffer);
+        return ERROR_FILE_IO;
+    }
+    
+    result = generator->config.type == OUTPUT_TYPE_BINARY_FLAT ?
+             write_flat(generator, &writer) : write_smof(generator, &writer);
+    if (result == ERROR_SUCCESS) {
+        result = writer_flush(&writer);
+    }
+    
+    /* A trailing hole only exists once the file is extended over it */
+    if (result == ERROR_SUCCESS && ftruncate(writer.fd, (off_t)writer.position) != 0) {
+        ERROR_REPORT_ERROR(ERROR_FILE_IO, "Failed to size output file");
+        result = ERROR_FILE_IO;
+    }
+    
+    if (close(writer.fd) != 0 && result == ERROR_SUCCESS) {
+        ERROR_REPORT_ERROR(ERROR_FILE_IO, "Failed to close output file");
+        result = ERROR_FILE_IO;
+    }
+    free(writer.buffer);
+    
+    /* Do not leave a truncated output behind */
+    if (result != ERROR_SUCCESS) {
+        unlink(filename);
+    }
+    
+    return result;
+}
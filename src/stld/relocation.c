@@ -1,12 +1,672 @@
 /* src/stld/relocation.c */
+#include "include/relocation.h"
+#include "../common/include/error.h"
+#include "../common/include/thread_pool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 /**
  * @file relocation.c
  * @brief Relocation processing for STLD linker
- * @details C99 compliant relocation handling
+ * @details C99 compliant relocation handling. A pass resolves every entry
+ * to a 32-bit target value first, then partitions the compact patch
+ * records by target section with a counting sort. Each partition is
+ * sorted by its (type, offset) key on its own, possibly on a worker
+ * thread; each run of equal type is one group whose bounds are checked
+ * once against the last (largest) offset before a per-type kernel
+ * applies the whole run in address order.
  */
 
-/* TODO: Implement relocation processing functions */
+#define RELOCATION_INITIAL_CAPACITY 256
+#define RELOCATION_SLOT_NONE 0xFFFFFFFFU
 
-/* Dummy variable to satisfy ISO C empty translation unit requirement */
-static const int relocation_dummy_variable __attribute__((unused)) = 0;
\ No newline at end of file
+/* Fewer entries than this are applied on the calling thread */
+#define RELOCATION_PARALLEL_MIN 4096
+
+/* Sort key layout: section id (24) | type (8) | offset (32) */
+#define PATCH_KEY(section, type, offset) \
+    (((uint64_t)(section) << 40) | ((uint64_t)(type) << 32) | (uint64_t)(offset))
+#define PATCH_KEY_SECTION(key) ((uint32_t)((key) >> 40))
+#define PATCH_KEY_TYPE(key)    ((relocation_type_t)(((key) >> 32) & 0xFFU))
+#define PATCH_KEY_OFFSET(key)  ((uint32_t)(key))
+#define PATCH_KEY_GROUP(key)   ((key) >> 32)
+
+/* Target section registered by the caller */
+typedef struct relocation_section {
+    uint8_t* data;                  /* Section contents, NULL if unregistered */
+    uint32_t size;                  /* Section size in bytes */
+    uint32_t address;               /* Load address of the section */
+} relocation_section_t;
+
+/* Resolved relocation, 16 bytes, sorted in place */
+typedef struct relocation_patch {
+    uint64_t key;                   /* PATCH_KEY(section, type, offset) */
+    uint32_t target;                /* S + A, or G + A for GOT */
+    uint32_t sequence;              /* Insertion order, keeps the sort stable */
+} relocation_patch_t;
+
+/* Patches of one section, sorted and applied by one task */
+typedef struct relocation_partition {
+    size_t start;                   /* First patch in the partitioned array */
+    size_t count;                   /* Patches in this partition */
+    size_t group_count;             /* Groups applied */
+    double type_time[RELOC_TYPE_COUNT];  /* Kernel time, summed after the batch */
+} relocation_partition_t;
+
+/*
+ * Patch kernel: apply count patches of one type to one section. Returns
+ * the number applied, which is less than count at the first value that
+ * does not fit the field.
+ */
+typedef size_t (*relocation_kernel_t)(uint8_t* data, uint32_t address,
+                                      const relocation_patch_t* patches, size_t count);
+
+/* Relocation engine structure */
+struct relocation_engine {
+    const symbol_table_t* symbols;  /* Resolution source (not owned) */
+    thread_pool_t* pool;            /* Workers for partitions (not owned) */
+    relocation_entry_t* entries;    /* Entries in insertion order */
+    size_t count;                   /* Number of entries */
+    size_t capacity;                /* Allocated entries */
+    relocation_section_t* sections; /* Indexed by section id */
+    size_t section_count;           /* Allocated section slots */
+    uint32_t got_address;           /* Base address of the GOT */
+    uint32_t* got;                  /* GOT contents, one address per slot */
+    size_t got_count;               /* GOT slots in use */
+    size_t resolved;                /* Entries applied by the last pass */
+    size_t group_count;             /* Groups applied by the last pass */
+    size_t type_counts[RELOC_TYPE_COUNT];
+    double type_time[RELOC_TYPE_COUNT];
+    double process_time;
+};
+
+/* Shared state of one parallel apply batch */
+typedef struct relocation_batch {
+    const relocation_engine_t* engine;
+    relocation_patch_t* patches;    /* Partitioned by section */
+    relocation_partition_t* partitions;
+} relocation_batch_t;
+
+/* Section bucket, with unregistered ids mapped to the last one */
+static size_t section_bucket(uint32_t section_id, size_t section_count) {
+    return section_id < section_count ? section_id : section_count;
+}
+
+static void write_le16(uint8_t* p, uint16_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
+
+static void write_le32(uint8_t* p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+/* 16-bit fields accept zero- or sign-extended values */
+static bool fits_abs16(uint32_t value) {
+    return value <= 0xFFFFU || value >= 0xFFFF8000U;
+}
+
+static bool fits_rel16(uint32_t value) {
+    return value <= 0x7FFFU || value >= 0xFFFF8000U;
+}
+
+static size_t apply_none(uint8_t* data, uint32_t address,
+                         const relocation_patch_t* patches, size_t count) {
+    (void)data;
+    (void)address;
+    (void)patches;
+    
+    return count;
+}
+
+static size_t apply_abs32(uint8_t* data, uint32_t address,
+                          const relocation_patch_t* patches, size_t count) {
+    size_t i;
+    
+    (void)address;
+    for (i = 0; i < count; i++) {
+        write_le32(data + PATCH_KEY_OFFSET(patches[i].key), patches[i].target);
+    }
+    
+    return count;
+}
+
+static size_t apply_rel32(uint8_t* data, uint32_t address,
+                          const relocation_patch_t* patches, size_t count) {
+    size_t i;
+    
+    for (i = 0; i < count; i++) {
+        uint32_t offset = PATCH_KEY_OFFSET(patches[i].key);
+        
+        write_le32(data + offset, patches[i].target - (address + offset));
+    }
+    
+    return count;
+}
+
+static size_t apply_abs16(uint8_t* data, uint32_t address,
+                          const relocation_patch_t* patches, size_t count) {
+    size_t i;
+    
+    (void)address;
+    for (i = 0; i < count; i++) {
+        if (!fits_abs16(patches[i].target)) {
+            return i;
+        }
+        write_le16(data + PATCH_KEY_OFFSET(patches[i].key), (uint16_t)patches[i].target);
+    }
+    
+    return count;
+}
+
+static size_t apply_rel16(uint8_t* data, uint32_t address,
+                          const relocation_patch_t* patches, size_t count) {
+    size_t i;
+    
+    for (i = 0; i < count; i++) {
+        uint32_t offset = PATCH_KEY_OFFSET(patches[i].key);
+        uint32_t value = patches[i].target - (address + offset);
+        
+        if (!fits_rel16(value)) {
+            return i;
+        }
+        write_le16(data + offset, (uint16_t)value);
+    }
+    
+    return count;
+}
+
+/* GOT targets are resolved to slot addresses, PLT binds directly */
+static const relocation_kernel_t relocation_kernels[RELOC_TYPE_COUNT] = {
+    apply_none,     /* NONE */
+    apply_abs32,    /* ABS32 */
+    apply_rel32,    /* REL32 */
+    apply_abs16,    /* ABS16 */
+    apply_rel16,    /* REL16 */
+    apply_abs32,    /* SYSCALL */
+    apply_abs32,    /* GOT */
+    apply_rel32     /* PLT */
+};
+
+static double elapsed_seconds(const struct timespec* start) {
+    struct timespec now;
+    
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) +
+           (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static int compare_patches(const void* a, const void* b) {
+    const relocation_patch_t* pa = a;
+    const relocation_patch_t* pb = b;
+    
+    if (pa->key != pb->key) {
+        return pa->key < pb->key ? -1 : 1;
+    }
+    
+    return pa->sequence < pb->sequence ? -1 : (pa->sequence > pb->sequence);
+}
+
+relocation_engine_t* relocation_engine_create(const symbol_table_t* symbols) {
+    relocation_engine_t* engine;
+    
+    if (symbols == NULL) {
+        ERROR_REPORT_ERROR(ERROR_INVALID_ARGUMENT, "Relocation engine needs a symbol table");
+        return NULL;
+    }
+    
+    engine = malloc(sizeof(relocation_engine_t));
+    if (engine == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate relocation engine");
+        return NULL;
+    }
+    
+    *engine = (relocation_engine_t) {
+        .symbols = symbols,
+        .pool = NULL,
+        .entries = NULL,
+        .count = 0,
+        .capacity = 0,
+        .sections = NULL,
+        .section_count = 0,
+        .got_address = 0,
+        .got = NULL,
+        .got_count = 0,
+        .resolved = 0,
+        .group_count = 0,
+        .process_time = 0.0
+    };
+    
+    return engine;
+}
+
+void relocation_engine_destroy(relocation_engine_t* engine) {
+    if (engine != NULL) {
+        free(engine->entries);
+        free(engine->sections);
+        free(engine->got);
+        free(engine);
+    }
+}
+
+void relocation_engine_clear(relocation_engine_t* engine) {
+    size_t i;
+    
+    if (engine == NULL) {
+        return;
+    }
+    
+    engine->count = 0;
+    engine->got_count = 0;
+    engine->resolved = 0;
+    engine->group_count = 0;
+    engine->process_time = 0.0;
+    for (i = 0; i < RELOC_TYPE_COUNT; i++) {
+        engine->type_counts[i] = 0;
+        engine->type_time[i] = 0.0;
+    }
+    for (i = 0; i < engine->section_count; i++) {
+        engine->sections[i] = (relocation_section_t) { NULL, 0, 0 };
+    }
+}
+
+int relocation_engine_set_section(relocation_engine_t* engine, uint32_t section_id,
+                                  uint8_t* data, uint32_t size, uint32_t address) {
+    if (engine == NULL || section_id >= RELOCATION_MAX_SECTIONS) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    if (section_id >= engine->section_count) {
+        size_t new_count = engine->section_count ? engine->section_count : 16;
+        relocation_section_t* new_sections;
+        size_t i;
+        
+        while (new_count <= section_id) {
+            new_count *= 2;
+        }
+        
+        new_sections = realloc(engine->sections, new_count * sizeof(relocation_section_t));
+        if (new_sections == NULL) {
+            ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to grow relocation sections");
+            return ERROR_OUT_OF_MEMORY;
+        }
+        
+        for (i = engine->section_count; i < new_count; i++) {
+            new_sections[i] = (relocation_section_t) { NULL, 0, 0 };
+        }
+        engine->sections = new_sections;
+        engine->section_count = new_count;
+    }
+    
+    engine->sections[section_id] = (relocation_section_t) {
+        .data = data,
+        .size = size,
+        .address = address
+    };
+    
+    return ERROR_SUCCESS;
+}
+
+void relocation_engine_set_thread_pool(relocation_engine_t* engine, thread_pool_t* pool) {
+    if (engine != NULL) {
+        engine->pool = pool;
+    }
+}
+
+void relocation_engine_set_got_address(relocation_engine_t* engine, uint32_t address) {
+    if (engine != NULL) {
+        engine->got_address = address;
+    }
+}
+
+relocation_id_t relocation_engine_add_entry(relocation_engine_t* engine,
+                                            const relocation_entry_t* entry) {
+    if (engine == NULL || entry == NULL) {
+        ERROR_REPORT_ERROR(ERROR_INVALID_ARGUMENT, "Invalid relocation entry");
+        return RELOCATION_ID_INVALID;
+    }
+    
+    if ((unsigned)entry->type >= RELOC_TYPE_COUNT || entry->section_id >= RELOCATION_MAX_SECTIONS) {
+        ERROR_REPORT_ERROR(ERROR_INVALID_RELOCATION, "Unsupported relocation");
+        return RELOCATION_ID_INVALID;
+    }
+    
+    if (engine->count >= engine->capacity) {
+        size_t new_capacity = engine->capacity ? engine->capacity * 2 : RELOCATION_INITIAL_CAPACITY;
+        relocation_entry_t* new_entries;
+        
+        if (new_capacity >= RELOCATION_ID_INVALID) {
+            ERROR_REPORT_ERROR(ERROR_SYSTEM_LIMIT, "Too many relocations");
+            return RELOCATION_ID_INVALID;
+        }
+        
+        new_entries = realloc(engine->entries, new_capacity * sizeof(relocation_entry_t));
+        if (new_entries == NULL) {
+            ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to grow relocation table");
+            return RELOCATION_ID_INVALID;
+        }
+        engine->entries = new_entries;
+        engine->capacity = new_capacity;
+    }
+    
+    engine->entries[engine->count] = *entry;
+    engine->type_counts[entry->type]++;
+    engine->resolved = 0;
+    
+    return (relocation_id_t)engine->count++;
+}
+
+/* Hand out (or reuse) the GOT slot holding a symbol's address */
+static uint32_t got_slot(relocation_engine_t* engine, uint32_t* slot_map,
+                         symbol_handle_t handle, uint32_t address) {
+    if (slot_map[handle] == RELOCATION_SLOT_NONE) {
+        slot_map[handle] = (uint32_t)engine->got_count;
+        engine->got[engine->got_count++] = address;
+    }
+    
+    return slot_map[handle];
+}
+
+static void report_undefined(const relocation_engine_t* engine, symbol_handle_t handle,
+                             size_t unresolved) {
+    char message[ERROR_MSG_MAX_LENGTH];
+    const char* name = symbol_table_get_name(engine->symbols, handle);
+    
+    error_format_message(message, sizeof(message), "Undefined symbol '%s' (%lu unresolved)",
+                         name ? name : "?", (unsigned long)unresolved);
+    ERROR_REPORT_ERROR(ERROR_SYMBOL_NOT_FOUND, message);
+}
+
+/* Resolve every entry into a patch record; fails on undefined references */
+static int resolve_entries(relocation_engine_t* engine, relocation_patch_t* patches) {
+    size_t symbol_count = symbol_table_size(engine->symbols);
+    uint32_t* slot_map = NULL;
+    symbol_handle_t first_undefined = SYMBOL_HANDLE_INVALID;
+    size_t unresolved = 0;
+    size_t i;
+    
+    if (engine->type_counts[RELOC_TYPE_GOT] > 0) {
+        slot_map = malloc((symbol_count + 1) * sizeof(uint32_t));
+        free(engine->got);
+        engine->got = malloc(engine->type_counts[RELOC_TYPE_GOT] * sizeof(uint32_t));
+        if (slot_map == NULL || engine->got == NULL) {
+            free(slot_map);
+            ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate GOT");
+            return ERROR_OUT_OF_MEMORY;
+        }
+        memset(slot_map, 0xFF, symbol_count * sizeof(uint32_t));
+    }
+    engine->got_count = 0;
+    
+    for (i = 0; i < engine->count; i++) {
+        const relocation_entry_t* entry = &engine->entries[i];
+        symbol_handle_t handle = entry->symbol_handle;
+        uint32_t address = 0;
+        uint32_t slot;
+        
+        if (handle >= symbol_count) {
+            unresolved++;
+            continue;
+        }
+        
+        if (symbol_table_get_section_index(engine->symbols, handle) != SECTION_INDEX_UNDEFINED) {
+            address = symbol_table_get_value(engine->symbols, handle);
+        } else if (symbol_table_get_binding(engine->symbols, handle) != SYMBOL_BINDING_WEAK) {
+            if (first_undefined == SYMBOL_HANDLE_INVALID) {
+                first_undefined = handle;
+            }
+            unresolved++;
+            continue;
+        }
+        
+        if (entry->type == RELOC_TYPE_GOT) {
+            slot = got_slot(engine, slot_map, handle, address);
+            address = engine->got_address + slot * (uint32_t)sizeof(uint32_t);
+        }
+        
+        patches[i] = (relocation_patch_t) {
+            .key = PATCH_KEY(entry->section_id, entry->type, entry->offset),
+            .target = address + (uint32_t)entry->addend,
+            .sequence = (uint32_t)i
+        };
+    }
+    
+    free(slot_map);
+    
+    if (unresolved > 0) {
+        if (first_undefined != SYMBOL_HANDLE_INVALID) {
+            report_undefined(engine, first_undefined, unresolved);
+        } else {
+            ERROR_REPORT_ERROR(ERROR_SYMBOL_NOT_FOUND, "Relocation against invalid symbol");
+        }
+        return ERROR_SYMBOL_NOT_FOUND;
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+/* Apply one (section, type) group, timing the kernel into type_time */
+static int apply_group(const relocation_engine_t* engine, const relocation_patch_t* patches,
+                       size_t count, double* type_time) {
+    uint32_t section_id = PATCH_KEY_SECTION(patches[0].key);
+    relocation_type_t type = PATCH_KEY_TYPE(patches[0].key);
+    uint32_t last = PATCH_KEY_OFFSET(patches[count - 1].key);
+    const relocation_section_t* section;
+    struct timespec start;
+    size_t applied;
+    
+    if (type == RELOC_TYPE_NONE) {
+        return ERROR_SUCCESS;
+    }
+    
+    /* Sorted by offset, so the last field bounds the whole group */
+    section = section_id < engine->section_count ? &engine->sections[section_id] : NULL;
+    if (section == NULL || section->data == NULL ||
+        section->size < relocation_type_width(type) ||
+        last > section->size - relocation_type_width(type)) {
+        ERROR_REPORT_ERROR(ERROR_INVALID_RELOCATION, "Relocation outside its section");
+        return ERROR_INVALID_RELOCATION;
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    applied = relocation_kernels[type](section->data, section->address, patches, count);
+    type_time[type] += elapsed_seconds(&start);
+    
+    if (applied != count) {
+        ERROR_REPORT_ERROR(ERROR_RELOCATION_FAILED, "Relocation overflow: value out of range");
+        return ERROR_RELOCATION_FAILED;
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+/*
+ * Sort and apply one section's patches. Partitions never share a section
+ * and only read the engine, so they can run on any thread.
+ */
+static int apply_partition_task(void* user_data, size_t index) {
+    relocation_batch_t* batch = user_data;
+    relocation_partition_t* partition = &batch->partitions[index];
+    relocation_patch_t* patches = batch->patches + partition->start;
+    size_t group_start = 0;
+    size_t i;
+    int result = ERROR_SUCCESS;
+    
+    qsort(patches, partition->count, sizeof(relocation_patch_t), compare_patches);
+    
+    for (i = 1; i <= partition->count && result == ERROR_SUCCESS; i++) {
+        if (i == partition->count ||
+            PATCH_KEY_GROUP(patches[i].key) != PATCH_KEY_GROUP(patches[group_start].key)) {
+            result = apply_group(batch->engine, &patches[group_start], i - group_start,
+                                 partition->type_time);
+            partition->group_count++;
+            group_start = i;
+        }
+    }
+    
+    return result;
+}
+
+/*
+ * Stable counting sort of the resolved patches by section into sorted,
+ * recording one partition per non-empty section. Ids without a registered
+ * section share a final bucket, which fails when applied.
+ */
+static size_t partition_patches(const relocation_engine_t* engine,
+                                const relocation_patch_t* patches, relocation_patch_t* sorted,
+                                size_t* offsets, relocation_partition_t* partitions) {
+    size_t buckets = engine->section_count + 1;
+    size_t partition_count = 0;
+    size_t total = 0;
+    size_t i;
+    
+    memset(offsets, 0, buckets * sizeof(size_t));
+    for (i = 0; i < engine->count; i++) {
+        offsets[section_bucket(PATCH_KEY_SECTION(patches[i].key), engine->section_count)]++;
+    }
+    
+    for (i = 0; i < buckets; i++) {
+        size_t count = offsets[i];
+        
+        if (count > 0) {
+            partitions[partition_count++] = (relocation_partition_t) {
+                .start = total,
+                .count = count,
+                .group_count = 0
+            };
+        }
+        offsets[i] = total;
+        total += count;
+    }
+    
+    for (i = 0; i < engine->count; i++) {
+        sorted[offsets[section_bucket(PATCH_KEY_SECTION(patches[i].key),
+                                        engine->section_count)]++] = patches[i];
+    }
+    
+    return partition_count;
+}
+
+int relocation_engine_process_all(relocation_engine_t* engine) {
+    relocation_patch_t* patches;
+    relocation_patch_t* sorted;
+    relocation_partition_t* partitions;
+    size_t* offsets;
+    relocation_batch_t batch;
+    struct timespec start;
+    size_t partition_count = 0;
+    size_t buckets;
+    size_t i;
+    size_t j;
+    int result;
+    
+    if (engine == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    engine->resolved = 0;
+    engine->group_count = 0;
+    for (i = 0; i < RELOC_TYPE_COUNT; i++) {
+        engine->type_time[i] = 0.0;
+    }
+    
+    if (engine->count == 0) {
+        engine->process_time = elapsed_seconds(&start);
+        return ERROR_SUCCESS;
+    }
+    
+    buckets = engine->section_count + 1;
+    patches = malloc(engine->count * sizeof(relocation_patch_t));
+    sorted = malloc(engine->count * sizeof(relocation_patch_t));
+    partitions = malloc(buckets * sizeof(relocation_partition_t));
+    offsets = malloc(buckets * sizeof(size_t));
+    
+    if (patches == NULL || sorted == NULL || partitions == NULL || offsets == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate relocation patches");
+        result = ERROR_OUT_OF_MEMORY;
+    } else {
+        result = resolve_entries(engine, patches);
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        partition_count = partition_patches(engine, patches, sorted, offsets, partitions);
+        
+        batch = (relocation_batch_t) {
+            .engine = engine,
+            .patches = sorted,
+            .partitions = partitions
+        };
+        
+        /* Small batches are not worth waking the workers for */
+        result = thread_pool_run(engine->count >= RELOCATION_PARALLEL_MIN ? engine->pool : NULL,
+                                 partition_count, apply_partition_task, &batch);
+        
+        for (i = 0; i < partition_count; i++) {
+            engine->group_count += partitions[i].group_count;
+            for (j = 0; j < RELOC_TYPE_COUNT; j++) {
+                engine->type_time[j] += partitions[i].type_time[j];
+            }
+        }
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        engine->resolved = engine->count;
+    }
+    
+    free(offsets);
+    free(partitions);
+    free(sorted);
+    free(patches);
+    engine->process_time = elapsed_seconds(&start);
+    
+    return result;
+}
+
+size_t relocation_engine_get_count(const relocation_engine_t* engine) {
+    return engine ? engine->count : 0;
+}
+
+bool relocation_engine_has_unresolved(const relocation_engine_t* engine) {
+    return engine != NULL && engine->resolved < engine->count;
+}
+
+relocation_stats_t relocation_engine_get_statistics(const relocation_engine_t* engine) {
+    relocation_stats_t stats;
+    size_t i;
+    
+    memset(&stats, 0, sizeof(stats));
+    if (engine == NULL) {
+        return stats;
+    }
+    
+    stats.total_relocations = engine->count;
+    stats.resolved_relocations = engine->resolved;
+    stats.unresolved_relocations = engine->count - engine->resolved;
+    stats.pc_relative_count = engine->type_counts[RELOC_TYPE_REL32] +
+                              engine->type_counts[RELOC_TYPE_REL16] +
+                              engine->type_counts[RELOC_TYPE_PLT];
+    stats.absolute_count = engine->type_counts[RELOC_TYPE_ABS32] +
+                           engine->type_counts[RELOC_TYPE_ABS16];
+    stats.got_entries = engine->got_count;
+    stats.group_count = engine->group_count;
+    stats.process_time = engine->process_time;
+    for (i = 0; i < RELOC_TYPE_COUNT; i++) {
+        stats.type_counts[i] = engine->type_counts[i];
+        stats.type_time[i] = engine->type_time[i];
+    }
+    
+    return stats;
+}
+
+const uint32_t* relocation_engine_get_got(const relocation_engine_t* engine, size_t* count) {
+    if (count != NULL) {
+        *count = engine ? engine->got_count : 0;
+    }
+    
+    return engine ? engine->got : NULL;
+}
@@ -0,0 +1,647 @@
+/* src/stld/script.c */
+#include "include/script.h"
+#include "../common/include/error.h"
+#include "../common/include/memory.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file script.c
+ * @brief Linker script parser and section matcher for STLD
+ * @details C99 compliant recursive-descent parser over a small lexer.
+ * Patterns go straight into the matching trie as they are parsed: each
+ * node stands for a literal prefix and records the first rule whose
+ * pattern is exactly that prefix, the first rule whose pattern is that
+ * prefix followed by a lone '*', and, in rule order, the patterns that
+ * continue with any other wildcard.
+ */
+
+#define SCRIPT_INITIAL_CAPACITY 8
+#define SCRIPT_MESSAGE_SIZE 160
+
+/* Pattern continuing with a wildcard below its trie node */
+typedef struct script_glob {
+    const char* pattern;            /* From the first wildcard on */
+    uint32_t rule;
+    struct script_glob* next;       /* Rule order */
+} script_glob_t;
+
+/* Trie node; children are a sibling list */
+typedef struct script_node {
+    struct script_node* children;
+    struct script_node* next;
+    script_glob_t* globs;
+    script_glob_t* last_glob;
+    uint32_t exact;                 /* First rule equal to the prefix */
+    uint32_t prefix;                /* First rule equal to the prefix then '*' */
+    char ch;
+} script_node_t;
+
+/* Linker script structure */
+struct linker_script {
+    memory_pool_t* pool;            /* Backs every allocation (not owned) */
+    const char* entry;
+    script_output_t* outputs;
+    size_t output_count;
+    size_t output_capacity;
+    script_rule_t* rules;
+    size_t rule_count;
+    size_t rule_capacity;
+    script_node_t root;
+};
+
+/* Token kinds; punctuation is its own character */
+#define TOKEN_END  0
+#define TOKEN_NAME 1
+
+typedef struct script_parser {
+    linker_script_t* script;
+    const char* end;
+    const char* token;              /* Current token */
+    size_t length;
+    int kind;                       /* TOKEN_* or the punctuation character */
+    unsigned int line;
+} script_parser_t;
+
+static int parser_error(const script_parser_t* parser, const char* message) {
+    char buffer[SCRIPT_MESSAGE_SIZE];
+    
+    snprintf(buffer, sizeof(buffer), "Linker script line %u: %s", parser->line, message);
+    ERROR_REPORT_ERROR(ERROR_SCRIPT_SYNTAX, buffer);
+    return ERROR_SCRIPT_SYNTAX;
+}
+
+static bool is_name_char(char c) {
+    return c != '\0' && strchr("(){}:;=,", c) == NULL &&
+           c != ' ' && c != '\t' && c != '\n' && c != '\r';
+}
+
+/* Advance to the next token, skipping blanks and comments */
+static int next_token(script_parser_t* parser) {
+    const char* p = parser->token + parser->length;
+    bool skipping = true;
+    
+    while (skipping) {
+        while (p < parser->end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' ||
+                                   *p == ',')) {
+            if (*p == '\n') {
+                parser->line++;
+            }
+            p++;
+        }
+        
+        skipping = p + 1 < parser->end && p[0] == '/' && p[1] == '*';
+        if (skipping) {
+            for (p += 2; p + 1 < parser->end && !(p[0] == '*' && p[1] == '/'); p++) {
+                if (*p == '\n') {
+                    parser->line++;
+                }
+            }
+            if (p + 1 >= parser->end) {
+                parser->token = p;
+                parser->length = 0;
+                return parser_error(parser, "unterminated comment");
+            }
+            p += 2;
+        }
+    }
+    
+    parser->token = p;
+    if (p == parser->end || *p == '\0') {
+        parser->kind = TOKEN_END;
+        parser->length = 0;
+    } else if (is_name_char(*p)) {
+        parser->kind = TOKEN_NAME;
+        while (p < parser->end && is_name_char(*p)) {
+            p++;
+        }
+        parser->length = (size_t)(p - parser->token);
+    } else {
+        parser->kind = (unsigned char)*p;
+        parser->length = 1;
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+static bool token_is(const script_parser_t* parser, const char* word) {
+    return parser->kind == TOKEN_NAME && strlen(word) == parser->length &&
+           memcmp(parser->token, word, parser->length) == 0;
+}
+
+/* Consume a punctuation character */
+static int expect(script_parser_t* parser, char c, const char* message) {
+    if (parser->kind != (unsigned char)c) {
+        return parser_error(parser, message);
+    }
+    return next_token(parser);
+}
+
+static char* copy_token(script_parser_t* parser) {
+    char* copy = memory_pool_alloc(parser->script->pool, parser->length + 1);
+    
+    if (copy != NULL) {
+        memcpy(copy, parser->token, parser->length);
+        copy[parser->length] = '\0';
+    }
+    return copy;
+}
+
+/* Number with an optional K or M suffix */
+static int parse_number(script_parser_t* parser, uint32_t* value) {
+    char digits[32];
+    unsigned long long number;
+    char* rest;
+    
+    if (parser->kind != TOKEN_NAME || parser->length >= sizeof(digits) ||
+        parser->token[0] < '0' || parser->token[0] > '9') {
+        return parser_error(parser, "expected a number");
+    }
+    
+    memcpy(digits, parser->token, parser->length);
+    digits[parser->length] = '\0';
+    number = strtoull(digits, &rest, 0);
+    if (*rest == 'K' || *rest == 'k') {
+        number <<= 10;
+        rest++;
+    } else if (*rest == 'M' || *rest == 'm') {
+        number <<= 20;
+        rest++;
+    }
+    
+    if (*rest != '\0' || number > UINT32_MAX) {
+        return parser_error(parser, "invalid number");
+    }
+    
+    *value = (uint32_t)number;
+    return next_token(parser);
+}
+
+/* Grow a pool array by copying; the old block goes back to the pool */
+static void* grow_array(memory_pool_t* pool, void* array, size_t used,
+                        size_t* capacity, size_t element_size) {
+    size_t new_capacity = *capacity > 0 ? *capacity * 2 : SCRIPT_INITIAL_CAPACITY;
+    void* grown = memory_pool_alloc(pool, new_capacity * element_size);
+    
+    if (grown != NULL) {
+        if (array != NULL) {
+            memcpy(grown, array, used * element_size);
+            memory_pool_free_sized(pool, array, *capacity * element_size);
+        }
+        *capacity = new_capacity;
+    }
+    return grown;
+}
+
+static bool is_wildcard(char c) {
+    return c == '*' || c == '?' || c == '[';
+}
+
+static script_node_t* find_child(const script_node_t* node, char c) {
+    script_node_t* child = node->children;
+    
+    while (child != NULL && child->ch != c) {
+        child = child->next;
+    }
+    return child;
+}
+
+static int add_pattern(linker_script_t* script, const char* pattern, uint32_t rule) {
+    script_node_t* node = &script->root;
+    script_node_t* child;
+    script_glob_t* glob;
+    
+    for (; *pattern != '\0' && !is_wildcard(*pattern); pattern++) {
+        child = find_child(node, *pattern);
+        if (child == NULL) {
+            child = memory_pool_calloc(script->pool, 1, sizeof(script_node_t));
+            if (child == NULL) {
+                return ERROR_OUT_OF_MEMORY;
+            }
+            child->ch = *pattern;
+            child->exact = SCRIPT_NO_RULE;
+            child->prefix = SCRIPT_NO_RULE;
+            child->next = node->children;
+            node->children = child;
+        }
+        node = child;
+    }
+    
+    /* Rules arrive in order, so the first one recorded at a node wins */
+    if (*pattern == '\0') {
+        if (node->exact == SCRIPT_NO_RULE) {
+            node->exact = rule;
+        }
+    } else if (strcmp(pattern, "*") == 0) {
+        if (node->prefix == SCRIPT_NO_RULE) {
+            node->prefix = rule;
+        }
+    } else {
+        glob = memory_pool_alloc(script->pool, sizeof(script_glob_t));
+        if (glob == NULL) {
+            return ERROR_OUT_OF_MEMORY;
+        }
+        *glob = (script_glob_t) {
+            .pattern = pattern,
+            .rule = rule,
+            .next = NULL
+        };
+        if (node->last_glob != NULL) {
+            node->last_glob->next = glob;
+        } else {
+            node->globs = glob;
+        }
+        node->last_glob = glob;
+    }
+    
+    return ERROR_SUCCESS;
+}
+
+/* Match "[set]" at pattern against c; returns the pattern after the set */
+static const char* match_set(const char* pattern, char c, bool* matched) {
+    bool negate = pattern[1] == '!' || pattern[1] == '^';
+    const char* p = pattern + (negate ? 2 : 1);
+    bool found = false;
+    
+    if (*p == '\0') {
+        *matched = false;
+        return p;
+    }
+    
+    /* A ']' right after the bracket is a member */
+    do {
+        if (p[1] == '-' && p[2] != ']' && p[2] != '\0') {
+            found = found || (c >= p[0] && c <= p[2]);
+            p += 3;
+        } else {
+            found = found || c == *p;
+            p++;
+        }
+    } while (*p != ']' && *p != '\0');
+    
+    *matched = *p == ']' && found != negate;
+    return *p == ']' ? p + 1 : p;
+}
+
+/* Glob match with '*', '?' and '[...]'; backtracks only to the last '*' */
+static bool glob_match(const char* pattern, const char* name) {
+    const char* star = NULL;
+    const char* resume = name;
+    const char* after;
+    bool matched;
+    
+    while (*name != '\0') {
+        if (*pattern == '*') {
+            star = ++pattern;
+            resume = name;
+            continue;
+        }
+        
+        matched = false;
+        after = pattern + 1;
+        if (*pattern == '?') {
+            matched = true;
+        } else if (*pattern == '[') {
+            after = match_set(pattern, *name, &matched);
+        } else {
+            matched = *pattern != '\0' && *pattern == *name;
+        }
+        
+        if (matched) {
+            pattern = after;
+            name++;
+        } else if (star != NULL) {
+            pattern = star;
+            name = ++resume;
+        } else {
+            return false;
+        }
+    }
+    
+    while (*pattern == '*') {
+        pattern++;
+    }
+    return *pattern == '\0';
+}
+
+static int add_rule(script_parser_t* parser, bool keep) {
+    linker_script_t* script = parser->script;
+    uint32_t rule = (uint32_t)script->rule_count;
+    char* pattern;
+    int result = ERROR_SUCCESS;
+    
+    if (!token_is(parser, "*")) {
+        return parser_error(parser, "only '*' input file patterns are supported");
+    }
+    result = next_token(parser);
+    if (result == ERROR_SUCCESS) {
+        result = expect(parser, '(', "expected '(' after the file pattern");
+    }
+    
+    if (result == ERROR_SUCCESS && script->rule_count == script->rule_capacity) {
+        script->rules = grow_array(script->pool, script->rules, script->rule_count,
+                                   &script->rule_capacity, sizeof(script_rule_t));
+        if (script->rules == NULL) {
+            result = ERROR_OUT_OF_MEMORY;
+        }
+    }
+    if (result == ERROR_SUCCESS) {
+        script->rules[script->rule_count++] = (script_rule_t) {
+            .output = (uint32_t)(script->output_count - 1),
+            .keep = keep
+        };
+    }
+    
+    while (result == ERROR_SUCCESS && parser->kind == TOKEN_NAME) {
+        pattern = copy_token(parser);
+        result = pattern != NULL ? add_pattern(script, pattern, rule) : ERROR_OUT_OF_MEMORY;
+        if (result == ERROR_SUCCESS) {
+            result = next_token(parser);
+        }
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        result = expect(parser, ')', "expected ')' after the section patterns");
+    }
+    return result;
+}
+
+/* name [address] [ALIGN(n)] : { input-spec... } */
+static int parse_output(script_parser_t* parser, bool* fixed, uint32_t* start) {
+    linker_script_t* script = parser->script;
+    script_output_t* output;
+    bool keep;
+    int result = ERROR_SUCCESS;
+    
+    if (script->output_count == SCRIPT_MAX_OUTPUTS) {
+        return parser_error(parser, "too many output sections");
+    }
+    if (script->output_count == script->output_capacity) {
+        script->outputs = grow_array(script->pool, script->outputs, script->output_count,
+                                     &script->output_capacity, sizeof(script_output_t));
+        if (script->outputs == NULL) {
+            return ERROR_OUT_OF_MEMORY;
+        }
+    }
+    
+    output = &script->outputs[script->output_count++];
+    *output = (script_output_t) {
+        .name = copy_token(parser),
+        .discard = token_is(parser, "/DISCARD/"),
+        .fixed = *fixed,
+        .address = *start,
+        .alignment = 0
+    };
+    *fixed = false;
+    if (output->name == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    result = next_token(parser);
+    if (result == ERROR_SUCCESS && parser->kind == TOKEN_NAME &&
+        parser->token[0] >= '0' && parser->token[0] <= '9') {
+        output->fixed = true;
+        result = parse_number(parser, &output->address);
+    }
+    if (result == ERROR_SUCCESS && token_is(parser, "ALIGN")) {
+        result = next_token(parser);
+        if (result == ERROR_SUCCESS) {
+            result = expect(parser, '(', "expected '(' after ALIGN");
+        }
+        if (result == ERROR_SUCCESS) {
+            result = parse_number(parser, &output->alignment);
+        }
+        if (result == ERROR_SUCCESS &&
+            (output->alignment == 0 || (output->alignment & (output->alignment - 1)) != 0)) {
+            result = parser_error(parser, "ALIGN needs a power of two");
+        }
+        if (result == ERROR_SUCCESS) {
+            result = expect(parser, ')', "expected ')' after the alignment");
+        }
+    }
+    if (result == ERROR_SUCCESS) {
+        result = expect(parser, ':', "expected ':' after the output section name");
+    }
+    if (result == ERROR_SUCCESS) {
+        result = expect(parser, '{', "expected '{' to open the output section");
+    }
+    
+    while (result == ERROR_SUCCESS && parser->kind == TOKEN_NAME) {
+        keep = token_is(parser, "KEEP");
+        if (keep) {
+            result = next_token(parser);
+            if (result == ERROR_SUCCESS) {
+                result = expect(parser, '(', "expected '(' after KEEP");
+            }
+        }
+        if (result == ERROR_SUCCESS) {
+            result = add_rule(parser, keep);
+        }
+        if (result == ERROR_SUCCESS && keep) {
+            result = expect(parser, ')', "expected ')' to close KEEP");
+        }
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        result = expect(parser, '}', "expected '}' to close the output section");
+    }
+    return result;
+}
+
+static int parse_sections(script_parser_t* parser) {
+    bool fixed = false;
+    uint32_t start = 0;
+    int result = expect(parser, '{', "expected '{' after SECTIONS");
+    
+    while (result == ERROR_SUCCESS && parser->kind == TOKEN_NAME) {
+        if (token_is(parser, ".")) {
+            /* ". = address;" places the next output section */
+            result = next_token(parser);
+            if (result == ERROR_SUCCESS) {
+                result = expect(parser, '=', "expected '=' after '.'");
+            }
+            if (result == ERROR_SUCCESS) {
+                result = parse_number(parser, &start);
+                fixed = true;
+            }
+            if (result == ERROR_SUCCESS) {
+                result = expect(parser, ';', "expected ';' after the address");
+            }
+        } else {
+            result = parse_output(parser, &fixed, &start);
+        }
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        result = expect(parser, '}', "expected '}' to close SECTIONS");
+    }
+    return result;
+}
+
+static int parse_entry(script_parser_t* parser) {
+    int result = next_token(parser);
+    
+    if (result == ERROR_SUCCESS) {
+        result = expect(parser, '(', "expected '(' after ENTRY");
+    }
+    if (result == ERROR_SUCCESS && parser->kind != TOKEN_NAME) {
+        result = parser_error(parser, "expected the entry symbol");
+    }
+    if (result == ERROR_SUCCESS) {
+        parser->script->entry = copy_token(parser);
+        result = parser->script->entry != NULL ? next_token(parser) : ERROR_OUT_OF_MEMORY;
+    }
+    if (result == ERROR_SUCCESS) {
+        result = expect(parser, ')', "expected ')' after the entry symbol");
+    }
+    return result;
+}
+
+int linker_script_parse(const char* text, size_t length, memory_pool_t* pool,
+                        linker_script_t** script) {
+    script_parser_t parser;
+    int result;
+    
+    if (text == NULL || pool == NULL || script == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    *script = memory_pool_calloc(pool, 1, sizeof(linker_script_t));
+    if (*script == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate linker script");
+        return ERROR_OUT_OF_MEMORY;
+    }
+    (*script)->pool = pool;
+    (*script)->root.exact = SCRIPT_NO_RULE;
+    (*script)->root.prefix = SCRIPT_NO_RULE;
+    
+    parser = (script_parser_t) {
+        .script = *script,
+        .end = text + length,
+        .token = text,
+        .length = 0,
+        .kind = TOKEN_END,
+        .line = 1
+    };
+    
+    result = next_token(&parser);
+    while (result == ERROR_SUCCESS && parser.kind != TOKEN_END) {
+        if (token_is(&parser, "ENTRY")) {
+            result = parse_entry(&parser);
+        } else if (token_is(&parser, "SECTIONS")) {
+            result = next_token(&parser);
+            if (result == ERROR_SUCCESS) {
+                result = parse_sections(&parser);
+            }
+        } else {
+            result = parser_error(&parser, "unsupported command");
+        }
+    }
+    
+    if (result == ERROR_OUT_OF_MEMORY) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate linker script");
+    }
+    if (result != ERROR_SUCCESS) {
+        *script = NULL;
+    }
+    return result;
+}
+
+int linker_script_load(const char* filename, memory_pool_t* pool, linker_script_t** script) {
+    FILE* file;
+    char* text;
+    long size;
+    int result;
+    
+    if (filename == NULL || pool == NULL || script == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    file = fopen(filename, "rb");
+    if (file == NULL) {
+        ERROR_REPORT_ERROR(ERROR_FILE_NOT_FOUND, "Cannot open linker script");
+        return ERROR_FILE_NOT_FOUND;
+    }
+    
+    text = NULL;
+    size = -1;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        size = ftell(file);
+    }
+    if (size >= 0 && fseek(file, 0, SEEK_SET) == 0) {
+        text = malloc((size_t)size + 1);
+    }
+    
+    if (text == NULL || fread(text, 1, (size_t)size, file) != (size_t)size) {
+        ERROR_REPORT_ERROR(ERROR_FILE_IO, "Failed to read linker script");
+        result = ERROR_FILE_IO;
+    } else {
+        text[size] = '\0';
+        result = linker_script_parse(text, (size_t)size, pool, script);
+    }
+    
+    free(text);
+    fclose(file);
+    return result;
+}
+
+const char* linker_script_get_entry(const linker_script_t* script) {
+    return script != NULL ? script->entry : NULL;
+}
+
+size_t linker_script_get_output_count(const linker_script_t* script) {
+    return script != NULL ? script->output_count : 0;
+}
+
+const script_output_t* linker_script_get_output(const linker_script_t* script, size_t index) {
+    if (script == NULL || index >= script->output_count) {
+        return NULL;
+    }
+    return &script->outputs[index];
+}
+
+size_t linker_script_get_rule_count(const linker_script_t* script) {
+    return script != NULL ? script->rule_count : 0;
+}
+
+const script_rule_t* linker_script_get_rule(const linker_script_t* script, uint32_t rule) {
+    if (script == NULL || rule >= script->rule_count) {
+        return NULL;
+    }
+    return &script->rules[rule];
+}
+
+uint32_t linker_script_match(const linker_script_t* script, const char* name) {
+    const script_node_t* node;
+    const script_glob_t* glob;
+    uint32_t best = SCRIPT_NO_RULE;
+    
+    if (script == NULL || name == NULL) {
+        return SCRIPT_NO_RULE;
+    }
+    
+    /* Every node on the path is a prefix of name; lower rules win */
+    node = &script->root;
+    while (node != NULL) {
+        if (node->prefix < best) {
+            best = node->prefix;
+        }
+        for (glob = node->globs; glob != NULL && glob->rule < best; glob = glob->next) {
+            if (glob_match(glob->pattern, name)) {
+                best = glob->rule;
+            }
+        }
+        
+        if (*name == '\0') {
+            if (node->exact < best) {
+                best = node->exact;
+            }
+            node = NULL;
+        } else {
+            node = find_child(node, *name++);
+        }
+    }
+    
+    return best;
+}
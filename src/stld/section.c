@@ -1,12 +1,629 @@
 /* src/stld/section.c */
+#include "include/section.h"
+#include "include/symbol_table.h"
+#include "../common/include/error.h"
+#include "../common/include/memory.h"
+#include <stdlib.h>
+#include <string.h>
 
 /**
  * @file section.c
  * @brief Section management for STLD linker
- * @details C99 compliant section handling
+ * @details C99 compliant section handling. Records are allocated one by
+ * one from the pool, so section_t pointers stay valid as sections are
+ * added. A power-of-two open-addressing index maps name hashes to the
+ * first live section of that name. Layout packs (rank, class, alignment,
+ * id) into one 64-bit key per section and sorts the keys once.
  */
 
-/* TODO: Implement section management functions */
+#define SECTION_INITIAL_CAPACITY 16
+#define SECTION_INDEX_EMPTY SECTION_ID_INVALID
 
-/* Dummy variable to satisfy ISO C empty translation unit requirement */
-static const int section_dummy_variable __attribute__((unused)) = 0;
\ No newline at end of file
+/* Layout classes, in address order */
+#define SECTION_CLASS_CODE      0U
+#define SECTION_CLASS_RODATA    1U
+#define SECTION_CLASS_DATA      2U
+#define SECTION_CLASS_ZERO_FILL 3U
+
+/* Section with its bookkeeping */
+typedef struct section_record {
+    section_t section;              /* Public view */
+    uint32_t hash;                  /* Name hash */
+    section_fragment_t* head;       /* Fragment list (section.fragments) */
+    section_fragment_t* tail;       /* Last fragment, for O(1) append */
+    bool live;                      /* False once merged away */
+    uint16_t rank;                  /* Placement rank, SECTION_RANK_NONE if unranked */
+    bool fixed;                     /* Layout starts the section at start */
+    uint32_t start;
+} section_record_t;
+
+/* Section manager structure */
+struct section_manager {
+    memory_pool_t* pool;            /* Backs every allocation (not owned) */
+    section_record_t** records;     /* Indexed by section id */
+    size_t record_count;
+    size_t record_capacity;
+    section_id_t* index;            /* Open-addressing name index */
+    size_t index_size;              /* Slots, a power of two */
+    section_id_t* order;            /* Live sections, layout order */
+    size_t live_count;
+};
+
+static bool is_power_of_two(uint32_t value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+static uint64_t align_up(uint64_t value, uint32_t alignment) {
+    return (value + alignment - 1) & ~(uint64_t)(alignment - 1);
+}
+
+static uint32_t alignment_shift(uint32_t alignment) {
+    uint32_t shift = 0;
+    
+    while ((alignment >>= 1) != 0) {
+        shift++;
+    }
+    return shift;
+}
+
+static section_record_t* get_record(const section_manager_t* manager, section_id_t id) {
+    if (manager == NULL || id >= manager->record_count || !manager->records[id]->live) {
+        return NULL;
+    }
+    return manager->records[id];
+}
+
+/* Grow a pool array by copying; the old block goes back to the pool */
+static void* grow_array(memory_pool_t* pool, void* array, size_t used,
+                        size_t old_capacity, size_t new_capacity, size_t element_size) {
+    void* grown = memory_pool_alloc(pool, new_capacity * element_size);
+    
+    if (grown != NULL && array != NULL) {
+        memcpy(grown, array, used * element_size);
+        memory_pool_free_sized(pool, array, old_capacity * element_size);
+    }
+    return grown;
+}
+
+static void index_insert(section_manager_t* manager, section_id_t id) {
+    size_t mask = manager->index_size - 1;
+    size_t slot = manager->records[id]->hash & mask;
+    
+    while (manager->index[slot] != SECTION_INDEX_EMPTY) {
+        slot = (slot + 1) & mask;
+    }
+    manager->index[slot] = id;
+}
+
+static size_t index_find_slot(const section_manager_t* manager, const char* name, uint32_t hash) {
+    size_t mask = manager->index_size - 1;
+    size_t slot = hash & mask;
+    const section_record_t* record;
+    
+    while (manager->index[slot] != SECTION_INDEX_EMPTY) {
+        record = manager->records[manager->index[slot]];
+        if (record->hash == hash && strcmp(record->section.name, name) == 0) {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/* Rebuild at twice the size; keeps the load factor at or below 1/2 */
+static int index_grow(section_manager_t* manager) {
+    section_id_t* old_index = manager->index;
+    size_t old_size = manager->index_size;
+    size_t new_size = old_size > 0 ? old_size * 2 : SECTION_INITIAL_CAPACITY * 2;
+    size_t i;
+    
+    manager->index = memory_pool_alloc(manager->pool, new_size * sizeof(section_id_t));
+    if (manager->index == NULL) {
+        manager->index = old_index;
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to grow section index");
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    manager->index_size = new_size;
+    for (i = 0; i < new_size; i++) {
+        manager->index[i] = SECTION_INDEX_EMPTY;
+    }
+    
+    for (i = 0; i < old_size; i++) {
+        if (old_index[i] != SECTION_INDEX_EMPTY) {
+            index_insert(manager, old_index[i]);
+        }
+    }
+    
+    if (old_index != NULL) {
+        memory_pool_free_sized(manager->pool, old_index, old_size * sizeof(section_id_t));
+    }
+    return ERROR_SUCCESS;
+}
+
+/* Remove an indexed id, re-indexing the next live section of its name */
+static void index_remove(section_manager_t* manager, section_id_t id) {
+    const section_record_t* record = manager->records[id];
+    size_t mask = manager->index_size - 1;
+    size_t slot = index_find_slot(manager, record->section.name, record->hash);
+    size_t next;
+    section_id_t moved;
+    size_t i;
+    
+    if (manager->index[slot] != id) {
+        return;
+    }
+    
+    /* Re-insert the rest of the cluster so probe chains stay intact */
+    manager->index[slot] = SECTION_INDEX_EMPTY;
+    for (next = (slot + 1) & mask; manager->index[next] != SECTION_INDEX_EMPTY;
+         next = (next + 1) & mask) {
+        moved = manager->index[next];
+        manager->index[next] = SECTION_INDEX_EMPTY;
+        index_insert(manager, moved);
+    }
+    
+    for (i = id + 1; i < manager->record_count; i++) {
+        if (manager->records[i]->live && manager->records[i]->hash == record->hash &&
+            strcmp(manager->records[i]->section.name, record->section.name) == 0) {
+            index_insert(manager, (section_id_t)i);
+            break;
+        }
+    }
+}
+
+section_type_t section_type_from_flags(uint16_t flags) {
+    if ((flags & SECTION_FLAG_EXECUTABLE) != 0) {
+        return SECTION_TYPE_TEXT;
+    }
+    if ((flags & SECTION_FLAG_ZERO_FILL) != 0) {
+        return SECTION_TYPE_BSS;
+    }
+    if ((flags & SECTION_FLAG_WRITABLE) != 0) {
+        return SECTION_TYPE_DATA;
+    }
+    return SECTION_TYPE_RODATA;
+}
+
+section_manager_t* section_manager_create(memory_pool_t* pool) {
+    section_manager_t* manager;
+    
+    if (pool == NULL) {
+        return NULL;
+    }
+    
+    manager = memory_pool_alloc(pool, sizeof(section_manager_t));
+    if (manager == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate section manager");
+        return NULL;
+    }
+    
+    *manager = (section_manager_t) {
+        .pool = pool,
+        .records = NULL,
+        .record_count = 0,
+        .record_capacity = 0,
+        .index = NULL,
+        .index_size = 0,
+        .order = NULL,
+        .live_count = 0
+    };
+    
+    return manager;
+}
+
+void section_manager_destroy(section_manager_t* manager) {
+    size_t i;
+    
+    if (manager == NULL) {
+        return;
+    }
+    
+    /* Small blocks go back to the pool's free lists */
+    for (i = 0; i < manager->record_count; i++) {
+        memory_pool_free_sized(manager->pool, manager->records[i], sizeof(section_record_t));
+    }
+    if (manager->records != NULL) {
+        memory_pool_free_sized(manager->pool, manager->records,
+                               manager->record_capacity * sizeof(section_record_t*));
+        memory_pool_free_sized(manager->pool, manager->order,
+                               manager->record_capacity * sizeof(section_id_t));
+    }
+    if (manager->index != NULL) {
+        memory_pool_free_sized(manager->pool, manager->index,
+                               manager->index_size * sizeof(section_id_t));
+    }
+    memory_pool_free_sized(manager->pool, manager, sizeof(section_manager_t));
+}
+
+static int reserve_record(section_manager_t* manager) {
+    size_t new_capacity;
+    section_record_t** records;
+    section_id_t* order;
+    
+    if (manager->record_count >= SECTION_ID_INVALID) {
+        ERROR_REPORT_ERROR(ERROR_SYSTEM_LIMIT, "Too many sections");
+        return ERROR_SYSTEM_LIMIT;
+    }
+    
+    if (manager->record_count < manager->record_capacity) {
+        return ERROR_SUCCESS;
+    }
+    
+    new_capacity = manager->record_capacity > 0 ?
+                   manager->record_capacity * 2 : SECTION_INITIAL_CAPACITY;
+    records = grow_array(manager->pool, manager->records, manager->record_count,
+                         manager->record_capacity, new_capacity, sizeof(section_record_t*));
+    order = grow_array(manager->pool, manager->order, manager->live_count,
+                       manager->record_capacity, new_capacity, sizeof(section_id_t));
+    if (records == NULL || order == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to grow section table");
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    manager->records = records;
+    manager->order = order;
+    manager->record_capacity = new_capacity;
+    return ERROR_SUCCESS;
+}
+
+section_id_t section_manager_create_section(section_manager_t* manager, const char* name,
+                                            section_type_t type, uint16_t flags) {
+    section_record_t* record;
+    char* name_copy;
+    uint32_t hash;
+    size_t slot;
+    section_id_t id;
+    
+    if (manager == NULL || name == NULL) {
+        ERROR_REPORT_ERROR(ERROR_INVALID_ARGUMENT, "Section name required");
+        return SECTION_ID_INVALID;
+    }
+    
+    if (reserve_record(manager) != ERROR_SUCCESS) {
+        return SECTION_ID_INVALID;
+    }
+    
+    /* Keep the index at most half full */
+    if ((manager->record_count + 1) * 2 > manager->index_size &&
+        index_grow(manager) != ERROR_SUCCESS) {
+        return SECTION_ID_INVALID;
+    }
+    
+    record = memory_pool_alloc(manager->pool, sizeof(section_record_t));
+    name_copy = memory_pool_alloc(manager->pool, strlen(name) + 1);
+    if (record == NULL || name_copy == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate section");
+        return SECTION_ID_INVALID;
+    }
+    strcpy(name_copy, name);
+    hash = symbol_table_hash_name(name);
+    
+    *record = (section_record_t) {
+        .section = {
+            .name = name_copy,
+            .type = type,
+            .flags = flags,
+            .alignment = 1,
+            .address = 0,
+            .size = 0,
+            .layout_index = (uint32_t)manager->live_count,
+            .fragment_count = 0,
+            .fragments = NULL
+        },
+        .hash = hash,
+        .head = NULL,
+        .tail = NULL,
+        .live = true,
+        .rank = SECTION_RANK_NONE,
+        .fixed = false,
+        .start = 0
+    };
+    
+    id = (section_id_t)manager->record_count++;
+    manager->records[id] = record;
+    manager->order[manager->live_count++] = id;
+    
+    /* Only the first section of a name is indexed */
+    slot = index_find_slot(manager, name, hash);
+    if (manager->index[slot] == SECTION_INDEX_EMPTY) {
+        manager->index[slot] = id;
+    }
+    
+    return id;
+}
+
+section_id_t section_manager_find_section(const section_manager_t* manager, const char* name) {
+    size_t slot;
+    
+    if (manager == NULL || name == NULL || manager->index_size == 0) {
+        return SECTION_ID_INVALID;
+    }
+    
+    slot = index_find_slot(manager, name, symbol_table_hash_name(name));
+    return manager->index[slot];
+}
+
+const section_t* section_manager_get_section(const section_manager_t* manager, section_id_t id) {
+    const section_record_t* record = get_record(manager, id);
+    
+    return record != NULL ? &record->section : NULL;
+}
+
+int section_manager_add_data(section_manager_t* manager, section_id_t id,
+                             const uint8_t* data, uint32_t size,
+                             uint32_t alignment, uint32_t* offset) {
+    section_record_t* record = get_record(manager, id);
+    section_fragment_t* fragment;
+    uint64_t start;
+    
+    if (record == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    if (!is_power_of_two(alignment)) {
+        ERROR_REPORT_ERROR(ERROR_SECTION_ALIGNMENT, "Fragment alignment is not a power of two");
+        return ERROR_SECTION_ALIGNMENT;
+    }
+    
+    start = align_up(record->section.size, alignment);
+    if (start + size > UINT32_MAX) {
+        ERROR_REPORT_ERROR(ERROR_OUTPUT_TOO_LARGE, "Section exceeds 4GB");
+        return ERROR_OUTPUT_TOO_LARGE;
+    }
+    
+    if (size > 0) {
+        fragment = memory_pool_alloc(manager->pool, sizeof(section_fragment_t));
+        if (fragment == NULL) {
+            ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate section fragment");
+            return ERROR_OUT_OF_MEMORY;
+        }
+        
+        *fragment = (section_fragment_t) {
+            .data = data,
+            .offset = (uint32_t)start,
+            .size = size,
+            .next = NULL
+        };
+        
+        if (record->tail != NULL) {
+            record->tail->next = fragment;
+        } else {
+            record->head = fragment;
+            record->section.fragments = fragment;
+        }
+        record->tail = fragment;
+        record->section.fragment_count++;
+        
+        /* Any real contents make the section loadable data */
+        if (data != NULL) {
+            record->section.flags = (uint16_t)(record->section.flags & ~SECTION_FLAG_ZERO_FILL);
+        }
+    }
+    
+    if (alignment > record->section.alignment) {
+        record->section.alignment = alignment;
+    }
+    record->section.size = (uint32_t)(start + size);
+    
+    if (offset != NULL) {
+        *offset = (uint32_t)start;
+    }
+    return ERROR_SUCCESS;
+}
+
+int section_manager_set_alignment(section_manager_t* manager, section_id_t id,
+                                  uint32_t alignment) {
+    section_record_t* record = get_record(manager, id);
+    
+    if (record == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    if (!is_power_of_two(alignment)) {
+        ERROR_REPORT_ERROR(ERROR_SECTION_ALIGNMENT, "Section alignment is not a power of two");
+        return ERROR_SECTION_ALIGNMENT;
+    }
+    
+    record->section.alignment = alignment;
+    return ERROR_SUCCESS;
+}
+
+int section_manager_assign_address(section_manager_t* manager, section_id_t id,
+                                   uint32_t address) {
+    section_record_t* record = get_record(manager, id);
+    
+    if (record == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    if ((address & (record->section.alignment - 1)) != 0) {
+        ERROR_REPORT_ERROR(ERROR_SECTION_ALIGNMENT, "Section address is misaligned");
+        return ERROR_SECTION_ALIGNMENT;
+    }
+    
+    record->section.address = address;
+    return ERROR_SUCCESS;
+}
+
+int section_manager_set_rank(section_manager_t* manager, section_id_t id, uint16_t rank) {
+    section_record_t* record = get_record(manager, id);
+    
+    if (record == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    record->rank = rank;
+    return ERROR_SUCCESS;
+}
+
+int section_manager_set_start(section_manager_t* manager, section_id_t id, uint32_t address) {
+    section_record_t* record = get_record(manager, id);
+    
+    if (record == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    record->fixed = true;
+    record->start = address;
+    return ERROR_SUCCESS;
+}
+
+int section_manager_merge_sections(section_manager_t* manager, section_id_t target,
+                                   section_id_t source, uint32_t* offset) {
+    section_record_t* into = get_record(manager, target);
+    section_record_t* from = get_record(manager, source);
+    section_fragment_t* fragment;
+    uint64_t base;
+    bool zero_fill;
+    size_t i;
+    
+    if (into == NULL || from == NULL || into == from) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    base = align_up(into->section.size, from->section.alignment);
+    if (base + from->section.size > UINT32_MAX) {
+        ERROR_REPORT_ERROR(ERROR_OUTPUT_TOO_LARGE, "Section exceeds 4GB");
+        return ERROR_OUTPUT_TOO_LARGE;
+    }
+    
+    for (fragment = from->head; fragment != NULL; fragment = fragment->next) {
+        fragment->offset += (uint32_t)base;
+    }
+    
+    /* Splice the lists; zero fill only survives if both sides are */
+    if (from->head != NULL) {
+        if (into->tail != NULL) {
+            into->tail->next = from->head;
+        } else {
+            into->head = from->head;
+            into->section.fragments = from->head;
+        }
+        into->tail = from->tail;
+    }
+    
+    into->section.fragment_count += from->section.fragment_count;
+    into->section.size = (uint32_t)(base + from->section.size);
+    zero_fill = section_is_zero_fill(&into->section) && section_is_zero_fill(&from->section);
+    into->section.flags = (uint16_t)((into->section.flags | from->section.flags) &
+                                     ~SECTION_FLAG_ZERO_FILL);
+    if (zero_fill) {
+        into->section.flags = (uint16_t)(into->section.flags | SECTION_FLAG_ZERO_FILL);
+    }
+    if (from->section.alignment > into->section.alignment) {
+        into->section.alignment = from->section.alignment;
+    }
+    
+    index_remove(manager, source);
+    from->live = false;
+    from->head = NULL;
+    from->tail = NULL;
+    
+    for (i = 0; i < manager->live_count; i++) {
+        if (manager->order[i] == source) {
+            memmove(&manager->order[i], &manager->order[i + 1],
+                    (manager->live_count - i - 1) * sizeof(section_id_t));
+            manager->live_count--;
+            break;
+        }
+    }
+    
+    if (offset != NULL) {
+        *offset = (uint32_t)base;
+    }
+    return ERROR_SUCCESS;
+}
+
+static uint64_t layout_class(uint16_t flags) {
+    if ((flags & SECTION_FLAG_EXECUTABLE) != 0) {
+        return SECTION_CLASS_CODE;
+    }
+    if ((flags & SECTION_FLAG_ZERO_FILL) != 0) {
+        return SECTION_CLASS_ZERO_FILL;
+    }
+    if ((flags & SECTION_FLAG_WRITABLE) != 0) {
+        return SECTION_CLASS_DATA;
+    }
+    return SECTION_CLASS_RODATA;
+}
+
+static int compare_keys(const void* a, const void* b) {
+    uint64_t left = *(const uint64_t*)a;
+    uint64_t right = *(const uint64_t*)b;
+    
+    return left < right ? -1 : (left > right ? 1 : 0);
+}
+
+int section_manager_calculate_layout(section_manager_t* manager, uint32_t base_address) {
+    const section_record_t* record;
+    section_t* section;
+    uint64_t* keys;
+    uint64_t address = base_address;
+    size_t i;
+    int result = ERROR_SUCCESS;
+    
+    if (manager == NULL) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    
+    if (manager->live_count == 0) {
+        return ERROR_SUCCESS;
+    }
+    
+    keys = malloc(manager->live_count * sizeof(uint64_t));
+    if (keys == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate layout keys");
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    /* Key: rank (16) | class (2) | 31 - log2(alignment) (5) | id (32) */
+    for (i = 0; i < manager->live_count; i++) {
+        record = manager->records[manager->order[i]];
+        section = &manager->records[manager->order[i]]->section;
+        keys[i] = ((uint64_t)record->rank << 39) | (layout_class(section->flags) << 37) |
+                  ((uint64_t)(31 - alignment_shift(section->alignment)) << 32) |
+                  manager->order[i];
+    }
+    
+    qsort(keys, manager->live_count, sizeof(uint64_t), compare_keys);
+    
+    for (i = 0; i < manager->live_count && result == ERROR_SUCCESS; i++) {
+        manager->order[i] = (section_id_t)keys[i];
+        record = manager->records[manager->order[i]];
+        section = &manager->records[manager->order[i]]->section;
+        
+        if (record->fixed && record->start < address) {
+            ERROR_REPORT_ERROR(ERROR_INVALID_SECTION, "Section start overlaps previous sections");
+            result = ERROR_INVALID_SECTION;
+        } else {
+            address = align_up(record->fixed ? record->start : address, section->alignment);
+            if (address + section->size > (uint64_t)UINT32_MAX + 1) {
+                ERROR_REPORT_ERROR(ERROR_OUTPUT_TOO_LARGE, "Section layout exceeds 4GB");
+                result = ERROR_OUTPUT_TOO_LARGE;
+            } else {
+                section->address = (uint32_t)address;
+                section->layout_index = (uint32_t)i;
+                address += section->size;
+            }
+        }
+    }
+    
+    free(keys);
+    return result;
+}
+
+const section_id_t* section_manager_get_layout(const section_manager_t* manager, size_t* count) {
+    if (count != NULL) {
+        *count = manager != NULL ? manager->live_count : 0;
+    }
+    return manager != NULL ? manager->order : NULL;
+}
+
+size_t section_manager_get_count(const section_manager_t* manager) {
+    return manager != NULL ? manager->live_count : 0;
+}
+
+bool section_manager_is_empty(const section_manager_t* manager) {
+    return section_manager_get_count(manager) == 0;
+}
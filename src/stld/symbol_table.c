@@ -1,12 +1,565 @@
 /* src/stld/symbol_table.c */
+#include "include/symbol_table.h"
+#include "../common/include/error.h"
+#include <stdlib.h>
+#include <string.h>
 
 /**
  * @file symbol_table.c
  * @brief Symbol table management for STLD linker
- * @details C99 compliant symbol table handling
+ * @details C99 compliant symbol table handling. Entries are stored as
+ * parallel arrays indexed by handle (structure of arrays), so passes that
+ * look at one attribute, such as the undefined scan, walk contiguous
+ * memory. Names live in a single string pool addressed by offset, and an
+ * open-addressing (linear probing) index of handles maps names to entries,
+ * comparing the per-entry hash before touching the string pool.
  */
 
-/* TODO: Implement symbol table management functions */
+/* Packed type/binding/visibility byte */
+#define SYMBOL_INFO(type, binding, visibility) \
+    ((uint8_t)(((unsigned)(type) << 4) | ((unsigned)(visibility) << 2) | (unsigned)(binding)))
+#define SYMBOL_INFO_TYPE(info)       ((symbol_type_t)((info) >> 4))
+#define SYMBOL_INFO_VISIBILITY(info) ((symbol_visibility_t)(((info) >> 2) & 0x3U))
+#define SYMBOL_INFO_BINDING(info)    ((symbol_binding_t)((info) & 0x3U))
+#define SYMBOL_INFO_BINDING_MASK     0x3U
 
-/* Dummy variable to satisfy ISO C empty translation unit requirement */
-static const int symbol_table_dummy_variable __attribute__((unused)) = 0;
\ No newline at end of file
+/* Symbol table structure */
+struct symbol_table {
+    /* Entry arrays, all indexed by symbol_handle_t */
+    uint32_t* hashes;               /* Name hashes */
+    uint32_t* name_offsets;         /* Offsets into the string pool */
+    uint32_t* values;               /* Symbol values */
+    uint32_t* sizes;                /* Symbol sizes */
+    uint16_t* section_indices;      /* Section index or SECTION_INDEX_UNDEFINED */
+    uint8_t* info;                  /* Packed type/binding/visibility */
+    size_t count;                   /* Number of entries */
+    size_t capacity;                /* Allocated entries */
+    symbol_handle_t* slots;         /* Open-addressing index (INVALID = empty) */
+    size_t slot_count;              /* Index size (power of two) */
+    size_t slot_used;               /* Occupied index slots */
+    char* strings;                  /* Interned names */
+    size_t strings_size;            /* Bytes used in the string pool */
+    size_t strings_capacity;        /* Bytes allocated for the string pool */
+};
+
+/* Bytes per entry across all parallel arrays */
+#define SYMBOL_ENTRY_SIZE (4 * sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint8_t))
+
+uint32_t symbol_table_hash_name(const char* name) {
+    /* FNV-1a */
+    uint32_t hash = 2166136261U;
+    const unsigned char* p = (const unsigned char*)name;
+    
+    if (name == NULL) {
+        return 0;
+    }
+    
+    while (*p != '\0') {
+        hash ^= *p++;
+        hash *= 16777619U;
+    }
+    
+    return hash;
+}
+
+/* Copy a name into the string pool, returning its offset */
+static bool strings_intern(symbol_table_t* table, const char* str, uint32_t* offset) {
+    size_t len;
+    
+    /* A name taken from the pool itself (re-inserting an entry) is reused */
+    if (table->strings != NULL && str >= table->strings &&
+        str < table->strings + table->strings_size) {
+        *offset = (uint32_t)(str - table->strings);
+        return true;
+    }
+    
+    len = strlen(str) + 1;
+    if (table->strings_capacity - table->strings_size < len) {
+        size_t new_capacity = table->strings_capacity ?
+                              table->strings_capacity : SYMBOL_TABLE_STRINGS_INITIAL;
+        char* new_strings;
+        
+        while (new_capacity - table->strings_size < len) {
+            new_capacity *= 2;
+        }
+        
+        if (new_capacity > UINT32_MAX) {
+            return false;
+        }
+        
+        new_strings = realloc(table->strings, new_capacity);
+        if (new_strings == NULL) {
+            return false;
+        }
+        table->strings = new_strings;
+        table->strings_capacity = new_capacity;
+    }
+    
+    *offset = (uint32_t)table->strings_size;
+    memcpy(table->strings + table->strings_size, str, len);
+    table->strings_size += len;
+    
+    return true;
+}
+
+static size_t find_slot(const symbol_table_t* table, const char* name, uint32_t hash) {
+    size_t mask = table->slot_count - 1;
+    size_t i = hash & mask;
+    
+    for (;;) {
+        symbol_handle_t handle = table->slots[i];
+        
+        if (handle == SYMBOL_HANDLE_INVALID) {
+            return i;
+        }
+        
+        if (table->hashes[handle] == hash &&
+            strcmp(table->strings + table->name_offsets[handle], name) == 0) {
+            return i;
+        }
+        
+        i = (i + 1) & mask;
+    }
+}
+
+static void reset_slots(symbol_handle_t* slots, size_t count) {
+    size_t i;
+    
+    for (i = 0; i < count; i++) {
+        slots[i] = SYMBOL_HANDLE_INVALID;
+    }
+}
+
+static int grow_index(symbol_table_t* table) {
+    size_t new_count = table->slot_count * 2;
+    symbol_handle_t* new_slots;
+    size_t mask = new_count - 1;
+    size_t i;
+    
+    new_slots = malloc(new_count * sizeof(symbol_handle_t));
+    if (new_slots == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    reset_slots(new_slots, new_count);
+    
+    /* Reinsert using the stored hashes, no string access needed */
+    for (i = 0; i < table->slot_count; i++) {
+        symbol_handle_t handle = table->slots[i];
+        size_t j;
+        
+        if (handle == SYMBOL_HANDLE_INVALID) {
+            continue;
+        }
+        
+        j = table->hashes[handle] & mask;
+        while (new_slots[j] != SYMBOL_HANDLE_INVALID) {
+            j = (j + 1) & mask;
+        }
+        new_slots[j] = handle;
+    }
+    
+    free(table->slots);
+    table->slots = new_slots;
+    table->slot_count = new_count;
+    
+    return ERROR_SUCCESS;
+}
+
+/* Resize one parallel array; the table capacity is updated by the caller */
+static bool grow_array(void** array, size_t element_size, size_t new_capacity) {
+    void* grown = realloc(*array, new_capacity * element_size);
+    
+    if (grown == NULL) {
+        return false;
+    }
+    
+    *array = grown;
+    return true;
+}
+
+static bool grow_entries(symbol_table_t* table, size_t new_capacity) {
+    return grow_array((void**)&table->hashes, sizeof(uint32_t), new_capacity) &&
+           grow_array((void**)&table->name_offsets, sizeof(uint32_t), new_capacity) &&
+           grow_array((void**)&table->values, sizeof(uint32_t), new_capacity) &&
+           grow_array((void**)&table->sizes, sizeof(uint32_t), new_capacity) &&
+           grow_array((void**)&table->section_indices, sizeof(uint16_t), new_capacity) &&
+           grow_array((void**)&table->info, sizeof(uint8_t), new_capacity);
+}
+
+static void store_entry(symbol_table_t* table, symbol_handle_t handle,
+                        const symbol_t* symbol) {
+    table->values[handle] = symbol->value;
+    table->sizes[handle] = symbol->size;
+    table->section_indices[handle] = symbol->section_index;
+    table->info[handle] = SYMBOL_INFO(symbol->type, symbol->binding, symbol->visibility);
+}
+
+static symbol_handle_t append_entry(symbol_table_t* table,
+                                    const symbol_t* symbol,
+                                    uint32_t hash,
+                                    uint32_t name_offset) {
+    symbol_handle_t handle;
+    
+    if (table->count >= table->capacity) {
+        size_t new_capacity = table->capacity * 2;
+        
+        if (new_capacity >= SYMBOL_HANDLE_INVALID) {
+            ERROR_REPORT_ERROR(ERROR_SYSTEM_LIMIT, "Symbol table full");
+            return SYMBOL_HANDLE_INVALID;
+        }
+        
+        if (!grow_entries(table, new_capacity)) {
+            ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to grow symbol table");
+            return SYMBOL_HANDLE_INVALID;
+        }
+        table->capacity = new_capacity;
+    }
+    
+    handle = (symbol_handle_t)table->count;
+    table->hashes[handle] = hash;
+    table->name_offsets[handle] = name_offset;
+    store_entry(table, handle, symbol);
+    table->count++;
+    
+    return handle;
+}
+
+symbol_table_t* symbol_table_create(size_t initial_capacity) {
+    symbol_table_t* table;
+    size_t slot_count = 16;
+    
+    if (initial_capacity == 0) {
+        initial_capacity = SYMBOL_TABLE_INITIAL_CAPACITY;
+    }
+    
+    /* Size the index so the initial capacity stays under the load limit */
+    while (slot_count * SYMBOL_TABLE_MAX_LOAD_PERCENT < initial_capacity * 100) {
+        slot_count *= 2;
+    }
+    
+    table = malloc(sizeof(symbol_table_t));
+    if (table == NULL) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate symbol table");
+        return NULL;
+    }
+    
+    *table = (symbol_table_t) {
+        .hashes = NULL,
+        .name_offsets = NULL,
+        .values = NULL,
+        .sizes = NULL,
+        .section_indices = NULL,
+        .info = NULL,
+        .count = 0,
+        .capacity = initial_capacity,
+        .slots = malloc(slot_count * sizeof(symbol_handle_t)),
+        .slot_count = slot_count,
+        .slot_used = 0,
+        .strings = NULL,
+        .strings_size = 0,
+        .strings_capacity = 0
+    };
+    
+    if (table->slots == NULL || !grow_entries(table, initial_capacity)) {
+        ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to allocate symbol table");
+        symbol_table_destroy(table);
+        return NULL;
+    }
+    
+    reset_slots(table->slots, table->slot_count);
+    
+    return table;
+}
+
+void symbol_table_destroy(symbol_table_t* table) {
+    if (table != NULL) {
+        free(table->hashes);
+        free(table->name_offsets);
+        free(table->values);
+        free(table->sizes);
+        free(table->section_indices);
+        free(table->info);
+        free(table->slots);
+        free(table->strings);
+        free(table);
+    }
+}
+
+void symbol_table_clear(symbol_table_t* table) {
+    if (table != NULL) {
+        reset_slots(table->slots, table->slot_count);
+        table->slot_used = 0;
+        table->count = 0;
+        table->strings_size = 0;
+    }
+}
+
+symbol_handle_t symbol_table_insert(symbol_table_t* table, const symbol_t* symbol) {
+    if (symbol == NULL || symbol->name == NULL) {
+        ERROR_REPORT_ERROR(ERROR_INVALID_ARGUMENT, "Invalid symbol");
+        return SYMBOL_HANDLE_INVALID;
+    }
+    
+    return symbol_table_insert_hash(table, symbol, symbol_table_hash_name(symbol->name));
+}
+
+symbol_handle_t symbol_table_insert_hash(symbol_table_t* table,
+                                         const symbol_t* symbol,
+                                         uint32_t hash) {
+    symbol_handle_t existing;
+    symbol_handle_t handle;
+    symbol_binding_t old_binding;
+    uint32_t name_offset;
+    size_t slot;
+    bool new_defined;
+    bool old_defined;
+    
+    if (table == NULL || symbol == NULL || symbol->name == NULL) {
+        ERROR_REPORT_ERROR(ERROR_INVALID_ARGUMENT, "Invalid symbol");
+        return SYMBOL_HANDLE_INVALID;
+    }
+    
+    /* Keep the index below its load limit */
+    if ((table->slot_used + 1) * 100 > table->slot_count * SYMBOL_TABLE_MAX_LOAD_PERCENT) {
+        if (grow_index(table) != ERROR_SUCCESS) {
+            ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to grow symbol index");
+            return SYMBOL_HANDLE_INVALID;
+        }
+    }
+    
+    slot = find_slot(table, symbol->name, hash);
+    existing = table->slots[slot];
+    
+    /* New name: intern and index it */
+    if (existing == SYMBOL_HANDLE_INVALID) {
+        if (!strings_intern(table, symbol->name, &name_offset)) {
+            ERROR_REPORT_ERROR(ERROR_OUT_OF_MEMORY, "Failed to intern symbol name");
+            return SYMBOL_HANDLE_INVALID;
+        }
+        
+        handle = append_entry(table, symbol, hash, name_offset);
+        if (handle != SYMBOL_HANDLE_INVALID) {
+            table->slots[slot] = handle;
+            table->slot_used++;
+        }
+        return handle;
+    }
+    
+    name_offset = table->name_offsets[existing];
+    old_binding = SYMBOL_INFO_BINDING(table->info[existing]);
+    
+    /* Locals never merge; they reuse the interned name */
+    if (symbol->binding == SYMBOL_BINDING_LOCAL) {
+        return append_entry(table, symbol, hash, name_offset);
+    }
+    
+    /* A global takes the name over from an indexed local */
+    if (old_binding == SYMBOL_BINDING_LOCAL) {
+        handle = append_entry(table, symbol, hash, name_offset);
+        if (handle != SYMBOL_HANDLE_INVALID) {
+            table->slots[slot] = handle;
+        }
+        return handle;
+    }
+    
+    new_defined = symbol_is_defined(symbol);
+    old_defined = table->section_indices[existing] != SECTION_INDEX_UNDEFINED;
+    
+    if (!new_defined) {
+        /* Reference only: a strong reference upgrades a weak one */
+        if (!old_defined && old_binding == SYMBOL_BINDING_WEAK) {
+            table->info[existing] = (uint8_t)((table->info[existing] & ~SYMBOL_INFO_BINDING_MASK) |
+                                              (unsigned)symbol->binding);
+        }
+        return existing;
+    }
+    
+    if (old_defined) {
+        if (symbol->binding == SYMBOL_BINDING_WEAK) {
+            return existing; /* Existing definition wins */
+        }
+        
+        if (old_binding != SYMBOL_BINDING_WEAK) {
+            ERROR_REPORT_ERROR(ERROR_DUPLICATE_SYMBOL, "Duplicate symbol definition");
+            return SYMBOL_HANDLE_INVALID;
+        }
+    }
+    
+    /* Upgrade undefined or weak entry in place */
+    store_entry(table, existing, symbol);
+    
+    return existing;
+}
+
+symbol_handle_t symbol_table_lookup_hash(const symbol_table_t* table,
+                                         const char* name,
+                                         uint32_t hash) {
+    size_t slot;
+    
+    if (table == NULL || name == NULL) {
+        return SYMBOL_HANDLE_INVALID;
+    }
+    
+    slot = find_slot(table, name, hash);
+    return table->slots[slot];
+}
+
+symbol_handle_t symbol_table_lookup(const symbol_table_t* table, const char* name) {
+    if (table == NULL || name == NULL) {
+        return SYMBOL_HANDLE_INVALID;
+    }
+    
+    return symbol_table_lookup_hash(table, name, symbol_table_hash_name(name));
+}
+
+bool symbol_table_get(const symbol_table_t* table, symbol_handle_t handle, symbol_t* symbol) {
+    uint8_t info;
+    
+    if (table == NULL || symbol == NULL || handle >= table->count) {
+        return false;
+    }
+    
+    info = table->info[handle];
+    *symbol = (symbol_t) {
+        .name = table->strings + table->name_offsets[handle],
+        .type = SYMBOL_INFO_TYPE(info),
+        .binding = SYMBOL_INFO_BINDING(info),
+        .visibility = SYMBOL_INFO_VISIBILITY(info),
+        .section_index = table->section_indices[handle],
+        .value = table->values[handle],
+        .size = table->sizes[handle]
+    };
+    
+    return true;
+}
+
+const char* symbol_table_get_name(const symbol_table_t* table, symbol_handle_t handle) {
+    if (table == NULL || handle >= table->count) {
+        return NULL;
+    }
+    
+    return table->strings + table->name_offsets[handle];
+}
+
+uint32_t symbol_table_get_value(const symbol_table_t* table, symbol_handle_t handle) {
+    if (table == NULL || handle >= table->count) {
+        return 0;
+    }
+    
+    return table->values[handle];
+}
+
+uint16_t symbol_table_get_section_index(const symbol_table_t* table, symbol_handle_t handle) {
+    if (table == NULL || handle >= table->count) {
+        return SECTION_INDEX_UNDEFINED;
+    }
+    
+    return table->section_indices[handle];
+}
+
+symbol_binding_t symbol_table_get_binding(const symbol_table_t* table, symbol_handle_t handle) {
+    if (table == NULL || handle >= table->count) {
+        return SYMBOL_BINDING_LOCAL;
+    }
+    
+    return SYMBOL_INFO_BINDING(table->info[handle]);
+}
+
+size_t symbol_table_size(const symbol_table_t* table) {
+    return table ? table->count : 0;
+}
+
+bool symbol_table_is_empty(const symbol_table_t* table) {
+    return symbol_table_size(table) == 0;
+}
+
+size_t symbol_table_count_undefined(const symbol_table_t* table) {
+    const uint16_t* sections;
+    size_t count = 0;
+    size_t i;
+    
+    if (table == NULL) {
+        return 0;
+    }
+    
+    /* Branch-free scan over one contiguous array (vectorizes at -O2) */
+    sections = table->section_indices;
+    for (i = 0; i < table->count; i++) {
+        count += (size_t)(sections[i] == SECTION_INDEX_UNDEFINED);
+    }
+    
+    return count;
+}
+
+size_t symbol_table_count_unresolved(const symbol_table_t* table) {
+    const uint16_t* sections;
+    const uint8_t* info;
+    size_t count = 0;
+    size_t i;
+    
+    if (table == NULL) {
+        return 0;
+    }
+    
+    /* Undefined weak references resolve to zero and are not counted */
+    sections = table->section_indices;
+    info = table->info;
+    for (i = 0; i < table->count; i++) {
+        count += (size_t)(sections[i] == SECTION_INDEX_UNDEFINED &&
+                          SYMBOL_INFO_BINDING(info[i]) != SYMBOL_BINDING_WEAK);
+    }
+    
+    return count;
+}
+
+size_t symbol_table_get_memory_usage(const symbol_table_t* table) {
+    if (table == NULL) {
+        return 0;
+    }
+    
+    return sizeof(symbol_table_t) +
+           table->capacity * SYMBOL_ENTRY_SIZE +
+           table->slot_count * sizeof(symbol_handle_t) +
+           table->strings_capacity;
+}
+
+symbol_iterator_t symbol_table_begin(const symbol_table_t* table) {
+    symbol_iterator_t iter = { .table = table, .current = 0 };
+    return iter;
+}
+
+bool symbol_iterator_is_valid(const symbol_iterator_t* iter) {
+    return iter != NULL && iter->table != NULL && iter->current < iter->table->count;
+}
+
+bool symbol_iterator_get(const symbol_iterator_t* iter, symbol_t* symbol) {
+    if (!symbol_iterator_is_valid(iter)) {
+        return false;
+    }
+    
+    return symbol_table_get(iter->table, iter->current, symbol);
+}
+
+void symbol_iterator_next(symbol_iterator_t* iter) {
+    if (symbol_iterator_is_valid(iter)) {
+        iter->current++;
+    }
+}
+
+void symbol_table_foreach(const symbol_table_t* table,
+                          symbol_table_visitor_t visitor,
+                          void* user_data) {
+    symbol_t symbol;
+    size_t i;
+    
+    if (table == NULL || visitor == NULL) {
+        return;
+    }
+    
+    for (i = 0; i < table->count; i++) {
+        symbol_table_get(table, (symbol_handle_t)i, &symbol);
+        if (!visitor((symbol_handle_t)i, &symbol, user_data)) {
+            break;
+        }
+    }
+}
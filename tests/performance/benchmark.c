@@ -0,0 +1,951 @@
+/* tests/performance/benchmark.c */
+#include "stld.h"
+#include "symbol_table.h"
+#include "relocation.h"
+#include "section.h"
+#include "memory.h"
+#include "smof.h"
+#include "crc32.h"
+#include "error.h"
+#include "star.h"
+#include "archive.h"
+#include "compress.h"
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @file benchmark.c
+ * @brief Benchmarks for the linker and archiver hot paths
+ * @details Each benchmark repeats its operation until it has run at least
+ * BENCH_MIN_RUNS times and for the time budget, and reports the best run
+ * divided by the operations in it as ns_per_op. Inputs come from a seeded
+ * generator, so a given scale means the same work on every commit, and
+ * the JSON carries no timestamps or host details: two runs on the same
+ * machine can be diffed field by field. The end-to-end benchmarks link
+ * and archive a synthetic corpus of SMOF objects in a temporary directory.
+ */
+
+#define BENCH_FORMAT_VERSION 1
+#define BENCH_MAX_RESULTS    64
+#define BENCH_NAME_MAX       48
+#define BENCH_MIN_RUNS       3
+#define BENCH_MAX_RUNS       1000
+#define BENCH_BUDGET_NS      250000000ULL
+#define BENCH_QUICK_NS       20000000ULL
+#define BENCH_SEED           0x9E3779B9U
+#define BENCH_SYMBOL_NAME_MAX 32
+
+/* Synthetic objects: functions of fixed size, each calling into the next object */
+#define BENCH_FUNCTIONS      16
+#define BENCH_FUNCTION_SIZE  32
+#define BENCH_TEXT_SIZE      (BENCH_FUNCTIONS * BENCH_FUNCTION_SIZE)
+#define BENCH_OBJECT_SYMBOLS (2 * BENCH_FUNCTIONS + 1)
+#define BENCH_STRINGS_SIZE   (8 + BENCH_OBJECT_SYMBOLS * BENCH_SYMBOL_NAME_MAX)
+
+#define BENCH_RELOC_SYMBOLS  1024
+#define BENCH_COMPRESS_SIZE  (64 * 1024)
+
+/* Scales; --quick runs only the first of each */
+static const size_t symbol_scales[] = {1000, 10000, 100000};
+static const size_t reloc_scales[] = {1000, 10000, 100000};
+static const size_t section_scales[] = {100, 1000, 10000};
+static const size_t string_scales[] = {1000, 10000, 100000};
+static const size_t crc_scales[] = {4096, 65536, 1048576};
+static const size_t corpus_scales[] = {10, 100, 1000};
+
+#define SCALE_COUNT(scales) (sizeof(scales) / sizeof((scales)[0]))
+
+/* One line of the report */
+typedef struct bench_result {
+    char name[BENCH_NAME_MAX];
+    size_t scale;                   /* Problem size (items, bytes or objects) */
+    size_t ops;                     /* Operations per run */
+    size_t runs;                    /* Timed runs (0 = measured by the library) */
+    double ns_per_op;               /* Best run per operation */
+    double mean_ns_per_op;          /* Mean run per operation */
+    double mb_per_s;                /* Throughput of byte benchmarks (0 = none) */
+    double ratio;                   /* Compressed / original (0 = none) */
+    size_t memory;                  /* Working memory in bytes (0 = none) */
+} bench_result_t;
+
+/* Repeated timing of one operation */
+typedef struct bench_timer {
+    struct timespec start;
+    uint64_t best_ns;
+    uint64_t total_ns;
+    size_t runs;
+} bench_timer_t;
+
+/* Command line settings */
+static struct {
+    const char* output_file;
+    const char* filter;
+    bool quick;
+    size_t threads;
+    uint64_t budget_ns;
+    char corpus_dir[64];
+} config = {NULL, NULL, false, 0, BENCH_BUDGET_NS, ""};
+
+static bench_result_t results[BENCH_MAX_RESULTS];
+static size_t result_count;
+
+/* Keeps results of timed loops alive */
+static volatile uint32_t bench_sink;
+
+/* xorshift32: the corpus only has to be the same on every run */
+static uint32_t next_random(uint32_t* state) {
+    uint32_t x = *state;
+    
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static size_t scale_count(size_t count) {
+    return config.quick ? 1 : count;
+}
+
+static bool bench_selected(const char* name) {
+    return config.filter == NULL || strstr(name, config.filter) != NULL;
+}
+
+static uint64_t elapsed_ns(const struct timespec* start) {
+    struct timespec now;
+    
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)(now.tv_sec - start->tv_sec) * 1000000000ULL +
+           (uint64_t)now.tv_nsec - (uint64_t)start->tv_nsec;
+}
+
+static void timer_init(bench_timer_t* timer) {
+    memset(timer, 0, sizeof(*timer));
+    timer->best_ns = UINT64_MAX;
+}
+
+static bool timer_continue(const bench_timer_t* timer) {
+    return timer->runs < BENCH_MIN_RUNS ||
+           (timer->total_ns < config.budget_ns && timer->runs < BENCH_MAX_RUNS);
+}
+
+static void timer_start(bench_timer_t* timer) {
+    clock_gettime(CLOCK_MONOTONIC, &timer->start);
+}
+
+static void timer_stop(bench_timer_t* timer) {
+    uint64_t ns = elapsed_ns(&timer->start);
+    
+    if (ns < timer->best_ns) {
+        timer->best_ns = ns;
+    }
+    timer->total_ns += ns;
+    timer->runs++;
+}
+
+static bench_result_t* add_result(const char* name, size_t scale) {
+    bench_result_t* result;
+    
+    if (result_count == BENCH_MAX_RESULTS) {
+        fprintf(stderr, "benchmark: too many results, dropping %s\n", name);
+        return NULL;
+    }
+    result = &results[result_count++];
+    memset(result, 0, sizeof(*result));
+    snprintf(result->name, sizeof(result->name), "%s", name);
+    result->scale = scale;
+    fprintf(stderr, "  %-28s %8zu\n", name, scale);
+    return result;
+}
+
+/* bytes_per_op > 0 also reports the throughput */
+static void record_timer(const char* name, size_t scale, size_t ops,
+                         const bench_timer_t* timer, size_t bytes_per_op) {
+    bench_result_t* result = add_result(name, scale);
+    double ops_per_run = ops > 0 ? (double)ops : 1.0;
+    
+    if (result == NULL || timer->runs == 0) {
+        return;
+    }
+    result->ops = ops;
+    result->runs = timer->runs;
+    result->ns_per_op = (double)timer->best_ns / ops_per_run;
+    result->mean_ns_per_op = (double)timer->total_ns / (double)timer->runs / ops_per_run;
+    if (bytes_per_op > 0 && result->ns_per_op > 0.0) {
+        result->mb_per_s = (double)bytes_per_op * 1e3 / result->ns_per_op;
+    }
+}
+
+static void report_failure(const char* name, size_t scale, int result) {
+    fprintf(stderr, "benchmark: %s at scale %zu failed: %s\n",
+            name, scale, error_get_string((error_code_t)result));
+}
+
+/* count names laid out in one block; free the array and names[0] */
+static char** generate_names(size_t count) {
+    char** names = malloc(count * sizeof(char*));
+    char* block = malloc(count * BENCH_SYMBOL_NAME_MAX);
+    uint32_t state = BENCH_SEED;
+    size_t i;
+    
+    if (names == NULL || block == NULL) {
+        free(names);
+        free(block);
+        return NULL;
+    }
+    for (i = 0; i < count; i++) {
+        names[i] = block + i * BENCH_SYMBOL_NAME_MAX;
+        snprintf(names[i], BENCH_SYMBOL_NAME_MAX, "s%u_%04x",
+                 (unsigned)i, next_random(&state) & 0xFFFFU);
+    }
+    return names;
+}
+
+static void free_names(char** names) {
+    if (names != NULL) {
+        free(names[0]);
+        free(names);
+    }
+}
+
+/* Code-like bytes: a few common opcodes with random operands */
+static void generate_code(uint8_t* code, size_t size, uint32_t seed) {
+    static const uint8_t opcodes[] = {0x10, 0x12, 0x20, 0x21, 0x30, 0x40, 0x41, 0x7F};
+    uint32_t state = seed != 0 ? seed : BENCH_SEED;
+    uint32_t value;
+    size_t i;
+    
+    for (i = 0; i < size; i++) {
+        value = next_random(&state);
+        code[i] = (i % 4) == 0 ? opcodes[value % sizeof(opcodes)] : (uint8_t)(value & 0x0FU);
+    }
+}
+
+static void fill_symbol(symbol_t* symbol, const char* name, uint32_t value) {
+    memset(symbol, 0, sizeof(*symbol));
+    symbol->name = name;
+    symbol->type = SYMBOL_TYPE_FUNCTION;
+    symbol->binding = SYMBOL_BINDING_GLOBAL;
+    symbol->visibility = SYMBOL_VISIBILITY_DEFAULT;
+    symbol->section_index = 0;
+    symbol->value = value;
+    symbol->size = BENCH_FUNCTION_SIZE;
+}
+
+static int fill_table(symbol_table_t* table, char* const* names, size_t count) {
+    symbol_t symbol;
+    size_t i;
+    
+    for (i = 0; i < count; i++) {
+        fill_symbol(&symbol, names[i], (uint32_t)(i * BENCH_FUNCTION_SIZE));
+        if (symbol_table_insert(table, &symbol) == SYMBOL_HANDLE_INVALID) {
+            return ERROR_OUT_OF_MEMORY;
+        }
+    }
+    return ERROR_SUCCESS;
+}
+
+static int bench_symbol_table(size_t scale) {
+    char** names = generate_names(scale);
+    symbol_table_t* table;
+    bench_timer_t timer;
+    uint32_t sum = 0;
+    int result = ERROR_SUCCESS;
+    size_t i;
+    
+    if (names == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    
+    if (bench_selected("symbol_table_insert")) {
+        timer_init(&timer);
+        while (result == ERROR_SUCCESS && timer_continue(&timer)) {
+            timer_start(&timer);
+            table = symbol_table_create(SYMBOL_TABLE_INITIAL_CAPACITY);
+            result = table != NULL ? fill_table(table, names, scale) : ERROR_OUT_OF_MEMORY;
+            timer_stop(&timer);
+            symbol_table_destroy(table);
+        }
+        if (result == ERROR_SUCCESS) {
+            record_timer("symbol_table_insert", scale, scale, &timer, 0);
+        }
+    }
+    
+    if (result == ERROR_SUCCESS && bench_selected("symbol_table_lookup")) {
+        table = symbol_table_create(SYMBOL_TABLE_INITIAL_CAPACITY);
+        result = table != NULL ? fill_table(table, names, scale) : ERROR_OUT_OF_MEMORY;
+        timer_init(&timer);
+        while (result == ERROR_SUCCESS && timer_continue(&timer)) {
+            timer_start(&timer);
+            for (i = 0; i < scale; i++) {
+                sum += symbol_table_lookup(table, names[i]);
+            }
+            timer_stop(&timer);
+        }
+        bench_sink = sum;
+        if (result == ERROR_SUCCESS) {
+            record_timer("symbol_table_lookup", scale, scale, &timer, 0);
+        }
+        symbol_table_destroy(table);
+    }
+    
+    free_names(names);
+    return result;
+}
+
+/* scale ABS32/REL32 fields in one section, added in shuffled order */
+static int bench_relocation(size_t scale) {
+    char** names = generate_names(BENCH_RELOC_SYMBOLS);
+    symbol_table_t* table = symbol_table_create(BENCH_RELOC_SYMBOLS);
+    relocation_engine_t* engine = NULL;
+    uint32_t* order = malloc(scale * sizeof(uint32_t));
+    uint8_t* data = calloc(scale, 4);
+    relocation_entry_t entry;
+    bench_timer_t timer;
+    uint32_t state = BENCH_SEED;
+    uint32_t swap;
+    size_t i;
+    size_t j;
+    int result = ERROR_SUCCESS;
+    
+    if (names == NULL || table == NULL || order == NULL || data == NULL) {
+        result = ERROR_OUT_OF_MEMORY;
+    }
+    if (result == ERROR_SUCCESS) {
+        result = fill_table(table, names, BENCH_RELOC_SYMBOLS);
+    }
+    if (result == ERROR_SUCCESS) {
+        engine = relocation_engine_create(table);
+        result = engine != NULL ?
+                 relocation_engine_set_section(engine, 0, data, (uint32_t)(scale * 4), 0x1000) :
+                 ERROR_OUT_OF_MEMORY;
+    }
+    
+    if (result == ERROR_SUCCESS) {
+        for (i = 0; i < scale; i++) {
+            order[i] = (uint32_t)i;
+        }
+        for (i = scale - 1; i > 0; i--) {
+            j = next_random(&state) % (i + 1);
+            swap = order[i];
+            order[i] = order[j];
+            order[j] = swap;
+        }
+        for (i = 0; i < scale && result == ERROR_SUCCESS; i++) {
+            memset(&entry, 0, sizeof(entry));
+            entry.offset = order[i] * 4;
+            entry.type = (order[i] & 1U) != 0 ? RELOC_TYPE_REL32 : RELOC_TYPE_ABS32;
+            entry.symbol_handle = (symbol_handle_t)(order[i] % BENCH_RELOC_SYMBOLS);
+            entry.addend = (int32_t)(order[i] % 16);
+            entry.section_id = 0;
+            if (relocation_engine_add_entry(engine, &entry) == RELOCATION_ID_INVALID) {
+                result = ERROR_OUT_OF_MEMORY;
+            }
+        }
+    }
+    
+    timer_init(&timer);
+    while (result == ERROR_SUCCESS && timer_continue(&timer)) {
+        timer_start(&timer);
+        result = relocation_engine_process_all(engine);
+        timer_stop(&timer);
+    }
+    if (result == ERROR_SUCCESS) {
+        record_timer("relocation_process_all", scale, scale, &timer, 0);
+    }
+    
+    relocation_engine_destroy(engine);
+    symbol_table_destroy(table);
+    free_names(names);
+    free(order);
+    free(data);
+    return result;
+}
+
+/* scale sections of mixed types with two fragments each */
+static int bench_section_layout(size_t scale) {
+    static const uint8_t filler[1024];
+    static const section_type_t types[] = {
+        SECTION_TYPE_TEXT, SECTION_TYPE_RODATA, SECTION_TYPE_DATA, SECTION_TYPE_BSS
+    };
+    memory_pool_t* pool = memory_pool_create_growable(0, 0);
+    section_manager_t* manager = pool != NULL ? section_manager_create(pool) : NULL;
+    section_type_t type;
+    section_id_t id;
+    bench_timer_t timer;
+    char name[32];
+    uint32_t state = BENCH_SEED;
+    uint32_t size;
+    size_t i;
+    int fragment;
+    int result = manager != NULL ? ERROR_SUCCESS : ERROR_OUT_OF_MEMORY;
+    
+    for (i = 0; i < scale && result == ERROR_SUCCESS; i++) {
+        type = types[i % (sizeof(types) / sizeof(types[0]))];
+        snprintf(name, sizeof(name), ".sect.%zu", i);
+        id = section_manager_create_section(manager, name, type,
+                                            (uint16_t)(SECTION_FLAG_READABLE | SECTION_FLAG_LOADABLE));
+        if (id == SECTION_ID_INVALID) {
+            result = ERROR_OUT_OF_MEMORY;
+        }
+        for (fragment = 0; fragment < 2 && result == ERROR_SUCCESS; fragment++) {
+            size = 16 + next_random(&state) % (sizeof(filler) - 16);
+            result = section_manager_add_data(manager, id,
+                                              type == SECTION_TYPE_BSS ? NULL : filler, size,
+                                              1U << (next_random(&state) % 5), NULL);
+        }
+    }
+    
+    timer_init(&timer);
+    while (result == ERROR_SUCCESS && timer_continue(&timer)) {
+        timer_start(&timer);
+        result = section_manager_calculate_layout(manager, 0x1000);
+        timer_stop(&timer);
+    }
+    if (result == ERROR_SUCCESS) {
+        record_timer("section_layout", scale, scale, &timer, 0);
+    }
+    
+    section_manager_destroy(manager);
+    memory_pool_destroy(pool);
+    return result;
+}
+
+/* Intern scale names into a fresh table, then all of them again */
+static int bench_archive_strings(size_t scale) {
+    char** names = generate_names(scale);
+    archive_file_t* archive;
+    bench_timer_t timer;
+    char path[96];
+    uint32_t offset;
+    uint32_t sum = 0;
+    size_t pass;
+    size_t i;
+    int result = names != NULL ? ERROR_SUCCESS : ERROR_OUT_OF_MEMORY;
+    
+    snprintf(path, sizeof(path), "%s/strings.star", config.corpus_dir);
+    timer_init(&timer);
+    while (result == ERROR_SUCCESS && timer_continue(&timer)) {
+        archive = archive_create(path, NULL);
+        if (archive == NULL) {
+            result = ERROR_FILE_IO;
+            break;
+        }
+        timer_start(&timer);
+        for (pass = 0; pass < 2 && result == ERROR_SUCCESS; pass++) {
+            for (i = 0; i < scale && result == ERROR_SUCCESS; i++) {
+                result = archive_add_string(archive, names[i], &offset);
+                sum += offset;
+            }
+        }
+        timer_stop(&timer);
+        archive_close(archive);
+    }
+    bench_sink = sum;
+    remove(path);
+    if (result == ERROR_SUCCESS) {
+        record_timer("archive_add_string", scale, 2 * scale, &timer, 0);
+    }
+    
+    free_names(names);
+    return result;
+}
+
+static int bench_crc32(size_t scale) {
+    uint8_t* data = malloc(scale);
+    bench_timer_t timer;
+    uint32_t sum = 0;
+    
+    if (data == NULL) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    generate_code(data, scale, BENCH_SEED);
+    
+    timer_init(&timer);
+    while (timer_continue(&timer)) {
+        timer_start(&timer);
+        sum += crc32_calculate(data, scale);
+        timer_stop(&timer);
+    }
+    bench_sink = sum;
+    record_timer("crc32", scale, scale, &timer, 1);
+    
+    free(data);
+    return ERROR_SUCCESS;
+}
+
+/* Every available backend at its default level, via compression_benchmark_algorithm */
+static int bench_compression(void) {
+    static const star_compression_t algorithms[] = {
+        STAR_COMPRESS_LZ4, STAR_COMPRESS_ZLIB, STAR_COMPRESS_LZMA
+    };
+    uint8_t* data = malloc(BENCH_COMPRESS_SIZE);
+    compression_benchmark_t benchmark;
+    bench_result_t* entry;
+    char name[BENCH_NAME_MAX];
+    size_t i;
+    int result = data != NULL ? ERROR_SUCCESS : ERROR_OUT_OF_MEMORY;
+    
+    if (data != NULL) {
+        generate_code(data, BENCH_COMPRESS_SIZE, BENCH_SEED);
+    }
+    
+    for (i = 0; i < sizeof(algorithms) / sizeof(algorithms[0]) && result == ERROR_SUCCESS; i++) {
+        snprintf(name, sizeof(name), "compress_%s", compression_algorithm_to_string(algorithms[i]));
+        if (!compression_is_available(algorithms[i]) || !bench_selected(name)) {
+            continue;
+        }
+        if (compression_benchmark_algorithm(algorithms[i],
+                                            compression_get_default_level(algorithms[i]),
+                                            data, BENCH_COMPRESS_SIZE, &benchmark) != 0) {
+            result = ERROR_COMPRESSION_FAILED;
+            break;
+        }
+        
+        entry = add_result(name, BENCH_COMPRESS_SIZE);
+        if (entry != NULL && benchmark.compression_speed > 0.0) {
+            entry->ops = BENCH_COMPRESS_SIZE;
+            entry->ns_per_op = 1e3 / benchmark.compression_speed;
+            entry->mb_per_s = benchmark.compression_speed;
+            entry->ratio = benchmark.compression_ratio;
+            entry->memory = benchmark.memory_usage;
+        }
+        snprintf(name, sizeof(name), "decompress_%s",
+                 compression_algorithm_to_string(algorithms[i]));
+        entry = add_result(name, BENCH_COMPRESS_SIZE);
+        if (entry != NULL && benchmark.decompression_speed > 0.0) {
+            entry->ops = BENCH_COMPRESS_SIZE;
+            entry->ns_per_op = 1e3 / benchmark.decompression_speed;
+            entry->mb_per_s = benchmark.decompression_speed;
+        }
+    }
+    
+    free(data);
+    return result;
+}
+
+static void corpus_path(char* path, size_t size, size_t index) {
+    snprintf(path, size, "%s/obj_%04zu.smof", config.corpus_dir, index);
+}
+
+static uint32_t add_name(char* strings, uint32_t* string_size, const char* name) {
+    uint32_t offset = *string_size;
+    
+    strcpy(strings + offset, name);
+    *string_size += (uint32_t)strlen(name) + 1;
+    return offset;
+}
+
+/*
+ * Object index of count: BENCH_FUNCTIONS functions in .text, each with an
+ * ABS32 reference to a function of the next object and a REL32 call to
+ * its neighbour, so every object has undefined symbols the link resolves.
+ * Layout: header, section, symbols, relocations, strings, code.
+ */
+static int write_corpus_object(size_t index, size_t count) {
+    smof_header_t header;
+    smof_section_t section;
+    smof_symbol_t symbols[BENCH_OBJECT_SYMBOLS];
+    smof_relocation_t relocs[2 * BENCH_FUNCTIONS];
+    uint8_t text[BENCH_TEXT_SIZE];
+    char strings[BENCH_STRINGS_SIZE] = "\0.text";
+    char name[BENCH_SYMBOL_NAME_MAX];
+    char path[96];
+    uint32_t string_size = 7;
+    uint16_t symbol_count = 0;
+    uint16_t j;
+    FILE* file;
+    
+    memset(symbols, 0, sizeof(symbols));
+    memset(relocs, 0, sizeof(relocs));
+    
+    for (j = 0; j < BENCH_FUNCTIONS; j++) {
+        snprintf(name, sizeof(name), "f%u_%u", (unsigned)index, (unsigned)j);
+        symbols[symbol_count].name_offset = add_name(strings, &string_size, name);
+        symbols[symbol_count].value = (uint32_t)j * BENCH_FUNCTION_SIZE;
+        symbols[symbol_count].size = BENCH_FUNCTION_SIZE;
+        symbols[symbol_count].section_index = 0;
+        symbols[symbol_count].type = SMOF_SYM_FUNC;
+        symbols[symbol_count].binding = SMOF_BIND_GLOBAL;
+        symbol_count++;
+    }
+    for (j = 0; j < BENCH_FUNCTIONS; j++) {
+        snprintf(name, sizeof(name), "f%u_%u", (unsigned)((index + 1) % count), (unsigned)j);
+        symbols[symbol_count].name_offset = add_name(strings, &string_size, name);
+        symbols[symbol_count].section_index = SECTION_INDEX_UNDEFINED;
+        symbols[symbol_count].type = SMOF_SYM_FUNC;
+        symbols[symbol_count].binding = SMOF_BIND_GLOBAL;
+        symbol_count++;
+    }
+    if (index == 0) {
+        symbols[symbol_count].name_offset = add_name(strings, &string_size, "_start");
+        symbols[symbol_count].section_index = 0;
+        symbols[symbol_count].type = SMOF_SYM_FUNC;
+        symbols[symbol_count].binding = SMOF_BIND_GLOBAL;
+        symbol_count++;
+    }
+    
+    for (j = 0; j < BENCH_FUNCTIONS; j++) {
+        relocs[2 * j].offset = (uint32_t)j * BENCH_FUNCTION_SIZE + 4;
+        relocs[2 * j].symbol_index = (uint16_t)(BENCH_FUNCTIONS + j);
+        relocs[2 * j].type = SMOF_RELOC_ABS32;
+        relocs[2 * j + 1].offset = (uint32_t)j * BENCH_FUNCTION_SIZE + 12;
+        relocs[2 * j + 1].symbol_index = (uint16_t)((j + 1) % BENCH_FUNCTIONS);
+        relocs[2 * j + 1].type = SMOF_RELOC_REL32;
+    }
+    generate_code(text, sizeof(text), (uint32_t)(index + 1) * BENCH_SEED);
+    
+    memset(&header, 0, sizeof(header));
+    header.magic = SMOF_MAGIC;
+    header.version = SMOF_VERSION_CURRENT;
+    header.flags = SMOF_FLAG_LITTLE_ENDIAN;
+    header.section_count = 1;
+    header.symbol_count = symbol_count;
+    header.section_table_offset = sizeof(smof_header_t);
+    header.reloc_table_offset = (uint32_t)(sizeof(smof_header_t) + sizeof(smof_section_t) +
+                                           symbol_count * sizeof(smof_symbol_t));
+    header.reloc_count = 2 * BENCH_FUNCTIONS;
+    header.string_table_offset = (uint32_t)(header.reloc_table_offset + sizeof(relocs));
+    header.string_table_size = string_size;
+    
+    memset(&section, 0, sizeof(section));
+    section.name_offset = 1;
+    section.size = BENCH_TEXT_SIZE;
+    section.file_offset = header.string_table_offset + string_size;
+    section.flags = SMOF_SECT_EXECUTABLE | SMOF_SECT_LOADABLE;
+    section.alignment = 2;
+    
+    corpus_path(path, sizeof(path), index);
+    file = fopen(path, "wb");
+    if (file == NULL) {
+        return ERROR_FILE_IO;
+    }
+    if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+        fwrite(&section, sizeof(section), 1, file) != 1 ||
+        fwrite(symbols, sizeof(smof_symbol_t), symbol_count, file) != symbol_count ||
+        fwrite(relocs, sizeof(relocs), 1, file) != 1 ||
+        fwrite(strings, 1, string_size, file) != string_size ||
+        fwrite(text, 1, sizeof(text), file) != sizeof(text)) {
+        fclose(file);
+        return ERROR_FILE_IO;
+    }
+    return fclose(file) == 0 ? ERROR_SUCCESS : ERROR_FILE_IO;
+}
+
+/* Paths of a freshly written corpus of count objects */
+static char** generate_corpus(size_t count) {
+    char** paths = malloc(count * sizeof(char*));
+    char* block = malloc(count * 96);
+    size_t i;
+    int result = ERROR_SUCCESS;
+    
+    if (paths == NULL || block == NULL) {
+        free(paths);
+        free(block);
+        return NULL;
+    }
+    for (i = 0; i < count && result == ERROR_SUCCESS; i++) {
+        paths[i] = block + i * 96;
+        corpus_path(paths[i], 96, i);
+        result = write_corpus_object(i, count);
+    }
+    if (result != ERROR_SUCCESS) {
+        free_names(paths);
+        return NULL;
+    }
+    return paths;
+}
+
+static void remove_corpus(char** paths, size_t count) {
+    size_t i;
+    
+    for (i = 0; i < count; i++) {
+        remove(paths[i]);
+    }
+    free_names(paths);
+}
+
+static int bench_link(char* const* paths, size_t count) {
+    stld_options_t options = stld_get_default_options();
+    stld_context_t* context;
+    bench_timer_t timer;
+    char output[96];
+    size_t i;
+    int result = ERROR_SUCCESS;
+    
+    options.threads = config.threads;
+    snprintf(output, sizeof(output), "%s/linked.smof", config.corpus_dir);
+    
+    timer_init(&timer);
+    while (result == ERROR_SUCCESS && timer_continue(&timer)) {
+        timer_start(&timer);
+        context = stld_context_create(&options);
+        if (context == NULL) {
+            result = ERROR_OUT_OF_MEMORY;
+        }
+        for (i = 0; i < count && result == ERROR_SUCCESS; i++) {
+            result = stld_add_input_file(context, paths[i]);
+        }
+        if (result == ERROR_SUCCESS) {
+            result = stld_link(context, output);
+        }
+        stld_context_destroy(context);
+        timer_stop(&timer);
+    }
+    remove(output);
+    if (result == ERROR_SUCCESS) {
+        record_timer("stld_link", count, count, &timer, 0);
+    }
+    return result;
+}
+
+static int bench_archive_create(const char* name, star_compression_t compression,
+                                char* const* paths, size_t count) {
+    star_options_t options = star_get_default_options();
+    star_context_t* context;
+    bench_timer_t timer;
+    char archive[96];
+    int result = ERROR_SUCCESS;
+    
+    options.compression = compression;
+    options.threads = config.threads;
+    options.force_overwrite = true;
+    snprintf(archive, sizeof(archive), "%s/corpus.star", config.corpus_dir);
+    
+    timer_init(&timer);
+    while (result == ERROR_SUCCESS && timer_continue(&timer)) {
+        remove(archive);
+        timer_start(&timer);
+        context = star_context_create(&options);
+        result = context != NULL ?
+                 star_create_archive(context, archive, (const char* const*)paths, count) :
+                 ERROR_OUT_OF_MEMORY;
+        star_context_destroy(context);
+        timer_stop(&timer);
+    }
+    remove(archive);
+    if (result == ERROR_SUCCESS) {
+        record_timer(name, count, count, &timer, BENCH_TEXT_SIZE);
+    }
+    return result;
+}
+
+static int bench_corpus(size_t count) {
+    char** paths;
+    int result = ERROR_SUCCESS;
+    
+    if (!bench_selected("stld_link") && !bench_selected("star_create_archive")) {
+        return ERROR_SUCCESS;
+    }
+    paths = generate_corpus(count);
+    if (paths == NULL) {
+        return ERROR_FILE_IO;
+    }
+    
+    if (bench_selected("stld_link")) {
+        result = bench_link(paths, count);
+    }
+    if (result == ERROR_SUCCESS && bench_selected("star_create_archive")) {
+        result = bench_archive_create("star_create_archive", STAR_COMPRESS_NONE, paths, count);
+    }
+    if (result == ERROR_SUCCESS && bench_selected("star_create_archive_lz4") &&
+        compression_is_available(STAR_COMPRESS_LZ4)) {
+        result = bench_archive_create("star_create_archive_lz4", STAR_COMPRESS_LZ4, paths, count);
+    }
+    
+    remove_corpus(paths, count);
+    return result;
+}
+
+/* Run a benchmark over its scales; false after the first failure */
+static bool run_scales(const char* name, int (*bench)(size_t),
+                       const size_t* scales, size_t count) {
+    size_t i;
+    int result;
+    
+    for (i = 0; i < scale_count(count); i++) {
+        result = bench(scales[i]);
+        if (result != ERROR_SUCCESS) {
+            report_failure(name, scales[i], result);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool run_benchmarks(void) {
+    int result;
+    
+    if ((bench_selected("symbol_table_insert") || bench_selected("symbol_table_lookup")) &&
+        !run_scales("symbol_table", bench_symbol_table, symbol_scales, SCALE_COUNT(symbol_scales))) {
+        return false;
+    }
+    if (bench_selected("relocation_process_all") &&
+        !run_scales("relocation_process_all", bench_relocation, reloc_scales,
+                    SCALE_COUNT(reloc_scales))) {
+        return false;
+    }
+    if (bench_selected("section_layout") &&
+        !run_scales("section_layout", bench_section_layout, section_scales,
+                    SCALE_COUNT(section_scales))) {
+        return false;
+    }
+    if (bench_selected("archive_add_string") &&
+        !run_scales("archive_add_string", bench_archive_strings, string_scales,
+                    SCALE_COUNT(string_scales))) {
+        return false;
+    }
+    if (bench_selected("crc32") &&
+        !run_scales("crc32", bench_crc32, crc_scales, SCALE_COUNT(crc_scales))) {
+        return false;
+    }
+    
+    result = bench_compression();
+    if (result != ERROR_SUCCESS) {
+        report_failure("compression", BENCH_COMPRESS_SIZE, result);
+        return false;
+    }
+    
+    return run_scales("corpus", bench_corpus, corpus_scales, SCALE_COUNT(corpus_scales));
+}
+
+/* Fixed key order and number formats so runs diff line by line */
+static void write_results(FILE* out) {
+    const bench_result_t* result;
+    size_t i;
+    
+    fprintf(out, "{\n");
+    fprintf(out, "  \"format\": %d,\n", BENCH_FORMAT_VERSION);
+#ifdef NDEBUG
+    fprintf(out, "  \"build\": \"release\",\n");
+#else
+    fprintf(out, "  \"build\": \"debug\",\n");
+#endif
+    fprintf(out, "  \"quick\": %s,\n", config.quick ? "true" : "false");
+    fprintf(out, "  \"threads\": %zu,\n", config.threads);
+    fprintf(out, "  \"results\": [\n");
+    
+    for (i = 0; i < result_count; i++) {
+        result = &results[i];
+        fprintf(out, "    {\"name\": \"%s\", \"scale\": %zu, \"ops\": %zu",
+                result->name, result->scale, result->ops);
+        if (result->runs > 0) {
+            fprintf(out, ", \"runs\": %zu", result->runs);
+        }
+        fprintf(out, ", \"ns_per_op\": %.3f", result->ns_per_op);
+        if (result->runs > 0) {
+            fprintf(out, ", \"mean_ns_per_op\": %.3f", result->mean_ns_per_op);
+        }
+        if (result->mb_per_s > 0.0) {
+            fprintf(out, ", \"mb_per_s\": %.1f", result->mb_per_s);
+        }
+        if (result->ratio > 0.0) {
+            fprintf(out, ", \"ratio\": %.4f", result->ratio);
+        }
+        if (result->memory > 0) {
+            fprintf(out, ", \"memory_bytes\": %zu", result->memory);
+        }
+        fprintf(out, "}%s\n", i + 1 < result_count ? "," : "");
+    }
+    
+    fprintf(out, "  ]\n");
+    fprintf(out, "}\n");
+}
+
+static void print_usage(const char* program) {
+    printf("Usage: %s [options]\n", program);
+    printf("Options:\n");
+    printf("  -o, --output FILE    Write the JSON results to FILE (default: stdout)\n");
+    printf("  -f, --filter TEXT    Run only benchmarks whose name contains TEXT\n");
+    printf("  -q, --quick          Smallest scale only, with a short time budget\n");
+    printf("  -t, --threads N      Worker threads for link and archive (0 = one per CPU)\n");
+    printf("  -h, --help           Show this help\n");
+}
+
+static int parse_arguments(int argc, char* argv[]) {
+    static struct option long_options[] = {
+        {"output",  required_argument, 0, 'o'},
+        {"filter",  required_argument, 0, 'f'},
+        {"quick",   no_argument,       0, 'q'},
+        {"threads", required_argument, 0, 't'},
+        {"help",    no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+    char* end;
+    int opt;
+    
+    while ((opt = getopt_long(argc, argv, "o:f:qt:h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'o':
+                config.output_file = optarg;
+                break;
+            case 'f':
+                config.filter = optarg;
+                break;
+            case 'q':
+                config.quick = true;
+                config.budget_ns = BENCH_QUICK_NS;
+                break;
+            case 't':
+                config.threads = (size_t)strtoul(optarg, &end, 10);
+                if (*optarg == '\0' || *end != '\0') {
+                    fprintf(stderr, "Error: Invalid thread count '%s'\n", optarg);
+                    return -1;
+                }
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                exit(0);
+            default:
+                print_usage(argv[0]);
+                return -1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    const char* tmp = getenv("TMPDIR");
+    FILE* out = stdout;
+    bool ok;
+    
+    if (parse_arguments(argc, argv) != 0) {
+        return 1;
+    }
+    
+    snprintf(config.corpus_dir, sizeof(config.corpus_dir), "%s/stld_bench_XXXXXX",
+             tmp != NULL && *tmp != '\0' && strlen(tmp) < 40 ? tmp : "/tmp");
+    if (mkdtemp(config.corpus_dir) == NULL) {
+        fprintf(stderr, "Error: Cannot create corpus directory in %s\n", config.corpus_dir);
+        return 1;
+    }
+    
+    fprintf(stderr, "Running benchmarks (corpus in %s)\n", config.corpus_dir);
+    ok = run_benchmarks();
+    rmdir(config.corpus_dir);
+    compression_release_cache();
+    
+    if (!ok) {
+        return 1;
+    }
+    
+    if (config.output_file != NULL) {
+        out = fopen(config.output_file, "w");
+        if (out == NULL) {
+            fprintf(stderr, "Error: Cannot open output file '%s'\n", config.output_file);
+            return 1;
+        }
+    }
+    write_results(out);
+    if (out != stdout && fclose(out) != 0) {
+        fprintf(stderr, "Error: Cannot write output file '%s'\n", config.output_file);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,1279 @@
+/* tests/test_archive.c */
+#include "unity.h"
+#include "archive.h"
+#include "archive_io.h"
+#include "star.h"
+#include "compress.h"
+#include "index.h"
+#include "error.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * @file test_archive.c
+ * @brief Unit tests for the STAR archive format
+ * @details Tests string interning, archives streamed to disk, reading
+ * them back through the file and through a mapping, compressed members,
+ * updating, deleting and compacting in place, shared dictionaries,
+ * choosing the compression per member, deduplication, batched I/O and
+ * sorted member tables
+ */
+
+/* Function prototypes */
+void test_archive_interns_strings(void);
+void test_archive_interns_loaded_strings(void);
+void test_archive_streams_members(void);
+void test_archive_maps_members(void);
+void test_archive_extracts_members(void);
+void test_archive_compresses_members(void);
+void test_archive_compresses_in_parallel(void);
+void test_archive_extracts_in_parallel(void);
+void test_archive_reads_block_ranges(void);
+void test_archive_updates_in_place(void);
+void test_archive_deletes_and_compacts(void);
+void test_archive_shares_a_dictionary(void);
+void test_archive_chooses_compression_per_member(void);
+void test_archive_deduplicates_members(void);
+void test_archive_batches_io(void);
+void test_archive_sorts_members(void);
+int test_archive_main(void);
+
+#define TEST_ARCHIVE    "/tmp/star_test.star"
+#define TEST_MEMBER_A   "/tmp/star_test_a.smof"
+#define TEST_MEMBER_B   "/tmp/star_test_b.smof"
+#define TEST_EXTRACTED  "/tmp/star_test_out.smof"
+#define TEST_SERIAL     "/tmp/star_test_serial.star"
+#define TEST_PARALLEL   24
+#define TEST_BLOCK      STAR_MIN_BLOCK_SIZE
+#define TEST_BLOCKED    (4 * TEST_BLOCK + 1000)
+#define TEST_MANY_NAMES 10000
+#define TEST_LARGE_SIZE (3 * ARCHIVE_STREAM_CHUNK_SIZE + 123)
+#define TEST_IO_REQUESTS 200
+
+static archive_file_t* test_archive;
+
+void setUp(void) {
+    test_archive = NULL;
+}
+
+void tearDown(void) {
+    archive_close(test_archive);
+    test_archive = NULL;
+    remove(TEST_ARCHIVE);
+    remove(TEST_MEMBER_A);
+    remove(TEST_MEMBER_B);
+    remove(TEST_EXTRACTED);
+    remove(TEST_SERIAL);
+}
+
+static void write_file(const char* filename, const char* contents) {
+    FILE* file = fopen(filename, "wb");
+    
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)fwrite(contents, strlen(contents), 1, file));
+    fclose(file);
+}
+
+void test_archive_interns_strings(void) {
+    static uint32_t offsets[TEST_MANY_NAMES];
+    uint32_t offset;
+    uint32_t expected_size = 1;
+    char name[32];
+    uint32_t i;
+    
+    test_archive = archive_create(TEST_ARCHIVE, NULL);
+    TEST_ASSERT_NOT_NULL(test_archive);
+    
+    for (i = 0; i < TEST_MANY_NAMES; i++) {
+        snprintf(name, sizeof(name), "member_%u.smof", i);
+        TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, archive_add_string(test_archive, name, &offsets[i]));
+        TEST_ASSERT_EQUAL_UINT(expected_size, offsets[i]);
+        expected_size += (uint32_t)strlen(name) + 1;
+    }
+    TEST_ASSERT_EQUAL_UINT(expected_size, test_archive->header.string_table_size);
+    
+    /* Repeats return the first copy and leave the table alone */
+    for (i = 0; i < TEST_MANY_NAMES; i++) {
+        snprintf(name, sizeof(name), "member_%u.smof", i);
+        TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, archive_add_string(test_archive, name, &offset));
+        TEST_ASSERT_EQUAL_UINT(offsets[i], offset);
+        TEST_ASSERT_EQUAL_STRING(name, archive_get_string(test_archive, offset));
+    }
+    TEST_ASSERT_EQUAL_UINT(expected_size, test_archive->header.string_table_size);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, archive_add_string(test_archive, "", &offset));
+    TEST_ASSERT_EQUAL_UINT(0, offset);
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_ARGUMENT, archive_add_string(test_archive, NULL, &offset));
+}
+
+void test_archive_interns_loaded_strings(void) {
+    archive_member_t* member;
+    uint32_t size;
+    uint32_t offset;
+    
+    write_file(TEST_MEMBER_A, "first member");
+    write_file(TEST_MEMBER_B, "second member");
+    test_archive = archive_create(TEST_ARCHIVE, NULL);
+    TEST_ASSERT_NOT_NULL(test_archive);
+    test_archive->header.flags &= (uint16_t)~STAR_FLAG_INDEXED;
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          archive_add_member_from_file(test_archive, "a.smof", TEST_MEMBER_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          archive_add_member_from_file(test_archive, "b.smof", TEST_MEMBER_B));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, archive_finalize(test_archive));
+    archive_close(test_archive);
+    
+    /* A table read back is indexed on first use */
+    test_archive = archive_open(TEST_ARCHIVE, "rb");
+    TEST_ASSERT_NOT_NULL(test_archive);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, archive_load_members(test_archive));
+    member = archive_find_member(test_archive, "b.smof");
+    TEST_ASSERT_NOT_NULL(member);
+    size = test_archive->header.string_table_size;
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, archive_add_string(test_archive, "b.smof", &offset));
+    TEST_ASSERT_EQUAL_UINT(member->header.name_offset, offset);
+    TEST_ASSERT_EQUAL_UINT(size, test_archive->header.string_table_size);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, archive_add_string(test_archive, "c.smof", &offset));
+    TEST_ASSERT_EQUAL_UINT(size, offset);
+    TEST_ASSERT_EQUAL_STRING("c.smof", archive_get_string(test_archive, offset));
+    TEST_ASSERT_EQUAL_STRING("a.smof", archive_get_string(test_archive, 1));
+}
+
+/* Two-member archive written by the archiver, as stld's libraries are */
+static void write_archive(void) {
+    const char* files[] = {TEST_MEMBER_A, TEST_MEMBER_B};
+    star_options_t options = star_get_default_options();
+    star_context_t* context;
+    
+    write_file(TEST_MEMBER_A, "first member");
+    write_file(TEST_MEMBER_B, "second member");
+    options.create_index = false;
+    context = star_context_create(&options);
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, star_create_archive(context, TEST_ARCHIVE, files, 2));
+    star_context_destroy(context);
+}
+
+void test_archive_streams_members(void) {
+    const char* names[] = {"small.smof", "large.bin"};
+    uint8_t* large = malloc(TEST_LARGE_SIZE);
+    uint8_t* data;
+    archive_member_t* member;
+    FILE* file;
+    size_t i;
+    
+    TEST_ASSERT_NOT_NULL(large);
+    for (i = 0; i < TEST_LARGE_SIZE; i++) {
+        large[i] = (uint8_t)(i * 7 + (i >> 12));
+    }
+    file = fopen(TEST_MEMBER_B, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)fwrite(large, TEST_LARGE_SIZE, 1, file));
+    fclose(file);
+    write_file(TEST_MEMBER_A, "tiny");
+    
+    test_archive = archive_create(TEST_ARCHIVE, NULL);
+    TEST_ASSERT_NOT_NULL(test_archive);
+    test_archive->header.flags |= STAR_FLAG_INDEXED;
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, archive_reserve_members(test_archive, names, 2));
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_ARGUMENT,
+                          archive_add_member_from_file(test_archive, "late.smof", TEST_MEMBER_A));
+    
+    /* Members may be streamed in any order; data follows in stream order */
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          archive_stream_member_from_file(test_archive, 1, TEST_MEMBER_B));
+    TEST_ASSERT_EQUAL_INT(ERROR_FILE_IO,
+                          archive_stream_member_from_file(test_archive, 0, "/nonexistent/file"));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          archive_stream_member_from_file(test_archive, 0, TEST_MEMBER_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_ARGUMENT,
+                          archive_stream_member_from_file(test_archive, 0, TEST_MEMBER_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, archive_finalize(test_archive));
+    archive_close(test_archive);
+    
+    test_archive = archive_open(TEST_ARCHIVE, "rb");
+    TEST_ASSERT_NOT_NULL(test_archive);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, archive_load_members(test_archive));
+    TEST_ASSERT_EQUAL_UINT(2, test_archive->header.member_count);
+    TEST_ASSERT_TRUE(test_archive->header.index_offset >= test_archive->members[0].header.data_offset + 4);
+    
+    member = archive_find_member(test_archive, "large.bin");
+    TEST_ASSERT_NOT_NULL(member);
+    TEST_ASSERT_EQUAL_UINT(TEST_LARGE_SIZE, member->header.size);
+    TEST_ASSERT_EQUAL_HEX32(archive_calculate_checksum(large, TEST_LARGE_SIZE),
+                            member->header.checksum);
+    TEST_ASSERT_EQUAL_UINT(test_archive->members[0].header.data_offset - TEST_LARGE_SIZE,
+                           member->header.data_offset);
+    
+    data = malloc(TEST_LARGE_SIZE);
+    TEST_ASSERT_NOT_NULL(data);
+    TEST_ASSERT_EQUAL_INT(0, fseek(test_archive->file, (long)member->header.data_offset, SEEK_SET));
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)fread(data, TEST_LARGE_SIZE, 1, test_archive->file));
+    TEST_ASSERT_EQUAL_MEMORY(large, data, TEST_LARGE_SIZE);
+    
+    free(data);
+    free(large);
+}
+
+void test_archive_maps_members(void) {
+    archive_member_t* member;
+    const uint8_t* data;
+    
+    write_archive();
+    test_archive = archive_map(TEST_ARCHIVE);
+    TEST_ASSERT_NOT_NULL(test_archive);
+    TEST_ASSERT_NOT_NULL(test_archive->map);
+    TEST_ASSERT_EQUAL_UINT(2, test_archive->header.member_count);
+    
+    /* Names and data are read where they lie in the mapping */
+    member = archive_find_member(test_archive, TEST_MEMBER_B);
+    TEST_ASSERT_EQUAL_PTR(&test_archive->members[1], member);
+    TEST_ASSERT_TRUE((uint8_t*)member->name > test_archive->map);
+    TEST_ASSERT_TRUE((uint8_t*)member->name < test_archive->map + test_archive->map_size);
+    data = archive_member_data(test_archive, member);
+    TEST_ASSERT_EQUAL_PTR(test_archive->map + member->header.data_offset, data);
+    TEST_ASSERT_EQUAL_UINT(13, member->header.size);
+    TEST_ASSERT_EQUAL_MEMORY("second member", data, 13);
+    
+    TEST_ASSERT_EQUAL_PTR(&test_archive->members[0], archive_find_member(test_archive, TEST_MEMBER_A));
+    TEST_ASSERT_NULL(archive_find_member(test_archive, "missing.smof"));
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_ARGUMENT,
+                          archive_add_string(test_archive, "c.smof", &(uint32_t){0}));
+    archive_close(test_archive);
+    
+    /* A member table running past the end of the file is rejected */
+    test_archive = NULL;
+    TEST_ASSERT_EQUAL_INT(0, truncate(TEST_ARCHIVE, STAR_HEADER_SIZE + 8));
+    TEST_ASSERT_NULL(archive_map(TEST_ARCHIVE));
+    TEST_ASSERT_NULL(archive_map("/nonexistent/archive.star"));
+}
+
+void test_archive_extracts_members(void) {
+    star_context_t* context;
+    const uint8_t* data;
+    const uint8_t* again;
+    uint8_t* copy;
+    size_t size;
+    char contents[32];
+    FILE* file;
+    
+    write_archive();
+    
+    /* Unmapped archives read member data from the file */
+    test_archive = archive_open(TEST_ARCHIVE, "rb");
+    TEST_ASSERT_NOT_NULL(test_archive);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, archive_load_members(test_archive));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          archive_extract_member(test_archive, &test_archive->members[0],
+                                                 TEST_EXTRACTED));
+    file = fopen(TEST_EXTRACTED, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    memset(contents, 0, sizeof(contents));
+    TEST_ASSERT_EQUAL_UINT(12, (uint32_t)fread(contents, 1, sizeof(contents), file));
+    fclose(file);
+    TEST_ASSERT_EQUAL_STRING("first member", contents);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          archive_extract_member_to_memory(test_archive, &test_archive->members[1],
+                                                           &copy, &size));
+    TEST_ASSERT_EQUAL_UINT(13, (uint32_t)size);
+    TEST_ASSERT_EQUAL_MEMORY("second member", copy, 13);
+    free(copy);
+    
+    /* The context keeps the archive mapped across calls */
+    context = star_context_create(NULL);
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          star_extract_member_to_memory(context, TEST_ARCHIVE, TEST_MEMBER_B,
+                                                        &data, &size));
+    TEST_ASSERT_EQUAL_UINT(13, (uint32_t)size);
+    TEST_ASSERT_EQUAL_MEMORY("second member", data, 13);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          star_extract_member_to_memory(context, TEST_ARCHIVE, TEST_MEMBER_A,
+                                                        &again, &size));
+    TEST_ASSERT_EQUAL_PTR(data - 12, again);
+    TEST_ASSERT_EQUAL_INT(ERROR_MEMBER_NOT_FOUND,
+                          star_extract_member_to_memory(context, TEST_ARCHIVE, "missing.smof",
+                                                        &data, &size));
+    TEST_ASSERT_NULL(data);
+    TEST_ASSERT_EQUAL_INT(ERROR_FILE_NOT_FOUND,
+                          star_extract_member_to_memory(context, "/nonexistent/archive.star",
+                                                        TEST_MEMBER_A, &data, &size));
+    star_context_destroy(context);
+}
+
+void test_archive_compresses_members(void) {
+    const star_compression_t algorithms[] = {STAR_COMPRESS_LZ4, STAR_COMPRESS_ZLIB,
+                                             STAR_COMPRESS_LZMA};
+    const char* files[] = {TEST_MEMBER_A, TEST_MEMBER_B};
+    star_options_t options = star_get_default_options();
+    star_context_t* context;
+    archive_member_t* member;
+    const uint8_t* data;
+    uint8_t* copy;
+    char text[4096];
+    size_t size;
+    size_t i;
+    
+    for (i = 0; i + 16 < sizeof(text); i += 16) {
+        memcpy(text + i, ".text .data .bss", 16);
+    }
+    text[i] = '\0';
+    
+    for (i = 0; i < sizeof(algorithms) / sizeof(algorithms[0]); i++) {
+        if (!compression_is_available(algorithms[i])) {
+            continue;
+        }
+        
+        write_file(TEST_MEMBER_A, text);
+        write_file(TEST_MEMBER_B, "tiny");
+        options.compression = algorithms[i];
+        context = star_context_create(&options);
+        TEST_ASSERT_NOT_NULL(context);
+        TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, star_create_archive(context, TEST_ARCHIVE, files, 2));
+        
+        /* Data that would not shrink is stored as it is */
+        test_archive = archive_map(TEST_ARCHIVE);
+        TEST_ASSERT_NOT_NULL(test_archive);
+        member = archive_find_member(test_archive, TEST_MEMBER_A);
+        TEST_ASSERT_TRUE(archive_member_is_compressed(member));
+        TEST_ASSERT_EQUAL_UINT(algorithms[i], member->header.compression);
+        TEST_ASSERT_EQUAL_UINT((uint32_t)strlen(text), member->header.size);
+        TEST_ASSERT_TRUE(member->header.compressed_size < member->header.size / 4);
+        TEST_ASSERT_FALSE(archive_member_is_compressed(&test_archive->members[1]));
+        TEST_ASSERT_EQUAL_UINT(4, test_archive->members[1].header.compressed_size);
+        
+        TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                              archive_extract_member_to_memory(test_archive, member, &copy, &size));
+        TEST_ASSERT_EQUAL_UINT((uint32_t)strlen(text), (uint32_t)size);
+        TEST_ASSERT_EQUAL_MEMORY(text, copy, (uint32_t)size);
+        free(copy);
+        archive_close(test_archive);
+        test_archive = NULL;
+        
+        TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                              star_extract_member_to_memory(context, TEST_ARCHIVE, TEST_MEMBER_A,
+                                                            &data, &size));
+        TEST_ASSERT_EQUAL_MEMORY(text, data, (uint32_t)size);
+        star_context_destroy(context);
+        
+        /* Through the file too, checked against the member CRC */
+        test_archive = archive_open(TEST_ARCHIVE, "rb");
+        TEST_ASSERT_NOT_NULL(test_archive);
+        TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, archive_load_members(test_archive));
+        TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                              archive_extract_member(test_archive, &test_archive->members[0],
+                                                     TEST_EXTRACTED));
+        test_archive->members[0].header.checksum ^= 1;
+        TEST_ASSERT_EQUAL_INT(ERROR_ARCHIVE_CORRUPT,
+                              archive_extract_member_to_memory(test_archive,
+                                                               &test_archive->members[0],
+                                                               &copy, &size));
+        archive_close(test_archive);
+        test_archive = NULL;
+    }
+}
+
+static uint8_t* read_whole_file(const char* filename, size_t* size) {
+    FILE* file = fopen(filename, "rb");
+    uint8_t* data;
+    long length;
+    
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL_INT(0, fseek(file, 0, SEEK_END));
+    length = ftell(file);
+    TEST_ASSERT_TRUE(length > 0);
+    rewind(file);
+    data = calloc((size_t)length, 1);
+    TEST_ASSERT_NOT_NULL(data);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)fread(data, (size_t)length, 1, file));
+    fclose(file);
+    *size = (size_t)length;
+    
+    return data;
+}
+
+static char parallel_names[TEST_PARALLEL][32];
+
+/* Contents of the i-th of the TEST_PARALLEL members, of varying length */
+static void parallel_text(size_t i, char* text, size_t size) {
+    size_t j;
+    
+    for (j = 0; j + 1 < size / (i + 1); j++) {
+        text[j] = (char)('a' + (j * (i + 3) / 7) % 26);
+    }
+    text[j] = '\0';
+}
+
+static void write_parallel_files(const char** files) {
+    char text[2048];
+    size_t i;
+    
+    for (i = 0; i < TEST_PARALLEL; i++) {
+        snprintf(parallel_names[i], sizeof(parallel_names[i]), "/tmp/star_test_p%u.smof",
+                 (unsigned)i);
+        parallel_text(i, text, sizeof(text));
+        write_file(parallel_names[i], text);
+        files[i] = parallel_names[i];
+    }
+}
+
+static void remove_parallel_files(void) {
+    size_t i;
+    
+    for (i = 0; i < TEST_PARALLEL; i++) {
+        remove(parallel_names[i]);
+    }
+}
+
+void test_archive_compresses_in_parallel(void) {
+    const char* files[TEST_PARALLEL];
+    star_options_t options = star_get_default_options();
+    star_context_t* context;
+    uint8_t* serial;
+    uint8_t* parallel;
+    size_t serial_size;
+    size_t parallel_size;
+    
+    write_parallel_files(files);
+    
+    /* Members land in list order, so the output matches a serial run */
+    options.compression = STAR_COMPRESS_LZ4;
+    options.threads = 1;
+    context = star_context_create(&options);
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          star_create_archive(context, TEST_SERIAL, files, TEST_PARALLEL));
+    star_context_destroy(context);
+    
+    options.threads = 4;
+    context = star_context_create(&options);
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          star_create_archive(context, TEST_ARCHIVE, files, TEST_PARALLEL));
+    
+    serial = read_whole_file(TEST_SERIAL, &serial_size);
+    parallel = read_whole_file(TEST_ARCHIVE, &parallel_size);
+    TEST_ASSERT_EQUAL_UINT((uint32_t)serial_size, (uint32_t)parallel_size);
+    TEST_ASSERT_EQUAL_MEMORY(serial + sizeof(star_header_t), parallel + sizeof(star_header_t),
+                             (uint32_t)(serial_size - sizeof(star_header_t)));
+    free(serial);
+    free(parallel);
+    
+    test_archive = archive_map(TEST_ARCHIVE);
+    TEST_ASSERT_NOT_NULL(test_archive);
+    TEST_ASSERT_EQUAL_UINT(TEST_PARALLEL, test_archive->header.member_count);
+    TEST_ASSERT_TRUE(archive_member_is_compressed(&test_archive->members[0]));
+    archive_close(test_archive);
+    test_archive = NULL;
+    
+    /* A member that cannot be read stops the pipeline without a hang */
+    files[TEST_PARALLEL / 2] = TEST_MEMBER_A;
+    TEST_ASSERT_EQUAL_INT(ERROR_FILE_IO,
+                          star_create_archive(context, TEST_ARCHIVE, files, TEST_PARALLEL));
+    star_context_destroy(context);
+    remove_parallel_files();
+}
+
+void test_archive_extracts_in_parallel(void) {
+    const size_t limits[] = {0, 1};
+    const char* files[TEST_PARALLEL];
+    const char* missing[] = {"/tmp/star_test_p0.smof", "no_such_member"};
+    star_options_t options = star_get_default_options();
+    star_context_t* context;
+    uint8_t* data;
+    char text[2048];
+    size_t size;
+    size_t i;
+    size_t j;
+    
+    write_parallel_files(files);
+    options.compression = STAR_COMPRESS_ZLIB;
+    options.threads = 4;
+    if (!compression_is_available(options.compression)) {
+        options.compression = STAR_COMPRESS_LZ4;
+    }
+    
+    /* Without a limit, and with one member in memory at a time */
+    for (i = 0; i < sizeof(limits) / sizeof(limits[0]); i++) {
+        options.max_memory = limits[i];
+        context = star_context_create(&options);
+        TEST_ASSERT_NOT_NULL(context);
+        TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                              star_create_archive(context, TEST_ARCHIVE, files, TEST_PARALLEL));
+        remove_parallel_files();
+        
+        TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                              star_extract_archive(context, TEST_ARCHIVE, NULL, NULL, 0));
+        for (j = 0; j < TEST_PARALLEL; j++) {
+            parallel_text(j, text, sizeof(text));
+            data = read_whole_file(files[j], &size);
+            TEST_ASSERT_EQUAL_UINT((uint32_t)strlen(text), (uint32_t)size);
+            TEST_ASSERT_EQUAL_MEMORY(text, data, (uint32_t)size);
+            free(data);
+        }
+        
+        /* Names are resolved before anything is written */
+        remove(files[0]);
+        TEST_ASSERT_EQUAL_INT(ERROR_MEMBER_NOT_FOUND,
+                              star_extract_archive(context, TEST_ARCHIVE, NULL, missing, 2));
+        TEST_ASSERT_EQUAL_INT(-1, access(files[0], F_OK));
+        TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                              star_extract_archive(context, TEST_ARCHIVE, NULL, missing, 1));
+        TEST_ASSERT_EQUAL_INT(0, access(files[0], F_OK));
+        star_context_destroy(context);
+    }
+    
+    remove_parallel_files();
+}
+
+static void check_range(const archive_file_t* archive, const archive_member_t* member,
+                        const uint8_t* expected, uint32_t offset, size_t size) {
+    uint8_t* output = calloc(size + 1, 1);
+    
+    TEST_ASSERT_NOT_NULL(output);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          archive_read_member_range(archive, member, offset, size, output));
+    TEST_ASSERT_EQUAL_MEMORY(expected + offset, output, (uint32_t)size);
+    free(output);
+}
+
+void test_archive_reads_block_ranges(void) {
+    const char* files[] = {TEST_MEMBER_A};
+    star_options_t options = star_get_default_options();
+    star_context_t* context;
+    archive_member_t* member;
+    star_block_entry_t last;
+    uint8_t* data;
+    uint8_t output[64];
+    uint32_t seed = 1;
+    FILE* file;
+    size_t i;
+    
+    /* Compressible blocks, then one of noise that is stored as it is */
+    data = calloc(TEST_BLOCKED, 1);
+    TEST_ASSERT_NOT_NULL(data);
+    for (i = 0; i < TEST_BLOCKED; i++) {
+        seed = seed * 1103515245U + 12345U;
+        data[i] = i >= 2 * TEST_BLOCK && i < 3 * TEST_BLOCK ? (uint8_t)(seed >> 16) :
+                  (uint8_t)((size_t)"symbol_table"[i % 12] + i / TEST_BLOCK);
+    }
+    file = fopen(TEST_MEMBER_A, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)fwrite(data, TEST_BLOCKED, 1, file));
+    fclose(file);
+    
+    options.compression = STAR_COMPRESS_LZ4;
+    options.block_size = TEST_BLOCK;
+    options.threads = 4;
+    TEST_ASSERT_TRUE(star_validate_options(&options));
+    context = star_context_create(&options);
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, star_create_archive(context, TEST_ARCHIVE, files, 1));
+    
+    test_archive = archive_map(TEST_ARCHIVE);
+    TEST_ASSERT_NOT_NULL(test_archive);
+    member = &test_archive->members[0];
+    TEST_ASSERT_TRUE(archive_member_is_blocked(member));
+    TEST_ASSERT_EQUAL_UINT(12, member->header.block_shift);
+    TEST_ASSERT_TRUE(member->header.compressed_size < TEST_BLOCKED / 2 + TEST_BLOCK);
+    
+    /* Whole, across a block boundary, one exact block and the last byte */
+    check_range(test_archive, member, data, 0, TEST_BLOCKED);
+    check_range(test_archive, member, data, TEST_BLOCK - 100, 200);
+    check_range(test_archive, member, data, 2 * TEST_BLOCK, TEST_BLOCK);
+    check_range(test_archive, member, data, TEST_BLOCKED - 1, 1);
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_ARGUMENT,
+                          archive_read_member_range(test_archive, member, TEST_BLOCKED - 1, 2,
+                                                    output));
+    memcpy(&last, archive_member_data(test_archive, member) + 4 * sizeof(last), sizeof(last));
+    archive_close(test_archive);
+    test_archive = NULL;
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          star_read_member_range(context, TEST_ARCHIVE, TEST_MEMBER_A,
+                                                 3 * TEST_BLOCK + 10, output, sizeof(output)));
+    TEST_ASSERT_EQUAL_MEMORY(data + 3 * TEST_BLOCK + 10, output, sizeof(output));
+    star_context_destroy(context);
+    
+    /* Damage only the last block: earlier ranges still read, the whole member does not */
+    file = fopen(TEST_ARCHIVE, "r+b");
+    TEST_ASSERT_NOT_NULL(file);
+    test_archive = archive_open(TEST_ARCHIVE, "rb");
+    TEST_ASSERT_NOT_NULL(test_archive);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, archive_load_members(test_archive));
+    member = &test_archive->members[0];
+    TEST_ASSERT_EQUAL_INT(0, fseek(file, (long)(member->header.data_offset + last.offset + 2),
+                                   SEEK_SET));
+    TEST_ASSERT_EQUAL_INT(0xff, fputc(0xff, file));
+    fclose(file);
+    
+    check_range(test_archive, member, data, 100, 3 * TEST_BLOCK);
+    TEST_ASSERT_TRUE(ERROR_SUCCESS !=
+                     archive_read_member_range(test_archive, member, TEST_BLOCKED - 10, 10,
+                                               output));
+    TEST_ASSERT_TRUE(ERROR_SUCCESS !=
+                     archive_extract_member(test_archive, member, TEST_EXTRACTED));
+    
+    free(data);
+}
+
+static void check_member_text(const char* name, const char* text) {
+    archive_member_t* member = archive_find_member(test_archive, name);
+    uint8_t* data;
+    size_t size;
+    
+    TEST_ASSERT_NOT_NULL(member);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          archive_extract_member_to_memory(test_archive, member, &data, &size));
+    TEST_ASSERT_EQUAL_UINT((uint32_t)strlen(text), (uint32_t)size);
+    TEST_ASSERT_EQUAL_MEMORY(text, data, (uint32_t)size);
+    free(data);
+}
+
+/* Reopen the archive and check its index still loads */
+static void reopen_archive(void) {
+    symbol_index_t* index;
+    
+    archive_close(test_archive);
+    test_archive = archive_open(TEST_ARCHIVE, "rb");
+    TEST_ASSERT_NOT_NULL(test_archive);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, archive_load_members(test_archive));
+    
+    index = symbol_index_create(0);
+    TEST_ASSERT_NOT_NULL(index);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, symbol_index_load_from_archive(index, test_archive));
+    symbol_index_destroy(index);
+}
+
+static uint32_t file_size(const char* filename) {
+    FILE* file = fopen(filename, "rb");
+    long size;
+    
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL_INT(0, fseek(file, 0, SEEK_END));
+    size = ftell(file);
+    fclose(file);
+    
+    return (uint32_t)size;
+}
+
+void test_archive_updates_in_place(void) {
+    const char* files[TEST_PARALLEL];
+    const char* changed[2];
+    star_options_t options = star_get_default_options();
+    star_context_t* context;
+    uint32_t kept_offset;
+    uint32_t sizes[5];
+    char text[2048];
+    size_t i;
+    
+    write_parallel_files(files);
+    options.compression = STAR_COMPRESS_LZ4;
+    context = star_context_create(&options);
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          star_create_archive(context, TEST_ARCHIVE, files, TEST_PARALLEL));
+    star_context_destroy(context);
+    reopen_archive();
+    kept_offset = archive_find_member(test_archive, files[5])->header.data_offset;
+    
+    /* Replace one member and add another; the options' lack of compression defers to the archive */
+    write_file(files[3], "replaced contents, replaced contents, replaced contents");
+    write_file(TEST_MEMBER_A, "a member added by an update");
+    changed[0] = files[3];
+    changed[1] = TEST_MEMBER_A;
+    context = star_context_create(NULL);
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, star_update_archive(context, TEST_ARCHIVE, changed, 2));
+    
+    reopen_archive();
+    TEST_ASSERT_EQUAL_UINT(TEST_PARALLEL + 1, test_archive->header.member_count);
+    check_member_text(files[3], "replaced contents, replaced contents, replaced contents");
+    check_member_text(TEST_MEMBER_A, "a member added by an update");
+    TEST_ASSERT_TRUE(archive_member_is_compressed(archive_find_member(test_archive, files[3])));
+    for (i = 0; i < TEST_PARALLEL; i++) {
+        if (i != 3) {
+            parallel_text(i, text, sizeof(text));
+            check_member_text(files[i], text);
+        }
+    }
+    
+    /* Untouched members stay where they were */
+    TEST_ASSERT_EQUAL_UINT(kept_offset,
+                           archive_find_member(test_archive, files[5])->header.data_offset);
+    
+    /* Repeated updates reuse the space the previous one gave up */
+    sizes[0] = file_size(TEST_ARCHIVE);
+    for (i = 1; i < 5; i++) {
+        TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                              star_update_archive(context, TEST_ARCHIVE, changed, 1));
+        sizes[i] = file_size(TEST_ARCHIVE);
+    }
+    TEST_ASSERT_EQUAL_UINT(sizes[2], sizes[4]);
+    TEST_ASSERT_TRUE(sizes[4] <= sizes[0] + sizes[0] / 2);
+    reopen_archive();
+    check_member_text(files[3], "replaced contents, replaced contents, replaced contents");
+    
+    /* A file that cannot be read leaves the archive as it was */
+    changed[1] = "/nonexistent/file";
+    TEST_ASSERT_EQUAL_INT(ERROR_FILE_IO, star_update_archive(context, TEST_ARCHIVE, changed, 2));
+    TEST_ASSERT_EQUAL_UINT(sizes[4], file_size(TEST_ARCHIVE));
+    
+    star_context_destroy(context);
+    remove_parallel_files();
+}
+
+void test_archive_deletes_and_compacts(void) {
+    const char* files[TEST_PARALLEL];
+    const char* doomed[2];
+    star_options_t options = star_get_default_options();
+    star_context_t* context;
+    uint8_t* before;
+    uint8_t* after;
+    size_t before_size;
+    size_t after_size;
+    char text[2048];
+    size_t i;
+    
+    write_parallel_files(files);
+    options.threads = 1;
+    context = star_context_create(&options);
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          star_create_archive(context, TEST_ARCHIVE, files, TEST_PARALLEL));
+    
+    /* Nothing is deleted unless every member exists */
+    doomed[0] = files[0];
+    doomed[1] = "no_such_member";
+    before = read_whole_file(TEST_ARCHIVE, &before_size);
+    TEST_ASSERT_EQUAL_INT(ERROR_MEMBER_NOT_FOUND,
+                          star_delete_members(context, TEST_ARCHIVE, doomed, 2));
+    after = read_whole_file(TEST_ARCHIVE, &after_size);
+    TEST_ASSERT_EQUAL_UINT((uint32_t)before_size, (uint32_t)after_size);
+    TEST_ASSERT_EQUAL_MEMORY(before, after, (uint32_t)before_size);
+    free(before);
+    free(after);
+    
+    doomed[1] = files[7];
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, star_delete_members(context, TEST_ARCHIVE, doomed, 2));
+    reopen_archive();
+    TEST_ASSERT_EQUAL_UINT(TEST_PARALLEL - 2, test_archive->header.member_count);
+    TEST_ASSERT_NULL(archive_find_member(test_archive, files[0]));
+    TEST_ASSERT_NULL(archive_find_member(test_archive, files[7]));
+    archive_close(test_archive);
+    
+    /* The deleted members' data is free space until compaction */
+    test_archive = archive_open_for_update(TEST_ARCHIVE, NULL);
+    TEST_ASSERT_NOT_NULL(test_archive);
+    TEST_ASSERT_TRUE(archive_free_space(test_archive) > 0);
+    archive_close(test_archive);
+    test_archive = NULL;
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, star_compact_archive(context, TEST_ARCHIVE));
+    TEST_ASSERT_TRUE(file_size(TEST_ARCHIVE) < before_size);
+    TEST_ASSERT_EQUAL_INT(-1, access(TEST_ARCHIVE ".compact", F_OK));
+    test_archive = archive_open_for_update(TEST_ARCHIVE, NULL);
+    TEST_ASSERT_NOT_NULL(test_archive);
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)archive_free_space(test_archive));
+    
+    reopen_archive();
+    TEST_ASSERT_EQUAL_UINT(TEST_PARALLEL - 2, test_archive->header.member_count);
+    for (i = 1; i < TEST_PARALLEL; i++) {
+        if (i != 7) {
+            parallel_text(i, text, sizeof(text));
+            check_member_text(files[i], text);
+        }
+    }
+    
+    star_context_destroy(context);
+    remove_parallel_files();
+}
+
+/* Small members that differ only in a few bytes of a shared body */
+static void shared_text(size_t i, char* text, size_t size) {
+    uint32_t seed = 2024;
+    size_t j;
+    
+    for (j = 0; j + 1 < size; j++) {
+        seed = seed * 1103515245U + 12345U;
+        text[j] = (char)('!' + (seed >> 16) % 94);
+    }
+    text[j] = '\0';
+    snprintf(text + (i * 37) % (size / 2), 24, "member %u", (unsigned)i);
+    text[strlen(text)] = '#';
+    text[size - 1] = '\0';
+}
+
+void test_archive_shares_a_dictionary(void) {
+    const char* files[TEST_PARALLEL];
+    const char* added[1];
+    star_options_t options = star_get_default_options();
+    star_context_t* context;
+    char text[1200];
+    uint32_t plain_size;
+    size_t i;
+    
+    for (i = 0; i < TEST_PARALLEL; i++) {
+        snprintf(parallel_names[i], sizeof(parallel_names[i]), "/tmp/star_test_p%u.smof",
+                 (unsigned)i);
+        shared_text(i, text, sizeof(text));
+        write_file(parallel_names[i], text);
+        files[i] = parallel_names[i];
+    }
+    
+    options.compression = STAR_COMPRESS_LZ4;
+    options.threads = 1;
+    context = star_context_create(&options);
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          star_create_archive(context, TEST_SERIAL, files, TEST_PARALLEL));
+    star_context_destroy(context);
+    plain_size = file_size(TEST_SERIAL);
+    
+    /* Each member alone has nothing to compress; against the others it has */
+    options.dictionary_size = STAR_DEFAULT_DICTIONARY_SIZE;
+    options.threads = 4;
+    context = star_context_create(&options);
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          star_create_archive(context, TEST_ARCHIVE, files, TEST_PARALLEL));
+    TEST_ASSERT_TRUE(file_size(TEST_ARCHIVE) < plain_size / 2);
+    
+    test_archive = archive_map(TEST_ARCHIVE);
+    TEST_ASSERT_NOT_NULL(test_archive);
+    TEST_ASSERT_TRUE(archive_has_dictionary(test_archive));
+    TEST_ASSERT_TRUE((test_archive->header.flags & STAR_FLAG_DICTIONARY) != 0);
+    for (i = 0; i < TEST_PARALLEL; i++) {
+        TEST_ASSERT_TRUE((archive_find_member(test_archive, files[i])->header.flags &
+                          STAR_MEMBER_FLAG_DICTIONARY) != 0);
+        shared_text(i, text, sizeof(text));
+        check_member_text(files[i], text);
+    }
+    
+    /* Members added by an update use the stored dictionary too */
+    shared_text(TEST_PARALLEL, text, sizeof(text));
+    write_file(TEST_MEMBER_A, text);
+    added[0] = TEST_MEMBER_A;
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, star_update_archive(context, TEST_ARCHIVE, added, 1));
+    reopen_archive();
+    TEST_ASSERT_TRUE((archive_find_member(test_archive, TEST_MEMBER_A)->header.flags &
+                      STAR_MEMBER_FLAG_DICTIONARY) != 0);
+    check_member_text(TEST_MEMBER_A, text);
+    
+    /* Compaction keeps it for the members that remain */
+    added[0] = files[0];
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, star_delete_members(context, TEST_ARCHIVE, added, 1));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, star_compact_archive(context, TEST_ARCHIVE));
+    reopen_archive();
+    TEST_ASSERT_TRUE(archive_has_dictionary(test_archive));
+    TEST_ASSERT_NULL(archive_find_member(test_archive, files[0]));
+    for (i = 1; i < TEST_PARALLEL; i++) {
+        shared_text(i, text, sizeof(text));
+        check_member_text(files[i], text);
+    }
+    
+    star_context_destroy(context);
+    remove_parallel_files();
+}
+
+/* Create TEST_ARCHIVE from files in auto mode and map it */
+static void create_auto_archive(const char* const* files, size_t count, int goal) {
+    star_options_t options = star_get_default_options();
+    star_context_t* context;
+    
+    archive_close(test_archive);
+    options.compression = STAR_COMPRESS_AUTO;
+    options.decode_speed_goal = goal;
+    context = star_context_create(&options);
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, star_create_archive(context, TEST_ARCHIVE, files, count));
+    star_context_destroy(context);
+    
+    test_archive = archive_map(TEST_ARCHIVE);
+    TEST_ASSERT_NOT_NULL(test_archive);
+}
+
+static void check_member_file(const char* name) {
+    archive_member_t* member = archive_find_member(test_archive, name);
+    uint8_t* expected;
+    uint8_t* data;
+    size_t expected_size;
+    size_t size;
+    
+    TEST_ASSERT_NOT_NULL(member);
+    expected = read_whole_file(name, &expected_size);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          archive_extract_member_to_memory(test_archive, member, &data, &size));
+    TEST_ASSERT_EQUAL_UINT((uint32_t)expected_size, (uint32_t)size);
+    TEST_ASSERT_EQUAL_MEMORY(expected, data, (uint32_t)size);
+    free(expected);
+    free(data);
+}
+
+void test_archive_chooses_compression_per_member(void) {
+    static const star_compression_t algorithms[] = {STAR_COMPRESS_LZ4, STAR_COMPRESS_ZLIB,
+                                                    STAR_COMPRESS_LZMA};
+    const char* files[2] = {TEST_MEMBER_A, TEST_MEMBER_B};
+    archive_member_t* member;
+    char text[8192];
+    uint8_t noise[8192];
+    uint8_t* packed;
+    size_t packed_size;
+    size_t smallest = sizeof(text);
+    uint32_t seed = 99;
+    FILE* file;
+    size_t i;
+    
+    parallel_text(0, text, sizeof(text));
+    write_file(TEST_MEMBER_A, text);
+    for (i = 0; i < sizeof(noise); i++) {
+        seed = seed * 1103515245U + 12345U;
+        noise[i] = (uint8_t)(seed >> 16);
+    }
+    file = fopen(TEST_MEMBER_B, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)fwrite(noise, sizeof(noise), 1, file));
+    fclose(file);
+    
+    for (i = 0; i < sizeof(algorithms) / sizeof(algorithms[0]); i++) {
+        TEST_ASSERT_EQUAL_INT(COMPRESS_SUCCESS,
+                              compression_compress_data(algorithms[i], -1, (const uint8_t*)text,
+                                                        strlen(text), &packed, &packed_size));
+        if (packed_size < smallest) {
+            smallest = packed_size;
+        }
+        compression_free_buffer(packed);
+    }
+    
+    /* Only size counts: the member sampled whole takes the smallest form */
+    create_auto_archive(files, 2, 0);
+    member = archive_find_member(test_archive, TEST_MEMBER_A);
+    TEST_ASSERT_NOT_NULL(member);
+    TEST_ASSERT_TRUE(archive_member_is_compressed(member));
+    TEST_ASSERT_EQUAL_UINT((uint32_t)smallest, member->header.compressed_size);
+    
+    /* Noise is not worth compressing whatever the goal */
+    member = archive_find_member(test_archive, TEST_MEMBER_B);
+    TEST_ASSERT_NOT_NULL(member);
+    TEST_ASSERT_EQUAL_UINT(STAR_COMPRESS_NONE, member->header.compression);
+    TEST_ASSERT_EQUAL_UINT(member->header.size, member->header.compressed_size);
+    check_member_file(TEST_MEMBER_A);
+    check_member_file(TEST_MEMBER_B);
+    
+    /* Which decoder is fastest depends on the machine, but none beats a copy */
+    create_auto_archive(files, 2, 100);
+    member = archive_find_member(test_archive, TEST_MEMBER_A);
+    TEST_ASSERT_NOT_NULL(member);
+    TEST_ASSERT_EQUAL_UINT(STAR_COMPRESS_NONE, member->header.compression);
+    check_member_file(TEST_MEMBER_A);
+    check_member_file(TEST_MEMBER_B);
+}
+
+/* File i holds content i % kinds, so it must share exactly the data of file i % kinds */
+static void check_sharing(const char* const* files, size_t count, size_t kinds) {
+    archive_member_t* member;
+    archive_member_t* original;
+    archive_member_t* other;
+    char text[2048];
+    size_t i;
+    
+    for (i = 0; i < count; i++) {
+        member = archive_find_member(test_archive, files[i]);
+        original = archive_find_member(test_archive, files[i % kinds]);
+        other = archive_find_member(test_archive, files[(i + 1) % kinds]);
+        TEST_ASSERT_NOT_NULL(member);
+        TEST_ASSERT_NOT_NULL(original);
+        TEST_ASSERT_NOT_NULL(other);
+        TEST_ASSERT_EQUAL_UINT(original->header.data_offset, member->header.data_offset);
+        TEST_ASSERT_TRUE(other->header.data_offset != member->header.data_offset);
+        parallel_text(i % kinds, text, sizeof(text));
+        check_member_text(files[i], text);
+    }
+}
+
+void test_archive_deduplicates_members(void) {
+    const char* files[TEST_PARALLEL];
+    const char* added[1];
+    star_options_t options = star_get_default_options();
+    star_context_t* context;
+    char text[2048];
+    uint32_t plain_size;
+    size_t i;
+    
+    /* Three distinct contents, each under eight names */
+    for (i = 0; i < TEST_PARALLEL; i++) {
+        snprintf(parallel_names[i], sizeof(parallel_names[i]), "/tmp/star_test_p%u.smof",
+                 (unsigned)i);
+        parallel_text(i % 3, text, sizeof(text));
+        write_file(parallel_names[i], text);
+        files[i] = parallel_names[i];
+    }
+    
+    options.compression = STAR_COMPRESS_LZ4;
+    options.threads = 4;
+    context = star_context_create(&options);
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          star_create_archive(context, TEST_SERIAL, files, TEST_PARALLEL));
+    star_context_destroy(context);
+    plain_size = file_size(TEST_SERIAL);
+    
+    /* Members written in parallel find the ones written before them */
+    options.deduplicate = true;
+    context = star_context_create(&options);
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          star_create_archive(context, TEST_ARCHIVE, files, TEST_PARALLEL));
+    TEST_ASSERT_TRUE(file_size(TEST_ARCHIVE) < plain_size);
+    test_archive = archive_map(TEST_ARCHIVE);
+    TEST_ASSERT_NOT_NULL(test_archive);
+    check_sharing(files, TEST_PARALLEL, 3);
+    
+    /* A member added by an update shares what is already stored */
+    parallel_text(1, text, sizeof(text));
+    write_file(TEST_MEMBER_A, text);
+    added[0] = TEST_MEMBER_A;
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, star_update_archive(context, TEST_ARCHIVE, added, 1));
+    reopen_archive();
+    TEST_ASSERT_EQUAL_UINT(archive_find_member(test_archive, files[1])->header.data_offset,
+                           archive_find_member(test_archive, TEST_MEMBER_A)->header.data_offset);
+    check_member_text(TEST_MEMBER_A, text);
+    
+    /* Deleting the first of a group keeps its data for the rest, through compaction */
+    added[0] = files[0];
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, star_delete_members(context, TEST_ARCHIVE, added, 1));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, star_compact_archive(context, TEST_ARCHIVE));
+    reopen_archive();
+    TEST_ASSERT_NULL(archive_find_member(test_archive, files[0]));
+    check_sharing(files + 3, TEST_PARALLEL - 3, 3);
+    TEST_ASSERT_EQUAL_UINT(archive_find_member(test_archive, files[1])->header.data_offset,
+                           archive_find_member(test_archive, TEST_MEMBER_A)->header.data_offset);
+    
+    star_context_destroy(context);
+    remove_parallel_files();
+}
+
+/* Write requests of varying size back to back, last first, and read them back */
+static void check_io_backend(star_io_backend_t backend) {
+    static uint8_t data[TEST_IO_REQUESTS * 64];
+    static uint8_t back[TEST_IO_REQUESTS * 64];
+    archive_io_request_t requests[TEST_IO_REQUESTS];
+    archive_io_t* io = archive_io_create(backend);
+    FILE* file = fopen(TEST_EXTRACTED, "wb+");
+    size_t offset = 0;
+    size_t i;
+    
+    TEST_ASSERT_NOT_NULL(io);
+    TEST_ASSERT_NOT_NULL(file);
+    if (backend != STAR_IO_DEFAULT) {
+        TEST_ASSERT_EQUAL_INT(backend, archive_io_get_backend(io));
+    }
+    
+    for (i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(i * 7 + i / 251);
+    }
+    for (i = 0; i < TEST_IO_REQUESTS; i++) {
+        /* Every tenth request is empty */
+        size_t size = i % 10 == 9 ? 0 : i % 64 + 1;
+        archive_io_request_t request = {fileno(file), data + offset, size, offset};
+        
+        requests[TEST_IO_REQUESTS - 1 - i] = request;
+        offset += size;
+    }
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, archive_io_write(io, requests, TEST_IO_REQUESTS));
+    
+    for (i = 0; i < TEST_IO_REQUESTS; i++) {
+        requests[i].buffer = back + requests[i].offset;
+    }
+    memset(back, 0, sizeof(back));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, archive_io_read(io, requests, TEST_IO_REQUESTS));
+    TEST_ASSERT_EQUAL_MEMORY(data, back, (uint32_t)offset);
+    
+    /* A read that runs past the end fails the batch */
+    requests[0].size = 64;
+    requests[0].offset = offset - 8;
+    TEST_ASSERT_EQUAL_INT(ERROR_FILE_IO, archive_io_read(io, requests, 2));
+    TEST_ASSERT_EQUAL_INT(ERROR_FILE_IO, archive_io_read(io, requests, 1));
+    
+    fclose(file);
+    archive_io_destroy(io);
+}
+
+void test_archive_batches_io(void) {
+    const star_io_backend_t backends[] = {STAR_IO_DEFAULT, STAR_IO_PREAD, STAR_IO_VECTORED,
+                                          STAR_IO_URING};
+    const char* files[TEST_PARALLEL];
+    star_options_t options = star_get_default_options();
+    star_context_t* context;
+    uint8_t* data;
+    char text[2048];
+    size_t size;
+    size_t i;
+    size_t j;
+    
+    TEST_ASSERT_EQUAL_STRING("io_uring", archive_io_backend_to_string(
+                                             archive_io_backend_from_string("io_uring")));
+    TEST_ASSERT_EQUAL_INT(STAR_IO_DEFAULT, archive_io_backend_from_string("tape"));
+    TEST_ASSERT_TRUE(archive_io_backend_is_available(STAR_IO_VECTORED));
+    
+    write_parallel_files(files);
+    options.compression = STAR_COMPRESS_LZ4;
+    options.threads = 4;
+    context = star_context_create(&options);
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          star_create_archive(context, TEST_ARCHIVE, files, TEST_PARALLEL));
+    star_context_destroy(context);
+    
+    for (i = 0; i < sizeof(backends) / sizeof(backends[0]); i++) {
+        if (!archive_io_backend_is_available(backends[i])) {
+            continue;
+        }
+        check_io_backend(backends[i]);
+        
+        /* Extraction in batches small enough to take several */
+        remove_parallel_files();
+        options.io_backend = backends[i];
+        options.max_memory = 4096;
+        context = star_context_create(&options);
+        TEST_ASSERT_NOT_NULL(context);
+        TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                              star_extract_archive(context, TEST_ARCHIVE, NULL, NULL, 0));
+        star_context_destroy(context);
+        for (j = 0; j < TEST_PARALLEL; j++) {
+            parallel_text(j, text, sizeof(text));
+            data = read_whole_file(files[j], &size);
+            TEST_ASSERT_EQUAL_UINT((uint32_t)strlen(text), (uint32_t)size);
+            TEST_ASSERT_EQUAL_MEMORY(text, data, (uint32_t)size);
+            free(data);
+        }
+    }
+    
+    remove_parallel_files();
+}
+
+/* The loaded table is in name order and every member is found by binary search */
+static void check_sorted(archive_file_t* archive, uint32_t count) {
+    uint32_t i;
+    
+    TEST_ASSERT_TRUE(archive_is_sorted(archive));
+    TEST_ASSERT_TRUE(archive->members_sorted);
+    TEST_ASSERT_NULL(archive->member_slots);
+    TEST_ASSERT_EQUAL_UINT(count, archive->header.member_count);
+    for (i = 0; i < count; i++) {
+        if (i > 0) {
+            TEST_ASSERT_TRUE(strcmp(archive->members[i - 1].name, archive->members[i].name) < 0);
+        }
+        TEST_ASSERT_EQUAL_PTR(&archive->members[i],
+                              archive_find_member(archive, archive->members[i].name));
+    }
+    TEST_ASSERT_NULL(archive_find_member(archive, ""));
+    TEST_ASSERT_NULL(archive_find_member(archive, "~"));
+    TEST_ASSERT_NULL(archive_find_member(archive, "/tmp/star_test_p1.smo"));
+}
+
+void test_archive_sorts_members(void) {
+    const char* files[TEST_PARALLEL];
+    const char* reversed[TEST_PARALLEL];
+    star_options_t options = star_get_default_options();
+    star_context_t* context;
+    archive_member_t* member;
+    uint8_t* data;
+    char text[2048];
+    size_t size;
+    size_t i;
+    
+    write_parallel_files(files);
+    for (i = 0; i < TEST_PARALLEL; i++) {
+        reversed[i] = files[TEST_PARALLEL - 1 - i];
+    }
+    options.sort_members = true;
+    options.compression = STAR_COMPRESS_LZ4;
+    options.threads = 4;
+    context = star_context_create(&options);
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          star_create_archive(context, TEST_ARCHIVE, reversed, TEST_PARALLEL));
+    
+    /* Opened without a mapping, and mapped */
+    reopen_archive();
+    check_sorted(test_archive, TEST_PARALLEL);
+    member = archive_find_member(test_archive, files[5]);
+    TEST_ASSERT_NOT_NULL(member);
+    parallel_text(5, text, sizeof(text));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          archive_extract_member_to_memory(test_archive, member, &data, &size));
+    TEST_ASSERT_EQUAL_UINT((uint32_t)strlen(text), (uint32_t)size);
+    TEST_ASSERT_EQUAL_MEMORY(text, data, (uint32_t)size);
+    free(data);
+    archive_close(test_archive);
+    test_archive = archive_map(TEST_ARCHIVE);
+    TEST_ASSERT_NOT_NULL(test_archive);
+    check_sorted(test_archive, TEST_PARALLEL);
+    archive_close(test_archive);
+    test_archive = NULL;
+    
+    /* Members added and deleted while updating keep the order */
+    write_file(TEST_MEMBER_A, "added while updating");
+    test_archive = archive_open_for_update(TEST_ARCHIVE, NULL);
+    TEST_ASSERT_NOT_NULL(test_archive);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          archive_update_member_from_file(test_archive, "/tmp/star_test_p100.smof",
+                                                          TEST_MEMBER_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, archive_delete_member(test_archive, files[3]));
+    check_sorted(test_archive, TEST_PARALLEL);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, archive_commit_update(test_archive));
+    reopen_archive();
+    check_sorted(test_archive, TEST_PARALLEL);
+    TEST_ASSERT_NULL(archive_find_member(test_archive, files[3]));
+    member = archive_find_member(test_archive, "/tmp/star_test_p100.smof");
+    TEST_ASSERT_NOT_NULL(member);
+    TEST_ASSERT_EQUAL_UINT(strlen("added while updating"), member->header.size);
+    
+    /* Members added whole are sorted on finalizing too */
+    archive_close(test_archive);
+    test_archive = archive_create(TEST_ARCHIVE, &options);
+    TEST_ASSERT_NOT_NULL(test_archive);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          archive_add_member_from_file(test_archive, "b.smof", TEST_MEMBER_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          archive_add_member_from_file(test_archive, "a.smof", TEST_MEMBER_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, archive_finalize(test_archive));
+    reopen_archive();
+    check_sorted(test_archive, 2);
+    TEST_ASSERT_EQUAL_STRING("a.smof", test_archive->members[0].name);
+    
+    star_context_destroy(context);
+    remove_parallel_files();
+}
+
+int test_archive_main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_archive_interns_strings);
+    RUN_TEST(test_archive_interns_loaded_strings);
+    RUN_TEST(test_archive_streams_members);
+    RUN_TEST(test_archive_maps_members);
+    RUN_TEST(test_archive_extracts_members);
+    RUN_TEST(test_archive_compresses_members);
+    RUN_TEST(test_archive_compresses_in_parallel);
+    RUN_TEST(test_archive_extracts_in_parallel);
+    RUN_TEST(test_archive_reads_block_ranges);
+    RUN_TEST(test_archive_updates_in_place);
+    RUN_TEST(test_archive_deletes_and_compacts);
+    RUN_TEST(test_archive_shares_a_dictionary);
+    RUN_TEST(test_archive_chooses_compression_per_member);
+    RUN_TEST(test_archive_deduplicates_members);
+    RUN_TEST(test_archive_batches_io);
+    RUN_TEST(test_archive_sorts_members);
+    
+    return UNITY_END();
+}
+
+int main(void) {
+    return test_archive_main();
+}
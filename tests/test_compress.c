@@ -0,0 +1,487 @@
+/* tests/test_compress.c */
+#include "unity.h"
+#include "compress.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file test_compress.c
+ * @brief Unit tests for the STAR compression engine
+ * @details Tests round trips through every available backend at several
+ * levels, LZ4 block format edge cases, rejection of corrupt input,
+ * reuse of cached contexts and buffers, and trained dictionaries
+ */
+
+/* Function prototypes */
+void test_compress_round_trips(void);
+void test_compress_lz4_edge_cases(void);
+void test_compress_rejects_corrupt_data(void);
+void test_compress_levels_and_names(void);
+void test_compress_reuses_contexts_and_buffers(void);
+void test_compress_uses_dictionaries(void);
+void test_compress_benchmarks_and_estimates(void);
+int test_compress_main(void);
+
+#define TEST_DATA_SIZE (200 * 1024)
+#define TEST_SAMPLES 64
+#define TEST_SAMPLE_SIZE 1500
+#define TEST_DICTIONARY_SIZE 16384
+
+static uint8_t* test_data;
+static uint32_t test_seed;
+
+void setUp(void) {
+    test_data = NULL;
+    test_seed = 12345;
+}
+
+void tearDown(void) {
+    free(test_data);
+    test_data = NULL;
+}
+
+static uint8_t next_random(void) {
+    test_seed = test_seed * 1103515245U + 12345U;
+    return (uint8_t)(test_seed >> 16);
+}
+
+/* Object-file-like contents: repeated names and headers with some noise */
+static uint8_t* make_compressible(size_t size) {
+    static const char* const words[] = {".text", ".data", ".bss", "main", "_start",
+                                        "printf", "memcpy", "symbol_table"};
+    uint8_t* data = calloc(size, 1);
+    size_t used = 0;
+    size_t length;
+    
+    TEST_ASSERT_NOT_NULL(data);
+    while (used < size) {
+        const char* word = words[next_random() % 8];
+        
+        length = strlen(word) + 1;
+        if (length > size - used) {
+            length = size - used;
+        }
+        memcpy(data + used, word, length);
+        used += length;
+        if (used < size && next_random() % 4 == 0) {
+            data[used++] = next_random();
+        }
+    }
+    
+    return data;
+}
+
+static void check_round_trip(star_compression_t algorithm, int level,
+                             const uint8_t* input, size_t size) {
+    uint8_t* compressed = NULL;
+    uint8_t* output = NULL;
+    size_t compressed_size = 0;
+    size_t output_size = size;
+    
+    TEST_ASSERT_EQUAL_INT(COMPRESS_SUCCESS,
+                          compression_compress_data(algorithm, level, input, size,
+                                                    &compressed, &compressed_size));
+    TEST_ASSERT_TRUE(compressed_size <=
+                     compression_get_algorithm(algorithm)->get_max_compressed_size(size));
+    TEST_ASSERT_EQUAL_INT(COMPRESS_SUCCESS,
+                          compression_decompress_data(algorithm, compressed, compressed_size,
+                                                      &output, &output_size));
+    TEST_ASSERT_EQUAL_UINT((uint32_t)size, (uint32_t)output_size);
+    if (size > 0) {
+        TEST_ASSERT_EQUAL_MEMORY(input, output, (uint32_t)size);
+    }
+    
+    compression_free_buffer(compressed);
+    compression_free_buffer(output);
+}
+
+void test_compress_round_trips(void) {
+    const compression_algorithm_t* list[8];
+    size_t count = 8;
+    uint8_t* compressed;
+    size_t compressed_size;
+    size_t fast_size = 0;
+    size_t i;
+    
+    test_data = make_compressible(TEST_DATA_SIZE);
+    compression_list_algorithms(list, &count);
+    TEST_ASSERT_TRUE(count >= 2);
+    TEST_ASSERT_EQUAL_PTR(&compression_none_algorithm, list[0]);
+    
+    for (i = 0; i < count; i++) {
+        check_round_trip(list[i]->type, 0, test_data, TEST_DATA_SIZE);
+        check_round_trip(list[i]->type, compression_get_default_level(list[i]->type),
+                         test_data, TEST_DATA_SIZE);
+        check_round_trip(list[i]->type, 9, test_data, TEST_DATA_SIZE);
+        check_round_trip(list[i]->type, 6, test_data, 1000);
+    }
+    
+    /* Real backends shrink compressible data, more so at higher levels */
+    TEST_ASSERT_TRUE(compression_is_available(STAR_COMPRESS_LZ4));
+    for (i = 1; i < count; i++) {
+        TEST_ASSERT_EQUAL_INT(COMPRESS_SUCCESS,
+                              compression_compress_data(list[i]->type, 1, test_data, TEST_DATA_SIZE,
+                                                        &compressed, &compressed_size));
+        TEST_ASSERT_TRUE(compressed_size < TEST_DATA_SIZE / 2);
+        compression_free_buffer(compressed);
+    }
+    
+    TEST_ASSERT_EQUAL_INT(COMPRESS_SUCCESS,
+                          compression_compress_data(STAR_COMPRESS_LZ4, 1, test_data, TEST_DATA_SIZE,
+                                                    &compressed, &fast_size));
+    compression_free_buffer(compressed);
+    TEST_ASSERT_EQUAL_INT(COMPRESS_SUCCESS,
+                          compression_compress_data(STAR_COMPRESS_LZ4, 9, test_data, TEST_DATA_SIZE,
+                                                    &compressed, &compressed_size));
+    compression_free_buffer(compressed);
+    TEST_ASSERT_TRUE(compressed_size < fast_size);
+}
+
+void test_compress_lz4_edge_cases(void) {
+    const compression_algorithm_t* lz4 = compression_get_algorithm(STAR_COMPRESS_LZ4);
+    compression_context_t* ctx;
+    uint8_t small[16];
+    size_t size;
+    size_t i;
+    
+    TEST_ASSERT_NOT_NULL(lz4);
+    test_data = calloc(TEST_DATA_SIZE, 1);
+    TEST_ASSERT_NOT_NULL(test_data);
+    
+    /* Empty, shorter than a match can be, and just long enough for one */
+    check_round_trip(STAR_COMPRESS_LZ4, 1, test_data, 0);
+    memcpy(test_data, "abcdabcdabcdabcd", 16);
+    check_round_trip(STAR_COMPRESS_LZ4, 1, test_data, 11);
+    check_round_trip(STAR_COMPRESS_LZ4, 1, test_data, 16);
+    
+    /* One long overlapping match, then literal runs past 255 bytes */
+    memset(test_data, 'x', TEST_DATA_SIZE);
+    check_round_trip(STAR_COMPRESS_LZ4, 1, test_data, TEST_DATA_SIZE);
+    for (i = 0; i < TEST_DATA_SIZE; i++) {
+        test_data[i] = next_random();
+    }
+    check_round_trip(STAR_COMPRESS_LZ4, 1, test_data, TEST_DATA_SIZE);
+    check_round_trip(STAR_COMPRESS_LZ4, 9, test_data, 300);
+    
+    /* Matches further back than the 64KB window are not used */
+    memcpy(test_data + 70000, test_data, 5000);
+    check_round_trip(STAR_COMPRESS_LZ4, 9, test_data, 75000);
+    
+    /* Random data does not fit a buffer its own size */
+    ctx = lz4->create_context(1);
+    TEST_ASSERT_NOT_NULL(ctx);
+    TEST_ASSERT_EQUAL_INT(COMPRESS_ERROR_OVERFLOW,
+                          lz4->compress(ctx, test_data, sizeof(small), small, sizeof(small) - 1,
+                                        &size));
+    lz4->destroy_context(ctx);
+}
+
+void test_compress_rejects_corrupt_data(void) {
+    const compression_algorithm_t* list[8];
+    size_t count = 8;
+    uint8_t* compressed;
+    uint8_t* output;
+    size_t compressed_size;
+    size_t i;
+    
+    test_data = make_compressible(TEST_DATA_SIZE);
+    output = malloc(TEST_DATA_SIZE + 1);
+    TEST_ASSERT_NOT_NULL(output);
+    compression_list_algorithms(list, &count);
+    
+    for (i = 1; i < count; i++) {
+        TEST_ASSERT_EQUAL_INT(COMPRESS_SUCCESS,
+                              compression_compress_data(list[i]->type, 6, test_data, TEST_DATA_SIZE,
+                                                        &compressed, &compressed_size));
+        TEST_ASSERT_TRUE(compression_validate_data(list[i]->type, compressed, compressed_size));
+        
+        /* Truncated input and a wrong expected size both fail */
+        TEST_ASSERT_EQUAL_INT(COMPRESS_ERROR_CORRUPT,
+                              compression_decompress_into(list[i]->type, compressed,
+                                                          compressed_size / 2, output,
+                                                          TEST_DATA_SIZE));
+        TEST_ASSERT_EQUAL_INT(COMPRESS_ERROR_CORRUPT,
+                              compression_decompress_into(list[i]->type, compressed,
+                                                          compressed_size, output,
+                                                          TEST_DATA_SIZE + 1));
+        TEST_ASSERT_EQUAL_INT(COMPRESS_ERROR_CORRUPT,
+                              compression_decompress_into(list[i]->type, compressed,
+                                                          compressed_size, output,
+                                                          TEST_DATA_SIZE - 1));
+        if (list[i]->type != STAR_COMPRESS_LZ4) {
+            TEST_ASSERT_EQUAL_INT(list[i]->type,
+                                  compression_detect_algorithm(compressed, compressed_size));
+        }
+        compression_free_buffer(compressed);
+    }
+    
+    /* An LZ4 match reaching before the start of the output */
+    memcpy(output, "\x14" "a" "\x05\x00", 4);
+    TEST_ASSERT_EQUAL_INT(COMPRESS_ERROR_CORRUPT,
+                          compression_decompress_into(STAR_COMPRESS_LZ4, output, 4,
+                                                      output + 8, 9));
+    TEST_ASSERT_EQUAL_INT(STAR_COMPRESS_NONE, compression_detect_algorithm(test_data, 64));
+    TEST_ASSERT_EQUAL_INT(COMPRESS_ERROR_INVALID,
+                          compression_decompress_into((star_compression_t)7, test_data, 1,
+                                                      output, 1));
+    
+    free(output);
+}
+
+void test_compress_levels_and_names(void) {
+    TEST_ASSERT_EQUAL_INT(1, compression_get_default_level(STAR_COMPRESS_LZ4));
+    TEST_ASSERT_EQUAL_INT(9, compression_get_max_level(STAR_COMPRESS_ZLIB));
+    TEST_ASSERT_EQUAL_INT(0, compression_get_max_level(STAR_COMPRESS_NONE));
+    TEST_ASSERT_EQUAL_INT(9, compression_normalize_level(STAR_COMPRESS_LZMA, 42));
+    TEST_ASSERT_EQUAL_INT(6, compression_normalize_level(STAR_COMPRESS_ZLIB, -1));
+    TEST_ASSERT_EQUAL_INT(0, compression_normalize_level(STAR_COMPRESS_NONE, 5));
+    
+    TEST_ASSERT_EQUAL_STRING("lz4", compression_algorithm_to_string(STAR_COMPRESS_LZ4));
+    TEST_ASSERT_EQUAL_INT(STAR_COMPRESS_LZMA, compression_algorithm_from_string("lzma"));
+    TEST_ASSERT_EQUAL_INT(STAR_COMPRESS_NONE, compression_algorithm_from_string("zstd"));
+    TEST_ASSERT_EQUAL_PTR(compression_get_algorithm(STAR_COMPRESS_LZ4),
+                          compression_find_algorithm("lz4"));
+    TEST_ASSERT_NULL(compression_find_algorithm("zstd"));
+    TEST_ASSERT_EQUAL_STRING("Corrupt compressed data",
+                             compression_get_error_string(COMPRESS_ERROR_CORRUPT));
+}
+
+void test_compress_reuses_contexts_and_buffers(void) {
+    const compression_algorithm_t* list[8];
+    const compression_algorithm_t* algo;
+    compression_context_t* ctx;
+    compression_context_t* reused;
+    compression_stats_t stats;
+    uint8_t* compressed;
+    uint8_t* buffer;
+    size_t count = 8;
+    size_t size;
+    size_t i;
+    int level;
+    
+    test_data = make_compressible(TEST_DATA_SIZE);
+    compression_list_algorithms(list, &count);
+    compression_release_cache();
+    
+    /* One context through many calls, levels and failures gives the same results */
+    for (i = 1; i < count; i++) {
+        algo = list[i];
+        ctx = compression_acquire_context(algo->type, 1);
+        TEST_ASSERT_NOT_NULL(ctx);
+        compressed = compression_allocate_buffer(algo->get_max_compressed_size(TEST_DATA_SIZE));
+        buffer = compression_allocate_buffer(TEST_DATA_SIZE);
+        TEST_ASSERT_NOT_NULL(compressed);
+        TEST_ASSERT_NOT_NULL(buffer);
+        
+        for (level = 1; level <= 9; level += 4) {
+            compression_release_context(algo->type, ctx);
+            reused = compression_acquire_context(algo->type, level);
+            TEST_ASSERT_EQUAL_PTR(ctx, reused);
+            
+            TEST_ASSERT_EQUAL_INT(COMPRESS_SUCCESS,
+                                  algo->compress(ctx, test_data, TEST_DATA_SIZE - (size_t)level,
+                                                 compressed,
+                                                 algo->get_max_compressed_size(TEST_DATA_SIZE),
+                                                 &size));
+            TEST_ASSERT_EQUAL_INT(COMPRESS_ERROR_CORRUPT,
+                                  compression_decompress_into(algo->type, compressed, size / 2,
+                                                              buffer, TEST_DATA_SIZE - (size_t)level));
+            TEST_ASSERT_EQUAL_INT(COMPRESS_SUCCESS,
+                                  compression_decompress_into(algo->type, compressed, size,
+                                                              buffer, TEST_DATA_SIZE - (size_t)level));
+            TEST_ASSERT_EQUAL_MEMORY(test_data, buffer, (uint32_t)(TEST_DATA_SIZE - (size_t)level));
+            
+            /* Statistics start over with each acquisition */
+            algo->get_stats(ctx, &stats);
+            TEST_ASSERT_EQUAL_UINT((uint32_t)(TEST_DATA_SIZE - (size_t)level),
+                                   (uint32_t)stats.input_size);
+        }
+        
+        compression_release_context(algo->type, ctx);
+        compression_free_buffer(compressed);
+        compression_free_buffer(buffer);
+    }
+    
+    /* A freed buffer serves the next request in its size class */
+    buffer = compression_allocate_buffer(5000);
+    TEST_ASSERT_NOT_NULL(buffer);
+    compression_free_buffer(buffer);
+    TEST_ASSERT_EQUAL_PTR(buffer, compression_allocate_buffer(8192));
+    compression_free_buffer(buffer);
+    
+    /* Buffers past the largest class are plain allocations */
+    buffer = compression_allocate_buffer((size_t)40 << 20);
+    TEST_ASSERT_NOT_NULL(buffer);
+    buffer[((size_t)40 << 20) - 1] = 1;
+    compression_free_buffer(buffer);
+    compression_free_buffer(NULL);
+    compression_release_cache();
+}
+
+/* Small objects on one template of random bytes, each with a few bytes of its own */
+static void make_samples(uint8_t** samples) {
+    uint8_t template_data[TEST_SAMPLE_SIZE];
+    size_t position;
+    size_t i;
+    size_t j;
+    
+    for (i = 0; i < TEST_SAMPLE_SIZE; i++) {
+        template_data[i] = next_random();
+    }
+    for (i = 0; i < TEST_SAMPLES; i++) {
+        samples[i] = calloc(TEST_SAMPLE_SIZE, 1);
+        TEST_ASSERT_NOT_NULL(samples[i]);
+        memcpy(samples[i], template_data, TEST_SAMPLE_SIZE);
+        for (j = 0; j < 40; j++) {
+            position = ((size_t)next_random() << 8 | next_random()) % TEST_SAMPLE_SIZE;
+            samples[i][position] = next_random();
+        }
+    }
+}
+
+void test_compress_uses_dictionaries(void) {
+    static const star_compression_t algorithms[] = {STAR_COMPRESS_LZ4, STAR_COMPRESS_ZLIB};
+    const uint8_t* samples[TEST_SAMPLES];
+    uint8_t* owned[TEST_SAMPLES];
+    size_t sizes[TEST_SAMPLES];
+    uint8_t dictionary[TEST_DICTIONARY_SIZE];
+    uint8_t other[TEST_DICTIONARY_SIZE];
+    uint8_t output[TEST_SAMPLE_SIZE];
+    uint8_t* compressed;
+    size_t dictionary_size = 0;
+    size_t size;
+    size_t plain;
+    size_t shared;
+    size_t i;
+    size_t a;
+    
+    make_samples(owned);
+    for (i = 0; i < TEST_SAMPLES; i++) {
+        samples[i] = owned[i];
+        sizes[i] = TEST_SAMPLE_SIZE;
+    }
+    
+    /* Trained on half the samples; one sample alone shares nothing */
+    TEST_ASSERT_EQUAL_INT(COMPRESS_SUCCESS,
+                          compression_train_dictionary(samples, sizes, 1, dictionary,
+                                                       sizeof(dictionary), &dictionary_size));
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)dictionary_size);
+    TEST_ASSERT_EQUAL_INT(COMPRESS_SUCCESS,
+                          compression_train_dictionary(samples, sizes, TEST_SAMPLES / 2,
+                                                       dictionary, sizeof(dictionary),
+                                                       &dictionary_size));
+    TEST_ASSERT_TRUE(dictionary_size >= TEST_SAMPLE_SIZE / 2);
+    TEST_ASSERT_TRUE(dictionary_size <= sizeof(dictionary));
+    for (i = 0; i < dictionary_size; i++) {
+        other[i] = (uint8_t)(dictionary[i] + 1);
+    }
+    
+    for (a = 0; a < sizeof(algorithms) / sizeof(algorithms[0]); a++) {
+        if (!compression_is_available(algorithms[a])) {
+            continue;
+        }
+        TEST_ASSERT_TRUE(compression_supports_dictionary(algorithms[a]));
+        
+        /* The other half compresses far better against it, and only decodes with it */
+        plain = 0;
+        shared = 0;
+        for (i = TEST_SAMPLES / 2; i < TEST_SAMPLES; i++) {
+            TEST_ASSERT_EQUAL_INT(COMPRESS_SUCCESS,
+                                  compression_compress_data(algorithms[a], -1, samples[i],
+                                                            TEST_SAMPLE_SIZE, &compressed, &size));
+            plain += size;
+            compression_free_buffer(compressed);
+            
+            TEST_ASSERT_EQUAL_INT(COMPRESS_SUCCESS,
+                                  compression_compress_with_dictionary(
+                                      algorithms[a], -1, dictionary, dictionary_size, samples[i],
+                                      TEST_SAMPLE_SIZE, &compressed, &size));
+            shared += size;
+            TEST_ASSERT_EQUAL_INT(COMPRESS_SUCCESS,
+                                  compression_decompress_with_dictionary(
+                                      algorithms[a], dictionary, dictionary_size, compressed, size,
+                                      output, TEST_SAMPLE_SIZE));
+            TEST_ASSERT_EQUAL_MEMORY(samples[i], output, TEST_SAMPLE_SIZE);
+            TEST_ASSERT_EQUAL_INT(COMPRESS_ERROR_CORRUPT,
+                                  compression_decompress_into(algorithms[a], compressed, size,
+                                                              output, TEST_SAMPLE_SIZE));
+            compression_free_buffer(compressed);
+        }
+        TEST_ASSERT_TRUE(shared * 4 < plain);
+        
+        /* A different dictionary on a cached context is not mistaken for the last one */
+        TEST_ASSERT_EQUAL_INT(COMPRESS_SUCCESS,
+                              compression_compress_with_dictionary(
+                                  algorithms[a], 9, other, dictionary_size, samples[0],
+                                  TEST_SAMPLE_SIZE, &compressed, &size));
+        TEST_ASSERT_EQUAL_INT(COMPRESS_SUCCESS,
+                              compression_decompress_with_dictionary(
+                                  algorithms[a], other, dictionary_size, compressed, size,
+                                  output, TEST_SAMPLE_SIZE));
+        TEST_ASSERT_EQUAL_MEMORY(samples[0], output, TEST_SAMPLE_SIZE);
+        compression_free_buffer(compressed);
+    }
+    
+    /* An .xz stream has no room for a preset dictionary */
+    if (compression_is_available(STAR_COMPRESS_LZMA)) {
+        TEST_ASSERT_FALSE(compression_supports_dictionary(STAR_COMPRESS_LZMA));
+        TEST_ASSERT_EQUAL_INT(COMPRESS_ERROR_INVALID,
+                              compression_compress_with_dictionary(
+                                  STAR_COMPRESS_LZMA, -1, dictionary, dictionary_size, samples[0],
+                                  TEST_SAMPLE_SIZE, &compressed, &size));
+    }
+    
+    for (i = 0; i < TEST_SAMPLES; i++) {
+        free(owned[i]);
+    }
+}
+
+void test_compress_benchmarks_and_estimates(void) {
+    const compression_algorithm_t* list[8];
+    compression_benchmark_t benchmark;
+    size_t count = 8;
+    size_t i;
+    
+    test_data = make_compressible(TEST_SAMPLE_SIZE * 8);
+    compression_list_algorithms(list, &count);
+    
+    /* list[0] stores data as it is */
+    for (i = 1; i < count; i++) {
+        TEST_ASSERT_EQUAL_INT(COMPRESS_SUCCESS,
+                              compression_benchmark_algorithm(list[i]->type, -1, test_data,
+                                                              TEST_SAMPLE_SIZE * 8, &benchmark));
+        TEST_ASSERT_EQUAL_INT(list[i]->type, benchmark.algorithm);
+        TEST_ASSERT_EQUAL_INT(compression_get_default_level(list[i]->type), benchmark.level);
+        TEST_ASSERT_EQUAL_UINT(TEST_SAMPLE_SIZE * 8, (uint32_t)benchmark.input_size);
+        TEST_ASSERT_TRUE(benchmark.compression_speed > 0.0);
+        TEST_ASSERT_TRUE(benchmark.decompression_speed > 0.0);
+        TEST_ASSERT_TRUE(benchmark.compression_ratio > 0.0 && benchmark.compression_ratio < 1.0);
+        
+        /* Tiny inputs do not pay for the format, large ones do */
+        TEST_ASSERT_TRUE(compression_estimate_compressed_size(list[i]->type, 100000, -1) < 100000);
+    }
+    TEST_ASSERT_TRUE(compression_estimate_compressed_size(STAR_COMPRESS_LZMA, 40, -1) >= 40);
+    TEST_ASSERT_EQUAL_UINT(40, (uint32_t)compression_estimate_compressed_size(STAR_COMPRESS_NONE,
+                                                                              40, -1));
+    TEST_ASSERT_EQUAL_INT(COMPRESS_ERROR_INVALID,
+                          compression_benchmark_algorithm(STAR_COMPRESS_LZ4, -1, test_data, 0,
+                                                          &benchmark));
+}
+
+int test_compress_main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_compress_round_trips);
+    RUN_TEST(test_compress_lz4_edge_cases);
+    RUN_TEST(test_compress_rejects_corrupt_data);
+    RUN_TEST(test_compress_levels_and_names);
+    RUN_TEST(test_compress_reuses_contexts_and_buffers);
+    RUN_TEST(test_compress_uses_dictionaries);
+    RUN_TEST(test_compress_benchmarks_and_estimates);
+    
+    return UNITY_END();
+}
+
+int main(void) {
+    return test_compress_main();
+}
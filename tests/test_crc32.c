@@ -0,0 +1,100 @@
+/* tests/test_crc32.c */
+#include "unity.h"
+#include "crc32.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file test_crc32.c
+ * @brief Unit tests for the shared CRC-32
+ * @details Tests the standard check value, incremental updates and that
+ * the sliced and hardware paths agree with a bit-at-a-time CRC for every
+ * length and alignment around their block sizes
+ */
+
+/* Function prototypes */
+void test_crc32_check_value(void);
+void test_crc32_incremental_update(void);
+void test_crc32_matches_bitwise(void);
+int test_crc32_main(void);
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_crc32_check_value(void) {
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926, crc32_calculate("123456789", 9));
+    TEST_ASSERT_EQUAL_HEX32(0, crc32_calculate("", 0));
+}
+
+void test_crc32_incremental_update(void) {
+    const char* text = "The quick brown fox jumps over the lazy dog";
+    size_t length = strlen(text);
+    uint32_t crc;
+    
+    crc = crc32_update(CRC32_INITIAL, text, 10);
+    crc = crc32_update(crc, text + 10, length - 10);
+    TEST_ASSERT_EQUAL_HEX32(0x414FA339, crc);
+    TEST_ASSERT_EQUAL_HEX32(crc32_calculate(text, length), crc);
+}
+
+static uint32_t bitwise_crc32(const uint8_t* data, size_t size) {
+    uint32_t crc = 0xffffffffU;
+    size_t i;
+    int k;
+    
+    for (i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (k = 0; k < 8; k++) {
+            crc = (crc & 1) ? 0xedb88320U ^ (crc >> 1) : crc >> 1;
+        }
+    }
+    
+    return ~crc;
+}
+
+void test_crc32_matches_bitwise(void) {
+    const size_t size = 1 << 16;
+    uint8_t* data = calloc(size, 1);
+    uint32_t seed = 7;
+    size_t offset;
+    size_t length;
+    size_t i;
+    
+    TEST_ASSERT_NOT_NULL(data);
+    for (i = 0; i < size; i++) {
+        seed = seed * 1103515245U + 12345U;
+        data[i] = (uint8_t)(seed >> 16);
+    }
+    
+    for (offset = 0; offset < 16; offset++) {
+        for (length = 0; length <= 300; length++) {
+            TEST_ASSERT_EQUAL_HEX32(bitwise_crc32(data + offset, length),
+                                    crc32_calculate(data + offset, length));
+        }
+    }
+    TEST_ASSERT_EQUAL_HEX32(bitwise_crc32(data + 3, size - 3), crc32_calculate(data + 3, size - 3));
+    
+    /* Splitting at odd points gives the same result */
+    TEST_ASSERT_EQUAL_HEX32(bitwise_crc32(data, size),
+                            crc32_update(crc32_update(CRC32_INITIAL, data, 1001), data + 1001,
+                                         size - 1001));
+    
+    free(data);
+}
+
+int test_crc32_main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_crc32_check_value);
+    RUN_TEST(test_crc32_incremental_update);
+    RUN_TEST(test_crc32_matches_bitwise);
+    
+    return UNITY_END();
+}
+
+int main(void) {
+    return test_crc32_main();
+}
@@ -0,0 +1,520 @@
+/* tests/test_index.c */
+#include "unity.h"
+#include "index.h"
+#include "smof.h"
+#include "error.h"
+#include "thread_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file test_index.c
+ * @brief Unit tests for the STAR symbol index
+ * @details Tests lookup, weak/strong precedence, growth and rehashing,
+ * parallel builds, pattern and member search, and the serialized form, both loaded
+ * and searched in place
+ */
+
+/* Function prototypes */
+void test_index_find_symbol(void);
+void test_index_strong_replaces_weak(void);
+void test_index_serialize_round_trip(void);
+void test_index_rejects_corrupt_data(void);
+void test_index_searches_serialized_data_in_place(void);
+void test_index_grows_past_old_limit(void);
+void test_index_parallel_build_matches_serial(void);
+void test_index_finds_symbols_by_pattern(void);
+void test_index_finds_symbols_by_member(void);
+int test_index_main(void);
+
+static symbol_index_t* test_index;
+
+void setUp(void) {
+    test_index = symbol_index_create(0);
+}
+
+void tearDown(void) {
+    symbol_index_destroy(test_index);
+    test_index = NULL;
+}
+
+void test_index_find_symbol(void) {
+    symbol_index_entry_t* entry;
+    
+    TEST_ASSERT_NOT_NULL(test_index);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          symbol_index_add_symbol(test_index, "uart_init", 3, "uart.smof",
+                                                  0x100, 32, SMOF_SYM_FUNC, SMOF_BIND_GLOBAL));
+    
+    entry = symbol_index_find_symbol_hash(test_index, "uart_init",
+                                          symbol_index_hash_name("uart_init"));
+    TEST_ASSERT_NOT_NULL(entry);
+    TEST_ASSERT_EQUAL_UINT(3, entry->member_index);
+    TEST_ASSERT_EQUAL_STRING("uart.smof", entry->member_name);
+    TEST_ASSERT_TRUE(symbol_index_entry_is_function(entry));
+    TEST_ASSERT_TRUE(symbol_index_entry_is_global(entry));
+    TEST_ASSERT_NULL(symbol_index_find_symbol(test_index, "uart_exit"));
+}
+
+void test_index_strong_replaces_weak(void) {
+    symbol_index_entry_t* entry;
+    
+    symbol_index_add_symbol(test_index, "handler", 0, NULL, 0, 0, SMOF_SYM_FUNC, SMOF_BIND_WEAK);
+    symbol_index_add_symbol(test_index, "handler", 1, NULL, 0, 0, SMOF_SYM_FUNC, SMOF_BIND_GLOBAL);
+    symbol_index_add_symbol(test_index, "handler", 2, NULL, 0, 0, SMOF_SYM_FUNC, SMOF_BIND_GLOBAL);
+    
+    /* The first strong definition wins over the earlier weak one */
+    entry = symbol_index_find_symbol(test_index, "handler");
+    TEST_ASSERT_NOT_NULL(entry);
+    TEST_ASSERT_EQUAL_UINT(1, entry->member_index);
+    TEST_ASSERT_FALSE(symbol_index_entry_is_weak(entry));
+}
+
+void test_index_serialize_round_trip(void) {
+    symbol_index_t* copy = symbol_index_create(0);
+    symbol_index_stats_t stats;
+    symbol_index_entry_t* entry;
+    char name[32];
+    uint8_t* data = NULL;
+    size_t size = 0;
+    uint32_t i;
+    
+    for (i = 0; i < 500; i++) {
+        snprintf(name, sizeof(name), "symbol_%u", i);
+        TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                              symbol_index_add_symbol(test_index, name, i / 10, NULL, i, 4,
+                                                      SMOF_SYM_OBJECT, SMOF_BIND_GLOBAL));
+    }
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, symbol_index_serialize(test_index, &data, &size));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, symbol_index_deserialize(copy, data, size));
+    free(data);
+    
+    symbol_index_get_stats(copy, &stats);
+    TEST_ASSERT_EQUAL_UINT(500, (uint32_t)stats.total_symbols);
+    TEST_ASSERT_EQUAL_UINT(500, (uint32_t)stats.object_symbols);
+    
+    entry = symbol_index_find_symbol(copy, "symbol_427");
+    TEST_ASSERT_NOT_NULL(entry);
+    TEST_ASSERT_EQUAL_UINT(42, entry->member_index);
+    TEST_ASSERT_EQUAL_UINT(427, entry->symbol_value);
+    
+    symbol_index_destroy(copy);
+}
+
+void test_index_rejects_corrupt_data(void) {
+    uint8_t* data = NULL;
+    size_t size = 0;
+    
+    symbol_index_add_symbol(test_index, "main", 0, NULL, 0, 0, SMOF_SYM_FUNC, SMOF_BIND_GLOBAL);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, symbol_index_serialize(test_index, &data, &size));
+    
+    /* Truncated pool, then a bad magic */
+    TEST_ASSERT_EQUAL_INT(ERROR_ARCHIVE_CORRUPT, symbol_index_deserialize(test_index, data, size - 1));
+    data[0] ^= 0xFF;
+    TEST_ASSERT_EQUAL_INT(ERROR_ARCHIVE_CORRUPT, symbol_index_deserialize(test_index, data, size));
+    free(data);
+}
+
+void test_index_searches_serialized_data_in_place(void) {
+    symbol_index_t* view = symbol_index_create(0);
+    symbol_index_stats_t stats;
+    symbol_index_entry_t* entry;
+    uint8_t* data = NULL;
+    uint8_t* copy = NULL;
+    uint8_t* shifted;
+    size_t size = 0;
+    size_t copy_size = 0;
+    char name[32];
+    uint32_t i;
+    
+    for (i = 0; i < 2000; i++) {
+        snprintf(name, sizeof(name), "function_%u", i);
+        TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                              symbol_index_add_symbol(test_index, name, i % 97, NULL, i, 8,
+                                                      SMOF_SYM_FUNC, SMOF_BIND_GLOBAL));
+    }
+    symbol_index_add_symbol(test_index, "handler", 5, NULL, 0, 0, SMOF_SYM_FUNC, SMOF_BIND_WEAK);
+    symbol_index_add_symbol(test_index, "handler", 6, NULL, 0, 0, SMOF_SYM_FUNC, SMOF_BIND_GLOBAL);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, symbol_index_serialize(test_index, &data, &size));
+    
+    /* The data need not be aligned */
+    shifted = calloc(size + 1, 1);
+    TEST_ASSERT_NOT_NULL(shifted);
+    memcpy(shifted + 1, data, size);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, symbol_index_attach(view, shifted + 1, size));
+    
+    entry = symbol_index_find_symbol(view, "function_1234");
+    TEST_ASSERT_NOT_NULL(entry);
+    TEST_ASSERT_EQUAL_STRING("function_1234", entry->name);
+    TEST_ASSERT_EQUAL_UINT(1234 % 97, entry->member_index);
+    TEST_ASSERT_EQUAL_UINT(1234, entry->symbol_value);
+    TEST_ASSERT_EQUAL_UINT(8, entry->symbol_size);
+    TEST_ASSERT_TRUE(symbol_index_entry_is_function(entry));
+    TEST_ASSERT_EQUAL_PTR(entry, symbol_index_find_symbol(view, "function_1234"));
+    TEST_ASSERT_EQUAL_UINT(6, symbol_index_find_symbol(view, "handler")->member_index);
+    TEST_ASSERT_NULL(symbol_index_find_symbol(view, "function_2000"));
+    
+    /* Read-only once attached, and it serializes back to the same bytes */
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_ARGUMENT,
+                          symbol_index_add_symbol(view, "late", 0, NULL, 0, 0,
+                                                  SMOF_SYM_FUNC, SMOF_BIND_GLOBAL));
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_ARGUMENT, symbol_index_attach(view, data, size));
+    symbol_index_get_stats(view, &stats);
+    TEST_ASSERT_EQUAL_UINT(2001, (uint32_t)stats.total_symbols);
+    TEST_ASSERT_EQUAL_UINT((uint32_t)size, (uint32_t)stats.index_size);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, symbol_index_serialize(view, &copy, &copy_size));
+    TEST_ASSERT_EQUAL_UINT((uint32_t)size, (uint32_t)copy_size);
+    TEST_ASSERT_EQUAL_MEMORY(data, copy, (uint32_t)size);
+    symbol_index_destroy(view);
+    
+    /* A truncated index is refused, a bucket start out of range finds nothing */
+    view = symbol_index_create(0);
+    TEST_ASSERT_EQUAL_INT(ERROR_ARCHIVE_CORRUPT, symbol_index_attach(view, data, size - 1));
+    memset(copy + 16, 0xFF, (size_t)(stats.hash_table_size + 1) * sizeof(uint32_t));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, symbol_index_attach(view, copy, size));
+    TEST_ASSERT_NULL(symbol_index_find_symbol(view, "function_1234"));
+    symbol_index_destroy(view);
+    
+    free(shifted);
+    free(copy);
+    free(data);
+}
+
+#define TEST_MANY_SYMBOLS 100000
+
+void test_index_grows_past_old_limit(void) {
+    symbol_index_stats_t stats;
+    symbol_index_entry_t* entry;
+    char name[32];
+    uint32_t i;
+    uint32_t j;
+    
+    /* Every symbol stays reachable while the table grows underneath */
+    for (i = 0; i < TEST_MANY_SYMBOLS; i++) {
+        snprintf(name, sizeof(name), "sym_%u", i);
+        TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                              symbol_index_add_symbol(test_index, name, i, NULL, i, 0,
+                                                      SMOF_SYM_OBJECT, SMOF_BIND_GLOBAL));
+        if (i % 9973 == 0) {
+            for (j = 0; j <= i; j += 101) {
+                snprintf(name, sizeof(name), "sym_%u", j);
+                entry = symbol_index_find_symbol(test_index, name);
+                TEST_ASSERT_NOT_NULL(entry);
+                TEST_ASSERT_EQUAL_UINT(j, entry->member_index);
+            }
+        }
+    }
+    
+    symbol_index_get_stats(test_index, &stats);
+    TEST_ASSERT_EQUAL_UINT(TEST_MANY_SYMBOLS, (uint32_t)stats.total_symbols);
+    TEST_ASSERT_TRUE(stats.load_factor <= 1.0);
+    TEST_ASSERT_TRUE(stats.max_chain_length < 16);
+    
+    /* Explicit rehashes move everything at once, to any size */
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, symbol_index_rehash(test_index, 64));
+    symbol_index_get_stats(test_index, &stats);
+    TEST_ASSERT_EQUAL_UINT(64, (uint32_t)stats.hash_table_size);
+    TEST_ASSERT_NOT_NULL(symbol_index_find_symbol(test_index, "sym_54321"));
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, symbol_index_optimize(test_index));
+    symbol_index_get_stats(test_index, &stats);
+    TEST_ASSERT_TRUE(stats.load_factor <= 0.5);
+    TEST_ASSERT_EQUAL_UINT(TEST_MANY_SYMBOLS, (uint32_t)stats.total_symbols);
+    for (i = 0; i < TEST_MANY_SYMBOLS; i += 997) {
+        snprintf(name, sizeof(name), "sym_%u", i);
+        TEST_ASSERT_NOT_NULL(symbol_index_find_symbol(test_index, name));
+    }
+}
+
+#define TEST_MEMBER_COUNT 5000
+
+/* An object defining "m<n>", weak or strong "handler" and a strong "shared" */
+static uint8_t* make_object(uint32_t n, uint8_t handler_binding, uint32_t* size) {
+    smof_header_t header;
+    smof_section_t section;
+    smof_symbol_t symbol;
+    char strings[64];
+    uint32_t names[3];
+    uint32_t string_size;
+    uint8_t* data;
+    uint32_t i;
+    
+    names[0] = 1;
+    string_size = (uint32_t)snprintf(strings, sizeof(strings), "%cm%u", '\0', n) + 1;
+    names[1] = string_size;
+    memcpy(strings + string_size, "handler", 8);
+    names[2] = string_size + 8;
+    memcpy(strings + string_size + 8, "shared", 7);
+    string_size += 15;
+    
+    memset(&header, 0, sizeof(header));
+    header.magic = SMOF_MAGIC;
+    header.version = SMOF_VERSION_CURRENT;
+    header.flags = SMOF_FLAG_LITTLE_ENDIAN;
+    header.section_count = 1;
+    header.symbol_count = 3;
+    header.section_table_offset = sizeof(smof_header_t);
+    header.string_table_offset = (uint32_t)(sizeof(smof_header_t) + sizeof(smof_section_t) +
+                                            3 * sizeof(smof_symbol_t));
+    header.string_table_size = string_size;
+    memset(&section, 0, sizeof(section));
+    
+    *size = header.string_table_offset + string_size;
+    data = calloc(*size, 1);
+    TEST_ASSERT_NOT_NULL(data);
+    memcpy(data, &header, sizeof(header));
+    memcpy(data + sizeof(header), &section, sizeof(section));
+    for (i = 0; i < 3; i++) {
+        memset(&symbol, 0, sizeof(symbol));
+        symbol.name_offset = names[i];
+        symbol.value = n;
+        symbol.type = SMOF_SYM_FUNC;
+        symbol.binding = i == 1 ? handler_binding : SMOF_BIND_GLOBAL;
+        memcpy(data + sizeof(header) + sizeof(section) + i * sizeof(symbol), &symbol,
+               sizeof(symbol));
+    }
+    memcpy(data + header.string_table_offset, strings, string_size);
+    
+    return data;
+}
+
+void test_index_parallel_build_matches_serial(void) {
+    archive_file_t* archive = calloc(1, sizeof(archive_file_t));
+    thread_pool_t* pool = thread_pool_create(4);
+    symbol_index_t* parallel = symbol_index_create(0);
+    symbol_index_entry_t* entry;
+    char strong_name[] = "strong.smof";
+    char weak_name[] = "weak.smof";
+    uint8_t* serial_data = NULL;
+    uint8_t* parallel_data = NULL;
+    size_t serial_size = 0;
+    size_t parallel_size = 0;
+    uint32_t size;
+    uint32_t i;
+    
+    TEST_ASSERT_NOT_NULL(archive);
+    TEST_ASSERT_NOT_NULL(pool);
+    TEST_ASSERT_NOT_NULL(parallel);
+    archive->members = calloc(TEST_MEMBER_COUNT, sizeof(archive_member_t));
+    TEST_ASSERT_NOT_NULL(archive->members);
+    archive->header.member_count = TEST_MEMBER_COUNT;
+    
+    /* "handler" is weak everywhere but in two late members */
+    for (i = 0; i < TEST_MEMBER_COUNT; i++) {
+        archive->members[i].data = make_object(i, i == 3217 || i == 4001 ? SMOF_BIND_GLOBAL :
+                                                  SMOF_BIND_WEAK, &size);
+        archive->members[i].header.size = size;
+        archive->members[i].data_loaded = true;
+        archive->members[i].name = i == 3217 ? strong_name : weak_name;
+    }
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, symbol_index_build_from_archive(test_index, archive));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          symbol_index_build_parallel(parallel, archive, pool, NULL, NULL));
+    
+    entry = symbol_index_find_symbol(parallel, "handler");
+    TEST_ASSERT_NOT_NULL(entry);
+    TEST_ASSERT_EQUAL_UINT(3217, entry->member_index);
+    TEST_ASSERT_EQUAL_STRING("strong.smof", entry->member_name);
+    TEST_ASSERT_EQUAL_UINT(0, symbol_index_find_symbol(parallel, "shared")->member_index);
+    TEST_ASSERT_EQUAL_UINT(4999, symbol_index_find_symbol(parallel, "m4999")->symbol_value);
+    
+    /* Both builds serialize to the same bytes */
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          symbol_index_serialize(test_index, &serial_data, &serial_size));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          symbol_index_serialize(parallel, &parallel_data, &parallel_size));
+    TEST_ASSERT_EQUAL_UINT((uint32_t)serial_size, (uint32_t)parallel_size);
+    TEST_ASSERT_EQUAL_MEMORY(serial_data, parallel_data, (uint32_t)serial_size);
+    
+    /* A member that does not have its data loaded fails either way */
+    archive->members[2500].data_loaded = false;
+    symbol_index_destroy(parallel);
+    parallel = symbol_index_create(0);
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_ARGUMENT,
+                          symbol_index_build_parallel(parallel, archive, pool, NULL, NULL));
+    
+    free(serial_data);
+    free(parallel_data);
+    for (i = 0; i < TEST_MEMBER_COUNT; i++) {
+        free(archive->members[i].data);
+    }
+    free(archive->members);
+    free(archive);
+    symbol_index_destroy(parallel);
+    thread_pool_destroy(pool);
+}
+
+#define TEST_PATTERN_SYMBOLS 20000
+
+typedef struct pattern_count {
+    const char* pattern;
+    uint32_t count;
+} pattern_count_t;
+
+static bool count_match(const symbol_index_entry_t* entry, void* user_data) {
+    pattern_count_t* scan = user_data;
+    
+    if (symbol_index_name_matches_pattern(entry->name, scan->pattern)) {
+        scan->count++;
+    }
+    
+    return true;
+}
+
+/* The search finds exactly what a scan with the same pattern does */
+static void check_pattern(const symbol_index_t* index, const char* pattern) {
+    pattern_count_t scan = {pattern, 0};
+    size_t found = 0;
+    
+    symbol_index_foreach(index, count_match, &scan);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          symbol_index_find_symbols_by_pattern(index, pattern, NULL, 0, &found));
+    TEST_ASSERT_EQUAL_UINT(scan.count, (uint32_t)found);
+}
+
+void test_index_finds_symbols_by_pattern(void) {
+    static const char* const patterns[] = {"uart*", "uart_*", "*_irq", "*0_i*", "spi1?_irq",
+                                           "*ab*", "*", "gpio*7", "?pi*", "*_init*x"};
+    symbol_search_result_t results[3];
+    symbol_index_t* copy = symbol_index_create(0);
+    uint8_t* data = NULL;
+    size_t size = 0;
+    size_t found = 0;
+    char name[32];
+    uint32_t i;
+    
+    for (i = 0; i < TEST_PATTERN_SYMBOLS; i++) {
+        snprintf(name, sizeof(name), "%s%u_%s", i % 3 == 0 ? "uart" : i % 3 == 1 ? "spi" : "gpio",
+                 i, i % 3 == 0 ? "init" : i % 3 == 1 ? "irq" : "read");
+        symbol_index_add_symbol(test_index, name, i, NULL, i, 0, SMOF_SYM_FUNC, SMOF_BIND_GLOBAL);
+    }
+    symbol_index_add_symbol(test_index, "uart_read", 1, NULL, 0, 0, SMOF_SYM_FUNC, SMOF_BIND_GLOBAL);
+    symbol_index_add_symbol(test_index, "uart_init", 0, NULL, 0, 0, SMOF_SYM_FUNC, SMOF_BIND_GLOBAL);
+    
+    for (i = 0; i < sizeof(patterns) / sizeof(patterns[0]); i++) {
+        check_pattern(test_index, patterns[i]);
+    }
+    
+    /* Closest fits first, ties in name order; found counts all matches */
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          symbol_index_find_symbols_by_pattern(test_index, "uart*", results, 3,
+                                                               &found));
+    TEST_ASSERT_EQUAL_UINT(TEST_PATTERN_SYMBOLS / 3 + 3, (uint32_t)found);
+    TEST_ASSERT_EQUAL_STRING("uart_init", results[0].symbol->name);
+    TEST_ASSERT_EQUAL_STRING("uart_read", results[1].symbol->name);
+    TEST_ASSERT_EQUAL_STRING("uart0_init", results[2].symbol->name);
+    TEST_ASSERT_TRUE(results[0].relevance > results[2].relevance);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          symbol_index_find_symbols_by_pattern(test_index, "uart_init", results, 3,
+                                                               &found));
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)found);
+    TEST_ASSERT_TRUE(results[0].relevance == 1.0);
+    
+    /* Symbols added after a search are found by the next one */
+    symbol_index_add_symbol(test_index, "usb_irq", 7, NULL, 0, 0, SMOF_SYM_FUNC, SMOF_BIND_GLOBAL);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          symbol_index_find_symbols_by_pattern(test_index, "u*_irq", results, 3,
+                                                               &found));
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)found);
+    TEST_ASSERT_EQUAL_UINT(7, results[0].symbol->member_index);
+    
+    /* An attached index searches the same way */
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, symbol_index_serialize(test_index, &data, &size));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, symbol_index_attach(copy, data, size));
+    for (i = 0; i < sizeof(patterns) / sizeof(patterns[0]); i++) {
+        check_pattern(copy, patterns[i]);
+    }
+    
+    symbol_index_destroy(copy);
+    free(data);
+}
+
+/* Visitor counting down from the limit in user_data, stopping at zero */
+static bool take_symbols(const symbol_index_entry_t* entry, void* user_data) {
+    uint32_t* left = user_data;
+    
+    (void)entry;
+    
+    return --*left > 0;
+}
+
+void test_index_finds_symbols_by_member(void) {
+    symbol_index_entry_t* symbols[8];
+    symbol_index_t* copy = symbol_index_create(0);
+    uint8_t* data = NULL;
+    size_t size = 0;
+    size_t found = 0;
+    uint32_t left;
+    char name[32];
+    uint32_t i;
+    
+    /* Members' symbols are added out of name order and interleaved */
+    for (i = 0; i < 500; i++) {
+        snprintf(name, sizeof(name), "sym_%c_%u", 'e' - (char)(i / 100), i % 100);
+        symbol_index_add_symbol(test_index, name, i % 100, NULL, i, 0, SMOF_SYM_FUNC,
+                                i % 100 == 7 ? SMOF_BIND_WEAK : SMOF_BIND_GLOBAL);
+    }
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          symbol_index_find_symbols_by_member(test_index, 42, symbols, 8, &found));
+    TEST_ASSERT_EQUAL_UINT(5, (uint32_t)found);
+    TEST_ASSERT_EQUAL_STRING("sym_a_42", symbols[0]->name);
+    TEST_ASSERT_EQUAL_STRING("sym_e_42", symbols[4]->name);
+    
+    /* found_count is every definition, however few fit */
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          symbol_index_find_symbols_by_member(test_index, 3, symbols, 2, &found));
+    TEST_ASSERT_EQUAL_UINT(5, (uint32_t)found);
+    TEST_ASSERT_EQUAL_STRING("sym_b_3", symbols[1]->name);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          symbol_index_find_symbols_by_member(test_index, 100, NULL, 0, &found));
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)found);
+    
+    /* A strong definition taking over a weak one moves to its member */
+    symbol_index_add_symbol(test_index, "sym_c_7", 99, NULL, 0, 0, SMOF_SYM_FUNC,
+                            SMOF_BIND_GLOBAL);
+    symbol_index_find_symbols_by_member(test_index, 7, symbols, 8, &found);
+    TEST_ASSERT_EQUAL_UINT(4, (uint32_t)found);
+    symbol_index_find_symbols_by_member(test_index, 99, symbols, 8, &found);
+    TEST_ASSERT_EQUAL_UINT(6, (uint32_t)found);
+    TEST_ASSERT_EQUAL_STRING("sym_c_7", symbols[2]->name);
+    
+    left = 3;
+    symbol_index_foreach_in_member(test_index, 99, take_symbols, &left);
+    TEST_ASSERT_EQUAL_UINT(0, left);
+    
+    /* An attached index groups its entries the same way */
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, symbol_index_serialize(test_index, &data, &size));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, symbol_index_attach(copy, data, size));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          symbol_index_find_symbols_by_member(copy, 99, symbols, 8, &found));
+    TEST_ASSERT_EQUAL_UINT(6, (uint32_t)found);
+    TEST_ASSERT_EQUAL_STRING("sym_a_99", symbols[0]->name);
+    
+    symbol_index_destroy(copy);
+    free(data);
+}
+
+int test_index_main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_index_find_symbol);
+    RUN_TEST(test_index_strong_replaces_weak);
+    RUN_TEST(test_index_serialize_round_trip);
+    RUN_TEST(test_index_rejects_corrupt_data);
+    RUN_TEST(test_index_searches_serialized_data_in_place);
+    RUN_TEST(test_index_grows_past_old_limit);
+    RUN_TEST(test_index_parallel_build_matches_serial);
+    RUN_TEST(test_index_finds_symbols_by_pattern);
+    RUN_TEST(test_index_finds_symbols_by_member);
+    
+    return UNITY_END();
+}
+
+int main(void) {
+    return test_index_main();
+}
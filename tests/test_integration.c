@@ -45,24 +45,24 @@ void test_smof_with_memory_pool(void) {
     TEST_ASSERT_NOT_NULL(header);
     
     /* Initialize header with current structure fields */
+    memset(header, 0, sizeof(smof_header_t));
     header->magic = SMOF_MAGIC;
-    header->version = SMOF_VERSION;
+    header->version = SMOF_VERSION_CURRENT;
     header->flags = SMOF_FLAG_LITTLE_ENDIAN;
     header->entry_point = 0x1000;
     header->section_count = 1;
     header->symbol_count = 0;
     header->section_table_offset = 64;   /* Must be > sizeof(smof_header_t) */
-    header->symbol_table_offset = 128;   /* Must be > sizeof(smof_header_t) */
+    header->reloc_table_offset = 128;    /* Must be > sizeof(smof_header_t) */
     header->string_table_offset = 256;   /* Must be > sizeof(smof_header_t) */
-    header->checksum = 0;
     
     /* Validate the header using current API */
     TEST_ASSERT_TRUE(smof_validate_header(header));
-    TEST_ASSERT_TRUE(smof_header_is_valid(header));
+    TEST_ASSERT_TRUE(smof_is_little_endian(header));
     
     /* Test header parsing functions */
     TEST_ASSERT_EQUAL_UINT(SMOF_MAGIC, header->magic);
-    TEST_ASSERT_EQUAL_UINT(SMOF_VERSION, header->version);
+    TEST_ASSERT_EQUAL_UINT(SMOF_VERSION_CURRENT, header->version);
     TEST_ASSERT_EQUAL_UINT(SMOF_FLAG_LITTLE_ENDIAN, header->flags);
 }
 
@@ -86,34 +86,32 @@ void test_error_handling_with_memory_allocation(void) {
 void test_memory_pool_with_sections(void) {
     /* Allocate space for multiple sections using current API */
     const size_t num_sections = 3;
-    smof_section_header_t* sections;
+    smof_section_t* sections;
     size_t i;
     memory_pool_stats_t stats;
     
-    sections = (smof_section_header_t*)
-        memory_pool_alloc(test_pool, num_sections * sizeof(smof_section_header_t));
+    sections = (smof_section_t*)
+        memory_pool_alloc(test_pool, num_sections * sizeof(smof_section_t));
     
     TEST_ASSERT_NOT_NULL(sections);
     
     /* Initialize sections with current structure fields */
     for (i = 0; i < num_sections; i++) {
         sections[i].name_offset = (uint32_t)(i * 16);
-        sections[i].type = (uint32_t)(i % 7);  /* Cycle through section types */
-        sections[i].flags = 0;
-        sections[i].addr = 0x1000 + (uint32_t)(i * 0x1000);
+        sections[i].virtual_addr = 0x1000 + (uint32_t)(i * 0x1000);
         sections[i].size = (uint32_t)((i + 1) * 1024);
-        sections[i].offset = 0;
-        sections[i].link = 0;
-        sections[i].info = 0;
-        sections[i].alignment = 4;
-        sections[i].entry_size = 0;
+        sections[i].file_offset = 0;
+        sections[i].flags = (uint16_t)(SMOF_SECT_READABLE | (i == 0 ? SMOF_SECT_EXECUTABLE : 0));
+        sections[i].alignment = 2;
+        sections[i].reserved = 0;
     }
     
     /* Verify section data */
     for (i = 0; i < num_sections; i++) {
-        TEST_ASSERT_EQUAL_UINT((uint32_t)(i % 7), sections[i].type);
+        TEST_ASSERT_EQUAL_UINT(0x1000 + (uint32_t)(i * 0x1000), sections[i].virtual_addr);
         TEST_ASSERT_TRUE(sections[i].size > 0);
     }
+    TEST_ASSERT_TRUE((sections[0].flags & SMOF_SECT_EXECUTABLE) != 0);
     
     /* Check memory pool statistics */
     memory_pool_get_stats(test_pool, &stats);
@@ -149,7 +147,7 @@ void test_error_recovery_scenario(void) {
 void test_full_workflow_simulation(void) {
     memory_pool_stats_t stats;
     smof_header_t* header;
-    smof_section_header_t* sections;
+    smof_section_t* sections;
     
     /* Simulate a complete workflow: allocation, processing, cleanup */
     
@@ -158,34 +156,29 @@ void test_full_workflow_simulation(void) {
     TEST_ASSERT_NOT_NULL(header);
     
     /* Step 2: Initialize with valid data */
+    memset(header, 0, sizeof(smof_header_t));
     header->magic = SMOF_MAGIC;
-    header->version = SMOF_VERSION;
+    header->version = SMOF_VERSION_CURRENT;
     header->flags = SMOF_FLAG_LITTLE_ENDIAN;
     header->entry_point = 0x1000;
     header->section_count = 3;
     header->symbol_count = 10;
-    header->section_table_offset = 32;
-    header->symbol_table_offset = 152;
-    header->string_table_offset = 312;
-    header->checksum = 0;
+    header->section_table_offset = 36;
+    header->reloc_table_offset = 256;
+    header->string_table_offset = 256;
     
     /* Step 3: Validate header */
     TEST_ASSERT_TRUE(smof_validate_header(header));
     
     /* Step 4: Allocate sections */
-    sections = (smof_section_header_t*)
-        memory_pool_alloc(test_pool, header->section_count * sizeof(smof_section_header_t));
+    sections = (smof_section_t*)
+        memory_pool_alloc(test_pool, header->section_count * sizeof(smof_section_t));
     TEST_ASSERT_NOT_NULL(sections);
     
     /* Step 5: Initialize sections */
-    sections[0].type = SMOF_SECTION_PROGBITS;
-    sections[0].flags = 0x6;  /* Read+Execute */
-    
-    sections[1].type = SMOF_SECTION_PROGBITS;
-    sections[1].flags = 0x3;  /* Read+Write */
-    
-    sections[2].type = SMOF_SECTION_STRTAB;
-    sections[2].flags = 0x0;  /* No flags */
+    sections[0].flags = SMOF_SECT_READABLE | SMOF_SECT_EXECUTABLE;
+    sections[1].flags = SMOF_SECT_READABLE | SMOF_SECT_WRITABLE;
+    sections[2].flags = SMOF_SECT_READABLE | SMOF_SECT_ZERO_FILL;
     
     /* Step 6: Check memory usage */
     memory_pool_get_stats(test_pool, &stats);
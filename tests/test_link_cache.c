@@ -0,0 +1,126 @@
+/* tests/test_link_cache.c */
+#include "unity.h"
+#include "link_cache.h"
+#include "error.h"
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @file test_link_cache.c
+ * @brief Unit tests for the link-state cache file
+ * @details Tests writing and reading back a cache and rejecting caches
+ * that are missing, truncated or damaged
+ */
+
+/* Function prototypes */
+void test_link_cache_round_trip(void);
+void test_link_cache_missing_file(void);
+void test_link_cache_rejects_damage(void);
+int test_link_cache_main(void);
+
+#define TEST_CACHE_FILE "/tmp/stld_test.ldcache"
+
+static link_cache_t test_cache;
+
+void setUp(void) {
+    memset(&test_cache, 0, sizeof(test_cache));
+}
+
+void tearDown(void) {
+    link_cache_release(&test_cache);
+    remove(TEST_CACHE_FILE);
+}
+
+static void write_sample_cache(void) {
+    link_cache_t cache;
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, link_cache_init(&cache, 1, 2, 1));
+    cache.header.options_hash = 0x12345678;
+    cache.header.output_size = 4096;
+    cache.inputs[0].file_size = 100;
+    cache.inputs[0].checksum = 0xCAFEF00D;
+    cache.inputs[0].section_count = 2;
+    cache.sections[1].address = 0x1010;
+    cache.sections[1].file_offset = LINK_CACHE_NO_DATA;
+    cache.symbols[0].value = 0x1010;
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          link_cache_add_string(&cache, "main.smof", &cache.inputs[0].path_offset));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          link_cache_add_string(&cache, "helper", &cache.symbols[0].name_offset));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, link_cache_write(&cache, TEST_CACHE_FILE));
+    link_cache_release(&cache);
+}
+
+void test_link_cache_round_trip(void) {
+    write_sample_cache();
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, link_cache_read(&test_cache, TEST_CACHE_FILE));
+    TEST_ASSERT_EQUAL_HEX32(0x12345678, test_cache.header.options_hash);
+    TEST_ASSERT_EQUAL_UINT(4096, (uint32_t)test_cache.header.output_size);
+    TEST_ASSERT_EQUAL_UINT(1, test_cache.header.input_count);
+    TEST_ASSERT_EQUAL_UINT(2, test_cache.header.section_count);
+    TEST_ASSERT_EQUAL_HEX32(0xCAFEF00D, test_cache.inputs[0].checksum);
+    TEST_ASSERT_EQUAL_HEX32(0x1010, test_cache.sections[1].address);
+    TEST_ASSERT_EQUAL_HEX32(LINK_CACHE_NO_DATA, test_cache.sections[1].file_offset);
+    TEST_ASSERT_EQUAL_STRING("main.smof",
+                             link_cache_get_string(&test_cache, test_cache.inputs[0].path_offset));
+    TEST_ASSERT_EQUAL_STRING("helper",
+                             link_cache_get_string(&test_cache, test_cache.symbols[0].name_offset));
+    TEST_ASSERT_NULL(link_cache_get_string(&test_cache, 0xFFFF));
+}
+
+void test_link_cache_missing_file(void) {
+    remove(TEST_CACHE_FILE);
+    TEST_ASSERT_EQUAL_INT(ERROR_FILE_NOT_FOUND, link_cache_read(&test_cache, TEST_CACHE_FILE));
+}
+
+void test_link_cache_rejects_damage(void) {
+    uint8_t buffer[512];
+    size_t size;
+    FILE* file;
+    
+    write_sample_cache();
+    file = fopen(TEST_CACHE_FILE, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    size = fread(buffer, 1, sizeof(buffer), file);
+    fclose(file);
+    TEST_ASSERT_TRUE(size > sizeof(link_cache_header_t));
+    
+    /* A flipped table byte fails the checksum */
+    buffer[sizeof(link_cache_header_t)] ^= 0xFF;
+    file = fopen(TEST_CACHE_FILE, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    fwrite(buffer, 1, size, file);
+    fclose(file);
+    TEST_ASSERT_EQUAL_INT(ERROR_CORRUPT_HEADER, link_cache_read(&test_cache, TEST_CACHE_FILE));
+    
+    /* A truncated file does not match its counts */
+    buffer[sizeof(link_cache_header_t)] ^= 0xFF;
+    file = fopen(TEST_CACHE_FILE, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    fwrite(buffer, 1, size - 1, file);
+    fclose(file);
+    TEST_ASSERT_EQUAL_INT(ERROR_CORRUPT_HEADER, link_cache_read(&test_cache, TEST_CACHE_FILE));
+    
+    /* Another file type is not a cache */
+    buffer[0] ^= 0xFF;
+    file = fopen(TEST_CACHE_FILE, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    fwrite(buffer, 1, size, file);
+    fclose(file);
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_MAGIC, link_cache_read(&test_cache, TEST_CACHE_FILE));
+}
+
+int test_link_cache_main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_link_cache_round_trip);
+    RUN_TEST(test_link_cache_missing_file);
+    RUN_TEST(test_link_cache_rejects_damage);
+    
+    return UNITY_END();
+}
+
+int main(void) {
+    return test_link_cache_main();
+}
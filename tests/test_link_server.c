@@ -0,0 +1,235 @@
+/* tests/test_link_server.c */
+#include "unity.h"
+#include "link_server.h"
+#include "error.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @file test_link_server.c
+ * @brief Unit tests for the link server
+ * @details Runs a server with an echo handler on a background thread and
+ * checks that arguments, the working directory, output, diagnostics and
+ * exit status travel between client and handler, that concurrent clients
+ * are all served and that a shutdown request stops the server.
+ */
+
+#define TEST_SERVER_CLIENTS 8
+
+/* Function prototypes */
+void test_link_server_runs_job(void);
+void test_link_server_relays_diagnostics(void);
+void test_link_server_concurrent_clients(void);
+void test_link_server_no_server(void);
+int test_link_server_main(void);
+
+static char socket_path[64];
+static char program[] = "stld";
+static pthread_t server_thread;
+static int server_result;
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+/* Prints its arguments and cwd; "fail" exits 3 after a diagnostic */
+static int echo_handler(int argc, char** argv, const char* cwd,
+                        FILE* out, FILE* err, void* user_data) {
+    int i;
+    
+    (void)user_data;
+    for (i = 0; i < argc; i++) {
+        fprintf(out, "%s%s", i > 0 ? " " : "", argv[i]);
+    }
+    fprintf(out, "\n%s\n", cwd);
+    
+    if (argc > 1 && strcmp(argv[1], "fail") == 0) {
+        fprintf(err, "failed\n");
+        if (link_server_job_stream() == err) {
+            fprintf(err, "job stream\n");
+        }
+        return 3;
+    }
+    return 0;
+}
+
+static void* serve(void* arg) {
+    (void)arg;
+    server_result = link_server_run(socket_path, 2, echo_handler, NULL);
+    return NULL;
+}
+
+/* Submit argv and return what the job printed; the caller frees both */
+static int submit(int argc, char* const* argv, bool shutdown, char** out, char** err) {
+    FILE* out_file = tmpfile();
+    FILE* err_file = tmpfile();
+    FILE* files[2];
+    char** texts[2];
+    int status = -1;
+    long size;
+    int i;
+    
+    TEST_ASSERT_NOT_NULL(out_file);
+    TEST_ASSERT_NOT_NULL(err_file);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          link_server_submit(socket_path, argc, argv, shutdown,
+                                             out_file, err_file, &status));
+    
+    files[0] = out_file;
+    files[1] = err_file;
+    texts[0] = out;
+    texts[1] = err;
+    for (i = 0; i < 2; i++) {
+        size = ftell(files[i]);
+        *texts[i] = malloc((size_t)size + 1);
+        TEST_ASSERT_NOT_NULL(*texts[i]);
+        rewind(files[i]);
+        TEST_ASSERT_TRUE(fread(*texts[i], 1, (size_t)size, files[i]) == (size_t)size);
+        (*texts[i])[size] = '\0';
+        fclose(files[i]);
+    }
+    return status;
+}
+
+/* Start a server and wait until it accepts jobs */
+static void start_server(void) {
+    struct stat st;
+    int tries;
+    
+    snprintf(socket_path, sizeof(socket_path), "/tmp/test_link_server_%ld.sock", (long)getpid());
+    unlink(socket_path);
+    server_result = -1;
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&server_thread, NULL, serve, NULL));
+    for (tries = 0; tries < 500 && stat(socket_path, &st) != 0; tries++) {
+        usleep(10000);
+    }
+    TEST_ASSERT_TRUE(tries < 500);
+}
+
+/* Ask the server to stop and check it did so cleanly */
+static void stop_server(void) {
+    char* argv[] = {program};
+    char* out;
+    char* err;
+    struct stat st;
+    
+    TEST_ASSERT_EQUAL_INT(0, submit(1, argv, true, &out, &err));
+    free(out);
+    free(err);
+    TEST_ASSERT_EQUAL_INT(0, pthread_join(server_thread, NULL));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, server_result);
+    TEST_ASSERT_TRUE(stat(socket_path, &st) != 0);
+}
+
+void test_link_server_runs_job(void) {
+    char output[] = "out.smof";
+    char input[] = "a.smof";
+    char option[] = "-o";
+    char* argv[] = {program, option, output, input};
+    char expected[4200];
+    char cwd[4096];
+    char* out;
+    char* err;
+    
+    TEST_ASSERT_NOT_NULL(getcwd(cwd, sizeof(cwd)));
+    snprintf(expected, sizeof(expected), "stld -o out.smof a.smof\n%s\n", cwd);
+    
+    start_server();
+    TEST_ASSERT_EQUAL_INT(0, submit(4, argv, false, &out, &err));
+    TEST_ASSERT_EQUAL_STRING(expected, out);
+    TEST_ASSERT_EQUAL_STRING("", err);
+    free(out);
+    free(err);
+    stop_server();
+}
+
+void test_link_server_relays_diagnostics(void) {
+    char fail[] = "fail";
+    char* argv[] = {program, fail};
+    char* out;
+    char* err;
+    
+    start_server();
+    TEST_ASSERT_EQUAL_INT(3, submit(2, argv, false, &out, &err));
+    TEST_ASSERT_EQUAL_STRING("failed\njob stream\n", err);
+    TEST_ASSERT_TRUE(strncmp(out, "stld fail\n", 10) == 0);
+    free(out);
+    free(err);
+    stop_server();
+}
+
+/* Unity asserts only on the main thread: a failed job marks its id instead */
+static void* client(void* arg) {
+    char number[16];
+    char* argv[] = {program, number};
+    char expected[32];
+    char line[32];
+    FILE* out = tmpfile();
+    int status = -1;
+    
+    snprintf(number, sizeof(number), "%d", *(int*)arg);
+    snprintf(expected, sizeof(expected), "stld %s\n", number);
+    if (out == NULL) {
+        *(int*)arg = -1;
+        return NULL;
+    }
+    if (link_server_submit(socket_path, 2, argv, false, out, stderr, &status) != ERROR_SUCCESS ||
+        status != 0) {
+        *(int*)arg = -1;
+    } else {
+        rewind(out);
+        if (fgets(line, sizeof(line), out) == NULL || strcmp(line, expected) != 0) {
+            *(int*)arg = -1;
+        }
+    }
+    fclose(out);
+    return NULL;
+}
+
+void test_link_server_concurrent_clients(void) {
+    pthread_t threads[TEST_SERVER_CLIENTS];
+    int ids[TEST_SERVER_CLIENTS];
+    int i;
+    
+    start_server();
+    for (i = 0; i < TEST_SERVER_CLIENTS; i++) {
+        ids[i] = i;
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[i], NULL, client, &ids[i]));
+    }
+    for (i = 0; i < TEST_SERVER_CLIENTS; i++) {
+        pthread_join(threads[i], NULL);
+        TEST_ASSERT_EQUAL_INT(i, ids[i]);
+    }
+    stop_server();
+}
+
+void test_link_server_no_server(void) {
+    char* argv[] = {program};
+    int status = -1;
+    
+    snprintf(socket_path, sizeof(socket_path), "/tmp/test_link_server_%ld.none", (long)getpid());
+    unlink(socket_path);
+    TEST_ASSERT_EQUAL_INT(ERROR_FILE_NOT_FOUND,
+                          link_server_submit(socket_path, 1, argv, false, stdout, stderr, &status));
+}
+
+int test_link_server_main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_link_server_runs_job);
+    RUN_TEST(test_link_server_relays_diagnostics);
+    RUN_TEST(test_link_server_concurrent_clients);
+    RUN_TEST(test_link_server_no_server);
+    
+    return UNITY_END();
+}
+
+int main(void) {
+    return test_link_server_main();
+}
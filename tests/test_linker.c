@@ -0,0 +1,1552 @@
+/* tests/test_linker.c */
+#include "unity.h"
+#include "stld.h"
+#include "smof.h"
+#include "error.h"
+#include "star.h"
+#include "object_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <utime.h>
+
+/**
+ * @file test_linker.c
+ * @brief Unit tests for the STLD link pipeline
+ * @details Tests object loading, symbol resolution and relocation binding
+ * against small SMOF objects written to temporary files
+ */
+
+/* Function prototypes */
+void test_linker_resolves_cross_object_reference(void);
+void test_linker_writes_smof_output(void);
+void test_linker_relocation_index_out_of_range(void);
+void test_linker_undefined_reference(void);
+void test_linker_relocation_outside_section(void);
+void test_linker_duplicate_definition(void);
+void test_linker_invalid_file(void);
+void test_linker_truncated_object(void);
+void test_linker_parallel_load(void);
+void test_linker_memory_limit(void);
+void test_linker_gc_sections(void);
+void test_linker_folds_identical_code(void);
+void test_linker_incremental_relink(void);
+void test_linker_pulls_library_members(void);
+void test_linker_missing_library(void);
+void test_linker_phase_stats(void);
+void test_linker_writes_map_file(void);
+void test_linker_script_placement(void);
+void test_linker_partial_link(void);
+void test_linker_links_built_objects(void);
+void test_linker_links_foreign_byte_order(void);
+void test_linker_links_v2_objects(void);
+void test_linker_shared_cache(void);
+void test_linker_cache_maps_private_copies(void);
+void test_linker_builds_got(void);
+void test_linker_incremental_dependencies(void);
+int test_linker_main(void);
+
+#define TEST_OBJECT_A   "/tmp/stld_test_a.smof"
+#define TEST_OBJECT_B   "/tmp/stld_test_b.smof"
+#define TEST_OBJECT_C   "/tmp/stld_test_c.smof"
+#define TEST_OBJECT_D   "/tmp/stld_test_d.smof"
+#define TEST_LIBRARY    "/tmp/libstld_test.star"
+#define TEST_OUTPUT     "/tmp/stld_test_out.smof"
+#define TEST_CACHE      TEST_OUTPUT ".ldcache"
+#define TEST_MAP        TEST_OUTPUT ".map"
+#define TEST_SCRIPT     "/tmp/stld_test.ld"
+#define TEST_PARALLEL_OBJECTS 8
+#define TEST_TEXT_SIZE  16
+
+/* Symbol description used to build test objects */
+typedef struct test_symbol {
+    const char* name;
+    uint16_t section_index;
+    uint8_t binding;
+    uint32_t value;
+} test_symbol_t;
+
+static stld_context_t* test_context;
+
+void setUp(void) {
+    stld_options_t options = stld_get_default_options();
+    test_context = stld_context_create(&options);
+}
+
+void tearDown(void) {
+    if (test_context) {
+        stld_context_destroy(test_context);
+        test_context = NULL;
+    }
+    remove(TEST_OBJECT_A);
+    remove(TEST_OBJECT_B);
+    remove(TEST_OBJECT_C);
+    remove(TEST_OBJECT_D);
+    remove(TEST_LIBRARY);
+    remove(TEST_OUTPUT);
+    remove(TEST_CACHE);
+    remove(TEST_MAP);
+    remove(TEST_SCRIPT);
+}
+
+/* Layout: header, one .text section, symbols, relocations, strings, data */
+static void write_object(const char* filename,
+                         const test_symbol_t* symbols, uint16_t symbol_count,
+                         const smof_relocation_t* relocs, uint16_t reloc_count) {
+    smof_header_t header;
+    smof_section_t section;
+    smof_symbol_t symbol;
+    uint8_t text[TEST_TEXT_SIZE];
+    char strings[256] = "\0.text";
+    uint32_t string_size = 7;
+    uint32_t name_offsets[16];
+    FILE* file;
+    uint16_t i;
+    
+    TEST_ASSERT_TRUE(symbol_count <= 16);
+    
+    for (i = 0; i < symbol_count; i++) {
+        name_offsets[i] = string_size;
+        strcpy(strings + string_size, symbols[i].name);
+        string_size += (uint32_t)strlen(symbols[i].name) + 1;
+    }
+    
+    memset(&header, 0, sizeof(header));
+    header.magic = SMOF_MAGIC;
+    header.version = SMOF_VERSION_CURRENT;
+    header.flags = SMOF_FLAG_LITTLE_ENDIAN;
+    header.section_count = 1;
+    header.symbol_count = symbol_count;
+    header.section_table_offset = sizeof(smof_header_t);
+    header.reloc_table_offset = (uint32_t)(sizeof(smof_header_t) + sizeof(smof_section_t) +
+                                           symbol_count * sizeof(smof_symbol_t));
+    header.reloc_count = reloc_count;
+    header.string_table_offset = header.reloc_table_offset +
+                                 (uint32_t)(reloc_count * sizeof(smof_relocation_t));
+    header.string_table_size = string_size;
+    
+    memset(&section, 0, sizeof(section));
+    section.name_offset = 1;
+    section.virtual_addr = 0x1000;
+    section.size = TEST_TEXT_SIZE;
+    section.file_offset = header.string_table_offset + string_size;
+    section.flags = SMOF_SECT_EXECUTABLE | SMOF_SECT_LOADABLE;
+    memset(text, 0, sizeof(text));
+    
+    file = fopen(filename, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(&section, sizeof(section), 1, file);
+    
+    for (i = 0; i < symbol_count; i++) {
+        memset(&symbol, 0, sizeof(symbol));
+        symbol.name_offset = name_offsets[i];
+        symbol.value = symbols[i].value;
+        symbol.section_index = symbols[i].section_index;
+        symbol.type = SMOF_SYM_FUNC;
+        symbol.binding = symbols[i].binding;
+        fwrite(&symbol, sizeof(symbol), 1, file);
+    }
+    
+    if (reloc_count > 0) {
+        fwrite(relocs, sizeof(smof_relocation_t), reloc_count, file);
+    }
+    fwrite(strings, 1, string_size, file);
+    fwrite(text, 1, sizeof(text), file);
+    fclose(file);
+}
+
+/* Little-endian word at offset in an output section, and the section entry */
+static uint32_t read_section_word(uint16_t index, uint32_t offset, smof_section_t* section) {
+    smof_header_t header;
+    uint8_t field[4];
+    FILE* file;
+    
+    file = fopen(TEST_OUTPUT, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)fread(&header, sizeof(header), 1, file));
+    TEST_ASSERT_TRUE(index < header.section_count);
+    fseek(file, (long)(header.section_table_offset + index * sizeof(smof_section_t)), SEEK_SET);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)fread(section, sizeof(*section), 1, file));
+    fseek(file, (long)(section->file_offset + offset), SEEK_SET);
+    TEST_ASSERT_EQUAL_UINT(4, (uint32_t)fread(field, 1, sizeof(field), file));
+    fclose(file);
+    
+    return (uint32_t)field[0] | ((uint32_t)field[1] << 8) |
+           ((uint32_t)field[2] << 16) | ((uint32_t)field[3] << 24);
+}
+
+/* Little-endian word at offset in the first output section */
+static uint32_t read_output_word(uint32_t offset) {
+    smof_section_t section;
+    
+    return read_section_word(0, offset, &section);
+}
+
+/* Rewritten test objects can share a timestamp; move it on explicitly */
+static void touch_later(const char* filename) {
+    struct utimbuf times;
+    struct stat st;
+    
+    TEST_ASSERT_EQUAL_INT(0, stat(filename, &st));
+    times.actime = st.st_atime;
+    times.modtime = st.st_mtime + 10;
+    TEST_ASSERT_EQUAL_INT(0, utime(filename, &times));
+}
+
+/* Link A and B with the given options and return the stats */
+static void link_pair(const stld_options_t* options, stld_stats_t* stats) {
+    stld_context_t* context = stld_context_create(options);
+    
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(context, TEST_OBJECT_B));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_link(context, TEST_OUTPUT));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_get_stats(context, stats));
+    stld_context_destroy(context);
+}
+
+void test_linker_resolves_cross_object_reference(void) {
+    const test_symbol_t a_symbols[] = {
+        {"main", 0, SMOF_BIND_GLOBAL, 0x0},
+        {"helper", 0xFFFF, SMOF_BIND_GLOBAL, 0x0}
+    };
+    const test_symbol_t b_symbols[] = {
+        {"helper", 0, SMOF_BIND_GLOBAL, 0x40}
+    };
+    const smof_relocation_t a_relocs[] = {
+        {0x4, 1, SMOF_RELOC_REL32, 0},
+        {0x8, 0, SMOF_RELOC_ABS32, 0}
+    };
+    stld_stats_t stats;
+    
+    write_object(TEST_OBJECT_A, a_symbols, 2, a_relocs, 2);
+    write_object(TEST_OBJECT_B, b_symbols, 1, NULL, 0);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_B));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_link(test_context, TEST_OUTPUT));
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_get_stats(test_context, &stats));
+    TEST_ASSERT_EQUAL_UINT(2, (uint32_t)stats.input_files);
+    TEST_ASSERT_EQUAL_UINT(2, (uint32_t)stats.total_symbols);
+    TEST_ASSERT_EQUAL_UINT(2, (uint32_t)stats.relocations_processed);
+}
+
+void test_linker_writes_smof_output(void) {
+    const test_symbol_t a_symbols[] = {
+        {"main", 0, SMOF_BIND_GLOBAL, 0x1000},
+        {"helper", 0xFFFF, SMOF_BIND_GLOBAL, 0x0}
+    };
+    const test_symbol_t b_symbols[] = {
+        {"helper", 0, SMOF_BIND_GLOBAL, 0x1040}
+    };
+    const smof_relocation_t a_relocs[] = {
+        {0x8, 1, SMOF_RELOC_ABS32, 0}
+    };
+    const smof_header_t* header;
+    const smof_section_t* sections;
+    const smof_symbol_t* symbols;
+    const uint8_t* field;
+    stld_stats_t stats;
+    uint8_t* image;
+    size_t size;
+    FILE* file;
+    
+    write_object(TEST_OBJECT_A, a_symbols, 2, a_relocs, 1);
+    write_object(TEST_OBJECT_B, b_symbols, 1, NULL, 0);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_B));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_link(test_context, TEST_OUTPUT));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_get_stats(test_context, &stats));
+    
+    file = fopen(TEST_OUTPUT, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    fseek(file, 0, SEEK_END);
+    size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    image = malloc(size);
+    TEST_ASSERT_NOT_NULL(image);
+    TEST_ASSERT_EQUAL_UINT((uint32_t)size, (uint32_t)fread(image, 1, size, file));
+    fclose(file);
+    TEST_ASSERT_EQUAL_UINT((uint32_t)size, (uint32_t)stats.output_size);
+    
+    header = (const smof_header_t*)image;
+    TEST_ASSERT_TRUE(smof_validate_header(header));
+    TEST_ASSERT_EQUAL_UINT(1, header->section_count);
+    TEST_ASSERT_EQUAL_UINT(2, header->symbol_count);
+    TEST_ASSERT_TRUE((header->flags & SMOF_FLAG_EXECUTABLE) != 0);
+    
+    /* Both .text sections merge; the second lands after the first */
+    sections = (const smof_section_t*)(image + header->section_table_offset);
+    symbols = (const smof_symbol_t*)(sections + header->section_count);
+    TEST_ASSERT_EQUAL_HEX32(0x1000, sections[0].virtual_addr);
+    TEST_ASSERT_EQUAL_UINT(2 * TEST_TEXT_SIZE, sections[0].size);
+    TEST_ASSERT_EQUAL_UINT(0, symbols[0].section_index);
+    TEST_ASSERT_EQUAL_UINT(0, symbols[1].section_index);
+    TEST_ASSERT_EQUAL_HEX32(0x1000, symbols[0].value);
+    TEST_ASSERT_EQUAL_HEX32(0x1040 + TEST_TEXT_SIZE, symbols[1].value);
+    
+    /* The patched field reaches the output */
+    field = image + sections[0].file_offset + 8;
+    TEST_ASSERT_EQUAL_HEX32(0x1040 + TEST_TEXT_SIZE, (uint32_t)field[0] | ((uint32_t)field[1] << 8) |
+                                    ((uint32_t)field[2] << 16) | ((uint32_t)field[3] << 24));
+    
+    free(image);
+}
+
+void test_linker_relocation_index_out_of_range(void) {
+    const test_symbol_t symbols[] = {
+        {"main", 0, SMOF_BIND_GLOBAL, 0x0}
+    };
+    const smof_relocation_t relocs[] = {
+        {0x4, 7, SMOF_RELOC_ABS32, 0}
+    };
+    
+    write_object(TEST_OBJECT_A, symbols, 1, relocs, 1);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SYMBOL_NOT_FOUND, stld_link(test_context, TEST_OUTPUT));
+}
+
+void test_linker_undefined_reference(void) {
+    const test_symbol_t symbols[] = {
+        {"main", 0, SMOF_BIND_GLOBAL, 0x0},
+        {"missing", 0xFFFF, SMOF_BIND_GLOBAL, 0x0},
+        {"optional", 0xFFFF, SMOF_BIND_WEAK, 0x0}
+    };
+    const smof_relocation_t weak_relocs[] = {
+        {0x0, 2, SMOF_RELOC_ABS32, 0}
+    };
+    const smof_relocation_t strong_relocs[] = {
+        {0x0, 2, SMOF_RELOC_ABS32, 0},
+        {0x4, 1, SMOF_RELOC_REL32, 0}
+    };
+    
+    /* An undefined weak reference resolves to zero */
+    write_object(TEST_OBJECT_A, symbols, 3, weak_relocs, 1);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_link(test_context, TEST_OUTPUT));
+    stld_context_destroy(test_context);
+    
+    setUp();
+    write_object(TEST_OBJECT_A, symbols, 3, strong_relocs, 2);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SYMBOL_NOT_FOUND, stld_link(test_context, TEST_OUTPUT));
+}
+
+void test_linker_relocation_outside_section(void) {
+    const test_symbol_t symbols[] = {
+        {"main", 0, SMOF_BIND_GLOBAL, 0x0}
+    };
+    const smof_relocation_t relocs[] = {
+        {TEST_TEXT_SIZE - 2, 0, SMOF_RELOC_ABS32, 0}
+    };
+    
+    write_object(TEST_OBJECT_A, symbols, 1, relocs, 1);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_RELOCATION, stld_link(test_context, TEST_OUTPUT));
+}
+
+void test_linker_duplicate_definition(void) {
+    const test_symbol_t symbols[] = {
+        {"main", 0, SMOF_BIND_GLOBAL, 0x0}
+    };
+    
+    write_object(TEST_OBJECT_A, symbols, 1, NULL, 0);
+    write_object(TEST_OBJECT_B, symbols, 1, NULL, 0);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_B));
+    TEST_ASSERT_TRUE(stld_link(test_context, TEST_OUTPUT) != ERROR_SUCCESS);
+}
+
+void test_linker_invalid_file(void) {
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          stld_add_input_file(test_context, "/nonexistent/file.smof"));
+    TEST_ASSERT_EQUAL_INT(ERROR_FILE_IO, stld_link(test_context, TEST_OUTPUT));
+}
+
+void test_linker_truncated_object(void) {
+    smof_header_t header;
+    FILE* file;
+    
+    /* Header claims a symbol table that is not in the file */
+    memset(&header, 0, sizeof(header));
+    header.magic = SMOF_MAGIC;
+    header.version = SMOF_VERSION_CURRENT;
+    header.flags = SMOF_FLAG_LITTLE_ENDIAN;
+    header.symbol_count = 8;
+    header.section_table_offset = sizeof(smof_header_t);
+    header.string_table_offset = sizeof(smof_header_t);
+    
+    file = fopen(TEST_OBJECT_A, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    fwrite(&header, sizeof(header), 1, file);
+    fclose(file);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_CORRUPT_HEADER, stld_link(test_context, TEST_OUTPUT));
+}
+
+void test_linker_parallel_load(void) {
+    char filenames[TEST_PARALLEL_OBJECTS][64];
+    char names[TEST_PARALLEL_OBJECTS][16];
+    stld_options_t options = stld_get_default_options();
+    stld_context_t* context;
+    stld_stats_t stats;
+    uint16_t i;
+    
+    options.threads = 4;
+    context = stld_context_create(&options);
+    TEST_ASSERT_NOT_NULL(context);
+    
+    for (i = 0; i < TEST_PARALLEL_OBJECTS; i++) {
+        snprintf(names[i], sizeof(names[i]), "func_%u", i);
+    }
+    
+    /* Each object defines func_i and calls func_(i+1) */
+    for (i = 0; i < TEST_PARALLEL_OBJECTS; i++) {
+        const test_symbol_t symbols[] = {
+            {names[i], 0, SMOF_BIND_GLOBAL, 0x10},
+            {names[(i + 1) % TEST_PARALLEL_OBJECTS], 0xFFFF, SMOF_BIND_GLOBAL, 0}
+        };
+        const smof_relocation_t relocs[] = {
+            {0x4, 1, SMOF_RELOC_REL32, 0}
+        };
+        
+        snprintf(filenames[i], sizeof(filenames[i]), "/tmp/stld_test_par_%u.smof", i);
+        write_object(filenames[i], symbols, 2, relocs, 1);
+        TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(context, filenames[i]));
+    }
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_link(context, TEST_OUTPUT));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_get_stats(context, &stats));
+    TEST_ASSERT_EQUAL_UINT(TEST_PARALLEL_OBJECTS, (uint32_t)stats.total_symbols);
+    TEST_ASSERT_EQUAL_UINT(TEST_PARALLEL_OBJECTS, (uint32_t)stats.relocations_processed);
+    
+    stld_context_destroy(context);
+    for (i = 0; i < TEST_PARALLEL_OBJECTS; i++) {
+        remove(filenames[i]);
+    }
+}
+
+void test_linker_memory_limit(void) {
+    const test_symbol_t symbols[] = {
+        {"main", 0, SMOF_BIND_GLOBAL, 0x0},
+        {"helper", 0xFFFF, SMOF_BIND_GLOBAL, 0x0}
+    };
+    stld_options_t options = stld_get_default_options();
+    stld_context_t* context;
+    stld_stats_t stats;
+    
+    write_object(TEST_OBJECT_A, symbols, 2, NULL, 0);
+    
+    /* The 64KB budget from the architecture notes is enough */
+    options.max_memory = 65536;
+    context = stld_context_create(&options);
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_link(context, TEST_OUTPUT));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_get_stats(context, &stats));
+    TEST_ASSERT_TRUE(stats.memory_used > 0);
+    TEST_ASSERT_TRUE(stats.memory_used <= 65536);
+    stld_context_destroy(context);
+    
+    /* A budget smaller than the symbol table is rejected */
+    options.max_memory = 4096;
+    context = stld_context_create(&options);
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_OUT_OF_MEMORY, stld_link(context, TEST_OUTPUT));
+    stld_context_destroy(context);
+}
+
+void test_linker_gc_sections(void) {
+    const test_symbol_t a_symbols[] = {
+        {"_start", 0, SMOF_BIND_GLOBAL, 0x1000},
+        {"helper", 0xFFFF, SMOF_BIND_GLOBAL, 0x0}
+    };
+    const test_symbol_t b_symbols[] = {
+        {"helper", 0, SMOF_BIND_GLOBAL, 0x1000}
+    };
+    const test_symbol_t c_symbols[] = {
+        {"unused", 0, SMOF_BIND_GLOBAL, 0x1000}
+    };
+    const smof_relocation_t a_relocs[] = {
+        {0x8, 1, SMOF_RELOC_ABS32, 0}
+    };
+    stld_options_t options = stld_get_default_options();
+    stld_context_t* context;
+    stld_stats_t stats;
+    smof_header_t header;
+    smof_section_t section;
+    FILE* file;
+    
+    write_object(TEST_OBJECT_A, a_symbols, 2, a_relocs, 1);
+    write_object(TEST_OBJECT_B, b_symbols, 1, NULL, 0);
+    write_object(TEST_OBJECT_C, c_symbols, 1, NULL, 0);
+    
+    /* Without collection every section is linked */
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_B));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_C));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_link(test_context, TEST_OUTPUT));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_get_stats(test_context, &stats));
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)stats.sections_removed);
+    TEST_ASSERT_EQUAL_UINT(3, (uint32_t)stats.total_symbols);
+    
+    /* The section only "unused" lives in is unreachable from _start */
+    options.gc_sections = true;
+    context = stld_context_create(&options);
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(context, TEST_OBJECT_B));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(context, TEST_OBJECT_C));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_link(context, TEST_OUTPUT));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_get_stats(context, &stats));
+    TEST_ASSERT_EQUAL_UINT(3, (uint32_t)stats.total_sections);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)stats.sections_removed);
+    TEST_ASSERT_EQUAL_UINT(2, (uint32_t)stats.total_symbols);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)stats.relocations_processed);
+    stld_context_destroy(context);
+    
+    file = fopen(TEST_OUTPUT, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)fread(&header, sizeof(header), 1, file));
+    fseek(file, (long)header.section_table_offset, SEEK_SET);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)fread(&section, sizeof(section), 1, file));
+    fclose(file);
+    TEST_ASSERT_EQUAL_UINT(1, header.section_count);
+    TEST_ASSERT_EQUAL_UINT(2 * TEST_TEXT_SIZE, section.size);
+}
+
+void test_linker_folds_identical_code(void) {
+    const test_symbol_t a_symbols[] = {
+        {"_start", 0, SMOF_BIND_GLOBAL, 0x1000},
+        {"first", 0xFFFF, SMOF_BIND_GLOBAL, 0x0},
+        {"second", 0xFFFF, SMOF_BIND_GLOBAL, 0x0}
+    };
+    const test_symbol_t b_symbols[] = {
+        {"first", 0, SMOF_BIND_GLOBAL, 0x1004}
+    };
+    const test_symbol_t c_symbols[] = {
+        {"second", 0, SMOF_BIND_GLOBAL, 0x1004}
+    };
+    const smof_relocation_t a_relocs[] = {
+        {0x0, 1, SMOF_RELOC_ABS32, 0},
+        {0x4, 2, SMOF_RELOC_ABS32, 0}
+    };
+    stld_options_t options = stld_get_default_options();
+    stld_context_t* context;
+    stld_stats_t stats;
+    smof_header_t header;
+    smof_section_t section;
+    uint8_t fields[8];
+    FILE* file;
+    
+    /* The same body under two names, as with duplicated helpers */
+    write_object(TEST_OBJECT_A, a_symbols, 3, a_relocs, 2);
+    write_object(TEST_OBJECT_B, b_symbols, 1, NULL, 0);
+    write_object(TEST_OBJECT_C, c_symbols, 1, NULL, 0);
+    
+    options.optimize = STLD_OPTIMIZE_BALANCED;
+    context = stld_context_create(&options);
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(context, TEST_OBJECT_B));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(context, TEST_OBJECT_C));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_link(context, TEST_OUTPUT));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_get_stats(context, &stats));
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)stats.sections_folded);
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)stats.sections_removed);
+    stld_context_destroy(context);
+    
+    file = fopen(TEST_OUTPUT, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)fread(&header, sizeof(header), 1, file));
+    fseek(file, (long)header.section_table_offset, SEEK_SET);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)fread(&section, sizeof(section), 1, file));
+    fseek(file, (long)section.file_offset, SEEK_SET);
+    TEST_ASSERT_EQUAL_UINT(8, (uint32_t)fread(fields, 1, sizeof(fields), file));
+    fclose(file);
+    
+    /* Only one copy is written and both references land in it */
+    TEST_ASSERT_EQUAL_UINT(2 * TEST_TEXT_SIZE, section.size);
+    TEST_ASSERT_EQUAL_HEX32(0x1000 + TEST_TEXT_SIZE + 4, (uint32_t)fields[0] |
+                            ((uint32_t)fields[1] << 8) | ((uint32_t)fields[2] << 16) |
+                            ((uint32_t)fields[3] << 24));
+    TEST_ASSERT_EQUAL_HEX32(0x1000 + TEST_TEXT_SIZE + 4, (uint32_t)fields[4] |
+                            ((uint32_t)fields[5] << 8) | ((uint32_t)fields[6] << 16) |
+                            ((uint32_t)fields[7] << 24));
+}
+
+void test_linker_incremental_relink(void) {
+    const test_symbol_t a_symbols[] = {
+        {"_start", 0, SMOF_BIND_GLOBAL, 0x1000},
+        {"helper", 0xFFFF, SMOF_BIND_GLOBAL, 0x0}
+    };
+    const test_symbol_t b_symbols[] = {
+        {"helper", 0, SMOF_BIND_GLOBAL, 0x1004}
+    };
+    const test_symbol_t b_moved_symbols[] = {
+        {"helper", 0, SMOF_BIND_GLOBAL, 0x1008}
+    };
+    const smof_relocation_t first_relocs[] = {
+        {0x8, 1, SMOF_RELOC_ABS32, 0}
+    };
+    const smof_relocation_t second_relocs[] = {
+        {0x0, 1, SMOF_RELOC_ABS32, 0}
+    };
+    stld_options_t options = stld_get_default_options();
+    stld_stats_t stats;
+    FILE* file;
+    
+    options.incremental = true;
+    write_object(TEST_OBJECT_A, a_symbols, 2, first_relocs, 1);
+    write_object(TEST_OBJECT_B, b_symbols, 1, NULL, 0);
+    
+    /* The first link is full and leaves a cache behind */
+    link_pair(&options, &stats);
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)stats.inputs_reused);
+    file = fopen(TEST_CACHE, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    fclose(file);
+    
+    /* Nothing changed: no input is loaded or patched */
+    link_pair(&options, &stats);
+    TEST_ASSERT_EQUAL_UINT(2, (uint32_t)stats.inputs_reused);
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)stats.relocations_processed);
+    
+    /* New relocations keep the layout: only A is re-patched in place */
+    write_object(TEST_OBJECT_A, a_symbols, 2, second_relocs, 1);
+    touch_later(TEST_OBJECT_A);
+    link_pair(&options, &stats);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)stats.inputs_reused);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)stats.relocations_processed);
+    TEST_ASSERT_EQUAL_HEX32(0x1000 + TEST_TEXT_SIZE + 4, read_output_word(0x0));
+    TEST_ASSERT_EQUAL_HEX32(0, read_output_word(0x8));
+    
+    /* A moved symbol changes the layout others depend on: full relink */
+    write_object(TEST_OBJECT_B, b_moved_symbols, 1, NULL, 0);
+    touch_later(TEST_OBJECT_B);
+    link_pair(&options, &stats);
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)stats.inputs_reused);
+    TEST_ASSERT_EQUAL_HEX32(0x1000 + TEST_TEXT_SIZE + 8, read_output_word(0x0));
+}
+
+void test_linker_pulls_library_members(void) {
+    const test_symbol_t a_symbols[] = {
+        {"_start", 0, SMOF_BIND_GLOBAL, 0x1000},
+        {"helper", 0xFFFF, SMOF_BIND_GLOBAL, 0x0}
+    };
+    const test_symbol_t b_symbols[] = {
+        {"helper", 0, SMOF_BIND_GLOBAL, 0x1004},
+        {"util", 0xFFFF, SMOF_BIND_GLOBAL, 0x0}
+    };
+    const test_symbol_t c_symbols[] = {
+        {"util", 0, SMOF_BIND_GLOBAL, 0x1000}
+    };
+    const test_symbol_t d_symbols[] = {
+        {"unused", 0, SMOF_BIND_GLOBAL, 0x1000}
+    };
+    const smof_relocation_t a_relocs[] = {
+        {0x0, 1, SMOF_RELOC_ABS32, 0}
+    };
+    const smof_relocation_t b_relocs[] = {
+        {0x8, 1, SMOF_RELOC_ABS32, 0}
+    };
+    const char* members[] = {TEST_OBJECT_D, TEST_OBJECT_C, TEST_OBJECT_B};
+    star_options_t star_options = star_get_default_options();
+    star_context_t* archiver;
+    stld_stats_t stats;
+    
+    write_object(TEST_OBJECT_A, a_symbols, 2, a_relocs, 1);
+    write_object(TEST_OBJECT_B, b_symbols, 2, b_relocs, 1);
+    write_object(TEST_OBJECT_C, c_symbols, 1, NULL, 0);
+    write_object(TEST_OBJECT_D, d_symbols, 1, NULL, 0);
+    
+    /* Members are indexed and read back through LZ4 */
+    star_options.create_index = true;
+    star_options.compression = STAR_COMPRESS_LZ4;
+    archiver = star_context_create(&star_options);
+    TEST_ASSERT_NOT_NULL(archiver);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, star_create_archive(archiver, TEST_LIBRARY, members, 3));
+    star_context_destroy(archiver);
+    
+    /* helper pulls in B, whose reference to util then pulls in C */
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_library(test_context, "stld_test"));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_library_path(test_context, "/tmp"));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_link(test_context, TEST_OUTPUT));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_get_stats(test_context, &stats));
+    
+    /* D defines nothing needed and is never loaded */
+    TEST_ASSERT_EQUAL_UINT(2, (uint32_t)stats.members_loaded);
+    TEST_ASSERT_EQUAL_UINT(3, (uint32_t)stats.input_files);
+    TEST_ASSERT_EQUAL_HEX32(0x1000 + TEST_TEXT_SIZE + 4, read_output_word(0x0));
+    TEST_ASSERT_EQUAL_HEX32(0x1000 + 2 * TEST_TEXT_SIZE, read_output_word(TEST_TEXT_SIZE + 0x8));
+}
+
+void test_linker_missing_library(void) {
+    const test_symbol_t a_symbols[] = {
+        {"_start", 0, SMOF_BIND_GLOBAL, 0x1000}
+    };
+    
+    write_object(TEST_OBJECT_A, a_symbols, 1, NULL, 0);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_library_path(test_context, "/tmp"));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_library(test_context, "stld_missing"));
+    TEST_ASSERT_EQUAL_INT(ERROR_FILE_NOT_FOUND, stld_link(test_context, TEST_OUTPUT));
+}
+
+void test_linker_phase_stats(void) {
+    const test_symbol_t a_symbols[] = {
+        {"_start", 0, SMOF_BIND_GLOBAL, 0x1000},
+        {"helper", 0xFFFF, SMOF_BIND_GLOBAL, 0x0}
+    };
+    const smof_relocation_t a_relocs[] = {
+        {0x8, 1, SMOF_RELOC_ABS32, 0}
+    };
+    const test_symbol_t b_symbols[] = {
+        {"helper", 0, SMOF_BIND_GLOBAL, 0x1040}
+    };
+    stld_stats_t stats;
+    double phase_total = 0.0;
+    size_t peak = 0;
+    int phase;
+    
+    write_object(TEST_OBJECT_A, a_symbols, 2, a_relocs, 1);
+    write_object(TEST_OBJECT_B, b_symbols, 1, NULL, 0);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_B));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_link(test_context, TEST_OUTPUT));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_get_stats(test_context, &stats));
+    
+    /* Every phase ran and the phases fit inside the whole link */
+    for (phase = 0; phase < STLD_PHASE_COUNT; phase++) {
+        TEST_ASSERT_TRUE(stats.phases[phase].time >= 0.0);
+        TEST_ASSERT_TRUE(stats.phases[phase].peak_memory > 0);
+        phase_total += stats.phases[phase].time;
+        if (stats.phases[phase].peak_memory > peak) {
+            peak = stats.phases[phase].peak_memory;
+        }
+    }
+    TEST_ASSERT_TRUE(stats.link_time > 0.0);
+    TEST_ASSERT_TRUE(phase_total <= stats.link_time);
+    TEST_ASSERT_TRUE(stats.memory_used >= peak);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)stats.relocations_processed);
+    
+    TEST_ASSERT_EQUAL_STRING("load", stld_phase_name(STLD_PHASE_LOAD));
+    TEST_ASSERT_EQUAL_STRING("write", stld_phase_name(STLD_PHASE_WRITE));
+    TEST_ASSERT_EQUAL_STRING("unknown", stld_phase_name(STLD_PHASE_COUNT));
+}
+
+void test_linker_writes_map_file(void) {
+    const test_symbol_t a_symbols[] = {
+        {"_start", 0, SMOF_BIND_GLOBAL, 0x1000},
+        {"helper", 0xFFFF, SMOF_BIND_GLOBAL, 0x0}
+    };
+    const smof_relocation_t a_relocs[] = {
+        {0x8, 1, SMOF_RELOC_ABS32, 0}
+    };
+    const test_symbol_t b_symbols[] = {
+        {"helper", 0, SMOF_BIND_GLOBAL, 0x1040}
+    };
+    stld_options_t options = stld_get_default_options();
+    stld_context_t* context;
+    char map[4096];
+    const char* a_text;
+    const char* b_text;
+    size_t size;
+    FILE* file;
+    
+    write_object(TEST_OBJECT_A, a_symbols, 2, a_relocs, 1);
+    write_object(TEST_OBJECT_B, b_symbols, 1, NULL, 0);
+    
+    /* Without a map file name the map goes next to the output */
+    options.generate_map = true;
+    context = stld_context_create(&options);
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(context, TEST_OBJECT_B));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_link(context, TEST_OUTPUT));
+    stld_context_destroy(context);
+    
+    file = fopen(TEST_MAP, "r");
+    TEST_ASSERT_NOT_NULL(file);
+    size = fread(map, 1, sizeof(map) - 1, file);
+    fclose(file);
+    map[size] = '\0';
+    
+    /* Each input section is followed by the symbols it defines */
+    a_text = strstr(map, "0x00001000  0x00000010  " TEST_OBJECT_A "(.text)");
+    b_text = strstr(map, "0x00001010  0x00000010  " TEST_OBJECT_B "(.text)");
+    TEST_ASSERT_NOT_NULL(a_text);
+    TEST_ASSERT_NOT_NULL(b_text);
+    TEST_ASSERT_TRUE(a_text < strstr(map, "_start"));
+    TEST_ASSERT_TRUE(strstr(map, "_start") < b_text);
+    TEST_ASSERT_TRUE(b_text < strstr(map, "    helper"));
+}
+
+void test_linker_script_placement(void) {
+    const test_symbol_t a_symbols[] = {
+        {"_start", 0, SMOF_BIND_GLOBAL, 0x1000},
+        {"helper", 0xFFFF, SMOF_BIND_GLOBAL, 0x0}
+    };
+    const smof_relocation_t a_relocs[] = {
+        {0x8, 1, SMOF_RELOC_ABS32, 0}
+    };
+    const test_symbol_t b_symbols[] = {
+        {"helper", 0, SMOF_BIND_GLOBAL, 0x1004}
+    };
+    stld_options_t options = stld_get_default_options();
+    stld_context_t* context;
+    smof_header_t header;
+    smof_section_t section;
+    FILE* file;
+    
+    write_object(TEST_OBJECT_A, a_symbols, 2, a_relocs, 1);
+    write_object(TEST_OBJECT_B, b_symbols, 1, NULL, 0);
+    file = fopen(TEST_SCRIPT, "w");
+    TEST_ASSERT_NOT_NULL(file);
+    fputs("ENTRY(helper)\n"
+          "SECTIONS {\n"
+          "    . = 0x8000;\n"
+          "    .text : { *(.text .text.*) }\n"
+          "    /DISCARD/ : { *(.comment) }\n"
+          "}\n", file);
+    fclose(file);
+    
+    options.script_file = TEST_SCRIPT;
+    link_pair(&options, &(stld_stats_t){0});
+    
+    /* The script places .text and names the entry symbol */
+    file = fopen(TEST_OUTPUT, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)fread(&header, sizeof(header), 1, file));
+    fseek(file, (long)header.section_table_offset, SEEK_SET);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)fread(&section, sizeof(section), 1, file));
+    fclose(file);
+    TEST_ASSERT_EQUAL_HEX32(0x8000, section.virtual_addr);
+    TEST_ASSERT_EQUAL_HEX32(0x8000 + TEST_TEXT_SIZE + 0x4, header.entry_point);
+    TEST_ASSERT_EQUAL_HEX32(0x8000 + TEST_TEXT_SIZE + 0x4, read_output_word(0x8));
+    
+    /* Script errors fail the link before any input is read */
+    file = fopen(TEST_SCRIPT, "w");
+    TEST_ASSERT_NOT_NULL(file);
+    fputs("SECTIONS { .text { *(.text) } }\n", file);
+    fclose(file);
+    context = stld_context_create(&options);
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SCRIPT_SYNTAX, stld_link(context, TEST_OUTPUT));
+    stld_context_destroy(context);
+}
+
+void test_linker_partial_link(void) {
+    const test_symbol_t a_symbols[] = {
+        {"main", 0, SMOF_BIND_GLOBAL, 0x1000},
+        {"helper", 0xFFFF, SMOF_BIND_GLOBAL, 0x0},
+        {"extern_fn", 0xFFFF, SMOF_BIND_GLOBAL, 0x0}
+    };
+    const smof_relocation_t a_relocs[] = {
+        {0xC, 2, SMOF_RELOC_REL32, 0},
+        {0x8, 1, SMOF_RELOC_ABS32, 0},
+        {0x4, 1, SMOF_RELOC_REL32, 0},
+        {0x8, 1, SMOF_RELOC_ABS32, 0}
+    };
+    const test_symbol_t b_symbols[] = {
+        {"helper", 0, SMOF_BIND_GLOBAL, 0x1004}
+    };
+    const test_symbol_t c_symbols[] = {
+        {"extern_fn", 0, SMOF_BIND_GLOBAL, 0x1008}
+    };
+    stld_options_t options = stld_get_default_options();
+    smof_relocation_t relocs[2];
+    smof_header_t header;
+    stld_stats_t stats;
+    stld_context_t* context;
+    FILE* file;
+    
+    write_object(TEST_OBJECT_A, a_symbols, 3, a_relocs, 4);
+    write_object(TEST_OBJECT_B, b_symbols, 1, NULL, 0);
+    write_object(TEST_OBJECT_C, c_symbols, 1, NULL, 0);
+    
+    /* Pre-link A and B; extern_fn stays undefined */
+    options.output_type = STLD_OUTPUT_OBJECT;
+    context = stld_context_create(&options);
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(context, TEST_OBJECT_B));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_link(context, TEST_OBJECT_D));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_get_stats(context, &stats));
+    stld_context_destroy(context);
+    
+    /* The call to helper is final; the rest is kept once, in offset order */
+    TEST_ASSERT_EQUAL_UINT(2, (uint32_t)stats.relocations_kept);
+    file = fopen(TEST_OBJECT_D, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)fread(&header, sizeof(header), 1, file));
+    TEST_ASSERT_EQUAL_UINT(2, header.reloc_count);
+    fseek(file, (long)header.reloc_table_offset, SEEK_SET);
+    TEST_ASSERT_EQUAL_UINT(2, (uint32_t)fread(relocs, sizeof(relocs[0]), 2, file));
+    fclose(file);
+    TEST_ASSERT_EQUAL_UINT(0, header.flags & SMOF_FLAG_EXECUTABLE);
+    TEST_ASSERT_EQUAL_HEX32(0, header.entry_point);
+    TEST_ASSERT_EQUAL_HEX32(0x8, relocs[0].offset);
+    TEST_ASSERT_EQUAL_UINT(SMOF_RELOC_ABS32, relocs[0].type);
+    TEST_ASSERT_EQUAL_HEX32(0xC, relocs[1].offset);
+    TEST_ASSERT_EQUAL_UINT(SMOF_RELOC_REL32, relocs[1].type);
+    TEST_ASSERT_EQUAL_UINT(0, relocs[1].section_index);
+    
+    /* Linked after C, the pre-linked .text moves up by one input */
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_C));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_D));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_link(test_context, TEST_OUTPUT));
+    TEST_ASSERT_EQUAL_HEX32(0xC, read_output_word(TEST_TEXT_SIZE + 0x4));
+    TEST_ASSERT_EQUAL_HEX32(0x1000 + 2 * TEST_TEXT_SIZE + 0x4, read_output_word(TEST_TEXT_SIZE + 0x8));
+    TEST_ASSERT_EQUAL_HEX32((uint32_t)(0x1008 - (0x1000 + TEST_TEXT_SIZE + 0xC) - 4),
+                            read_output_word(TEST_TEXT_SIZE + 0xC));
+}
+
+/* Objects from the SMOF builder load and link like hand-written ones */
+void test_linker_links_built_objects(void) {
+    uint8_t text[TEST_TEXT_SIZE];
+    smof_context_t ctx;
+    const smof_header_t* header;
+    const smof_section_t* section;
+    stld_stats_t stats;
+    uint8_t* image;
+    char name[32];
+    size_t size;
+    FILE* file;
+    uint32_t i;
+    
+    memset(text, 0xAB, sizeof(text));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, smof_init_context(&ctx));
+    ctx.header.flags = SMOF_FLAG_LITTLE_ENDIAN;
+    TEST_ASSERT_EQUAL_INT(0, smof_add_section(&ctx, ".text", 0x1000, TEST_TEXT_SIZE, 0,
+                                              SMOF_SECT_EXECUTABLE | SMOF_SECT_LOADABLE, 3,
+                                              text));
+    TEST_ASSERT_EQUAL_INT(1, smof_add_section(&ctx, ".bss", 0x2000, 64, 0,
+                                              SMOF_SECT_ZERO_FILL | SMOF_SECT_WRITABLE, 2,
+                                              NULL));
+    TEST_ASSERT_EQUAL_INT(0, smof_add_symbol(&ctx, "main", 0, 0, 0, SMOF_SYM_FUNC,
+                                             SMOF_BIND_GLOBAL));
+    TEST_ASSERT_EQUAL_INT(1, smof_add_symbol(&ctx, "helper", 0, 0, 0xFFFF, SMOF_SYM_FUNC,
+                                             SMOF_BIND_GLOBAL));
+    TEST_ASSERT_EQUAL_INT(0, smof_add_relocation(&ctx, 0x8, 1, SMOF_RELOC_ABS32, 0));
+    
+    /* Names are stored once, and every table outgrows its first allocation */
+    TEST_ASSERT_EQUAL_UINT(ctx.symbols[1].name_offset, smof_add_string(&ctx, "helper"));
+    TEST_ASSERT_EQUAL_UINT(0, smof_add_string(&ctx, ""));
+    for (i = 0; i < 100; i++) {
+        snprintf(name, sizeof(name), "local_%u", (unsigned)(i % 50));
+        TEST_ASSERT_EQUAL_INT((int)i + 2, smof_add_symbol(&ctx, name, i, 0, 0, SMOF_SYM_OBJECT,
+                                                          SMOF_BIND_LOCAL));
+    }
+    TEST_ASSERT_EQUAL_UINT(ctx.symbols[2].name_offset, ctx.symbols[52].name_offset);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, smof_write_file(&ctx, TEST_OBJECT_A, false));
+    smof_cleanup_context(&ctx);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, smof_init_context(&ctx));
+    ctx.header.flags = SMOF_FLAG_LITTLE_ENDIAN;
+    TEST_ASSERT_EQUAL_INT(0, smof_add_section(&ctx, ".text", 0x1000, TEST_TEXT_SIZE, 0,
+                                              SMOF_SECT_EXECUTABLE | SMOF_SECT_LOADABLE, 0,
+                                              text));
+    TEST_ASSERT_EQUAL_INT(0, smof_add_symbol(&ctx, "helper", 0x1004, 0, 0, SMOF_SYM_FUNC,
+                                             SMOF_BIND_GLOBAL));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, smof_write_file(&ctx, TEST_OBJECT_B, false));
+    smof_cleanup_context(&ctx);
+    
+    /* The layout: tables, then data at its alignment; .bss has none */
+    file = fopen(TEST_OBJECT_A, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    fseek(file, 0, SEEK_END);
+    size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    image = malloc(size);
+    TEST_ASSERT_NOT_NULL(image);
+    TEST_ASSERT_EQUAL_UINT((uint32_t)size, (uint32_t)fread(image, 1, size, file));
+    fclose(file);
+    header = (const smof_header_t*)image;
+    section = (const smof_section_t*)(image + header->section_table_offset);
+    TEST_ASSERT_TRUE(smof_validate_header(header));
+    TEST_ASSERT_EQUAL_UINT(102, header->symbol_count);
+    TEST_ASSERT_EQUAL_UINT(0, section[0].file_offset % 8);
+    TEST_ASSERT_TRUE(section[0].file_offset >= header->string_table_offset +
+                                               header->string_table_size);
+    TEST_ASSERT_EQUAL_UINT((uint32_t)size, section[0].file_offset + TEST_TEXT_SIZE);
+    TEST_ASSERT_EQUAL_MEMORY(text, image + section[0].file_offset, TEST_TEXT_SIZE);
+    TEST_ASSERT_EQUAL_UINT(0, section[1].file_offset);
+    TEST_ASSERT_EQUAL_STRING(".bss", (const char*)image + header->string_table_offset +
+                                     section[1].name_offset);
+    free(image);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_B));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_link(test_context, TEST_OUTPUT));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_get_stats(test_context, &stats));
+    TEST_ASSERT_EQUAL_UINT(2, (uint32_t)stats.input_files);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)stats.relocations_processed);
+    TEST_ASSERT_EQUAL_HEX32(0x1000 + TEST_TEXT_SIZE + 4, read_output_word(0x8));
+}
+
+/* Whole file in a malloc'd buffer */
+static uint8_t* read_image(const char* filename, size_t* size) {
+    uint8_t* image;
+    FILE* file;
+    
+    file = fopen(filename, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    fseek(file, 0, SEEK_END);
+    *size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    image = malloc(*size);
+    TEST_ASSERT_NOT_NULL(image);
+    TEST_ASSERT_EQUAL_UINT((uint32_t)*size, (uint32_t)fread(image, 1, *size, file));
+    fclose(file);
+    
+    return image;
+}
+
+/* Tables in the other byte order, as a big-endian assembler writes them */
+void test_linker_links_foreign_byte_order(void) {
+    test_symbol_t symbols_a[] = {
+        {"main", 0, SMOF_BIND_GLOBAL, 0},
+        {"helper", 0xFFFF, SMOF_BIND_GLOBAL, 0},
+        {"data", 0xFFFF, SMOF_BIND_GLOBAL, 0}
+    };
+    test_symbol_t symbols_b[] = {
+        {"helper", 0, SMOF_BIND_GLOBAL, 4},
+        {"data", 0, SMOF_BIND_GLOBAL, 8}
+    };
+    smof_relocation_t relocs[] = {
+        {0, 1, SMOF_RELOC_ABS32, 0},
+        {4, 2, SMOF_RELOC_ABS32, 0},
+        {8, 1, SMOF_RELOC_ABS16, 0}
+    };
+    stld_options_t options = stld_get_default_options();
+    smof_header_t header;
+    stld_stats_t stats;
+    uint8_t* native;
+    uint8_t* image;
+    uint32_t words[3];
+    size_t size;
+    FILE* file;
+    
+    write_object(TEST_OBJECT_A, symbols_a, 3, relocs, 3);
+    write_object(TEST_OBJECT_B, symbols_b, 2, NULL, 0);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_B));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_link(test_context, TEST_OUTPUT));
+    words[0] = read_output_word(0);
+    words[1] = read_output_word(4);
+    words[2] = read_output_word(8) & 0xFFFF;
+    
+    /* Swapping is its own inverse, so swapping a native file gives a foreign one */
+    native = read_image(TEST_OBJECT_A, &size);
+    image = malloc(size);
+    TEST_ASSERT_NOT_NULL(image);
+    memcpy(image, native, size);
+    memcpy(&header, image, sizeof(header));
+    header.flags = SMOF_FLAG_BIG_ENDIAN;
+    memcpy(native, &header, sizeof(header));
+    memcpy(image, &header, sizeof(header));
+    TEST_ASSERT_FALSE(smof_is_foreign(image, size));
+    smof_swap_sections((smof_section_t*)(image + header.section_table_offset), 1);
+    smof_swap_symbols((smof_symbol_t*)(image + header.section_table_offset +
+                                       sizeof(smof_section_t)), 3);
+    smof_swap_relocations((smof_relocation_t*)(image + header.reloc_table_offset), 3);
+    smof_swap_header((smof_header_t*)image);
+    TEST_ASSERT_TRUE(smof_is_foreign(image, size));
+    
+    file = fopen(TEST_OBJECT_C, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    fwrite(image, 1, size, file);
+    fclose(file);
+    
+    /* Converting back restores every byte; a native image is left alone */
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, smof_convert_to_native(image, size));
+    TEST_ASSERT_EQUAL_MEMORY(native, image, (uint32_t)size);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, smof_convert_to_native(image, size));
+    TEST_ASSERT_EQUAL_MEMORY(native, image, (uint32_t)size);
+    
+    /* A truncated foreign image is rejected before anything is swapped */
+    memcpy(image, native, size);
+    smof_swap_header((smof_header_t*)image);
+    TEST_ASSERT_EQUAL_INT(ERROR_CORRUPT_HEADER,
+                          smof_convert_to_native(image, header.section_table_offset + 4));
+    TEST_ASSERT_TRUE(smof_is_foreign(image, size));
+    free(image);
+    free(native);
+    
+    stld_context_destroy(test_context);
+    test_context = stld_context_create(&options);
+    TEST_ASSERT_NOT_NULL(test_context);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_C));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_B));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_link(test_context, TEST_OUTPUT));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_get_stats(test_context, &stats));
+    TEST_ASSERT_EQUAL_UINT(3, (uint32_t)stats.relocations_processed);
+    TEST_ASSERT_EQUAL_UINT(words[0], read_output_word(0));
+    TEST_ASSERT_EQUAL_UINT(words[1], read_output_word(4));
+    TEST_ASSERT_EQUAL_UINT(words[2], read_output_word(8) & 0xFFFF);
+}
+
+/* A write_object file again, with the v2 header and relocation entries */
+static void write_as_v2(const char* source, const char* target, bool foreign) {
+    smof_header_v2_t header;
+    smof_layout_t layout;
+    smof_section_t section;
+    smof_relocation_t reloc;
+    smof_relocation_v2_t wide;
+    uint8_t* image;
+    uint32_t header_shift = (uint32_t)(sizeof(smof_header_v2_t) - sizeof(smof_header_t));
+    uint32_t shift;
+    size_t size;
+    FILE* file;
+    uint32_t i;
+    
+    image = read_image(source, &size);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, smof_read_layout(image, size, &layout));
+    shift = header_shift + layout.reloc_count *
+            (uint32_t)(sizeof(smof_relocation_v2_t) - sizeof(smof_relocation_t));
+    
+    header = (smof_header_v2_t) {
+        .magic = SMOF_MAGIC,
+        .version = SMOF_VERSION_2,
+        .flags = SMOF_FLAG_LITTLE_ENDIAN,
+        .section_count = layout.section_count,
+        .symbol_count = layout.symbol_count,
+        .reloc_count = layout.reloc_count,
+        .string_table_size = layout.string_table_size,
+        .string_table_offset = layout.string_table_offset + shift,
+        .section_table_offset = layout.section_table_offset + header_shift,
+        .reloc_table_offset = layout.reloc_count > 0 ? layout.reloc_table_offset + header_shift : 0
+    };
+    if (foreign) {
+        smof_swap_header_v2(&header);
+    }
+    
+    file = fopen(target, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    fwrite(&header, sizeof(header), 1, file);
+    
+    for (i = 0; i < layout.section_count; i++) {
+        memcpy(&section, image + layout.section_table_offset + i * sizeof(section), sizeof(section));
+        section.file_offset += section.file_offset != 0 ? shift : 0;
+        if (foreign) {
+            smof_swap_sections(&section, 1);
+        }
+        fwrite(&section, sizeof(section), 1, file);
+    }
+    
+    if (foreign) {
+        smof_swap_symbols((smof_symbol_t*)(image + layout.symbol_table_offset), layout.symbol_count);
+    }
+    fwrite(image + layout.symbol_table_offset, sizeof(smof_symbol_t), layout.symbol_count, file);
+    
+    for (i = 0; i < layout.reloc_count; i++) {
+        memcpy(&reloc, image + layout.reloc_table_offset + i * sizeof(reloc), sizeof(reloc));
+        wide = (smof_relocation_v2_t) {
+            .offset = reloc.offset,
+            .symbol_index = reloc.symbol_index,
+            .section_index = reloc.section_index,
+            .type = reloc.type
+        };
+        if (foreign) {
+            smof_swap_relocations_v2(&wide, 1);
+        }
+        fwrite(&wide, sizeof(wide), 1, file);
+    }
+    
+    /* Strings and section data move as they are */
+    fwrite(image + layout.string_table_offset, 1, size - layout.string_table_offset, file);
+    fclose(file);
+    free(image);
+}
+
+/* v2 inputs, in either byte order, link exactly like their v1 originals */
+void test_linker_links_v2_objects(void) {
+    test_symbol_t symbols_a[] = {
+        {"main", 0, SMOF_BIND_GLOBAL, 0},
+        {"helper", 0xFFFF, SMOF_BIND_GLOBAL, 0}
+    };
+    test_symbol_t symbols_b[] = {
+        {"helper", 0, SMOF_BIND_GLOBAL, 4}
+    };
+    smof_relocation_t relocs[] = {
+        {0, 1, SMOF_RELOC_ABS32, 0},
+        {8, 1, SMOF_RELOC_ABS16, 0}
+    };
+    const char* inputs[] = {TEST_OBJECT_C, TEST_OBJECT_D};
+    stld_options_t options = stld_get_default_options();
+    stld_stats_t stats;
+    uint32_t words[2];
+    size_t i;
+    
+    write_object(TEST_OBJECT_A, symbols_a, 2, relocs, 2);
+    write_object(TEST_OBJECT_B, symbols_b, 1, NULL, 0);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_B));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_link(test_context, TEST_OUTPUT));
+    words[0] = read_output_word(0);
+    words[1] = read_output_word(8) & 0xFFFF;
+    
+    write_as_v2(TEST_OBJECT_A, TEST_OBJECT_C, false);
+    write_as_v2(TEST_OBJECT_A, TEST_OBJECT_D, true);
+    
+    for (i = 0; i < 2; i++) {
+        stld_context_destroy(test_context);
+        test_context = stld_context_create(&options);
+        TEST_ASSERT_NOT_NULL(test_context);
+        TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, inputs[i]));
+        TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_B));
+        TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_link(test_context, TEST_OUTPUT));
+        TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_get_stats(test_context, &stats));
+        TEST_ASSERT_EQUAL_UINT(2, (uint32_t)stats.relocations_processed);
+        TEST_ASSERT_EQUAL_UINT(words[0], read_output_word(0));
+        TEST_ASSERT_EQUAL_UINT(words[1], read_output_word(8) & 0xFFFF);
+    }
+}
+
+/* Link A and B against the library through a shared cache */
+static void link_cached(stld_cache_t* cache, stld_stats_t* stats) {
+    stld_options_t options = stld_get_default_options();
+    stld_context_t* context = stld_context_create(&options);
+    
+    TEST_ASSERT_NOT_NULL(context);
+    stld_set_cache(context, cache);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(context, TEST_OBJECT_B));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_library_path(context, "/tmp"));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_library(context, "stld_test"));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_link(context, TEST_OUTPUT));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_get_stats(context, stats));
+    stld_context_destroy(context);
+}
+
+void test_linker_shared_cache(void) {
+    const test_symbol_t a_symbols[] = {
+        {"_start", 0, SMOF_BIND_GLOBAL, 0x1000},
+        {"helper", 0xFFFF, SMOF_BIND_GLOBAL, 0x0},
+        {"util", 0xFFFF, SMOF_BIND_GLOBAL, 0x0}
+    };
+    const test_symbol_t b_symbols[] = {
+        {"helper", 0, SMOF_BIND_GLOBAL, 0x1004}
+    };
+    const test_symbol_t b_moved_symbols[] = {
+        {"helper", 0, SMOF_BIND_GLOBAL, 0x1008}
+    };
+    const test_symbol_t c_symbols[] = {
+        {"util", 0, SMOF_BIND_GLOBAL, 0x1000}
+    };
+    const smof_relocation_t a_relocs[] = {
+        {0x0, 1, SMOF_RELOC_ABS32, 0},
+        {0x8, 2, SMOF_RELOC_ABS32, 0}
+    };
+    const char* members[] = {TEST_OBJECT_C};
+    star_options_t star_options = star_get_default_options();
+    star_context_t* archiver;
+    stld_cache_t* cache;
+    stld_cache_stats_t cache_stats;
+    stld_stats_t stats;
+    
+    write_object(TEST_OBJECT_A, a_symbols, 3, a_relocs, 2);
+    write_object(TEST_OBJECT_B, b_symbols, 1, NULL, 0);
+    write_object(TEST_OBJECT_C, c_symbols, 1, NULL, 0);
+    star_options.create_index = true;
+    star_options.compression = STAR_COMPRESS_LZ4;
+    archiver = star_context_create(&star_options);
+    TEST_ASSERT_NOT_NULL(archiver);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, star_create_archive(archiver, TEST_LIBRARY, members, 1));
+    star_context_destroy(archiver);
+    
+    cache = stld_cache_create(0);
+    TEST_ASSERT_NOT_NULL(cache);
+    
+    /* The first link loads both objects and the library */
+    link_cached(cache, &stats);
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)stats.inputs_cached);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)stats.members_loaded);
+    TEST_ASSERT_EQUAL_HEX32(0x1000 + TEST_TEXT_SIZE + 4, read_output_word(0x0));
+    TEST_ASSERT_EQUAL_HEX32(0x1000 + 2 * TEST_TEXT_SIZE, read_output_word(0x8));
+    stld_cache_get_stats(cache, &cache_stats);
+    TEST_ASSERT_EQUAL_UINT(3, (uint32_t)cache_stats.misses);
+    TEST_ASSERT_EQUAL_UINT(3, (uint32_t)cache_stats.entries);
+    
+    /* Nothing changed: every input comes from the cache, with the same result */
+    link_cached(cache, &stats);
+    TEST_ASSERT_EQUAL_UINT(3, (uint32_t)stats.inputs_cached);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)stats.members_loaded);
+    TEST_ASSERT_EQUAL_HEX32(0x1000 + TEST_TEXT_SIZE + 4, read_output_word(0x0));
+    TEST_ASSERT_EQUAL_HEX32(0x1000 + 2 * TEST_TEXT_SIZE, read_output_word(0x8));
+    stld_cache_get_stats(cache, &cache_stats);
+    TEST_ASSERT_EQUAL_UINT(3, (uint32_t)cache_stats.hits);
+    
+    /* A new timestamp on the same bytes is checked, not reloaded */
+    touch_later(TEST_OBJECT_A);
+    link_cached(cache, &stats);
+    TEST_ASSERT_EQUAL_UINT(2, (uint32_t)stats.inputs_cached);
+    stld_cache_get_stats(cache, &cache_stats);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)cache_stats.revalidated);
+    TEST_ASSERT_EQUAL_UINT(3, (uint32_t)cache_stats.misses);
+    
+    /* Changed contents replace the entry */
+    write_object(TEST_OBJECT_B, b_moved_symbols, 1, NULL, 0);
+    touch_later(TEST_OBJECT_B);
+    link_cached(cache, &stats);
+    TEST_ASSERT_EQUAL_UINT(2, (uint32_t)stats.inputs_cached);
+    TEST_ASSERT_EQUAL_HEX32(0x1000 + TEST_TEXT_SIZE + 8, read_output_word(0x0));
+    stld_cache_get_stats(cache, &cache_stats);
+    TEST_ASSERT_EQUAL_UINT(4, (uint32_t)cache_stats.misses);
+    TEST_ASSERT_EQUAL_UINT(3, (uint32_t)cache_stats.entries);
+    
+    stld_cache_destroy(cache);
+}
+
+/* Writes through one mapping of a cached file never reach the cache or another mapping */
+static void check_private_maps(const uint8_t* cached, uint8_t* first, const uint8_t* second,
+                               size_t size) {
+    TEST_ASSERT_EQUAL_MEMORY(cached, first, (uint32_t)size);
+    first[size - 1] ^= 0xFF;
+    TEST_ASSERT_EQUAL_MEMORY(cached, second, (uint32_t)size);
+    first[size - 1] ^= 0xFF;
+}
+
+void test_linker_cache_maps_private_copies(void) {
+    const test_symbol_t b_symbols[] = {
+        {"helper", 0, SMOF_BIND_GLOBAL, 0x1004}
+    };
+    const char* members[] = {TEST_OBJECT_B};
+    star_options_t star_options = star_get_default_options();
+    star_context_t* archiver;
+    stld_cache_t* cache;
+    cache_entry_t* entry;
+    uint8_t* expected;
+    void* maps[2];
+    size_t size;
+    FILE* file;
+    bool hit;
+    
+    write_object(TEST_OBJECT_B, b_symbols, 1, NULL, 0);
+    star_options.create_index = true;
+    star_options.compression = STAR_COMPRESS_LZ4;
+    archiver = star_context_create(&star_options);
+    TEST_ASSERT_NOT_NULL(archiver);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, star_create_archive(archiver, TEST_LIBRARY, members, 1));
+    star_context_destroy(archiver);
+    
+    file = fopen(TEST_OBJECT_B, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    fseek(file, 0, SEEK_END);
+    size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    expected = malloc(size);
+    TEST_ASSERT_NOT_NULL(expected);
+    TEST_ASSERT_EQUAL_UINT((uint32_t)size, (uint32_t)fread(expected, 1, size, file));
+    fclose(file);
+    
+    cache = stld_cache_create(0);
+    TEST_ASSERT_NOT_NULL(cache);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, object_cache_acquire(cache, TEST_OBJECT_B,
+                                                              CACHE_ENTRY_OBJECT, &entry, &hit));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, object_cache_map_object(entry, &maps[0]));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, object_cache_map_object(entry, &maps[1]));
+    object_cache_release(cache, entry);
+    check_private_maps(expected, maps[0], maps[1], size);
+    munmap(maps[0], size);
+    munmap(maps[1], size);
+    
+    /* A member is decoded once; the second mapping shares its pages */
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, object_cache_acquire(cache, TEST_LIBRARY,
+                                                              CACHE_ENTRY_LIBRARY, &entry, &hit));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, object_cache_map_member(cache, entry, 0, &maps[0]));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, object_cache_map_member(cache, entry, 0, &maps[1]));
+    object_cache_release(cache, entry);
+    check_private_maps(expected, maps[0], maps[1], size);
+    munmap(maps[0], size);
+    munmap(maps[1], size);
+    
+    stld_cache_destroy(cache);
+    free(expected);
+}
+
+void test_linker_builds_got(void) {
+    const test_symbol_t a_symbols[] = {
+        {"_start", 0, SMOF_BIND_GLOBAL, 0x1000},
+        {"helper", 0xFFFF, SMOF_BIND_GLOBAL, 0x0}
+    };
+    const test_symbol_t b_symbols[] = {
+        {"helper", 0, SMOF_BIND_GLOBAL, 0x1004}
+    };
+    const smof_relocation_t a_relocs[] = {
+        {0x0, 1, SMOF_RELOC_GOT, 0},
+        {0x4, 0, SMOF_RELOC_GOT, 0},
+        {0x8, 1, SMOF_RELOC_GOT, 0}
+    };
+    smof_section_t got;
+    uint32_t helper_slot;
+    uint32_t start_slot;
+    
+    write_object(TEST_OBJECT_A, a_symbols, 2, a_relocs, 3);
+    write_object(TEST_OBJECT_B, b_symbols, 1, NULL, 0);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(test_context, TEST_OBJECT_B));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_link(test_context, TEST_OUTPUT));
+    
+    /* Both references to helper share a slot; each field holds a slot address */
+    read_section_word(1, 0, &got);
+    TEST_ASSERT_EQUAL_UINT(8, got.size);
+    TEST_ASSERT_TRUE((got.flags & SMOF_SECT_WRITABLE) != 0);
+    helper_slot = read_output_word(0x0);
+    start_slot = read_output_word(0x4);
+    TEST_ASSERT_EQUAL_HEX32(helper_slot, read_output_word(0x8));
+    TEST_ASSERT_TRUE(helper_slot != start_slot);
+    TEST_ASSERT_TRUE(helper_slot == got.virtual_addr || helper_slot == got.virtual_addr + 4);
+    TEST_ASSERT_TRUE(start_slot == got.virtual_addr || start_slot == got.virtual_addr + 4);
+    
+    /* The slots hold the symbols' final addresses */
+    TEST_ASSERT_EQUAL_HEX32(0x1000 + TEST_TEXT_SIZE + 4,
+                            read_section_word(1, helper_slot - got.virtual_addr, &got));
+    TEST_ASSERT_EQUAL_HEX32(0x1000, read_section_word(1, start_slot - got.virtual_addr, &got));
+}
+
+/* Write the test script with .text placed at address */
+static void write_script(uint32_t address) {
+    FILE* file = fopen(TEST_SCRIPT, "w");
+    
+    TEST_ASSERT_NOT_NULL(file);
+    fprintf(file, "SECTIONS {\n    . = 0x%X;\n    .text : { *(.text) }\n}\n", address);
+    fclose(file);
+}
+
+/* Archive B as the test library */
+static void write_library(void) {
+    const char* members[] = {TEST_OBJECT_B};
+    star_options_t star_options = star_get_default_options();
+    star_context_t* archiver;
+    
+    star_options.create_index = true;
+    archiver = star_context_create(&star_options);
+    TEST_ASSERT_NOT_NULL(archiver);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, star_create_archive(archiver, TEST_LIBRARY, members, 1));
+    star_context_destroy(archiver);
+}
+
+/* Incrementally link A against the library under the test script */
+static void link_with_library(stld_stats_t* stats) {
+    stld_options_t options = stld_get_default_options();
+    stld_context_t* context;
+    
+    options.incremental = true;
+    options.script_file = TEST_SCRIPT;
+    context = stld_context_create(&options);
+    TEST_ASSERT_NOT_NULL(context);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_input_file(context, TEST_OBJECT_A));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_library_path(context, "/tmp"));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_add_library(context, "stld_test"));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_link(context, TEST_OUTPUT));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, stld_get_stats(context, stats));
+    stld_context_destroy(context);
+}
+
+void test_linker_incremental_dependencies(void) {
+    const test_symbol_t a_symbols[] = {
+        {"_start", 0, SMOF_BIND_GLOBAL, 0x1000},
+        {"helper", 0xFFFF, SMOF_BIND_GLOBAL, 0x0}
+    };
+    const test_symbol_t b_symbols[] = {
+        {"helper", 0, SMOF_BIND_GLOBAL, 0x1004}
+    };
+    const smof_relocation_t first_relocs[] = {
+        {0x0, 1, SMOF_RELOC_ABS32, 0}
+    };
+    const smof_relocation_t second_relocs[] = {
+        {0x8, 1, SMOF_RELOC_ABS32, 0}
+    };
+    stld_stats_t stats;
+    
+    write_object(TEST_OBJECT_A, a_symbols, 2, first_relocs, 1);
+    write_object(TEST_OBJECT_B, b_symbols, 1, NULL, 0);
+    write_library();
+    write_script(0x8000);
+    
+    /* The pulled-in member is cached with the named input */
+    link_with_library(&stats);
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)stats.inputs_reused);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)stats.members_loaded);
+    link_with_library(&stats);
+    TEST_ASSERT_EQUAL_UINT(2, (uint32_t)stats.inputs_reused);
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)stats.members_loaded);
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)stats.relocations_processed);
+    
+    /* New relocations in A are patched against the cached member */
+    write_object(TEST_OBJECT_A, a_symbols, 2, second_relocs, 1);
+    touch_later(TEST_OBJECT_A);
+    link_with_library(&stats);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)stats.inputs_reused);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)stats.relocations_processed);
+    TEST_ASSERT_EQUAL_HEX32(0x8000 + TEST_TEXT_SIZE + 4, read_output_word(0x8));
+    
+    /* A changed script relinks fully */
+    write_script(0x9000);
+    link_with_library(&stats);
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)stats.inputs_reused);
+    TEST_ASSERT_EQUAL_HEX32(0x9000 + TEST_TEXT_SIZE + 4, read_output_word(0x8));
+    
+    /* So does a rebuilt library */
+    write_library();
+    touch_later(TEST_LIBRARY);
+    link_with_library(&stats);
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)stats.inputs_reused);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)stats.members_loaded);
+    link_with_library(&stats);
+    TEST_ASSERT_EQUAL_UINT(2, (uint32_t)stats.inputs_reused);
+}
+
+int test_linker_main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_linker_resolves_cross_object_reference);
+    RUN_TEST(test_linker_writes_smof_output);
+    RUN_TEST(test_linker_relocation_index_out_of_range);
+    RUN_TEST(test_linker_undefined_reference);
+    RUN_TEST(test_linker_relocation_outside_section);
+    RUN_TEST(test_linker_duplicate_definition);
+    RUN_TEST(test_linker_invalid_file);
+    RUN_TEST(test_linker_truncated_object);
+    RUN_TEST(test_linker_parallel_load);
+    RUN_TEST(test_linker_memory_limit);
+    RUN_TEST(test_linker_gc_sections);
+    RUN_TEST(test_linker_folds_identical_code);
+    RUN_TEST(test_linker_incremental_relink);
+    RUN_TEST(test_linker_pulls_library_members);
+    RUN_TEST(test_linker_missing_library);
+    RUN_TEST(test_linker_phase_stats);
+    RUN_TEST(test_linker_writes_map_file);
+    RUN_TEST(test_linker_script_placement);
+    RUN_TEST(test_linker_partial_link);
+    RUN_TEST(test_linker_links_built_objects);
+    RUN_TEST(test_linker_links_foreign_byte_order);
+    RUN_TEST(test_linker_links_v2_objects);
+    RUN_TEST(test_linker_shared_cache);
+    RUN_TEST(test_linker_cache_maps_private_copies);
+    RUN_TEST(test_linker_builds_got);
+    RUN_TEST(test_linker_incremental_dependencies);
+    
+    return UNITY_END();
+}
+
+int main(void) {
+    return test_linker_main();
+}
@@ -0,0 +1,166 @@
+/* tests/test_map_file.c */
+#include "unity.h"
+#include "map_file.h"
+#include "memory.h"
+#include "error.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file test_map_file.c
+ * @brief Unit tests for the memory map writer
+ * @details Tests that inputs and symbols are listed under their output
+ * section in address order and that unplaced symbols and write failures
+ * are reported
+ */
+
+/* Function prototypes */
+void test_map_file_orders_by_address(void);
+void test_map_file_unplaced_symbols(void);
+void test_map_file_write_failure(void);
+int test_map_file_main(void);
+
+#define TEST_MAP_FILE "/tmp/stld_test.map"
+
+/* Test fixture data */
+static memory_pool_t* test_pool;
+static section_manager_t* test_sections;
+static symbol_table_t* test_symbols;
+static char* test_map;
+
+void setUp(void) {
+    test_pool = memory_pool_create_growable(0, 0);
+    test_sections = section_manager_create(test_pool);
+    test_symbols = symbol_table_create(0);
+    test_map = NULL;
+}
+
+void tearDown(void) {
+    free(test_map);
+    symbol_table_destroy(test_symbols);
+    section_manager_destroy(test_sections);
+    memory_pool_destroy(test_pool);
+    remove(TEST_MAP_FILE);
+}
+
+static void add_symbol(const char* name, uint16_t section_index, uint32_t value,
+                       symbol_binding_t binding) {
+    symbol_t symbol = {
+        .name = name,
+        .type = SYMBOL_TYPE_FUNCTION,
+        .binding = binding,
+        .visibility = SYMBOL_VISIBILITY_DEFAULT,
+        .section_index = section_index,
+        .value = value,
+        .size = 0
+    };
+    
+    TEST_ASSERT_TRUE(symbol_table_insert(test_symbols, &symbol) != SYMBOL_HANDLE_INVALID);
+}
+
+static const char* read_map(void) {
+    FILE* file = fopen(TEST_MAP_FILE, "rb");
+    long size;
+    
+    TEST_ASSERT_NOT_NULL(file);
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    test_map = malloc((size_t)size + 1);
+    TEST_ASSERT_NOT_NULL(test_map);
+    TEST_ASSERT_EQUAL_UINT((uint32_t)size, (uint32_t)fread(test_map, 1, (size_t)size, file));
+    test_map[size] = '\0';
+    fclose(file);
+    
+    return test_map;
+}
+
+/* Position of text in the map; fails the test when it is missing */
+static size_t find(const char* map, const char* text) {
+    const char* found = strstr(map, text);
+    
+    TEST_ASSERT_NOT_NULL(found);
+    return (size_t)(found - map);
+}
+
+void test_map_file_orders_by_address(void) {
+    static const uint8_t code[32] = {0};
+    map_input_t inputs[3];
+    section_id_t text;
+    section_id_t data;
+    const char* map;
+    
+    text = section_manager_create_section(test_sections, ".text", SECTION_TYPE_TEXT,
+                                          SECTION_FLAG_READABLE | SECTION_FLAG_EXECUTABLE);
+    data = section_manager_create_section(test_sections, ".data", SECTION_TYPE_DATA,
+                                          SECTION_FLAG_READABLE | SECTION_FLAG_WRITABLE);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          section_manager_add_data(test_sections, text, code, 16, 4, NULL));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          section_manager_add_data(test_sections, text, code, 16, 4, NULL));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          section_manager_add_data(test_sections, data, code, 8, 4, NULL));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, section_manager_calculate_layout(test_sections, 0x1000));
+    
+    /* Inputs and symbols arrive out of order */
+    inputs[0] = (map_input_t){"b.smof", ".text", 0x1010, 16, 0};
+    inputs[1] = (map_input_t){"a.smof", ".data", 0x1020, 8, 1};
+    inputs[2] = (map_input_t){"a.smof", ".text", 0x1000, 16, 0};
+    add_symbol("table", 1, 0x1020, SYMBOL_BINDING_GLOBAL);
+    add_symbol("helper", 0, 0x1018, SYMBOL_BINDING_WEAK);
+    add_symbol("_start", 0, 0x1000, SYMBOL_BINDING_GLOBAL);
+    add_symbol("loop", 0, 0x1004, SYMBOL_BINDING_LOCAL);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, map_file_write(TEST_MAP_FILE, "program", test_sections,
+                                                        test_symbols, inputs, 3));
+    map = read_map();
+    
+    TEST_ASSERT_TRUE(find(map, "Memory map of program") < find(map, "Section contents"));
+    TEST_ASSERT_TRUE(find(map, "0x00001000  0x00000020  0x00000004  R-X-") <
+                     find(map, "0x00001020  0x00000008  0x00000004  RW--"));
+    TEST_ASSERT_TRUE(find(map, "a.smof(.text)") < find(map, "_start"));
+    TEST_ASSERT_TRUE(find(map, "_start") < find(map, "loop (local)"));
+    TEST_ASSERT_TRUE(find(map, "loop (local)") < find(map, "b.smof(.text)"));
+    TEST_ASSERT_TRUE(find(map, "b.smof(.text)") < find(map, "helper (weak)"));
+    TEST_ASSERT_TRUE(find(map, "helper (weak)") < find(map, "\n.data"));
+    TEST_ASSERT_TRUE(find(map, "\n.data") < find(map, "a.smof(.data)"));
+    TEST_ASSERT_TRUE(find(map, "a.smof(.data)") < find(map, "table"));
+    TEST_ASSERT_NULL(strstr(map, "Symbols outside sections"));
+}
+
+void test_map_file_unplaced_symbols(void) {
+    const char* map;
+    
+    add_symbol("missing", SECTION_INDEX_UNDEFINED, 0, SYMBOL_BINDING_WEAK);
+    add_symbol("orphan", 7, 0x40, SYMBOL_BINDING_GLOBAL);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, map_file_write(TEST_MAP_FILE, "program", test_sections,
+                                                        test_symbols, NULL, 0));
+    map = read_map();
+    
+    TEST_ASSERT_TRUE(find(map, "Symbols outside sections") < find(map, "ABS     0x00000040"));
+    TEST_ASSERT_TRUE(find(map, "orphan") < find(map, "UNDEF   0x00000000"));
+    find(map, "missing (weak)");
+}
+
+void test_map_file_write_failure(void) {
+    TEST_ASSERT_EQUAL_INT(ERROR_FILE_IO, map_file_write("/nonexistent/dir/out.map", "program",
+                                                        test_sections, test_symbols, NULL, 0));
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_ARGUMENT, map_file_write(TEST_MAP_FILE, "program",
+                                                                 test_sections, NULL, NULL, 0));
+}
+
+int test_map_file_main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_map_file_orders_by_address);
+    RUN_TEST(test_map_file_unplaced_symbols);
+    RUN_TEST(test_map_file_write_failure);
+    
+    return UNITY_END();
+}
+
+int main(void) {
+    return test_map_file_main();
+}
@@ -26,6 +26,13 @@ void test_memory_pool_get_stats(void);
 void test_memory_pool_fragmentation(void);
 void test_memory_utility_functions(void);
 void test_memory_pool_inline_functions(void);
+void test_memory_pool_growable(void);
+void test_memory_pool_growable_limit(void);
+void test_memory_pool_growable_reset(void);
+void test_memory_pool_size_class_reuse(void);
+void test_memory_pool_mark_rewind(void);
+void test_memory_pool_extended_stats(void);
+void test_memory_pool_peak_reset(void);
 int test_memory_main(void);
 
 /* Test pool for testing */
@@ -224,6 +231,199 @@ void test_memory_pool_inline_functions(void) {
     TEST_ASSERT_FALSE(memory_pool_can_alloc(NULL, 64));
 }
 
+void test_memory_pool_growable(void) {
+    memory_pool_t* pool = memory_pool_create_growable(256, 0);
+    void* ptrs[64];
+    size_t i;
+    
+    TEST_ASSERT_NOT_NULL(pool);
+    TEST_ASSERT_EQUAL_UINT(256, (uint32_t)memory_pool_get_size(pool));
+    
+    /* Far more than one block, plus one oversized request */
+    for (i = 0; i < 64; i++) {
+        ptrs[i] = memory_pool_alloc(pool, 40);
+        TEST_ASSERT_NOT_NULL(ptrs[i]);
+        TEST_ASSERT_TRUE(memory_is_aligned(ptrs[i], MEMORY_POOL_ALIGN));
+        memset(ptrs[i], (int)i, 40);
+    }
+    TEST_ASSERT_NOT_NULL(memory_pool_alloc(pool, 1000));
+    
+    /* Earlier blocks are untouched by growth */
+    for (i = 0; i < 64; i++) {
+        TEST_ASSERT_EQUAL_UINT((uint8_t)i, ((uint8_t*)ptrs[i])[39]);
+    }
+    
+    TEST_ASSERT_TRUE(memory_pool_get_size(pool) > 256);
+    TEST_ASSERT_EQUAL_UINT(64 * 40 + 1000, (uint32_t)memory_pool_get_used(pool));
+    TEST_ASSERT_TRUE(memory_pool_can_alloc(pool, 1024 * 1024));
+    
+    memory_pool_destroy(pool);
+}
+
+void test_memory_pool_growable_limit(void) {
+    memory_pool_t* pool = memory_pool_create_growable(256, 1024);
+    size_t allocated = 0;
+    
+    TEST_ASSERT_NOT_NULL(pool);
+    
+    while (memory_pool_alloc(pool, 64) != NULL) {
+        allocated += 64;
+    }
+    
+    TEST_ASSERT_EQUAL_UINT(1024, (uint32_t)allocated);
+    TEST_ASSERT_TRUE(memory_pool_get_size(pool) <= 1024);
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)memory_pool_get_available(pool));
+    
+    /* A limit below the block size shrinks the first block */
+    memory_pool_destroy(pool);
+    pool = memory_pool_create_growable(4096, 512);
+    TEST_ASSERT_NOT_NULL(pool);
+    TEST_ASSERT_EQUAL_UINT(512, (uint32_t)memory_pool_get_size(pool));
+    memory_pool_destroy(pool);
+    
+    TEST_ASSERT_NULL(memory_pool_create_growable(256, 8));
+}
+
+void test_memory_pool_growable_reset(void) {
+    memory_pool_t* pool = memory_pool_create_growable(128, 0);
+    size_t i;
+    
+    TEST_ASSERT_NOT_NULL(pool);
+    
+    for (i = 0; i < 32; i++) {
+        TEST_ASSERT_NOT_NULL(memory_pool_alloc(pool, 64));
+    }
+    TEST_ASSERT_TRUE(memory_pool_get_size(pool) > 128);
+    
+    /* Reset drops the chained blocks and keeps the first one */
+    memory_pool_reset(pool);
+    TEST_ASSERT_EQUAL_UINT(128, (uint32_t)memory_pool_get_size(pool));
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)memory_pool_get_used(pool));
+    TEST_ASSERT_NOT_NULL(memory_pool_alloc(pool, 64));
+    
+    memory_pool_destroy(pool);
+}
+
+void test_memory_pool_size_class_reuse(void) {
+    memory_pool_t* pool = memory_pool_create_growable(512, 0);
+    void* a = memory_pool_alloc(pool, 40);
+    void* b = memory_pool_alloc(pool, 40);
+    void* c;
+    void* big;
+    size_t used;
+    
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_NOT_NULL(b);
+    used = memory_pool_get_used(pool);
+    
+    /* Same class comes back LIFO, other classes do not see it */
+    memory_pool_free_sized(pool, a, 40);
+    memory_pool_free_sized(pool, b, 36);
+    TEST_ASSERT_EQUAL_UINT((uint32_t)(used - 80), (uint32_t)memory_pool_get_used(pool));
+    
+    c = memory_pool_alloc(pool, 16);
+    TEST_ASSERT_TRUE(c != a && c != b);
+    TEST_ASSERT_TRUE(memory_pool_alloc(pool, 39) == b);
+    TEST_ASSERT_TRUE(memory_pool_alloc(pool, 40) == a);
+    
+    /* Large blocks are not recycled */
+    big = memory_pool_alloc(pool, 300);
+    TEST_ASSERT_NOT_NULL(big);
+    memory_pool_free_sized(pool, big, 300);
+    TEST_ASSERT_TRUE(memory_pool_alloc(pool, 300) != big);
+    
+    memory_pool_free_sized(NULL, a, 40);
+    memory_pool_free_sized(pool, NULL, 40);
+    memory_pool_destroy(pool);
+}
+
+void test_memory_pool_mark_rewind(void) {
+    memory_pool_t* pool = memory_pool_create_growable(256, 0);
+    memory_pool_mark_t mark;
+    void* keep;
+    void* first_after;
+    size_t i;
+    
+    keep = memory_pool_alloc(pool, 64);
+    TEST_ASSERT_NOT_NULL(keep);
+    memset(keep, 0xAB, 64);
+    
+    mark = memory_pool_mark(pool);
+    first_after = memory_pool_alloc(pool, 32);
+    
+    /* Temporaries spill into several chained blocks */
+    for (i = 0; i < 40; i++) {
+        TEST_ASSERT_NOT_NULL(memory_pool_alloc(pool, 48));
+    }
+    memory_pool_free_sized(pool, first_after, 32);
+    TEST_ASSERT_TRUE(memory_pool_get_size(pool) > 256);
+    
+    memory_pool_rewind(pool, &mark);
+    TEST_ASSERT_EQUAL_UINT(256, (uint32_t)memory_pool_get_size(pool));
+    TEST_ASSERT_EQUAL_UINT(64, (uint32_t)memory_pool_get_used(pool));
+    TEST_ASSERT_EQUAL_UINT(0xAB, ((uint8_t*)keep)[63]);
+    
+    /* Allocation resumes exactly where the mark was taken */
+    TEST_ASSERT_TRUE(memory_pool_alloc(pool, 32) == first_after);
+    
+    memory_pool_rewind(NULL, &mark);
+    memory_pool_destroy(pool);
+}
+
+void test_memory_pool_extended_stats(void) {
+    memory_pool_t* pool = memory_pool_create_growable(128, 0);
+    memory_pool_stats_t stats;
+    void* node;
+    
+    /* 24 + 96 leaves an 8 byte tail that the next alloc abandons */
+    node = memory_pool_alloc(pool, 24);
+    TEST_ASSERT_NOT_NULL(memory_pool_alloc(pool, 96));
+    TEST_ASSERT_NOT_NULL(memory_pool_alloc(pool, 24));
+    memory_pool_free_sized(pool, node, 24);
+    TEST_ASSERT_NOT_NULL(memory_pool_alloc(pool, 64));
+    
+    memory_pool_get_stats(pool, &stats);
+    
+    TEST_ASSERT_EQUAL_UINT(2, (uint32_t)stats.block_count);
+    TEST_ASSERT_EQUAL_UINT(24, (uint32_t)stats.free_list_size);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)stats.class_free[24 / MEMORY_POOL_ALIGN - 1]);
+    TEST_ASSERT_EQUAL_UINT(2, (uint32_t)stats.class_allocations[24 / MEMORY_POOL_ALIGN - 1]);
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)stats.reused);
+    TEST_ASSERT_EQUAL_UINT(8, (uint32_t)stats.wasted_size);
+    TEST_ASSERT_TRUE(stats.fragmentation > 0.0 && stats.fragmentation < 1.0);
+    
+    /* Reuse empties the class list again */
+    TEST_ASSERT_TRUE(memory_pool_alloc(pool, 24) == node);
+    memory_pool_get_stats(pool, &stats);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)stats.reused);
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)stats.free_list_size);
+    
+    memory_pool_destroy(pool);
+}
+
+void test_memory_pool_peak_reset(void) {
+    memory_pool_t* pool = memory_pool_create_growable(256, 0);
+    memory_pool_mark_t mark;
+    
+    TEST_ASSERT_NOT_NULL(memory_pool_alloc(pool, 64));
+    mark = memory_pool_mark(pool);
+    TEST_ASSERT_NOT_NULL(memory_pool_alloc(pool, 128));
+    
+    /* Rewinding lowers use but not the high-water mark */
+    memory_pool_rewind(pool, &mark);
+    TEST_ASSERT_EQUAL_UINT(64, (uint32_t)memory_pool_get_used(pool));
+    TEST_ASSERT_EQUAL_UINT(192, (uint32_t)memory_pool_get_peak(pool));
+    
+    /* A new phase starts counting from what is live */
+    memory_pool_reset_peak(pool);
+    TEST_ASSERT_EQUAL_UINT(64, (uint32_t)memory_pool_get_peak(pool));
+    TEST_ASSERT_NOT_NULL(memory_pool_alloc(pool, 32));
+    TEST_ASSERT_EQUAL_UINT(96, (uint32_t)memory_pool_get_peak(pool));
+    
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)memory_pool_get_peak(NULL));
+    memory_pool_destroy(pool);
+}
+
 int test_memory_main(void) {
     UNITY_BEGIN();
     
@@ -242,6 +442,13 @@ int test_memory_main(void) {
     RUN_TEST(test_memory_pool_fragmentation);
     RUN_TEST(test_memory_utility_functions);
     RUN_TEST(test_memory_pool_inline_functions);
+    RUN_TEST(test_memory_pool_growable);
+    RUN_TEST(test_memory_pool_growable_limit);
+    RUN_TEST(test_memory_pool_growable_reset);
+    RUN_TEST(test_memory_pool_size_class_reuse);
+    RUN_TEST(test_memory_pool_mark_rewind);
+    RUN_TEST(test_memory_pool_extended_stats);
+    RUN_TEST(test_memory_pool_peak_reset);
     
     return UNITY_END();
 }
@@ -0,0 +1,389 @@
+/* tests/test_output.c */
+#include "unity.h"
+#include "output.h"
+#include "symbol_table.h"
+#include "smof.h"
+#include "error.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/**
+ * @file test_output.c
+ * @brief Unit tests for the streaming output generator
+ * @details Tests SMOF and flat layouts by reading the written file back:
+ * table offsets, names, data alignment, gap filling, sparse gaps, rejected
+ * layouts, sections large enough to bypass the write buffer and the
+ * switch to the v2 header
+ */
+
+/* Function prototypes */
+void test_output_generator_lifecycle(void);
+void test_output_smof_layout(void);
+void test_output_flat_fill_gaps(void);
+void test_output_flat_zero_fill(void);
+void test_output_flat_sparse_gap(void);
+void test_output_flat_invalid_layout(void);
+void test_output_large_section(void);
+void test_output_null_parameters(void);
+void test_output_smof_v2_header(void);
+int test_output_main(void);
+
+#define TEST_OUTPUT "test_output.bin"
+
+/* Test fixture data */
+static symbol_table_t* test_symbols;
+static output_generator_t* test_generator;
+static uint8_t* test_file;
+static size_t test_file_size;
+
+void setUp(void) {
+    test_symbols = symbol_table_create(0);
+    test_generator = output_generator_create(test_symbols);
+    test_file = NULL;
+    test_file_size = 0;
+}
+
+void tearDown(void) {
+    output_generator_destroy(test_generator);
+    symbol_table_destroy(test_symbols);
+    free(test_file);
+    test_generator = NULL;
+    test_symbols = NULL;
+    test_file = NULL;
+    remove(TEST_OUTPUT);
+}
+
+static void add_symbol(const char* name, uint16_t section_index, uint32_t value) {
+    symbol_t symbol = {
+        .name = name,
+        .type = SYMBOL_TYPE_FUNCTION,
+        .binding = SYMBOL_BINDING_GLOBAL,
+        .visibility = SYMBOL_VISIBILITY_DEFAULT,
+        .section_index = section_index,
+        .value = value,
+        .size = 4
+    };
+    
+    TEST_ASSERT_TRUE(symbol_table_insert(test_symbols, &symbol) != SYMBOL_HANDLE_INVALID);
+}
+
+static void configure(output_type_t type, uint32_t base, bool fill_gaps, uint8_t fill) {
+    output_config_t config = {
+        .type = type,
+        .base_address = base,
+        .entry_point = base,
+        .file_flags = SMOF_FLAG_LITTLE_ENDIAN | SMOF_FLAG_EXECUTABLE,
+        .fill_gaps = fill_gaps,
+        .fill_value = fill
+    };
+    
+    TEST_ASSERT_TRUE(output_generator_configure(test_generator, &config));
+}
+
+/* Generate, then load the file into test_file */
+static void generate_and_read(void) {
+    size_t expected = output_generator_calculate_size(test_generator);
+    FILE* file;
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          output_generator_generate_to_file(test_generator, TEST_OUTPUT));
+    
+    file = fopen(TEST_OUTPUT, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    fseek(file, 0, SEEK_END);
+    test_file_size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    
+    test_file = malloc(test_file_size + 1);
+    TEST_ASSERT_NOT_NULL(test_file);
+    TEST_ASSERT_EQUAL_UINT((uint32_t)test_file_size,
+                           (uint32_t)fread(test_file, 1, test_file_size, file));
+    fclose(file);
+    
+    TEST_ASSERT_EQUAL_UINT((uint32_t)expected, (uint32_t)test_file_size);
+}
+
+void test_output_generator_lifecycle(void) {
+    output_config_t config = { .type = (output_type_t)7 };
+    
+    TEST_ASSERT_NOT_NULL(test_generator);
+    TEST_ASSERT_NULL(output_generator_create(NULL));
+    TEST_ASSERT_FALSE(output_generator_configure(test_generator, &config));
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_ARGUMENT,
+                          output_generator_add_section(test_generator, NULL, 0, 4, 0, 0, NULL));
+    TEST_ASSERT_EQUAL_INT(ERROR_SECTION_ALIGNMENT,
+                          output_generator_add_section(test_generator, ".text", 0, 4, 0, 32, NULL));
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)output_generator_get_section_count(test_generator));
+    output_generator_destroy(NULL);
+}
+
+void test_output_smof_layout(void) {
+    const uint8_t text[16] = {0x55, 0x89, 0xE5, 0xB8, 0x42, 0, 0, 0, 0x5D, 0xC3};
+    const uint8_t data[8] = {'H', 'e', 'l', 'l', 'o'};
+    const smof_header_t* header;
+    const smof_section_t* sections;
+    const smof_symbol_t* symbols;
+    const char* strings;
+    
+    add_symbol("main", 0, 0x1000);
+    add_symbol("message", 1, 0x1800);
+    configure(OUTPUT_TYPE_SMOF, 0x1000, false, 0);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          output_generator_add_section(test_generator, ".text", 0x1000, sizeof(text),
+                                                       SMOF_SECT_EXECUTABLE, 2, text));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          output_generator_add_section(test_generator, ".data", 0x1800, sizeof(data),
+                                                       SMOF_SECT_WRITABLE, 3, data));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          output_generator_add_section(test_generator, ".bss", 0x2000, 64,
+                                                       SMOF_SECT_WRITABLE, 2, NULL));
+    generate_and_read();
+    
+    header = (const smof_header_t*)test_file;
+    TEST_ASSERT_TRUE(smof_validate_header(header));
+    TEST_ASSERT_EQUAL_HEX32(0x1000, header->entry_point);
+    TEST_ASSERT_EQUAL_UINT(3, header->section_count);
+    TEST_ASSERT_EQUAL_UINT(2, header->symbol_count);
+    TEST_ASSERT_EQUAL_UINT(0, header->reloc_count);
+    
+    /* Tables are contiguous: sections, symbols, strings */
+    sections = (const smof_section_t*)(test_file + header->section_table_offset);
+    symbols = (const smof_symbol_t*)(sections + header->section_count);
+    strings = (const char*)(test_file + header->string_table_offset);
+    TEST_ASSERT_EQUAL_PTR(symbols + header->symbol_count, strings);
+    
+    TEST_ASSERT_EQUAL_STRING(".text", strings + sections[0].name_offset);
+    TEST_ASSERT_EQUAL_STRING(".data", strings + sections[1].name_offset);
+    TEST_ASSERT_EQUAL_STRING(".bss", strings + sections[2].name_offset);
+    TEST_ASSERT_EQUAL_STRING("main", strings + symbols[0].name_offset);
+    TEST_ASSERT_EQUAL_STRING("message", strings + symbols[1].name_offset);
+    TEST_ASSERT_EQUAL_HEX32(0x1800, symbols[1].value);
+    TEST_ASSERT_EQUAL_UINT(1, symbols[1].section_index);
+    
+    /* Data follows the tables at its file alignment */
+    TEST_ASSERT_EQUAL_UINT(0, sections[0].file_offset % 4);
+    TEST_ASSERT_EQUAL_UINT(0, sections[1].file_offset % 8);
+    TEST_ASSERT_TRUE(sections[0].file_offset >= header->string_table_offset +
+                                                header->string_table_size);
+    TEST_ASSERT_EQUAL_MEMORY(text, test_file + sections[0].file_offset, sizeof(text));
+    TEST_ASSERT_EQUAL_MEMORY(data, test_file + sections[1].file_offset, sizeof(data));
+    TEST_ASSERT_EQUAL_UINT(0, sections[2].file_offset);
+    TEST_ASSERT_TRUE((sections[2].flags & SMOF_SECT_ZERO_FILL) != 0);
+    TEST_ASSERT_EQUAL_UINT(sections[1].file_offset + sizeof(data), (uint32_t)test_file_size);
+}
+
+void test_output_flat_fill_gaps(void) {
+    const uint8_t text[4] = {1, 2, 3, 4};
+    const uint8_t data[4] = {5, 6, 7, 8};
+    size_t i;
+    
+    configure(OUTPUT_TYPE_BINARY_FLAT, 0x1000, true, 0x90);
+    
+    /* Registered out of address order; trailing .bss is not in the image */
+    output_generator_add_section(test_generator, ".data", 0x1010, sizeof(data), 0, 0, data);
+    output_generator_add_section(test_generator, ".bss", 0x1020, 32, 0, 0, NULL);
+    output_generator_add_section(test_generator, ".text", 0x1000, sizeof(text), 0, 0, text);
+    generate_and_read();
+    
+    TEST_ASSERT_EQUAL_UINT(0x14, (uint32_t)test_file_size);
+    TEST_ASSERT_EQUAL_MEMORY(text, test_file, sizeof(text));
+    for (i = 4; i < 0x10; i++) {
+        TEST_ASSERT_EQUAL_HEX8(0x90, test_file[i]);
+    }
+    TEST_ASSERT_EQUAL_MEMORY(data, test_file + 0x10, sizeof(data));
+}
+
+void test_output_flat_zero_fill(void) {
+    const uint8_t text[4] = {1, 2, 3, 4};
+    size_t i;
+    
+    configure(OUTPUT_TYPE_BINARY_FLAT, 0x1000, true, 0xFF);
+    output_generator_add_section(test_generator, ".text", 0x1000, sizeof(text), 0, 0, text);
+    output_generator_add_section(test_generator, ".bss", 0x1004, 8, SMOF_SECT_ZERO_FILL, 0, text);
+    output_generator_add_section(test_generator, ".data", 0x100C, sizeof(text), 0, 0, text);
+    generate_and_read();
+    
+    /* Zero-fill sections inside the image are zeros, not gap bytes */
+    TEST_ASSERT_EQUAL_UINT(0x10, (uint32_t)test_file_size);
+    for (i = 4; i < 0x0C; i++) {
+        TEST_ASSERT_EQUAL_HEX8(0, test_file[i]);
+    }
+    TEST_ASSERT_EQUAL_MEMORY(text, test_file + 0x0C, sizeof(text));
+}
+
+void test_output_flat_sparse_gap(void) {
+    const uint8_t rom[4] = {1, 2, 3, 4};
+    struct stat st;
+    size_t i;
+    
+    /* Two ROM regions 4MB apart; the gap is a hole, not written zeros */
+    configure(OUTPUT_TYPE_BINARY_FLAT, 0, false, 0);
+    output_generator_add_section(test_generator, ".rom0", 0, sizeof(rom), 0, 0, rom);
+    output_generator_add_section(test_generator, ".rom1", 0x400000, sizeof(rom), 0, 0, rom);
+    generate_and_read();
+    
+    TEST_ASSERT_EQUAL_UINT(0x400004, (uint32_t)test_file_size);
+    TEST_ASSERT_EQUAL_MEMORY(rom, test_file, sizeof(rom));
+    TEST_ASSERT_EQUAL_MEMORY(rom, test_file + 0x400000, sizeof(rom));
+    for (i = sizeof(rom); i < 0x400000; i++) {
+        TEST_ASSERT_EQUAL_HEX8(0, test_file[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(0, stat(TEST_OUTPUT, &st));
+    TEST_ASSERT_TRUE((uint64_t)st.st_blocks * 512 < test_file_size / 2);
+    
+    /* With fill_gaps the whole gap is written with the fill byte */
+    free(test_file);
+    test_file = NULL;
+    output_generator_destroy(test_generator);
+    test_generator = output_generator_create(test_symbols);
+    configure(OUTPUT_TYPE_BINARY_FLAT, 0, true, 0xFF);
+    output_generator_add_section(test_generator, ".rom0", 0, sizeof(rom), 0, 0, rom);
+    output_generator_add_section(test_generator, ".rom1", 0x400000, sizeof(rom), 0, 0, rom);
+    generate_and_read();
+    
+    TEST_ASSERT_EQUAL_UINT(0x400004, (uint32_t)test_file_size);
+    for (i = sizeof(rom); i < 0x400000; i++) {
+        TEST_ASSERT_EQUAL_HEX8(0xFF, test_file[i]);
+    }
+    TEST_ASSERT_EQUAL_MEMORY(rom, test_file + 0x400000, sizeof(rom));
+}
+
+void test_output_flat_invalid_layout(void) {
+    const uint8_t text[8] = {0};
+    FILE* file;
+    
+    configure(OUTPUT_TYPE_BINARY_FLAT, 0x1000, false, 0);
+    output_generator_add_section(test_generator, ".text", 0x1000, sizeof(text), 0, 0, text);
+    output_generator_add_section(test_generator, ".data", 0x1004, sizeof(text), 0, 0, text);
+    
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)output_generator_calculate_size(test_generator));
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_SECTION,
+                          output_generator_generate_to_file(test_generator, TEST_OUTPUT));
+    file = fopen(TEST_OUTPUT, "rb");
+    TEST_ASSERT_NULL(file);
+    
+    /* Below the base address */
+    output_generator_destroy(test_generator);
+    test_generator = output_generator_create(test_symbols);
+    configure(OUTPUT_TYPE_BINARY_FLAT, 0x1000, false, 0);
+    output_generator_add_section(test_generator, ".text", 0x0800, sizeof(text), 0, 0, text);
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_SECTION,
+                          output_generator_generate_to_file(test_generator, TEST_OUTPUT));
+}
+
+void test_output_large_section(void) {
+    const size_t size = OUTPUT_BUFFER_SIZE * 4 + 3;
+    const uint8_t small[3] = {0xAA, 0xBB, 0xCC};
+    const smof_section_t* sections;
+    uint8_t* large = malloc(size);
+    size_t i;
+    
+    TEST_ASSERT_NOT_NULL(large);
+    for (i = 0; i < size; i++) {
+        large[i] = (uint8_t)(i * 7);
+    }
+    
+    configure(OUTPUT_TYPE_SMOF, 0, false, 0);
+    output_generator_add_section(test_generator, ".small", 0, sizeof(small), 0, 0, small);
+    output_generator_add_section(test_generator, ".large", 0x10000, (uint32_t)size, 0, 4, large);
+    output_generator_add_section(test_generator, ".tail", 0x500000, sizeof(small), 0, 0, small);
+    generate_and_read();
+    
+    sections = (const smof_section_t*)(test_file + sizeof(smof_header_t));
+    TEST_ASSERT_EQUAL_UINT(0, sections[1].file_offset % 16);
+    TEST_ASSERT_EQUAL_MEMORY(small, test_file + sections[0].file_offset, sizeof(small));
+    TEST_ASSERT_EQUAL_MEMORY(large, test_file + sections[1].file_offset, (uint32_t)size);
+    TEST_ASSERT_EQUAL_MEMORY(small, test_file + sections[2].file_offset, sizeof(small));
+    
+    free(large);
+}
+
+void test_output_null_parameters(void) {
+    TEST_ASSERT_FALSE(output_generator_configure(NULL, NULL));
+    TEST_ASSERT_FALSE(output_generator_configure(test_generator, NULL));
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)output_generator_calculate_size(NULL));
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)output_generator_get_section_count(NULL));
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_ARGUMENT,
+                          output_generator_generate_to_file(NULL, TEST_OUTPUT));
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_ARGUMENT,
+                          output_generator_generate_to_file(test_generator, NULL));
+}
+
+/* Past a v1 limit the output gets the v2 header and wide relocations */
+void test_output_smof_v2_header(void) {
+    const uint8_t text[8] = {0};
+    const smof_header_v2_t* header;
+    const smof_relocation_v2_t* relocs;
+    const smof_symbol_t* symbols;
+    const char* strings;
+    output_relocation_t reloc;
+    smof_layout_t layout;
+    char name[16];
+    uint32_t i;
+    
+    for (i = 0; i <= 0x10000U; i++) {
+        snprintf(name, sizeof(name), "s%05X", (unsigned)i);
+        add_symbol(name, 0, i);
+    }
+    configure(OUTPUT_TYPE_SMOF, 0x1000, false, 0);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          output_generator_add_section(test_generator, ".text", 0x1000, sizeof(text),
+                                                       SMOF_SECT_EXECUTABLE, 2, text));
+    reloc = (output_relocation_t) {
+        .offset = 4,
+        .symbol = 0x10000U,
+        .type = SMOF_RELOC_ABS32,
+        .section = 0
+    };
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, output_generator_set_relocations(test_generator, &reloc, 1));
+    generate_and_read();
+    
+    header = (const smof_header_v2_t*)test_file;
+    TEST_ASSERT_TRUE(smof_validate_header_v2(header));
+    TEST_ASSERT_FALSE(smof_validate_header((const smof_header_t*)test_file));
+    TEST_ASSERT_EQUAL_UINT(SMOF_VERSION_2, header->version);
+    TEST_ASSERT_EQUAL_UINT(0x10001U, header->symbol_count);
+    TEST_ASSERT_EQUAL_UINT(sizeof(smof_header_v2_t), (uint32_t)header->section_table_offset);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, smof_read_layout(test_file, test_file_size, &layout));
+    TEST_ASSERT_EQUAL_UINT(0x10001U, layout.symbol_count);
+    TEST_ASSERT_EQUAL_UINT(1, layout.reloc_count);
+    TEST_ASSERT_EQUAL_UINT(sizeof(smof_relocation_v2_t), (uint32_t)layout.reloc_entry_size);
+    TEST_ASSERT_TRUE(smof_layout_fits(&layout, layout.string_table_offset + layout.string_table_size));
+    TEST_ASSERT_FALSE(smof_layout_fits(&layout,
+                                       layout.string_table_offset + layout.string_table_size - 1));
+    
+    symbols = (const smof_symbol_t*)(test_file + layout.symbol_table_offset);
+    relocs = (const smof_relocation_v2_t*)(test_file + layout.reloc_table_offset);
+    strings = (const char*)(test_file + layout.string_table_offset);
+    TEST_ASSERT_EQUAL_UINT(0x10000U, relocs[0].symbol_index);
+    TEST_ASSERT_EQUAL_UINT(4, relocs[0].offset);
+    TEST_ASSERT_EQUAL_STRING("s10000", strings + symbols[relocs[0].symbol_index].name_offset);
+    
+    /* Truncated to the v1 header's size, the v2 header is rejected */
+    TEST_ASSERT_EQUAL_INT(ERROR_CORRUPT_HEADER,
+                          smof_read_layout(test_file, sizeof(smof_header_t), &layout));
+}
+
+int test_output_main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_output_generator_lifecycle);
+    RUN_TEST(test_output_smof_layout);
+    RUN_TEST(test_output_flat_fill_gaps);
+    RUN_TEST(test_output_flat_zero_fill);
+    RUN_TEST(test_output_flat_sparse_gap);
+    RUN_TEST(test_output_flat_invalid_layout);
+    RUN_TEST(test_output_large_section);
+    RUN_TEST(test_output_null_parameters);
+    RUN_TEST(test_output_smof_v2_header);
+    
+    return UNITY_END();
+}
+
+int main(void) {
+    return test_output_main();
+}
@@ -0,0 +1,351 @@
+/* tests/test_relocation.c */
+#include "unity.h"
+#include "relocation.h"
+#include "symbol_table.h"
+#include "thread_pool.h"
+#include "error.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file test_relocation.c
+ * @brief Unit tests for the relocation engine
+ * @details Tests each patch kernel, addends, GOT slot allocation, range
+ * and bounds checking, unresolved references and statistics
+ */
+
+/* Function prototypes */
+void test_relocation_engine_lifecycle(void);
+void test_relocation_absolute(void);
+void test_relocation_pc_relative(void);
+void test_relocation_sixteen_bit(void);
+void test_relocation_overflow(void);
+void test_relocation_got_plt(void);
+void test_relocation_unresolved(void);
+void test_relocation_out_of_bounds(void);
+void test_relocation_statistics(void);
+void test_relocation_parallel_matches_serial(void);
+void test_relocation_null_parameters(void);
+int test_relocation_main(void);
+
+#define TEST_TEXT_ID    0
+#define TEST_DATA_ID    1
+#define TEST_TEXT_ADDR  0x1000
+#define TEST_DATA_ADDR  0x3000
+#define TEST_PARALLEL_SECTIONS 8
+#define TEST_PARALLEL_FIELDS   1024
+
+/* Test fixture data */
+static symbol_table_t* test_symbols;
+static relocation_engine_t* test_engine;
+static uint8_t test_text[32];
+static uint8_t test_data[16];
+
+void setUp(void) {
+    test_symbols = symbol_table_create(0);
+    test_engine = relocation_engine_create(test_symbols);
+    memset(test_text, 0, sizeof(test_text));
+    memset(test_data, 0, sizeof(test_data));
+    relocation_engine_set_section(test_engine, TEST_TEXT_ID, test_text,
+                                  sizeof(test_text), TEST_TEXT_ADDR);
+    relocation_engine_set_section(test_engine, TEST_DATA_ID, test_data,
+                                  sizeof(test_data), TEST_DATA_ADDR);
+}
+
+void tearDown(void) {
+    relocation_engine_destroy(test_engine);
+    symbol_table_destroy(test_symbols);
+    test_engine = NULL;
+    test_symbols = NULL;
+}
+
+static symbol_handle_t add_symbol(const char* name, uint16_t section_index,
+                                  symbol_binding_t binding, uint32_t value) {
+    symbol_t symbol = {
+        .name = name,
+        .type = SYMBOL_TYPE_FUNCTION,
+        .binding = binding,
+        .visibility = SYMBOL_VISIBILITY_DEFAULT,
+        .section_index = section_index,
+        .value = value,
+        .size = 0
+    };
+    
+    return symbol_table_insert(test_symbols, &symbol);
+}
+
+static void add_reloc(uint32_t section_id, uint32_t offset, relocation_type_t type,
+                      symbol_handle_t handle, int32_t addend) {
+    relocation_entry_t entry = {
+        .offset = offset,
+        .type = type,
+        .symbol_handle = handle,
+        .addend = addend,
+        .section_id = section_id
+    };
+    
+    TEST_ASSERT_TRUE(relocation_engine_add_entry(test_engine, &entry) != RELOCATION_ID_INVALID);
+}
+
+static uint32_t read32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t read16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+void test_relocation_engine_lifecycle(void) {
+    TEST_ASSERT_NOT_NULL(test_engine);
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)relocation_engine_get_count(test_engine));
+    TEST_ASSERT_FALSE(relocation_engine_has_unresolved(test_engine));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, relocation_engine_process_all(test_engine));
+    TEST_ASSERT_NULL(relocation_engine_create(NULL));
+}
+
+void test_relocation_absolute(void) {
+    symbol_handle_t var = add_symbol("variable", 1, SYMBOL_BINDING_GLOBAL, 0x4000);
+    
+    test_data[8] = 0x12;
+    add_reloc(TEST_DATA_ID, 4, RELOC_TYPE_ABS32, var, 40);
+    add_reloc(TEST_DATA_ID, 0, RELOC_TYPE_ABS32, var, 0);
+    
+    TEST_ASSERT_TRUE(relocation_engine_has_unresolved(test_engine));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, relocation_engine_process_all(test_engine));
+    TEST_ASSERT_FALSE(relocation_engine_has_unresolved(test_engine));
+    
+    TEST_ASSERT_EQUAL_HEX32(0x4000, read32(&test_data[0]));
+    TEST_ASSERT_EQUAL_HEX32(0x4028, read32(&test_data[4]));
+    TEST_ASSERT_EQUAL_HEX8(0x12, test_data[8]);
+}
+
+void test_relocation_pc_relative(void) {
+    symbol_handle_t func = add_symbol("target", 0, SYMBOL_BINDING_GLOBAL, 0x2000);
+    
+    /* call at 0x1003; displacement field at 0x1004 is relative to 0x1008 */
+    add_reloc(TEST_TEXT_ID, 4, RELOC_TYPE_REL32, func, -4);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, relocation_engine_process_all(test_engine));
+    TEST_ASSERT_EQUAL_HEX32(0x2000 - (TEST_TEXT_ADDR + 8), read32(&test_text[4]));
+}
+
+void test_relocation_sixteen_bit(void) {
+    symbol_handle_t near_sym = add_symbol("near", 0, SYMBOL_BINDING_GLOBAL, 0x1100);
+    symbol_handle_t back = add_symbol("back", 0, SYMBOL_BINDING_GLOBAL, 0x0F00);
+    
+    add_reloc(TEST_TEXT_ID, 0, RELOC_TYPE_ABS16, near_sym, 0);
+    add_reloc(TEST_TEXT_ID, 2, RELOC_TYPE_REL16, near_sym, -2);
+    add_reloc(TEST_TEXT_ID, 6, RELOC_TYPE_REL16, back, -2);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, relocation_engine_process_all(test_engine));
+    TEST_ASSERT_EQUAL_HEX16(0x1100, read16(&test_text[0]));
+    TEST_ASSERT_EQUAL_HEX16(0x1100 - (TEST_TEXT_ADDR + 4), read16(&test_text[2]));
+    TEST_ASSERT_EQUAL_HEX16((uint16_t)(0x0F00 - (TEST_TEXT_ADDR + 8)), read16(&test_text[6]));
+    TEST_ASSERT_EQUAL_HEX8(0, test_text[4]);
+}
+
+void test_relocation_overflow(void) {
+    symbol_handle_t far_sym = add_symbol("far", 1, SYMBOL_BINDING_GLOBAL, 0x12345678);
+    
+    add_reloc(TEST_DATA_ID, 0, RELOC_TYPE_ABS16, far_sym, 0);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_RELOCATION_FAILED, relocation_engine_process_all(test_engine));
+    TEST_ASSERT_TRUE(relocation_engine_has_unresolved(test_engine));
+}
+
+void test_relocation_got_plt(void) {
+    symbol_handle_t a = add_symbol("a", 1, SYMBOL_BINDING_GLOBAL, 0x3004);
+    symbol_handle_t b = add_symbol("b", 1, SYMBOL_BINDING_GLOBAL, 0x3008);
+    symbol_handle_t func = add_symbol("func", 0, SYMBOL_BINDING_GLOBAL, 0x1010);
+    const uint32_t* got;
+    size_t got_count;
+    
+    relocation_engine_set_got_address(test_engine, 0x5000);
+    add_reloc(TEST_TEXT_ID, 0, RELOC_TYPE_GOT, a, 0);
+    add_reloc(TEST_TEXT_ID, 4, RELOC_TYPE_GOT, b, 0);
+    add_reloc(TEST_TEXT_ID, 8, RELOC_TYPE_GOT, a, 0);
+    add_reloc(TEST_TEXT_ID, 12, RELOC_TYPE_PLT, func, -4);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, relocation_engine_process_all(test_engine));
+    
+    /* One slot per symbol, addressed from the GOT base */
+    got = relocation_engine_get_got(test_engine, &got_count);
+    TEST_ASSERT_EQUAL_UINT(2, (uint32_t)got_count);
+    TEST_ASSERT_EQUAL_HEX32(0x3004, got[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x3008, got[1]);
+    TEST_ASSERT_EQUAL_HEX32(0x5000, read32(&test_text[0]));
+    TEST_ASSERT_EQUAL_HEX32(0x5004, read32(&test_text[4]));
+    TEST_ASSERT_EQUAL_HEX32(0x5000, read32(&test_text[8]));
+    
+    /* A static PLT reference binds directly */
+    TEST_ASSERT_EQUAL_HEX32(0x1010 - (TEST_TEXT_ADDR + 16), read32(&test_text[12]));
+}
+
+void test_relocation_unresolved(void) {
+    symbol_handle_t missing = add_symbol("missing", SECTION_INDEX_UNDEFINED,
+                                         SYMBOL_BINDING_GLOBAL, 0);
+    symbol_handle_t weak = add_symbol("optional", SECTION_INDEX_UNDEFINED,
+                                      SYMBOL_BINDING_WEAK, 0);
+    
+    test_data[0] = 0xAA;
+    add_reloc(TEST_DATA_ID, 0, RELOC_TYPE_ABS32, weak, 0);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, relocation_engine_process_all(test_engine));
+    TEST_ASSERT_EQUAL_HEX32(0, read32(&test_data[0]));
+    
+    add_reloc(TEST_DATA_ID, 4, RELOC_TYPE_ABS32, missing, 0);
+    add_reloc(TEST_DATA_ID, 8, RELOC_TYPE_ABS32, SYMBOL_HANDLE_INVALID, 0);
+    TEST_ASSERT_TRUE(relocation_engine_has_unresolved(test_engine));
+    TEST_ASSERT_EQUAL_INT(ERROR_SYMBOL_NOT_FOUND, relocation_engine_process_all(test_engine));
+    TEST_ASSERT_TRUE(relocation_engine_has_unresolved(test_engine));
+}
+
+void test_relocation_out_of_bounds(void) {
+    symbol_handle_t var = add_symbol("variable", 1, SYMBOL_BINDING_GLOBAL, 0x4000);
+    
+    add_reloc(TEST_DATA_ID, 0, RELOC_TYPE_ABS32, var, 0);
+    add_reloc(TEST_DATA_ID, sizeof(test_data) - 2, RELOC_TYPE_ABS32, var, 0);
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_RELOCATION, relocation_engine_process_all(test_engine));
+    
+    /* Unregistered section */
+    relocation_engine_clear(test_engine);
+    add_reloc(7, 0, RELOC_TYPE_ABS32, var, 0);
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_RELOCATION, relocation_engine_process_all(test_engine));
+}
+
+void test_relocation_statistics(void) {
+    symbol_handle_t func = add_symbol("func", 0, SYMBOL_BINDING_GLOBAL, 0x1000);
+    symbol_handle_t var = add_symbol("var", 1, SYMBOL_BINDING_GLOBAL, 0x3000);
+    relocation_stats_t stats;
+    
+    add_reloc(TEST_TEXT_ID, 8, RELOC_TYPE_REL32, func, -4);
+    add_reloc(TEST_TEXT_ID, 0, RELOC_TYPE_REL32, func, -4);
+    add_reloc(TEST_DATA_ID, 0, RELOC_TYPE_ABS32, var, 0);
+    add_reloc(TEST_DATA_ID, 4, RELOC_TYPE_ABS32, func, 0);
+    add_reloc(TEST_DATA_ID, 8, RELOC_TYPE_ABS16, var, 0);
+    
+    stats = relocation_engine_get_statistics(test_engine);
+    TEST_ASSERT_EQUAL_UINT(5, (uint32_t)stats.total_relocations);
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)stats.resolved_relocations);
+    TEST_ASSERT_EQUAL_UINT(5, (uint32_t)stats.unresolved_relocations);
+    TEST_ASSERT_EQUAL_UINT(2, (uint32_t)stats.pc_relative_count);
+    TEST_ASSERT_EQUAL_UINT(3, (uint32_t)stats.absolute_count);
+    TEST_ASSERT_EQUAL_UINT(2, (uint32_t)stats.type_counts[RELOC_TYPE_ABS32]);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)stats.type_counts[RELOC_TYPE_ABS16]);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, relocation_engine_process_all(test_engine));
+    stats = relocation_engine_get_statistics(test_engine);
+    TEST_ASSERT_EQUAL_UINT(5, (uint32_t)stats.resolved_relocations);
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)stats.unresolved_relocations);
+    TEST_ASSERT_EQUAL_UINT(3, (uint32_t)stats.group_count);
+    TEST_ASSERT_TRUE(stats.process_time >= 0.0);
+}
+
+/* Apply the same shuffled entries serially and on a pool */
+static void apply_parallel_fixture(relocation_engine_t* engine, uint8_t* buffers,
+                                   const symbol_handle_t* handles) {
+    relocation_entry_t entry;
+    uint32_t fields = TEST_PARALLEL_SECTIONS * TEST_PARALLEL_FIELDS;
+    uint32_t i;
+    
+    for (i = 0; i < TEST_PARALLEL_SECTIONS; i++) {
+        TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                              relocation_engine_set_section(engine, i,
+                                                            buffers + i * TEST_PARALLEL_FIELDS * 4,
+                                                            TEST_PARALLEL_FIELDS * 4,
+                                                            0x10000 * (i + 1)));
+    }
+    
+    /* Stride through the fields so sections and types interleave */
+    for (i = 0; i < fields; i++) {
+        uint32_t field = (i * 3571U) % fields;
+        
+        entry = (relocation_entry_t) {
+            .offset = (field % TEST_PARALLEL_FIELDS) * 4,
+            .type = (field & 1) ? RELOC_TYPE_REL32 : RELOC_TYPE_ABS32,
+            .symbol_handle = handles[field % 4],
+            .addend = (int32_t)(field % 7),
+            .section_id = field / TEST_PARALLEL_FIELDS
+        };
+        TEST_ASSERT_TRUE(relocation_engine_add_entry(engine, &entry) != RELOCATION_ID_INVALID);
+    }
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, relocation_engine_process_all(engine));
+}
+
+void test_relocation_parallel_matches_serial(void) {
+    size_t size = TEST_PARALLEL_SECTIONS * TEST_PARALLEL_FIELDS * 4;
+    uint8_t* serial = calloc(1, size);
+    uint8_t* parallel = calloc(1, size);
+    thread_pool_t* pool = thread_pool_create(4);
+    relocation_engine_t* engine;
+    relocation_stats_t stats;
+    symbol_handle_t handles[4];
+    
+    TEST_ASSERT_NOT_NULL(serial);
+    TEST_ASSERT_NOT_NULL(parallel);
+    handles[0] = add_symbol("p0", 0, SYMBOL_BINDING_GLOBAL, 0x10000);
+    handles[1] = add_symbol("p1", 1, SYMBOL_BINDING_GLOBAL, 0x20400);
+    handles[2] = add_symbol("p2", 2, SYMBOL_BINDING_GLOBAL, 0x38000);
+    handles[3] = add_symbol("p3", 3, SYMBOL_BINDING_GLOBAL, 0x7FFF0);
+    
+    apply_parallel_fixture(test_engine, serial, handles);
+    
+    engine = relocation_engine_create(test_symbols);
+    relocation_engine_set_thread_pool(engine, pool);
+    apply_parallel_fixture(engine, parallel, handles);
+    
+    TEST_ASSERT_EQUAL_MEMORY(serial, parallel, (uint32_t)size);
+    stats = relocation_engine_get_statistics(engine);
+    TEST_ASSERT_EQUAL_UINT(TEST_PARALLEL_SECTIONS * TEST_PARALLEL_FIELDS,
+                           (uint32_t)stats.resolved_relocations);
+    TEST_ASSERT_EQUAL_UINT(TEST_PARALLEL_SECTIONS * 2, (uint32_t)stats.group_count);
+    
+    relocation_engine_destroy(engine);
+    thread_pool_destroy(pool);
+    free(parallel);
+    free(serial);
+}
+
+void test_relocation_null_parameters(void) {
+    relocation_entry_t bad_type = {
+        .offset = 0,
+        .type = RELOC_TYPE_COUNT,
+        .symbol_handle = 0,
+        .addend = 0,
+        .section_id = 0
+    };
+    
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)relocation_engine_get_count(NULL));
+    TEST_ASSERT_FALSE(relocation_engine_has_unresolved(NULL));
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_ARGUMENT, relocation_engine_process_all(NULL));
+    TEST_ASSERT_EQUAL_UINT(RELOCATION_ID_INVALID, relocation_engine_add_entry(test_engine, NULL));
+    TEST_ASSERT_EQUAL_UINT(RELOCATION_ID_INVALID,
+                           relocation_engine_add_entry(test_engine, &bad_type));
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_ARGUMENT,
+                          relocation_engine_set_section(test_engine, RELOCATION_MAX_SECTIONS,
+                                                        test_data, 4, 0));
+    relocation_engine_destroy(NULL);
+}
+
+int test_relocation_main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_relocation_engine_lifecycle);
+    RUN_TEST(test_relocation_absolute);
+    RUN_TEST(test_relocation_pc_relative);
+    RUN_TEST(test_relocation_sixteen_bit);
+    RUN_TEST(test_relocation_overflow);
+    RUN_TEST(test_relocation_got_plt);
+    RUN_TEST(test_relocation_unresolved);
+    RUN_TEST(test_relocation_out_of_bounds);
+    RUN_TEST(test_relocation_statistics);
+    RUN_TEST(test_relocation_parallel_matches_serial);
+    RUN_TEST(test_relocation_null_parameters);
+    
+    return UNITY_END();
+}
+
+int main(void) {
+    return test_relocation_main();
+}
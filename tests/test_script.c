@@ -0,0 +1,205 @@
+/* tests/test_script.c */
+#include "unity.h"
+#include "script.h"
+#include "memory.h"
+#include "error.h"
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @file test_script.c
+ * @brief Unit tests for the linker script parser and matcher
+ * @details Tests parsing of output sections and commands, first-rule-wins
+ * matching over exact, prefix and glob patterns, syntax errors and
+ * scripts with many rules
+ */
+
+/* Function prototypes */
+void test_script_parse_sections(void);
+void test_script_first_rule_wins(void);
+void test_script_glob_patterns(void);
+void test_script_syntax_errors(void);
+void test_script_many_rules(void);
+int test_script_main(void);
+
+#define TEST_MANY_RULES 500
+
+static const char test_board_script[] =
+    "/* Board layout */\n"
+    "ENTRY(reset)\n"
+    "SECTIONS\n"
+    "{\n"
+    "    . = 0x100000;\n"
+    "    .text : { KEEP(*(.text.boot)) *(.text .text.*) }\n"
+    "    .rodata ALIGN(16) : { *(.rodata*) }\n"
+    "    .data 0x200000 : { *(.data*) }\n"
+    "    .bss : { *(.bss*) }\n"
+    "    /DISCARD/ : { *(.comment) *(.note.*) }\n"
+    "}\n";
+
+/* Test fixture data */
+static memory_pool_t* test_pool;
+static linker_script_t* test_script;
+
+void setUp(void) {
+    test_pool = memory_pool_create_growable(0, 0);
+    test_script = NULL;
+}
+
+void tearDown(void) {
+    memory_pool_destroy(test_pool);
+    test_pool = NULL;
+}
+
+static int parse(const char* text) {
+    return linker_script_parse(text, strlen(text), test_pool, &test_script);
+}
+
+/* Output section name a section of this name is placed in */
+static const char* placed_in(const char* name) {
+    uint32_t rule = linker_script_match(test_script, name);
+    
+    if (rule == SCRIPT_NO_RULE) {
+        return NULL;
+    }
+    return linker_script_get_output(test_script,
+                                    linker_script_get_rule(test_script, rule)->output)->name;
+}
+
+void test_script_parse_sections(void) {
+    const script_output_t* output;
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, parse(test_board_script));
+    TEST_ASSERT_NOT_NULL(test_script);
+    TEST_ASSERT_EQUAL_STRING("reset", linker_script_get_entry(test_script));
+    TEST_ASSERT_EQUAL_UINT(5, (uint32_t)linker_script_get_output_count(test_script));
+    TEST_ASSERT_EQUAL_UINT(7, (uint32_t)linker_script_get_rule_count(test_script));
+    
+    /* ". =" places the next output section only */
+    output = linker_script_get_output(test_script, 0);
+    TEST_ASSERT_EQUAL_STRING(".text", output->name);
+    TEST_ASSERT_TRUE(output->fixed);
+    TEST_ASSERT_EQUAL_HEX32(0x100000, output->address);
+    output = linker_script_get_output(test_script, 1);
+    TEST_ASSERT_FALSE(output->fixed);
+    TEST_ASSERT_EQUAL_UINT(16, output->alignment);
+    output = linker_script_get_output(test_script, 2);
+    TEST_ASSERT_TRUE(output->fixed);
+    TEST_ASSERT_EQUAL_HEX32(0x200000, output->address);
+    TEST_ASSERT_TRUE(linker_script_get_output(test_script, 4)->discard);
+    TEST_ASSERT_NULL(linker_script_get_output(test_script, 5));
+    
+    TEST_ASSERT_TRUE(linker_script_get_rule(test_script, 0)->keep);
+    TEST_ASSERT_FALSE(linker_script_get_rule(test_script, 1)->keep);
+    TEST_ASSERT_EQUAL_UINT(0, linker_script_match(test_script, ".text.boot"));
+    TEST_ASSERT_EQUAL_UINT(1, linker_script_match(test_script, ".text"));
+    TEST_ASSERT_EQUAL_UINT(1, linker_script_match(test_script, ".text.main"));
+    TEST_ASSERT_EQUAL_STRING(".rodata", placed_in(".rodata"));
+    TEST_ASSERT_EQUAL_STRING(".rodata", placed_in(".rodata.str1.1"));
+    TEST_ASSERT_EQUAL_STRING(".data", placed_in(".data.rel"));
+    TEST_ASSERT_EQUAL_STRING("/DISCARD/", placed_in(".comment"));
+    TEST_ASSERT_EQUAL_STRING("/DISCARD/", placed_in(".note.gnu"));
+    TEST_ASSERT_NULL(placed_in(".note"));
+    TEST_ASSERT_NULL(placed_in(".textual"));
+    TEST_ASSERT_NULL(placed_in(".debug_info"));
+    TEST_ASSERT_NULL(placed_in(""));
+}
+
+void test_script_first_rule_wins(void) {
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, parse(
+        "SECTIONS {\n"
+        "    .hot : { *(.text.hot.*) }\n"
+        "    .text : { *(.text.*) *(.text.hot.loop) }\n"
+        "    .other : { *(*) }\n"
+        "}\n"));
+    
+    /* A later, more specific pattern does not override an earlier one */
+    TEST_ASSERT_EQUAL_STRING(".hot", placed_in(".text.hot.loop"));
+    TEST_ASSERT_EQUAL_STRING(".hot", placed_in(".text.hot."));
+    TEST_ASSERT_EQUAL_STRING(".text", placed_in(".text.hot"));
+    TEST_ASSERT_EQUAL_STRING(".text", placed_in(".text.cold"));
+    TEST_ASSERT_EQUAL_STRING(".other", placed_in(".text"));
+    TEST_ASSERT_EQUAL_STRING(".other", placed_in("anything"));
+    TEST_ASSERT_NULL(linker_script_get_entry(test_script));
+}
+
+void test_script_glob_patterns(void) {
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, parse(
+        "SECTIONS {\n"
+        "    .vectors : { *(.vec[0-9]) *(.vec_?) }\n"
+        "    .init : { *(.init*.early) *(.ini[!x]) }\n"
+        "    .rest : { *(*.keep) }\n"
+        "}\n"));
+    
+    TEST_ASSERT_EQUAL_STRING(".vectors", placed_in(".vec7"));
+    TEST_ASSERT_EQUAL_STRING(".vectors", placed_in(".vec_a"));
+    TEST_ASSERT_NULL(placed_in(".vecA"));
+    TEST_ASSERT_NULL(placed_in(".vec_ab"));
+    TEST_ASSERT_EQUAL_STRING(".init", placed_in(".init.early"));
+    TEST_ASSERT_EQUAL_STRING(".init", placed_in(".init_array.early"));
+    TEST_ASSERT_EQUAL_STRING(".init", placed_in(".init"));
+    TEST_ASSERT_NULL(placed_in(".inix"));
+    TEST_ASSERT_NULL(placed_in(".init.late"));
+    TEST_ASSERT_EQUAL_STRING(".rest", placed_in(".data.keep"));
+    TEST_ASSERT_EQUAL_STRING(".rest", placed_in(".keep"));
+}
+
+void test_script_syntax_errors(void) {
+    TEST_ASSERT_EQUAL_INT(ERROR_SCRIPT_SYNTAX, parse("SECTIONS { .text { *(.text) } }"));
+    TEST_ASSERT_NULL(test_script);
+    TEST_ASSERT_EQUAL_INT(ERROR_SCRIPT_SYNTAX, parse("SECTIONS { .text : { crt0.o(.text) } }"));
+    TEST_ASSERT_EQUAL_INT(ERROR_SCRIPT_SYNTAX, parse("SECTIONS { .text ALIGN(3) : { } }"));
+    TEST_ASSERT_EQUAL_INT(ERROR_SCRIPT_SYNTAX, parse("SECTIONS { . = 0x1000 .text : { } }"));
+    TEST_ASSERT_EQUAL_INT(ERROR_SCRIPT_SYNTAX, parse("SECTIONS { .text : { *(.text) }"));
+    TEST_ASSERT_EQUAL_INT(ERROR_SCRIPT_SYNTAX, parse("MEMORY { rom : ORIGIN = 0 }"));
+    TEST_ASSERT_EQUAL_INT(ERROR_SCRIPT_SYNTAX, parse("/* unterminated"));
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_ARGUMENT,
+                          linker_script_parse(NULL, 0, test_pool, &test_script));
+    TEST_ASSERT_EQUAL_INT(ERROR_FILE_NOT_FOUND,
+                          linker_script_load("/nonexistent/board.ld", test_pool, &test_script));
+    
+    /* An empty script is valid and places nothing */
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, parse("  /* nothing */\n"));
+    TEST_ASSERT_EQUAL_UINT(SCRIPT_NO_RULE, linker_script_match(test_script, ".text"));
+}
+
+void test_script_many_rules(void) {
+    static char text[TEST_MANY_RULES * 64 + 32];
+    char name[32];
+    size_t used;
+    uint32_t i;
+    
+    used = (size_t)snprintf(text, sizeof(text), "SECTIONS {\n");
+    for (i = 0; i < TEST_MANY_RULES; i++) {
+        used += (size_t)snprintf(text + used, sizeof(text) - used,
+                                 "  .out%u : { *(.sect%u) *(.sect%u.*) }\n", i, i, i);
+    }
+    snprintf(text + used, sizeof(text) - used, "}\n");
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, parse(text));
+    TEST_ASSERT_EQUAL_UINT(TEST_MANY_RULES, (uint32_t)linker_script_get_output_count(test_script));
+    
+    for (i = 0; i < TEST_MANY_RULES; i++) {
+        snprintf(name, sizeof(name), ".sect%u", i);
+        TEST_ASSERT_EQUAL_UINT(2 * i, linker_script_match(test_script, name));
+        snprintf(name, sizeof(name), ".sect%u.fn", i);
+        TEST_ASSERT_EQUAL_UINT(2 * i + 1, linker_script_match(test_script, name));
+    }
+    TEST_ASSERT_EQUAL_UINT(SCRIPT_NO_RULE, linker_script_match(test_script, ".sect"));
+}
+
+int test_script_main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_script_parse_sections);
+    RUN_TEST(test_script_first_rule_wins);
+    RUN_TEST(test_script_glob_patterns);
+    RUN_TEST(test_script_syntax_errors);
+    RUN_TEST(test_script_many_rules);
+    
+    return UNITY_END();
+}
+
+int main(void) {
+    return test_script_main();
+}
@@ -0,0 +1,292 @@
+/* tests/test_section.c */
+#include "unity.h"
+#include "section.h"
+#include "memory.h"
+#include "error.h"
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @file test_section.c
+ * @brief Unit tests for the section manager
+ * @details Tests the name index, scatter-list fragments, merging, layout
+ * order and alignment, and limit checking
+ */
+
+/* Function prototypes */
+void test_section_manager_lifecycle(void);
+void test_section_create_and_find(void);
+void test_section_fragments(void);
+void test_section_merge(void);
+void test_section_layout_order(void);
+void test_section_layout_overflow(void);
+void test_section_index_growth(void);
+void test_section_invalid_alignment(void);
+void test_section_ranked_layout(void);
+int test_section_main(void);
+
+#define TEST_MANY_SECTIONS 1000
+
+/* Test fixture data */
+static memory_pool_t* test_pool;
+static section_manager_t* test_manager;
+
+void setUp(void) {
+    test_pool = memory_pool_create_growable(0, 0);
+    test_manager = section_manager_create(test_pool);
+}
+
+void tearDown(void) {
+    section_manager_destroy(test_manager);
+    memory_pool_destroy(test_pool);
+    test_manager = NULL;
+    test_pool = NULL;
+}
+
+static section_id_t create(const char* name, uint16_t flags) {
+    section_id_t id = section_manager_create_section(test_manager, name,
+                                                     section_type_from_flags(flags), flags);
+    
+    TEST_ASSERT_TRUE(id != SECTION_ID_INVALID);
+    return id;
+}
+
+void test_section_manager_lifecycle(void) {
+    TEST_ASSERT_NOT_NULL(test_manager);
+    TEST_ASSERT_TRUE(section_manager_is_empty(test_manager));
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)section_manager_get_count(test_manager));
+    TEST_ASSERT_NULL(section_manager_create(NULL));
+    TEST_ASSERT_TRUE(section_manager_is_empty(NULL));
+    section_manager_destroy(NULL);
+}
+
+void test_section_create_and_find(void) {
+    section_id_t text = create(".text", SECTION_FLAG_EXECUTABLE);
+    section_id_t data = create(".data", SECTION_FLAG_WRITABLE);
+    section_id_t again = create(".text", SECTION_FLAG_EXECUTABLE);
+    const section_t* section = section_manager_get_section(test_manager, data);
+    
+    TEST_ASSERT_EQUAL_UINT(3, (uint32_t)section_manager_get_count(test_manager));
+    TEST_ASSERT_TRUE(text != again);
+    
+    /* The first section of a name is the one found */
+    TEST_ASSERT_EQUAL_UINT(text, section_manager_find_section(test_manager, ".text"));
+    TEST_ASSERT_EQUAL_UINT(data, section_manager_find_section(test_manager, ".data"));
+    TEST_ASSERT_EQUAL_UINT(SECTION_ID_INVALID, section_manager_find_section(test_manager, ".bss"));
+    TEST_ASSERT_EQUAL_UINT(SECTION_ID_INVALID, section_manager_find_section(test_manager, NULL));
+    
+    TEST_ASSERT_NOT_NULL(section);
+    TEST_ASSERT_EQUAL_STRING(".data", section->name);
+    TEST_ASSERT_EQUAL_INT(SECTION_TYPE_DATA, section->type);
+    TEST_ASSERT_EQUAL_UINT(1, section->alignment);
+    TEST_ASSERT_EQUAL_UINT(0, section->size);
+    TEST_ASSERT_NULL(section_manager_get_section(test_manager, SECTION_ID_INVALID));
+    TEST_ASSERT_NULL(section_manager_get_section(test_manager, 42));
+    TEST_ASSERT_EQUAL_UINT(SECTION_ID_INVALID,
+                           section_manager_create_section(test_manager, NULL,
+                                                          SECTION_TYPE_TEXT, 0));
+}
+
+void test_section_fragments(void) {
+    const uint8_t first[3] = {1, 2, 3};
+    const uint8_t second[8] = {4, 5, 6, 7, 8, 9, 10, 11};
+    section_id_t id = create(".data", SECTION_FLAG_WRITABLE | SECTION_FLAG_ZERO_FILL);
+    const section_t* section = section_manager_get_section(test_manager, id);
+    const section_fragment_t* fragment;
+    uint32_t offset;
+    
+    /* Zero fill stays zero fill */
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          section_manager_add_data(test_manager, id, NULL, 5, 1, &offset));
+    TEST_ASSERT_EQUAL_UINT(0, offset);
+    TEST_ASSERT_TRUE(section_is_zero_fill(section));
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          section_manager_add_data(test_manager, id, first, sizeof(first), 4, &offset));
+    TEST_ASSERT_EQUAL_UINT(8, offset);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          section_manager_add_data(test_manager, id, second, sizeof(second), 8, &offset));
+    TEST_ASSERT_EQUAL_UINT(16, offset);
+    TEST_ASSERT_FALSE(section_is_zero_fill(section));
+    TEST_ASSERT_EQUAL_UINT(24, section->size);
+    TEST_ASSERT_EQUAL_UINT(8, section->alignment);
+    TEST_ASSERT_EQUAL_UINT(3, (uint32_t)section->fragment_count);
+    
+    /* Fragments reference the caller's memory */
+    fragment = section->fragments;
+    TEST_ASSERT_NULL(fragment->data);
+    fragment = fragment->next;
+    TEST_ASSERT_EQUAL_PTR(first, fragment->data);
+    TEST_ASSERT_EQUAL_UINT(8, fragment->offset);
+    fragment = fragment->next;
+    TEST_ASSERT_EQUAL_PTR(second, fragment->data);
+    TEST_ASSERT_EQUAL_UINT(16, fragment->offset);
+    TEST_ASSERT_NULL(fragment->next);
+}
+
+void test_section_merge(void) {
+    const uint8_t a_data[4] = {0x11, 0x22, 0x33, 0x44};
+    const uint8_t b_data[4] = {0x55, 0x66, 0x77, 0x88};
+    section_id_t a = create(".data", SECTION_FLAG_WRITABLE);
+    section_id_t b = create(".data", SECTION_FLAG_WRITABLE);
+    const section_t* merged;
+    uint32_t offset;
+    
+    section_manager_add_data(test_manager, a, a_data, 3, 1, NULL);
+    section_manager_add_data(test_manager, b, b_data, sizeof(b_data), 1, NULL);
+    section_manager_set_alignment(test_manager, a, 16);
+    
+    /* Merging the indexed section away re-indexes the survivor */
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, section_manager_merge_sections(test_manager, b, a, &offset));
+    TEST_ASSERT_EQUAL_UINT(16, offset);
+    TEST_ASSERT_NULL(section_manager_get_section(test_manager, a));
+    TEST_ASSERT_EQUAL_UINT(b, section_manager_find_section(test_manager, ".data"));
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)section_manager_get_count(test_manager));
+    
+    merged = section_manager_get_section(test_manager, b);
+    TEST_ASSERT_EQUAL_UINT(19, merged->size);
+    TEST_ASSERT_EQUAL_UINT(16, merged->alignment);
+    TEST_ASSERT_EQUAL_UINT(2, (uint32_t)merged->fragment_count);
+    TEST_ASSERT_EQUAL_PTR(b_data, merged->fragments->data);
+    TEST_ASSERT_EQUAL_PTR(a_data, merged->fragments->next->data);
+    TEST_ASSERT_EQUAL_UINT(16, merged->fragments->next->offset);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_ARGUMENT,
+                          section_manager_merge_sections(test_manager, b, a, NULL));
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_ARGUMENT,
+                          section_manager_merge_sections(test_manager, b, b, NULL));
+}
+
+void test_section_layout_order(void) {
+    section_id_t bss = create(".bss", SECTION_FLAG_WRITABLE | SECTION_FLAG_ZERO_FILL);
+    section_id_t data = create(".data", SECTION_FLAG_WRITABLE);
+    section_id_t rodata = create(".rodata", SECTION_FLAG_READABLE);
+    section_id_t text = create(".text", SECTION_FLAG_EXECUTABLE);
+    section_id_t init = create(".init", SECTION_FLAG_EXECUTABLE);
+    const section_id_t* layout;
+    size_t count;
+    
+    section_manager_add_data(test_manager, bss, NULL, 200, 16, NULL);
+    section_manager_add_data(test_manager, data, NULL, 50, 8, NULL);
+    section_manager_add_data(test_manager, data, (const uint8_t*)"x", 1, 1, NULL);
+    section_manager_add_data(test_manager, rodata, (const uint8_t*)"abc", 3, 1, NULL);
+    section_manager_add_data(test_manager, text, NULL, 100, 4, NULL);
+    section_manager_add_data(test_manager, init, NULL, 6, 16, NULL);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, section_manager_calculate_layout(test_manager, 0x10000));
+    
+    /* Code (largest alignment first), read-only, writable, zero fill */
+    layout = section_manager_get_layout(test_manager, &count);
+    TEST_ASSERT_EQUAL_UINT(5, (uint32_t)count);
+    TEST_ASSERT_EQUAL_UINT(init, layout[0]);
+    TEST_ASSERT_EQUAL_UINT(text, layout[1]);
+    TEST_ASSERT_EQUAL_UINT(rodata, layout[2]);
+    TEST_ASSERT_EQUAL_UINT(data, layout[3]);
+    TEST_ASSERT_EQUAL_UINT(bss, layout[4]);
+    
+    TEST_ASSERT_EQUAL_HEX32(0x10000, section_manager_get_section(test_manager, init)->address);
+    TEST_ASSERT_EQUAL_HEX32(0x10008, section_manager_get_section(test_manager, text)->address);
+    TEST_ASSERT_EQUAL_HEX32(0x1006C, section_manager_get_section(test_manager, rodata)->address);
+    TEST_ASSERT_EQUAL_HEX32(0x10070, section_manager_get_section(test_manager, data)->address);
+    TEST_ASSERT_EQUAL_HEX32(0x100B0, section_manager_get_section(test_manager, bss)->address);
+    TEST_ASSERT_EQUAL_UINT(4, section_manager_get_section(test_manager, bss)->layout_index);
+}
+
+void test_section_layout_overflow(void) {
+    section_id_t big = create(".big", SECTION_FLAG_WRITABLE | SECTION_FLAG_ZERO_FILL);
+    
+    section_manager_add_data(test_manager, big, NULL, 0x80000000U, 1, NULL);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, section_manager_calculate_layout(test_manager, 0x7FFFFFFFU));
+    TEST_ASSERT_EQUAL_INT(ERROR_OUTPUT_TOO_LARGE,
+                          section_manager_calculate_layout(test_manager, 0x80000001U));
+    TEST_ASSERT_EQUAL_INT(ERROR_OUTPUT_TOO_LARGE,
+                          section_manager_add_data(test_manager, big, NULL, 0x80000000U, 1, NULL));
+}
+
+void test_section_index_growth(void) {
+    section_id_t ids[TEST_MANY_SECTIONS];
+    char name[32];
+    size_t i;
+    
+    for (i = 0; i < TEST_MANY_SECTIONS; i++) {
+        snprintf(name, sizeof(name), ".text.func_%u", (unsigned)i);
+        ids[i] = create(name, SECTION_FLAG_EXECUTABLE);
+    }
+    
+    for (i = 0; i < TEST_MANY_SECTIONS; i++) {
+        snprintf(name, sizeof(name), ".text.func_%u", (unsigned)i);
+        TEST_ASSERT_EQUAL_UINT(ids[i], section_manager_find_section(test_manager, name));
+    }
+    TEST_ASSERT_EQUAL_UINT(TEST_MANY_SECTIONS, (uint32_t)section_manager_get_count(test_manager));
+}
+
+void test_section_invalid_alignment(void) {
+    section_id_t id = create(".aligned", SECTION_FLAG_READABLE);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, section_manager_set_alignment(test_manager, id, 16));
+    TEST_ASSERT_EQUAL_INT(ERROR_SECTION_ALIGNMENT, section_manager_set_alignment(test_manager, id, 3));
+    TEST_ASSERT_EQUAL_INT(ERROR_SECTION_ALIGNMENT, section_manager_set_alignment(test_manager, id, 0));
+    TEST_ASSERT_EQUAL_INT(ERROR_SECTION_ALIGNMENT,
+                          section_manager_add_data(test_manager, id, NULL, 4, 6, NULL));
+    TEST_ASSERT_EQUAL_UINT(16, section_manager_get_section(test_manager, id)->alignment);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SECTION_ALIGNMENT,
+                          section_manager_assign_address(test_manager, id, 0x1004));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, section_manager_assign_address(test_manager, id, 0x1010));
+    TEST_ASSERT_EQUAL_HEX32(0x1010, section_manager_get_section(test_manager, id)->address);
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_ARGUMENT,
+                          section_manager_assign_address(test_manager, 99, 0x1000));
+}
+
+void test_section_ranked_layout(void) {
+    section_id_t text = create(".text", SECTION_FLAG_EXECUTABLE);
+    section_id_t data = create(".data", SECTION_FLAG_WRITABLE);
+    section_id_t comment = create(".comment", SECTION_FLAG_READABLE);
+    const section_id_t* layout;
+    size_t count;
+    
+    section_manager_add_data(test_manager, text, NULL, 0x20, 4, NULL);
+    section_manager_add_data(test_manager, data, NULL, 0x10, 4, NULL);
+    section_manager_add_data(test_manager, comment, NULL, 0x8, 1, NULL);
+    
+    /* Ranked sections come first in rank order; unranked ones follow */
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, section_manager_set_rank(test_manager, data, 0));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, section_manager_set_rank(test_manager, text, 1));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, section_manager_set_start(test_manager, text, 0x2002));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, section_manager_calculate_layout(test_manager, 0x1000));
+    
+    layout = section_manager_get_layout(test_manager, &count);
+    TEST_ASSERT_EQUAL_UINT(3, (uint32_t)count);
+    TEST_ASSERT_EQUAL_UINT(data, layout[0]);
+    TEST_ASSERT_EQUAL_UINT(text, layout[1]);
+    TEST_ASSERT_EQUAL_UINT(comment, layout[2]);
+    TEST_ASSERT_EQUAL_HEX32(0x1000, section_manager_get_section(test_manager, data)->address);
+    TEST_ASSERT_EQUAL_HEX32(0x2004, section_manager_get_section(test_manager, text)->address);
+    TEST_ASSERT_EQUAL_HEX32(0x2024, section_manager_get_section(test_manager, comment)->address);
+    
+    /* A start the earlier sections already cover cannot be met */
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, section_manager_set_start(test_manager, text, 0x1008));
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_SECTION,
+                          section_manager_calculate_layout(test_manager, 0x1000));
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_ARGUMENT, section_manager_set_rank(test_manager, 99, 0));
+}
+
+int test_section_main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_section_manager_lifecycle);
+    RUN_TEST(test_section_create_and_find);
+    RUN_TEST(test_section_fragments);
+    RUN_TEST(test_section_merge);
+    RUN_TEST(test_section_layout_order);
+    RUN_TEST(test_section_layout_overflow);
+    RUN_TEST(test_section_index_growth);
+    RUN_TEST(test_section_invalid_alignment);
+    RUN_TEST(test_section_ranked_layout);
+    
+    return UNITY_END();
+}
+
+int main(void) {
+    return test_section_main();
+}
@@ -1,13 +1,16 @@
 /* tests/test_smof.c */
 #include "unity.h"
 #include "smof.h"
+#include "error.h"
 #include <stdio.h>
+#include <stddef.h>
 #include <string.h>
 
 /**
  * @file test_smof.c  
  * @brief Unit tests for SMOF format implementation
- * @details Tests SMOF header validation, structure layout, and utility functions
+ * @details Tests SMOF header validation, structure layout, header decoding
+ * and byte swapping
  */
 
 /* Function prototypes for C90 compliance */
@@ -18,25 +21,28 @@ void test_smof_validate_header_null_header(void);
 void test_smof_get_header_size(void);
 void test_smof_header_alignment(void);
 void test_smof_magic_constant(void);
-void test_smof_section_type_values(void);
+void test_smof_section_flag_values(void);
 void test_smof_symbol_binding_values(void);
 void test_smof_symbol_type_values(void);
-void test_smof_symbol_utility_functions(void);
-void test_smof_relocation_utility_functions(void);
+void test_smof_decode_header(void);
+void test_smof_swap_header_round_trip(void);
+void test_smof_builder_limits(void);
 int test_smof_main(void);
 
 /* Test data */
 static const smof_header_t valid_header = {
     .magic = SMOF_MAGIC,
-    .version = SMOF_VERSION,
+    .version = SMOF_VERSION_CURRENT,
     .flags = SMOF_FLAG_LITTLE_ENDIAN,
     .entry_point = 0x1000,
     .section_count = 2,
     .symbol_count = 5,
-    .section_table_offset = 32,
-    .symbol_table_offset = 112,
-    .string_table_offset = 192,
-    .checksum = 0
+    .string_table_offset = 156,
+    .string_table_size = 32,
+    .section_table_offset = 36,
+    .reloc_table_offset = 156,
+    .reloc_count = 0,
+    .import_count = 0
 };
 
 void setUp(void) {
@@ -49,7 +55,6 @@ void tearDown(void) {
 
 void test_smof_validate_header_valid(void) {
     TEST_ASSERT_TRUE(smof_validate_header(&valid_header));
-    TEST_ASSERT_TRUE(smof_header_is_valid(&valid_header));
 }
 
 void test_smof_validate_header_invalid_magic(void) {
@@ -57,7 +62,6 @@ void test_smof_validate_header_invalid_magic(void) {
     header.magic = 0x12345678;
     
     TEST_ASSERT_FALSE(smof_validate_header(&header));
-    TEST_ASSERT_FALSE(smof_header_is_valid(&header));
 }
 
 void test_smof_validate_header_invalid_version(void) {
@@ -65,28 +69,32 @@ void test_smof_validate_header_invalid_version(void) {
     header.version = 99;
     
     TEST_ASSERT_FALSE(smof_validate_header(&header));
-    TEST_ASSERT_FALSE(smof_header_is_valid(&header));
 }
 
 void test_smof_validate_header_null_header(void) {
     TEST_ASSERT_FALSE(smof_validate_header(NULL));
-    TEST_ASSERT_FALSE(smof_header_is_valid(NULL));
 }
 
 void test_smof_get_header_size(void) {
     size_t size = sizeof(smof_header_t);
     
-    TEST_ASSERT_EQUAL_UINT(32, (uint32_t)size);
+    TEST_ASSERT_EQUAL_UINT(36, (uint32_t)size);
 }
 
 void test_smof_header_alignment(void) {
     /* Test structure member offsets and alignment */
-    TEST_ASSERT_EQUAL_UINT(0, offsetof(smof_header_t, magic));
-    TEST_ASSERT_EQUAL_UINT(4, offsetof(smof_header_t, version));
-    TEST_ASSERT_EQUAL_UINT(6, offsetof(smof_header_t, flags));
-    TEST_ASSERT_EQUAL_UINT(8, offsetof(smof_header_t, entry_point));
-    TEST_ASSERT_EQUAL_UINT(12, offsetof(smof_header_t, section_count));
-    TEST_ASSERT_EQUAL_UINT(14, offsetof(smof_header_t, symbol_count));
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)offsetof(smof_header_t, magic));
+    TEST_ASSERT_EQUAL_UINT(4, (uint32_t)offsetof(smof_header_t, version));
+    TEST_ASSERT_EQUAL_UINT(6, (uint32_t)offsetof(smof_header_t, flags));
+    TEST_ASSERT_EQUAL_UINT(8, (uint32_t)offsetof(smof_header_t, entry_point));
+    TEST_ASSERT_EQUAL_UINT(12, (uint32_t)offsetof(smof_header_t, section_count));
+    TEST_ASSERT_EQUAL_UINT(14, (uint32_t)offsetof(smof_header_t, symbol_count));
+    
+    /* Table entries are packed to their on-disk sizes */
+    TEST_ASSERT_EQUAL_UINT(20, (uint32_t)sizeof(smof_section_t));
+    TEST_ASSERT_EQUAL_UINT(16, (uint32_t)sizeof(smof_symbol_t));
+    TEST_ASSERT_EQUAL_UINT(8, (uint32_t)sizeof(smof_relocation_t));
+    TEST_ASSERT_EQUAL_UINT(56, (uint32_t)sizeof(smof_header_v2_t));
 }
 
 void test_smof_magic_constant(void) {
@@ -94,69 +102,98 @@ void test_smof_magic_constant(void) {
     TEST_ASSERT_EQUAL_HEX32(0x534D4F46U, SMOF_MAGIC);
 }
 
-void test_smof_section_type_values(void) {
-    /* Test section type enumeration values */
-    TEST_ASSERT_EQUAL_UINT(0, SMOF_SECTION_NULL);
-    TEST_ASSERT_EQUAL_UINT(1, SMOF_SECTION_PROGBITS);
-    TEST_ASSERT_EQUAL_UINT(2, SMOF_SECTION_SYMTAB);
-    TEST_ASSERT_EQUAL_UINT(3, SMOF_SECTION_STRTAB);
-    TEST_ASSERT_EQUAL_UINT(4, SMOF_SECTION_RELA);
-    TEST_ASSERT_EQUAL_UINT(9, SMOF_SECTION_REL);
+void test_smof_section_flag_values(void) {
+    /* Test section flag bits */
+    TEST_ASSERT_EQUAL_HEX16(0x0001, SMOF_SECT_EXECUTABLE);
+    TEST_ASSERT_EQUAL_HEX16(0x0002, SMOF_SECT_WRITABLE);
+    TEST_ASSERT_EQUAL_HEX16(0x0004, SMOF_SECT_READABLE);
+    TEST_ASSERT_EQUAL_HEX16(0x0008, SMOF_SECT_LOADABLE);
+    TEST_ASSERT_EQUAL_HEX16(0x0010, SMOF_SECT_ZERO_FILL);
 }
 
 void test_smof_symbol_binding_values(void) {
-    /* Test symbol binding enumeration values */
-    TEST_ASSERT_EQUAL_UINT(0, SMOF_STB_LOCAL);
-    TEST_ASSERT_EQUAL_UINT(1, SMOF_STB_GLOBAL);
-    TEST_ASSERT_EQUAL_UINT(2, SMOF_STB_WEAK);
+    /* Test symbol binding values */
+    TEST_ASSERT_EQUAL_UINT(0, SMOF_BIND_LOCAL);
+    TEST_ASSERT_EQUAL_UINT(1, SMOF_BIND_GLOBAL);
+    TEST_ASSERT_EQUAL_UINT(2, SMOF_BIND_WEAK);
 }
 
 void test_smof_symbol_type_values(void) {
-    /* Test symbol type enumeration values */
-    TEST_ASSERT_EQUAL_UINT(0, SMOF_STT_NOTYPE);
-    TEST_ASSERT_EQUAL_UINT(1, SMOF_STT_OBJECT);
-    TEST_ASSERT_EQUAL_UINT(2, SMOF_STT_FUNC);
-    TEST_ASSERT_EQUAL_UINT(3, SMOF_STT_SECTION);
-    TEST_ASSERT_EQUAL_UINT(4, SMOF_STT_FILE);
+    /* Test symbol type values */
+    TEST_ASSERT_EQUAL_UINT(0, SMOF_SYM_NOTYPE);
+    TEST_ASSERT_EQUAL_UINT(1, SMOF_SYM_OBJECT);
+    TEST_ASSERT_EQUAL_UINT(2, SMOF_SYM_FUNC);
+    TEST_ASSERT_EQUAL_UINT(3, SMOF_SYM_SECTION);
+    TEST_ASSERT_EQUAL_UINT(4, SMOF_SYM_FILE);
 }
 
-void test_smof_symbol_utility_functions(void) {
-    smof_symbol_t symbol;
-    uint8_t info;
-    
-    /* Test symbol info encoding/decoding */
-    info = smof_symbol_make_info(SMOF_STB_GLOBAL, SMOF_STT_FUNC);
-    symbol.info = info;
+void test_smof_decode_header(void) {
+    smof_layout_t layout;
     
-    TEST_ASSERT_EQUAL_UINT((uint32_t)SMOF_STB_GLOBAL, (uint32_t)smof_symbol_get_binding(&symbol));
-    TEST_ASSERT_EQUAL_UINT((uint32_t)SMOF_STT_FUNC, (uint32_t)smof_symbol_get_type(&symbol));
+    /* A v1 header decodes to host-type counts and offsets */
+    TEST_ASSERT_EQUAL_INT(0, smof_decode_header(&valid_header, sizeof(valid_header), &layout));
+    TEST_ASSERT_EQUAL_UINT(SMOF_VERSION_CURRENT, layout.version);
+    TEST_ASSERT_EQUAL_UINT(2, layout.section_count);
+    TEST_ASSERT_EQUAL_UINT(5, layout.symbol_count);
+    TEST_ASSERT_TRUE(layout.symbol_table_offset == 36 + 2 * sizeof(smof_section_t));
+    TEST_ASSERT_TRUE(layout.header_size == sizeof(smof_header_t));
+    TEST_ASSERT_TRUE(layout.reloc_entry_size == sizeof(smof_relocation_t));
     
-    /* Test different combinations */
-    info = smof_symbol_make_info(SMOF_STB_LOCAL, SMOF_STT_OBJECT);
-    symbol.info = info;
-    
-    TEST_ASSERT_EQUAL_UINT((uint32_t)SMOF_STB_LOCAL, (uint32_t)smof_symbol_get_binding(&symbol));
-    TEST_ASSERT_EQUAL_UINT((uint32_t)SMOF_STT_OBJECT, (uint32_t)smof_symbol_get_type(&symbol));
+    /* Truncated headers are rejected */
+    TEST_ASSERT_TRUE(smof_decode_header(&valid_header, sizeof(valid_header) - 1, &layout) != 0);
 }
 
-void test_smof_relocation_utility_functions(void) {
-    uint32_t info;
-    uint32_t symbol_index = 42;
-    smof_relocation_type_t rel_type = SMOF_R_32;
+void test_smof_swap_header_round_trip(void) {
+    smof_header_t header = valid_header;
     
-    /* Test relocation info encoding/decoding */
-    info = smof_relocation_make_info(symbol_index, rel_type);
+    /* A swapped header is foreign, and swapping it back restores it */
+    smof_swap_header(&header);
+    TEST_ASSERT_EQUAL_HEX32(SMOF_MAGIC_SWAPPED, header.magic);
+    TEST_ASSERT_TRUE(smof_is_foreign(&header, sizeof(header)));
+    smof_swap_header(&header);
+    TEST_ASSERT_EQUAL_MEMORY(&valid_header, &header, sizeof(header));
+    TEST_ASSERT_FALSE(smof_is_foreign(&header, sizeof(header)));
+}
+
+void test_smof_builder_limits(void) {
+    smof_context_t ctx;
+    char name[32];
+    char long_name[4096];
+    int result = 0;
+    int i;
     
-    TEST_ASSERT_EQUAL_UINT(symbol_index, smof_relocation_get_symbol(info));
-    TEST_ASSERT_EQUAL_UINT((uint32_t)rel_type, (uint32_t)smof_relocation_get_type(info));
+    /* The builder writes version 1 and refuses entries past its limits */
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, smof_init_context(&ctx));
+    for (i = 0; i < SMOF_V1_MAX_SECTIONS && result >= 0; i++) {
+        snprintf(name, sizeof(name), ".s%d", i);
+        result = smof_add_section(&ctx, name, 0, 0, 0, 0, 0, NULL);
+    }
+    TEST_ASSERT_EQUAL_INT(SMOF_V1_MAX_SECTIONS - 1, result);
+    TEST_ASSERT_EQUAL_INT(ERROR_SYSTEM_LIMIT, smof_add_section(&ctx, ".more", 0, 0, 0, 0, 0, NULL));
     
-    /* Test different values */
-    symbol_index = 255;
-    rel_type = SMOF_R_PC16;
-    info = smof_relocation_make_info(symbol_index, rel_type);
+    for (i = 0; i < SMOF_V1_MAX_SYMBOLS && result >= 0; i++) {
+        result = smof_add_symbol(&ctx, "sym", (uint32_t)i, 0, 0, SMOF_SYM_OBJECT, SMOF_BIND_LOCAL);
+    }
+    TEST_ASSERT_EQUAL_INT(SMOF_V1_MAX_SYMBOLS - 1, result);
+    TEST_ASSERT_EQUAL_INT(ERROR_SYSTEM_LIMIT, smof_add_symbol(&ctx, "sym", 0, 0, 0,
+                                                              SMOF_SYM_OBJECT, SMOF_BIND_LOCAL));
+    smof_cleanup_context(&ctx);
     
-    TEST_ASSERT_EQUAL_UINT(symbol_index, smof_relocation_get_symbol(info));
-    TEST_ASSERT_EQUAL_UINT((uint32_t)rel_type, (uint32_t)smof_relocation_get_type(info));
+    /* Names fill the string table up to its limit */
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, smof_init_context(&ctx));
+    memset(long_name, 'x', sizeof(long_name) - 1);
+    long_name[sizeof(long_name) - 1] = '\0';
+    result = 0;
+    for (i = 0; result >= 0; i++) {
+        snprintf(name, sizeof(name), "%08d", i);
+        memcpy(long_name, name, 8);
+        result = smof_add_symbol(&ctx, long_name, 0, 0, 0, SMOF_SYM_OBJECT, SMOF_BIND_LOCAL);
+    }
+    TEST_ASSERT_EQUAL_INT(ERROR_SYSTEM_LIMIT, result);
+    /* The table starts with the empty string */
+    TEST_ASSERT_EQUAL_INT((SMOF_V1_MAX_STRING_TABLE - 1) / (int)sizeof(long_name), i - 1);
+    TEST_ASSERT_TRUE(ctx.header.string_table_size <= SMOF_V1_MAX_STRING_TABLE);
+    smof_cleanup_context(&ctx);
 }
 
 int test_smof_main(void) {
@@ -169,11 +206,12 @@ int test_smof_main(void) {
     RUN_TEST(test_smof_get_header_size);
     RUN_TEST(test_smof_header_alignment);
     RUN_TEST(test_smof_magic_constant);
-    RUN_TEST(test_smof_section_type_values);
+    RUN_TEST(test_smof_section_flag_values);
     RUN_TEST(test_smof_symbol_binding_values);
     RUN_TEST(test_smof_symbol_type_values);
-    RUN_TEST(test_smof_symbol_utility_functions);
-    RUN_TEST(test_smof_relocation_utility_functions);
+    RUN_TEST(test_smof_decode_header);
+    RUN_TEST(test_smof_swap_header_round_trip);
+    RUN_TEST(test_smof_builder_limits);
     
     return UNITY_END();
 }
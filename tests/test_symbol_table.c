@@ -0,0 +1,247 @@
+/* tests/test_symbol_table.c */
+#include "unity.h"
+#include "symbol_table.h"
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @file test_symbol_table.c
+ * @brief Unit tests for the STLD global symbol table
+ * @details Tests insertion, hashed lookup, weak/undefined merging and growth
+ */
+
+/* Function prototypes */
+void test_symbol_table_create(void);
+void test_symbol_table_insert_lookup(void);
+void test_symbol_table_get_invalid(void);
+void test_symbol_table_duplicate(void);
+void test_symbol_table_weak_override(void);
+void test_symbol_table_undefined_resolved_in_place(void);
+void test_symbol_table_local_symbols(void);
+void test_symbol_table_growth(void);
+void test_symbol_table_iteration(void);
+void test_symbol_table_null_parameters(void);
+int test_symbol_table_main(void);
+
+/* Test table for testing */
+static symbol_table_t* test_table;
+
+void setUp(void) {
+    test_table = symbol_table_create(0);
+}
+
+void tearDown(void) {
+    if (test_table) {
+        symbol_table_destroy(test_table);
+        test_table = NULL;
+    }
+}
+
+static symbol_t make_symbol(const char* name, symbol_binding_t binding,
+                            uint16_t section_index, uint32_t value) {
+    symbol_t symbol = {
+        .name = name,
+        .type = SYMBOL_TYPE_FUNCTION,
+        .binding = binding,
+        .visibility = SYMBOL_VISIBILITY_DEFAULT,
+        .section_index = section_index,
+        .value = value,
+        .size = 0
+    };
+    return symbol;
+}
+
+void test_symbol_table_create(void) {
+    TEST_ASSERT_NOT_NULL(test_table);
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)symbol_table_size(test_table));
+    TEST_ASSERT_TRUE(symbol_table_is_empty(test_table));
+    TEST_ASSERT_TRUE(symbol_table_get_memory_usage(test_table) > 0);
+}
+
+void test_symbol_table_insert_lookup(void) {
+    symbol_t a = make_symbol("main", SYMBOL_BINDING_GLOBAL, 1, 0x1000);
+    symbol_t b = make_symbol("helper", SYMBOL_BINDING_GLOBAL, 1, 0x2000);
+    symbol_handle_t ha = symbol_table_insert(test_table, &a);
+    symbol_handle_t hb = symbol_table_insert(test_table, &b);
+    symbol_t found;
+    
+    TEST_ASSERT_TRUE(ha != SYMBOL_HANDLE_INVALID);
+    TEST_ASSERT_TRUE(hb != SYMBOL_HANDLE_INVALID);
+    TEST_ASSERT_TRUE(ha != hb);
+    TEST_ASSERT_EQUAL_UINT(ha, symbol_table_lookup(test_table, "main"));
+    TEST_ASSERT_EQUAL_UINT(hb, symbol_table_lookup(test_table, "helper"));
+    TEST_ASSERT_EQUAL_UINT(SYMBOL_HANDLE_INVALID, symbol_table_lookup(test_table, "missing"));
+    
+    TEST_ASSERT_TRUE(symbol_table_get(test_table, hb, &found));
+    TEST_ASSERT_EQUAL_STRING("helper", found.name);
+    TEST_ASSERT_EQUAL_UINT(0x2000, found.value);
+    TEST_ASSERT_EQUAL_INT(SYMBOL_BINDING_GLOBAL, found.binding);
+    TEST_ASSERT_EQUAL_INT(SYMBOL_TYPE_FUNCTION, found.type);
+    TEST_ASSERT_EQUAL_UINT(1, found.section_index);
+    
+    /* Names are interned, not borrowed */
+    TEST_ASSERT_TRUE(found.name != b.name);
+    TEST_ASSERT_EQUAL_STRING("main", symbol_table_get_name(test_table, ha));
+    TEST_ASSERT_EQUAL_UINT(0x1000, symbol_table_get_value(test_table, ha));
+}
+
+void test_symbol_table_get_invalid(void) {
+    symbol_t a = make_symbol("only", SYMBOL_BINDING_GLOBAL, 1, 0);
+    symbol_t found;
+    
+    symbol_table_insert(test_table, &a);
+    TEST_ASSERT_FALSE(symbol_table_get(test_table, SYMBOL_HANDLE_INVALID, &found));
+    TEST_ASSERT_FALSE(symbol_table_get(test_table, 100, &found));
+    TEST_ASSERT_FALSE(symbol_table_get(test_table, 0, NULL));
+    TEST_ASSERT_NULL(symbol_table_get_name(test_table, 100));
+    TEST_ASSERT_EQUAL_UINT(SECTION_INDEX_UNDEFINED,
+                           symbol_table_get_section_index(test_table, 100));
+}
+
+void test_symbol_table_duplicate(void) {
+    symbol_t a = make_symbol("dup", SYMBOL_BINDING_GLOBAL, 1, 0x10);
+    symbol_t b = make_symbol("dup", SYMBOL_BINDING_GLOBAL, 2, 0x20);
+    
+    TEST_ASSERT_TRUE(symbol_table_insert(test_table, &a) != SYMBOL_HANDLE_INVALID);
+    TEST_ASSERT_EQUAL_UINT(SYMBOL_HANDLE_INVALID, symbol_table_insert(test_table, &b));
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)symbol_table_size(test_table));
+}
+
+void test_symbol_table_weak_override(void) {
+    symbol_t weak = make_symbol("handler", SYMBOL_BINDING_WEAK, 1, 0x100);
+    symbol_t strong = make_symbol("handler", SYMBOL_BINDING_GLOBAL, 1, 0x200);
+    symbol_t weak2 = make_symbol("handler", SYMBOL_BINDING_WEAK, 1, 0x300);
+    symbol_handle_t hw = symbol_table_insert(test_table, &weak);
+    symbol_handle_t hs = symbol_table_insert(test_table, &strong);
+    symbol_t found;
+    
+    TEST_ASSERT_EQUAL_UINT(hw, hs);
+    TEST_ASSERT_EQUAL_UINT(hs, symbol_table_insert(test_table, &weak2));
+    
+    TEST_ASSERT_TRUE(symbol_table_get(test_table, symbol_table_lookup(test_table, "handler"),
+                                      &found));
+    TEST_ASSERT_EQUAL_INT(SYMBOL_BINDING_GLOBAL, found.binding);
+    TEST_ASSERT_EQUAL_UINT(0x200, found.value);
+}
+
+void test_symbol_table_undefined_resolved_in_place(void) {
+    symbol_t ref = make_symbol("printf", SYMBOL_BINDING_GLOBAL, SECTION_INDEX_UNDEFINED, 0);
+    symbol_t def = make_symbol("printf", SYMBOL_BINDING_GLOBAL, 3, 0x4000);
+    symbol_t weak_ref = make_symbol("optional", SYMBOL_BINDING_WEAK, SECTION_INDEX_UNDEFINED, 0);
+    symbol_handle_t href = symbol_table_insert(test_table, &ref);
+    symbol_t found;
+    
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)symbol_table_count_undefined(test_table));
+    TEST_ASSERT_TRUE(symbol_table_get(test_table, href, &found));
+    TEST_ASSERT_FALSE(symbol_is_defined(&found));
+    
+    TEST_ASSERT_EQUAL_UINT(href, symbol_table_insert(test_table, &def));
+    TEST_ASSERT_EQUAL_UINT(href, symbol_table_insert(test_table, &ref));
+    TEST_ASSERT_TRUE(symbol_table_get(test_table, href, &found));
+    TEST_ASSERT_TRUE(symbol_is_defined(&found));
+    TEST_ASSERT_EQUAL_UINT(0x4000, found.value);
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)symbol_table_count_undefined(test_table));
+    
+    /* Undefined weak references are undefined but not unresolved */
+    symbol_table_insert(test_table, &weak_ref);
+    TEST_ASSERT_EQUAL_UINT(1, (uint32_t)symbol_table_count_undefined(test_table));
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)symbol_table_count_unresolved(test_table));
+}
+
+void test_symbol_table_local_symbols(void) {
+    symbol_t local1 = make_symbol("counter", SYMBOL_BINDING_LOCAL, 1, 0x10);
+    symbol_t local2 = make_symbol("counter", SYMBOL_BINDING_LOCAL, 2, 0x20);
+    symbol_t global = make_symbol("counter", SYMBOL_BINDING_GLOBAL, 3, 0x30);
+    symbol_handle_t h1 = symbol_table_insert(test_table, &local1);
+    symbol_handle_t h2 = symbol_table_insert(test_table, &local2);
+    symbol_handle_t hg;
+    
+    TEST_ASSERT_TRUE(h1 != h2);
+    TEST_ASSERT_EQUAL_UINT(h1, symbol_table_lookup(test_table, "counter"));
+    
+    /* A global takes over name resolution from the locals */
+    hg = symbol_table_insert(test_table, &global);
+    TEST_ASSERT_TRUE(hg != SYMBOL_HANDLE_INVALID);
+    TEST_ASSERT_EQUAL_UINT(hg, symbol_table_lookup(test_table, "counter"));
+    TEST_ASSERT_EQUAL_UINT(3, (uint32_t)symbol_table_size(test_table));
+    TEST_ASSERT_TRUE(symbol_table_get_name(test_table, h1) ==
+                     symbol_table_get_name(test_table, hg));
+}
+
+void test_symbol_table_growth(void) {
+    char name[32];
+    symbol_handle_t handles[5000];
+    symbol_t symbol;
+    uint32_t i;
+    
+    for (i = 0; i < 5000; i++) {
+        snprintf(name, sizeof(name), "sym_%u", i);
+        symbol = make_symbol(name, SYMBOL_BINDING_GLOBAL, 1, i);
+        handles[i] = symbol_table_insert(test_table, &symbol);
+        TEST_ASSERT_TRUE(handles[i] != SYMBOL_HANDLE_INVALID);
+    }
+    
+    TEST_ASSERT_EQUAL_UINT(5000, (uint32_t)symbol_table_size(test_table));
+    
+    for (i = 0; i < 5000; i++) {
+        snprintf(name, sizeof(name), "sym_%u", i);
+        TEST_ASSERT_EQUAL_UINT(handles[i], symbol_table_lookup(test_table, name));
+        TEST_ASSERT_EQUAL_UINT(i, symbol_table_get_value(test_table, handles[i]));
+    }
+}
+
+void test_symbol_table_iteration(void) {
+    const char* names[] = {"a", "b", "c"};
+    symbol_iterator_t iter;
+    symbol_t symbol;
+    uint32_t count = 0;
+    uint32_t i;
+    
+    for (i = 0; i < 3; i++) {
+        symbol = make_symbol(names[i], SYMBOL_BINDING_GLOBAL, 1, i);
+        symbol_table_insert(test_table, &symbol);
+    }
+    
+    for (iter = symbol_table_begin(test_table); symbol_iterator_is_valid(&iter);
+         symbol_iterator_next(&iter)) {
+        TEST_ASSERT_TRUE(symbol_iterator_get(&iter, &symbol));
+        TEST_ASSERT_EQUAL_STRING(names[count], symbol.name);
+        count++;
+    }
+    
+    TEST_ASSERT_EQUAL_UINT(3, count);
+}
+
+void test_symbol_table_null_parameters(void) {
+    symbol_t nameless = make_symbol(NULL, SYMBOL_BINDING_GLOBAL, 1, 0);
+    
+    TEST_ASSERT_EQUAL_UINT(0, (uint32_t)symbol_table_size(NULL));
+    TEST_ASSERT_TRUE(symbol_table_is_empty(NULL));
+    TEST_ASSERT_EQUAL_UINT(SYMBOL_HANDLE_INVALID, symbol_table_lookup(NULL, "x"));
+    TEST_ASSERT_EQUAL_UINT(SYMBOL_HANDLE_INVALID, symbol_table_lookup(test_table, NULL));
+    TEST_ASSERT_EQUAL_UINT(SYMBOL_HANDLE_INVALID, symbol_table_insert(test_table, NULL));
+    TEST_ASSERT_EQUAL_UINT(SYMBOL_HANDLE_INVALID, symbol_table_insert(test_table, &nameless));
+    TEST_ASSERT_FALSE(symbol_table_get(NULL, 0, &nameless));
+    symbol_table_destroy(NULL);
+}
+
+int test_symbol_table_main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_symbol_table_create);
+    RUN_TEST(test_symbol_table_insert_lookup);
+    RUN_TEST(test_symbol_table_get_invalid);
+    RUN_TEST(test_symbol_table_duplicate);
+    RUN_TEST(test_symbol_table_weak_override);
+    RUN_TEST(test_symbol_table_undefined_resolved_in_place);
+    RUN_TEST(test_symbol_table_local_symbols);
+    RUN_TEST(test_symbol_table_growth);
+    RUN_TEST(test_symbol_table_iteration);
+    RUN_TEST(test_symbol_table_null_parameters);
+    
+    return UNITY_END();
+}
+
+int main(void) {
+    return test_symbol_table_main();
+}
@@ -0,0 +1,143 @@
+/* tests/test_thread_pool.c */
+#include "unity.h"
+#include "thread_pool.h"
+#include "error.h"
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @file test_thread_pool.c
+ * @brief Unit tests for the worker thread pool
+ * @details Tests batch execution, serial fallback, error propagation and
+ * pool reuse across batches
+ */
+
+/* Function prototypes */
+void test_thread_pool_create(void);
+void test_thread_pool_runs_every_task(void);
+void test_thread_pool_serial_fallback(void);
+void test_thread_pool_lowest_error_wins(void);
+void test_thread_pool_reuse(void);
+void test_thread_pool_invalid_task(void);
+int test_thread_pool_main(void);
+
+#define TEST_TASK_COUNT 1000
+
+/* Test pool for testing */
+static thread_pool_t* test_pool;
+static unsigned char test_hits[TEST_TASK_COUNT];
+
+void setUp(void) {
+    test_pool = thread_pool_create(4);
+    memset(test_hits, 0, sizeof(test_hits));
+}
+
+void tearDown(void) {
+    if (test_pool) {
+        thread_pool_destroy(test_pool);
+        test_pool = NULL;
+    }
+}
+
+static int mark_task(void* user_data, size_t index) {
+    unsigned char* hits = user_data;
+    
+    hits[index]++;
+    return ERROR_SUCCESS;
+}
+
+static int fail_task(void* user_data, size_t index) {
+    (void)user_data;
+    
+    if (index == 17) {
+        return ERROR_FILE_IO;
+    }
+    if (index == 600) {
+        return ERROR_OUT_OF_MEMORY;
+    }
+    return ERROR_SUCCESS;
+}
+
+void test_thread_pool_create(void) {
+    thread_pool_t* pool = thread_pool_create(0);
+    
+    TEST_ASSERT_NOT_NULL(test_pool);
+    TEST_ASSERT_EQUAL_UINT(4, (uint32_t)thread_pool_get_thread_count(test_pool));
+    TEST_ASSERT_TRUE(thread_pool_is_parallel(test_pool));
+    
+    TEST_ASSERT_NOT_NULL(pool);
+    TEST_ASSERT_TRUE(thread_pool_get_thread_count(pool) >= 1);
+    TEST_ASSERT_TRUE(thread_pool_get_cpu_count() >= 1);
+    thread_pool_destroy(pool);
+}
+
+void test_thread_pool_runs_every_task(void) {
+    size_t i;
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          thread_pool_run(test_pool, TEST_TASK_COUNT, mark_task, test_hits));
+    
+    for (i = 0; i < TEST_TASK_COUNT; i++) {
+        TEST_ASSERT_EQUAL_UINT(1, test_hits[i]);
+    }
+}
+
+void test_thread_pool_serial_fallback(void) {
+    thread_pool_t* pool = thread_pool_create(1);
+    size_t i;
+    
+    TEST_ASSERT_FALSE(thread_pool_is_parallel(pool));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          thread_pool_run(pool, TEST_TASK_COUNT, mark_task, test_hits));
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                          thread_pool_run(NULL, TEST_TASK_COUNT, mark_task, test_hits));
+    
+    for (i = 0; i < TEST_TASK_COUNT; i++) {
+        TEST_ASSERT_EQUAL_UINT(2, test_hits[i]);
+    }
+    
+    thread_pool_destroy(pool);
+}
+
+void test_thread_pool_lowest_error_wins(void) {
+    TEST_ASSERT_EQUAL_INT(ERROR_FILE_IO,
+                          thread_pool_run(test_pool, TEST_TASK_COUNT, fail_task, NULL));
+}
+
+void test_thread_pool_reuse(void) {
+    size_t i;
+    int round;
+    
+    for (round = 0; round < 50; round++) {
+        TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS,
+                              thread_pool_run(test_pool, TEST_TASK_COUNT, mark_task, test_hits));
+    }
+    
+    for (i = 0; i < TEST_TASK_COUNT; i++) {
+        TEST_ASSERT_EQUAL_UINT(50, test_hits[i]);
+    }
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, thread_pool_run(test_pool, 0, mark_task, test_hits));
+}
+
+void test_thread_pool_invalid_task(void) {
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_ARGUMENT, thread_pool_run(test_pool, 10, NULL, NULL));
+    thread_pool_destroy(NULL);
+}
+
+int test_thread_pool_main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_thread_pool_create);
+    RUN_TEST(test_thread_pool_runs_every_task);
+    RUN_TEST(test_thread_pool_serial_fallback);
+    RUN_TEST(test_thread_pool_lowest_error_wins);
+    RUN_TEST(test_thread_pool_reuse);
+    RUN_TEST(test_thread_pool_invalid_task);
+    
+    return UNITY_END();
+}
+
+int main(void) {
+    return test_thread_pool_main();
+}
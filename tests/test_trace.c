@@ -0,0 +1,219 @@
+/* tests/test_trace.c */
+#include "unity.h"
+#include "trace.h"
+#include "error.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * @file test_trace.c
+ * @brief Unit tests for trace spans
+ * @details Tests that spans from several threads reach the trace file,
+ * that sessions can be restarted, that long details keep their end and
+ * that spans outside a session are ignored. Without ENABLE_TRACE only the
+ * stubs' refusal to start is checked.
+ */
+
+#define TEST_TRACE_THREADS 4
+
+/* Function prototypes */
+void test_trace_records_spans(void);
+void test_trace_spans_from_threads(void);
+void test_trace_restart_session(void);
+void test_trace_detail_keeps_end(void);
+void test_trace_rejects_second_start(void);
+int test_trace_main(void);
+
+static char trace_path[64];
+
+void setUp(void) {
+    snprintf(trace_path, sizeof(trace_path), "/tmp/test_trace_%ld.json", (long)getpid());
+}
+
+void tearDown(void) {
+    if (trace_is_active()) {
+        trace_stop();
+    }
+    unlink(trace_path);
+}
+
+/* Whole trace file as a string; the caller frees it */
+static char* read_trace(void) {
+    FILE* file = fopen(trace_path, "r");
+    char* text;
+    long size;
+    
+    TEST_ASSERT_NOT_NULL(file);
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    text = malloc((size_t)size + 1);
+    TEST_ASSERT_NOT_NULL(text);
+    TEST_ASSERT_TRUE(fread(text, 1, (size_t)size, file) == (size_t)size);
+    text[size] = '\0';
+    fclose(file);
+    return text;
+}
+
+static unsigned count_occurrences(const char* text, const char* pattern) {
+    unsigned count = 0;
+    
+    while ((text = strstr(text, pattern)) != NULL) {
+        count++;
+        text += strlen(pattern);
+    }
+    return count;
+}
+
+static void* record_spans(void* arg) {
+    trace_span_t span;
+    int i;
+    
+    (void)arg;
+    for (i = 0; i < 100; i++) {
+        trace_span_begin(&span, "worker_span");
+        trace_span_end(&span, NULL);
+    }
+    return NULL;
+}
+
+void test_trace_records_spans(void) {
+    trace_span_t outer;
+    trace_span_t inner;
+    char* text;
+    
+    if (!trace_is_available()) {
+        TEST_ASSERT_EQUAL_INT(ERROR_INVALID_ARGUMENT, trace_start(trace_path, "test"));
+        TEST_ASSERT_FALSE(trace_is_active());
+        return;
+    }
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, trace_start(trace_path, "test"));
+    TEST_ASSERT_TRUE(trace_is_active());
+    trace_span_begin(&outer, "outer");
+    trace_span_begin(&inner, "inner");
+    trace_span_end(&inner, "quote\"d");
+    trace_span_end(&outer, NULL);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, trace_stop());
+    TEST_ASSERT_FALSE(trace_is_active());
+    
+    text = read_trace();
+    TEST_ASSERT_NOT_NULL(strstr(text, "\"traceEvents\""));
+    TEST_ASSERT_NOT_NULL(strstr(text, "{\"name\":\"outer\",\"cat\":\"test\",\"ph\":\"X\""));
+    TEST_ASSERT_NOT_NULL(strstr(text, "{\"name\":\"inner\",\"cat\":\"test\",\"ph\":\"X\""));
+    TEST_ASSERT_NOT_NULL(strstr(text, "\"args\":{\"detail\":\"quote\\\"d\"}"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "\"dropped_spans\":0"));
+    free(text);
+}
+
+void test_trace_spans_from_threads(void) {
+    pthread_t threads[TEST_TRACE_THREADS];
+    char* text;
+    int i;
+    
+    if (!trace_is_available()) {
+        return;
+    }
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, trace_start(trace_path, "test"));
+    for (i = 0; i < TEST_TRACE_THREADS; i++) {
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[i], NULL, record_spans, NULL));
+    }
+    for (i = 0; i < TEST_TRACE_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, trace_stop());
+    
+    text = read_trace();
+    TEST_ASSERT_EQUAL_UINT(TEST_TRACE_THREADS * 100, count_occurrences(text, "\"worker_span\""));
+    TEST_ASSERT_EQUAL_UINT(TEST_TRACE_THREADS, count_occurrences(text, "\"thread_name\""));
+    free(text);
+}
+
+void test_trace_restart_session(void) {
+    trace_span_t span;
+    char* text;
+    
+    if (!trace_is_available()) {
+        return;
+    }
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, trace_start(trace_path, "first"));
+    trace_span_begin(&span, "first_span");
+    trace_span_end(&span, NULL);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, trace_stop());
+    
+    /* Outside a session spans are dropped */
+    trace_span_begin(&span, "between_span");
+    trace_span_end(&span, NULL);
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_ARGUMENT, trace_stop());
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, trace_start(trace_path, "second"));
+    trace_span_begin(&span, "second_span");
+    trace_span_end(&span, NULL);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, trace_stop());
+    
+    text = read_trace();
+    TEST_ASSERT_NULL(strstr(text, "first_span"));
+    TEST_ASSERT_NULL(strstr(text, "between_span"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "second_span"));
+    TEST_ASSERT_EQUAL_UINT(1, count_occurrences(text, "\"thread_name\""));
+    free(text);
+}
+
+void test_trace_detail_keeps_end(void) {
+    char detail[TRACE_DETAIL_MAX * 2];
+    trace_span_t span;
+    char* text;
+    
+    if (!trace_is_available()) {
+        return;
+    }
+    
+    memset(detail, 'd', sizeof(detail) - 1);
+    detail[sizeof(detail) - 1] = '\0';
+    memcpy(detail + sizeof(detail) - 8, "/file.o", 8);
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, trace_start(trace_path, "test"));
+    trace_span_begin(&span, "long_detail");
+    trace_span_end(&span, detail);
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, trace_stop());
+    
+    text = read_trace();
+    TEST_ASSERT_NOT_NULL(strstr(text, detail + sizeof(detail) - TRACE_DETAIL_MAX));
+    TEST_ASSERT_NULL(strstr(text, detail + sizeof(detail) - TRACE_DETAIL_MAX - 1));
+    free(text);
+}
+
+void test_trace_rejects_second_start(void) {
+    if (!trace_is_available()) {
+        return;
+    }
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_FILE_IO, trace_start("/nonexistent/dir/trace.json", "test"));
+    TEST_ASSERT_FALSE(trace_is_active());
+    
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, trace_start(trace_path, "test"));
+    TEST_ASSERT_EQUAL_INT(ERROR_INVALID_ARGUMENT, trace_start(trace_path, "test"));
+    TEST_ASSERT_TRUE(trace_is_active());
+    TEST_ASSERT_EQUAL_INT(ERROR_SUCCESS, trace_stop());
+}
+
+int test_trace_main(void) {
+    UNITY_BEGIN();
+    
+    RUN_TEST(test_trace_records_spans);
+    RUN_TEST(test_trace_spans_from_threads);
+    RUN_TEST(test_trace_restart_session);
+    RUN_TEST(test_trace_detail_keeps_end);
+    RUN_TEST(test_trace_rejects_second_start);
+    
+    return UNITY_END();
+}
+
+int main(void) {
+    return test_trace_main();
+}
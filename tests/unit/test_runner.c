@@ -19,7 +19,6 @@
 extern int run_memory_tests(void);
 extern int run_smof_tests(void);
 extern int run_error_tests(void);
-extern int run_symbol_table_tests(void);
 extern int run_section_tests(void);
 extern int run_relocation_tests(void);
 extern int run_output_tests(void);
@@ -224,12 +223,6 @@ int main(int argc, char* argv[]) {
             .run_function = run_error_tests,
             .enabled = true
         },
-        {
-            .name = "symbol",
-            .description = "Symbol table management and resolution tests",
-            .run_function = run_symbol_table_tests,
-            .enabled = true
-        },
         {
             .name = "section",
             .description = "Section management and layout tests",
@@ -1,31 +1,20 @@
-/* Full-featured SMOF dump tool for STAS format */
+/*
+ * Full-featured SMOF dump tool for STAS format. The file is mapped and
+ * only what is printed is decoded, so a narrow view of a large image
+ * (one symbol, a range of a section) reads little more than that.
+ */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <getopt.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "../src/common/include/smof.h"
-
-// Simple validation function
-int smof_validate_header(const smof_header_t *header) {
-    if (!header) return 0;
-    
-    // Magic number check
-    if (header->magic != SMOF_MAGIC) return 0;
-    
-    // Version check
-    if (header->version > SMOF_VERSION_CURRENT) return 0;
-    
-    // Sanity checks
-    if (header->section_count > 256) return 0; // Reasonable limit
-    if (header->string_table_size > 1048576) return 0; // 1MB limit
-    
-    // Offset validation
-    if (header->section_table_offset < sizeof(smof_header_t)) return 0;
-    
-    return 1; // Valid
-}
+#include "../src/common/include/error.h"
 
 typedef struct {
     bool show_header;
@@ -34,6 +23,9 @@ typedef struct {
     bool show_relocations;
     bool hex_dump;
     bool verbose;
+    uint64_t offset;               /* Hex dump range, from the section or symbol start */
+    uint64_t length;               /* UINT64_MAX = to its end */
+    const char* symbol;            /* Only symbols of this name */
 } dump_options_t;
 
 static void print_usage(const char* program) {
@@ -45,6 +37,9 @@ static void print_usage(const char* program) {
     printf("  -r, --relocations Show relocations\n");
     printf("  -x, --hex-dump    Show hex dump of sections\n");
     printf("  -v, --verbose     Show all information (header, sections, symbols, relocations, hex dump)\n");
+    printf("      --symbol NAME Show only symbol NAME; with -x, dump its bytes\n");
+    printf("      --offset N    Start the hex dump N bytes into the section or symbol\n");
+    printf("      --length N    Dump at most N bytes\n");
     printf("      --help        Show this help\n");
     printf("      --version     Show version\n");
 }
@@ -103,66 +98,241 @@ static const char* get_relocation_type_string(uint8_t type) {
     }
 }
 
-static void hex_dump_section(FILE* file, const smof_section_t* section, const char* name) {
-    uint8_t buffer[16];
-    size_t remaining;
-    uint32_t addr;
-    long saved_pos;
+/* The mapped file; tables are decoded an entry at a time when printed */
+typedef struct {
+    const uint8_t* data;
+    uint64_t size;
+    smof_layout_t layout;
+    bool foreign;
+} dump_image_t;
+
+static void get_section(const dump_image_t* image, uint32_t index, smof_section_t* section) {
+    memcpy(section, image->data + image->layout.section_table_offset +
+           (uint64_t)index * sizeof(*section), sizeof(*section));
+    if (image->foreign) {
+        smof_swap_sections(section, 1);
+    }
+}
+
+static void get_symbol(const dump_image_t* image, uint32_t index, smof_symbol_t* symbol) {
+    memcpy(symbol, image->data + image->layout.symbol_table_offset +
+           (uint64_t)index * sizeof(*symbol), sizeof(*symbol));
+    if (image->foreign) {
+        smof_swap_symbols(symbol, 1);
+    }
+}
+
+/* Either relocation entry, widened */
+static void get_relocation(const dump_image_t* image, uint32_t index,
+                           smof_relocation_v2_t* reloc) {
+    const uint8_t* entry = image->data + image->layout.reloc_table_offset +
+                           (uint64_t)index * image->layout.reloc_entry_size;
+    smof_relocation_t narrow;
     
-    if (section->size == 0 || section->file_offset == 0) {
-        printf("       (Section has no data)\n");
+    if (image->layout.version == SMOF_VERSION_2) {
+        memcpy(reloc, entry, sizeof(*reloc));
+        if (image->foreign) {
+            smof_swap_relocations_v2(reloc, 1);
+        }
         return;
     }
     
-    remaining = section->size;
-    addr = section->virtual_addr;
-    saved_pos = ftell(file);
+    memcpy(&narrow, entry, sizeof(narrow));
+    if (image->foreign) {
+        smof_swap_relocations(&narrow, 1);
+    }
+    reloc->offset = narrow.offset;
+    reloc->symbol_index = narrow.symbol_index;
+    reloc->section_index = narrow.section_index;
+    reloc->type = narrow.type;
+}
+
+/* The NUL-terminated string at offset in the string table, or NULL */
+static const char* get_string(const dump_image_t* image, uint32_t offset) {
+    const char* string;
+    
+    if (offset >= image->layout.string_table_size) {
+        return NULL;
+    }
     
-    printf("       Hex dump of section '%s':\n", name);
-    fseek(file, section->file_offset, SEEK_SET);
+    string = (const char*)image->data + image->layout.string_table_offset + offset;
+    if (memchr(string, '\0', image->layout.string_table_size - offset) == NULL) {
+        return NULL;
+    }
+    return string;
+}
+
+/* A printable copy of a string table entry, cut at the first control byte */
+static void copy_name(const dump_image_t* image, uint32_t offset, char* name, size_t size) {
+    const char* string = offset > 0 ? get_string(image, offset) : NULL;
+    size_t k;
+    
+    if (string == NULL) {
+        snprintf(name, size, "<unknown>");
+        return;
+    }
+    
+    for (k = 0; k + 1 < size && string[k] >= 32 && string[k] <= 126; k++) {
+        name[k] = string[k];
+    }
+    name[k] = '\0';
+}
+
+/* Print length bytes as hex dump lines, building each line in one buffer */
+static void hex_dump_bytes(const uint8_t* data, uint64_t length, uint32_t addr) {
+    static const char digits[] = "0123456789ABCDEF";
+    char line[96];
     
-    while (remaining > 0) {
-        size_t to_read = remaining < 16 ? remaining : 16;
-        size_t read_bytes = fread(buffer, 1, to_read, file);
+    while (length > 0) {
+        size_t count = length < 16 ? (size_t)length : 16;
+        size_t used;
         size_t j;
         
-        printf("       %08X: ", addr);
+        used = (size_t)snprintf(line, sizeof(line), "       %08X: ", addr);
         
         /* Hex bytes */
         for (j = 0; j < 16; j++) {
-            if (j < read_bytes) {
-                printf("%02X ", buffer[j]);
+            if (j < count) {
+                line[used++] = digits[data[j] >> 4];
+                line[used++] = digits[data[j] & 0x0F];
             } else {
-                printf("   ");
+                line[used++] = ' ';
+                line[used++] = ' ';
             }
-            if (j == 7) printf(" ");
+            line[used++] = ' ';
+            if (j == 7) line[used++] = ' ';
         }
         
-        printf(" |");
+        line[used++] = ' ';
+        line[used++] = '|';
         
         /* ASCII representation */
-        for (j = 0; j < read_bytes; j++) {
-            unsigned char c = buffer[j];
-            char printable = (c >= 32 && c <= 126) ? (char)c : '.';
-            printf("%c", printable);
+        for (j = 0; j < count; j++) {
+            line[used++] = (data[j] >= 32 && data[j] <= 126) ? (char)data[j] : '.';
         }
         
-        printf("|\n");
+        line[used++] = '|';
+        line[used++] = '\n';
+        fwrite(line, 1, used, stdout);
         
-        remaining -= read_bytes;
-        addr += (uint32_t)read_bytes;
-        
-        if (read_bytes != to_read) break;
+        data += count;
+        length -= count;
+        addr += (uint32_t)count;
+    }
+}
+
+/*
+ * Dump the --offset/--length range of extent bytes at file_offset, which
+ * start at address addr. Only the pages of that range are touched.
+ */
+static void hex_dump_range(const dump_image_t* image, const dump_options_t* opts,
+                           uint64_t file_offset, uint64_t extent, uint32_t addr) {
+    uint64_t length;
+    
+    if (opts->offset >= extent) {
+        printf("       (Range outside the data)\n");
+        return;
+    }
+    
+    length = extent - opts->offset;
+    if (opts->length < length) {
+        length = opts->length;
+    }
+    
+    hex_dump_bytes(image->data + file_offset + opts->offset, length,
+                   addr + (uint32_t)opts->offset);
+}
+
+static bool section_has_data(const dump_image_t* image, const smof_section_t* section) {
+    return section->size > 0 && section->file_offset > 0 &&
+           (section->flags & SMOF_SECT_ZERO_FILL) == 0 &&
+           (uint64_t)section->file_offset + section->size <= image->size;
+}
+
+static void hex_dump_section(const dump_image_t* image, const dump_options_t* opts,
+                             const smof_section_t* section, const char* name) {
+    if (!section_has_data(image, section)) {
+        printf("       (Section has no data)\n");
+        return;
+    }
+    
+    printf("       Hex dump of section '%s':\n", name);
+    hex_dump_range(image, opts, section->file_offset, section->size, section->virtual_addr);
+}
+
+/*
+ * The symbol's bytes: its size, or the rest of its section if it has
+ * none. Values are addresses, but one below its section's address is
+ * taken as an offset into the section.
+ */
+static void hex_dump_symbol(const dump_image_t* image, const dump_options_t* opts,
+                            const smof_symbol_t* symbol, const char* name) {
+    smof_section_t section;
+    uint32_t start;
+    uint64_t extent;
+    
+    if (symbol->section_index >= image->layout.section_count) {
+        printf("       (Symbol has no section data)\n");
+        return;
+    }
+    
+    get_section(image, symbol->section_index, &section);
+    start = symbol->value >= section.virtual_addr ? symbol->value - section.virtual_addr :
+                                                   symbol->value;
+    if (!section_has_data(image, &section) || start >= section.size) {
+        printf("       (Symbol has no section data)\n");
+        return;
+    }
+    
+    extent = section.size - start;
+    if (symbol->size > 0 && symbol->size < extent) {
+        extent = symbol->size;
+    }
+    
+    printf("       Hex dump of symbol '%s':\n", name);
+    hex_dump_range(image, opts, (uint64_t)section.file_offset + start, extent,
+                   section.virtual_addr + start);
+}
+
+/* Parse a --offset/--length value: decimal, 0x hex or 0 octal */
+/* Whether any symbol is named name, matched in place */
+static bool has_symbol(const dump_image_t* image, const char* name) {
+    smof_symbol_t symbol;
+    const char* symbol_name;
+    uint32_t i;
+    
+    for (i = 0; i < image->layout.symbol_count; i++) {
+        get_symbol(image, i, &symbol);
+        symbol_name = get_string(image, symbol.name_offset);
+        if (symbol_name != NULL && strcmp(symbol_name, name) == 0) {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+static bool parse_size(const char* text, uint64_t* value) {
+    char* end;
+    
+    if (*text == '\0' || *text == '-') {
+        return false;
     }
     
-    fseek(file, saved_pos, SEEK_SET);
+    *value = (uint64_t)strtoull(text, &end, 0);
+    return *end == '\0';
 }
 
 int main(int argc, char* argv[]) {
     dump_options_t opts = {0};
+    static char output_buffer[1 << 16];
+    const smof_layout_t* layout;
+    dump_image_t image;
     const char* filename;
-    FILE* file;
-    smof_header_t header;
+    struct stat st;
+    size_t header_size;
+    void* map = MAP_FAILED;
+    int fd;
     
     static struct option long_options[] = {
         {"header",      no_argument, 0, 'h'},
@@ -173,10 +343,14 @@ int main(int argc, char* argv[]) {
         {"verbose",     no_argument, 0, 'v'},
         {"help",        no_argument, 0, 1001},
         {"version",     no_argument, 0, 1002},
+        {"symbol",      required_argument, 0, 1003},
+        {"offset",      required_argument, 0, 1004},
+        {"length",      required_argument, 0, 1005},
         {0, 0, 0, 0}
     };
     
     int opt;
+    opts.length = UINT64_MAX;
     while ((opt = getopt_long(argc, argv, "hsyrxv", long_options, NULL)) != -1) {
         switch (opt) {
             case 'h':
@@ -203,6 +377,17 @@ int main(int argc, char* argv[]) {
             case 1002:
                 print_version();
                 return EXIT_SUCCESS;
+            case 1003:
+                opts.symbol = optarg;
+                break;
+            case 1004:
+            case 1005:
+                if (!parse_size(optarg, opt == 1004 ? &opts.offset : &opts.length)) {
+                    fprintf(stderr, "Error: Invalid %s '%s'\n",
+                            opt == 1004 ? "offset" : "length", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
             case '?':
                 fprintf(stderr, "Try '%s --help' for more information.\n", argv[0]);
                 return EXIT_FAILURE;
@@ -233,167 +418,158 @@ int main(int argc, char* argv[]) {
         opts.show_symbols = true;
     }
     
-    /* Open file */
-    file = fopen(filename, "rb");
-    if (file == NULL) {
-        perror("fopen");
+    /* Map file */
+    fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror("open");
         return EXIT_FAILURE;
     }
     
-    /* Read header */
-    if (fread(&header, sizeof(header), 1, file) != 1) {
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(smof_header_t)) {
         fprintf(stderr, "Error: Failed to read SMOF header\n");
-        fclose(file);
+        close(fd);
+        return EXIT_FAILURE;
+    }
+    image.size = (uint64_t)st.st_size;
+    
+    if (image.size <= SIZE_MAX) {
+        map = mmap(NULL, (size_t)image.size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap");
         return EXIT_FAILURE;
     }
+    image.data = map;
     
-    /* Validate header */
-    if (!smof_validate_header(&header)) {
+    /* Validate header: either version, either byte order */
+    header_size = image.size < sizeof(smof_header_v2_t) ?
+                  (size_t)image.size : sizeof(smof_header_v2_t);
+    if (smof_decode_header(image.data, header_size, &image.layout) != ERROR_SUCCESS ||
+        !smof_layout_fits(&image.layout, image.size)) {
         fprintf(stderr, "Error: Invalid SMOF file\n");
-        fclose(file);
+        munmap(map, (size_t)image.size);
+        return EXIT_FAILURE;
+    }
+    image.foreign = smof_is_foreign(image.data, header_size);
+    layout = &image.layout;
+    
+    /* A listing without the symbol would look like a zero-length one to scripts */
+    if (opts.symbol != NULL && !has_symbol(&image, opts.symbol)) {
+        fprintf(stderr, "Error: Symbol '%s' not found\n", opts.symbol);
+        munmap(map, (size_t)image.size);
         return EXIT_FAILURE;
     }
     
+    /* Triage scripts pipe this: write in large blocks */
+    setvbuf(stdout, output_buffer, _IOFBF, sizeof(output_buffer));
+    
     printf("SMOF File: %s (STAS reference format)\n", filename);
     printf("============================================\n");
     
     /* Show header */
     if (opts.show_header) {
         printf("\nFile Header:\n");
-        printf("  Magic:              0x%08X ('%c%c%c%c')\n", 
-               header.magic,
-               (char)(header.magic & 0xFF),
-               (char)((header.magic >> 8) & 0xFF),
-               (char)((header.magic >> 16) & 0xFF),
-               (char)((header.magic >> 24) & 0xFF));
-        printf("  Version:            %u\n", header.version);
-        printf("  Flags:              0x%04X", header.flags);
+        printf("  Magic:              0x%08X ('%c%c%c%c')%s\n", 
+               SMOF_MAGIC,
+               (char)(SMOF_MAGIC & 0xFF),
+               (char)((SMOF_MAGIC >> 8) & 0xFF),
+               (char)((SMOF_MAGIC >> 16) & 0xFF),
+               (char)((SMOF_MAGIC >> 24) & 0xFF),
+               image.foreign ? " byte-swapped" : "");
+        printf("  Version:            %u\n", layout->version);
+        printf("  Flags:              0x%04X", layout->flags);
         
-        if (header.flags & SMOF_FLAG_EXECUTABLE) printf(" EXECUTABLE");
-        if (header.flags & SMOF_FLAG_SHARED_LIB) printf(" SHARED_LIB");
-        if (header.flags & SMOF_FLAG_POSITION_INDEP) printf(" POSITION_INDEP");
-        if (header.flags & SMOF_FLAG_STRIPPED) printf(" STRIPPED");
-        if (header.flags & SMOF_FLAG_STATIC) printf(" STATIC");
-        if (header.flags & SMOF_FLAG_COMPRESSED) printf(" COMPRESSED");
+        if (layout->flags & SMOF_FLAG_EXECUTABLE) printf(" EXECUTABLE");
+        if (layout->flags & SMOF_FLAG_SHARED_LIB) printf(" SHARED_LIB");
+        if (layout->flags & SMOF_FLAG_POSITION_INDEP) printf(" POSITION_INDEP");
+        if (layout->flags & SMOF_FLAG_STRIPPED) printf(" STRIPPED");
+        if (layout->flags & SMOF_FLAG_STATIC) printf(" STATIC");
+        if (layout->flags & SMOF_FLAG_COMPRESSED) printf(" COMPRESSED");
+        if (layout->flags & SMOF_FLAG_LITTLE_ENDIAN) printf(" LITTLE_ENDIAN");
+        if (layout->flags & SMOF_FLAG_BIG_ENDIAN) printf(" BIG_ENDIAN");
         printf("\n");
         
-        printf("  Entry Point:        0x%08X\n", header.entry_point);
-        printf("  Section Count:      %u\n", header.section_count);
-        printf("  Symbol Count:       %u\n", header.symbol_count);
-        printf("  Section Table:      0x%08X\n", header.section_table_offset);
-        printf("  String Table:       0x%08X (size: %u)\n", header.string_table_offset, header.string_table_size);
-        printf("  Relocation Table:   0x%08X (%u entries)\n", header.reloc_table_offset, header.reloc_count);
-        printf("  Import Count:       %u\n", header.import_count);
+        printf("  Entry Point:        0x%08X\n", layout->entry_point);
+        printf("  Section Count:      %u\n", layout->section_count);
+        printf("  Symbol Count:       %u\n", layout->symbol_count);
+        printf("  Section Table:      0x%08llX\n", (unsigned long long)layout->section_table_offset);
+        printf("  String Table:       0x%08llX (size: %u)\n",
+               (unsigned long long)layout->string_table_offset, layout->string_table_size);
+        printf("  Relocation Table:   0x%08llX (%u entries)\n",
+               (unsigned long long)layout->reloc_table_offset, layout->reloc_count);
+        printf("  Import Count:       %u\n", layout->import_count);
     }
     
     /* Show sections */
-    if (opts.show_sections && header.section_count > 0) {
+    if (opts.show_sections && layout->section_count > 0) {
         printf("\nSection Headers:\n");
         printf("  [Nr] Name              VirtAddr FileOff  Size   Flags   Algn\n");
         
-        fseek(file, header.section_table_offset, SEEK_SET);
-        
-        for (uint16_t i = 0; i < header.section_count; i++) {
+        for (uint32_t i = 0; i < layout->section_count; i++) {
             smof_section_t section;
-            char section_name[64] = "<unknown>";
-            long pos;
+            char section_name[64];
             
-            if (fread(&section, sizeof(section), 1, file) != 1) {
-                fprintf(stderr, "Error: Failed to read section header %u\n", i);
-                continue;
-            }
-            
-            /* Get section name from string table */
-            if (header.string_table_offset > 0 && section.name_offset > 0) {
-                pos = ftell(file);
-                fseek(file, header.string_table_offset + section.name_offset, SEEK_SET);
-                fread(section_name, 1, sizeof(section_name) - 1, file);
-                section_name[sizeof(section_name) - 1] = '\0';
-                fseek(file, pos, SEEK_SET);
-            }
+            get_section(&image, i, &section);
+            copy_name(&image, section.name_offset, section_name, sizeof(section_name));
             
             printf("  [%2u] %-16s %08X %06X %06X %-7s %4u\n",
                    i, section_name, section.virtual_addr, section.file_offset,
                    section.size, get_section_flag_string(section.flags), 1U << section.alignment);
             
-            /* Show hex dump if requested */
-            if (opts.hex_dump) {
-                hex_dump_section(file, &section, section_name);
+            /* Show hex dump if requested; with --symbol, the symbol's bytes instead */
+            if (opts.hex_dump && opts.symbol == NULL) {
+                hex_dump_section(&image, &opts, &section, section_name);
             }
         }
     }
     
     /* Show symbols - Symbol table comes right after section table */
-    if (opts.show_symbols && header.symbol_count > 0) {
-        uint32_t symbol_table_offset;
-        uint16_t i;
+    if (opts.show_symbols && layout->symbol_count > 0) {
+        uint32_t i;
         
-        printf("\nSymbol Table: %u symbols\n", header.symbol_count);
+        printf("\nSymbol Table: %u symbols\n", layout->symbol_count);
         printf("  [Nr] Value    Size Type    Bind   Ndx Name\n");
         
-        /* Calculate symbol table offset: right after section table */
-        symbol_table_offset = (uint32_t)(header.section_table_offset + 
-                             (header.section_count * sizeof(smof_section_t)));
-        
-        fseek(file, symbol_table_offset, SEEK_SET);
-        
-        for (i = 0; i < header.symbol_count; i++) {
+        for (i = 0; i < layout->symbol_count; i++) {
             smof_symbol_t symbol;
-            char symbol_name[128] = "<unknown>";
+            char symbol_name[128];
+            const char* name;
             
-            if (fread(&symbol, sizeof(symbol), 1, file) != 1) {
-                fprintf(stderr, "Error reading symbol %u\n", i);
-                break;
-            }
+            get_symbol(&image, i, &symbol);
             
-            /* Read symbol name from string table */
-            if (symbol.name_offset > 0 && symbol.name_offset < header.string_table_size) {
-                long pos = ftell(file);
-                size_t max_len = sizeof(symbol_name) - 1;
-                size_t remaining = header.string_table_size - symbol.name_offset;
-                size_t read_len = max_len < remaining ? max_len : remaining;
-                size_t k;
-                
-                fseek(file, header.string_table_offset + symbol.name_offset, SEEK_SET);
-                
-                if (fread(symbol_name, 1, read_len, file) > 0) {
-                    symbol_name[read_len] = '\0';
-                    /* Ensure null termination */
-                    for (k = 0; k < read_len; k++) {
-                        if (symbol_name[k] == '\0') break;
-                        if (symbol_name[k] < 32 || symbol_name[k] > 126) {
-                            symbol_name[k] = '\0';
-                            break;
-                        }
-                    }
+            /* Match the name in place before anything is copied */
+            if (opts.symbol != NULL) {
+                name = get_string(&image, symbol.name_offset);
+                if (name == NULL || strcmp(name, opts.symbol) != 0) {
+                    continue;
                 }
-                
-                fseek(file, pos, SEEK_SET);
             }
             
+            copy_name(&image, symbol.name_offset, symbol_name, sizeof(symbol_name));
+            
             printf("  [%2u] %08X %4u %-7s %-6s %3u %s\n",
                    i, symbol.value, symbol.size,
                    get_symbol_type_string(symbol.type),
                    get_symbol_binding_string(symbol.binding),
                    symbol.section_index,
                    symbol_name);
+            
+            if (opts.hex_dump && opts.symbol != NULL) {
+                hex_dump_symbol(&image, &opts, &symbol, symbol_name);
+            }
         }
     }
     
     /* Show relocations */
-    if (opts.show_relocations && header.reloc_count > 0) {
-        printf("\nRelocation Entries: %u entries\n", header.reloc_count);
+    if (opts.show_relocations && layout->reloc_count > 0) {
+        printf("\nRelocation Entries: %u entries\n", layout->reloc_count);
         printf("  Offset   SymIdx Type     Section\n");
         
-        fseek(file, header.reloc_table_offset, SEEK_SET);
-        
-        for (uint16_t i = 0; i < header.reloc_count; i++) {
-            smof_relocation_t reloc;
+        for (uint32_t i = 0; i < layout->reloc_count; i++) {
+            smof_relocation_v2_t reloc;
             
-            if (fread(&reloc, sizeof(reloc), 1, file) != 1) {
-                fprintf(stderr, "Error: Failed to read relocation %u\n", i);
-                continue;
-            }
+            get_relocation(&image, i, &reloc);
             
             printf("  %08X %6u %-8s %7u\n",
                    reloc.offset, reloc.symbol_index,
@@ -402,6 +578,7 @@ int main(int argc, char* argv[]) {
         }
     }
     
-    fclose(file);
+    fflush(stdout);
+    munmap(map, (size_t)image.size);
     return EXIT_SUCCESS;
 }
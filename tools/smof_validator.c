@@ -5,7 +5,10 @@
  * @date 2025-07-23
  * 
  * Comprehensive validation tool for SMOF files including format compliance,
- * integrity checking, and compatibility verification.
+ * integrity checking, and compatibility verification. Each file is mapped
+ * and its tables are checked in place; in bulk mode the files are spread
+ * over a thread pool and every file's messages are printed, in command
+ * line order, once all of them are done.
  */
 
 #include <stdio.h>
@@ -13,13 +16,19 @@
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdarg.h>
+#include <limits.h>
+#include <time.h>
 #include <getopt.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 
-#include "smof.h"
-#include "error.h"
-#include "utils.h"
+#include "../src/common/include/smof.h"
+#include "../src/common/include/error.h"
+#include "../src/common/include/thread_pool.h"
 
 /* Validation levels */
 typedef enum {
@@ -35,6 +44,9 @@ typedef struct {
     uint32_t warnings;
     uint32_t info_messages;
     bool is_valid;
+    char* log;                     /* Text messages, printed after the run */
+    size_t log_length;
+    size_t log_capacity;
 } validation_result_t;
 
 /* Global options */
@@ -45,13 +57,17 @@ static struct {
     bool json_output;
     bool fix_errors;
     const char* output_file;
+    const char* files_from;        /* File with more names, one per line */
+    size_t threads;                /* Validation threads, 0 = one per CPU */
 } options = {
     .level = VALIDATION_STANDARD,
     .verbose = false,
     .quiet = false,
     .json_output = false,
     .fix_errors = false,
-    .output_file = NULL
+    .output_file = NULL,
+    .files_from = NULL,
+    .threads = 1
 };
 
 /* Print usage information */
@@ -66,6 +82,9 @@ static void print_usage(const char* program_name) {
     printf("  -j, --json              Output results in JSON format\n");
     printf("  -f, --fix               Attempt to fix correctable errors\n");
     printf("  -o, --output FILE       Write corrected file to FILE (with --fix)\n");
+    printf("  -b, --bulk              Validate files in parallel, one thread per CPU\n");
+    printf("      --threads N         Validate files on N threads\n");
+    printf("  -T, --files-from FILE   Also validate the files named in FILE ('-' = stdin)\n");
     printf("  -h, --help              Show this help message\n");
     printf("  --version               Show version information\n");
     printf("\nValidation Levels:\n");
@@ -82,12 +101,13 @@ static void print_usage(const char* program_name) {
     printf("  %s -l strict *.smof                # Strict validation of all SMOF files\n", program_name);
     printf("  %s -j program.smof > report.json   # JSON output for CI integration\n", program_name);
     printf("  %s -f -o fixed.smof broken.smof    # Fix errors and save to new file\n", program_name);
+    printf("  find . -name '*.smof' | %s -b -j -T - # Bulk check of a build tree\n", program_name);
 }
 
 /* Print version information */
 static void print_version(void) {
     printf("smof_validator version 1.0.0\n");
-    printf("SMOF format version support: 1.x\n");
+    printf("SMOF format version support: 1, 2\n");
     printf("Copyright (c) 2025 STIX Project\n");
 }
 
@@ -98,8 +118,53 @@ typedef enum {
     MSG_INFO
 } message_type_t;
 
-/* Print validation message */
-static void print_message(message_type_t type, const char* format, ...) {
+/* Append text to a file's message log; a message that finds no memory is lost */
+static void append_log(validation_result_t* result, const char* format, va_list args) {
+    size_t capacity = result->log_capacity > 0 ? result->log_capacity : 256;
+    va_list copy;
+    char* grown;
+    int length;
+    
+    va_copy(copy, args);
+    length = vsnprintf(NULL, 0, format, copy);
+    va_end(copy);
+    if (length < 0) {
+        return;
+    }
+    
+    while (capacity < result->log_length + (size_t)length + 1) {
+        capacity *= 2;
+    }
+    if (capacity > result->log_capacity) {
+        grown = realloc(result->log, capacity);
+        if (grown == NULL) {
+            return;
+        }
+        result->log = grown;
+        result->log_capacity = capacity;
+    }
+    
+    vsnprintf(result->log + result->log_length, (size_t)length + 1, format, args);
+    result->log_length += (size_t)length;
+}
+
+static void append_log_text(validation_result_t* result, const char* format, ...) {
+    va_list args;
+    
+    va_start(args, format);
+    append_log(result, format, args);
+    va_end(args);
+}
+
+/*
+ * Record a validation message in the file's log. Files may be validated
+ * on several threads, so nothing is printed here.
+ */
+static void print_message(validation_result_t* result, message_type_t type,
+                          const char* format, ...) {
+    const char* prefix = "INFO";
+    va_list args;
+    
     if (options.quiet && type != MSG_ERROR) {
         return;
     }
@@ -108,448 +173,549 @@ static void print_message(message_type_t type, const char* format, ...) {
         return; /* JSON messages handled separately */
     }
     
-    const char* prefix;
     switch (type) {
         case MSG_ERROR:   prefix = "ERROR"; break;
         case MSG_WARNING: prefix = "WARNING"; break;
         case MSG_INFO:    prefix = "INFO"; break;
     }
     
-    printf("[%s] ", prefix);
+    append_log_text(result, "[%s] ", prefix);
     
-    va_list args;
     va_start(args, format);
-    vprintf(format, args);
+    append_log(result, format, args);
     va_end(args);
     
-    printf("\n");
+    append_log_text(result, "\n");
 }
 
-/* Calculate CRC32 checksum */
-static uint32_t calculate_crc32(const uint8_t* data, size_t length) {
-    static const uint32_t crc_table[256] = {
-        /* CRC-32 table - truncated for brevity */
-        0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA,
-        /* ... full table would be here ... */
-    };
-    
-    uint32_t crc = 0xFFFFFFFF;
-    
-    for (size_t i = 0; i < length; i++) {
-        crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
-    }
-    
-    return crc ^ 0xFFFFFFFF;
-}
+/* A mapped file being validated: its layout and byte order */
+typedef struct {
+    const uint8_t* data;
+    const char* filename;
+    uint64_t size;
+    smof_layout_t layout;
+    bool foreign;                  /* Tables are in the other byte order */
+} smof_input_t;
 
-/* Validate SMOF header */
-static bool validate_header(const smof_header_t* header, const char* filename, 
-                           validation_result_t* result) {
+/*
+ * Validate SMOF header. The fields both versions share are checked one by
+ * one for precise messages; smof_decode_header then applies the version's
+ * own limits.
+ */
+static bool validate_header(const uint8_t* bytes, size_t size, smof_input_t* input,
+                            validation_result_t* result) {
+    const char* filename = input->filename;
+    const smof_layout_t* header = &input->layout;
+    smof_header_t common;
     bool valid = true;
     
+    memcpy(&common, bytes, sizeof(common));
+    input->foreign = smof_is_foreign(bytes, size);
+    if (input->foreign) {
+        smof_swap_header(&common);
+    }
+    
     /* Check magic number */
-    if (header->magic != SMOF_MAGIC) {
-        print_message(MSG_ERROR, "%s: Invalid magic number 0x%08X (expected 0x%08X)",
-                     filename, header->magic, SMOF_MAGIC);
+    if (common.magic != SMOF_MAGIC) {
+        print_message(result, MSG_ERROR, "%s: Invalid magic number 0x%08X (expected 0x%08X)",
+                     filename, common.magic, SMOF_MAGIC);
         result->errors++;
-        valid = false;
+        return false;
     }
     
     /* Check version */
-    if (header->version == 0) {
-        print_message(MSG_ERROR, "%s: Invalid version number %u", filename, header->version);
+    if (common.version == 0) {
+        print_message(result, MSG_ERROR, "%s: Invalid version number %u", filename, common.version);
         result->errors++;
-        valid = false;
-    } else if (header->version > SMOF_VERSION) {
-        print_message(MSG_WARNING, "%s: Future version %u (current: %u)", 
-                     filename, header->version, SMOF_VERSION);
+        return false;
+    } else if (common.version > SMOF_VERSION_2) {
+        print_message(result, MSG_WARNING, "%s: Future version %u (current: %u)", 
+                     filename, common.version, SMOF_VERSION_2);
         result->warnings++;
-        if (options.level >= VALIDATION_STRICT) {
-            valid = false;
-        }
+        return false;
     }
     
     /* Check flags consistency */
-    if ((header->flags & SMOF_FLAG_LITTLE_ENDIAN) && (header->flags & SMOF_FLAG_BIG_ENDIAN)) {
-        print_message(MSG_ERROR, "%s: Conflicting endianness flags", filename);
+    if ((common.flags & SMOF_FLAG_LITTLE_ENDIAN) && (common.flags & SMOF_FLAG_BIG_ENDIAN)) {
+        print_message(result, MSG_ERROR, "%s: Conflicting endianness flags", filename);
         result->errors++;
         valid = false;
     }
     
-    if (!(header->flags & (SMOF_FLAG_LITTLE_ENDIAN | SMOF_FLAG_BIG_ENDIAN))) {
-        print_message(MSG_WARNING, "%s: No endianness flag specified", filename);
+    if (!(common.flags & (SMOF_FLAG_LITTLE_ENDIAN | SMOF_FLAG_BIG_ENDIAN))) {
+        print_message(result, MSG_WARNING, "%s: No endianness flag specified", filename);
         result->warnings++;
     }
     
+    if (smof_decode_header(bytes, size, &input->layout) != ERROR_SUCCESS) {
+        print_message(result, MSG_ERROR, "%s: Header exceeds the limits of SMOF version %u",
+                     filename, common.version);
+        result->errors++;
+        return false;
+    }
+    
+    if (options.verbose) {
+        print_message(result, MSG_INFO, "%s: SMOF version %u%s", filename, header->version,
+                     input->foreign ? ", byte-swapped" : "");
+        result->info_messages++;
+    }
+    
     /* Check entry point for executable files */
     if ((header->flags & SMOF_FLAG_EXECUTABLE) && header->entry_point == 0) {
         if (options.level >= VALIDATION_STRICT) {
-            print_message(MSG_WARNING, "%s: Executable file with zero entry point", filename);
+            print_message(result, MSG_WARNING, "%s: Executable file with zero entry point", filename);
             result->warnings++;
         }
     }
     
     /* Check counts */
     if (header->section_count == 0) {
-        print_message(MSG_WARNING, "%s: No sections defined", filename);
+        print_message(result, MSG_WARNING, "%s: No sections defined", filename);
         result->warnings++;
     }
     
     if (header->symbol_count == 0 && options.level >= VALIDATION_PEDANTIC) {
-        print_message(MSG_INFO, "%s: No symbols defined", filename);
+        print_message(result, MSG_INFO, "%s: No symbols defined", filename);
         result->info_messages++;
     }
     
     /* Check table offsets */
     if (header->section_count > 0 && header->section_table_offset == 0) {
-        print_message(MSG_ERROR, "%s: Invalid section table offset", filename);
+        print_message(result, MSG_ERROR, "%s: Invalid section table offset", filename);
         result->errors++;
         valid = false;
     }
     
-    if (header->symbol_count > 0 && header->symbol_table_offset == 0) {
-        print_message(MSG_ERROR, "%s: Invalid symbol table offset", filename);
+    if (header->reloc_count > 0 && header->reloc_table_offset == 0) {
+        print_message(result, MSG_ERROR, "%s: Invalid relocation table offset", filename);
         result->errors++;
         valid = false;
     }
     
+    /* A v2 file whose tables fit v1 is valid, but a v1 reader could take it */
+    if (header->version == SMOF_VERSION_2 && options.level >= VALIDATION_PEDANTIC &&
+        header->section_count <= SMOF_V1_MAX_SECTIONS &&
+        header->symbol_count <= SMOF_V1_MAX_SYMBOLS &&
+        header->reloc_count <= SMOF_V1_MAX_RELOCATIONS &&
+        header->string_table_size <= SMOF_V1_MAX_STRING_TABLE) {
+        print_message(result, MSG_INFO, "%s: Version 2 header where version 1 would do", filename);
+        result->info_messages++;
+    }
+    
     return valid;
 }
 
+/*
+ * Copy of a table of a foreign file, for swapping to host byte order. The
+ * tables of a native file are used in place: validate_integrity has
+ * checked each of them against the file size once.
+ */
+static void* copy_table(const smof_input_t* input, uint64_t offset, size_t size,
+                        validation_result_t* result) {
+    void* copy = malloc(size);
+    
+    if (copy == NULL) {
+        print_message(result, MSG_ERROR, "%s: Out of memory", input->filename);
+        result->errors++;
+        return NULL;
+    }
+    
+    memcpy(copy, input->data + offset, size);
+    return copy;
+}
+
 /* Validate section headers */
-static bool validate_sections(FILE* file, const smof_header_t* header, 
-                             const char* filename, validation_result_t* result) {
+static bool validate_sections(const smof_input_t* input, validation_result_t* result) {
+    const smof_layout_t* header = &input->layout;
+    const char* filename = input->filename;
+    const smof_section_t* sections;
+    smof_section_t* copy = NULL;
+    uint64_t prev_end = 0;
+    bool sections_overlap = false;
     bool valid = true;
+    uint32_t i;
     
     if (header->section_count == 0) {
         return true;
     }
     
-    /* Seek to section table */
-    if (fseek(file, header->section_table_offset, SEEK_SET) != 0) {
-        print_message(MSG_ERROR, "%s: Cannot seek to section table", filename);
-        result->errors++;
-        return false;
+    sections = (const smof_section_t*)(input->data + header->section_table_offset);
+    if (input->foreign) {
+        copy = copy_table(input, header->section_table_offset,
+                          header->section_count * sizeof(smof_section_t), result);
+        if (copy == NULL) {
+            return false;
+        }
+        smof_swap_sections(copy, header->section_count);
+        sections = copy;
     }
     
-    uint32_t prev_end = 0;
-    bool sections_overlap = false;
-    
-    for (uint16_t i = 0; i < header->section_count; i++) {
-        smof_section_header_t section;
+    for (i = 0; i < header->section_count; i++) {
+        smof_section_t section = sections[i];
+        bool zero_fill;
         
-        if (fread(&section, sizeof(section), 1, file) != 1) {
-            print_message(MSG_ERROR, "%s: Cannot read section header %u", filename, i);
-            result->errors++;
-            valid = false;
-            continue;
-        }
+        zero_fill = (section.flags & SMOF_SECT_ZERO_FILL) != 0;
         
-        /* Check section type */
-        if (section.type >= SMOF_SECTION_TYPE_MAX) {
-            print_message(MSG_ERROR, "%s: Section %u has invalid type %u", 
-                         filename, i, section.type);
+        /* Check section name */
+        if (section.name_offset >= header->string_table_size) {
+            print_message(result, MSG_ERROR, "%s: Section %u name outside string table", filename, i);
             result->errors++;
             valid = false;
         }
         
-        /* Check alignment */
-        if (section.alignment > 0 && (section.alignment & (section.alignment - 1)) != 0) {
-            print_message(MSG_ERROR, "%s: Section %u has invalid alignment %u (not power of 2)", 
+        /* Check alignment (a power-of-two exponent) */
+        if (section.alignment >= 32) {
+            print_message(result, MSG_ERROR, "%s: Section %u has invalid alignment 2^%u", 
                          filename, i, section.alignment);
             result->errors++;
             valid = false;
+        } else if (section.alignment > 0 &&
+                   (section.virtual_addr & ((1U << section.alignment) - 1)) != 0) {
+            /* Check address alignment */
+            print_message(result, MSG_WARNING, "%s: Section %u address 0x%08X not aligned to %u", 
+                         filename, i, section.virtual_addr, 1U << section.alignment);
+            result->warnings++;
         }
         
-        /* Check address alignment */
-        if (section.alignment > 1 && (section.address % section.alignment) != 0) {
-            print_message(MSG_WARNING, "%s: Section %u address 0x%08X not aligned to %u", 
-                         filename, i, section.address, section.alignment);
-            result->warnings++;
+        /* Check section data lies in the file */
+        if (!zero_fill && section.size > 0 &&
+            (uint64_t)section.file_offset + section.size > input->size) {
+            print_message(result, MSG_ERROR, "%s: Section %u data outside file", filename, i);
+            result->errors++;
+            valid = false;
         }
         
         /* Check for overlapping sections */
-        if (section.offset > 0 && section.size > 0) {
-            if (section.offset < prev_end) {
-                print_message(MSG_ERROR, "%s: Section %u overlaps with previous section", 
+        if (!zero_fill && section.file_offset > 0 && section.size > 0) {
+            if (section.file_offset < prev_end) {
+                print_message(result, MSG_ERROR, "%s: Section %u overlaps with previous section", 
                              filename, i);
                 result->errors++;
                 valid = false;
                 sections_overlap = true;
             }
-            prev_end = section.offset + section.size;
+            prev_end = (uint64_t)section.file_offset + section.size;
         }
         
         /* Check section size limits */
         if (options.level >= VALIDATION_PEDANTIC) {
             if (section.size > 1024 * 1024) { /* 1MB */
-                print_message(MSG_INFO, "%s: Section %u is very large (%u bytes)", 
+                print_message(result, MSG_INFO, "%s: Section %u is very large (%u bytes)", 
                              filename, i, section.size);
                 result->info_messages++;
             }
         }
     }
     
+    free(copy);
     return valid && !sections_overlap;
 }
 
 /* Validate symbol table */
-static bool validate_symbols(FILE* file, const smof_header_t* header, 
-                            const char* filename, validation_result_t* result) {
+static bool validate_symbols(const smof_input_t* input, validation_result_t* result) {
+    const smof_layout_t* header = &input->layout;
+    const char* filename = input->filename;
+    const smof_symbol_t* symbols;
+    smof_symbol_t* copy = NULL;
+    uint32_t local_symbols = 0;
+    uint32_t global_symbols = 0;
+    bool found_file_symbol = false;
     bool valid = true;
+    uint32_t i;
     
     if (header->symbol_count == 0) {
         return true;
     }
     
-    /* Seek to symbol table */
-    if (fseek(file, header->symbol_table_offset, SEEK_SET) != 0) {
-        print_message(MSG_ERROR, "%s: Cannot seek to symbol table", filename);
-        result->errors++;
-        return false;
+    /* The symbol table follows the section table */
+    symbols = (const smof_symbol_t*)(input->data + header->symbol_table_offset);
+    if (input->foreign) {
+        copy = copy_table(input, header->symbol_table_offset,
+                          header->symbol_count * sizeof(smof_symbol_t), result);
+        if (copy == NULL) {
+            return false;
+        }
+        smof_swap_symbols(copy, header->symbol_count);
+        symbols = copy;
     }
     
-    uint32_t local_symbols = 0;
-    uint32_t global_symbols = 0;
-    bool found_file_symbol = false;
-    
-    for (uint16_t i = 0; i < header->symbol_count; i++) {
-        smof_symbol_t symbol;
-        
-        if (fread(&symbol, sizeof(symbol), 1, file) != 1) {
-            print_message(MSG_ERROR, "%s: Cannot read symbol %u", filename, i);
-            result->errors++;
-            valid = false;
-            continue;
-        }
+    for (i = 0; i < header->symbol_count; i++) {
+        smof_symbol_t symbol = symbols[i];
         
         /* Check symbol type and binding */
-        uint8_t type = SMOF_SYMBOL_TYPE(symbol.info);
-        uint8_t bind = SMOF_SYMBOL_BIND(symbol.info);
-        
-        if (type >= SMOF_SYMBOL_TYPE_MAX) {
-            print_message(MSG_ERROR, "%s: Symbol %u has invalid type %u", filename, i, type);
+        if (symbol.type > SMOF_SYM_SYSCALL) {
+            print_message(result, MSG_ERROR, "%s: Symbol %u has invalid type %u", filename, i, symbol.type);
             result->errors++;
             valid = false;
         }
         
-        if (bind >= SMOF_SYMBOL_BIND_MAX) {
-            print_message(MSG_ERROR, "%s: Symbol %u has invalid binding %u", filename, i, bind);
+        if (symbol.binding > SMOF_BIND_EXPORT) {
+            print_message(result, MSG_ERROR, "%s: Symbol %u has invalid binding %u",
+                         filename, i, symbol.binding);
             result->errors++;
             valid = false;
         }
         
         /* Count symbol types */
-        if (bind == SMOF_SYMBOL_BIND_LOCAL) {
+        if (symbol.binding == SMOF_BIND_LOCAL) {
             local_symbols++;
         } else {
             global_symbols++;
         }
         
-        if (type == SMOF_SYMBOL_TYPE_FILE) {
+        if (symbol.type == SMOF_SYM_FILE) {
             found_file_symbol = true;
         }
         
         /* Check section index */
-        if (symbol.section_index != SMOF_SECTION_UNDEF && 
+        if (symbol.section_index != 0xFFFF && 
             symbol.section_index >= header->section_count) {
-            print_message(MSG_ERROR, "%s: Symbol %u references invalid section %u", 
+            print_message(result, MSG_ERROR, "%s: Symbol %u references invalid section %u", 
                          filename, i, symbol.section_index);
             result->errors++;
             valid = false;
         }
         
-        /* Check symbol visibility */
-        uint8_t visibility = SMOF_SYMBOL_VISIBILITY(symbol.other);
-        if (visibility >= SMOF_SYMBOL_VIS_MAX) {
-            print_message(MSG_WARNING, "%s: Symbol %u has invalid visibility %u", 
-                         filename, i, visibility);
-            result->warnings++;
+        /* Check symbol name */
+        if (symbol.name_offset >= header->string_table_size) {
+            print_message(result, MSG_ERROR, "%s: Symbol %u name outside string table", filename, i);
+            result->errors++;
+            valid = false;
         }
     }
     
     /* Pedantic checks */
     if (options.level >= VALIDATION_PEDANTIC) {
         if (!found_file_symbol && global_symbols > 0) {
-            print_message(MSG_INFO, "%s: No file symbol found (recommended for debugging)", 
+            print_message(result, MSG_INFO, "%s: No file symbol found (recommended for debugging)", 
                          filename);
             result->info_messages++;
         }
         
         if (local_symbols == 0 && global_symbols > 0) {
-            print_message(MSG_INFO, "%s: No local symbols found", filename);
+            print_message(result, MSG_INFO, "%s: No local symbols found", filename);
             result->info_messages++;
         }
     }
     
+    free(copy);
+    return valid;
+}
+
+/* Validate relocation table, in the entry format of the file's version */
+static bool validate_relocations(const smof_input_t* input, validation_result_t* result) {
+    const smof_layout_t* header = &input->layout;
+    const char* filename = input->filename;
+    bool wide = header->version == SMOF_VERSION_2;
+    const void* table = input->data + header->reloc_table_offset;
+    void* copy = NULL;
+    smof_relocation_v2_t reloc;
+    smof_relocation_t entry;
+    bool valid = true;
+    uint32_t i;
+    
+    if (header->reloc_count == 0) {
+        return true;
+    }
+    
+    if (input->foreign) {
+        copy = copy_table(input, header->reloc_table_offset,
+                          header->reloc_count * header->reloc_entry_size, result);
+        if (copy == NULL) {
+            return false;
+        }
+        if (wide) {
+            smof_swap_relocations_v2(copy, header->reloc_count);
+        } else {
+            smof_swap_relocations(copy, header->reloc_count);
+        }
+        table = copy;
+    }
+    
+    for (i = 0; i < header->reloc_count; i++) {
+        if (wide) {
+            reloc = ((const smof_relocation_v2_t*)table)[i];
+        } else {
+            entry = ((const smof_relocation_t*)table)[i];
+            reloc.offset = entry.offset;
+            reloc.symbol_index = entry.symbol_index;
+            reloc.section_index = entry.section_index;
+            reloc.type = entry.type;
+        }
+        
+        if (reloc.type > SMOF_RELOC_PLT) {
+            print_message(result, MSG_ERROR, "%s: Relocation %u has invalid type %u",
+                         filename, i, reloc.type);
+            result->errors++;
+            valid = false;
+        }
+        
+        if (reloc.symbol_index >= header->symbol_count) {
+            print_message(result, MSG_ERROR, "%s: Relocation %u references invalid symbol %u",
+                         filename, i, reloc.symbol_index);
+            result->errors++;
+            valid = false;
+        }
+        
+        if (reloc.section_index >= header->section_count) {
+            print_message(result, MSG_ERROR, "%s: Relocation %u references invalid section %u",
+                         filename, i, reloc.section_index);
+            result->errors++;
+            valid = false;
+        }
+    }
+    
+    free(copy);
     return valid;
 }
 
 /* Validate string table */
-static bool validate_string_table(FILE* file, const smof_header_t* header, 
-                                 const char* filename, validation_result_t* result) {
+static bool validate_string_table(const smof_input_t* input, validation_result_t* result) {
+    const smof_layout_t* header = &input->layout;
+    const char* filename = input->filename;
+    
     if (header->string_table_offset == 0) {
         if (header->symbol_count > 0 || header->section_count > 0) {
-            print_message(MSG_WARNING, "%s: No string table but symbols/sections present", filename);
+            print_message(result, MSG_WARNING, "%s: No string table but symbols/sections present", filename);
             result->warnings++;
             return false;
         }
         return true;
     }
     
-    /* Get file size */
-    struct stat st;
-    if (fstat(fileno(file), &st) != 0) {
-        print_message(MSG_ERROR, "%s: Cannot get file size", filename);
+    /* Check if string table is within file bounds */
+    if (header->string_table_offset >= input->size) {
+        print_message(result, MSG_ERROR, "%s: String table offset beyond file end", filename);
         result->errors++;
         return false;
     }
     
-    /* Check if string table is within file bounds */
-    if (header->string_table_offset >= (uint32_t)st.st_size) {
-        print_message(MSG_ERROR, "%s: String table offset beyond file end", filename);
-        result->errors++;
-        return false;
+    /* First byte should be null for empty string */
+    if (input->data[header->string_table_offset] != 0) {
+        print_message(result, MSG_WARNING, "%s: String table does not start with null byte", filename);
+        result->warnings++;
     }
     
-    /* Seek to string table */
-    if (fseek(file, header->string_table_offset, SEEK_SET) != 0) {
-        print_message(MSG_ERROR, "%s: Cannot seek to string table", filename);
+    return true;
+}
+
+/* Validate file integrity: every table the header describes is in the file */
+static bool validate_integrity(const smof_input_t* input, validation_result_t* result) {
+    if (!smof_layout_fits(&input->layout, input->size)) {
+        print_message(result, MSG_ERROR, "%s: File too small for its tables (%llu bytes)", 
+                     input->filename, (unsigned long long)input->size);
         result->errors++;
         return false;
     }
     
-    /* Read first byte - should be null for empty string */
-    uint8_t first_byte;
-    if (fread(&first_byte, 1, 1, file) == 1) {
-        if (first_byte != 0) {
-            print_message(MSG_WARNING, "%s: String table does not start with null byte", filename);
-            result->warnings++;
-        }
-    }
-    
     return true;
 }
 
-/* Validate file integrity */
-static bool validate_integrity(FILE* file, const smof_header_t* header, 
-                              const char* filename, validation_result_t* result) {
+/* Validate single SMOF file */
+static bool validate_smof_file(const char* filename, validation_result_t* result) {
+    smof_input_t input;
+    struct stat st;
+    size_t header_size;
+    void* map = MAP_FAILED;
     bool valid = true;
+    int fd;
     
-    /* Calculate header checksum (excluding the checksum field itself) */
-    uint8_t header_copy[sizeof(smof_header_t)];
-    memcpy(header_copy, header, sizeof(smof_header_t));
-    
-    /* Zero out checksum field */
-    smof_header_t* temp_header = (smof_header_t*)header_copy;
-    temp_header->checksum = 0;
-    
-    uint32_t calculated_checksum = calculate_crc32(header_copy, sizeof(smof_header_t));
-    
-    if (calculated_checksum != header->checksum) {
-        print_message(MSG_ERROR, "%s: Header checksum mismatch (expected 0x%08X, got 0x%08X)", 
-                     filename, header->checksum, calculated_checksum);
+    memset(&input, 0, sizeof(input));
+    input.filename = filename;
+    fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        print_message(result, MSG_ERROR, "%s: Cannot open file: %s", filename, strerror(errno));
         result->errors++;
-        valid = false;
+        return false;
     }
     
-    /* Check file size consistency */
-    struct stat st;
-    if (fstat(fileno(file), &st) == 0) {
-        uint32_t expected_min_size = sizeof(smof_header_t);
-        
-        if (header->section_count > 0) {
-            expected_min_size = header->section_table_offset + 
-                               (header->section_count * sizeof(smof_section_header_t));
-        }
-        
-        if (header->symbol_count > 0) {
-            uint32_t symbol_table_end = header->symbol_table_offset + 
-                                       (header->symbol_count * sizeof(smof_symbol_t));
-            if (symbol_table_end > expected_min_size) {
-                expected_min_size = symbol_table_end;
-            }
-        }
-        
-        if ((uint32_t)st.st_size < expected_min_size) {
-            print_message(MSG_ERROR, "%s: File too small (expected at least %u bytes, got %ld)", 
-                         filename, expected_min_size, st.st_size);
-            result->errors++;
-            valid = false;
-        }
+    if (fstat(fd, &st) != 0) {
+        print_message(result, MSG_ERROR, "%s: Cannot get file size", filename);
+        result->errors++;
+        close(fd);
+        return false;
     }
+    input.size = (uint64_t)st.st_size;
     
-    return valid;
-}
-
-/* Validate single SMOF file */
-static bool validate_smof_file(const char* filename, validation_result_t* result) {
-    FILE* file = fopen(filename, "rb");
-    if (file == NULL) {
-        print_message(MSG_ERROR, "%s: Cannot open file: %s", filename, strerror(errno));
+    if (input.size < sizeof(smof_header_t)) {
+        print_message(result, MSG_ERROR, "%s: Cannot read SMOF header", filename);
         result->errors++;
+        close(fd);
         return false;
     }
     
-    bool valid = true;
-    
-    /* Read header */
-    smof_header_t header;
-    if (fread(&header, sizeof(header), 1, file) != 1) {
-        print_message(MSG_ERROR, "%s: Cannot read SMOF header", filename);
+    /* The mapping outlives the descriptor */
+    if (input.size <= SIZE_MAX) {
+        map = mmap(NULL, (size_t)input.size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) {
+        print_message(result, MSG_ERROR, "%s: Cannot map file", filename);
         result->errors++;
-        fclose(file);
         return false;
     }
+    input.data = map;
     
-    /* Validate header */
-    if (!validate_header(&header, filename, result)) {
-        valid = false;
-    }
+    /* Header, as much as the longer version needs */
+    header_size = input.size < sizeof(smof_header_v2_t) ?
+                  (size_t)input.size : sizeof(smof_header_v2_t);
     
-    /* Only continue with further validation if header is basically valid */
-    if (header.magic == SMOF_MAGIC) {
-        /* Validate sections */
-        if (options.level >= VALIDATION_STANDARD) {
-            if (!validate_sections(file, &header, filename, result)) {
+    /* Only continue with further validation if the header could be read */
+    if (!validate_header(input.data, header_size, &input, result)) {
+        valid = false;
+    } else {
+        /* Validate integrity first: the table checks rely on it */
+        if (!validate_integrity(&input, result)) {
+            valid = false;
+        } else if (options.level >= VALIDATION_STANDARD) {
+            if (!validate_sections(&input, result)) {
                 valid = false;
             }
-        }
-        
-        /* Validate symbols */
-        if (options.level >= VALIDATION_STANDARD) {
-            if (!validate_symbols(file, &header, filename, result)) {
+            
+            if (!validate_symbols(&input, result)) {
                 valid = false;
             }
-        }
-        
-        /* Validate string table */
-        if (options.level >= VALIDATION_STANDARD) {
-            if (!validate_string_table(file, &header, filename, result)) {
+            
+            if (!validate_relocations(&input, result)) {
                 valid = false;
             }
-        }
-        
-        /* Validate integrity */
-        if (options.level >= VALIDATION_STRICT) {
-            if (!validate_integrity(file, &header, filename, result)) {
+            
+            if (!validate_string_table(&input, result)) {
                 valid = false;
             }
         }
     }
     
-    fclose(file);
+    munmap(map, (size_t)input.size);
     
     if (valid && options.verbose) {
-        print_message(MSG_INFO, "%s: File is valid", filename);
+        print_message(result, MSG_INFO, "%s: File is valid", filename);
     }
     
     return valid;
 }
 
+/* The files of one run and their results, one per file */
+typedef struct {
+    char* const* filenames;
+    validation_result_t* results;
+} validation_batch_t;
+
+/* Thread pool task: validate file index of the batch */
+static int validate_file_task(void* user_data, size_t index) {
+    validation_batch_t* batch = user_data;
+    validation_result_t* result = &batch->results[index];
+    
+    result->is_valid = validate_smof_file(batch->filenames[index], result);
+    return ERROR_SUCCESS;
+}
+
 /* Output results in JSON format */
-static void output_json_results(const char** filenames, int file_count, 
+static void output_json_results(char* const* filenames, int file_count, 
                                validation_result_t* results) {
+    uint32_t total_errors = 0, total_warnings = 0, total_info = 0;
+    int valid_files = 0;
+    
     printf("{\n");
     printf("  \"validator\": \"smof_validator\",\n");
     printf("  \"version\": \"1.0.0\",\n");
@@ -573,9 +739,6 @@ static void output_json_results(const char** filenames, int file_count,
     printf("  ],\n");
     
     /* Summary */
-    uint32_t total_errors = 0, total_warnings = 0, total_info = 0;
-    int valid_files = 0;
-    
     for (int i = 0; i < file_count; i++) {
         total_errors += results[i].errors;
         total_warnings += results[i].warnings;
@@ -602,13 +765,17 @@ static int parse_arguments(int argc, char* argv[]) {
         {"json",    no_argument,       0, 'j'},
         {"fix",     no_argument,       0, 'f'},
         {"output",  required_argument, 0, 'o'},
+        {"bulk",    no_argument,       0, 'b'},
+        {"threads", required_argument, 0, 1002},
+        {"files-from", required_argument, 0, 'T'},
         {"help",    no_argument,       0, 'h'},
         {"version", no_argument,       0, 1001},
         {0, 0, 0, 0}
     };
     
+    char* end;
     int opt;
-    while ((opt = getopt_long(argc, argv, "l:vqjfo:h", long_options, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "l:vqjfo:bT:h", long_options, NULL)) != -1) {
         switch (opt) {
             case 'l':
                 if (strcmp(optarg, "basic") == 0) {
@@ -640,6 +807,19 @@ static int parse_arguments(int argc, char* argv[]) {
             case 'o':
                 options.output_file = optarg;
                 break;
+            case 'b':
+                options.threads = 0;
+                break;
+            case 1002:
+                options.threads = (size_t)strtoul(optarg, &end, 10);
+                if (*optarg == '\0' || *end != '\0') {
+                    fprintf(stderr, "Error: Invalid thread count '%s'\n", optarg);
+                    return -1;
+                }
+                break;
+            case 'T':
+                options.files_from = optarg;
+                break;
             case 'h':
                 print_usage(argv[0]);
                 exit(0);
@@ -654,34 +834,125 @@ static int parse_arguments(int argc, char* argv[]) {
     return optind;
 }
 
+/*
+ * Read file names, one per line, from path ("-" = stdin) into *names.
+ * Returns the number of names, or -1 on error.
+ */
+static int read_file_list(const char* path, char*** names) {
+    FILE* file = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    size_t capacity = 0;
+    size_t buffer_size = 0;
+    char* line = NULL;
+    char** grown;
+    ssize_t length;
+    int count = 0;
+    
+    *names = NULL;
+    if (file == NULL) {
+        fprintf(stderr, "Error: Cannot open '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+    
+    while ((length = getline(&line, &buffer_size, file)) >= 0) {
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+            line[--length] = '\0';
+        }
+        if (length == 0) {
+            continue;
+        }
+        
+        if ((size_t)count == capacity) {
+            capacity = capacity > 0 ? capacity * 2 : 256;
+            grown = realloc(*names, capacity * sizeof(char*));
+            if (grown == NULL) {
+                count = -1;
+                break;
+            }
+            *names = grown;
+        }
+        (*names)[count] = malloc((size_t)length + 1);
+        if ((*names)[count] == NULL) {
+            count = -1;
+            break;
+        }
+        memcpy((*names)[count], line, (size_t)length + 1);
+        count++;
+        if (count == INT_MAX) {
+            break;
+        }
+    }
+    
+    free(line);
+    if (file != stdin) {
+        fclose(file);
+    }
+    if (count < 0) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+    }
+    return count;
+}
+
 /* Main function */
 int main(int argc, char* argv[]) {
     int first_file_arg = parse_arguments(argc, argv);
+    validation_batch_t batch;
+    validation_result_t* results;
+    thread_pool_t* pool = NULL;
+    char** filenames;
+    char** listed = NULL;
+    bool all_valid = true;
+    int listed_count = 0;
+    int file_count;
     
     if (first_file_arg < 0) {
         fprintf(stderr, "Try '%s --help' for more information.\n", argv[0]);
         return 2;
     }
     
-    if (first_file_arg >= argc) {
+    if (options.files_from != NULL) {
+        listed_count = read_file_list(options.files_from, &listed);
+        if (listed_count < 0) {
+            return 2;
+        }
+    }
+    
+    if (first_file_arg >= argc && listed_count == 0) {
         fprintf(stderr, "Error: No input files specified\n");
         fprintf(stderr, "Try '%s --help' for more information.\n", argv[0]);
+        free(listed);
         return 2;
     }
     
-    int file_count = argc - first_file_arg;
-    const char** filenames = (const char**)(argv + first_file_arg);
-    validation_result_t* results = calloc(file_count, sizeof(validation_result_t));
+    /* Command line names first, then the listed ones */
+    file_count = argc - first_file_arg + listed_count;
+    filenames = malloc((size_t)file_count * sizeof(char*));
+    results = calloc((size_t)file_count, sizeof(validation_result_t));
     
-    if (results == NULL) {
+    if (filenames == NULL || results == NULL) {
         fprintf(stderr, "Error: Memory allocation failed\n");
+        free(filenames);
+        free(results);
         return 2;
     }
+    memcpy(filenames, argv + first_file_arg, (size_t)(argc - first_file_arg) * sizeof(char*));
+    if (listed_count > 0) {
+        memcpy(filenames + (argc - first_file_arg), listed, (size_t)listed_count * sizeof(char*));
+    }
+    
+    /* Validate each file; without a pool the batch runs on this thread */
+    if (options.threads != 1 && file_count > 1) {
+        pool = thread_pool_create(options.threads);
+    }
+    batch.filenames = filenames;
+    batch.results = results;
+    thread_pool_run(pool, (size_t)file_count, validate_file_task, &batch);
+    thread_pool_destroy(pool);
     
-    /* Validate each file */
-    bool all_valid = true;
     for (int i = 0; i < file_count; i++) {
-        results[i].is_valid = validate_smof_file(filenames[i], &results[i]);
+        if (results[i].log != NULL) {
+            fputs(results[i].log, stdout);
+            free(results[i].log);
+        }
         if (!results[i].is_valid) {
             all_valid = false;
         }
@@ -715,6 +986,11 @@ int main(int argc, char* argv[]) {
         }
     }
     
+    for (int i = 0; i < listed_count; i++) {
+        free(listed[i]);
+    }
+    free(listed);
+    free(filenames);
     free(results);
     return all_valid ? 0 : 1;
 }
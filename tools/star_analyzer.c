@@ -6,6 +6,8 @@
  * 
  * Advanced analysis tool for STAR archives providing detailed statistics,
  * compression analysis, integrity checking, and optimization recommendations.
+ * An optional compression trial recompresses every member with one
+ * algorithm, several members at a time, to show what it would save.
  */
 
 #include <stdio.h>
@@ -16,13 +18,13 @@
 #include <getopt.h>
 #include <errno.h>
 #include <time.h>
-#include <math.h>
 
 #include "star.h"
 #include "archive.h"
 #include "compress.h"
 #include "index.h"
 #include "error.h"
+#include "thread_pool.h"
 
 /* Analysis modes */
 typedef enum {
@@ -33,6 +35,24 @@ typedef enum {
     ANALYSIS_OPTIMIZATION /* Optimization recommendations */
 } analysis_mode_t;
 
+/* Member types, by file name extension */
+typedef enum {
+    MEMBER_OBJECT,
+    MEMBER_EXECUTABLE,
+    MEMBER_LIBRARY,
+    MEMBER_OTHER,
+    MEMBER_TYPE_COUNT
+} member_type_t;
+
+/* Sizes of the members of one type, as stored or as a trial compressed them */
+typedef struct {
+    size_t count;                   /* Members with data */
+    uint64_t original_size;
+    uint64_t compressed_size;
+    double best_ratio;              /* Compressed over original size */
+    double worst_ratio;
+} type_stats_t;
+
 /* Statistics structure */
 typedef struct {
     /* File counts */
@@ -43,8 +63,10 @@ typedef struct {
     size_t library_members;
     
     /* Size statistics */
+    uint64_t archive_size;
     uint64_t total_original_size;
-    uint64_t total_compressed_size;
+    uint64_t total_compressed_size;  /* Stored bytes, shared data counted once */
+    uint64_t shared_size;            /* Stored bytes members share instead of repeating */
     uint64_t archive_overhead;
     double compression_ratio;
     double space_efficiency;
@@ -55,6 +77,10 @@ typedef struct {
     double average_compression_ratio;
     double best_compression_ratio;
     double worst_compression_ratio;
+    size_t blocked_members;
+    size_t block_size;              /* Largest block size of blocked members */
+    size_t dictionary_size;
+    type_stats_t types[MEMBER_TYPE_COUNT];
     
     /* Symbol statistics */
     size_t total_symbols;
@@ -73,6 +99,23 @@ typedef struct {
     double index_overhead;
 } archive_stats_t;
 
+/*
+ * One archive under analysis. It is mapped once; every statistic comes
+ * from one pass over its member table, and the detailed and compression
+ * passes walk the same loaded members instead of listing them again.
+ */
+typedef struct {
+    const char* filename;
+    archive_file_t* archive;
+    archive_stats_t stats;
+    
+    /* Compression trial, if one was asked for */
+    const compression_algorithm_t* trial_algorithm;
+    uint64_t* trial_sizes;          /* Per member, UINT64_MAX = not compressed */
+    size_t trial_failures;          /* Members whose data could not be read */
+    type_stats_t trial[MEMBER_TYPE_COUNT];
+} archive_analysis_t;
+
 /* Global options */
 static struct {
     analysis_mode_t mode;
@@ -82,6 +125,8 @@ static struct {
     bool detailed_compression;
     bool show_recommendations;
     const char* output_file;
+    const char* trial;             /* Algorithm to trial, NULL = none */
+    size_t threads;                /* Trial threads, 0 = one per CPU */
 } options = {
     .mode = ANALYSIS_BASIC,
     .verbose = false,
@@ -89,7 +134,9 @@ static struct {
     .csv_output = false,
     .detailed_compression = false,
     .show_recommendations = false,
-    .output_file = NULL
+    .output_file = NULL,
+    .trial = NULL,
+    .threads = 0
 };
 
 /* Print usage information */
@@ -104,6 +151,8 @@ static void print_usage(const char* program_name) {
     printf("  -c, --csv               Output results in CSV format\n");
     printf("  --compression           Show detailed compression analysis\n");
     printf("  --recommendations       Show optimization recommendations\n");
+    printf("  --trial ALGORITHM       Recompress every member with ALGORITHM (lz4|zlib|lzma)\n");
+    printf("  --threads N             Run the trial on N threads (default: one per CPU)\n");
     printf("  -o, --output FILE       Write results to FILE\n");
     printf("  -h, --help              Show this help message\n");
     printf("  --version               Show version information\n");
@@ -118,6 +167,7 @@ static void print_usage(const char* program_name) {
     printf("  %s -m detailed -v archive.star            # Detailed verbose analysis\n", program_name);
     printf("  %s --compression --json archive.star      # Compression analysis in JSON\n", program_name);
     printf("  %s -m optimization *.star                 # Optimization recommendations\n", program_name);
+    printf("  %s -m compression --trial lzma lib.star   # What LZMA would save\n", program_name);
 }
 
 /* Print version information */
@@ -127,82 +177,130 @@ static void print_version(void) {
     printf("Copyright (c) 2025 STIX Project\n");
 }
 
-/* Calculate archive statistics */
-static bool calculate_statistics(star_context_t* context, const char* filename, 
-                                archive_stats_t* stats) {
-    memset(stats, 0, sizeof(archive_stats_t));
+/* Member type, by file name extension */
+static member_type_t member_type_of(const char* name) {
+    const char* ext = name != NULL ? strrchr(name, '.') : NULL;
     
-    /* Get basic archive information */
-    star_archive_info_t archive_info;
-    if (star_get_archive_info(context, filename, &archive_info) != 0) {
-        return false;
+    if (ext == NULL) {
+        return MEMBER_OTHER;
+    }
+    if (strcmp(ext, ".smof") == 0) {
+        return MEMBER_OBJECT;
+    }
+    if (strcmp(ext, ".exe") == 0 || strcmp(ext, ".bin") == 0) {
+        return MEMBER_EXECUTABLE;
     }
+    if (strcmp(ext, ".star") == 0 || strcmp(ext, ".a") == 0) {
+        return MEMBER_LIBRARY;
+    }
+    return MEMBER_OTHER;
+}
+
+static void type_stats_add(type_stats_t* type, uint64_t original, uint64_t compressed) {
+    double ratio;
     
-    stats->total_members = archive_info.member_count;
-    stats->total_original_size = archive_info.total_size;
-    stats->total_compressed_size = archive_info.compressed_size;
-    stats->archive_overhead = archive_info.archive_size - archive_info.compressed_size;
+    if (original == 0) {
+        return;
+    }
     
-    if (stats->total_original_size > 0) {
-        stats->compression_ratio = (double)stats->total_compressed_size / stats->total_original_size;
-        stats->space_efficiency = 1.0 - stats->compression_ratio;
+    ratio = (double)compressed / (double)original;
+    if (type->count == 0 || ratio < type->best_ratio) {
+        type->best_ratio = ratio;
     }
+    if (type->count == 0 || ratio > type->worst_ratio) {
+        type->worst_ratio = ratio;
+    }
+    type->count++;
+    type->original_size += original;
+    type->compressed_size += compressed;
+}
+
+/*
+ * Add offset to an open-addressed set of data offsets (0 = empty slot, as
+ * no member data starts at 0). False if it was already there: identical
+ * members share one stored copy.
+ */
+static bool add_data_offset(uint32_t* slots, uint32_t mask, uint32_t offset) {
+    uint32_t slot = (offset * 2654435761U) & mask;
     
-    /* Get member details */
-    star_member_info_t* members = malloc(stats->total_members * sizeof(star_member_info_t));
-    if (members == NULL) {
-        return false;
+    while (slots[slot] != 0) {
+        if (slots[slot] == offset) {
+            return false;
+        }
+        slot = (slot + 1) & mask;
     }
+    slots[slot] = offset;
+    return true;
+}
+
+/* Calculate archive statistics in one pass over the member table */
+static bool calculate_statistics(archive_analysis_t* analysis) {
+    const archive_file_t* archive = analysis->archive;
+    archive_stats_t* stats = &analysis->stats;
+    size_t algorithm_counts[STAR_COMPRESS_AUTO] = {0};
+    uint32_t* offsets;
+    uint32_t mask = 15;
+    const compression_algorithm_t* algorithm;
+    symbol_index_stats_t index_stats;
+    symbol_index_t* index;
+    double total_ratio = 0.0;
+    size_t max_count = 0;
+    uint32_t i;
+    
+    memset(stats, 0, sizeof(archive_stats_t));
+    stats->total_members = archive->header.member_count;
+    stats->archive_size = archive->map_size;
+    stats->dictionary_size = archive->header.dictionary_size;
     
-    size_t member_count = stats->total_members;
-    if (star_list_archive(context, filename, members, &member_count) != 0) {
-        free(members);
+    /* At most half full, so probes stay short */
+    while (mask / 2 < archive->header.member_count && mask < UINT32_MAX / 2) {
+        mask = mask * 2 + 1;
+    }
+    offsets = calloc((size_t)mask + 1, sizeof(uint32_t));
+    if (offsets == NULL) {
         return false;
     }
     
-    /* Initialize time statistics */
-    stats->oldest_member = UINT64_MAX;
-    stats->newest_member = 0;
-    
     /* Analyze compression ratios */
-    double total_ratio = 0.0;
     stats->best_compression_ratio = 1.0;
     stats->worst_compression_ratio = 0.0;
     
-    /* Count algorithm usage */
-    char algorithms[16][32];
-    size_t algorithm_counts[16] = {0};
-    size_t unique_algorithms = 0;
-    
-    for (size_t i = 0; i < member_count; i++) {
-        const star_member_info_t* member = &members[i];
+    for (i = 0; i < archive->header.member_count; i++) {
+        const archive_member_t* member = &archive->members[i];
+        time_t timestamp = archive_member_get_timestamp(member);
+        uint32_t stored = archive_stored_size(member);
+        member_type_t type = member_type_of(member->name);
         
         /* Update time statistics */
-        if (member->timestamp < stats->oldest_member) {
-            stats->oldest_member = member->timestamp;
+        if (i == 0 || timestamp < stats->oldest_member) {
+            stats->oldest_member = timestamp;
         }
-        if (member->timestamp > stats->newest_member) {
-            stats->newest_member = member->timestamp;
+        if (i == 0 || timestamp > stats->newest_member) {
+            stats->newest_member = timestamp;
         }
         
         /* Count member types based on filename extension */
-        const char* ext = strrchr(member->name, '.');
-        if (ext != NULL) {
-            if (strcmp(ext, ".smof") == 0) {
-                stats->object_members++;
-            } else if (strcmp(ext, ".exe") == 0 || strcmp(ext, ".bin") == 0) {
-                stats->executable_members++;
-            } else if (strcmp(ext, ".star") == 0 || strcmp(ext, ".a") == 0) {
-                stats->library_members++;
-            }
+        if (type == MEMBER_OBJECT) {
+            stats->object_members++;
+        } else if (type == MEMBER_EXECUTABLE) {
+            stats->executable_members++;
+        } else if (type == MEMBER_LIBRARY) {
+            stats->library_members++;
         }
+        type_stats_add(&stats->types[type], member->header.size, stored);
         
-        /* Count compressed members */
-        if (member->compressed_size < member->size) {
-            stats->compressed_members++;
+        stats->total_original_size += member->header.size;
+        if (stored == 0 || add_data_offset(offsets, mask, member->header.data_offset)) {
+            stats->total_compressed_size += stored;
+        } else {
+            stats->shared_size += stored;
+        }
+        
+        /* Count compressed members and their algorithms */
+        if (archive_member_is_compressed(member) && member->header.size > 0) {
+            double ratio = (double)stored / (double)member->header.size;
             
-            /* Track compression ratio */
-            double ratio = (double)member->compressed_size / member->size;
+            stats->compressed_members++;
             total_ratio += ratio;
             
             if (ratio < stats->best_compression_ratio) {
@@ -211,79 +309,145 @@ static bool calculate_statistics(star_context_t* context, const char* filename,
             if (ratio > stats->worst_compression_ratio) {
                 stats->worst_compression_ratio = ratio;
             }
-        }
-        
-        /* Count compression algorithms */
-        if (member->compression_algorithm && strlen(member->compression_algorithm) > 0) {
-            bool found = false;
-            for (size_t j = 0; j < unique_algorithms; j++) {
-                if (strcmp(algorithms[j], member->compression_algorithm) == 0) {
-                    algorithm_counts[j]++;
-                    found = true;
-                    break;
-                }
+            
+            if (member->header.compression < STAR_COMPRESS_AUTO) {
+                algorithm_counts[member->header.compression]++;
             }
             
-            if (!found && unique_algorithms < 16) {
-                strncpy(algorithms[unique_algorithms], member->compression_algorithm, 31);
-                algorithms[unique_algorithms][31] = '\0';
-                algorithm_counts[unique_algorithms] = 1;
-                unique_algorithms++;
+            if (archive_member_is_blocked(member) &&
+                ((size_t)1 << member->header.block_shift) > stats->block_size) {
+                stats->block_size = (size_t)1 << member->header.block_shift;
+            }
+            if (archive_member_is_blocked(member)) {
+                stats->blocked_members++;
             }
         }
     }
     
-    stats->compression_algorithms_used = unique_algorithms;
+    free(offsets);
+    
+    stats->archive_overhead = stats->archive_size - stats->total_compressed_size;
+    
+    if (stats->total_original_size > 0) {
+        stats->compression_ratio = (double)stats->total_compressed_size /
+                                   (double)stats->total_original_size;
+        stats->space_efficiency = 1.0 - stats->compression_ratio;
+    }
     
     /* Find primary algorithm (most used) */
-    size_t max_count = 0;
-    for (size_t i = 0; i < unique_algorithms; i++) {
+    for (i = 0; i < STAR_COMPRESS_AUTO; i++) {
+        algorithm = compression_get_algorithm((star_compression_t)i);
+        if (algorithm_counts[i] == 0 || algorithm == NULL) {
+            continue;
+        }
+        stats->compression_algorithms_used++;
         if (algorithm_counts[i] > max_count) {
             max_count = algorithm_counts[i];
-            strncpy(stats->primary_algorithm, algorithms[i], sizeof(stats->primary_algorithm) - 1);
-            stats->primary_algorithm[sizeof(stats->primary_algorithm) - 1] = '\0';
+            snprintf(stats->primary_algorithm, sizeof(stats->primary_algorithm), "%s",
+                     algorithm->name);
         }
     }
     
     /* Calculate average compression ratio */
     if (stats->compressed_members > 0) {
-        stats->average_compression_ratio = total_ratio / stats->compressed_members;
+        stats->average_compression_ratio = total_ratio / (double)stats->compressed_members;
     }
     
-    /* Get symbol statistics if available */
-    star_symbol_info_t* symbols = malloc(10000 * sizeof(star_symbol_info_t));
-    if (symbols != NULL) {
-        size_t symbol_count = 10000;
-        if (star_list_symbols(context, filename, symbols, &symbol_count) == 0) {
+    /* Symbol statistics from the index, used where it lies in the mapping */
+    if (archive_has_index(archive) && archive->header.index_size > 0) {
+        stats->has_file_index = true;
+        stats->index_size = archive->header.index_size;
+        if (stats->archive_size > 0) {
+            stats->index_overhead = (double)stats->index_size / (double)stats->archive_size;
+        }
+        
+        index = symbol_index_create(0);
+        if (index != NULL && symbol_index_load_from_archive(index, archive) == ERROR_SUCCESS) {
+            symbol_index_get_stats(index, &index_stats);
             stats->has_symbol_index = true;
-            stats->total_symbols = symbol_count;
-            
-            for (size_t i = 0; i < symbol_count; i++) {
-                switch (symbols[i].binding) {
-                    case STAR_SYMBOL_GLOBAL:
-                        stats->global_symbols++;
-                        break;
-                    case STAR_SYMBOL_WEAK:
-                        stats->weak_symbols++;
-                        break;
-                    case STAR_SYMBOL_UNDEFINED:
-                        stats->undefined_symbols++;
-                        break;
-                }
-            }
+            stats->total_symbols = index_stats.total_symbols;
+            stats->global_symbols = index_stats.global_symbols;
+            stats->weak_symbols = index_stats.weak_symbols;
+            /* The index holds definitions only */
+            stats->undefined_symbols = 0;
         }
-        free(symbols);
+        symbol_index_destroy(index);
     }
     
-    /* Check for file index */
-    star_index_info_t index_info;
-    if (star_get_index_info(context, filename, &index_info) == 0) {
-        stats->has_file_index = true;
-        stats->index_size = index_info.size;
-        stats->index_overhead = (double)stats->index_size / archive_info.archive_size;
+    return true;
+}
+
+/* Thread pool task: compress member index with the trial algorithm */
+static int trial_member_task(void* user_data, size_t index) {
+    archive_analysis_t* analysis = user_data;
+    const archive_member_t* member = &analysis->archive->members[index];
+    const uint8_t* data = NULL;
+    uint8_t* buffer = NULL;
+    uint8_t* output = NULL;
+    size_t output_size = 0;
+    
+    analysis->trial_sizes[index] = UINT64_MAX;
+    if (member->header.size == 0) {
+        return ERROR_SUCCESS;
+    }
+    
+    /* Data stored as it is is used in the mapping */
+    if (!archive_member_is_compressed(member)) {
+        data = archive_member_data(analysis->archive, member);
+    } else {
+        buffer = malloc(member->header.size);
+        if (buffer != NULL &&
+            archive_read_member(analysis->archive, member, buffer) == ERROR_SUCCESS) {
+            data = buffer;
+        }
+    }
+    
+    if (data != NULL &&
+        compression_compress_data(analysis->trial_algorithm->type, -1, data, member->header.size,
+                                  &output, &output_size) == COMPRESS_SUCCESS) {
+        analysis->trial_sizes[index] = output_size;
+        compression_free_buffer(output);
+    }
+    
+    free(buffer);
+    return ERROR_SUCCESS;
+}
+
+/* Recompress every member with the trial algorithm, several at a time */
+static bool run_compression_trial(archive_analysis_t* analysis) {
+    const archive_file_t* archive = analysis->archive;
+    thread_pool_t* pool = NULL;
+    uint32_t count = archive->header.member_count;
+    uint32_t i;
+    
+    if (count == 0) {
+        return true;
+    }
+    
+    analysis->trial_sizes = malloc(count * sizeof(uint64_t));
+    if (analysis->trial_sizes == NULL) {
+        return false;
+    }
+    
+    if (options.threads != 1) {
+        pool = thread_pool_create(options.threads);
+    }
+    thread_pool_run(pool, count, trial_member_task, analysis);
+    thread_pool_destroy(pool);
+    
+    for (i = 0; i < count; i++) {
+        const archive_member_t* member = &archive->members[i];
+        
+        if (analysis->trial_sizes[i] == UINT64_MAX) {
+            if (member->header.size > 0) {
+                analysis->trial_failures++;
+            }
+            continue;
+        }
+        type_stats_add(&analysis->trial[member_type_of(member->name)],
+                       member->header.size, analysis->trial_sizes[i]);
     }
     
-    free(members);
     return true;
 }
 
@@ -296,10 +460,12 @@ static void print_basic_analysis(const char* filename, const archive_stats_t* st
     printf("  Total Members:      %zu\n", stats->total_members);
     printf("  Original Size:      %llu bytes (%.2f MB)\n", 
            (unsigned long long)stats->total_original_size,
-           stats->total_original_size / (1024.0 * 1024.0));
+           (double)stats->total_original_size / (1024.0 * 1024.0));
     printf("  Compressed Size:    %llu bytes (%.2f MB)\n",
            (unsigned long long)stats->total_compressed_size,
-           stats->total_compressed_size / (1024.0 * 1024.0));
+           (double)stats->total_compressed_size / (1024.0 * 1024.0));
+    printf("  Shared Data:        %llu bytes (not stored again)\n",
+           (unsigned long long)stats->shared_size);
     printf("  Archive Overhead:   %llu bytes\n", (unsigned long long)stats->archive_overhead);
     printf("  Space Efficiency:   %.1f%%\n", stats->space_efficiency * 100.0);
     
@@ -313,7 +479,7 @@ static void print_basic_analysis(const char* filename, const archive_stats_t* st
     printf("\nCompression:\n");
     printf("  Compressed Members: %zu (%.1f%%)\n", 
            stats->compressed_members,
-           (stats->total_members > 0) ? (stats->compressed_members * 100.0 / stats->total_members) : 0.0);
+           (stats->total_members > 0) ? ((double)stats->compressed_members * 100.0 / (double)stats->total_members) : 0.0);
     printf("  Primary Algorithm:  %s\n", 
            strlen(stats->primary_algorithm) > 0 ? stats->primary_algorithm : "None");
     printf("  Average Ratio:      %.1f%%\n", (1.0 - stats->average_compression_ratio) * 100.0);
@@ -335,40 +501,39 @@ static void print_basic_analysis(const char* filename, const archive_stats_t* st
     printf("\n");
 }
 
-/* Print detailed member analysis */
-static void print_detailed_analysis(star_context_t* context, const char* filename,
-                                   const archive_stats_t* stats) {
-    printf("Detailed Member Analysis:\n");
-    printf("========================================\n\n");
+/* Member algorithm name, NONE for members stored as they are */
+static const char* member_algorithm_name(const archive_member_t* member) {
+    const compression_algorithm_t* algorithm = NULL;
     
-    star_member_info_t* members = malloc(stats->total_members * sizeof(star_member_info_t));
-    if (members == NULL) {
-        printf("Error: Memory allocation failed\n");
-        return;
+    if (archive_member_is_compressed(member)) {
+        algorithm = compression_get_algorithm((star_compression_t)member->header.compression);
     }
+    return algorithm != NULL ? algorithm->name : "NONE";
+}
+
+/* Print detailed member analysis */
+static void print_detailed_analysis(const archive_analysis_t* analysis) {
+    const archive_file_t* archive = analysis->archive;
     
-    size_t member_count = stats->total_members;
-    if (star_list_archive(context, filename, members, &member_count) != 0) {
-        printf("Error: Cannot list archive members\n");
-        free(members);
-        return;
-    }
+    printf("Detailed Member Analysis:\n");
+    printf("========================================\n\n");
     
     printf("%-32s %10s %10s %8s %8s %s\n",
            "Member Name", "Original", "Compressed", "Ratio", "Type", "Algorithm");
     printf("%-32s %10s %10s %8s %8s %s\n",
            "----------", "--------", "----------", "-----", "----", "---------");
     
-    for (size_t i = 0; i < member_count; i++) {
-        const star_member_info_t* member = &members[i];
-        
+    for (uint32_t i = 0; i < archive->header.member_count; i++) {
+        const archive_member_t* member = &archive->members[i];
+        uint32_t stored = archive_stored_size(member);
+        const char* ext = member->name != NULL ? strrchr(member->name, '.') : NULL;
+        const char* type = "OTHER";
         double ratio = 0.0;
-        if (member->size > 0) {
-            ratio = (1.0 - (double)member->compressed_size / member->size) * 100.0;
+        
+        if (member->header.size > 0) {
+            ratio = (1.0 - (double)stored / (double)member->header.size) * 100.0;
         }
         
-        const char* type = "OTHER";
-        const char* ext = strrchr(member->name, '.');
         if (ext != NULL) {
             if (strcmp(ext, ".smof") == 0) type = "OBJECT";
             else if (strcmp(ext, ".exe") == 0) type = "EXEC";
@@ -377,66 +542,104 @@ static void print_detailed_analysis(star_context_t* context, const char* filenam
         }
         
         printf("%-32s %10u %10u %7.1f%% %8s %s\n",
-               member->name,
-               member->size,
-               member->compressed_size,
+               member->name != NULL ? member->name : "<unnamed>",
+               member->header.size,
+               stored,
                ratio,
                type,
-               member->compression_algorithm ? member->compression_algorithm : "NONE");
+               member_algorithm_name(member));
     }
     
-    free(members);
+    printf("\n");
+}
+
+/* Rows of savings by member type: average over the type's bytes, best and worst member */
+static void print_type_table(const type_stats_t* types) {
+    static const char* const labels[MEMBER_TYPE_COUNT] = {
+        "Object", "Executable", "Library", "Other"
+    };
+    
+    printf("  File Type    Count   Avg Ratio   Best    Worst\n");
+    printf("  ---------    -----   ---------   ----    -----\n");
+    
+    for (int i = 0; i < MEMBER_TYPE_COUNT; i++) {
+        const type_stats_t* type = &types[i];
+        double average = 0.0;
+        
+        if (type->count == 0) {
+            continue;
+        }
+        average = 1.0 - (double)type->compressed_size / (double)type->original_size;
+        printf("  %-10s   %5zu      %5.1f%%   %5.1f%%  %5.1f%%\n",
+               labels[i], type->count, average * 100.0,
+               (1.0 - type->best_ratio) * 100.0, (1.0 - type->worst_ratio) * 100.0);
+    }
+}
+
+/* Print what the trial algorithm saved, next to what is stored */
+static void print_trial_analysis(const archive_analysis_t* analysis) {
+    uint64_t original = 0;
+    uint64_t compressed = 0;
+    
+    for (int i = 0; i < MEMBER_TYPE_COUNT; i++) {
+        original += analysis->trial[i].original_size;
+        compressed += analysis->trial[i].compressed_size;
+    }
+    
+    printf("Compression Trial (%s):\n", analysis->trial_algorithm->name);
+    printf("  Trial Size:         %llu bytes (stored: %llu bytes)\n",
+           (unsigned long long)compressed, (unsigned long long)analysis->stats.total_compressed_size);
+    printf("  Trial Ratio:        %.1f%%\n",
+           original > 0 ? (1.0 - (double)compressed / (double)original) * 100.0 : 0.0);
+    if (analysis->trial_failures > 0) {
+        printf("  Unreadable Members: %zu\n", analysis->trial_failures);
+    }
+    printf("\n");
+    print_type_table(analysis->trial);
     printf("\n");
 }
 
 /* Print compression analysis */
-static void print_compression_analysis(star_context_t* context, const char* filename,
-                                      const archive_stats_t* stats) {
+static void print_compression_analysis(const archive_analysis_t* analysis) {
+    const archive_stats_t* stats = &analysis->stats;
+    
     printf("Compression Analysis:\n");
     printf("========================================\n\n");
     
     printf("Overall Compression Statistics:\n");
     printf("  Algorithms Used:    %zu\n", stats->compression_algorithms_used);
-    printf("  Primary Algorithm:  %s\n", stats->primary_algorithm);
+    printf("  Primary Algorithm:  %s\n",
+           strlen(stats->primary_algorithm) > 0 ? stats->primary_algorithm : "None");
     printf("  Average Ratio:      %.1f%%\n", (1.0 - stats->average_compression_ratio) * 100.0);
     printf("  Best Ratio:         %.1f%%\n", (1.0 - stats->best_compression_ratio) * 100.0);
     printf("  Worst Ratio:        %.1f%%\n", (1.0 - stats->worst_compression_ratio) * 100.0);
     printf("\n");
     
-    /* Get detailed compression information */
-    star_compression_info_t comp_info;
-    if (star_get_compression_info(context, filename, &comp_info) == 0) {
-        printf("Compression Configuration:\n");
-        printf("  Algorithm:          %s\n", comp_info.algorithm_name);
-        printf("  Compression Level:  %d\n", comp_info.level);
-        printf("  Dictionary Size:    %zu bytes\n", comp_info.dictionary_size);
-        printf("  Block Size:         %zu bytes\n", comp_info.block_size);
-        printf("  Total Blocks:       %zu\n", comp_info.block_count);
-        printf("\n");
+    printf("Compression Configuration:\n");
+    printf("  Dictionary Size:    %zu bytes\n", stats->dictionary_size);
+    printf("  Blocked Members:    %zu\n", stats->blocked_members);
+    if (stats->blocked_members > 0) {
+        printf("  Block Size:         %zu bytes\n", stats->block_size);
     }
+    printf("\n");
     
     /* Analyze compression effectiveness by file type */
     printf("Compression Effectiveness by File Type:\n");
-    printf("  File Type    Count   Avg Ratio   Best    Worst\n");
-    printf("  ---------    -----   ---------   ----    -----\n");
-    
-    /* This would require collecting statistics by file type */
-    printf("  Object       %4zu      %5.1f%%   %5.1f%%  %5.1f%%\n", 
-           stats->object_members, 65.0, 80.0, 45.0);
-    printf("  Executable   %4zu      %5.1f%%   %5.1f%%  %5.1f%%\n", 
-           stats->executable_members, 55.0, 70.0, 35.0);
-    printf("  Library      %4zu      %5.1f%%   %5.1f%%  %5.1f%%\n", 
-           stats->library_members, 70.0, 85.0, 50.0);
+    print_type_table(stats->types);
     printf("\n");
+    
+    if (analysis->trial_algorithm != NULL) {
+        print_trial_analysis(analysis);
+    }
 }
 
 /* Print optimization recommendations */
 static void print_optimization_recommendations(const archive_stats_t* stats) {
+    int recommendations = 0;
+    
     printf("Optimization Recommendations:\n");
     printf("========================================\n\n");
     
-    int recommendations = 0;
-    
     /* Check compression efficiency */
     if (stats->space_efficiency < 0.3) {
         printf("%d. Consider using a higher compression level or different algorithm.\n", ++recommendations);
@@ -490,7 +693,10 @@ static void print_optimization_recommendations(const archive_stats_t* stats) {
 }
 
 /* Output results in JSON format */
-static void output_json_results(const char* filename, const archive_stats_t* stats) {
+static void output_json_results(const archive_analysis_t* analysis) {
+    const archive_stats_t* stats = &analysis->stats;
+    const char* filename = analysis->filename;
+    
     printf("{\n");
     printf("  \"analyzer\": \"star_analyzer\",\n");
     printf("  \"version\": \"1.0.0\",\n");
@@ -509,6 +715,7 @@ static void output_json_results(const char* filename, const archive_stats_t* sta
     printf("    \"sizes\": {\n");
     printf("      \"original_bytes\": %llu,\n", (unsigned long long)stats->total_original_size);
     printf("      \"compressed_bytes\": %llu,\n", (unsigned long long)stats->total_compressed_size);
+    printf("      \"shared_bytes\": %llu,\n", (unsigned long long)stats->shared_size);
     printf("      \"overhead_bytes\": %llu,\n", (unsigned long long)stats->archive_overhead);
     printf("      \"compression_ratio\": %.4f,\n", stats->compression_ratio);
     printf("      \"space_efficiency\": %.4f\n", stats->space_efficiency);
@@ -534,7 +741,23 @@ static void output_json_results(const char* filename, const archive_stats_t* sta
     printf("      \"has_file_index\": %s,\n", stats->has_file_index ? "true" : "false");
     printf("      \"size_bytes\": %zu,\n", stats->index_size);
     printf("      \"overhead_ratio\": %.4f\n", stats->index_overhead);
-    printf("    }\n");
+    printf("    }%s\n", analysis->trial_algorithm != NULL ? "," : "");
+    
+    if (analysis->trial_algorithm != NULL) {
+        uint64_t original = 0;
+        uint64_t compressed = 0;
+        
+        for (int i = 0; i < MEMBER_TYPE_COUNT; i++) {
+            original += analysis->trial[i].original_size;
+            compressed += analysis->trial[i].compressed_size;
+        }
+        printf("    \"trial\": {\n");
+        printf("      \"algorithm\": \"%s\",\n", analysis->trial_algorithm->name);
+        printf("      \"original_bytes\": %llu,\n", (unsigned long long)original);
+        printf("      \"compressed_bytes\": %llu,\n", (unsigned long long)compressed);
+        printf("      \"unreadable_members\": %zu\n", analysis->trial_failures);
+        printf("    }\n");
+    }
     
     printf("  }\n");
     printf("}\n");
@@ -552,9 +775,13 @@ static int parse_arguments(int argc, char* argv[]) {
         {"output",          required_argument, 0, 'o'},
         {"help",            no_argument,       0, 'h'},
         {"version",         no_argument,       0, 1003},
+        {"trial",           required_argument, 0, 1004},
+        {"threads",         required_argument, 0, 1005},
         {0, 0, 0, 0}
     };
     
+    const compression_algorithm_t* algorithm;
+    char* end;
     int opt;
     while ((opt = getopt_long(argc, argv, "m:vjco:h", long_options, NULL)) != -1) {
         switch (opt) {
@@ -598,6 +825,21 @@ static int parse_arguments(int argc, char* argv[]) {
             case 1003:
                 print_version();
                 exit(0);
+            case 1004:
+                algorithm = compression_find_algorithm(optarg);
+                if (algorithm == NULL || algorithm->type == STAR_COMPRESS_NONE) {
+                    fprintf(stderr, "Error: Invalid trial algorithm '%s'\n", optarg);
+                    return -1;
+                }
+                options.trial = optarg;
+                break;
+            case 1005:
+                options.threads = (size_t)strtoul(optarg, &end, 10);
+                if (*optarg == '\0' || *end != '\0') {
+                    fprintf(stderr, "Error: Invalid thread count '%s'\n", optarg);
+                    return -1;
+                }
+                break;
             case '?':
                 return -1;
         }
@@ -608,62 +850,79 @@ static int parse_arguments(int argc, char* argv[]) {
 
 /* Analyze single archive */
 static bool analyze_archive(const char* filename) {
-    star_options_t star_opts = star_get_default_options();
-    star_opts.verbose = options.verbose;
+    archive_analysis_t analysis;
+    bool success = true;
     
-    star_context_t* context = star_context_create(&star_opts);
-    if (context == NULL) {
-        fprintf(stderr, "Error: Cannot create STAR context\n");
+    memset(&analysis, 0, sizeof(analysis));
+    analysis.filename = filename;
+    analysis.archive = archive_map(filename);
+    if (analysis.archive == NULL) {
+        fprintf(stderr, "Error: Cannot analyze archive '%s'\n", filename);
         return false;
     }
     
-    archive_stats_t stats;
-    if (!calculate_statistics(context, filename, &stats)) {
-        fprintf(stderr, "Error: Cannot analyze archive '%s'\n", filename);
-        star_context_destroy(context);
-        return false;
+    if (!calculate_statistics(&analysis)) {
+        fprintf(stderr, "Error: Memory allocation failed\n");
+        success = false;
+    }
+    
+    if (success && options.trial != NULL) {
+        analysis.trial_algorithm = compression_find_algorithm(options.trial);
+        if (!run_compression_trial(&analysis)) {
+            fprintf(stderr, "Error: Memory allocation failed\n");
+            success = false;
+        }
     }
     
     /* Output results based on format */
-    if (options.json_output) {
-        output_json_results(filename, &stats);
+    if (!success) {
+        /* Nothing to report */
+    } else if (options.json_output) {
+        output_json_results(&analysis);
     } else {
         switch (options.mode) {
             case ANALYSIS_BASIC:
-                print_basic_analysis(filename, &stats);
+                print_basic_analysis(filename, &analysis.stats);
                 break;
             case ANALYSIS_DETAILED:
-                print_basic_analysis(filename, &stats);
-                print_detailed_analysis(context, filename, &stats);
+                print_basic_analysis(filename, &analysis.stats);
+                print_detailed_analysis(&analysis);
                 break;
             case ANALYSIS_COMPRESSION:
-                print_compression_analysis(context, filename, &stats);
+                print_compression_analysis(&analysis);
                 if (options.detailed_compression) {
-                    print_detailed_analysis(context, filename, &stats);
+                    print_detailed_analysis(&analysis);
                 }
                 break;
             case ANALYSIS_INTEGRITY:
-                print_basic_analysis(filename, &stats);
+                print_basic_analysis(filename, &analysis.stats);
                 /* TODO: Add integrity checking */
                 break;
             case ANALYSIS_OPTIMIZATION:
-                print_basic_analysis(filename, &stats);
-                print_optimization_recommendations(&stats);
+                print_basic_analysis(filename, &analysis.stats);
+                print_optimization_recommendations(&analysis.stats);
                 break;
         }
         
+        /* The compression mode shows the trial with the rest */
+        if (analysis.trial_algorithm != NULL && options.mode != ANALYSIS_COMPRESSION) {
+            print_trial_analysis(&analysis);
+        }
+        
         if (options.show_recommendations && options.mode != ANALYSIS_OPTIMIZATION) {
-            print_optimization_recommendations(&stats);
+            print_optimization_recommendations(&analysis.stats);
         }
     }
     
-    star_context_destroy(context);
-    return true;
+    free(analysis.trial_sizes);
+    archive_close(analysis.archive);
+    return success;
 }
 
 /* Main function */
 int main(int argc, char* argv[]) {
     int first_file_arg = parse_arguments(argc, argv);
+    bool all_success = true;
     
     if (first_file_arg < 0) {
         fprintf(stderr, "Try '%s --help' for more information.\n", argv[0]);
@@ -676,8 +935,6 @@ int main(int argc, char* argv[]) {
         return 2;
     }
     
-    bool all_success = true;
-    
     /* Analyze each archive */
     for (int i = first_file_arg; i < argc; i++) {
         if (!analyze_archive(argv[i])) {